@@ -0,0 +1,574 @@
+/**
+@file   AsyncAudioBiquadCascade.cpp
+@brief  A compiled cascade of biquad filter sections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <clocale>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BIQUAD_CASCADE_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define BIQUAD_CASCADE_NEON
+#include <arm_neon.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+extern "C" {
+#include "fidlib.h"
+};
+
+#include "AsyncAudioBiquadCascade.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+  typedef AudioBiquadCascade::Section Section;
+
+    /*
+     * The lane kernels filter LANES channels at a time. The state of each
+     * section is stored as the w1 values of all lanes followed by the w2
+     * values of all lanes.
+     */
+  typedef void (*LaneKernel)(const Section *sec, size_t nsec, double gain,
+                             double out_gain, double *state,
+                             const float *const *src, float *const *dest,
+                             int count);
+
+
+  void lanesGeneric(const Section *sec, size_t nsec, double gain,
+                    double out_gain, double *state,
+                    const float *const *src, float *const *dest, int count)
+  {
+    for (int n=0; n<count; ++n)
+    {
+      double x[4] = { src[0][n], src[1][n], src[2][n], src[3][n] };
+      double *st = state;
+      for (size_t s=0; s<nsec; ++s, st+=8)
+      {
+        for (int l=0; l<4; ++l)
+        {
+          const double w1 = st[l];
+          const double w2 = st[4+l];
+          const double w = x[l] - sec[s].a2 * w2 - sec[s].a1 * w1;
+          const double fir = sec[s].b2 * w2 + sec[s].b1 * w1;
+          x[l] = fir + sec[s].b0 * w;
+          st[4+l] = w1;
+          st[l] = w;
+        }
+      }
+      for (int l=0; l<4; ++l)
+      {
+        dest[l][n] = out_gain * (x[l] * gain);
+      }
+    }
+  } /* lanesGeneric */
+
+
+#ifdef BIQUAD_CASCADE_X86
+  __attribute__((target("sse2")))
+  void lanesSse2(const Section *sec, size_t nsec, double gain,
+                 double out_gain, double *state, const float *const *src,
+                 float *const *dest, int count)
+  {
+    const __m128d g = _mm_set1_pd(gain);
+    const __m128d og = _mm_set1_pd(out_gain);
+    for (int n=0; n<count; ++n)
+    {
+      __m128d x0 = _mm_set_pd(src[1][n], src[0][n]);
+      __m128d x1 = _mm_set_pd(src[3][n], src[2][n]);
+      double *st = state;
+      for (size_t s=0; s<nsec; ++s, st+=8)
+      {
+        const __m128d a1 = _mm_set1_pd(sec[s].a1);
+        const __m128d a2 = _mm_set1_pd(sec[s].a2);
+        const __m128d b0 = _mm_set1_pd(sec[s].b0);
+        const __m128d b1 = _mm_set1_pd(sec[s].b1);
+        const __m128d b2 = _mm_set1_pd(sec[s].b2);
+        const __m128d w1_0 = _mm_loadu_pd(st);
+        const __m128d w1_1 = _mm_loadu_pd(st+2);
+        const __m128d w2_0 = _mm_loadu_pd(st+4);
+        const __m128d w2_1 = _mm_loadu_pd(st+6);
+        const __m128d w0 = _mm_sub_pd(_mm_sub_pd(x0, _mm_mul_pd(a2, w2_0)),
+                                      _mm_mul_pd(a1, w1_0));
+        const __m128d w1 = _mm_sub_pd(_mm_sub_pd(x1, _mm_mul_pd(a2, w2_1)),
+                                      _mm_mul_pd(a1, w1_1));
+        x0 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b2, w2_0), _mm_mul_pd(b1, w1_0)),
+                        _mm_mul_pd(b0, w0));
+        x1 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b2, w2_1), _mm_mul_pd(b1, w1_1)),
+                        _mm_mul_pd(b0, w1));
+        _mm_storeu_pd(st+4, w1_0);
+        _mm_storeu_pd(st+6, w1_1);
+        _mm_storeu_pd(st, w0);
+        _mm_storeu_pd(st+2, w1);
+      }
+      const __m128 y = _mm_movelh_ps(
+          _mm_cvtpd_ps(_mm_mul_pd(og, _mm_mul_pd(x0, g))),
+          _mm_cvtpd_ps(_mm_mul_pd(og, _mm_mul_pd(x1, g))));
+      float out[4];
+      _mm_storeu_ps(out, y);
+      dest[0][n] = out[0];
+      dest[1][n] = out[1];
+      dest[2][n] = out[2];
+      dest[3][n] = out[3];
+    }
+  } /* lanesSse2 */
+
+
+  __attribute__((target("avx")))
+  void lanesAvx(const Section *sec, size_t nsec, double gain,
+                double out_gain, double *state, const float *const *src,
+                float *const *dest, int count)
+  {
+    const __m256d g = _mm256_set1_pd(gain);
+    const __m256d og = _mm256_set1_pd(out_gain);
+    for (int n=0; n<count; ++n)
+    {
+      __m256d x = _mm256_set_pd(src[3][n], src[2][n], src[1][n], src[0][n]);
+      double *st = state;
+      for (size_t s=0; s<nsec; ++s, st+=8)
+      {
+        const __m256d w1 = _mm256_loadu_pd(st);
+        const __m256d w2 = _mm256_loadu_pd(st+4);
+        const __m256d w = _mm256_sub_pd(
+            _mm256_sub_pd(x, _mm256_mul_pd(_mm256_set1_pd(sec[s].a2), w2)),
+            _mm256_mul_pd(_mm256_set1_pd(sec[s].a1), w1));
+        const __m256d fir = _mm256_add_pd(
+            _mm256_mul_pd(_mm256_set1_pd(sec[s].b2), w2),
+            _mm256_mul_pd(_mm256_set1_pd(sec[s].b1), w1));
+        x = _mm256_add_pd(fir, _mm256_mul_pd(_mm256_set1_pd(sec[s].b0), w));
+        _mm256_storeu_pd(st+4, w1);
+        _mm256_storeu_pd(st, w);
+      }
+      float out[4];
+      _mm_storeu_ps(out,
+          _mm256_cvtpd_ps(_mm256_mul_pd(og, _mm256_mul_pd(x, g))));
+      dest[0][n] = out[0];
+      dest[1][n] = out[1];
+      dest[2][n] = out[2];
+      dest[3][n] = out[3];
+    }
+  } /* lanesAvx */
+#endif
+
+
+#ifdef BIQUAD_CASCADE_NEON
+  void lanesNeon(const Section *sec, size_t nsec, double gain,
+                 double out_gain, double *state, const float *const *src,
+                 float *const *dest, int count)
+  {
+    const float64x2_t g = vdupq_n_f64(gain);
+    const float64x2_t og = vdupq_n_f64(out_gain);
+    for (int n=0; n<count; ++n)
+    {
+      const double xin[4] = { src[0][n], src[1][n], src[2][n], src[3][n] };
+      float64x2_t x0 = vld1q_f64(xin);
+      float64x2_t x1 = vld1q_f64(xin+2);
+      double *st = state;
+      for (size_t s=0; s<nsec; ++s, st+=8)
+      {
+        const float64x2_t a1 = vdupq_n_f64(sec[s].a1);
+        const float64x2_t a2 = vdupq_n_f64(sec[s].a2);
+        const float64x2_t b0 = vdupq_n_f64(sec[s].b0);
+        const float64x2_t b1 = vdupq_n_f64(sec[s].b1);
+        const float64x2_t b2 = vdupq_n_f64(sec[s].b2);
+        const float64x2_t w1_0 = vld1q_f64(st);
+        const float64x2_t w1_1 = vld1q_f64(st+2);
+        const float64x2_t w2_0 = vld1q_f64(st+4);
+        const float64x2_t w2_1 = vld1q_f64(st+6);
+          // Separate multiply and subtract, no fused multiply-add, to get
+          // the same rounding as the other implementations
+        const float64x2_t w0 = vsubq_f64(vsubq_f64(x0, vmulq_f64(a2, w2_0)),
+                                         vmulq_f64(a1, w1_0));
+        const float64x2_t w1 = vsubq_f64(vsubq_f64(x1, vmulq_f64(a2, w2_1)),
+                                         vmulq_f64(a1, w1_1));
+        x0 = vaddq_f64(vaddq_f64(vmulq_f64(b2, w2_0), vmulq_f64(b1, w1_0)),
+                       vmulq_f64(b0, w0));
+        x1 = vaddq_f64(vaddq_f64(vmulq_f64(b2, w2_1), vmulq_f64(b1, w1_1)),
+                       vmulq_f64(b0, w1));
+        vst1q_f64(st+4, w1_0);
+        vst1q_f64(st+6, w1_1);
+        vst1q_f64(st, w0);
+        vst1q_f64(st+2, w1);
+      }
+      const float32x4_t y = vcombine_f32(
+          vcvt_f32_f64(vmulq_f64(og, vmulq_f64(x0, g))),
+          vcvt_f32_f64(vmulq_f64(og, vmulq_f64(x1, g))));
+      float out[4];
+      vst1q_f32(out, y);
+      dest[0][n] = out[0];
+      dest[1][n] = out[1];
+      dest[2][n] = out[2];
+      dest[3][n] = out[3];
+    }
+  } /* lanesNeon */
+#endif
+
+
+  struct LaneImpl
+  {
+    const char *name;
+    LaneKernel  kernel;
+  };
+
+  LaneImpl selectLaneImpl(void)
+  {
+#ifdef BIQUAD_CASCADE_X86
+    if (__builtin_cpu_supports("avx"))
+    {
+      return { "AVX", lanesAvx };
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+      return { "SSE2", lanesSse2 };
+    }
+#endif
+#ifdef BIQUAD_CASCADE_NEON
+    return { "NEON", lanesNeon };
+#endif
+    return { "generic", lanesGeneric };
+  } /* selectLaneImpl */
+
+
+  const LaneImpl& laneImpl(void)
+  {
+    static const LaneImpl impl = selectLaneImpl();
+    return impl;
+  } /* laneImpl */
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+const char *AudioBiquadCascade::implName(void)
+{
+  return laneImpl().name;
+} /* AudioBiquadCascade::implName */
+
+
+AudioBiquadCascade::AudioBiquadCascade(int channels)
+  : m_channels(channels), m_gain(1.0), m_output_gain(1.0)
+{
+  assert(channels > 0);
+} /* AudioBiquadCascade::AudioBiquadCascade */
+
+
+AudioBiquadCascade::~AudioBiquadCascade(void)
+{
+} /* AudioBiquadCascade::~AudioBiquadCascade */
+
+
+bool AudioBiquadCascade::parseFilterSpec(const std::string &filter_spec,
+                                         int sample_rate)
+{
+  char spec_buf[256];
+  strncpy(spec_buf, filter_spec.c_str(), sizeof(spec_buf));
+  spec_buf[sizeof(spec_buf) - 1] = 0;
+  char *spec = spec_buf;
+  FidFilter *ff = 0;
+  char *old_locale = setlocale(LC_ALL, "C");
+  char *fferr = fid_parse(sample_rate, &spec, &ff);
+  setlocale(LC_ALL, old_locale);
+  if (fferr != 0)
+  {
+    m_error_str = fferr;
+    free(fferr);
+    return false;
+  }
+
+    // Pair up the IIR and FIR parts and collect the gain the same way as
+    // fid_run_new do it
+  vector<Section> sections;
+  double gain = 1.0;
+  FidFilter *filt = ff;
+  while (filt->len)
+  {
+    if ((filt->typ == 'F') && (filt->len == 1))
+    {
+      gain *= filt->val[0];
+      filt = FFNEXT(filt);
+      continue;
+    }
+
+    const double *iir = 0;
+    const double *fir = 0;
+    int n_iir = 0;
+    int n_fir = 0;
+    if (filt->typ == 'F')
+    {
+      fir = filt->val;
+      n_fir = filt->len;
+      filt = FFNEXT(filt);
+    }
+    else if (filt->typ == 'I')
+    {
+      iir = filt->val;
+      n_iir = filt->len;
+      filt = FFNEXT(filt);
+      while ((filt->typ == 'F') && (filt->len == 1))
+      {
+        gain *= filt->val[0];
+        filt = FFNEXT(filt);
+      }
+      if (filt->typ == 'F')
+      {
+        fir = filt->val;
+        n_fir = filt->len;
+        filt = FFNEXT(filt);
+      }
+    }
+
+    const int cnt = max(n_iir, n_fir);
+    if ((cnt < 2) || (cnt > 3) || (n_iir == 1))
+    {
+      m_error_str = "The filter contain parts that are not first or "
+                    "second order";
+      free(ff);
+      return false;
+    }
+
+    Section sec = { 1.0, 0.0, 0.0, 0.0, 0.0 };
+    double adj = 1.0;
+    if (n_iir > 0)
+    {
+      adj = 1.0 / iir[0];
+      gain *= adj;
+      sec.a1 = iir[1];
+      sec.a2 = (n_iir > 2) ? iir[2] * adj : 0.0;
+        // Only full second order sections get the first IIR coefficient
+        // normalized in fid_run_new
+      if ((n_iir == 3) && ((n_fir == 3) || (n_fir == 0)))
+      {
+        sec.a1 *= adj;
+      }
+    }
+    if (n_fir > 0)
+    {
+      sec.b0 = fir[0];
+      sec.b1 = fir[1];
+      sec.b2 = (n_fir > 2) ? fir[2] : 0.0;
+    }
+    sections.push_back(sec);
+  }
+  free(ff);
+
+  setSections(sections, gain);
+  return true;
+} /* AudioBiquadCascade::parseFilterSpec */
+
+
+void AudioBiquadCascade::setSections(const vector<Section> &sections,
+                                     double gain)
+{
+  m_sections = sections;
+  m_gain = gain;
+  const int groups = (m_channels + LANES - 1) / LANES;
+  const int lanes = (m_channels == 1) ? 1 : LANES;
+  m_state.assign(groups * m_sections.size() * 2 * lanes, 0.0);
+} /* AudioBiquadCascade::setSections */
+
+
+void AudioBiquadCascade::reset(void)
+{
+  fill(m_state.begin(), m_state.end(), 0.0);
+} /* AudioBiquadCascade::reset */
+
+
+void AudioBiquadCascade::process(float *dest, const float *src, int count)
+{
+  assert(m_channels == 1);
+
+    // Run one section at a time over the whole block so that the state of
+    // the section is kept in registers
+  if (m_work.size() < static_cast<size_t>(count))
+  {
+    m_work.resize(count);
+  }
+  double *work = m_work.data();
+  for (int n=0; n<count; ++n)
+  {
+    work[n] = src[n];
+  }
+  double *st = m_state.data();
+  for (const Section &sec : m_sections)
+  {
+    double w1 = st[0];
+    double w2 = st[1];
+    for (int n=0; n<count; ++n)
+    {
+      const double w = work[n] - sec.a2 * w2 - sec.a1 * w1;
+      const double fir = sec.b2 * w2 + sec.b1 * w1;
+      work[n] = fir + sec.b0 * w;
+      w2 = w1;
+      w1 = w;
+    }
+    st[0] = w1;
+    st[1] = w2;
+    st += 2;
+  }
+  for (int n=0; n<count; ++n)
+  {
+    dest[n] = m_output_gain * (work[n] * m_gain);
+  }
+} /* AudioBiquadCascade::process */
+
+
+void AudioBiquadCascade::process(float *const *dest, const float *const *src,
+                                 int count)
+{
+  if (m_channels == 1)
+  {
+    process(dest[0], src[0], count);
+    return;
+  }
+
+    // Unused lanes in the last group read zeros and write to a scratch
+    // buffer
+  if (m_zero.size() < static_cast<size_t>(count))
+  {
+    m_zero.assign(count, 0.0f);
+    m_scratch.resize(count);
+  }
+  const LaneKernel kernel = laneImpl().kernel;
+  const size_t group_size = m_sections.size() * 2 * LANES;
+  for (int ch=0; ch<m_channels; ch+=LANES)
+  {
+    const float *lane_src[LANES];
+    float *lane_dest[LANES];
+    for (int l=0; l<LANES; ++l)
+    {
+      const bool used = (ch + l < m_channels);
+      lane_src[l] = used ? src[ch + l] : m_zero.data();
+      lane_dest[l] = used ? dest[ch + l] : m_scratch.data();
+    }
+    kernel(m_sections.data(), m_sections.size(), m_gain, m_output_gain,
+           m_state.data() + (ch / LANES) * group_size, lane_src, lane_dest,
+           count);
+  }
+} /* AudioBiquadCascade::process */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,268 @@
+/**
+@file   AsyncAudioBiquadCascade.h
+@brief  A compiled cascade of biquad filter sections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_BIQUAD_CASCADE_INCLUDED
+#define ASYNC_AUDIO_BIQUAD_CASCADE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A compiled cascade of biquad filter sections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class run an IIR filter, designed by the fidlib filter library, as a
+cascade of first and second order sections. The filter specification syntax
+is the same as for the AudioFilter class. Filters designed by fidlib are
+lists of small IIR and FIR parts which fidlib run using an interpreted
+command list, one sample at a time. This class instead convert the parts into
+biquad sections once and then filter whole blocks of samples with compiled
+code. The arithmetic is done in double precision in the same order as fidlib
+do it so the output is the same as for a fidlib filter.
+
+The same filter can be run on a number of channels at the same time, for
+example the audio from a number of receivers. The channels are then processed
+in groups of four using SIMD instructions, one channel per lane, when such
+instructions are available on the CPU.
+
+\code
+  AudioBiquadCascade filter(4);
+  if (!filter.parseFilterSpec("LpCh9/-0.05/5000", 16000))
+  {
+    std::cerr << filter.errorString() << std::endl;
+  }
+  const float *in[4] = { rx1, rx2, rx3, rx4 };
+  float *out[4] = { out1, out2, out3, out4 };
+  filter.process(out, in, 160);
+\endcode
+
+Only filters where all IIR and FIR parts are at most of second order can be
+run as a biquad cascade. That include all Butterworth, Chebyshev and Bessel
+filters and the biquad filters. The parseFilterSpec function will fail for
+filters containing higher order parts, like raw FIR filters.
+*/
+class AudioBiquadCascade
+{
+  public:
+    /**
+     * @brief A filter section
+     *
+     * The section calculate w = x - a1*w1 - a2*w2 and then
+     * y = b0*w + b1*w1 + b2*w2, where w1 and w2 are the two previous values
+     * of w.
+     */
+    struct Section
+    {
+      double b0, b1, b2;
+      double a1, a2;
+    };
+
+    /**
+     * @brief   Get the name of the SIMD implementation in use
+     * @return  Returns the name of the SIMD implementation
+     */
+    static const char *implName(void);
+
+    /**
+     * @brief   Constructor
+     * @param   channels The number of channels to filter
+     */
+    explicit AudioBiquadCascade(int channels=1);
+
+    /**
+     * @brief   Destructor
+     */
+    ~AudioBiquadCascade(void);
+
+    /**
+     * @brief   Create the filter from the given filter specification
+     * @param   filter_spec The filter specification
+     * @param   sample_rate The sampling rate
+     * @return  Returns \em true on success or else \em false
+     */
+    bool parseFilterSpec(const std::string &filter_spec, int sample_rate);
+
+    /**
+     * @brief   Set the filter sections directly
+     * @param   sections  The filter sections, in processing order
+     * @param   gain      The gain to apply to the output of the last section
+     */
+    void setSections(const std::vector<Section> &sections, double gain);
+
+    /**
+     * @brief   Get the latest filter creation error
+     * @return  Returns an error string if an error has occured previously
+     */
+    std::string errorString(void) const { return m_error_str; }
+
+    /**
+     * @brief   Get the filter sections
+     * @return  Returns the filter sections, in processing order
+     */
+    const std::vector<Section>& sections(void) const { return m_sections; }
+
+    /**
+     * @brief   Get the gain applied after the last section
+     * @return  Returns the gain as a linear factor
+     */
+    double gain(void) const { return m_gain; }
+
+    /**
+     * @brief   Get the number of channels
+     * @return  Returns the number of channels
+     */
+    int channels(void) const { return m_channels; }
+
+    /**
+     * @brief   Set the output gain of the filter
+     * @param   gain The linear gain to multiply the filter output with
+     */
+    void setOutputGain(double gain) { m_output_gain = gain; }
+
+    /**
+     * @brief   Reset the filter state of all channels
+     */
+    void reset(void);
+
+    /**
+     * @brief   Filter a block of samples for a single channel filter
+     * @param   dest  The destination buffer, may be the same as src
+     * @param   src   The source buffer
+     * @param   count The number of samples to filter
+     */
+    void process(float *dest, const float *src, int count);
+
+    /**
+     * @brief   Filter a block of samples for all channels
+     * @param   dest  One destination buffer per channel
+     * @param   src   One source buffer per channel
+     * @param   count The number of samples to filter in each channel
+     *
+     * The destination buffers may be the same as the source buffers.
+     */
+    void process(float *const *dest, const float *const *src, int count);
+
+  private:
+    static const int LANES = 4;
+
+    int                   m_channels;
+    std::vector<Section>  m_sections;
+    double                m_gain;
+    double                m_output_gain;
+    std::vector<double>   m_state;
+    std::vector<double>   m_work;
+    std::vector<float>    m_zero;
+    std::vector<float>    m_scratch;
+    std::string           m_error_str;
+
+    AudioBiquadCascade(const AudioBiquadCascade&);
+    AudioBiquadCascade& operator=(const AudioBiquadCascade&);
+
+};  /* class AudioBiquadCascade */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_BIQUAD_CASCADE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -38,6 +38,7 @@ ANY KIND. See http://www.dspguru.com/wol.htm for more information.
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioPolyphaseResampler.h>
 
 
 /****************************************************************************
@@ -112,6 +113,8 @@ http://www.dsptutor.freeuk.com/remez/RemezFIRFilterDesign.html
 
 This implementation is based on the multirate FAQ at dspguru.com:
 http://dspguru.com/info/faqs/mrfaq.htm
+
+The filtering is done by the AudioPolyphaseResampler class.
 */
 class AudioDecimator : public AudioProcessor
 {
@@ -147,10 +150,7 @@ class AudioDecimator : public AudioProcessor
 
     
   private:
-    const int 	factor_M;
-    float     	*p_Z;
-    int       	H_size;
-    const float *p_H;
+    AudioPolyphaseResampler resampler;
     
     AudioDecimator(const AudioDecimator&);
     AudioDecimator& operator=(const AudioDecimator&);
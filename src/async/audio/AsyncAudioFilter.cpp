@@ -59,6 +59,7 @@ extern "C" {
 };
 
 #include "AsyncAudioFilter.h"
+#include "AsyncAudioBiquadCascade.h"
 
 
 
@@ -134,14 +135,14 @@ namespace Async
  ****************************************************************************/
 
 AudioFilter::AudioFilter(int sample_rate)
-  : sample_rate(sample_rate), fv(0), output_gain(1.0f)
+  : sample_rate(sample_rate), fv(0), biquad(0), output_gain(1.0f)
 {
 
 } /* AudioFilter::AudioFilter */
 
 
 AudioFilter::AudioFilter(const string &filter_spec, int sample_rate)
-  : sample_rate(sample_rate), fv(0), output_gain(1.0f)
+  : sample_rate(sample_rate), fv(0), biquad(0), output_gain(1.0f)
 {
   if (!parseFilterSpec(filter_spec))
   {
@@ -161,6 +162,20 @@ bool AudioFilter::parseFilterSpec(const std::string &filter_spec)
 {
   deleteFilter();
 
+    // Run the filter as a compiled biquad cascade if possible
+  const char *fidlib_str = getenv("ASYNC_AUDIO_FILTER_FIDLIB");
+  if ((fidlib_str == 0) || (atoi(fidlib_str) == 0))
+  {
+    biquad = new AudioBiquadCascade;
+    if (biquad->parseFilterSpec(filter_spec, sample_rate))
+    {
+      biquad->setOutputGain(output_gain);
+      return true;
+    }
+    delete biquad;
+    biquad = 0;
+  }
+
   fv = new FidVars;
   
   char spec_buf[256];
@@ -186,12 +201,23 @@ bool AudioFilter::parseFilterSpec(const std::string &filter_spec)
 void AudioFilter::setOutputGain(float gain_db)
 {
   output_gain = powf(10.0f, gain_db / 20.0f);
+  if (biquad != 0)
+  {
+    biquad->setOutputGain(output_gain);
+  }
 } /* AudioFilter::setOutputGain */
 
 
 void AudioFilter::reset(void)
 {
-  fid_run_zapbuf(fv->buf);
+  if (biquad != 0)
+  {
+    biquad->reset();
+  }
+  else
+  {
+    fid_run_zapbuf(fv->buf);
+  }
 } /* AudioFilter::reset */
 
 
@@ -207,6 +233,12 @@ void AudioFilter::processSamples(float *dest, const float *src, int count)
 {
   //cout << "AudioFilter::processSamples: len=" << len << endl;
   
+  if (biquad != 0)
+  {
+    biquad->process(dest, src, count);
+    return;
+  }
+
   for (int i=0; i<count; ++i)
   {
     dest[i] = output_gain * fv->func(fv->buf, src[i]);
@@ -235,6 +267,8 @@ void AudioFilter::deleteFilter(void)
     delete fv;
     fv = 0;
   }
+  delete biquad;
+  biquad = 0;
 } /* AudioFilter::deleteFilter */
 
 
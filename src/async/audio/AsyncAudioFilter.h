@@ -81,6 +81,7 @@ namespace Async
  ****************************************************************************/
 
 class FidVars;
+class AudioBiquadCascade;
   
 
 /****************************************************************************
@@ -109,6 +110,12 @@ class FidVars;
 @brief	A class for creating a wide range of audio filters
 @author Tobias Blomberg / SM0SVX
 @date   2006-04-23
+
+The filter is designed using the fidlib filter library. When the filter can
+be represented as a cascade of first and second order sections, which is true
+for most filter types, it is run as a compiled AudioBiquadCascade. Other
+filters are run by the fidlib filter interpreter. Setting the environment
+variable ASYNC_AUDIO_FILTER_FIDLIB to 1 force all filters to be run by fidlib.
 */
 class AudioFilter : public AudioProcessor
 {
@@ -171,6 +178,13 @@ class AudioFilter : public AudioProcessor
      * @brief Reset the filter state
      */
     void reset(void);
+
+    /**
+     * @brief   Check if the filter is run as a compiled biquad cascade
+     * @return  Returns \em true if run as a biquad cascade or \em false if
+     *          run by the fidlib filter interpreter
+     */
+    bool isBiquadCascade(void) const { return biquad != 0; }
     
     
   protected:
@@ -191,6 +205,7 @@ class AudioFilter : public AudioProcessor
   private:
     int         sample_rate;
     FidVars   	*fv;
+    AudioBiquadCascade *biquad;
     float     	output_gain;
     std::string error_str;
     
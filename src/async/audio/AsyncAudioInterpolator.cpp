@@ -27,7 +27,7 @@ ANY KIND. See http://www.dspguru.com/wol.htm for more information.
  *
  ****************************************************************************/
 
-#include <cstring>
+#include <cassert>
 
 
 /****************************************************************************
@@ -108,23 +108,14 @@ using namespace Async;
 
 AudioInterpolator::AudioInterpolator(int interpolation_factor,
       	      	      	      	     const float *filter_coeff, int taps)
-  : factor_L(interpolation_factor), L_size(taps), p_H(filter_coeff)
+  : resampler(interpolation_factor, 1, filter_coeff, taps)
 {
-  //p_H = new float[taps];
-  //memcpy(p_H, filter_coeff, taps * sizeof(*p_H));
-  
-  setInputOutputSampleRate(1, factor_L);
-
-    // FIXME: What if L_size does not divide evenly with factor_L?
-  size_t p_Z_size = L_size / factor_L;
-  p_Z = new float[p_Z_size];
-  memset(p_Z, 0, sizeof(*p_Z) * p_Z_size);
+  setInputOutputSampleRate(1, interpolation_factor);
 } /* AudioInterpolator::AudioInterpolator */
 
 
 AudioInterpolator::~AudioInterpolator(void)
 {
-  delete [] p_Z;
 } /* AudioInterpolator::~AudioInterpolator */
 
 
@@ -138,39 +129,10 @@ AudioInterpolator::~AudioInterpolator(void)
 
 void AudioInterpolator::processSamples(float *dest, const float *src, int count)
 {
-  int orig_count = count;
-  int num_taps_per_phase = L_size / factor_L;
-  
-  int num_out = 0;
-  while (count-- > 0)
-  {
-      // shift Z delay line up to make room for next sample
-    memmove(p_Z + 1, p_Z, (num_taps_per_phase - 1) * sizeof(float));
-
-      // copy next sample from input buffer to bottom of Z delay line
-    p_Z[0] = *src++;
-
-      // calculate outputs
-    for (int phase_num = 0; phase_num < factor_L; phase_num++)
-    {
-      	// point to the current polyphase filter
-      const float *p_coeff = p_H + phase_num;
-
-      	// calculate FIR sum
-      float sum = 0.0;
-      for (int tap = 0; tap < num_taps_per_phase; tap++)
-      {
-        sum += *p_coeff * p_Z[tap];
-        p_coeff += factor_L;          /* point to next coefficient */
-      }
-      *dest++ = sum * factor_L; /* store scaled sum and point to next output */
-      num_out++;
-    }
-  }
-
-  //printf("num_out=%d  orig_count=%d\n", num_out, orig_count);
-  assert(num_out == orig_count * factor_L);
-  
+  size_t num_out = resampler.process(dest, src, count);
+  assert(num_out ==
+         static_cast<size_t>(count * resampler.interpolationFactor()));
+  (void)num_out;
 } /* AudioInterpolator::processSamples */
 
 
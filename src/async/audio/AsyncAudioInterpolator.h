@@ -38,6 +38,7 @@ ANY KIND. See http://www.dspguru.com/wol.htm for more information.
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioPolyphaseResampler.h>
 
 
 
@@ -113,6 +114,8 @@ http://www.dsptutor.freeuk.com/remez/RemezFIRFilterDesign.html
 
 This implementation is based on the multirate FAQ at dspguru.com:
 http://dspguru.com/info/faqs/mrfaq.htm
+
+The filtering is done by the AudioPolyphaseResampler class.
 */
 class AudioInterpolator : public Async::AudioProcessor
 {
@@ -148,10 +151,7 @@ class AudioInterpolator : public Async::AudioProcessor
 
     
   private:
-    const int 	factor_L;
-    float     	*p_Z;
-    int       	L_size;
-    const float *p_H;
+    AudioPolyphaseResampler resampler;
 
     AudioInterpolator(const AudioInterpolator&);
     AudioInterpolator& operator=(const AudioInterpolator&);
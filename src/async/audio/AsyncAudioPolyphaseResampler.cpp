@@ -0,0 +1,523 @@
+/**
+@file   AsyncAudioPolyphaseResampler.cpp
+@brief  A rational polyphase sample rate converter
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define POLYPHASE_RESAMPLER_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define POLYPHASE_RESAMPLER_NEON
+#include <arm_neon.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioPolyphaseResampler.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+  typedef float (*DotFunc)(const float *a, const float *b, size_t n);
+
+    // Multiple accumulators are used to break the dependency chain between
+    // the additions
+  float dotGeneric(const float *a, const float *b, size_t n)
+  {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i+4 <= n; i += 4)
+    {
+      s0 += a[i] * b[i];
+      s1 += a[i+1] * b[i+1];
+      s2 += a[i+2] * b[i+2];
+      s3 += a[i+3] * b[i+3];
+    }
+    for (; i < n; ++i)
+    {
+      s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+  } /* dotGeneric */
+
+
+#ifdef POLYPHASE_RESAMPLER_X86
+  __attribute__((target("sse")))
+  inline float hsumSse(__m128 v)
+  {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+  } /* hsumSse */
+
+
+  __attribute__((target("sse")))
+  float dotSse(const float *a, const float *b, size_t n)
+  {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i+8 <= n; i += 8)
+    {
+      acc0 = _mm_add_ps(acc0,
+          _mm_mul_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+      acc1 = _mm_add_ps(acc1,
+          _mm_mul_ps(_mm_loadu_ps(a+i+4), _mm_loadu_ps(b+i+4)));
+    }
+    if (i+4 <= n)
+    {
+      acc0 = _mm_add_ps(acc0,
+          _mm_mul_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+      i += 4;
+    }
+    float sum = hsumSse(_mm_add_ps(acc0, acc1));
+    for (; i < n; ++i)
+    {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  } /* dotSse */
+
+
+  __attribute__((target("avx2,fma")))
+  inline float hsumAvx(__m256 v)
+  {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_movehdup_ps(lo);
+    __m128 sums = _mm_add_ps(lo, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+  } /* hsumAvx */
+
+
+  __attribute__((target("avx2,fma")))
+  float dotAvx2(const float *a, const float *b, size_t n)
+  {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i+16 <= n; i += 16)
+    {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i),
+                             acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i+8), _mm256_loadu_ps(b+i+8),
+                             acc1);
+    }
+    if (i+8 <= n)
+    {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i),
+                             acc0);
+      i += 8;
+    }
+    float sum = hsumAvx(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i)
+    {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  } /* dotAvx2 */
+#endif /* POLYPHASE_RESAMPLER_X86 */
+
+
+#ifdef POLYPHASE_RESAMPLER_NEON
+  inline float32x4_t macNeon(float32x4_t acc, float32x4_t a, float32x4_t b)
+  {
+#ifdef __aarch64__
+    return vfmaq_f32(acc, a, b);
+#else
+    return vmlaq_f32(acc, a, b);
+#endif
+  } /* macNeon */
+
+
+  inline float hsumNeon(float32x4_t v)
+  {
+#ifdef __aarch64__
+    return vaddvq_f32(v);
+#else
+    float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#endif
+  } /* hsumNeon */
+
+
+  float dotNeon(const float *a, const float *b, size_t n)
+  {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i+8 <= n; i += 8)
+    {
+      acc0 = macNeon(acc0, vld1q_f32(a+i), vld1q_f32(b+i));
+      acc1 = macNeon(acc1, vld1q_f32(a+i+4), vld1q_f32(b+i+4));
+    }
+    if (i+4 <= n)
+    {
+      acc0 = macNeon(acc0, vld1q_f32(a+i), vld1q_f32(b+i));
+      i += 4;
+    }
+    float sum = hsumNeon(vaddq_f32(acc0, acc1));
+    for (; i < n; ++i)
+    {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  } /* dotNeon */
+#endif /* POLYPHASE_RESAMPLER_NEON */
+
+
+  struct DotImpl
+  {
+    const char  *name;
+    DotFunc     dot;
+  };
+
+  DotImpl selectDotImpl(void)
+  {
+#ifdef POLYPHASE_RESAMPLER_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+      return { "AVX2", dotAvx2 };
+    }
+    if (__builtin_cpu_supports("sse"))
+    {
+      return { "SSE", dotSse };
+    }
+#endif
+#ifdef POLYPHASE_RESAMPLER_NEON
+    return { "NEON", dotNeon };
+#endif
+    return { "generic", dotGeneric };
+  } /* selectDotImpl */
+
+
+  const DotImpl& dotImpl(void)
+  {
+    static const DotImpl impl = selectDotImpl();
+    return impl;
+  } /* dotImpl */
+
+
+  int gcd(int a, int b)
+  {
+    while (b != 0)
+    {
+      int t = a % b;
+      a = b;
+      b = t;
+    }
+    return a;
+  } /* gcd */
+
+
+  double besselI0(double x)
+  {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k=1; k<50; ++k)
+    {
+      term *= (x / (2.0 * k)) * (x / (2.0 * k));
+      sum += term;
+      if (term < sum * 1.0e-12)
+      {
+        break;
+      }
+    }
+    return sum;
+  } /* besselI0 */
+
+
+    /*
+     * Design a Kaiser windowed sinc lowpass filter for the upsampled rate.
+     * The filter length is estimated using the formula by Kaiser. The taps
+     * are normalized to unity gain at DC.
+     */
+  vector<double> designLowpass(double fs, double f_pass, double f_stop,
+                               double atten)
+  {
+    const double beta = 0.1102 * (atten - 8.7);
+    const int len = static_cast<int>(
+        ceil((atten - 7.95) / (14.36 * (f_stop - f_pass) / fs))) + 1;
+    const double fc = 0.5 * (f_pass + f_stop) / fs;
+    const double center = 0.5 * (len - 1);
+    const double i0_beta = besselI0(beta);
+    vector<double> h(len);
+    double sum = 0.0;
+    for (int n=0; n<len; ++n)
+    {
+      const double x = n - center;
+      const double sinc = (x == 0.0) ? 2.0 * fc
+                                     : sin(2.0 * M_PI * fc * x) / (M_PI * x);
+      const double r = x / center;
+      const double win = besselI0(beta * sqrt(max(0.0, 1.0 - r * r))) /
+                         i0_beta;
+      h[n] = sinc * win;
+      sum += h[n];
+    }
+    for (double &tap : h)
+    {
+      tap /= sum;
+    }
+    return h;
+  } /* designLowpass */
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool AudioPolyphaseResampler::isSupported(int input_rate, int output_rate)
+{
+  if ((input_rate <= 0) || (output_rate <= 0))
+  {
+    return false;
+  }
+  return output_rate / gcd(input_rate, output_rate) <= MAX_PHASES;
+} /* AudioPolyphaseResampler::isSupported */
+
+
+const char *AudioPolyphaseResampler::implName(void)
+{
+  return dotImpl().name;
+} /* AudioPolyphaseResampler::implName */
+
+
+AudioPolyphaseResampler::AudioPolyphaseResampler(int input_rate,
+                                                 int output_rate)
+  : m_interp(1), m_decim(1), m_taps(0), m_phase(0)
+{
+  assert(isSupported(input_rate, output_rate));
+  const int g = gcd(input_rate, output_rate);
+  m_interp = output_rate / g;
+  m_decim = input_rate / g;
+
+    // The passband and stopband edges are set relative to the lowest of the
+    // two sample rates, since that rate decide where aliases or images will
+    // appear
+  const double min_rate = min(input_rate, output_rate);
+  const double fs = static_cast<double>(input_rate) * m_interp;
+  vector<double> proto = designLowpass(fs, 0.40625 * min_rate,
+                                       0.5625 * min_rate, 60.0);
+  setPrototype(proto, m_interp);
+} /* AudioPolyphaseResampler::AudioPolyphaseResampler */
+
+
+AudioPolyphaseResampler::AudioPolyphaseResampler(int interp, int decim,
+                                                 const float *coeff, int taps)
+  : m_interp(interp), m_decim(decim), m_taps(0), m_phase(0)
+{
+  assert((interp > 0) && (interp <= MAX_PHASES) && (decim > 0));
+  assert(taps > 0);
+  vector<double> proto(coeff, coeff + taps);
+  setPrototype(proto, interp);
+} /* AudioPolyphaseResampler::AudioPolyphaseResampler */
+
+
+size_t AudioPolyphaseResampler::outputCount(size_t input_count) const
+{
+  const size_t end = input_count * m_interp;
+  if (end <= m_phase)
+  {
+    return 0;
+  }
+  return (end - m_phase + m_decim - 1) / m_decim;
+} /* AudioPolyphaseResampler::outputCount */
+
+
+size_t AudioPolyphaseResampler::maxInputCount(size_t output_space) const
+{
+  return (output_space * m_decim + m_phase) / m_interp;
+} /* AudioPolyphaseResampler::maxInputCount */
+
+
+size_t AudioPolyphaseResampler::process(float *dest, const float *src,
+                                        size_t count)
+{
+    // The delay line hold the last taps-1 input samples of the previous block
+    // followed by the samples of this block so that each dot product can be
+    // done over a contiguous range of samples
+  const size_t hist = m_taps - 1;
+  m_buf.resize(hist + count);
+  memcpy(&m_buf[hist], src, count * sizeof(*src));
+
+    // The phase is the upsampled time of the next output sample, relative to
+    // the first sample of this block
+  const DotFunc dot = dotImpl().dot;
+  const size_t end = count * m_interp;
+  size_t t = m_phase;
+  size_t num_out = 0;
+  while (t < end)
+  {
+    const size_t i = t / m_interp;
+    const size_t p = t - i * m_interp;
+    dest[num_out++] = dot(&m_coeff[p * m_taps], &m_buf[i], m_taps);
+    t += m_decim;
+  }
+  m_phase = t - end;
+
+  memmove(&m_buf[0], &m_buf[count], hist * sizeof(m_buf[0]));
+  m_buf.resize(hist);
+
+  return num_out;
+} /* AudioPolyphaseResampler::process */
+
+
+void AudioPolyphaseResampler::reset(void)
+{
+  fill(m_buf.begin(), m_buf.end(), 0.0f);
+  m_phase = m_decim - 1;
+} /* AudioPolyphaseResampler::reset */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void AudioPolyphaseResampler::setPrototype(const vector<double> &proto,
+                                           double gain)
+{
+    // Split the prototype filter into one branch per phase. The taps of each
+    // branch are stored in reverse order so that the newest sample is
+    // multiplied by the last coefficient. Branches are zero padded at the end
+    // if the filter length is not a multiple of the interpolation factor.
+  const int len = proto.size();
+  m_taps = (len + m_interp - 1) / m_interp;
+  m_coeff.assign(static_cast<size_t>(m_interp) * m_taps, 0.0f);
+  for (int p=0; p<m_interp; ++p)
+  {
+    for (int tap=0; tap<m_taps; ++tap)
+    {
+      const int n = p + m_interp * tap;
+      if (n < len)
+      {
+        m_coeff[p * m_taps + m_taps - 1 - tap] = gain * proto[n];
+      }
+    }
+  }
+  m_buf.assign(m_taps - 1, 0.0f);
+  m_phase = m_decim - 1;
+} /* AudioPolyphaseResampler::setPrototype */
+
+
+
+/*
+ * This file has not been truncated
+ */
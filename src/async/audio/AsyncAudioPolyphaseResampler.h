@@ -0,0 +1,250 @@
+/**
+@file   AsyncAudioPolyphaseResampler.h
+@brief  A rational polyphase sample rate converter
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_POLYPHASE_RESAMPLER_INCLUDED
+#define ASYNC_AUDIO_POLYPHASE_RESAMPLER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A rational polyphase sample rate converter
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class changes the sample rate of a signal by a rational factor L/M. The
+signal is conceptually upsampled by L, lowpass filtered and then downsampled
+by M. Only the filter outputs that are kept are calculated and only the input
+samples that are not zero are multiplied, which is done by splitting the
+filter into L polyphase branches with one dot product per output sample.
+The dot products use SIMD instructions when available.
+
+The filter can either be given as an array of FIR filter coefficients or be
+designed from the input and output sample rates. A designed filter is a Kaiser
+windowed sinc with 60dB stopband attenuation. The passband reaches 40% and the
+stopband starts at 56% of the lowest of the two sample rates. The transition
+band is thus wider than required so some attenuated frequencies just above
+half the lowest sample rate are folded into the top of the band. This keeps
+down the filter length, which is good for both CPU load and delay. Any two
+sample rates are supported as long as the interpolation factor, after
+reduction by the greatest common divisor, is not larger than MAX_PHASES.
+For example, 44100Hz to 16000Hz is L=160, M=441.
+
+The AudioDecimator, AudioInterpolator and AudioResampler audio pipe classes
+are built on top of this class.
+*/
+class AudioPolyphaseResampler
+{
+  public:
+    /**
+     * @brief The maximum number of polyphase branches
+     */
+    static const int MAX_PHASES = 1024;
+
+    /**
+     * @brief   Check if a sample rate conversion is supported
+     * @param   input_rate  The input sample rate
+     * @param   output_rate The output sample rate
+     * @return  Returns \em true if the conversion is supported
+     */
+    static bool isSupported(int input_rate, int output_rate);
+
+    /**
+     * @brief   Get the name of the SIMD implementation in use
+     * @return  Returns the name of the SIMD implementation
+     */
+    static const char *implName(void);
+
+    /**
+     * @brief   Constructor
+     * @param   input_rate  The input sample rate
+     * @param   output_rate The output sample rate
+     *
+     * Use this constructor to get a filter designed for the given rates. The
+     * conversion must be supported, see isSupported.
+     */
+    AudioPolyphaseResampler(int input_rate, int output_rate);
+
+    /**
+     * @brief   Constructor
+     * @param   interp  The interpolation factor (L)
+     * @param   decim   The decimation factor (M)
+     * @param   coeff   The FIR filter coefficients
+     * @param   taps    The number of filter coefficients
+     *
+     * The filter is designed for the input sample rate times the
+     * interpolation factor. The output is multiplied by the interpolation
+     * factor to make up for the zeros inserted when upsampling.
+     */
+    AudioPolyphaseResampler(int interp, int decim, const float *coeff,
+                            int taps);
+
+    /**
+     * @brief   Get the interpolation factor
+     * @return  Returns the interpolation factor (L)
+     */
+    int interpolationFactor(void) const { return m_interp; }
+
+    /**
+     * @brief   Get the decimation factor
+     * @return  Returns the decimation factor (M)
+     */
+    int decimationFactor(void) const { return m_decim; }
+
+    /**
+     * @brief   Get the number of filter taps in each polyphase branch
+     * @return  Returns the number of taps per branch
+     */
+    int tapsPerPhase(void) const { return m_taps; }
+
+    /**
+     * @brief   Get the number of output samples for a number of inputs
+     * @param   input_count The number of input samples
+     * @return  Returns the exact number of samples the next call to process
+     *          will produce
+     */
+    size_t outputCount(size_t input_count) const;
+
+    /**
+     * @brief   Get the number of input samples that will fit
+     * @param   output_space The number of output samples there is room for
+     * @return  Returns the largest number of input samples that will not
+     *          produce more than output_space output samples
+     */
+    size_t maxInputCount(size_t output_space) const;
+
+    /**
+     * @brief   Resample a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples in the source buffer
+     * @return  Returns the number of samples written to the destination
+     *
+     * The destination buffer must have room for outputCount(count) samples.
+     */
+    size_t process(float *dest, const float *src, size_t count);
+
+    /**
+     * @brief   Reset the filter state
+     */
+    void reset(void);
+
+  private:
+    int                 m_interp;
+    int                 m_decim;
+    int                 m_taps;
+    std::vector<float>  m_coeff;
+    std::vector<float>  m_buf;
+    size_t              m_phase;
+
+    AudioPolyphaseResampler(const AudioPolyphaseResampler&);
+    AudioPolyphaseResampler& operator=(const AudioPolyphaseResampler&);
+    void setPrototype(const std::vector<double> &proto, double gain);
+
+};  /* class AudioPolyphaseResampler */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_POLYPHASE_RESAMPLER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
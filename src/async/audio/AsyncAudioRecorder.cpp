@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2004-2009 Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -39,6 +39,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <algorithm>
 #include <sstream>
 #include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
 
 
 /****************************************************************************
@@ -47,6 +53,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncFdWatch.h>
 
 
 /****************************************************************************
@@ -56,6 +63,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncAudioRecorder.h"
+#include "AsyncAudioContainer.h"
 
 
 
@@ -85,6 +93,71 @@ using namespace Async;
  *
  ****************************************************************************/
 
+/**
+ * The background writer thread. The main thread copy the samples into a
+ * queue of preallocated blocks and wake the writer thread up through a pipe.
+ * The writer thread then store the blocks to file using the same functions
+ * that are used when writing directly. A write error is reported back to the
+ * main thread through another pipe. When the file is closed, the writer
+ * thread write the rest of the queue, finish and close the file and then
+ * report that it is done through the same pipe.
+ */
+class AudioRecorder::Writer
+{
+  public:
+    static const unsigned BLOCK_SIZE = 256;
+
+    Writer(AudioRecorder *rec, unsigned queue_size)
+      : m_rec(rec), m_queue(queue_size), m_head(0), m_tail(0),
+        m_max_depth(0), m_dropped(0), m_failed(false), m_result(false),
+        m_event_watch(0)
+    {
+      m_wake_pipe[0] = m_wake_pipe[1] = -1;
+      m_event_pipe[0] = m_event_pipe[1] = -1;
+    }
+
+    ~Writer(void) { stop(); }
+
+    bool start(void);
+    void finish(void);
+    bool stop(void);
+    unsigned queueSamples(const float *samples, int count);
+    unsigned depth(void) const
+    {
+      return m_head.load(memory_order_acquire) -
+             m_tail.load(memory_order_acquire);
+    }
+    unsigned maxDepth(void) const { return m_max_depth; }
+    unsigned size(void) const { return m_queue.size(); }
+    unsigned dropped(void) const { return m_dropped; }
+
+  private:
+    struct Block
+    {
+      unsigned  count;
+      float     samples[BLOCK_SIZE];
+    };
+
+    AudioRecorder*      m_rec;
+    vector<Block>       m_queue;
+    atomic<size_t>      m_head;
+    atomic<size_t>      m_tail;
+    unsigned            m_max_depth;
+    unsigned            m_dropped;
+    bool                m_failed;
+    bool                m_result;
+    int                 m_wake_pipe[2];
+    int                 m_event_pipe[2];
+    FdWatch*            m_event_watch;
+    std::thread         m_thread;
+
+    Writer(const Writer&);
+    Writer& operator=(const Writer&);
+    void threadFunc(void);
+    void writeQueuedBlocks(void);
+    void eventReceived(FdWatch *watch);
+};
+
 
 
 /****************************************************************************
@@ -121,7 +194,9 @@ using namespace Async;
 AudioRecorder::AudioRecorder(const string& filename,
       	      	      	     AudioRecorder::Format fmt,
 			     int sample_rate)
-  : filename(filename), file(NULL), samples_written(0), format(fmt),
+  : filename(filename), file(NULL), container(0), container_failed(false),
+    writer(0), closing(false), write_buffer_ms(0), samples_written(0),
+    samples_stored(0), max_queue_depth(0), dropped_blocks(0), format(fmt),
     sample_rate(sample_rate), max_samples(0), high_water_mark(0),
     high_water_mark_reached(false)
 {
@@ -140,6 +215,10 @@ AudioRecorder::AudioRecorder(const string& filename,
       {
         format = FMT_WAV;
       }
+      else if (ext == "opus")
+      {
+        format = FMT_OPUS;
+      }
     }
   }
 } /* AudioRecorder::AudioRecorder */
@@ -147,38 +226,101 @@ AudioRecorder::AudioRecorder(const string& filename,
 
 AudioRecorder::~AudioRecorder(void)
 {
-  closeFile();
+  if (writer != 0)
+  {
+    writer->stop();
+    delete writer;
+    writer = 0;
+  }
+  else if (file != NULL)
+  {
+    finishFile();
+  }
+  delete container;
 } /* AudioRecorder::~AudioRecorder */
 
 
 bool AudioRecorder::initialize(void)
 {
+  waitClosed();
   assert(file == NULL);
+
+  if (format == FMT_OPUS)
+  {
+    if (sample_rate != INTERNAL_SAMPLE_RATE)
+    {
+      errmsg = "The Opus format is only supported at the internal sample rate";
+      return false;
+    }
+    container = createAudioContainer("opus");
+    if (container == 0)
+    {
+      errmsg = "Support for the Opus format is not available";
+      return false;
+    }
+    container->writeBlock.connect(
+        sigc::mem_fun(*this, &AudioRecorder::writeContainerBlock));
+  }
   
   file = fopen(filename.c_str(), "w");
   if (file == NULL)
   {
     setErrMsgFromErrno("fopen");
+    delete container;
+    container = 0;
     return false;
   }
   
+  size_t header_size = 0;
   if (format == FMT_WAV)
   {
-      // Leave room for the wave file header
-    if (fseek(file, WAVE_HEADER_SIZE, SEEK_SET) != 0)
+    header_size = WAVE_HEADER_SIZE;
+  }
+  else if (container != 0)
+  {
+    header_size = container->headerSize();
+  }
+  if (header_size > 0)
+  {
+      // Leave room for the file header
+    if (fseek(file, header_size, SEEK_SET) != 0)
     {
       setErrMsgFromErrno("fseek");
       fclose(file);
       file = NULL;
+      delete container;
+      container = 0;
       return false;
     }
   }
   
   samples_written = 0;
+  samples_stored = 0;
+  container_failed = false;
+  max_queue_depth = 0;
+  dropped_blocks = 0;
   high_water_mark_reached = false;
   timerclear(&begin_timestamp);
   timerclear(&end_timestamp);
   errmsg = "";
+
+  if (write_buffer_ms > 0)
+  {
+    const unsigned queue_size = max(2U,
+        write_buffer_ms * (sample_rate / 1000) / Writer::BLOCK_SIZE);
+    writer = new Writer(this, queue_size);
+    if (!writer->start())
+    {
+      setErrMsgFromErrno("pipe");
+      delete writer;
+      writer = 0;
+      fclose(file);
+      file = NULL;
+      delete container;
+      container = 0;
+      return false;
+    }
+  }
   
   return true;
   
@@ -192,31 +334,69 @@ void AudioRecorder::setMaxRecordingTime(unsigned time_ms, unsigned hw_time_ms)
 } /* AudioRecorder::setMaxRecordingTime */
 
 
+unsigned AudioRecorder::writeQueueDepth(void) const
+{
+  return (writer != 0) ? writer->depth() : 0;
+} /* AudioRecorder::writeQueueDepth */
+
+
+unsigned AudioRecorder::maxWriteQueueDepth(void) const
+{
+  return (writer != 0) ? writer->maxDepth() : max_queue_depth;
+} /* AudioRecorder::maxWriteQueueDepth */
+
+
+unsigned AudioRecorder::writeQueueSize(void) const
+{
+  return (writer != 0) ? writer->size() : 0;
+} /* AudioRecorder::writeQueueSize */
+
+
+unsigned AudioRecorder::droppedBlocks(void) const
+{
+  return (writer != 0) ? writer->dropped() : dropped_blocks;
+} /* AudioRecorder::droppedBlocks */
+
+
 bool AudioRecorder::closeFile(void)
 {
-  bool success = true;
-  if (file != NULL)
+  if ((file == NULL) || closing)
   {
-    if (format == FMT_WAV)
-    {
-      success = writeWaveHeader();
-    }
-    if (fclose(file) != 0)
-    {
-      setErrMsgFromErrno("fclose");
-      success = false;
-    }
-    file = NULL;
+    return true;
+  }
+
+  if (writer != 0)
+  {
+      // The writer thread finish the file when it has written all queued
+      // audio and then report back through the event pipe
+    closing = true;
+    writer->finish();
+    return true;
   }
+
+  const bool success = finishFile();
+  file = NULL;
+  delete container;
+  container = 0;
+  fileClosed(success);
   return success;
 } /* AudioRecorder::closeFile */
 
 
+void AudioRecorder::waitClosed(void)
+{
+  if (closing)
+  {
+    onWriterFinished();
+  }
+} /* AudioRecorder::waitClosed */
+
+
 int AudioRecorder::writeSamples(const float *samples, int count)
 {
   assert(count > 0);
 
-  if (file == NULL)
+  if ((file == NULL) || closing)
   {
     return count;
   }
@@ -238,35 +418,25 @@ int AudioRecorder::writeSamples(const float *samples, int count)
     timersub(&end_timestamp, &block_time, &begin_timestamp);
   }
   
-  short buf[count];
-  for (int i=0; i<count; ++i)
+  int written = count;
+  if (writer != 0)
   {
-    float sample = samples[i];
-    if (sample > 1)
-    {
-      buf[i] = 32767;
-    }
-    else if (sample < -1)
-    {
-      buf[i] = -32767;
-    }
-    else
-    {
-      buf[i] = static_cast<short>(32767.0 * sample);
-    }
+      // Blocks that do not fit in the queue are dropped so the caller is
+      // never blocked by the file system
+    samples_written += writer->queueSamples(samples, count);
   }
-  
-  int written = fwrite(buf, sizeof(*buf), count, file);
-  if ((written != count) && ferror(file))
+  else
   {
-    setErrMsgFromErrno("fwrite");
-    errorOccurred();
-    closeFile();
-    return count;
+    written = storeSamples(samples, count);
+    if (written < 0)
+    {
+      errorOccurred();
+      closeFile();
+      return count;
+    }
+    samples_written += written;
   }
   
-  samples_written += written;
-  
   if ((high_water_mark > 0) && (samples_written >= high_water_mark))
   {
     high_water_mark = 0;
@@ -317,6 +487,113 @@ void AudioRecorder::flushSamples(void)
  *
  ****************************************************************************/
 
+int AudioRecorder::storeSamples(const float *samples, int count)
+{
+  if (container != 0)
+  {
+    container->writeSamples(samples, count);
+    if (container_failed)
+    {
+      return -1;
+    }
+    samples_stored += count;
+    return count;
+  }
+
+  short buf[count];
+  for (int i=0; i<count; ++i)
+  {
+    float sample = samples[i];
+    if (sample > 1)
+    {
+      buf[i] = 32767;
+    }
+    else if (sample < -1)
+    {
+      buf[i] = -32767;
+    }
+    else
+    {
+      buf[i] = static_cast<short>(32767.0 * sample);
+    }
+  }
+  
+  int written = fwrite(buf, sizeof(*buf), count, file);
+  if ((written != count) && ferror(file))
+  {
+    setErrMsgFromErrno("fwrite");
+    return -1;
+  }
+  samples_stored += written;
+  return written;
+} /* AudioRecorder::storeSamples */
+
+
+bool AudioRecorder::finishFile(void)
+{
+  bool success = true;
+  if (container != 0)
+  {
+    container->endStream();
+    success = !container_failed;
+    const size_t header_size = container->headerSize();
+    if (success && (header_size > 0))
+    {
+      rewind(file);
+      if (fwrite(container->header(), 1, header_size, file) != header_size)
+      {
+        setErrMsgFromErrno("fwrite");
+        success = false;
+      }
+    }
+  }
+  else if (format == FMT_WAV)
+  {
+    success = writeWaveHeader();
+  }
+  if (fclose(file) != 0)
+  {
+    setErrMsgFromErrno("fclose");
+    success = false;
+  }
+  return success;
+} /* AudioRecorder::finishFile */
+
+
+void AudioRecorder::writeContainerBlock(const char *buf, size_t len)
+{
+  if (!container_failed && (fwrite(buf, 1, len, file) != len))
+  {
+    setErrMsgFromErrno("fwrite");
+    container_failed = true;
+  }
+} /* AudioRecorder::writeContainerBlock */
+
+
+void AudioRecorder::onWriterError(void)
+{
+  errorOccurred();
+  closeFile();
+} /* AudioRecorder::onWriterError */
+
+
+void AudioRecorder::onWriterFinished(void)
+{
+    // The writer thread has already finished the file so this will not
+    // block, unless called from waitClosed
+  const bool success = writer->stop();
+  max_queue_depth = writer->maxDepth();
+  dropped_blocks = writer->dropped();
+  delete writer;
+  writer = 0;
+  file = NULL;
+  delete container;
+  container = 0;
+  closing = false;
+  fileClosed(success);
+} /* AudioRecorder::onWriterFinished */
+
+
 bool AudioRecorder::writeWaveHeader(void)
 {
   rewind(file);
@@ -329,7 +606,7 @@ bool AudioRecorder::writeWaveHeader(void)
   ptr += 4;
   
     // ChunkSize
-  ptr += store32bitValue(ptr, 36 + samples_written * sizeof(short));
+  ptr += store32bitValue(ptr, 36 + samples_stored * sizeof(short));
   
     // Format
   memcpy(ptr, "WAVE", 4);
@@ -365,7 +642,7 @@ bool AudioRecorder::writeWaveHeader(void)
   ptr += 4;
   
     // Subchunk2Size (num samples * num channels * bytes per sample)
-  ptr += store32bitValue(ptr, samples_written * 1 * sizeof(short));
+  ptr += store32bitValue(ptr, samples_stored * 1 * sizeof(short));
   
   assert(ptr - buf == WAVE_HEADER_SIZE);
 
@@ -408,6 +685,185 @@ void AudioRecorder::setErrMsgFromErrno(const std::string &fname)
 } /* AudioRecorder::setErrMsgFromErrno */
 
 
+bool AudioRecorder::Writer::start(void)
+{
+  if ((pipe(m_wake_pipe) == -1) || (pipe(m_event_pipe) == -1))
+  {
+    stop();
+    return false;
+  }
+
+    // The main thread must never block on the pipes. If the wake pipe is
+    // full, the writer thread is already awake.
+  fcntl(m_wake_pipe[1], F_SETFL, O_NONBLOCK);
+  fcntl(m_event_pipe[0], F_SETFL, O_NONBLOCK);
+  m_event_watch = new FdWatch(m_event_pipe[0], FdWatch::FD_WATCH_RD);
+  m_event_watch->activity.connect(
+      sigc::mem_fun(*this, &Writer::eventReceived));
+
+  m_thread = std::thread(&Writer::threadFunc, this);
+  return true;
+} /* AudioRecorder::Writer::start */
+
+
+void AudioRecorder::Writer::finish(void)
+{
+    // Closing the write end of the wake pipe make the writer thread write
+    // the rest of the queue, finish the file and exit
+  if (m_wake_pipe[1] != -1)
+  {
+    close(m_wake_pipe[1]);
+    m_wake_pipe[1] = -1;
+  }
+} /* AudioRecorder::Writer::finish */
+
+
+bool AudioRecorder::Writer::stop(void)
+{
+  finish();
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+
+  delete m_event_watch;
+  m_event_watch = 0;
+  for (int *fds : { m_wake_pipe, m_event_pipe })
+  {
+    for (int i=0; i<2; ++i)
+    {
+      if (fds[i] != -1)
+      {
+        close(fds[i]);
+        fds[i] = -1;
+      }
+    }
+  }
+  return m_result;
+} /* AudioRecorder::Writer::stop */
+
+
+unsigned AudioRecorder::Writer::queueSamples(const float *samples, int count)
+{
+  unsigned queued = 0;
+  while (count > 0)
+  {
+    const unsigned len = (static_cast<unsigned>(count) < BLOCK_SIZE)
+      ? count : BLOCK_SIZE;
+    const size_t head = m_head.load(memory_order_relaxed);
+    const size_t depth = head - m_tail.load(memory_order_acquire);
+    if (depth < m_queue.size())
+    {
+      Block &block = m_queue[head % m_queue.size()];
+      memcpy(block.samples, samples, len * sizeof(*samples));
+      block.count = len;
+      m_head.store(head + 1, memory_order_release);
+      m_max_depth = max(m_max_depth, static_cast<unsigned>(depth + 1));
+      queued += len;
+    }
+    else
+    {
+      m_dropped += 1;
+    }
+    samples += len;
+    count -= len;
+  }
+
+  const char ch = 'W';
+  if ((write(m_wake_pipe[1], &ch, 1) == -1) && (errno != EAGAIN))
+  {
+    perror("write to AudioRecorder wake pipe");
+  }
+
+  return queued;
+} /* AudioRecorder::Writer::queueSamples */
+
+
+void AudioRecorder::Writer::threadFunc(void)
+{
+  char buf[64];
+  for (;;)
+  {
+    writeQueuedBlocks();
+    ssize_t len = read(m_wake_pipe[0], buf, sizeof(buf));
+    if (len == 0)
+    {
+      break;
+    }
+    else if (len < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      perror("read from AudioRecorder wake pipe");
+      break;
+    }
+  }
+  writeQueuedBlocks();
+  m_result = m_rec->finishFile() && !m_failed;
+
+  const char ch = 'C';
+  if (write(m_event_pipe[1], &ch, 1) == -1)
+  {
+    perror("write to AudioRecorder event pipe");
+  }
+} /* AudioRecorder::Writer::threadFunc */
+
+
+void AudioRecorder::Writer::writeQueuedBlocks(void)
+{
+  for (;;)
+  {
+    const size_t tail = m_tail.load(memory_order_relaxed);
+    if (tail == m_head.load(memory_order_acquire))
+    {
+      break;
+    }
+    const Block &block = m_queue[tail % m_queue.size()];
+
+      // After a write error the rest of the audio is thrown away until the
+      // main thread close the file
+    if (!m_failed && (m_rec->storeSamples(block.samples, block.count) < 0))
+    {
+      m_failed = true;
+      const char ch = 'E';
+      if (write(m_event_pipe[1], &ch, 1) == -1)
+      {
+        perror("write to AudioRecorder event pipe");
+      }
+    }
+    m_tail.store(tail + 1, memory_order_release);
+  }
+} /* AudioRecorder::Writer::writeQueuedBlocks */
+
+
+void AudioRecorder::Writer::eventReceived(FdWatch *watch)
+{
+  bool error = false;
+  bool finished = false;
+  char buf[64];
+  ssize_t len;
+  while ((len = read(m_event_pipe[0], buf, sizeof(buf))) > 0)
+  {
+    error = error || (memchr(buf, 'E', len) != 0);
+    finished = finished || (memchr(buf, 'C', len) != 0);
+  }
+
+    // This object is deleted when the recorder is told that the file has
+    // been finished so no members may be used after that
+  AudioRecorder *rec = m_rec;
+  if (error)
+  {
+    rec->onWriterError();
+  }
+  if (finished)
+  {
+    rec->onWriterFinished();
+  }
+} /* AudioRecorder::Writer::eventReceived */
+
+
 
 /*
  * This file has not been truncated
@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2004-2009 Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -84,7 +84,8 @@ namespace Async
  *
  ****************************************************************************/
 
-  
+class AudioContainer;
+
 
 /****************************************************************************
  *
@@ -114,12 +115,22 @@ namespace Async
 @date   2005-08-29
 
 Use this class to stream audio into a file. The audio is stored in raw format,
-(only samples no header) or WAV format.
+(only samples no header), WAV format or, if SvxLink was built with Opus and
+Ogg support, Ogg/Opus format.
+
+Normally the file is written directly from the writeSamples function. Writing
+to slow storage, like an SD card, may then block the application for a while.
+Use the setWriteBufferTime function to have the file written by a background
+thread instead. The audio is then put in a preallocated queue that the thread
+empty. If the thread cannot keep up, blocks of audio are dropped rather than
+blocking the caller. When the file is closed, the thread also write the rest
+of the queue and finish the file in the background. The fileClosed signal is
+emitted when the file is complete.
 */
 class AudioRecorder : public Async::AudioSink
 {
   public:
-    typedef enum { FMT_AUTO, FMT_RAW, FMT_WAV } Format;
+    typedef enum { FMT_AUTO, FMT_RAW, FMT_WAV, FMT_OPUS } Format;
     
     /**
      * @brief 	Default constuctor
@@ -142,10 +153,52 @@ class AudioRecorder : public Async::AudioSink
      *
      * This function will initialize the recorder and open the file.
      * On error, this function returns \em false. The error message can be
-     * retrieved using the errorMsg function.
+     * retrieved using the errorMsg function. If the previous file is still
+     * being finished by the background writer thread, this function wait
+     * for it to complete first.
      */
     bool initialize(void);
-    
+
+    /**
+     * @brief   Write the file from a background thread
+     * @param   time_ms The length of the write queue in milliseconds
+     *
+     * Use this function to have the file written by a background thread.
+     * The audio is queued in a buffer that can hold about the given time of
+     * audio. If the buffer is full, incoming blocks of audio are dropped.
+     * A time of 0, which is the default, makes the file to be written
+     * directly from the writeSamples function. The new setting take effect
+     * the next time the initialize function is called.
+     * When the file is closed, the thread write all queued audio and finish
+     * the file without blocking the caller. Wait for the fileClosed signal
+     * before using the file.
+     */
+    void setWriteBufferTime(unsigned time_ms) { write_buffer_ms = time_ms; }
+
+    /**
+     * @brief   Get the number of blocks in the write queue
+     * @return  Returns the number of blocks waiting to be written to file
+     */
+    unsigned writeQueueDepth(void) const;
+
+    /**
+     * @brief   Get the maximum number of blocks that have been queued
+     * @return  Returns the maximum write queue depth for the current file
+     */
+    unsigned maxWriteQueueDepth(void) const;
+
+    /**
+     * @brief   Get the size of the write queue
+     * @return  Returns the number of blocks that can be queued
+     */
+    unsigned writeQueueSize(void) const;
+
+    /**
+     * @brief   Get the number of blocks dropped since the file was opened
+     * @return  Returns the number of blocks dropped because of a full queue
+     */
+    unsigned droppedBlocks(void) const;
+
     /**
      * @brief   Set the maximum length of this recording
      * @param   time_ms The maximum time in milliseconds
@@ -171,9 +224,28 @@ class AudioRecorder : public Async::AudioSink
      * been closed, all samples coming in after that will be discarded.
      * If an error occurr, this function will return \em false. The error
      * message can be retrieved using the errorMsg function.
+     * When a background writer thread is used, the file is finished by the
+     * thread and this function return \em true right away. The result is
+     * then given by the fileClosed signal.
      */
     bool closeFile(void);
 
+    /**
+     * @brief   Check if the file is being finished in the background
+     * @return  Returns \em true if the writer thread is finishing the file
+     */
+    bool isClosing(void) const { return closing; }
+
+    /**
+     * @brief   Wait for the writer thread to finish the file
+     *
+     * Use this function if the file must be complete before going on, for
+     * example when the application is exiting. If the file is being finished
+     * by the writer thread, the caller is blocked until it is done and the
+     * fileClosed signal is emitted before this function return.
+     */
+    void waitClosed(void);
+
     /**
      * @brief   Find out how many samples that have been written so far
      * @return  Returns the number of samples written so far
@@ -221,6 +293,8 @@ class AudioRecorder : public Async::AudioSink
      *
      * This function is used to retrieve the last set error message. It can
      * for example be used when the initialize method return false or when the
+     * error signal is emitted. When a background writer thread is used, the
+     * error message is only valid when the file is closed or when the
      * error signal is emitted.
      */
     std::string errorMsg(void) const { return errmsg; }
@@ -245,10 +319,36 @@ class AudioRecorder : public Async::AudioSink
      */
     sigc::signal<void()> errorOccurred;
 
+    /**
+     * @brief   A signal that's emitted when the file has been closed
+     * @param   success \em true if the file was written and closed without
+     *                  errors
+     *
+     * This signal is emitted when the file is complete on disk, after all
+     * audio has been written, the header has been updated and the file has
+     * been closed. When a background writer thread is used, this happen some
+     * time after closeFile has returned. Otherwise the signal is emitted
+     * from the closeFile function. If the file could not be written, the
+     * error message can be retrieved using the errorMsg function. The signal
+     * is not emitted when the recorder is destroyed with the file still open
+     * or closing.
+     */
+    sigc::signal<void(bool)> fileClosed;
+
   private:
+    class Writer;
+
     std::string     filename;
     FILE      	    *file;
+    AudioContainer  *container;
+    bool            container_failed;
+    Writer          *writer;
+    bool            closing;
+    unsigned        write_buffer_ms;
     unsigned        samples_written;
+    unsigned        samples_stored;
+    unsigned        max_queue_depth;
+    unsigned        dropped_blocks;
     Format    	    format;
     int       	    sample_rate;
     unsigned        max_samples;
@@ -260,6 +360,11 @@ class AudioRecorder : public Async::AudioSink
     
     AudioRecorder(const AudioRecorder&);
     AudioRecorder& operator=(const AudioRecorder&);
+    int storeSamples(const float *samples, int count);
+    bool finishFile(void);
+    void writeContainerBlock(const char *buf, size_t len);
+    void onWriterError(void);
+    void onWriterFinished(void);
     bool writeWaveHeader(void);
     int store32bitValue(char *ptr, uint32_t val);
     int store16bitValue(char *ptr, uint16_t val);
@@ -0,0 +1,250 @@
+/**
+@file   AsyncAudioResampler.cpp
+@brief  An audio pipe that converts between two arbitrary sample rates
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncApplication.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioResampler.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioResampler::AudioResampler(int input_rate, int output_rate)
+  : m_resampler(input_rate, output_rate), m_buf_cnt(0), m_do_flush(false),
+    m_input_stopped(false), m_output_stopped(false)
+{
+} /* AudioResampler::AudioResampler */
+
+
+AudioResampler::~AudioResampler(void)
+{
+} /* AudioResampler::~AudioResampler */
+
+
+int AudioResampler::writeSamples(const float *samples, int len)
+{
+  assert(len > 0);
+
+  m_do_flush = false;
+  int orig_len = len;
+
+  writeFromBuf();
+
+    // Process as many samples as there is room for in the output buffer.
+    // The resampler keeps its own filter history so no input samples need to
+    // be buffered here.
+  while (len > 0)
+  {
+    int proc_cnt = min(static_cast<size_t>(len),
+                       m_resampler.maxInputCount(BUFSIZE - m_buf_cnt));
+    if (proc_cnt == 0)
+    {
+      break;
+    }
+    m_buf_cnt += m_resampler.process(m_buf + m_buf_cnt, samples, proc_cnt);
+    samples += proc_cnt;
+    len -= proc_cnt;
+    writeFromBuf();
+  }
+
+  int ret_len = orig_len - len;
+  if (ret_len == 0)
+  {
+    m_input_stopped = true;
+  }
+
+  return ret_len;
+} /* AudioResampler::writeSamples */
+
+
+void AudioResampler::flushSamples(void)
+{
+  m_do_flush = true;
+  m_input_stopped = false;
+  if (m_buf_cnt == 0)
+  {
+    m_do_flush = false;
+    sinkFlushSamples();
+  }
+} /* AudioResampler::flushSamples */
+
+
+void AudioResampler::resumeOutput(void)
+{
+  m_output_stopped = false;
+  writeFromBuf();
+} /* AudioResampler::resumeOutput */
+
+
+void AudioResampler::allSamplesFlushed(void)
+{
+  m_do_flush = false;
+  sourceAllSamplesFlushed();
+} /* AudioResampler::allSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void AudioResampler::writeFromBuf(void)
+{
+  if ((m_buf_cnt == 0) || m_output_stopped)
+  {
+    return;
+  }
+
+  int written;
+  do
+  {
+    written = sinkWriteSamples(m_buf, m_buf_cnt);
+    assert((written >= 0) && (written <= m_buf_cnt));
+    if (written > 0)
+    {
+      m_buf_cnt -= written;
+      if (m_buf_cnt > 0)
+      {
+        memmove(m_buf, m_buf + written, m_buf_cnt * sizeof(*m_buf));
+      }
+    }
+
+    if (m_do_flush && (m_buf_cnt == 0))
+    {
+      m_do_flush = false;
+      Application::app().runTask(
+          mem_fun(*this, &AudioResampler::sinkFlushSamples));
+    }
+  }
+  while ((written > 0) && (m_buf_cnt > 0));
+
+  m_output_stopped = (written == 0);
+
+  if (m_input_stopped && (m_buf_cnt < BUFSIZE))
+  {
+    m_input_stopped = false;
+    Application::app().runTask(
+        mem_fun(*this, &AudioResampler::sourceResumeOutput));
+  }
+} /* AudioResampler::writeFromBuf */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,195 @@
+/**
+@file   AsyncAudioResampler.h
+@brief  An audio pipe that converts between two arbitrary sample rates
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_RESAMPLER_INCLUDED
+#define ASYNC_AUDIO_RESAMPLER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSource.h>
+#include <AsyncAudioSink.h>
+#include <AsyncAudioPolyphaseResampler.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  An audio pipe that converts between two arbitrary sample rates
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This audio pipe class will convert an audio stream from one sampling rate to
+another. Unlike the AudioDecimator and AudioInterpolator classes, the ratio
+between the two rates does not have to be an integer so this class can for
+example be used to convert the audio from a sound card running at 44100Hz to
+the 16000Hz used internally. The lowpass filter is designed automatically from
+the two sample rates. Use AudioPolyphaseResampler::isSupported to check if a
+conversion is supported before creating an object of this class.
+
+\code
+  AudioResampler *resampler = new AudioResampler(44100, 16000);
+  source->registerSink(resampler, true);
+\endcode
+*/
+class AudioResampler : public AudioSink, public AudioSource,
+                       public sigc::trackable
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   input_rate  The input sample rate
+     * @param   output_rate The output sample rate
+     */
+    AudioResampler(int input_rate, int output_rate);
+
+    /**
+     * @brief   Destructor
+     */
+    ~AudioResampler(void);
+
+    /**
+     * @brief   Get the resampling engine
+     * @return  Returns the resampler used to do the conversion
+     */
+    const AudioPolyphaseResampler& resampler(void) const { return m_resampler; }
+
+    /**
+     * @brief   Write audio to the resampler
+     * @param   samples The buffer containing the samples
+     * @param   len     The number of samples in the buffer
+     * @return  Return the number of samples processed
+     */
+    int writeSamples(const float *samples, int len);
+
+    /**
+     * @brief Order a flush of all samples
+     */
+    void flushSamples(void);
+
+    /**
+     * @brief Resume output to the sink if previously stopped
+     */
+    void resumeOutput(void);
+
+    /**
+     * @brief All samples have been flushed by the sink
+     */
+    void allSamplesFlushed(void);
+
+  private:
+    static const int BUFSIZE = 256;
+
+    AudioPolyphaseResampler m_resampler;
+    float                   m_buf[BUFSIZE];
+    int                     m_buf_cnt;
+    bool                    m_do_flush;
+    bool                    m_input_stopped;
+    bool                    m_output_stopped;
+
+    AudioResampler(const AudioResampler&);
+    AudioResampler& operator=(const AudioResampler&);
+    void writeFromBuf(void);
+
+};  /* class AudioResampler */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_RESAMPLER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
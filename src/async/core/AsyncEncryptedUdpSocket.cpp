@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cassert>
 #include <cstring>
 #include <iterator>
+#include <chrono>
 
 
 /****************************************************************************
@@ -95,6 +96,12 @@ namespace {
  *
  ****************************************************************************/
 
+uint64_t elapsedNs(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+} /* elapsedNs */
+
 
 
 }; /* End of anonymous namespace */
@@ -141,9 +148,173 @@ bool EncryptedUdpSocket::randomBytes(std::vector<uint8_t>& bytes)
 } /* EncryptedUdpSocket::randomBytes */
 
 
+void EncryptedUdpSocket::freeCipherContext(CipherContext* ctx)
+{
+  EVP_CIPHER_CTX_free(ctx);
+} /* EncryptedUdpSocket::freeCipherContext */
+
+
+EncryptedUdpSocket::CipherContext* EncryptedUdpSocket::newCipherContext(
+    const Cipher* cipher, const std::vector<uint8_t>& key, bool encrypt)
+{
+  if ((cipher == nullptr) ||
+      (key.size() != static_cast<size_t>(EVP_CIPHER_key_length(cipher))))
+  {
+    return nullptr;
+  }
+
+  EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+  if (ctx == nullptr)
+  {
+    return nullptr;
+  }
+
+    // Set up the key schedule once. The IV is set for each datagram.
+  if ((encrypt && !EVP_EncryptInit_ex(ctx, cipher, NULL, key.data(), NULL)) ||
+      (!encrypt && !EVP_DecryptInit_ex(ctx, cipher, NULL, key.data(), NULL)))
+  {
+    std::cout << "### EVP_CipherInit_ex failed" << std::endl;
+    EVP_CIPHER_CTX_free(ctx);
+    return nullptr;
+  }
+
+  return ctx;
+} /* EncryptedUdpSocket::newCipherContext */
+
+
+int EncryptedUdpSocket::encryptDatagram(CipherContext* ctx, const uint8_t* iv,
+                                        size_t taglen,
+                                        const void *aad, int aadlen,
+                                        const void *buf, int cnt,
+                                        uint8_t *out)
+{
+  assert((aad == nullptr) == (aadlen <= 0));
+
+  if ((iv != nullptr) && !EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv))
+  {
+    std::cout << "### EVP_EncryptInit_ex failed" << std::endl;
+    return -1;
+  }
+
+  auto inbuf = static_cast<const uint8_t*>(buf);
+  auto aadbuf = static_cast<const uint8_t*>(aad);
+  auto outbufp = out;
+  int outlen = 0;
+  int totoutlen = aadlen + taglen;
+  if (aadlen > 0)
+  {
+    std::memcpy(outbufp, aadbuf, aadlen);
+    if(!EVP_EncryptUpdate(ctx, nullptr, &outlen, aadbuf, aadlen))
+    {
+      std::cout << "### EVP_EncryptUpdate with AAD failed" << std::endl;
+      ERR_print_errors_fp(stderr);
+      return -1;
+    }
+  }
+  outbufp += aadlen + taglen;
+
+  if(!EVP_EncryptUpdate(ctx, outbufp, &outlen, inbuf, cnt))
+  {
+    std::cout << "### EVP_EncryptUpdate failed" << std::endl;
+    return -1;
+  }
+  outbufp += outlen;
+  totoutlen += outlen;
+
+  if(!EVP_EncryptFinal_ex(ctx, outbufp, &outlen))
+  {
+    std::cout << "### EVP_EncryptFinal failed" << std::endl;
+    return -1;
+  }
+  totoutlen += outlen;
+
+  if (taglen > 0)
+  {
+    outbufp = out + aadlen;
+    if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, taglen, outbufp))
+    {
+      std::cout << "### EVP_CIPHER_CTX_ctrl(EVP_CTRL_AEAD_GET_TAG) failed"
+                << std::endl;
+      return -1;
+    }
+  }
+
+  return totoutlen;
+} /* EncryptedUdpSocket::encryptDatagram */
+
+
+int EncryptedUdpSocket::decryptDatagram(CipherContext* ctx, const uint8_t* iv,
+                                        size_t aadlen, size_t taglen,
+                                        const void *buf, int count,
+                                        uint8_t *out)
+{
+  if ((iv != nullptr) && !EVP_DecryptInit_ex(ctx, NULL, NULL, NULL, iv))
+  {
+    std::cout << "### EVP_DecryptInit_ex failed" << std::endl;
+    return -1;
+  }
+
+  auto inbuf = static_cast<const uint8_t*>(buf);
+  int outlen = 0;
+  if (aadlen > 0)
+  {
+    if (static_cast<size_t>(count) < aadlen)
+    {
+      std::cout << "### EncryptedUdpSocket::decryptDatagram: count=" << count
+                << " aadlen=" << aadlen << std::endl;
+      return -1;
+    }
+    if(!EVP_DecryptUpdate(ctx, nullptr, &outlen, inbuf, aadlen))
+    {
+      std::cout << "### : EVP_DecryptUpdate AAD failed" << std::endl;
+      return -1;
+    }
+    assert(static_cast<size_t>(outlen) == aadlen);
+    inbuf += aadlen;
+    count -= aadlen;
+  }
+
+  if (taglen > 0)
+  {
+    if (static_cast<size_t>(count) < taglen)
+    {
+      std::cout << "### Required tag does not fit within incoming data"
+                << std::endl;
+      return -1;
+    }
+      // The tag is only read by OpenSSL
+    if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, taglen,
+                             const_cast<uint8_t*>(inbuf)))
+    {
+      std::cout << "### EVP_CIPHER_CTX_ctrl(EVP_CTRL_AEAD_SET_TAG) failed"
+                << std::endl;
+      return -1;
+    }
+    inbuf += taglen;
+    count -= taglen;
+  }
+
+  if(!EVP_DecryptUpdate(ctx, out, &outlen, inbuf, count))
+  {
+    std::cout << "### EVP_DecryptUpdate failed" << std::endl;
+    return -1;
+  }
+
+  int totoutlen = outlen;
+  if(!EVP_DecryptFinal_ex(ctx, out+outlen, &outlen))
+  {
+    std::cout << "### EVP_DecryptFinal_ex failed" << std::endl;
+    return -1;
+  }
+  totoutlen += outlen;
+
+  return totoutlen;
+} /* EncryptedUdpSocket::decryptDatagram */
+
+
 EncryptedUdpSocket::EncryptedUdpSocket(uint16_t local_port,
-    const IpAddress &bind_ip)
-  : UdpSocket(local_port, bind_ip)
+    const IpAddress &bind_ip, bool reuse_port)
+  : UdpSocket(local_port, bind_ip, reuse_port)
 {
   m_cipher_ctx = EVP_CIPHER_CTX_new();
 } /* EncryptedUdpSocket::EncryptedUdpSocket */
@@ -151,6 +322,11 @@ EncryptedUdpSocket::EncryptedUdpSocket(uint16_t local_port,
 
 EncryptedUdpSocket::~EncryptedUdpSocket(void)
 {
+  for (auto& item : m_peers)
+  {
+    freePeer(item.second);
+  }
+  m_peers.clear();
   EVP_CIPHER_CTX_free(m_cipher_ctx);
   m_cipher_ctx = nullptr;
 } /* EncryptedUdpSocket::~EncryptedUdpSocket */
@@ -165,6 +341,13 @@ bool EncryptedUdpSocket::setCipher(const std::string& type)
 
 bool EncryptedUdpSocket::setCipher(const EncryptedUdpSocket::Cipher* cipher)
 {
+    // Peer contexts are bound to the previous cipher
+  for (auto& item : m_peers)
+  {
+    freePeer(item.second);
+  }
+  m_peers.clear();
+
     // Clean up the context, free all memory except the context itself
   if (!EVP_CIPHER_CTX_reset(m_cipher_ctx))
   {
@@ -189,6 +372,17 @@ bool EncryptedUdpSocket::setCipher(const EncryptedUdpSocket::Cipher* cipher)
 } /* EncryptedUdpSocket::setCipher */
 
 
+const EncryptedUdpSocket::Cipher* EncryptedUdpSocket::cipher(void) const
+{
+  assert(m_cipher_ctx != nullptr);
+#if OPENSSL_VERSION_MAJOR >= 3
+  return EVP_CIPHER_CTX_get0_cipher(m_cipher_ctx);
+#else
+  return EVP_CIPHER_CTX_cipher(m_cipher_ctx);
+#endif
+} /* EncryptedUdpSocket::cipher */
+
+
 bool EncryptedUdpSocket::setCipherIV(std::vector<uint8_t> iv)
 {
   m_cipher_iv = iv;
@@ -234,6 +428,63 @@ const std::vector<uint8_t> EncryptedUdpSocket::cipherKey(void) const
 } /* EncryptedUdpSocket::cipherKey */
 
 
+EncryptedUdpSocket::CipherContext* EncryptedUdpSocket::newCipherContext(
+    const std::vector<uint8_t>& key) const
+{
+  return createCipherContext(key, true);
+} /* EncryptedUdpSocket::newCipherContext */
+
+
+bool EncryptedUdpSocket::bindPeer(PeerId id, const std::vector<uint8_t>& key)
+{
+  Peer peer;
+  peer.enc_ctx = createCipherContext(key, true);
+  peer.dec_ctx = createCipherContext(key, false);
+  if ((peer.enc_ctx == nullptr) || (peer.dec_ctx == nullptr))
+  {
+    freePeer(peer);
+    return false;
+  }
+  unbindPeer(id);
+  m_peers[id] = peer;
+  return true;
+} /* EncryptedUdpSocket::bindPeer */
+
+
+void EncryptedUdpSocket::unbindPeer(PeerId id)
+{
+  auto it = m_peers.find(id);
+  if (it != m_peers.end())
+  {
+    if (m_rx_ctx == it->second.dec_ctx)
+    {
+      m_rx_ctx = nullptr;
+    }
+    freePeer(it->second);
+    m_peers.erase(it);
+  }
+} /* EncryptedUdpSocket::unbindPeer */
+
+
+bool EncryptedUdpSocket::peerIsBound(PeerId id) const
+{
+  return (m_peers.find(id) != m_peers.end());
+} /* EncryptedUdpSocket::peerIsBound */
+
+
+bool EncryptedUdpSocket::setRxPeer(PeerId id)
+{
+  auto it = m_peers.find(id);
+  if (it == m_peers.end())
+  {
+    m_rx_ctx = nullptr;
+    return false;
+  }
+  m_rx_ctx = it->second.dec_ctx;
+  return true;
+} /* EncryptedUdpSocket::setRxPeer */
+
+
 bool EncryptedUdpSocket::write(const IpAddress& remote_ip, int remote_port,
                                const void *buf, int count)
 {
@@ -253,10 +504,6 @@ bool EncryptedUdpSocket::write(const IpAddress& remote_ip, int remote_port,
   //std::cout << std::dec << std::endl;
 
   assert(m_cipher_ctx != nullptr);
-  assert((aad == nullptr) == (aadlen <= 0));
-
-  auto inbuf = static_cast<const uint8_t*>(buf);
-  auto aadbuf = static_cast<const uint8_t*>(aad);
 
   auto key_length = EVP_CIPHER_CTX_key_length(m_cipher_ctx);
   //auto iv_length = EVP_CIPHER_CTX_iv_length(m_cipher_ctx);
@@ -272,62 +519,38 @@ bool EncryptedUdpSocket::write(const IpAddress& remote_ip, int remote_port,
                        m_cipher_iv.data());
   }
 
-  //auto taglen = EVP_CIPHER_CTX_get_tag_length(m_cipher_ctx);
-  //std::cout << "### taglen=" << m_taglen << std::endl;
+  return encryptAndSend(m_cipher_ctx, nullptr, remote_ip, remote_port,
+                        aad, aadlen, buf, cnt);
+} /* EncryptedUdpSocket::write */
 
-    // Allow enough space in output buffer for AAD, tag, encrypted plaintext
-    // and one additional block
-  uint8_t outbuf[aadlen + m_taglen + cnt + EVP_MAX_BLOCK_LENGTH];
-  auto outbufp = outbuf;
-  int outlen = 0;
-  int totoutlen = aadlen + m_taglen;
-  if (aadlen > 0)
-  {
-    std::memcpy(outbufp, aadbuf, aadlen);
-    if(!EVP_EncryptUpdate(m_cipher_ctx, nullptr, &outlen, aadbuf, aadlen))
-    {
-      std::cout << "### EVP_EncryptUpdate with AAD failed" << std::endl;
-      ERR_print_errors_fp(stderr);
-      return false;
-    }
-  }
-  outbufp += aadlen + m_taglen;
 
-  if(!EVP_EncryptUpdate(m_cipher_ctx, outbufp, &outlen, inbuf, cnt))
-  {
-    std::cout << "### EVP_EncryptUpdate failed" << std::endl;
-    return false;
-  }
-  outbufp += outlen;
-  totoutlen += outlen;
+bool EncryptedUdpSocket::write(const IpAddress& remote_ip, int remote_port,
+                               CipherContext* ctx,
+                               const std::vector<uint8_t>& iv,
+                               const void *aad, int aadlen,
+                               const void *buf, int cnt)
+{
+  assert(ctx != nullptr);
+  assert(iv.size() == static_cast<size_t>(EVP_CIPHER_CTX_iv_length(ctx)));
+
+    // Only set the IV. The key schedule is kept from the previous call.
+  return encryptAndSend(ctx, iv.data(), remote_ip, remote_port,
+                        aad, aadlen, buf, cnt);
+} /* EncryptedUdpSocket::write */
 
-  if(!EVP_EncryptFinal_ex(m_cipher_ctx, outbufp, &outlen))
-  {
-    std::cout << "### EVP_EncryptFinal failed" << std::endl;
-    return false;
-  }
-  totoutlen += outlen;
 
-  if (m_taglen > 0)
+bool EncryptedUdpSocket::write(const IpAddress& remote_ip, int remote_port,
+                               PeerId id, const std::vector<uint8_t>& iv,
+                               const void *aad, int aadlen,
+                               const void *buf, int cnt)
+{
+  auto it = m_peers.find(id);
+  if (it == m_peers.end())
   {
-    outbufp = outbuf + aadlen;
-    if (!EVP_CIPHER_CTX_ctrl(m_cipher_ctx, EVP_CTRL_AEAD_GET_TAG,
-          m_taglen, outbufp))
-    {
-      std::cout << "### EVP_CIPHER_CTX_ctrl(EVP_CTRL_AEAD_GET_TAG) failed"
-                << std::endl;
-      return false;
-    }
+    return false;
   }
-
-  //std::cout << "### EncryptedUdpSocket::write: totoutlen=" << totoutlen
-  //          << " data=";
-  //std::copy(outbuf, outbuf+totoutlen,
-  //    std::ostream_iterator<int>(std::cout << std::hex, " "));
-  //std::cout << std::dec << std::endl;
-
-  return UdpSocket::write(remote_ip, remote_port, outbuf, totoutlen);
-
+  return write(remote_ip, remote_port, it->second.enc_ctx, iv,
+               aad, aadlen, buf, cnt);
 } /* EncryptedUdpSocket::write */
 
 
@@ -340,12 +563,20 @@ bool EncryptedUdpSocket::write(const IpAddress& remote_ip, int remote_port,
 void EncryptedUdpSocket::onDataReceived(const IpAddress& ip, uint16_t port,
                                         void* buf, int count)
 {
+  m_rx_ctx = nullptr;
   if ((count < 0) || cipherDataReceived(ip, port, buf, count))
   {
+    m_rx_ctx = nullptr;
     return;
   }
 
-  assert(m_cipher_ctx != nullptr);
+    // Use the context of the peer if one was selected by the handler of the
+    // cipherDataReceived signal
+  EVP_CIPHER_CTX* ctx = (m_rx_ctx != nullptr) ? m_rx_ctx : m_cipher_ctx;
+  const bool use_peer_ctx = (m_rx_ctx != nullptr);
+  m_rx_ctx = nullptr;
+  assert(ctx != nullptr);
+
   //std::cout << "### EncryptedUdpSocket::onDataReceived: count="
   //          << count << " iv=";
   //std::copy(m_cipher_iv.begin(), m_cipher_iv.end(),
@@ -357,75 +588,35 @@ void EncryptedUdpSocket::onDataReceived(const IpAddress& ip, uint16_t port,
   /* Allow enough space in output buffer for additional block */
   unsigned char outbuf[count + EVP_MAX_BLOCK_LENGTH];
 
-  auto key_length = EVP_CIPHER_CTX_key_length(m_cipher_ctx);
-  //auto iv_length = EVP_CIPHER_CTX_iv_length(m_cipher_ctx);
-  //std::cout << "### key_length=" << key_length << std::endl;
-  //std::cout << "### iv_length=" << iv_length << std::endl;
-  if (key_length > 0)
+  const auto start = std::chrono::steady_clock::now();
+  const uint8_t* iv = nullptr;
+  if (use_peer_ctx)
   {
-    //OPENSSL_assert(key_length == m_cipher_key.size());
+      // The key schedule is already set up so only set the IV
+    iv = m_cipher_iv.data();
+  }
+  else if (EVP_CIPHER_CTX_key_length(ctx) > 0)
+  {
+    //auto iv_length = EVP_CIPHER_CTX_iv_length(m_cipher_ctx);
     //OPENSSL_assert(iv_length == m_cipher_iv.size());
 
       // Set key and IV in the cipher context
-    EVP_DecryptInit_ex(m_cipher_ctx, NULL, NULL, m_cipher_key.data(),
+    EVP_DecryptInit_ex(ctx, NULL, NULL, m_cipher_key.data(),
                       m_cipher_iv.data());
   }
 
-  int outlen = 0;
-  void* aad = nullptr;
-  if (m_aadlen > 0)
-  {
-    if (static_cast<size_t>(count) < m_aadlen)
-    {
-      std::cout << "### EncryptedUdpSocket::onDataReceived: count=" << count
-                << " m_aadlen=" << m_aadlen << std::endl;
-      return;
-    }
-    if(!EVP_DecryptUpdate(m_cipher_ctx, nullptr, &outlen, inbuf, m_aadlen))
-    {
-      std::cout << "### : EVP_DecryptUpdate AAD failed" << std::endl;
-      return;
-    }
-    assert(static_cast<size_t>(outlen) == m_aadlen);
-    aad = inbuf;
-    inbuf += m_aadlen;
-    count -= m_aadlen;
-  }
-
-  //auto taglen = EVP_CIPHER_CTX_get_tag_length(m_cipher_ctx);
-  //std::cout << "### taglen=" << m_taglen << std::endl;
-  if (m_taglen > 0)
-  {
-    if (static_cast<size_t>(count) < m_taglen)
-    {
-      std::cout << "### Required tag does not fit within incoming data"
-                << std::endl;
-      return;
-    }
-    if (!EVP_CIPHER_CTX_ctrl(
-          m_cipher_ctx, EVP_CTRL_AEAD_SET_TAG, m_taglen, inbuf))
-    {
-      std::cout << "### EVP_CIPHER_CTX_ctrl(EVP_CTRL_AEAD_SET_TAG) failed"
-                << std::endl;
-      return;
-    }
-    inbuf += m_taglen;
-    count -= m_taglen;
-  }
-
-  if(!EVP_DecryptUpdate(m_cipher_ctx, outbuf, &outlen, inbuf, count))
+  int totoutlen = decryptDatagram(ctx, iv, m_aadlen, m_taglen,
+                                  inbuf, count, outbuf);
+  if (totoutlen < 0)
   {
-    std::cout << "### EVP_DecryptUpdate failed" << std::endl;
+    ++m_stats.decrypt_fail_cnt;
     return;
   }
+  void* aad = (m_aadlen > 0) ? inbuf : nullptr;
 
-  int totoutlen = outlen;
-  if(!EVP_DecryptFinal_ex(m_cipher_ctx, outbuf+outlen, &outlen))
-  {
-    std::cout << "### EVP_DecryptFinal_ex failed" << std::endl;
-    return;
-  }
-  totoutlen += outlen;
+  m_stats.decrypt_time_ns += elapsedNs(start);
+  m_stats.decrypt_bytes += totoutlen;
+  ++m_stats.decrypt_cnt;
 
   //std::cout << "### EncryptedUdpSocket::onDataReceived: totoutlen="
   //          << totoutlen << std::endl;
@@ -440,6 +631,53 @@ void EncryptedUdpSocket::onDataReceived(const IpAddress& ip, uint16_t port,
  *
  ****************************************************************************/
 
+EVP_CIPHER_CTX* EncryptedUdpSocket::createCipherContext(
+    const std::vector<uint8_t>& key, bool encrypt) const
+{
+  return newCipherContext(cipher(), key, encrypt);
+} /* EncryptedUdpSocket::createCipherContext */
+
+
+void EncryptedUdpSocket::freePeer(Peer& peer)
+{
+  EVP_CIPHER_CTX_free(peer.enc_ctx);
+  peer.enc_ctx = nullptr;
+  EVP_CIPHER_CTX_free(peer.dec_ctx);
+  peer.dec_ctx = nullptr;
+} /* EncryptedUdpSocket::freePeer */
+
+
+bool EncryptedUdpSocket::encryptAndSend(EVP_CIPHER_CTX* ctx,
+                                        const uint8_t* iv,
+                                        const IpAddress& remote_ip,
+                                        int remote_port,
+                                        const void *aad, int aadlen,
+                                        const void *buf, int cnt)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+    // Allow enough space in output buffer for AAD, tag, encrypted plaintext
+    // and one additional block
+  uint8_t outbuf[encryptedSize(aadlen, m_taglen, cnt)];
+  int totoutlen = encryptDatagram(ctx, iv, m_taglen, aad, aadlen,
+                                  buf, cnt, outbuf);
+  if (totoutlen < 0)
+  {
+    return false;
+  }
+
+  m_stats.encrypt_time_ns += elapsedNs(start);
+  m_stats.encrypt_bytes += cnt;
+  ++m_stats.encrypt_cnt;
+
+  //std::cout << "### EncryptedUdpSocket::write: totoutlen=" << totoutlen
+  //          << " data=";
+  //std::copy(outbuf, outbuf+totoutlen,
+  //    std::ostream_iterator<int>(std::cout << std::hex, " "));
+  //std::cout << std::dec << std::endl;
+
+  return UdpSocket::write(remote_ip, remote_port, outbuf, totoutlen);
+} /* EncryptedUdpSocket::encryptAndSend */
 
 
 /*
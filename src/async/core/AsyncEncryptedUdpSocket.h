@@ -40,6 +40,8 @@ An example of how to use the Async::EncryptedUdpSocket class
 
 #include <openssl/evp.h>
 #include <vector>
+#include <map>
+#include <cstdint>
 
 
 /****************************************************************************
@@ -122,6 +124,26 @@ class EncryptedUdpSocket : public UdpSocket
 {
   public:
     using Cipher = EVP_CIPHER;
+    using CipherContext = EVP_CIPHER_CTX;
+    using PeerId = uint32_t;
+
+    /**
+     * @brief   Counters for encrypted and decrypted datagrams
+     *
+     * The time counters hold the time spent in the cipher functions, so
+     * dividing a byte counter with the corresponding time counter give the
+     * throughput of the cipher.
+     */
+    struct CipherStats
+    {
+      uint64_t  encrypt_cnt       = 0;  ///< Number of encrypted datagrams
+      uint64_t  encrypt_bytes     = 0;  ///< Number of encrypted bytes
+      uint64_t  encrypt_time_ns   = 0;  ///< Time spent encrypting
+      uint64_t  decrypt_cnt       = 0;  ///< Number of decrypted datagrams
+      uint64_t  decrypt_bytes     = 0;  ///< Number of decrypted bytes
+      uint64_t  decrypt_time_ns   = 0;  ///< Time spent decrypting
+      uint64_t  decrypt_fail_cnt  = 0;  ///< Number of failed decryptions
+    };
 
     /**
      * @brief   Fetch a named cipher object
@@ -161,13 +183,91 @@ class EncryptedUdpSocket : public UdpSocket
      */
     static bool randomBytes(std::vector<uint8_t>& bytes);
 
+    /**
+     * @brief   Free a cipher context created using newCipherContext
+     * @param   ctx The cipher context to free
+     *
+     * It is safe to call this function with a null pointer.
+     */
+    static void freeCipherContext(CipherContext* ctx);
+
+    /**
+     * @brief   Create a cipher context that is pre-initialized with a key
+     * @param   cipher  The cipher to use
+     * @param   key     The cipher key
+     * @param   encrypt Set to \em true for encryption, \em false for
+     *                  decryption
+     * @return  Returns a new cipher context or \em nullptr on failure
+     *
+     * This function work like the newCipherContext member function but do
+     * not use any socket state. The returned context must be freed using the
+     * freeCipherContext function.
+     */
+    static CipherContext* newCipherContext(const Cipher* cipher,
+                                           const std::vector<uint8_t>& key,
+                                           bool encrypt);
+
+    /**
+     * @brief   Get the size of the buffer needed to encrypt a datagram
+     * @param   aadlen  The length of the associated data
+     * @param   taglen  The length of the AEAD tag
+     * @param   cnt     The length of the plaintext
+     * @return  Returns the needed size of the output buffer in bytes
+     */
+    static size_t encryptedSize(size_t aadlen, size_t taglen, size_t cnt)
+    {
+      return aadlen + taglen + cnt + EVP_MAX_BLOCK_LENGTH;
+    }
+
+    /**
+     * @brief   Encrypt a datagram
+     * @param   ctx     A context set up for encryption
+     * @param   iv      The IV to use or \em nullptr to keep the IV in ctx
+     * @param   taglen  The length of the AEAD tag
+     * @param   aad     Prepended unencrypted data
+     * @param   aadlen  The length of the unencrypted data
+     * @param   buf     The plaintext
+     * @param   cnt     The length of the plaintext
+     * @param   out     Output buffer, at least encryptedSize bytes long
+     * @return  Returns the length of the datagram or -1 on failure
+     *
+     * The datagram is laid out in the same way as when using the write
+     * functions, that is the AAD followed by the tag and the ciphertext. The
+     * function do not use any socket state so it may be called from any
+     * thread as long as the context is not used by another thread at the
+     * same time.
+     */
+    static int encryptDatagram(CipherContext* ctx, const uint8_t* iv,
+                               size_t taglen, const void *aad, int aadlen,
+                               const void *buf, int cnt, uint8_t *out);
+
+    /**
+     * @brief   Decrypt a datagram
+     * @param   ctx     A context set up for decryption
+     * @param   iv      The IV to use or \em nullptr to keep the IV in ctx
+     * @param   aadlen  The length of the associated data
+     * @param   taglen  The length of the AEAD tag
+     * @param   buf     The received datagram
+     * @param   count   The length of the received datagram
+     * @param   out     Output buffer, at least count + EVP_MAX_BLOCK_LENGTH
+     *                  bytes long
+     * @return  Returns the length of the plaintext or -1 on failure
+     *
+     * The associated data, if any, is found first in the received datagram.
+     * Like encryptDatagram, this function may be called from any thread.
+     */
+    static int decryptDatagram(CipherContext* ctx, const uint8_t* iv,
+                               size_t aadlen, size_t taglen,
+                               const void *buf, int count, uint8_t *out);
+
     /**
      * @brief   Constructor
      * @param   local_port  The local UDP port to bind to, 0=ephemeral
      * @param   bind_ip     The local interface (IP) to bind to
+     * @param   reuse_port  Allow other sockets to bind to the same port
      */
     EncryptedUdpSocket(uint16_t local_port=0,
-        const IpAddress &bind_ip=IpAddress());
+        const IpAddress &bind_ip=IpAddress(), bool reuse_port=false);
 
     /**
      * @brief   Disallow copy construction
@@ -218,6 +318,12 @@ class EncryptedUdpSocket : public UdpSocket
      */
     bool setCipher(const Cipher* cipher);
 
+    /**
+     * @brief   Get the cipher set using setCipher
+     * @return  Returns the cipher or \em nullptr if no cipher is set
+     */
+    const Cipher* cipher(void) const;
+
     /**
      * @brief   Set the initialization vector to use with the cipher
      * @param   iv The initialization vector
@@ -265,6 +371,73 @@ class EncryptedUdpSocket : public UdpSocket
      */
     const std::vector<uint8_t> cipherKey(void) const;
 
+    /**
+     * @brief   Create a cipher context that is pre-initialized with a key
+     * @param   key The cipher key
+     * @return  Returns a new cipher context or \em nullptr on failure
+     *
+     * Use this function to create a cipher context for a peer that is sent
+     * to often. The cipher set using setCipher is used and the key schedule
+     * is set up once so that only the IV have to be changed for each datagram
+     * when using the write function that take a cipher context. The returned
+     * context must be freed using the freeCipherContext function.
+     */
+    CipherContext* newCipherContext(const std::vector<uint8_t>& key) const;
+
+    /**
+     * @brief   Bind a cipher key to a peer
+     * @param   id  The peer identifier, e.g. a client id
+     * @param   key The cipher key to use for the peer
+     * @return  Returns \em true on success
+     *
+     * Use this function to set up pre-keyed cipher contexts, one for sending
+     * and one for receiving, for a peer. The key schedule is then only set up
+     * once and only the IV have to be changed for each datagram. The peer
+     * identifier is chosen by the application, e.g. a client id or a hash
+     * of the remote address and port. A previous binding for the same peer
+     * identifier is replaced. The setCipher function must be called before
+     * calling this function.
+     */
+    bool bindPeer(PeerId id, const std::vector<uint8_t>& key);
+
+    /**
+     * @brief   Remove a peer binding
+     * @param   id The peer identifier
+     */
+    void unbindPeer(PeerId id);
+
+    /**
+     * @brief   Check if a peer is bound
+     * @param   id The peer identifier
+     * @return  Returns \em true if the peer is bound
+     */
+    bool peerIsBound(PeerId id) const;
+
+    /**
+     * @brief   Use the cipher context of a peer for the received datagram
+     * @param   id The peer identifier
+     * @return  Returns \em true if the peer is bound
+     *
+     * This function should be called from a handler connected to the
+     * cipherDataReceived signal when the sender of the datagram has been
+     * identified. The received datagram will then be decrypted using the
+     * pre-keyed context of the peer and the IV set using setCipherIV. The
+     * key set using setCipherKey is not used. The selection is only valid
+     * for the datagram currently being received.
+     */
+    bool setRxPeer(PeerId id);
+
+    /**
+     * @brief   Get the cipher counters
+     * @return  Returns the counters for encrypted and decrypted datagrams
+     */
+    const CipherStats& cipherStats(void) const { return m_stats; }
+
+    /**
+     * @brief   Reset all cipher counters to zero
+     */
+    void resetCipherStats(void) { m_stats = CipherStats(); }
+
     /**
      * @brief   Set the length of the AEAD tag
      * @param   taglen The length of the tag in bytes
@@ -324,6 +497,44 @@ class EncryptedUdpSocket : public UdpSocket
     bool write(const IpAddress& remote_ip, int remote_port,
                const void *aad, int aadlen, const void *buf, int cnt);
 
+    /**
+     * @brief   Write data to the remote host using a given cipher context
+     * @param   remote_ip   The IP-address of the remote host
+     * @param   remote_port The remote port to use
+     * @param   ctx         A cipher context created using newCipherContext
+     * @param   iv          The initialization vector to use
+     * @param   aad         Prepended unencrypted data
+     * @param   aadlen      The length of the unencrypted data
+     * @param   buf         A buffer containing the data to send
+     * @param   cnt         The number of bytes to write
+     * @return  Return \em true on success or \em false on failure
+     *
+     * This function work like the write function above but the key set up
+     * in the given cipher context is used instead of the key set using
+     * setCipherKey. Since the key schedule is already set up in the context,
+     * only the IV is changed which make this function much more efficient
+     * when the same data is sent to many peers.
+     */
+    bool write(const IpAddress& remote_ip, int remote_port,
+               CipherContext* ctx, const std::vector<uint8_t>& iv,
+               const void *aad, int aadlen, const void *buf, int cnt);
+
+    /**
+     * @brief   Write data to a bound peer
+     * @param   remote_ip   The IP-address of the remote host
+     * @param   remote_port The remote port to use
+     * @param   id          The peer identifier given to bindPeer
+     * @param   iv          The initialization vector to use
+     * @param   aad         Prepended unencrypted data
+     * @param   aadlen      The length of the unencrypted data
+     * @param   buf         A buffer containing the data to send
+     * @param   cnt         The number of bytes to write
+     * @return  Return \em true on success or \em false on failure
+     */
+    bool write(const IpAddress& remote_ip, int remote_port, PeerId id,
+               const std::vector<uint8_t>& iv,
+               const void *aad, int aadlen, const void *buf, int cnt);
+
     /**
      * @brief   A signal that is emitted when cipher data has been received
      * @param   ip    The IP-address the data was received from
@@ -350,11 +561,30 @@ class EncryptedUdpSocket : public UdpSocket
         int count) override;
 
   private:
+    struct Peer
+    {
+      EVP_CIPHER_CTX* enc_ctx = nullptr;
+      EVP_CIPHER_CTX* dec_ctx = nullptr;
+    };
+    using PeerMap = std::map<PeerId, Peer>;
+
     EVP_CIPHER_CTX*       m_cipher_ctx  = nullptr;
     std::vector<uint8_t>  m_cipher_iv;
     std::vector<uint8_t>  m_cipher_key;
     size_t                m_taglen      = 0;
     size_t                m_aadlen      = 0;
+    PeerMap               m_peers;
+    EVP_CIPHER_CTX*       m_rx_ctx      = nullptr;
+    CipherStats           m_stats;
+
+    EVP_CIPHER_CTX* createCipherContext(const std::vector<uint8_t>& key,
+                                        bool encrypt) const;
+    void freePeer(Peer& peer);
+
+    bool encryptAndSend(EVP_CIPHER_CTX* ctx, const uint8_t* iv,
+                        const IpAddress& remote_ip,
+                        int remote_port, const void *aad, int aadlen,
+                        const void *buf, int cnt);
 
 };  /* class EncryptedUdpSocket */
 
@@ -42,6 +42,7 @@ An example of how to use the HttpServerConnection class in a client
 #include <vector>
 #include <deque>
 #include <cstring>
+#include <strings.h>
 #include <map>
 #include <string>
 #include <sstream>
@@ -153,6 +154,25 @@ class HttpServerConnection : public TcpConnection
         headers.clear();
       }
 
+      /**
+       * @brief   Get the value of a request header
+       * @param   key   The name of the header, matched case insensitively
+       * @param   value Set to the header value if found
+       * @return  Returns \em true if the header was found
+       */
+      bool getHeader(const std::string& key, std::string& value) const
+      {
+        for (const auto& header : headers)
+        {
+          if (strcasecmp(header.first.c_str(), key.c_str()) == 0)
+          {
+            value = header.second;
+            return true;
+          }
+        }
+        return false;
+      }
+
       Request& operator=(Request&& other)
       {
         method = std::move(other.method);
@@ -86,6 +86,25 @@ MsgDerived d2;
 d2.unpack(ss);
 \endcode
 
+Messages may also be packed directly into a byte buffer, without going through
+the iostream machinery. This is faster and does not allocate any memory for
+number types. The buffer is bounds checked so packing will fail if the buffer
+is too small. Unpacking from a buffer work in the same way. Use the packedSize
+function to find out how large a buffer is needed.
+
+\code{.cpp}
+std::vector<uint8_t> buf(d1.packedSize());
+Async::MsgBufWriter w(buf.data(), buf.size());
+d1.pack(w);
+
+MsgDerived d3;
+Async::MsgBufReader r(buf.data(), w.size());
+d3.unpack(r);
+\endcode
+
+Custom MsgPacker specializations must implement pack and unpack for both
+streams and buffers.
+
 For a working example, have a look at the demo application,
 \ref AsyncMsg_demo.cpp.
 
@@ -131,6 +150,7 @@ An example of how to use the AsyncMsg class
 #include <set>
 #include <map>
 #include <limits>
+#include <cstring>
 #include <endian.h>
 #include <stdint.h>
 
@@ -195,6 +215,10 @@ namespace Async
     { \
       return BASE_CLASS::pack(os); \
     } \
+    bool packParent(Async::MsgBufWriter& w) const \
+    { \
+      return BASE_CLASS::pack(w); \
+    } \
     size_t packedSizeParent(void) const \
     { \
       return BASE_CLASS::packedSize(); \
@@ -202,6 +226,10 @@ namespace Async
     bool unpackParent(std::istream& is) \
     { \
       return BASE_CLASS::unpack(is); \
+    } \
+    bool unpackParent(Async::MsgBufReader& r) \
+    { \
+      return BASE_CLASS::unpack(r); \
     }
 
 /**
@@ -216,6 +244,10 @@ namespace Async
     { \
       return packParent(os) && Msg::pack(os, __VA_ARGS__); \
     } \
+    bool pack(Async::MsgBufWriter& w) const override \
+    { \
+      return packParent(w) && Msg::pack(w, __VA_ARGS__); \
+    } \
     size_t packedSize(void) const override \
     { \
       return packedSizeParent() + Msg::packedSize(__VA_ARGS__); \
@@ -223,6 +255,10 @@ namespace Async
     bool unpack(std::istream& is) override \
     { \
       return unpackParent(is) && Msg::unpack(is, __VA_ARGS__); \
+    } \
+    bool unpack(Async::MsgBufReader& r) override \
+    { \
+      return unpackParent(r) && Msg::unpack(r, __VA_ARGS__); \
     }
 
 /**
@@ -235,10 +271,18 @@ namespace Async
     { \
       return packParent(os); \
     } \
+    bool pack(Async::MsgBufWriter& w) const override \
+    { \
+      return packParent(w); \
+    } \
     size_t packedSize(void) const override { return packedSizeParent(); } \
     bool unpack(std::istream& is) override \
     { \
       return unpackParent(is); \
+    } \
+    bool unpack(Async::MsgBufReader& r) override \
+    { \
+      return unpackParent(r); \
     }
 
 
@@ -256,13 +300,182 @@ namespace Async
  *
  ****************************************************************************/
 
+/**
+@brief  Write packed message data to a byte buffer
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class is used to pack messages directly into a memory buffer that is
+owned by the caller. No memory is allocated. Writing beyond the end of the
+buffer is not possible. Instead, the write fail and the writer is marked as
+bad so that all subsequent writes fail as well.
+*/
+class MsgBufWriter
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   buf   The buffer to write to
+     * @param   size  The size of the buffer
+     */
+    MsgBufWriter(void *buf, size_t size)
+      : m_begin(static_cast<uint8_t*>(buf)), m_pos(m_begin),
+        m_end(m_begin + size), m_good(true)
+    {
+    }
+
+    /**
+     * @brief   Write data to the buffer
+     * @param   data  The data to write
+     * @param   len   The number of bytes to write
+     * @return  Returns \em true on success or \em false if out of space
+     */
+    bool write(const void *data, size_t len)
+    {
+      if (!m_good || (len > available()))
+      {
+        m_good = false;
+        return false;
+      }
+      std::memcpy(m_pos, data, len);
+      m_pos += len;
+      return true;
+    }
+
+    /**
+     * @brief   Check if all writes so far have been successful
+     * @return  Returns \em true if no write have failed
+     */
+    bool good(void) const { return m_good; }
+
+    /**
+     * @brief   Get the number of bytes written to the buffer
+     * @return  Returns the number of bytes written
+     */
+    size_t size(void) const { return m_pos - m_begin; }
+
+    /**
+     * @brief   Get the number of bytes left in the buffer
+     * @return  Returns the number of bytes that can still be written
+     */
+    size_t available(void) const { return m_end - m_pos; }
+
+    /**
+     * @brief   Get a pointer to the start of the buffer
+     * @return  Returns a pointer to the first byte in the buffer
+     */
+    const uint8_t *data(void) const { return m_begin; }
+
+  private:
+    uint8_t*  m_begin;
+    uint8_t*  m_pos;
+    uint8_t*  m_end;
+    bool      m_good;
+};  /* class MsgBufWriter */
+
+
+/**
+@brief  Read packed message data from a byte buffer
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class is used to unpack messages directly from a memory buffer that is
+owned by the caller. Reading beyond the end of the buffer is not possible.
+Instead, the read fail and the reader is marked as bad so that all subsequent
+reads fail as well.
+*/
+class MsgBufReader
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   buf   The buffer to read from
+     * @param   size  The number of valid bytes in the buffer
+     */
+    MsgBufReader(const void *buf, size_t size)
+      : m_begin(static_cast<const uint8_t*>(buf)), m_pos(m_begin),
+        m_end(m_begin + size), m_good(true)
+    {
+    }
+
+    /**
+     * @brief   Read data from the buffer
+     * @param   data  The buffer to copy the data to
+     * @param   len   The number of bytes to read
+     * @return  Returns \em true on success or \em false if out of data
+     */
+    bool read(void *data, size_t len)
+    {
+      const uint8_t *src = take(len);
+      if (src == nullptr)
+      {
+        return false;
+      }
+      std::memcpy(data, src, len);
+      return true;
+    }
+
+    /**
+     * @brief   Consume data from the buffer without copying it
+     * @param   len   The number of bytes to consume
+     * @return  Returns a pointer to the data or nullptr if out of data
+     *
+     * The returned pointer point into the buffer given to the constructor so
+     * it is only valid as long as that buffer is valid.
+     */
+    const uint8_t *take(size_t len)
+    {
+      if (!m_good || (len > available()))
+      {
+        m_good = false;
+        return nullptr;
+      }
+      const uint8_t *src = m_pos;
+      m_pos += len;
+      return src;
+    }
+
+    /**
+     * @brief   Check if all reads so far have been successful
+     * @return  Returns \em true if no read have failed
+     */
+    bool good(void) const { return m_good; }
+
+    /**
+     * @brief   Get the number of bytes read from the buffer
+     * @return  Returns the number of bytes read
+     */
+    size_t size(void) const { return m_pos - m_begin; }
+
+    /**
+     * @brief   Get the number of bytes left to read in the buffer
+     * @return  Returns the number of bytes left
+     */
+    size_t available(void) const { return m_end - m_pos; }
+
+    /**
+     * @brief   Get a pointer to the current read position
+     * @return  Returns a pointer to the next byte to read
+     */
+    const uint8_t *pos(void) const { return m_pos; }
+
+  private:
+    const uint8_t*  m_begin;
+    const uint8_t*  m_pos;
+    const uint8_t*  m_end;
+    bool            m_good;
+};  /* class MsgBufReader */
+
+
 template <typename T>
 class MsgPacker
 {
   public:
     static bool pack(std::ostream& os, const T& val) { return val.pack(os); }
+    static bool pack(MsgBufWriter& w, const T& val) { return val.pack(w); }
     static size_t packedSize(const T& val) { return val.packedSize(); }
     static bool unpack(std::istream& is, T& val) { return val.unpack(is); }
+    static bool unpack(MsgBufReader& r, T& val) { return val.unpack(r); }
 };
 
 template <>
@@ -274,6 +487,7 @@ class MsgPacker<char>
       //std::cout << "pack<char>("<< int(val) << ")" << std::endl;
       return os.write(&val, 1).good();
     }
+    static bool pack(MsgBufWriter& w, char val) { return w.write(&val, 1); }
     static size_t packedSize(const char& val) { return sizeof(char); }
     static bool unpack(std::istream& is, char& val)
     {
@@ -281,6 +495,7 @@ class MsgPacker<char>
       //std::cout << "unpack<char>(" << int(val) << ")" << std::endl;
       return is.good();
     }
+    static bool unpack(MsgBufReader& r, char& val) { return r.read(&val, 1); }
 };
 
 template <typename T>
@@ -295,6 +510,13 @@ class Packer64
       o.uval = htobe64(o.uval);
       return os.write(o.buf, sizeof(T)).good();
     }
+    static bool pack(MsgBufWriter& w, const T& val)
+    {
+      Overlay o;
+      o.val = val;
+      o.uval = htobe64(o.uval);
+      return w.write(o.buf, sizeof(T));
+    }
     static size_t packedSize(const T& val) { return sizeof(T); }
     static bool unpack(std::istream& is, T& val)
     {
@@ -305,6 +527,17 @@ class Packer64
       //std::cout << "unpack<64>(" << val << ")" << std::endl;
       return is.good();
     }
+    static bool unpack(MsgBufReader& r, T& val)
+    {
+      Overlay o;
+      if (!r.read(o.buf, sizeof(T)))
+      {
+        return false;
+      }
+      o.uval = be64toh(o.uval);
+      val = o.val;
+      return true;
+    }
   private:
     union Overlay
     {
@@ -329,6 +562,13 @@ class Packer32
       o.uval = htobe32(o.uval);
       return os.write(o.buf, sizeof(T)).good();
     }
+    static bool pack(MsgBufWriter& w, const T& val)
+    {
+      Overlay o;
+      o.val = val;
+      o.uval = htobe32(o.uval);
+      return w.write(o.buf, sizeof(T));
+    }
     static size_t packedSize(const T& val) { return sizeof(T); }
     static bool unpack(std::istream& is, T& val)
     {
@@ -339,6 +579,17 @@ class Packer32
       //std::cout << "unpack<32>(" << val << ")" << std::endl;
       return is.good();
     }
+    static bool unpack(MsgBufReader& r, T& val)
+    {
+      Overlay o;
+      if (!r.read(o.buf, sizeof(T)))
+      {
+        return false;
+      }
+      o.uval = be32toh(o.uval);
+      val = o.val;
+      return true;
+    }
   private:
     union Overlay
     {
@@ -363,6 +614,13 @@ class Packer16
       o.uval = htobe16(o.uval);
       return os.write(o.buf, sizeof(T)).good();
     }
+    static bool pack(MsgBufWriter& w, const T& val)
+    {
+      Overlay o;
+      o.val = val;
+      o.uval = htobe16(o.uval);
+      return w.write(o.buf, sizeof(T));
+    }
     static size_t packedSize(const T& val) { return sizeof(T); }
     static bool unpack(std::istream& is, T& val)
     {
@@ -373,6 +631,17 @@ class Packer16
       //std::cout << "unpack<16>(" << val << ")" << std::endl;
       return is.good();
     }
+    static bool unpack(MsgBufReader& r, T& val)
+    {
+      Overlay o;
+      if (!r.read(o.buf, sizeof(T)))
+      {
+        return false;
+      }
+      o.uval = be16toh(o.uval);
+      val = o.val;
+      return true;
+    }
   private:
     union Overlay
     {
@@ -393,6 +662,10 @@ class Packer8
       //std::cout << "pack<8>(" << int(val) << ")" << std::endl;
       return os.write(reinterpret_cast<const char*>(&val), sizeof(T)).good();
     }
+    static bool pack(MsgBufWriter& w, const T& val)
+    {
+      return w.write(&val, sizeof(T));
+    }
     static size_t packedSize(const T& val) { return sizeof(T); }
     static bool unpack(std::istream& is, T& val)
     {
@@ -400,6 +673,10 @@ class Packer8
       //std::cout << "unpack<8>(" << int(val) << ")" << std::endl;
       return is.good();
     }
+    static bool unpack(MsgBufReader& r, T& val)
+    {
+      return r.read(&val, sizeof(T));
+    }
 };
 template <> class MsgPacker<uint8_t> : public Packer8<uint8_t> {};
 template <> class MsgPacker<int8_t> : public Packer8<int8_t> {};
@@ -419,6 +696,16 @@ class MsgPacker<std::string>
       return MsgPacker<uint16_t>::pack(os, str_len) &&
              os.write(val.c_str(), val.size());
     }
+    static bool pack(MsgBufWriter& w, const std::string& val)
+    {
+      if (val.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      uint16_t str_len(val.size());
+      return MsgPacker<uint16_t>::pack(w, str_len) &&
+             w.write(val.data(), val.size());
+    }
     static size_t packedSize(const std::string& val)
     {
       return sizeof(uint16_t) + val.size();
@@ -442,6 +729,21 @@ class MsgPacker<std::string>
       }
       return false;
     }
+    static bool unpack(MsgBufReader& r, std::string& val)
+    {
+      uint16_t str_len;
+      if (!MsgPacker<uint16_t>::unpack(r, str_len))
+      {
+        return false;
+      }
+      const uint8_t *str = r.take(str_len);
+      if (str == nullptr)
+      {
+        return false;
+      }
+      val.assign(reinterpret_cast<const char*>(str), str_len);
+      return true;
+    }
 };
 
 template <typename I>
@@ -465,6 +767,14 @@ class MsgPacker<std::vector<I>>
       }
       return true;
     }
+    static bool pack(MsgBufWriter& w, const std::vector<I>& vec)
+    {
+      if (vec.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      return MsgPacker<uint16_t>::pack(w, vec.size()) && packItems(w, vec);
+    }
     static size_t packedSize(const std::vector<I>& vec)
     {
       size_t size = sizeof(uint16_t);
@@ -493,6 +803,50 @@ class MsgPacker<std::vector<I>>
       }
       return true;
     }
+    static bool unpack(MsgBufReader& r, std::vector<I>& vec)
+    {
+      uint16_t vec_size;
+      if (!MsgPacker<uint16_t>::unpack(r, vec_size))
+      {
+        return false;
+      }
+      vec.resize(vec_size);
+      return unpackItems(r, vec);
+    }
+
+  private:
+    template <typename V>
+    static bool packItems(MsgBufWriter& w, const V& vec)
+    {
+      for (const auto& item : vec)
+      {
+        if (!MsgPacker<I>::pack(w, item))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    static bool packItems(MsgBufWriter& w, const std::vector<uint8_t>& vec)
+    {
+      return w.write(vec.data(), vec.size());
+    }
+    template <typename V>
+    static bool unpackItems(MsgBufReader& r, V& vec)
+    {
+      for (auto& item : vec)
+      {
+        if (!MsgPacker<I>::unpack(r, item))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    static bool unpackItems(MsgBufReader& r, std::vector<uint8_t>& vec)
+    {
+      return r.read(vec.data(), vec.size());
+    }
 };
 
 template <typename I>
@@ -519,6 +873,25 @@ class MsgPacker<std::set<I>>
       }
       return true;
     }
+    static bool pack(MsgBufWriter& w, const std::set<I>& s)
+    {
+      if (s.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      if (!MsgPacker<uint16_t>::pack(w, s.size()))
+      {
+        return false;
+      }
+      for (const auto& item : s)
+      {
+        if (!MsgPacker<I>::pack(w, item))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
     static size_t packedSize(const std::set<I>& s)
     {
       size_t size = sizeof(uint16_t);
@@ -552,6 +925,25 @@ class MsgPacker<std::set<I>>
       }
       return true;
     }
+    static bool unpack(MsgBufReader& r, std::set<I>& s)
+    {
+      uint16_t set_size;
+      if (!MsgPacker<uint16_t>::unpack(r, set_size))
+      {
+        return false;
+      }
+      s.clear();
+      for (int i=0; i<set_size; ++i)
+      {
+        I val;
+        if (!MsgPacker<I>::unpack(r, val))
+        {
+          return false;
+        }
+        s.insert(s.end(), val);
+      }
+      return true;
+    }
 };
 
 template <typename Tag, typename Value>
@@ -573,6 +965,26 @@ class MsgPacker<std::map<Tag,Value>>
       }
       return true;
     }
+    static bool pack(MsgBufWriter& w, const std::map<Tag, Value>& m)
+    {
+      if (m.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      if (!MsgPacker<uint16_t>::pack(w, m.size()))
+      {
+        return false;
+      }
+      for (const auto& item : m)
+      {
+        if (!MsgPacker<Tag>::pack(w, item.first) ||
+            !MsgPacker<Value>::pack(w, item.second))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
     static size_t packedSize(const std::map<Tag, Value>& m)
     {
       size_t size = sizeof(uint16_t);
@@ -603,6 +1015,27 @@ class MsgPacker<std::map<Tag,Value>>
       }
       return true;
     }
+    static bool unpack(MsgBufReader& r, std::map<Tag,Value>& m)
+    {
+      uint16_t map_size;
+      if (!MsgPacker<uint16_t>::unpack(r, map_size))
+      {
+        return false;
+      }
+      m.clear();
+      for (int i=0; i<map_size; ++i)
+      {
+        Tag tag;
+        Value val;
+        if (!MsgPacker<Tag>::unpack(r, tag) ||
+            !MsgPacker<Value>::unpack(r, val))
+        {
+          return false;
+        }
+        m[tag] = val;
+      }
+      return true;
+    }
 };
 
 template <typename T, size_t N>
@@ -620,6 +1053,17 @@ class MsgPacker<std::array<T, N>>
       }
       return true;
     }
+    static bool pack(MsgBufWriter& w, const std::array<T, N>& vec)
+    {
+      for (const auto& item : vec)
+      {
+        if (!MsgPacker<T>::pack(w, item))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
     static size_t packedSize(const std::array<T, N>& vec)
     {
       size_t size = 0;
@@ -640,6 +1084,17 @@ class MsgPacker<std::array<T, N>>
       }
       return true;
     }
+    static bool unpack(MsgBufReader& r, std::array<T, N>& vec)
+    {
+      for (auto& item : vec)
+      {
+        if (!MsgPacker<T>::unpack(r, item))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
 };
 
 template <typename T, size_t N> class MsgPacker<T[N]>
@@ -656,6 +1111,17 @@ template <typename T, size_t N> class MsgPacker<T[N]>
       }
       return true;
     }
+    static bool pack(MsgBufWriter& w, const T (&vec)[N])
+    {
+      for (const auto& item : vec)
+      {
+        if (!MsgPacker<T>::pack(w, item))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
     static size_t packedSize(const T (&vec)[N])
     {
       size_t size = 0;
@@ -676,6 +1142,17 @@ template <typename T, size_t N> class MsgPacker<T[N]>
       }
       return true;
     }
+    static bool unpack(MsgBufReader& r, T (&vec)[N])
+    {
+      for (auto& item : vec)
+      {
+        if (!MsgPacker<T>::unpack(r, item))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
 };
 
 
@@ -690,12 +1167,16 @@ class Msg
     virtual ~Msg(void) {}
 
     bool packParent(std::ostream&) const { return true; }
+    bool packParent(MsgBufWriter&) const { return true; }
     size_t packedSizeParent(void) const { return 0; }
     bool unpackParent(std::istream&) { return true; }
+    bool unpackParent(MsgBufReader&) { return true; }
 
     virtual bool pack(std::ostream&) const { return true; }
+    virtual bool pack(MsgBufWriter&) const { return true; }
     virtual size_t packedSize(void) const { return 0; }
     virtual bool unpack(std::istream&) { return true; }
+    virtual bool unpack(MsgBufReader&) { return true; }
 
     template <typename T>
     bool pack(std::ostream& os, const T& val) const
@@ -712,6 +1193,16 @@ class Msg
     {
       return MsgPacker<T>::unpack(is, val);
     }
+    template <typename T>
+    bool pack(MsgBufWriter& w, const T& val) const
+    {
+      return MsgPacker<T>::pack(w, val);
+    }
+    template <typename T>
+    bool unpack(MsgBufReader& r, T& val) const
+    {
+      return MsgPacker<T>::unpack(r, val);
+    }
 
     template <typename T1, typename T2, typename... Args>
     bool pack(std::ostream& os, const T1& v1, const T2& v2,
@@ -729,6 +1220,17 @@ class Msg
     {
       return unpack(is, v1) && unpack(is, v2, args...);
     }
+    template <typename T1, typename T2, typename... Args>
+    bool pack(MsgBufWriter& w, const T1& v1, const T2& v2,
+              const Args&... args) const
+    {
+      return pack(w, v1) && pack(w, v2, args...);
+    }
+    template <typename T1, typename T2, typename... Args>
+    bool unpack(MsgBufReader& r, T1& v1, T2& v2, Args&... args)
+    {
+      return unpack(r, v1) && unpack(r, v2, args...);
+    }
 }; /* class Msg */
 
 
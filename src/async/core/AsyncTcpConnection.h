@@ -286,6 +286,15 @@ class TcpConnection : virtual public sigc::trackable
      */
     bool isIdle(void) const { return sock == -1; }
 
+    /**
+     * @brief   Get the number of bytes waiting to be sent
+     * @return  Returns the number of bytes in the write buffer
+     *
+     * Written data is buffered until the socket is writable. This function
+     * can be used to detect a peer that is not reading fast enough.
+     */
+    size_t writeBufferSize(void) const { return m_write_buf.size(); }
+
     /**
      * @brief   Enable or disable TLS for this connection
      * @param   enable Set to \em true to enable
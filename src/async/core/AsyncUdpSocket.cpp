@@ -37,6 +37,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -45,6 +46,8 @@
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <vector>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -54,6 +57,7 @@
  ****************************************************************************/
 
 #include <AsyncFdWatch.h>
+#include <AsyncApplication.h>
 
 
 /****************************************************************************
@@ -84,6 +88,7 @@ using namespace Async;
  *
  ****************************************************************************/
 
+#define DEFAULT_SEND_QUEUE_LIMIT  (1024 * 1024)
 
 
 /****************************************************************************
@@ -109,6 +114,88 @@ class UdpPacket
 };
 
 
+class UdpSendQueue
+{
+  public:
+    static const size_t MAX_BATCH = 64;
+
+    struct Entry
+    {
+      struct sockaddr_in  addr;
+      size_t              offset;
+      size_t              len;
+    };
+
+    std::vector<char>   data;
+    std::vector<Entry>  entries;
+    size_t              head;
+    bool                flush_pending;
+
+    UdpSendQueue(void) : head(0), flush_pending(false) {}
+
+    bool empty(void) const { return head >= entries.size(); }
+
+    size_t bytes(void) const
+    {
+      return empty() ? 0 : data.size() - entries[head].offset;
+    }
+
+      // Throw away the datagrams that have already been sent
+    void compact(void)
+    {
+      if (empty())
+      {
+        clear();
+        return;
+      }
+      const size_t offset = entries[head].offset;
+      data.erase(data.begin(), data.begin() + offset);
+      entries.erase(entries.begin(), entries.begin() + head);
+      for (auto& entry : entries)
+      {
+        entry.offset -= offset;
+      }
+      head = 0;
+    }
+
+    void clear(void)
+    {
+      data.clear();
+      entries.clear();
+      head = 0;
+    }
+};
+
+
+const size_t UdpSendQueue::MAX_BATCH;
+
+
+class UdpRecvBatch
+{
+  public:
+    static const size_t BUFSIZE = 65536;
+
+    std::vector<char>               bufs;
+    std::vector<struct sockaddr_in> addrs;
+    std::vector<int>                lens;
+#ifdef HAS_RECVMMSG
+    std::vector<struct iovec>       iovs;
+    std::vector<struct mmsghdr>     msgs;
+#endif
+
+    explicit UdpRecvBatch(unsigned size)
+      : bufs(size * BUFSIZE), addrs(size), lens(size)
+#ifdef HAS_RECVMMSG
+        , iovs(size), msgs(size)
+#endif
+    {
+    }
+
+    unsigned size(void) const { return addrs.size(); }
+    char *buf(unsigned idx) { return &bufs[idx * BUFSIZE]; }
+};
+
+
 /****************************************************************************
  *
  * Prototypes
@@ -153,8 +240,11 @@ class UdpPacket
  * Bugs:      
  *------------------------------------------------------------------------
  */
-UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
-  : sock(-1), rd_watch(0), wr_watch(0), send_buf(0)
+UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip,
+                     bool reuse_port)
+  : sock(-1), rd_watch(0), wr_watch(0), send_buf(0), send_batching(false),
+    send_queue(0), send_queue_limit(DEFAULT_SEND_QUEUE_LIMIT),
+    send_queue_dropped(0), recv_batch_size(1), recv_batch(0), deleted(0)
 {
     // Create UDP socket
   sock = socket(AF_INET, SOCK_DGRAM, 0);
@@ -173,28 +263,44 @@ UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
     return;
   }
   
-    // Bind the socket to a local port if one was specified
-  if (local_port > 0)
+    // Bind the socket to the given local port. If no port was specified,
+    // the kernel choose a free port so that it can be read back using
+    // localPort right away.
+  if ((local_port > 0) && reuse_port)
   {
-    struct sockaddr_in addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(local_port);
-    if (bind_ip.isEmpty())
-    {
-      addr.sin_addr.s_addr = INADDR_ANY;
-    }
-    else
+#ifdef SO_REUSEPORT
+    int on = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1)
     {
-      addr.sin_addr = bind_ip.ip4Addr();
-    }
-    if(::bind(sock, reinterpret_cast<struct sockaddr *>(&addr),
-              sizeof(addr)) == -1)
-    {
-      perror("bind");
+      perror("setsockopt(SO_REUSEPORT)");
       cleanup();
       return;
     }
+#else
+    fprintf(stderr, "*** ERROR: SO_REUSEPORT is not supported\n");
+    cleanup();
+    return;
+#endif
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(local_port);
+  if (bind_ip.isEmpty())
+  {
+    addr.sin_addr.s_addr = INADDR_ANY;
+  }
+  else
+  {
+    addr.sin_addr = bind_ip.ip4Addr();
+  }
+  if(::bind(sock, reinterpret_cast<struct sockaddr *>(&addr),
+            sizeof(addr)) == -1)
+  {
+    perror("bind");
+    cleanup();
+    return;
   }
 
     // Setup a watch for incoming data
@@ -214,6 +320,10 @@ UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
 
 UdpSocket::~UdpSocket(void)
 {
+  if (deleted != 0)
+  {
+    *deleted = true;
+  }
   cleanup();
 } /* UdpSocket::~UdpSocket */
 
@@ -255,6 +365,13 @@ uint16_t UdpSocket::localPort(void) const
 bool UdpSocket::write(const IpAddress& remote_ip, int remote_port,
     const void *buf, int count)
 {
+    // Also queue the datagram if batching was just disabled but there still
+    // are datagrams in the queue, to keep the order
+  if (send_batching || ((send_queue != 0) && !send_queue->empty()))
+  {
+    return queueDatagram(remote_ip, remote_port, buf, count);
+  }
+
   if (send_buf != 0)
   {
     return false;
@@ -288,6 +405,97 @@ bool UdpSocket::write(const IpAddress& remote_ip, int remote_port,
 } /* UdpSocket::write */
 
 
+void UdpSocket::setSendBatching(bool enable)
+{
+  send_batching = enable;
+  if (!send_batching)
+  {
+    flushSendQueue();
+  }
+} /* UdpSocket::setSendBatching */
+
+
+bool UdpSocket::flushSendQueue(void)
+{
+  if (send_queue == 0)
+  {
+    return true;
+  }
+  send_queue->flush_pending = false;
+
+    // Wait for a datagram from a non-batched write to be sent first
+  if (send_buf != 0)
+  {
+    return true;
+  }
+
+  bool ok = true;
+  while (!send_queue->empty())
+  {
+#ifdef HAS_SENDMMSG
+    const size_t cnt = std::min(send_queue->entries.size() - send_queue->head,
+                                UdpSendQueue::MAX_BATCH);
+    struct iovec iovs[UdpSendQueue::MAX_BATCH];
+    struct mmsghdr msgs[UdpSendQueue::MAX_BATCH];
+    memset(msgs, 0, cnt * sizeof(msgs[0]));
+    for (size_t i=0; i<cnt; ++i)
+    {
+      UdpSendQueue::Entry& entry = send_queue->entries[send_queue->head + i];
+      iovs[i].iov_base = &send_queue->data[entry.offset];
+      iovs[i].iov_len = entry.len;
+      msgs[i].msg_hdr.msg_name = &entry.addr;
+      msgs[i].msg_hdr.msg_namelen = sizeof(entry.addr);
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int ret = sendmmsg(sock, msgs, cnt, 0);
+#else
+    UdpSendQueue::Entry& entry = send_queue->entries[send_queue->head];
+    int ret = sendto(sock, &send_queue->data[entry.offset], entry.len, 0,
+        reinterpret_cast<struct sockaddr *>(&entry.addr), sizeof(entry.addr));
+    if (ret != -1)
+    {
+      ret = 1;
+    }
+#endif
+    if (ret == -1)
+    {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        if (!wr_watch->isEnabled())
+        {
+          wr_watch->setEnabled(true);
+          sendBufferFull(true);
+        }
+        send_queue->compact();
+        return ok;
+      }
+        // Drop the datagram that could not be sent and go on with the rest
+      perror("sendmmsg in UdpSocket::flushSendQueue");
+      ret = 1;
+      ok = false;
+    }
+    send_queue->head += ret;
+  }
+  send_queue->clear();
+
+  return ok;
+} /* UdpSocket::flushSendQueue */
+
+
+size_t UdpSocket::sendQueueSize(void) const
+{
+  return (send_queue != 0) ? send_queue->bytes() : 0;
+} /* UdpSocket::sendQueueSize */
+
+
+void UdpSocket::setRecvBatchSize(unsigned batch_size)
+{
+    // The batch buffers are (re)allocated on the next read
+  recv_batch_size = std::max(batch_size, 1U);
+} /* UdpSocket::setRecvBatchSize */
+
+
 
 /****************************************************************************
  *
@@ -331,6 +539,12 @@ void UdpSocket::cleanup(void)
   
   delete send_buf;
   send_buf = 0;
+
+  delete send_queue;
+  send_queue = 0;
+
+  delete recv_batch;
+  recv_batch = 0;
   
   if (sock != -1)
   {
@@ -345,6 +559,12 @@ void UdpSocket::cleanup(void)
 
 void UdpSocket::handleInput(FdWatch *watch)
 {
+  if (recv_batch_size > 1)
+  {
+    readBatch();
+    return;
+  }
+
   char buf[65536];
   struct sockaddr_in addr;
   socklen_t addr_len = sizeof(addr);
@@ -363,6 +583,18 @@ void UdpSocket::handleInput(FdWatch *watch)
 
 void UdpSocket::sendRest(FdWatch *watch)
 {
+  if (send_buf == 0)
+  {
+      // Batched datagrams are waiting for the socket to become writable
+    wr_watch->setEnabled(false);
+    flushSendQueue();
+    if (!wr_watch->isEnabled())
+    {
+      sendBufferFull(false);
+    }
+    return;
+  }
+
   struct sockaddr_in addr;
   addr.sin_family = AF_INET;
   addr.sin_port = htons(send_buf->port);
@@ -394,10 +626,148 @@ void UdpSocket::sendRest(FdWatch *watch)
   delete send_buf;
   send_buf = 0;
   wr_watch->setEnabled(false);
-  
+
+  if ((send_queue != 0) && !send_queue->empty())
+  {
+    flushSendQueue();
+  }
 } /* UdpSocket::sendRest */
 
 
+bool UdpSocket::queueDatagram(const IpAddress& remote_ip, int remote_port,
+                              const void *buf, int count)
+{
+  if (send_queue == 0)
+  {
+    send_queue = new UdpSendQueue;
+  }
+
+  if (send_queue->bytes() + count > send_queue_limit)
+  {
+      // Try to make room by sending the queued datagrams right away. If the
+      // socket send buffer is full, the datagram is dropped.
+    flushSendQueue();
+    if (send_queue->bytes() + count > send_queue_limit)
+    {
+      ++send_queue_dropped;
+      return false;
+    }
+  }
+
+  UdpSendQueue::Entry entry;
+  memset(&entry.addr, 0, sizeof(entry.addr));
+  entry.addr.sin_family = AF_INET;
+  entry.addr.sin_port = htons(remote_port);
+  entry.addr.sin_addr = remote_ip.ip4Addr();
+  entry.offset = send_queue->data.size();
+  entry.len = count;
+  const char *cbuf = static_cast<const char *>(buf);
+  send_queue->data.insert(send_queue->data.end(), cbuf, cbuf + count);
+  send_queue->entries.push_back(entry);
+
+    // The queue is flushed when the call chain has returned to the main loop
+  if (!send_queue->flush_pending)
+  {
+    send_queue->flush_pending = true;
+    Application::app().runTask(mem_fun(*this, &UdpSocket::sendQueued));
+  }
+
+  return true;
+} /* UdpSocket::queueDatagram */
+
+
+void UdpSocket::sendQueued(void)
+{
+  flushSendQueue();
+} /* UdpSocket::sendQueued */
+
+
+bool UdpSocket::readBatch(void)
+{
+  if ((recv_batch == 0) || (recv_batch->size() != recv_batch_size))
+  {
+    delete recv_batch;
+    recv_batch = new UdpRecvBatch(recv_batch_size);
+  }
+
+    // Detect if this object is deleted from a dataReceived handler
+  bool is_deleted = false;
+  deleted = &is_deleted;
+
+    // Do not read forever if datagrams arrive faster than we can handle
+    // them. The rest will be read on the next main loop iteration.
+  const unsigned max_rounds = 8;
+  for (unsigned round=0; round<max_rounds; ++round)
+  {
+    UdpRecvBatch& batch = *recv_batch;
+    const unsigned size = batch.size();
+#ifdef HAS_RECVMMSG
+    for (unsigned i=0; i<size; ++i)
+    {
+      batch.iovs[i].iov_base = batch.buf(i);
+      batch.iovs[i].iov_len = UdpRecvBatch::BUFSIZE;
+      memset(&batch.msgs[i], 0, sizeof(batch.msgs[i]));
+      batch.msgs[i].msg_hdr.msg_name = &batch.addrs[i];
+      batch.msgs[i].msg_hdr.msg_namelen = sizeof(batch.addrs[i]);
+      batch.msgs[i].msg_hdr.msg_iov = &batch.iovs[i];
+      batch.msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int cnt = recvmmsg(sock, &batch.msgs[0], size, MSG_DONTWAIT, NULL);
+    for (int i=0; i<cnt; ++i)
+    {
+      batch.lens[i] = batch.msgs[i].msg_len;
+    }
+#else
+    int cnt = 0;
+    while (static_cast<unsigned>(cnt) < size)
+    {
+      socklen_t addr_len = sizeof(batch.addrs[cnt]);
+      int len = recvfrom(sock, batch.buf(cnt), UdpRecvBatch::BUFSIZE,
+          MSG_DONTWAIT, reinterpret_cast<struct sockaddr *>(&batch.addrs[cnt]),
+          &addr_len);
+      if (len == -1)
+      {
+        if (cnt == 0)
+        {
+          cnt = -1;
+        }
+        break;
+      }
+      batch.lens[cnt++] = len;
+    }
+#endif
+    if (cnt == -1)
+    {
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+      {
+        perror("recvmmsg in UdpSocket::readBatch");
+      }
+      break;
+    }
+
+    for (int i=0; i<cnt; ++i)
+    {
+      onDataReceived(IpAddress(batch.addrs[i].sin_addr),
+                     ntohs(batch.addrs[i].sin_port),
+                     batch.buf(i), batch.lens[i]);
+      if (is_deleted)
+      {
+        return false;
+      }
+    }
+
+    if ((static_cast<unsigned>(cnt) < size) ||
+        (recv_batch->size() != recv_batch_size))
+    {
+      break;
+    }
+  }
+
+  deleted = 0;
+  return true;
+} /* UdpSocket::readBatch */
+
+
 
 
 
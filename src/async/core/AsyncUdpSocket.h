@@ -69,6 +69,8 @@ An example of how to use the Async::UdpSocket class
  ****************************************************************************/
 
 class UdpPacket;
+class UdpSendQueue;
+class UdpRecvBatch;
 
 
 /****************************************************************************
@@ -127,11 +129,17 @@ class UdpSocket : public sigc::trackable
     /**
      * @brief 	Constructor
      * @param 	local_port  The local port to use. If not specified, a random
-     *	      	      	    local port will be used.
+     *	      	      	    local port is chosen by the kernel when the
+     *	      	      	    socket is created.
      * @param  	bind_ip     Bind to the interface with the given IP address.
      *	      	            If left empty, bind to all interfaces.
+     * @param   reuse_port  Set the SO_REUSEPORT option before binding so that
+     *                      more than one socket can bind to the same port.
+     *                      The kernel then distribute incoming datagrams
+     *                      between the sockets.
      */
-    UdpSocket(uint16_t local_port=0, const IpAddress &bind_ip=IpAddress());
+    UdpSocket(uint16_t local_port=0, const IpAddress &bind_ip=IpAddress(),
+              bool reuse_port=false);
   
     /**
      * @brief 	Destructor
@@ -171,6 +179,106 @@ class UdpSocket : public sigc::trackable
     virtual bool write(const IpAddress& remote_ip, int remote_port,
         const void *buf, int count);
 
+    /**
+     * @brief   Enable or disable batching of outgoing datagrams
+     * @param   enable Set to \em true to enable batching
+     *
+     * When batching is enabled, datagrams written using the write function
+     * are queued and then sent all at once when the call chain has returned
+     * to the main loop. On Linux the sendmmsg system call is used so that
+     * many datagrams are sent using one system call. This is good for
+     * applications that send the same data to many hosts. Any queued
+     * datagrams are sent when batching is disabled.
+     *
+     * The size of the queue is limited, see setSendQueueLimit. When the
+     * limit is reached, the queue is flushed right away. If the datagrams
+     * still cannot be sent because the socket send buffer is full, new
+     * datagrams are dropped and the write function return \em false, just
+     * like when batching is not used.
+     */
+    void setSendBatching(bool enable);
+
+    /**
+     * @brief   Check if batching of outgoing datagrams is enabled
+     * @return  Returns \em true if batching is enabled
+     */
+    bool sendBatching(void) const { return send_batching; }
+
+    /**
+     * @brief   Send all queued datagrams immediately
+     * @return  Returns \em false if a datagram could not be sent
+     *
+     * This function is normally called automatically from the main loop
+     * when send batching is enabled but it may be called manually to send
+     * the queued datagrams immediately.
+     */
+    bool flushSendQueue(void);
+
+    /**
+     * @brief   Set the maximum size of the send queue
+     * @param   max_bytes The maximum number of bytes to queue
+     *
+     * This is the maximum number of bytes of datagram data to keep in the
+     * send queue when send batching is enabled. The default is 1MB.
+     */
+    void setSendQueueLimit(size_t max_bytes) { send_queue_limit = max_bytes; }
+
+    /**
+     * @brief   Get the maximum size of the send queue
+     * @return  Returns the maximum number of bytes to queue
+     */
+    size_t sendQueueLimit(void) const { return send_queue_limit; }
+
+    /**
+     * @brief   Get the current size of the send queue
+     * @return  Returns the number of bytes of queued datagram data
+     */
+    size_t sendQueueSize(void) const;
+
+    /**
+     * @brief   Get the number of datagrams dropped by the send queue
+     * @return  Returns the number of datagrams dropped since the socket was
+     *          created because the send queue was full
+     */
+    uint64_t sendQueueDropped(void) const { return send_queue_dropped; }
+
+    /**
+     * @brief   Set the maximum number of datagrams read at a time
+     * @param   batch_size The maximum number of datagrams
+     *
+     * When the batch size is larger than one, all available datagrams are
+     * read each time the socket become readable, using as few system calls
+     * as possible. On Linux the recvmmsg system call is used to read up to
+     * batch_size datagrams using one system call. The datagrams are then
+     * delivered one by one through the dataReceived signal. Each slot in the
+     * batch use a 64kB buffer. The default is one.
+     */
+    void setRecvBatchSize(unsigned batch_size);
+
+    /**
+     * @brief   Get the maximum number of datagrams read at a time
+     * @return  Returns the batch size
+     */
+    unsigned recvBatchSize(void) const { return recv_batch_size; }
+
+    /**
+     * @brief   Handle a datagram that was received by other means
+     * @param   ip    The IP-address the data was received from
+     * @param   port  The remote port number
+     * @param   buf   The buffer containing the received data
+     * @param   count The number of bytes received
+     *
+     * Use this function to handle a datagram in the same way as if it had
+     * been read from this socket, e.g. when another socket bound to the same
+     * port using the reuse_port constructor argument is read by another
+     * thread. This function must be called from the main thread.
+     */
+    void injectDatagram(const IpAddress& ip, uint16_t port, void *buf,
+                        int count)
+    {
+      onDataReceived(ip, port, buf, count);
+    }
+
     /**
      * @brief   Get the file descriptor for the UDP socket
      * @return  Returns the file descriptor associated with the socket or
@@ -199,14 +307,25 @@ class UdpSocket : public sigc::trackable
         int count);
 
   private:
-    int       	sock;
-    FdWatch * 	rd_watch;
-    FdWatch * 	wr_watch;
-    UdpPacket * send_buf;
+    int       	    sock;
+    FdWatch * 	    rd_watch;
+    FdWatch * 	    wr_watch;
+    UdpPacket *     send_buf;
+    bool            send_batching;
+    UdpSendQueue *  send_queue;
+    size_t          send_queue_limit;
+    uint64_t        send_queue_dropped;
+    unsigned        recv_batch_size;
+    UdpRecvBatch *  recv_batch;
+    bool *          deleted;
     
     void cleanup(void);
     void handleInput(FdWatch *watch);
     void sendRest(FdWatch *watch);
+    bool queueDatagram(const IpAddress& remote_ip, int remote_port,
+                       const void *buf, int count);
+    void sendQueued(void);
+    bool readBatch(void);
 
 };  /* class UdpSocket */
 
@@ -39,12 +39,17 @@
 #include <sys/select.h>
 #include <signal.h>
 #include <unistd.h>
+#ifdef HAS_EPOLL_SUPPORT
+#include <sys/epoll.h>
+#endif
 
 #include <cstdlib>
 #include <cstdio>
 #include <cerrno>
 #include <cassert>
+#include <cstring>
 #include <algorithm>
+#include <iostream>
 
 
 /****************************************************************************
@@ -64,6 +69,7 @@
 #include "AsyncCppDnsLookupWorker.h"
 #include "AsyncFdWatch.h"
 #include "AsyncTimer.h"
+#include "AsyncTimerWheel.h"
 #include "AsyncCppApplication.h"
 
 
@@ -106,6 +112,15 @@ using namespace Async;
     }                                                                         \
   } while (0)
 
+  // The initial number of events that can be returned from one epoll_wait
+  // call. The buffer grows dynamically if it fills up.
+#define EPOLL_INITIAL_EVENTS  64
+
+  // Convert a timespec to milliseconds, rounding down or up
+#define clock_floor_ms(ts) \
+  (uint64_t((ts)->tv_sec) * 1000 + (ts)->tv_nsec / 1000000)
+#define clock_ceil_ms(ts) \
+  (uint64_t((ts)->tv_sec) * 1000 + ((ts)->tv_nsec + 999999) / 1000000)
 
 
 
@@ -148,6 +163,47 @@ int CppApplication::sighandler_pipe[2];
  *
  ****************************************************************************/
 
+bool CppApplication::backendFromName(const std::string& name,
+                                     Backend& backend)
+{
+  if (name == "select")
+  {
+    backend = BACKEND_SELECT;
+  }
+  else if (name == "epoll")
+  {
+    backend = BACKEND_EPOLL;
+  }
+  else if (name == "epoll_et")
+  {
+    backend = BACKEND_EPOLL_ET;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+} /* CppApplication::backendFromName */
+
+
+bool CppApplication::timerBackendFromName(const std::string& name,
+                                          TimerBackend& backend)
+{
+  if (name == "map")
+  {
+    backend = TIMER_BACKEND_MAP;
+  }
+  else if (name == "wheel")
+  {
+    backend = TIMER_BACKEND_WHEEL;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+} /* CppApplication::timerBackendFromName */
+
 
 /*
  *------------------------------------------------------------------------
@@ -162,20 +218,75 @@ int CppApplication::sighandler_pipe[2];
  *------------------------------------------------------------------------
  */
 CppApplication::CppApplication(void)
-  : do_quit(false), max_desc(0), unix_signal_recv(-1), unix_signal_recv_cnt(0)
+  : do_quit(false), max_desc(0), unix_signal_recv(-1), unix_signal_recv_cnt(0),
+    m_backend(BACKEND_SELECT), m_epoll_fd(-1), m_epoll_events(0),
+    m_epoll_events_size(0), m_timer_backend(TIMER_BACKEND_MAP),
+    m_timer_wheel(0), m_expiring_timer(0)
 {
   FD_ZERO(&rd_set);
   FD_ZERO(&wr_set);
   sighandler_pipe[0] = sighandler_pipe[1] = -1;
+
+  const char *backend_str = getenv("ASYNC_CPP_APP_BACKEND");
+  if (backend_str != 0)
+  {
+    Backend backend;
+    if (!backendFromName(backend_str, backend) || !setBackend(backend))
+    {
+      std::cerr << "*** WARNING: Unknown or unsupported backend \""
+                << backend_str << "\" specified in environment variable "
+                   "ASYNC_CPP_APP_BACKEND. Using \"select\"." << std::endl;
+    }
+  }
+
+  const char *timers_str = getenv("ASYNC_CPP_APP_TIMERS");
+  if (timers_str != 0)
+  {
+    TimerBackend timer_backend;
+    if (timerBackendFromName(timers_str, timer_backend))
+    {
+      setTimerBackend(timer_backend);
+    }
+    else
+    {
+      std::cerr << "*** WARNING: Unknown timer backend \"" << timers_str
+                << "\" specified in environment variable "
+                   "ASYNC_CPP_APP_TIMERS. Using \"map\"." << std::endl;
+    }
+  }
 } /* CppApplication::CppApplication */
 
 
 CppApplication::~CppApplication(void)
 {
   clearTasks();
+  epollTeardown();
+  delete m_timer_wheel;
+  m_timer_wheel = 0;
 } /* CppApplication::~CppApplication */
 
 
+bool CppApplication::setBackend(Backend backend)
+{
+  assert(sighandler_pipe[0] == -1);
+#ifndef HAS_EPOLL_SUPPORT
+  if (backend != BACKEND_SELECT)
+  {
+    return false;
+  }
+#endif
+  m_backend = backend;
+  return true;
+} /* CppApplication::setBackend */
+
+
+void CppApplication::setTimerBackend(TimerBackend backend)
+{
+  assert(m_timer_wheel == 0);
+  m_timer_backend = backend;
+} /* CppApplication::setTimerBackend */
+
+
 void CppApplication::exec(void)
 {
   if (pipe(sighandler_pipe) == -1)
@@ -203,11 +314,26 @@ void CppApplication::exec(void)
     }
   }
   
+  if (m_backend != BACKEND_SELECT)
+  {
+    epollSetup();
+  }
+
+  if ((m_timer_backend == TIMER_BACKEND_WHEEL) && (m_timer_wheel == 0))
+  {
+    timerWheelSetup();
+  }
+
   while (!do_quit)
   {
     struct timespec *timeout_ptr = 0;
     struct timespec timeout;
     TimerMap::iterator titer = timer_map.begin();
+    if (m_timer_wheel != 0)
+    {
+      timeout_ptr = timerWheelTimeout(timeout);
+      titer = timer_map.end();
+    }
     while (titer != timer_map.end())
     {
       if (titer->second != 0)
@@ -229,11 +355,21 @@ void CppApplication::exec(void)
       }
       titer = timer_map.begin();
     }
-    
-    fd_set local_rd_set = rd_set;
-    fd_set local_wr_set = wr_set;
-    int dcnt = pselect(max_desc, &local_rd_set, &local_wr_set, NULL,
-	timeout_ptr, NULL);
+
+    fd_set local_rd_set;
+    fd_set local_wr_set;
+    int dcnt;
+    if (m_backend == BACKEND_SELECT)
+    {
+      local_rd_set = rd_set;
+      local_wr_set = wr_set;
+      dcnt = pselect(max_desc, &local_rd_set, &local_wr_set, NULL,
+                     timeout_ptr, NULL);
+    }
+    else
+    {
+      dcnt = epollWait(timeout_ptr);
+    }
     if (dcnt == -1)
     {
       if ((errno == EINTR) || (errno == EAGAIN))
@@ -242,12 +378,16 @@ void CppApplication::exec(void)
       }
       else
       {
-        perror("pselect");
+        perror((m_backend == BACKEND_SELECT) ? "pselect" : "epoll_wait");
         exit(1);
       }
     }
     
-    if ((timeout_ptr != 0)
+    if (m_timer_wheel != 0)
+    {
+      timerWheelExpire();
+    }
+    else if ((timeout_ptr != 0)
         && ((dcnt == 0)
             || ((timeout_ptr->tv_sec == 0) && (timeout_ptr->tv_nsec == 0))
            )
@@ -262,6 +402,43 @@ void CppApplication::exec(void)
       timer_map.erase(titer);
     }
     
+    if (m_backend != BACKEND_SELECT)
+    {
+#ifdef HAS_EPOLL_SUPPORT
+        /* Dispatch activity for the file descriptors that are ready */
+      for (int i=0; i<dcnt; ++i)
+      {
+        int fd = m_epoll_events[i].data.fd;
+        uint32_t events = m_epoll_events[i].events;
+        if (events & (EPOLLIN | EPOLLPRI | EPOLLHUP | EPOLLERR))
+        {
+          WatchMap::iterator witer = rd_watch_map.find(fd);
+          if ((witer != rd_watch_map.end()) && (witer->second != 0))
+          {
+            witer->second->activity(witer->second);
+          }
+        }
+        if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+        {
+          WatchMap::iterator witer = wr_watch_map.find(fd);
+          if ((witer != wr_watch_map.end()) && (witer->second != 0))
+          {
+            witer->second->activity(witer->second);
+          }
+        }
+      }
+
+        /* Grow the event buffer if it was filled up */
+      if (dcnt == m_epoll_events_size)
+      {
+        delete [] m_epoll_events;
+        m_epoll_events_size *= 2;
+        m_epoll_events = new struct epoll_event[m_epoll_events_size];
+      }
+#endif
+      continue;
+    }
+
     WatchMap::iterator witer, next_witer;
     
       /* Check for activity on the read watch file descriptors */
@@ -309,6 +486,8 @@ void CppApplication::exec(void)
     assert(dcnt == 0);
   }
 
+  epollTeardown();
+
   for (UnixSignalMap::const_iterator it = unix_signals.begin();
        it != unix_signals.end();
        ++it)
@@ -426,16 +605,23 @@ void CppApplication::addFdWatch(FdWatch *fd_watch)
   switch (fd_watch->type())
   {
     case FdWatch::FD_WATCH_RD:
-      FD_SET(fd, &rd_set);
+      if (fd < FD_SETSIZE)
+      {
+        FD_SET(fd, &rd_set);
+      }
       watch_map = &rd_watch_map;
       break;
 
     case FdWatch::FD_WATCH_WR:
-      FD_SET(fd, &wr_set);
+      if (fd < FD_SETSIZE)
+      {
+        FD_SET(fd, &wr_set);
+      }
       watch_map = &wr_watch_map;
       break;
   }
   assert(watch_map != 0);
+  assert((m_backend != BACKEND_SELECT) || (fd < FD_SETSIZE));
 
   WatchMap::iterator iter = watch_map->find(fd);
   assert((iter == watch_map->end()) || (iter->second == 0));
@@ -446,7 +632,11 @@ void CppApplication::addFdWatch(FdWatch *fd_watch)
   }
 
   (*watch_map)[fd] = fd_watch;
-  
+
+  if (m_epoll_fd >= 0)
+  {
+    epollUpdate(fd);
+  }
 } /* CppApplication::addFdWatch */
 
 
@@ -457,12 +647,18 @@ void CppApplication::delFdWatch(FdWatch *fd_watch)
   switch (fd_watch->type())
   {
     case FdWatch::FD_WATCH_RD:
-      FD_CLR(fd, &rd_set);
+      if (fd < FD_SETSIZE)
+      {
+        FD_CLR(fd, &rd_set);
+      }
       watch_map = &rd_watch_map;
       break;
       
     case FdWatch::FD_WATCH_WR:
-      FD_CLR(fd, &wr_set);
+      if (fd < FD_SETSIZE)
+      {
+        FD_CLR(fd, &wr_set);
+      }
       watch_map = &wr_watch_map;
       break;
   }
@@ -471,6 +667,11 @@ void CppApplication::delFdWatch(FdWatch *fd_watch)
   WatchMap::iterator iter = watch_map->find(fd);
   assert((iter != watch_map->end()) && (iter->second != 0));
   iter->second = 0;
+
+  if (m_epoll_fd >= 0)
+  {
+    epollUpdate(fd);
+  }
   
   if (fd+1 == max_desc)
   {
@@ -504,6 +705,16 @@ void CppApplication::addTimer(Timer *timer)
 {
   struct timespec current;
   clock_gettime(CLOCK_MONOTONIC, &current);
+  if (m_timer_wheel != 0)
+  {
+      // Round up to make sure that the timer never expire too early. A zero
+      // timeout should expire as soon as possible so no rounding is needed.
+    uint64_t now_tick = (timer->timeout() > 0)
+      ? clock_ceil_ms(&current)
+      : clock_floor_ms(&current);
+    m_timer_wheel->add(timer, now_tick + timer->timeout());
+    return;
+  }
   addTimerP(timer, current);
 } /* CppApplication::addTimer */
 
@@ -524,6 +735,16 @@ void CppApplication::addTimerP(Timer *timer, const struct timespec& current)
 
 void CppApplication::delTimer(Timer *timer)
 {
+  if (m_timer_wheel != 0)
+  {
+    if (timer == m_expiring_timer)
+    {
+      m_expiring_timer = 0;
+    }
+    m_timer_wheel->remove(timer);
+    return;
+  }
+
   TimerMap::iterator iter;
   for (iter=timer_map.begin(); iter!=timer_map.end(); ++iter)
   {
@@ -560,6 +781,268 @@ void CppApplication::handleUnixSignal(void)
 } /* CppApplication::handleUnixSignal */
 
 
+int CppApplication::epollWait(struct timespec *timeout_ptr)
+{
+#ifdef HAS_EPOLL_SUPPORT
+    // Round the timeout up to whole milliseconds so that we never wake up
+    // before the first timer has expired
+  int timeout_ms = -1;
+  if (timeout_ptr != 0)
+  {
+    if (timeout_ptr->tv_sec > 1000000)
+    {
+      timeout_ms = 1000000000;
+    }
+    else
+    {
+      timeout_ms = timeout_ptr->tv_sec * 1000 +
+                   (timeout_ptr->tv_nsec + 999999) / 1000000;
+    }
+  }
+
+    // Descriptors that cannot be handled by epoll, like regular files, are
+    // always reported as ready, just like select would do
+  int always_ready_cnt = m_epoll_always_ready.size();
+  if (always_ready_cnt > 0)
+  {
+    timeout_ms = 0;
+    if (always_ready_cnt >= m_epoll_events_size)
+    {
+      delete [] m_epoll_events;
+      m_epoll_events_size = 2 * always_ready_cnt;
+      m_epoll_events = new struct epoll_event[m_epoll_events_size];
+    }
+  }
+
+  int dcnt = epoll_wait(m_epoll_fd, m_epoll_events,
+                        m_epoll_events_size - always_ready_cnt, timeout_ms);
+  if (dcnt < 0)
+  {
+    return dcnt;
+  }
+
+  for (EpollFdSet::const_iterator it = m_epoll_always_ready.begin();
+       it != m_epoll_always_ready.end();
+       ++it)
+  {
+    struct epoll_event& ev = m_epoll_events[dcnt++];
+    ev.data.fd = *it;
+    ev.events = 0;
+    if (watchIsActive(rd_watch_map, *it))
+    {
+      ev.events |= EPOLLIN;
+    }
+    if (watchIsActive(wr_watch_map, *it))
+    {
+      ev.events |= EPOLLOUT;
+    }
+  }
+
+  return dcnt;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+} /* CppApplication::epollWait */
+
+
+void CppApplication::epollSetup(void)
+{
+#ifdef HAS_EPOLL_SUPPORT
+  assert(m_epoll_fd < 0);
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll_fd == -1)
+  {
+    perror("epoll_create1");
+    exit(1);
+  }
+  m_epoll_events_size = EPOLL_INITIAL_EVENTS;
+  m_epoll_events = new struct epoll_event[m_epoll_events_size];
+
+    // Move all watches set up before the main loop was started over to epoll
+  for (WatchMap::const_iterator it = rd_watch_map.begin();
+       it != rd_watch_map.end();
+       ++it)
+  {
+    if (it->second != 0)
+    {
+      epollUpdate(it->first);
+    }
+  }
+  for (WatchMap::const_iterator it = wr_watch_map.begin();
+       it != wr_watch_map.end();
+       ++it)
+  {
+    if (it->second != 0)
+    {
+      epollUpdate(it->first);
+    }
+  }
+#endif
+} /* CppApplication::epollSetup */
+
+
+void CppApplication::epollTeardown(void)
+{
+#ifdef HAS_EPOLL_SUPPORT
+  if (m_epoll_fd >= 0)
+  {
+    close(m_epoll_fd);
+    m_epoll_fd = -1;
+  }
+  delete [] m_epoll_events;
+  m_epoll_events = 0;
+  m_epoll_events_size = 0;
+  m_epoll_mask.clear();
+  m_epoll_always_ready.clear();
+#endif
+} /* CppApplication::epollTeardown */
+
+
+void CppApplication::epollUpdate(int fd)
+{
+#ifdef HAS_EPOLL_SUPPORT
+  uint32_t events = 0;
+  if (watchIsActive(rd_watch_map, fd))
+  {
+    events |= EPOLLIN;
+  }
+  if (watchIsActive(wr_watch_map, fd))
+  {
+    events |= EPOLLOUT;
+  }
+
+  EpollMaskMap::iterator it = m_epoll_mask.find(fd);
+  if (events == 0)
+  {
+    if (it != m_epoll_mask.end())
+    {
+        // The file descriptor may already have been closed, in which case
+        // the kernel have removed it from the epoll set automatically
+      epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      m_epoll_mask.erase(it);
+    }
+    m_epoll_always_ready.erase(fd);
+    return;
+  }
+
+  if (m_epoll_always_ready.count(fd) > 0)
+  {
+    return;
+  }
+
+  if (m_backend == BACKEND_EPOLL_ET)
+  {
+    events |= EPOLLET;
+  }
+  if ((it != m_epoll_mask.end()) && (it->second == events))
+  {
+    return;
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = fd;
+  int op = (it == m_epoll_mask.end()) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  int ret = epoll_ctl(m_epoll_fd, op, fd, &ev);
+  if ((ret == -1) && (op == EPOLL_CTL_MOD) && (errno == ENOENT))
+  {
+      // The file descriptor have been closed and reopened since it was added
+    ret = epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+  }
+  else if ((ret == -1) && (op == EPOLL_CTL_ADD) && (errno == EEXIST))
+  {
+    ret = epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+  }
+  if ((ret == -1) && (errno == EPERM))
+  {
+      // The file descriptor does not support epoll, e.g. a regular file
+    m_epoll_always_ready.insert(fd);
+    return;
+  }
+  if (ret == -1)
+  {
+    perror("epoll_ctl");
+    exit(1);
+  }
+  m_epoll_mask[fd] = events;
+#endif
+} /* CppApplication::epollUpdate */
+
+
+bool CppApplication::watchIsActive(const WatchMap& watch_map, int fd) const
+{
+  WatchMap::const_iterator it = watch_map.find(fd);
+  return (it != watch_map.end()) && (it->second != 0);
+} /* CppApplication::watchIsActive */
+
+
+void CppApplication::timerWheelSetup(void)
+{
+  struct timespec current;
+  clock_gettime(CLOCK_MONOTONIC, &current);
+  m_timer_wheel = new TimerWheel(clock_floor_ms(&current));
+
+    // Move all timers started before the main loop was started to the wheel
+  for (TimerMap::iterator it = timer_map.begin(); it != timer_map.end(); ++it)
+  {
+    if (it->second != 0)
+    {
+      m_timer_wheel->add(it->second, clock_ceil_ms(&it->first));
+    }
+  }
+  timer_map.clear();
+} /* CppApplication::timerWheelSetup */
+
+
+struct timespec *CppApplication::timerWheelTimeout(struct timespec& timeout)
+{
+  uint64_t next_tick;
+  if (!m_timer_wheel->nextExpiry(next_tick))
+  {
+    return 0;
+  }
+
+  struct timespec current;
+  clock_gettime(CLOCK_MONOTONIC, &current);
+  struct timespec next;
+  next.tv_sec = next_tick / 1000;
+  next.tv_nsec = (next_tick % 1000) * 1000000;
+  clock_timersub(&next, &current, &timeout);
+  if (timeout.tv_sec < 0)
+  {
+    timeout.tv_sec = 0;
+    timeout.tv_nsec = 0;
+  }
+  return &timeout;
+} /* CppApplication::timerWheelTimeout */
+
+
+void CppApplication::timerWheelExpire(void)
+{
+  struct timespec current;
+  clock_gettime(CLOCK_MONOTONIC, &current);
+  m_timer_wheel->advance(clock_floor_ms(&current));
+
+    // Timers that are started from an expiration handler will be handled in
+    // the next main loop iteration at the earliest
+  Timer *timer;
+  uint64_t expire_tick;
+  while ((timer = m_timer_wheel->popExpired(expire_tick)) != 0)
+  {
+    m_expiring_timer = timer;
+    timer->expired(timer);
+    if ((m_expiring_timer != 0) &&
+        (m_expiring_timer->type() == Timer::TYPE_PERIODIC))
+    {
+      m_timer_wheel->add(timer, expire_tick + timer->timeout());
+    }
+    m_expiring_timer = 0;
+  }
+} /* CppApplication::timerWheelExpire */
+
+
 
 /*
  * This file has not been truncated
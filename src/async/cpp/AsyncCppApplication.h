@@ -45,7 +45,10 @@
 #include <sigc++/sigc++.h>
 
 #include <map>
+#include <set>
+#include <string>
 #include <utility>
+#include <cstdint>
 
 
 /****************************************************************************
@@ -71,6 +74,7 @@
  *
  ****************************************************************************/
 
+struct epoll_event;
 
 
 /****************************************************************************
@@ -82,6 +86,16 @@
 namespace Async
 {
 
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class TimerWheel;
+
+
 /****************************************************************************
  *
  * Defines & typedefs
@@ -136,8 +150,74 @@ namespace Async
 class CppApplication : public Application
 {
   public:
+    /**
+     * @brief The I/O multiplexing mechanism used by the main loop
+     *
+     * BACKEND_SELECT is the classic pselect based implementation. It is
+     * portable but the cost of each loop iteration is proportional to the
+     * number of watched file descriptors and descriptors may not be larger
+     * than FD_SETSIZE.
+     *
+     * BACKEND_EPOLL use the Linux epoll API in level triggered mode. The cost
+     * of each loop iteration is proportional to the number of file
+     * descriptors that are ready and there is no FD_SETSIZE limit.
+     *
+     * BACKEND_EPOLL_ET use the Linux epoll API in edge triggered mode. This
+     * save some work in the kernel but require that all FdWatch users read
+     * or write until EAGAIN on each activity signal. Do not use this mode
+     * unless you know that all watches in the application behave that way.
+     */
+    typedef enum
+    {
+      BACKEND_SELECT,   ///< Use pselect (the default)
+      BACKEND_EPOLL,    ///< Use level triggered epoll
+      BACKEND_EPOLL_ET  ///< Use edge triggered epoll
+    } Backend;
+
+    /**
+     * @brief The data structure used to keep track of active timers
+     *
+     * TIMER_BACKEND_MAP keep all timers in a map sorted on expiration time.
+     * Only one timer is handled per main loop iteration.
+     *
+     * TIMER_BACKEND_WHEEL use a hierarchical timer wheel with constant time
+     * start and stop of timers. All timers that have expired are handled in
+     * one main loop iteration. The resolution is one millisecond.
+     */
+    typedef enum
+    {
+      TIMER_BACKEND_MAP,    ///< Use a sorted map (the default)
+      TIMER_BACKEND_WHEEL   ///< Use a hierarchical timer wheel
+    } TimerBackend;
+
+    /**
+     * @brief   Convert a backend name to a backend identifier
+     * @param   name    The name of the backend ("select", "epoll", "epoll_et")
+     * @param   backend The backend identifier is returned here
+     * @return  Returns \em true on success or \em false if the name is unknown
+     */
+    static bool backendFromName(const std::string& name, Backend& backend);
+
+    /**
+     * @brief   Convert a timer backend name to a timer backend identifier
+     * @param   name    The name of the timer backend ("map", "wheel")
+     * @param   backend The timer backend identifier is returned here
+     * @return  Returns \em true on success or \em false if the name is unknown
+     */
+    static bool timerBackendFromName(const std::string& name,
+                                     TimerBackend& backend);
+
     /**
      * @brief Constructor
+     *
+     * The backend used by the main loop is by default BACKEND_SELECT. It can
+     * be changed by setting the environment variable ASYNC_CPP_APP_BACKEND to
+     * one of "select", "epoll" or "epoll_et" or by calling setBackend before
+     * calling exec.
+     *
+     * The timer backend is by default TIMER_BACKEND_MAP. It can be changed by
+     * setting the environment variable ASYNC_CPP_APP_TIMERS to "map" or
+     * "wheel" or by calling setTimerBackend before calling exec.
      */
     CppApplication(void);
 
@@ -158,6 +238,40 @@ class CppApplication : public Application
      */
     void uncatchUnixSignal(int signum);
 
+    /**
+     * @brief   Choose the I/O multiplexing backend
+     * @param   backend The backend to use
+     * @return  Returns \em true on success or \em false if the backend is
+     *          not supported on this platform
+     *
+     * The backend can only be changed before the exec function is called.
+     * File descriptor watches that have already been set up will be moved
+     * over to the new backend when the main loop is started.
+     */
+    bool setBackend(Backend backend);
+
+    /**
+     * @brief   Get the I/O multiplexing backend in use
+     * @return  Returns the backend identifier
+     */
+    Backend backend(void) const { return m_backend; }
+
+    /**
+     * @brief   Choose the timer backend
+     * @param   backend The timer backend to use
+     *
+     * The timer backend can only be changed before the exec function is
+     * called. Timers that have already been started will be moved over to
+     * the new backend when the main loop is started.
+     */
+    void setTimerBackend(TimerBackend backend);
+
+    /**
+     * @brief   Get the timer backend in use
+     * @return  Returns the timer backend identifier
+     */
+    TimerBackend timerBackend(void) const { return m_timer_backend; }
+
     /**
      * @brief Execute the application main loop
      *
@@ -199,7 +313,9 @@ class CppApplication : public Application
     typedef std::map<int, FdWatch*>   	      	      	        WatchMap;
     typedef std::multimap<struct timespec, Timer *, lttimespec> TimerMap;
     typedef std::map<int, struct sigaction>                     UnixSignalMap;
-    
+    typedef std::map<int, uint32_t>                             EpollMaskMap;
+    typedef std::set<int>                                       EpollFdSet;
+
     static int          sighandler_pipe[2];
 
     bool      	      	do_quit;
@@ -212,7 +328,16 @@ class CppApplication : public Application
     UnixSignalMap       unix_signals;
     int                 unix_signal_recv;
     size_t              unix_signal_recv_cnt;
-    
+    Backend             m_backend;
+    int                 m_epoll_fd;
+    EpollMaskMap        m_epoll_mask;
+    EpollFdSet          m_epoll_always_ready;
+    struct epoll_event  *m_epoll_events;
+    int                 m_epoll_events_size;
+    TimerBackend        m_timer_backend;
+    TimerWheel          *m_timer_wheel;
+    Timer               *m_expiring_timer;
+
     static void unixSignalHandler(int signum);
 
     void addFdWatch(FdWatch *fd_watch);
@@ -222,7 +347,15 @@ class CppApplication : public Application
     void delTimer(Timer *timer);    
     DnsLookupWorker *newDnsLookupWorker(const DnsLookup& lookup);
     void handleUnixSignal(void);
-    
+    int epollWait(struct timespec *timeout_ptr);
+    void epollSetup(void);
+    void epollTeardown(void);
+    void epollUpdate(int fd);
+    bool watchIsActive(const WatchMap& watch_map, int fd) const;
+    void timerWheelSetup(void);
+    struct timespec *timerWheelTimeout(struct timespec& timeout);
+    void timerWheelExpire(void);
+
 };  /* class CppApplication */
 
 
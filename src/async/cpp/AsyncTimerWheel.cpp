@@ -0,0 +1,418 @@
+/**
+@file   AsyncTimerWheel.cpp
+@brief  A hierarchical timer wheel used to schedule Async::Timer objects
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2025 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncTimerWheel.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Static class variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+
+
+}; /* End of anonymous namespace */
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+TimerWheel::TimerWheel(uint64_t now_tick)
+  : m_tick(now_tick)
+{
+  for (unsigned level=0; level<LEVELS; ++level)
+  {
+    m_level_cnt[level] = 0;
+    for (unsigned idx=0; idx<SLOTS; ++idx)
+    {
+      listInit(m_slots[level][idx]);
+    }
+  }
+  listInit(m_due);
+  listInit(m_expired);
+} /* TimerWheel::TimerWheel */
+
+
+TimerWheel::~TimerWheel(void)
+{
+  for (TimerIndex::iterator it = m_timers.begin(); it != m_timers.end(); ++it)
+  {
+    delete it->second;
+  }
+  for (std::vector<Node*>::iterator it = m_free_nodes.begin();
+       it != m_free_nodes.end();
+       ++it)
+  {
+    delete *it;
+  }
+} /* TimerWheel::~TimerWheel */
+
+
+void TimerWheel::add(Timer *timer, uint64_t expire_tick)
+{
+  Node *node = 0;
+  if (!m_free_nodes.empty())
+  {
+    node = m_free_nodes.back();
+    m_free_nodes.pop_back();
+  }
+  else
+  {
+    node = new Node;
+  }
+  node->timer = timer;
+  node->expire = expire_tick;
+  node->level = -1;
+
+  bool inserted = m_timers.insert(TimerIndex::value_type(timer, node)).second;
+  assert(inserted);
+  (void)inserted;
+
+  insert(node);
+} /* TimerWheel::add */
+
+
+bool TimerWheel::remove(Timer *timer)
+{
+  TimerIndex::iterator it = m_timers.find(timer);
+  if (it == m_timers.end())
+  {
+    return false;
+  }
+  Node *node = it->second;
+  m_timers.erase(it);
+  if (node->level >= 0)
+  {
+    --m_level_cnt[node->level];
+  }
+  listUnlink(node);
+  m_free_nodes.push_back(node);
+  return true;
+} /* TimerWheel::remove */
+
+
+bool TimerWheel::nextExpiry(uint64_t& tick) const
+{
+  if (!listEmpty(m_due) || !listEmpty(m_expired))
+  {
+    tick = m_tick;
+    return true;
+  }
+  unsigned lowest = 0;
+  while ((lowest < LEVELS) && (m_level_cnt[lowest] == 0))
+  {
+    ++lowest;
+  }
+  if (lowest == LEVELS)
+  {
+    return false;
+  }
+
+    // The first level hold all timers that expire within SLOTS ticks so
+    // they can be found exactly. A cascade may bring in more timers so we
+    // need to wake up at each cascade that is non-empty.
+  if (lowest == 0)
+  {
+    for (uint64_t t=m_tick+1; t<=m_tick+SLOTS; ++t)
+    {
+      if ((((t & SLOT_MASK) == 0) && cascadeHasTimers(t)) ||
+          !listEmpty(m_slots[0][t & SLOT_MASK]))
+      {
+        tick = t;
+        return true;
+      }
+    }
+  }
+
+    // Timers in the upper levels are found at the next cascade point
+  for (unsigned level=std::max(lowest, 1U); level<LEVELS; ++level)
+  {
+    const unsigned shift = level * SLOT_BITS;
+    const uint64_t base = m_tick >> shift;
+    for (uint64_t k=1; k<=SLOTS; ++k)
+    {
+      uint64_t t = (base + k) << shift;
+      if (cascadeHasTimers(t))
+      {
+        tick = t;
+        return true;
+      }
+    }
+  }
+
+  assert(!"TimerWheel::nextExpiry: Timer not found in wheel");
+  return false;
+} /* TimerWheel::nextExpiry */
+
+
+void TimerWheel::advance(uint64_t now_tick)
+{
+  listSplice(m_expired, m_due);
+  while (m_tick < now_tick)
+  {
+      // Skip ahead to the next cascade point if the lower levels are empty
+    unsigned lowest = 0;
+    while ((lowest < LEVELS) && (m_level_cnt[lowest] == 0))
+    {
+      ++lowest;
+    }
+    if (lowest == LEVELS)
+    {
+      m_tick = now_tick;
+      break;
+    }
+    if (lowest > 0)
+    {
+      const unsigned shift = lowest * SLOT_BITS;
+      const uint64_t next_cascade = ((m_tick >> shift) + 1) << shift;
+      if (next_cascade > now_tick)
+      {
+        m_tick = now_tick;
+        break;
+      }
+      m_tick = next_cascade - 1;
+    }
+
+    ++m_tick;
+    const unsigned idx = m_tick & SLOT_MASK;
+    if (idx == 0)
+    {
+      for (unsigned level=1; level<LEVELS; ++level)
+      {
+        const unsigned lidx = (m_tick >> (level * SLOT_BITS)) & SLOT_MASK;
+        cascade(level, lidx);
+        if (lidx != 0)
+        {
+          break;
+        }
+      }
+      listSplice(m_expired, m_due);
+    }
+
+    Node& slot = m_slots[0][idx];
+    while (!listEmpty(slot))
+    {
+      Node *node = slot.next;
+      listUnlink(node);
+      node->level = -1;
+      --m_level_cnt[0];
+      listAppend(m_expired, node);
+    }
+  }
+} /* TimerWheel::advance */
+
+
+Timer *TimerWheel::popExpired(uint64_t& expire_tick)
+{
+  if (listEmpty(m_expired))
+  {
+    return 0;
+  }
+  Node *node = m_expired.next;
+  listUnlink(node);
+  m_timers.erase(node->timer);
+  m_free_nodes.push_back(node);
+  expire_tick = node->expire;
+  return node->timer;
+} /* TimerWheel::popExpired */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void TimerWheel::listInit(Node& head)
+{
+  head.prev = head.next = &head;
+  head.timer = 0;
+  head.expire = 0;
+  head.level = -1;
+} /* TimerWheel::listInit */
+
+
+void TimerWheel::listAppend(Node& head, Node *node)
+{
+  node->prev = head.prev;
+  node->next = &head;
+  head.prev->next = node;
+  head.prev = node;
+} /* TimerWheel::listAppend */
+
+
+void TimerWheel::listUnlink(Node *node)
+{
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->prev = node->next = node;
+} /* TimerWheel::listUnlink */
+
+
+void TimerWheel::listSplice(Node& dst, Node& src)
+{
+  if (listEmpty(src))
+  {
+    return;
+  }
+  Node *first = src.next;
+  Node *last = src.prev;
+  first->prev = dst.prev;
+  dst.prev->next = first;
+  last->next = &dst;
+  dst.prev = last;
+  listInit(src);
+} /* TimerWheel::listSplice */
+
+
+void TimerWheel::insert(Node *node)
+{
+  if (node->expire <= m_tick)
+  {
+    node->level = -1;
+    listAppend(m_due, node);
+    return;
+  }
+
+  const uint64_t delta = node->expire - m_tick;
+  unsigned level = 0;
+  while ((level < LEVELS-1) && (delta >> ((level + 1) * SLOT_BITS)) != 0)
+  {
+    ++level;
+  }
+  assert((delta >> (LEVELS * SLOT_BITS)) == 0);
+  const unsigned idx = (node->expire >> (level * SLOT_BITS)) & SLOT_MASK;
+  node->level = level;
+  ++m_level_cnt[level];
+  listAppend(m_slots[level][idx], node);
+} /* TimerWheel::insert */
+
+
+void TimerWheel::cascade(unsigned level, unsigned idx)
+{
+  Node tmp;
+  listInit(tmp);
+  listSplice(tmp, m_slots[level][idx]);
+  while (!listEmpty(tmp))
+  {
+    Node *node = tmp.next;
+    listUnlink(node);
+    --m_level_cnt[level];
+    insert(node);
+  }
+} /* TimerWheel::cascade */
+
+
+bool TimerWheel::cascadeHasTimers(uint64_t tick) const
+{
+  for (unsigned level=1; level<LEVELS; ++level)
+  {
+    const unsigned lidx = (tick >> (level * SLOT_BITS)) & SLOT_MASK;
+    if (!listEmpty(m_slots[level][lidx]))
+    {
+      return true;
+    }
+    if (lidx != 0)
+    {
+      break;
+    }
+  }
+  return false;
+} /* TimerWheel::cascadeHasTimers */
+
+
+/*
+ * This file has not been truncated
+ */
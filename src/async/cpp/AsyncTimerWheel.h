@@ -0,0 +1,255 @@
+/**
+@file   AsyncTimerWheel.h
+@brief  A hierarchical timer wheel used to schedule Async::Timer objects
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a hierarchical timer wheel that is used by
+Async::CppApplication as an alternative to keeping all timers in a sorted
+map. Starting and stopping a timer is O(1) and all timers that are due are
+collected in one batch. This class should never be used directly.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2025 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_TIMER_WHEEL_INCLUDED
+#define ASYNC_TIMER_WHEEL_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class Timer;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A hierarchical timer wheel
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+The wheel consist of four levels with 256 slots each. One tick on the first
+level is one millisecond, which is the resolution of Async::Timer. Each level
+above covers 256 times the time span of the level below, so the total range
+is 2^32 ms, which is more than what fit in the timeout of a timer. Timers in
+the upper levels are cascaded down one level at a time as time progresses.
+
+All times are given as absolute tick counts. The caller decide what the tick
+count is relative to, e.g. milliseconds since the epoch of CLOCK_MONOTONIC.
+*/
+class TimerWheel
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   now_tick The current tick count
+     */
+    explicit TimerWheel(uint64_t now_tick);
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    TimerWheel(const TimerWheel&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief   Destructor
+     */
+    ~TimerWheel(void);
+
+    /**
+     * @brief   Add a timer to the wheel
+     * @param   timer       The timer to add
+     * @param   expire_tick The tick count when the timer should expire
+     *
+     * A timer must not be added twice. An expire tick that has already
+     * passed will make the timer expire at the next call to advance.
+     */
+    void add(Timer *timer, uint64_t expire_tick);
+
+    /**
+     * @brief   Remove a timer from the wheel
+     * @param   timer The timer to remove
+     * @return  Returns \em true if the timer was found or \em false if not
+     *
+     * The timer will also be removed if it has expired but not yet been
+     * popped using popExpired.
+     */
+    bool remove(Timer *timer);
+
+    /**
+     * @brief   Find out when the next timer expire
+     * @param   tick The tick count is returned here
+     * @return  Returns \em true if there are timers or \em false otherwise
+     *
+     * The returned tick count may be earlier than the real expiration time
+     * of the next timer if a cascade of an upper level is needed first. It is
+     * never later.
+     */
+    bool nextExpiry(uint64_t& tick) const;
+
+    /**
+     * @brief   Advance the wheel to the given time
+     * @param   now_tick The current tick count
+     *
+     * All timers that expire up to and including the given tick count will
+     * be moved to the list of expired timers. Use popExpired to fetch them.
+     */
+    void advance(uint64_t now_tick);
+
+    /**
+     * @brief   Fetch the next expired timer
+     * @param   expire_tick The expiration tick of the timer is returned here
+     * @return  Returns the timer or 0 if there are no more expired timers
+     *
+     * The timer is no longer part of the wheel when it has been returned.
+     */
+    Timer *popExpired(uint64_t& expire_tick);
+
+    /**
+     * @brief   Get the current tick count of the wheel
+     * @return  Returns the last tick count that the wheel was advanced to
+     */
+    uint64_t tick(void) const { return m_tick; }
+
+    /**
+     * @brief   Get the number of timers handled by the wheel
+     * @return  Returns the number of timers, including expired ones
+     */
+    size_t size(void) const { return m_timers.size(); }
+
+  private:
+    static const unsigned LEVELS      = 4;
+    static const unsigned SLOT_BITS   = 8;
+    static const unsigned SLOTS       = 1 << SLOT_BITS;
+    static const unsigned SLOT_MASK   = SLOTS - 1;
+
+    struct Node
+    {
+      Timer*    timer;
+      uint64_t  expire;
+      Node*     prev;
+      Node*     next;
+      int       level;
+    };
+    typedef std::unordered_map<Timer*, Node*> TimerIndex;
+
+    uint64_t            m_tick;
+    Node                m_slots[LEVELS][SLOTS];
+    Node                m_due;
+    Node                m_expired;
+    size_t              m_level_cnt[LEVELS];
+    TimerIndex          m_timers;
+    std::vector<Node*>  m_free_nodes;
+
+    static void listInit(Node& head);
+    static bool listEmpty(const Node& head) { return head.next == &head; }
+    static void listAppend(Node& head, Node *node);
+    static void listUnlink(Node *node);
+    static void listSplice(Node& dst, Node& src);
+
+    void insert(Node *node);
+    void cascade(unsigned level, unsigned idx);
+    bool cascadeHasTimers(uint64_t tick) const;
+
+};  /* class TimerWheel */
+
+
+} /* namespace Async */
+
+#endif /* ASYNC_TIMER_WHEEL_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
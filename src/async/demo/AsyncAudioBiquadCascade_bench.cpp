@@ -0,0 +1,233 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+
+#include <AsyncAudioFilter.h>
+#include <AsyncAudioBiquadCascade.h>
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Compiled biquad cascade versus fidlib filter benchmark
+ *
+ * Usage: AsyncAudioBiquadCascade_bench [seconds of audio]
+ *
+ * The filters used in SvxLink are run both by the fidlib filter interpreter
+ * and as compiled biquad cascades. The output of the two must be the same.
+ * The biquad cascade is also run for a number of channels at the same time
+ * and each channel must give the same output as a single channel filter.
+ * The CPU time used per channel is then measured for the fidlib
+ * interpreter, a single channel biquad cascade and a four channel biquad
+ * cascade. The exit status is zero if all filters give the same output.
+ */
+
+namespace {
+  const int SAMPLE_RATE = 16000;
+  const int BLOCK_SIZE = 160;
+  const double MAX_DIFF = 1.0e-6;
+
+  const char *filter_specs[] = {
+    "LpCh9/-0.05/5000",
+    "LpCh9/-0.05/5500 x HpCh12/-0.05/300",
+    "LpBu20/3500 x HpCh12/-0.05/300",
+    "BpCh10/-0.1/300-5000",
+    "BpBu3/1000-1300",
+    "HsBq1/0.05/36/3500",
+    "HpBu1/50 x LpBu1/150",
+    "BpBu4/300-4300 x 0.5 0.3 / 1.0 -0.4",
+  };
+
+  class Filter : public AudioFilter
+  {
+    public:
+      Filter(const string &spec, bool fidlib) : AudioFilter(SAMPLE_RATE)
+      {
+        if (fidlib)
+        {
+          setenv("ASYNC_AUDIO_FILTER_FIDLIB", "1", 1);
+        }
+        if (!parseFilterSpec(spec))
+        {
+          cerr << "*** ERROR: " << spec << ": " << errorString() << endl;
+          exit(1);
+        }
+        unsetenv("ASYNC_AUDIO_FILTER_FIDLIB");
+        setOutputGain(-3.0f);
+      }
+      using AudioFilter::processSamples;
+  };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  vector<float> makeSignal(int len, unsigned seed)
+  {
+    mt19937 rng(seed);
+    normal_distribution<float> noise(0.0f, 0.1f);
+    vector<float> sig(len);
+    for (int n=0; n<len; ++n)
+    {
+      sig[n] = noise(rng) + 0.4f * sin(2.0 * M_PI * 1000.0 * n / SAMPLE_RATE) +
+               0.3f * sin(2.0 * M_PI * 4800.0 * n / SAMPLE_RATE);
+    }
+    return sig;
+  }
+
+  double maxDiff(const vector<float> &a, const vector<float> &b)
+  {
+    double diff = 0.0;
+    for (size_t i=0; i<a.size(); ++i)
+    {
+      diff = max(diff, static_cast<double>(fabs(a[i] - b[i])));
+    }
+    return diff;
+  }
+
+  bool checkFilter(const string &spec)
+  {
+    const int len = SAMPLE_RATE;
+    const vector<float> in = makeSignal(len, 4711);
+
+    Filter ref(spec, true);
+    Filter compiled(spec, false);
+    vector<float> out_ref(len);
+    vector<float> out_compiled(len);
+    for (int n=0; n<len; n+=BLOCK_SIZE)
+    {
+      ref.processSamples(&out_ref[n], &in[n], BLOCK_SIZE);
+      compiled.processSamples(&out_compiled[n], &in[n], BLOCK_SIZE);
+    }
+    const double diff = maxDiff(out_ref, out_compiled);
+
+      // Run five channels, one more than fits into one group of lanes, and
+      // compare them to a single channel filter
+    const int channels = 5;
+    vector<vector<float> > ch_in;
+    vector<vector<float> > ch_out(channels, vector<float>(len));
+    for (int ch=0; ch<channels; ++ch)
+    {
+      ch_in.push_back(makeSignal(len, 4711 + ch));
+    }
+    AudioBiquadCascade multi(channels);
+    multi.parseFilterSpec(spec, SAMPLE_RATE);
+    for (int n=0; n<len; n+=BLOCK_SIZE)
+    {
+      const float *src[channels];
+      float *dest[channels];
+      for (int ch=0; ch<channels; ++ch)
+      {
+        src[ch] = &ch_in[ch][n];
+        dest[ch] = &ch_out[ch][n];
+      }
+      multi.process(dest, src, BLOCK_SIZE);
+    }
+    double ch_diff = 0.0;
+    for (int ch=0; ch<channels; ++ch)
+    {
+      AudioBiquadCascade single;
+      single.parseFilterSpec(spec, SAMPLE_RATE);
+      vector<float> out(len);
+      single.process(out.data(), ch_in[ch].data(), len);
+      ch_diff = max(ch_diff, maxDiff(out, ch_out[ch]));
+    }
+
+    const bool ok = compiled.isBiquadCascade() && (diff <= MAX_DIFF) &&
+                    (ch_diff <= MAX_DIFF);
+    cout << setw(40) << left << spec << right
+         << setw(4) << multi.sections().size() << " sections"
+         << "  fidlib diff=" << setw(9) << diff
+         << "  channel diff=" << setw(9) << ch_diff
+         << (ok ? "  OK" : "  FAILED") << endl;
+    return ok;
+  }
+
+  void benchFilter(const string &spec, double seconds)
+  {
+    const vector<float> in = makeSignal(BLOCK_SIZE, 4711);
+    vector<float> out(BLOCK_SIZE);
+    const int blocks = seconds * SAMPLE_RATE / BLOCK_SIZE;
+    const double samples = static_cast<double>(blocks) * BLOCK_SIZE;
+
+    Filter ref(spec, true);
+    double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      ref.processSamples(out.data(), in.data(), BLOCK_SIZE);
+    }
+    const double t_fidlib = cpuTime() - start;
+
+    AudioBiquadCascade single;
+    single.parseFilterSpec(spec, SAMPLE_RATE);
+    start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      single.process(out.data(), in.data(), BLOCK_SIZE);
+    }
+    const double t_single = cpuTime() - start;
+
+    const int channels = 4;
+    AudioBiquadCascade multi(channels);
+    multi.parseFilterSpec(spec, SAMPLE_RATE);
+    vector<vector<float> > ch_out(channels, vector<float>(BLOCK_SIZE));
+    const float *src[channels];
+    float *dest[channels];
+    for (int ch=0; ch<channels; ++ch)
+    {
+      src[ch] = in.data();
+      dest[ch] = ch_out[ch].data();
+    }
+    start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      multi.process(dest, src, BLOCK_SIZE);
+    }
+    const double t_multi = (cpuTime() - start) / channels;
+
+    cout << setw(40) << left << spec << right << fixed << setprecision(1)
+         << setw(10) << (1e9 * t_fidlib / samples)
+         << setw(10) << (1e9 * t_single / samples)
+         << setw(10) << (1e9 * t_multi / samples)
+         << setw(8) << (t_fidlib / t_multi) << "x" << endl;
+    cout.unsetf(ios::fixed);
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 20.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  cout << "SIMD implementation: " << AudioBiquadCascade::implName() << endl;
+  int failed = 0;
+  for (const char *spec : filter_specs)
+  {
+    failed += checkFilter(spec) ? 0 : 1;
+  }
+
+  cout << endl << setw(40) << left << "filter" << right
+       << setw(10) << "fidlib" << setw(10) << "biquad"
+       << setw(10) << "4 lanes" << "  (ns per sample and channel)" << endl;
+  for (const char *spec : filter_specs)
+  {
+    benchFilter(spec, seconds);
+  }
+
+  return (failed == 0) ? 0 : 1;
+}
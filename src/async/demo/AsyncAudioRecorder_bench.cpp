@@ -0,0 +1,282 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <AsyncCppApplication.h>
+#include <AsyncTimer.h>
+#include <AsyncAudioRecorder.h>
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Audio recorder write path benchmark
+ *
+ * Usage: AsyncAudioRecorder_bench [seconds of audio]
+ *
+ * First the same audio is recorded to a WAV file directly and through the
+ * background writer thread. The two files must be the same. If Opus support
+ * is available, an Ogg/Opus file is recorded through the writer thread too.
+ *
+ * Then slow storage is simulated by recording to a named pipe which is read
+ * by a thread that stall for a while now and then. The audio is written in
+ * real time and the time spent in the writeSamples function is measured,
+ * once for direct writes and once using the writer thread. With the writer
+ * thread no call may take more than a few milliseconds and no blocks may be
+ * dropped. Closing the file must not block either. The writer thread finish
+ * the file in the background and the completion is waited for in the event
+ * loop. The exit status is zero if all checks pass.
+ */
+
+namespace {
+  const int SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
+  const int BLOCK_SIZE = 256;
+  const unsigned WRITE_BUFFER_TIME = 2000;
+  const unsigned STALL_INTERVAL = 1000;
+  const unsigned STALL_TIME = 500;
+  const double MAX_THREADED_WRITE_TIME = 0.005;
+  const int CLOSE_TIMEOUT = 30000;
+
+  double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  vector<float> makeAudio(double seconds)
+  {
+    vector<float> audio(static_cast<size_t>(seconds * SAMPLE_RATE));
+    for (size_t i=0; i<audio.size(); ++i)
+    {
+      audio[i] = 0.5f * sinf(2.0f * M_PI * 440.0f * i / SAMPLE_RATE) +
+                 0.2f * sinf(2.0f * M_PI * 1234.0f * i / SAMPLE_RATE);
+    }
+    return audio;
+  }
+
+  string readFile(const string &path)
+  {
+    ifstream ifs(path, ios::binary);
+    ostringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+  }
+
+  bool record(const string &path, const vector<float> &audio,
+              unsigned buffer_ms)
+  {
+    AudioRecorder rec(path);
+    rec.setWriteBufferTime(buffer_ms);
+    if (!rec.initialize())
+    {
+      cout << path << ": " << rec.errorMsg() << endl;
+      return false;
+    }
+    for (size_t i=0; i+BLOCK_SIZE<=audio.size(); i+=BLOCK_SIZE)
+    {
+      rec.writeSamples(&audio[i], BLOCK_SIZE);
+    }
+    bool closed_ok = false;
+    rec.fileClosed.connect([&](bool success) { closed_ok = success; });
+    rec.closeFile();
+    rec.waitClosed();
+    const bool ok = closed_ok && (rec.droppedBlocks() == 0);
+    if (!ok)
+    {
+      cout << path << ": " << rec.errorMsg() << " dropped="
+           << rec.droppedBlocks() << endl;
+    }
+    return ok;
+  }
+
+  bool checkFileContent(const string &dir, const vector<float> &audio)
+  {
+      // The audio is written faster than real time so the queue must be
+      // able to hold all of it
+    const unsigned buffer_ms = 1000 * audio.size() / SAMPLE_RATE + 1000;
+    const string direct_path = dir + "/direct.wav";
+    const string threaded_path = dir + "/threaded.wav";
+    bool ok = record(direct_path, audio, 0) &&
+              record(threaded_path, audio, buffer_ms);
+    const string direct = readFile(direct_path);
+    const string threaded = readFile(threaded_path);
+    ok = ok && (direct.size() > 44) && (direct == threaded);
+    cout << "WAV direct/threaded: " << direct.size() << "/" << threaded.size()
+         << " bytes" << (ok ? "  OK" : "  FAILED") << endl;
+    unlink(direct_path.c_str());
+    unlink(threaded_path.c_str());
+
+    const string opus_path = dir + "/threaded.opus";
+    AudioRecorder probe(opus_path);
+    if (!probe.initialize())
+    {
+      cout << "Opus: " << probe.errorMsg() << "  SKIPPED" << endl;
+      return ok;
+    }
+    probe.closeFile();
+    const bool opus_ok = record(opus_path, audio, buffer_ms);
+    const string opus = readFile(opus_path);
+    const bool opus_pass = opus_ok && (opus.compare(0, 4, "OggS") == 0) &&
+                           (opus.size() < direct.size() / 4);
+    cout << "Opus threaded: " << opus.size() << " bytes"
+         << (opus_pass ? "  OK" : "  FAILED") << endl;
+    unlink(opus_path.c_str());
+    return ok && opus_pass;
+  }
+
+    // Read the pipe slowly, like storage that stall now and then
+  void slowReader(string path)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      perror("open fifo");
+      return;
+    }
+      // A small pipe buffer so that the stalls are not hidden by it
+    fcntl(fd, F_SETPIPE_SZ, 4096);
+    char buf[4096];
+    double next_stall = now() + STALL_INTERVAL / 1000.0;
+    for (;;)
+    {
+      if (now() >= next_stall)
+      {
+        this_thread::sleep_for(chrono::milliseconds(STALL_TIME));
+        next_stall = now() + STALL_INTERVAL / 1000.0;
+      }
+      ssize_t len = read(fd, buf, sizeof(buf));
+      if (len <= 0)
+      {
+        break;
+      }
+    }
+    close(fd);
+  }
+
+  bool checkStalls(const string &dir, const vector<float> &audio,
+                   unsigned buffer_ms)
+  {
+    const string path = dir + "/stall.raw";
+    unlink(path.c_str());
+    if (mkfifo(path.c_str(), 0600) != 0)
+    {
+      perror("mkfifo");
+      return false;
+    }
+    thread reader(slowReader, path);
+
+    AudioRecorder rec(path);
+    rec.setWriteBufferTime(buffer_ms);
+    bool ok = rec.initialize();
+
+    double max_time = 0.0;
+    double tot_time = 0.0;
+    unsigned blocks = 0;
+    const double block_time = static_cast<double>(BLOCK_SIZE) / SAMPLE_RATE;
+    double next = now();
+    for (size_t i=0; ok && (i+BLOCK_SIZE<=audio.size()); i+=BLOCK_SIZE)
+    {
+      const double start = now();
+      rec.writeSamples(&audio[i], BLOCK_SIZE);
+      const double t = now() - start;
+      max_time = max(max_time, t);
+      tot_time += t;
+      ++blocks;
+      next += block_time;
+      const double wait = next - now();
+      if (wait > 0.0)
+      {
+        this_thread::sleep_for(chrono::duration<double>(wait));
+      }
+    }
+    const unsigned max_depth = rec.maxWriteQueueDepth();
+    const unsigned queue_size = rec.writeQueueSize();
+
+      // With the writer thread the file is finished in the background while
+      // the event loop is running
+    bool closed = false;
+    bool closed_ok = false;
+    rec.fileClosed.connect([&](bool success) {
+        closed = true;
+        closed_ok = success;
+      });
+    const double close_start = now();
+    rec.closeFile();
+    const double close_time = now() - close_start;
+    if (rec.isClosing())
+    {
+      rec.fileClosed.connect([](bool) { Application::app().quit(); });
+      Timer timeout(CLOSE_TIMEOUT);
+      timeout.expired.connect([](Timer*) { Application::app().quit(); });
+      Application::app().exec();
+    }
+    ok = ok && closed && closed_ok;
+    reader.join();
+    unlink(path.c_str());
+
+    if (buffer_ms > 0)
+    {
+      ok = ok && (rec.droppedBlocks() == 0) &&
+           (max_time < MAX_THREADED_WRITE_TIME) &&
+           (close_time < MAX_THREADED_WRITE_TIME);
+    }
+    cout << (buffer_ms > 0 ? "Threaded" : "Direct  ") << fixed
+         << setprecision(1) << ": mean=" << setw(7) << (1e6 * tot_time / blocks)
+         << "us max=" << setw(9) << (1e6 * max_time) << "us close="
+         << setw(9) << (1e6 * close_time) << "us";
+    cout.unsetf(ios::fixed);
+    if (buffer_ms > 0)
+    {
+      cout << " queue=" << max_depth << "/" << queue_size
+           << " dropped=" << rec.droppedBlocks();
+    }
+    cout << (ok ? "  OK" : "  FAILED") << endl;
+    return ok;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  CppApplication app;
+
+  double seconds = 5.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  char dir_template[] = "/tmp/AsyncAudioRecorder_bench.XXXXXX";
+  const char *dir = mkdtemp(dir_template);
+  if (dir == 0)
+  {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  const vector<float> audio = makeAudio(seconds);
+  int failed = 0;
+  failed += checkFileContent(dir, audio) ? 0 : 1;
+  cout << endl << "Recording " << seconds << "s in real time to storage that "
+       << "stall " << STALL_TIME << "ms every " << STALL_INTERVAL << "ms"
+       << endl;
+  failed += checkStalls(dir, audio, 0) ? 0 : 1;
+  failed += checkStalls(dir, audio, WRITE_BUFFER_TIME) ? 0 : 1;
+
+  rmdir(dir);
+  return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,427 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <AsyncAudioDecimator.h>
+#include <AsyncAudioInterpolator.h>
+#include <AsyncAudioPolyphaseResampler.h>
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Polyphase resampler benchmark
+ *
+ * Usage: AsyncAudioResampler_bench [seconds of audio]
+ *
+ * The AudioDecimator and AudioInterpolator classes are run side by side with
+ * a copy of the sample by sample implementation they used before they were
+ * moved onto the AudioPolyphaseResampler engine. The output of the two must
+ * be the same, apart from rounding. The CPU time used per input sample is
+ * then measured for both. At the end the accuracy of the resampler designed
+ * for non integer ratios, like 44100Hz to 16000Hz, is measured by fitting a
+ * sine to the output and computing the SINAD. The attenuation of a tone
+ * above the output Nyquist frequency is measured as well. The exit status is
+ * zero if all checks pass.
+ */
+
+namespace {
+  const int BLOCK_SIZE = 480;
+  const double MAX_DIFF = 1.0e-5;
+
+    // The sample by sample decimator used before the polyphase engine
+  class LegacyDecimator
+  {
+    public:
+      LegacyDecimator(int factor, const vector<float> &h)
+        : factor_M(factor), p_H(h), p_Z(h.size(), 0.0f) {}
+
+      int process(float *dest, const float *src, int count)
+      {
+        const int H_size = p_H.size();
+        int num_out = 0;
+        while (count >= factor_M)
+        {
+          memmove(&p_Z[factor_M], &p_Z[0],
+                  (H_size - factor_M) * sizeof(float));
+          for (int tap = factor_M - 1; tap >= 0; tap--)
+          {
+            p_Z[tap] = *src++;
+          }
+          count -= factor_M;
+          float sum = 0.0;
+          for (int tap = 0; tap < H_size; tap++)
+          {
+            sum += p_H[tap] * p_Z[tap];
+          }
+          dest[num_out++] = sum;
+        }
+        return num_out;
+      }
+
+    private:
+      int           factor_M;
+      vector<float> p_H;
+      vector<float> p_Z;
+  };
+
+    // The sample by sample interpolator used before the polyphase engine
+  class LegacyInterpolator
+  {
+    public:
+      LegacyInterpolator(int factor, const vector<float> &h)
+        : factor_L(factor), p_H(h), p_Z(h.size() / factor, 0.0f) {}
+
+      int process(float *dest, const float *src, int count)
+      {
+        const int num_taps_per_phase = p_Z.size();
+        int num_out = 0;
+        while (count-- > 0)
+        {
+          memmove(&p_Z[1], &p_Z[0], (num_taps_per_phase - 1) * sizeof(float));
+          p_Z[0] = *src++;
+          for (int phase_num = 0; phase_num < factor_L; phase_num++)
+          {
+            const float *p_coeff = &p_H[phase_num];
+            float sum = 0.0;
+            for (int tap = 0; tap < num_taps_per_phase; tap++)
+            {
+              sum += *p_coeff * p_Z[tap];
+              p_coeff += factor_L;
+            }
+            dest[num_out++] = sum * factor_L;
+          }
+        }
+        return num_out;
+      }
+
+    private:
+      int           factor_L;
+      vector<float> p_H;
+      vector<float> p_Z;
+  };
+
+  class Decimator : public AudioDecimator
+  {
+    public:
+      Decimator(int factor, const vector<float> &h)
+        : AudioDecimator(factor, h.data(), h.size()) {}
+      using AudioDecimator::processSamples;
+  };
+
+  class Interpolator : public AudioInterpolator
+  {
+    public:
+      Interpolator(int factor, const vector<float> &h)
+        : AudioInterpolator(factor, h.data(), h.size()) {}
+      using AudioInterpolator::processSamples;
+  };
+
+  struct Conversion
+  {
+    const char  *name;
+    bool        interpolate;
+    int         factor;
+    int         taps;
+  };
+
+  const Conversion conversions[] = {
+    { "decimate 48000->16000", false, 3, 54 },
+    { "decimate 16000->8000",  false, 2, 90 },
+    { "interpolate 16000->48000", true, 3, 48 },
+    { "interpolate 8000->16000",  true, 2, 64 },
+  };
+
+  struct Rates
+  {
+    int input_rate;
+    int output_rate;
+  };
+
+  const Rates rates[] = {
+    { 44100, 16000 },
+    { 16000, 44100 },
+    { 48000, 16000 },
+    { 22050, 16000 },
+    { 32000, 16000 },
+    { 96000, 16000 },
+  };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+    // A Hamming windowed sinc lowpass filter with the cutoff at the Nyquist
+    // frequency of the lower rate
+  vector<float> windowedSinc(int factor, int taps)
+  {
+    vector<float> h(taps);
+    const double fc = 0.5 / factor;
+    const double center = 0.5 * (taps - 1);
+    for (int n=0; n<taps; ++n)
+    {
+      const double x = n - center;
+      const double sinc = (x == 0.0) ? 2.0 * fc
+                                     : sin(2.0 * M_PI * fc * x) / (M_PI * x);
+      h[n] = sinc * (0.54 - 0.46 * cos(2.0 * M_PI * n / (taps - 1)));
+    }
+    return h;
+  }
+
+  vector<float> makeNoise(int len)
+  {
+    mt19937 rng(4711);
+    normal_distribution<float> noise(0.0f, 0.3f);
+    vector<float> sig(len);
+    for (auto& s : sig)
+    {
+      s = noise(rng);
+    }
+    return sig;
+  }
+
+  vector<float> makeTone(double freq, int rate, int len)
+  {
+    vector<float> sig(len);
+    for (int n=0; n<len; ++n)
+    {
+      sig[n] = 0.5 * sin(2.0 * M_PI * freq * n / rate);
+    }
+    return sig;
+  }
+
+  vector<float> resample(AudioPolyphaseResampler &r, const vector<float> &in)
+  {
+    vector<float> out;
+    vector<float> buf(r.outputCount(BLOCK_SIZE) + 1);
+    for (size_t n=0; n+BLOCK_SIZE<=in.size(); n+=BLOCK_SIZE)
+    {
+      const size_t cnt = r.outputCount(BLOCK_SIZE);
+      buf.resize(cnt);
+      if (r.process(buf.data(), &in[n], BLOCK_SIZE) != cnt)
+      {
+        cerr << "*** ERROR: Unexpected output count" << endl;
+        exit(1);
+      }
+      out.insert(out.end(), buf.begin(), buf.end());
+    }
+    return out;
+  }
+
+    // Fit a sine of the given frequency, using least squares, to the signal
+    // and return the power of the sine relative to the power of the residual
+  double sinad(const vector<float> &sig, double freq, int rate, size_t skip)
+  {
+    double cc = 0.0, ss = 0.0, cs = 0.0, xc = 0.0, xs = 0.0;
+    for (size_t n=skip; n<sig.size(); ++n)
+    {
+      const double c = cos(2.0 * M_PI * freq * n / rate);
+      const double s = sin(2.0 * M_PI * freq * n / rate);
+      cc += c * c;
+      ss += s * s;
+      cs += c * s;
+      xc += sig[n] * c;
+      xs += sig[n] * s;
+    }
+    const double det = cc * ss - cs * cs;
+    const double a = (xc * ss - xs * cs) / det;
+    const double b = (xs * cc - xc * cs) / det;
+    double p_sig = 0.0;
+    double p_err = 0.0;
+    for (size_t n=skip; n<sig.size(); ++n)
+    {
+      const double fit = a * cos(2.0 * M_PI * freq * n / rate) +
+                         b * sin(2.0 * M_PI * freq * n / rate);
+      p_sig += fit * fit;
+      p_err += (sig[n] - fit) * (sig[n] - fit);
+    }
+    return 10.0 * log10(p_sig / p_err);
+  }
+
+  double power(const vector<float> &sig, size_t skip)
+  {
+    double p = 0.0;
+    for (size_t n=skip; n<sig.size(); ++n)
+    {
+      p += sig[n] * sig[n];
+    }
+    return p / (sig.size() - skip);
+  }
+
+  bool checkConversion(const Conversion &conv, double seconds)
+  {
+    const vector<float> h = windowedSinc(conv.factor, conv.taps);
+    const vector<float> in = makeNoise(BLOCK_SIZE * 100);
+    const int out_block = conv.interpolate ? BLOCK_SIZE * conv.factor
+                                           : BLOCK_SIZE / conv.factor;
+    vector<float> out_ref(out_block);
+    vector<float> out_new(out_block);
+    double diff = 0.0;
+
+    LegacyDecimator ref_dec(conv.factor, h);
+    LegacyInterpolator ref_int(conv.factor, h);
+    Decimator dec(conv.factor, h);
+    Interpolator interp(conv.factor, h);
+    for (size_t n=0; n<in.size(); n+=BLOCK_SIZE)
+    {
+      if (conv.interpolate)
+      {
+        ref_int.process(out_ref.data(), &in[n], BLOCK_SIZE);
+        interp.processSamples(out_new.data(), &in[n], BLOCK_SIZE);
+      }
+      else
+      {
+        ref_dec.process(out_ref.data(), &in[n], BLOCK_SIZE);
+        dec.processSamples(out_new.data(), &in[n], BLOCK_SIZE);
+      }
+      for (int i=0; i<out_block; ++i)
+      {
+        diff = max(diff, static_cast<double>(fabs(out_ref[i] - out_new[i])));
+      }
+    }
+
+    const int blocks = seconds * 16000 / BLOCK_SIZE;
+    const double samples = static_cast<double>(blocks) * BLOCK_SIZE;
+    double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      if (conv.interpolate)
+      {
+        ref_int.process(out_ref.data(), in.data(), BLOCK_SIZE);
+      }
+      else
+      {
+        ref_dec.process(out_ref.data(), in.data(), BLOCK_SIZE);
+      }
+    }
+    const double t_ref = cpuTime() - start;
+    start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      if (conv.interpolate)
+      {
+        interp.processSamples(out_new.data(), in.data(), BLOCK_SIZE);
+      }
+      else
+      {
+        dec.processSamples(out_new.data(), in.data(), BLOCK_SIZE);
+      }
+    }
+    const double t_new = cpuTime() - start;
+
+    const bool ok = diff <= MAX_DIFF;
+    cout << setw(26) << left << conv.name << right
+         << setw(5) << conv.taps << " taps"
+         << "  diff=" << setw(9) << setprecision(3) << diff
+         << fixed << setprecision(1)
+         << setw(9) << (1e9 * t_ref / samples)
+         << setw(9) << (1e9 * t_new / samples)
+         << setw(7) << (t_ref / t_new) << "x"
+         << (ok ? "  OK" : "  FAILED") << endl;
+    cout.unsetf(ios::fixed);
+    return ok;
+  }
+
+  bool checkRates(const Rates &r, double seconds)
+  {
+    const int in_rate = r.input_rate;
+    const int out_rate = r.output_rate;
+    const int len = in_rate / BLOCK_SIZE * BLOCK_SIZE;
+    const size_t skip = out_rate / 10;
+
+      // Accuracy for a tone in the passband
+    double min_sinad = 1000.0;
+    for (double freq : { 300.0, 1000.0, 3000.0 })
+    {
+      AudioPolyphaseResampler res(in_rate, out_rate);
+      vector<float> out = resample(res, makeTone(freq, in_rate, len));
+      min_sinad = min(min_sinad, sinad(out, freq, out_rate, skip));
+    }
+
+      // Attenuation of a tone that would alias into the passband, if the
+      // input rate is the highest of the two
+    const bool check_alias = (in_rate > out_rate);
+    double alias = 0.0;
+    if (check_alias)
+    {
+      const double freq = min(10000.0, 0.45 * in_rate);
+      AudioPolyphaseResampler res(in_rate, out_rate);
+      const vector<float> in = makeTone(freq, in_rate, len);
+      vector<float> out = resample(res, in);
+      alias = 10.0 * log10(power(out, skip) / power(in, 0));
+    }
+
+      // Throughput
+    AudioPolyphaseResampler res(in_rate, out_rate);
+    const vector<float> in = makeNoise(BLOCK_SIZE);
+    vector<float> out(res.outputCount(BLOCK_SIZE) + 1);
+    const int blocks = seconds * in_rate / BLOCK_SIZE;
+    const double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      res.process(out.data(), in.data(), BLOCK_SIZE);
+    }
+    const double t = cpuTime() - start;
+
+    const bool ok = (min_sinad > 55.0) && (!check_alias || (alias < -50.0));
+    cout << setw(6) << in_rate << "->" << setw(6) << left << out_rate << right
+         << "  L/M=" << setw(4) << res.interpolationFactor() << "/"
+         << setw(4) << left << res.decimationFactor() << right
+         << setw(4) << res.tapsPerPhase() << " taps"
+         << fixed << setprecision(1)
+         << "  SINAD=" << setw(5) << min_sinad << "dB"
+         << "  alias=";
+    if (check_alias)
+    {
+      cout << setw(6) << alias << "dB";
+    }
+    else
+    {
+      cout << setw(8) << "-";
+    }
+    cout << setw(7) << (1e9 * t / (static_cast<double>(blocks) * BLOCK_SIZE))
+         << " ns/sample"
+         << (ok ? "  OK" : "  FAILED") << endl;
+    cout.unsetf(ios::fixed);
+    return ok;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 20.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  cout << "SIMD implementation: " << AudioPolyphaseResampler::implName()
+       << endl;
+  cout << setw(26) << left << "conversion" << right << setw(30) << ""
+       << setw(9) << "legacy" << setw(9) << "engine"
+       << "  (ns per input sample)" << endl;
+  int failed = 0;
+  for (const Conversion &conv : conversions)
+  {
+    failed += checkConversion(conv, seconds) ? 0 : 1;
+  }
+
+  cout << endl;
+  for (const Rates &r : rates)
+  {
+    failed += checkRates(r, seconds) ? 0 : 1;
+  }
+
+  return (failed == 0) ? 0 : 1;
+}
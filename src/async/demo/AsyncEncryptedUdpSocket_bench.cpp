@@ -0,0 +1,231 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include <AsyncCppApplication.h>
+#include <AsyncEncryptedUdpSocket.h>
+#include <AsyncMsg.h>
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Encrypted UDP fan-out micro benchmark
+ *
+ * Usage: AsyncEncryptedUdpSocket_bench [listener count] [frame count]
+ *
+ * The benchmark simulate a reflector that send one audio frame to many
+ * listeners. The "rekey" method pack the message for each listener and set
+ * the key and IV in the socket before each write. The "fanout" method pack
+ * the message once and use a pre-keyed cipher context per listener so that
+ * only the IV have to be set for each write. All datagrams are sent to a
+ * socket on the loopback interface that is never read.
+ *
+ * Before the benchmark is run, a check is made that a bound peer that get a
+ * new key use the new key for the following datagrams. The exit status is
+ * non-zero if the check fail.
+ */
+
+struct AudioMsg : public Msg
+{
+  uint16_t              type = 101;
+  vector<uint8_t>       audio;
+  ASYNC_MSG_MEMBERS(type, audio)
+};
+
+struct Listener
+{
+  vector<uint8_t>                   key;
+  EncryptedUdpSocket::CipherContext *ctx = nullptr;
+  uint32_t                          cntr = 0;
+};
+
+
+static double cpuTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static vector<uint8_t> mkIV(uint32_t cntr)
+{
+  vector<uint8_t> iv(12, 0);
+  for (int i=0; i<4; ++i)
+  {
+    iv[8+i] = (cntr >> (8 * (3-i))) & 0xff;
+  }
+  return iv;
+}
+
+
+  // Receive one datagram from the sink socket and try to decrypt it
+static bool decryptsWith(int sink, const EncryptedUdpSocket& sock,
+                         const vector<uint8_t>& key, uint32_t cntr)
+{
+  uint8_t buf[2048];
+  ssize_t len = recv(sink, buf, sizeof(buf), 0);
+  if (len <= 0)
+  {
+    return false;
+  }
+  EncryptedUdpSocket::CipherContext* ctx =
+    EncryptedUdpSocket::newCipherContext(sock.cipher(), key, false);
+  uint8_t out[sizeof(buf)];
+  const bool ok = (ctx != nullptr) &&
+                  (EncryptedUdpSocket::decryptDatagram(ctx, mkIV(cntr).data(),
+                                                       4, 8, buf, len,
+                                                       out) >= 0);
+  EncryptedUdpSocket::freeCipherContext(ctx);
+  return ok;
+}
+
+
+  // Check that a bound peer use the new key after being bound again
+static bool checkRekey(int sink, EncryptedUdpSocket& sock,
+                       const IpAddress& sink_ip, int sink_port)
+{
+  const EncryptedUdpSocket::PeerId id = 4711;
+  vector<uint8_t> old_key(16), new_key(16);
+  EncryptedUdpSocket::randomBytes(old_key);
+  EncryptedUdpSocket::randomBytes(new_key);
+  const uint8_t aad[4] = {0, 0, 0, 0};
+  const char payload[] = "rekey";
+
+  bool ok = sock.bindPeer(id, old_key) &&
+            sock.write(sink_ip, sink_port, id, mkIV(0), aad, sizeof(aad),
+                       payload, sizeof(payload)) &&
+            decryptsWith(sink, sock, old_key, 0);
+  ok = ok && sock.peerIsBound(id) && sock.bindPeer(id, new_key) &&
+       sock.write(sink_ip, sink_port, id, mkIV(0), aad, sizeof(aad),
+                  payload, sizeof(payload)) &&
+       decryptsWith(sink, sock, new_key, 0);
+  ok = ok && sock.write(sink_ip, sink_port, id, mkIV(0), aad, sizeof(aad),
+                        payload, sizeof(payload)) &&
+       !decryptsWith(sink, sock, old_key, 0);
+  sock.unbindPeer(id);
+  ok = ok && !sock.peerIsBound(id);
+  cout << "Rekey of bound peer: " << (ok ? "OK" : "FAILED") << endl;
+  return ok;
+}
+
+
+int main(int argc, char **argv)
+{
+  int listener_cnt = (argc > 1) ? atoi(argv[1]) : 200;
+  int frame_cnt = (argc > 2) ? atoi(argv[2]) : 2000;
+
+  CppApplication app;
+
+    // A sink socket that is never read. Datagrams are dropped by the
+    // kernel when the receive buffer is full.
+  int sink = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrlen = sizeof(addr);
+  if ((sink < 0) ||
+      (bind(sink, reinterpret_cast<struct sockaddr*>(&addr), addrlen) != 0) ||
+      (getsockname(sink, reinterpret_cast<struct sockaddr*>(&addr),
+                   &addrlen) != 0))
+  {
+    perror("sink socket");
+    exit(1);
+  }
+  IpAddress sink_ip("127.0.0.1");
+  int sink_port = ntohs(addr.sin_port);
+
+  EncryptedUdpSocket sock;
+  if (!sock.initOk() || !sock.setCipher("AES-128-GCM"))
+  {
+    cerr << "*** ERROR: Could not set up encrypted UDP socket" << endl;
+    exit(1);
+  }
+  sock.setCipherAADLength(4);
+  sock.setTagLength(8);
+
+  if (!checkRekey(sink, sock, sink_ip, sink_port))
+  {
+    exit(1);
+  }
+
+  vector<Listener> listeners(listener_cnt);
+  for (auto& l : listeners)
+  {
+    l.key.resize(16);
+    EncryptedUdpSocket::randomBytes(l.key);
+    l.ctx = sock.newCipherContext(l.key);
+  }
+
+  AudioMsg msg;
+  msg.audio.resize(160, 0x55);
+
+  cout << setw(8) << "method" << setw(11) << "listeners"
+       << setw(10) << "frames" << setw(10) << "cpu [s]"
+       << setw(16) << "frames/s/core" << setw(14) << "ns/datagram" << endl;
+
+  for (int method=0; method<2; ++method)
+  {
+    double start = cpuTime();
+    for (int f=0; f<frame_cnt; ++f)
+    {
+      string packed;
+      if (method == 1)
+      {
+        ostringstream ss;
+        msg.pack(ss);
+        packed = ss.str();
+      }
+      for (auto& l : listeners)
+      {
+        uint32_t cntr = l.cntr++;
+        uint8_t aad[4] = {
+          uint8_t(cntr >> 24), uint8_t(cntr >> 16),
+          uint8_t(cntr >> 8), uint8_t(cntr)
+        };
+        if (method == 0)
+        {
+          ostringstream ss;
+          msg.pack(ss);
+          sock.setCipherIV(mkIV(cntr));
+          sock.setCipherKey(l.key);
+          sock.write(sink_ip, sink_port, aad, sizeof(aad),
+                     ss.str().data(), ss.str().size());
+        }
+        else
+        {
+          sock.write(sink_ip, sink_port, l.ctx, mkIV(cntr), aad, sizeof(aad),
+                     packed.data(), packed.size());
+        }
+      }
+    }
+    double cpu_s = cpuTime() - start;
+    cout << setw(8) << (method == 0 ? "rekey" : "fanout")
+         << setw(11) << listener_cnt
+         << setw(10) << frame_cnt
+         << setw(10) << fixed << setprecision(3) << cpu_s
+         << setw(16) << setprecision(0) << (frame_cnt / cpu_s)
+         << setw(14) << setprecision(0)
+         << (1e9 * cpu_s / (double(frame_cnt) * listener_cnt))
+         << endl;
+  }
+
+  for (auto& l : listeners)
+  {
+    EncryptedUdpSocket::freeCipherContext(l.ctx);
+  }
+  close(sink);
+
+  return 0;
+}
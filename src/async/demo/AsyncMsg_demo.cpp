@@ -135,6 +135,24 @@ int main(void)
   std::cout << "two.one.carr=" << two.one.carr << std::endl;
   std::cout << "two.i=" << two.i << std::endl;
 
+    // Pack to and unpack from a byte buffer instead of a stream
+  std::vector<uint8_t> buf(two.packedSize());
+  Async::MsgBufWriter w(buf.data(), buf.size());
+  if (!two.pack(w))
+  {
+    std::cerr << "*** ERROR: Packing to buffer failed\n";
+    return 1;
+  }
+  MsgTwo three;
+  Async::MsgBufReader r(buf.data(), w.size());
+  if (!three.unpack(r) || (r.available() != 0))
+  {
+    std::cerr << "*** ERROR: Unpacking from buffer failed\n";
+    return 1;
+  }
+  std::cout << "three.one.str=" << three.one.str << std::endl;
+  std::cout << "three.i=" << three.i << std::endl;
+
   return 0;
 } /* main */
 
@@ -0,0 +1,162 @@
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include <AsyncCppApplication.h>
+#include <AsyncTimer.h>
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Timer micro benchmark for Async::CppApplication
+ *
+ * Usage: AsyncTimer_bench [client count] [run time in seconds]
+ *
+ * The benchmark simulate a server with many clients where each client have a
+ * heartbeat timer that is reset each time a packet is received and a
+ * periodic timer. Each timer backend is run in a separate child process
+ * since there can only be one application object per process.
+ */
+
+class Bench : public sigc::trackable
+{
+  public:
+    Bench(int timer_cnt, int runtime_s)
+      : m_frame_timer(20, Timer::TYPE_PERIODIC),
+        m_stop_timer(1000 * runtime_s), m_frame_cnt(0), m_reset_cnt(0),
+        m_expire_cnt(0), m_next(0)
+    {
+      srand(4711);
+      for (int i=0; i<timer_cnt; ++i)
+      {
+        Timer *heartbeat = new Timer(1000 + rand() % 1000);
+        heartbeat->expired.connect(mem_fun(*this, &Bench::onExpired));
+        m_heartbeats.push_back(heartbeat);
+
+        Timer *periodic = new Timer(20 + rand() % 980, Timer::TYPE_PERIODIC);
+        periodic->expired.connect(mem_fun(*this, &Bench::onExpired));
+        m_periodics.push_back(periodic);
+      }
+      m_frame_timer.expired.connect(mem_fun(*this, &Bench::onFrame));
+      m_stop_timer.expired.connect(mem_fun(*this, &Bench::onStop));
+    }
+
+    ~Bench(void)
+    {
+      for (size_t i=0; i<m_heartbeats.size(); ++i)
+      {
+        delete m_heartbeats[i];
+        delete m_periodics[i];
+      }
+    }
+
+    void printResult(const string& name, double cpu_s)
+    {
+      cout << setw(6) << name
+           << setw(10) << m_heartbeats.size()
+           << setw(12) << m_reset_cnt
+           << setw(12) << m_expire_cnt
+           << setw(12) << fixed << setprecision(3) << cpu_s
+           << setw(14) << setprecision(1)
+           << (1e9 * cpu_s / (m_reset_cnt + m_expire_cnt))
+           << endl;
+    }
+
+  private:
+    Timer               m_frame_timer;
+    Timer               m_stop_timer;
+    vector<Timer*>      m_heartbeats;
+    vector<Timer*>      m_periodics;
+    unsigned            m_frame_cnt;
+    unsigned long       m_reset_cnt;
+    unsigned long       m_expire_cnt;
+    size_t              m_next;
+
+    void onFrame(Timer *t)
+    {
+        // Simulate that a tenth of all clients sent a packet in this frame
+      ++m_frame_cnt;
+      for (size_t i=0; i<m_heartbeats.size() / 10; ++i)
+      {
+        m_heartbeats[m_next]->reset();
+        m_next = (m_next + 1) % m_heartbeats.size();
+        ++m_reset_cnt;
+      }
+    }
+
+    void onExpired(Timer *t)
+    {
+      ++m_expire_cnt;
+      if (t->type() == Timer::TYPE_ONESHOT)
+      {
+        t->setEnable(false);
+        t->setEnable(true);
+      }
+    }
+
+    void onStop(Timer *t)
+    {
+      Application::app().quit();
+    }
+};
+
+
+static double cpuTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void runBench(CppApplication::TimerBackend backend,
+                     const string& name, int timer_cnt, int runtime_s)
+{
+  CppApplication app;
+  app.setTimerBackend(backend);
+  Bench bench(timer_cnt, runtime_s);
+  double start = cpuTime();
+  app.exec();
+  bench.printResult(name, cpuTime() - start);
+}
+
+
+int main(int argc, char **argv)
+{
+  int timer_cnt = (argc > 1) ? atoi(argv[1]) : 1000;
+  int runtime_s = (argc > 2) ? atoi(argv[2]) : 5;
+
+  cout << setw(6) << "type" << setw(10) << "clients"
+       << setw(12) << "resets" << setw(12) << "expirations"
+       << setw(12) << "cpu [s]" << setw(14) << "ns/operation" << endl;
+
+  const char *names[] = { "map", "wheel" };
+  for (int i=0; i<2; ++i)
+  {
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+      perror("fork");
+      exit(1);
+    }
+    if (pid == 0)
+    {
+      CppApplication::TimerBackend backend;
+      CppApplication::timerBackendFromName(names[i], backend);
+      runBench(backend, names[i], timer_cnt, runtime_s);
+      exit(0);
+    }
+    waitpid(pid, 0, 0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include <AsyncCppApplication.h>
+#include <AsyncUdpSocket.h>
+#include <AsyncTimer.h>
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * UDP socket loopback micro benchmark
+ *
+ * Usage: AsyncUdpSocket_bench [burst size] [run time in seconds] [UDP port]
+ *
+ * The benchmark simulate a server that send one datagram to each of many
+ * clients each time a datagram is received. A burst of datagrams is sent
+ * from one socket to another over the loopback interface. When the whole
+ * burst has been received, the next burst is sent. The given UDP port and the
+ * port above it are used. The "plain" method use one system call per
+ * datagram. The "batched" method enable send batching and receive batching in
+ * Async::UdpSocket. Each method is run in a separate child process since there
+ * can only be one application object per process.
+ */
+
+class Bench : public sigc::trackable
+{
+  public:
+    Bench(uint16_t rx_port, bool batched, int burst, int runtime_s)
+      : m_tx(rx_port + 1, IpAddress("127.0.0.1")),
+        m_rx(rx_port, IpAddress("127.0.0.1")), m_rx_port(rx_port),
+        m_stall_timer(100, Timer::TYPE_PERIODIC),
+        m_stop_timer(1000 * runtime_s), m_burst(burst), m_payload(200, 'x'),
+        m_tx_cnt(0), m_rx_cnt(0), m_burst_rx_cnt(0), m_stall_cnt(0)
+    {
+      if (batched)
+      {
+        m_tx.setSendBatching(true);
+        m_rx.setRecvBatchSize(32);
+      }
+      int bufsize = 4 * 1024 * 1024;
+      setsockopt(m_rx.fd(), SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+      m_rx.dataReceived.connect(mem_fun(*this, &Bench::onDataReceived));
+      m_stall_timer.expired.connect(mem_fun(*this, &Bench::onStall));
+      m_stop_timer.expired.connect(mem_fun(*this, &Bench::onStop));
+      sendBurst();
+    }
+
+    void printResult(const string& name, double cpu_s)
+    {
+      cout << setw(8) << name
+           << setw(8) << m_burst
+           << setw(12) << m_tx_cnt
+           << setw(12) << m_rx_cnt
+           << setw(8) << m_stall_cnt
+           << setw(9) << m_tx.sendQueueDropped()
+           << setw(10) << fixed << setprecision(3) << cpu_s
+           << setw(14) << setprecision(0) << (m_rx_cnt / cpu_s)
+           << endl;
+    }
+
+  private:
+    UdpSocket       m_tx;
+    UdpSocket       m_rx;
+    uint16_t        m_rx_port;
+    Timer           m_stall_timer;
+    Timer           m_stop_timer;
+    int             m_burst;
+    string          m_payload;
+    unsigned long   m_tx_cnt;
+    unsigned long   m_rx_cnt;
+    int             m_burst_rx_cnt;
+    unsigned        m_stall_cnt;
+
+    void sendBurst(void)
+    {
+      m_burst_rx_cnt = 0;
+      for (int i=0; i<m_burst; ++i)
+      {
+        m_tx.write(IpAddress("127.0.0.1"), m_rx_port,
+                   m_payload.data(), m_payload.size());
+        ++m_tx_cnt;
+      }
+    }
+
+    void onDataReceived(const IpAddress& ip, uint16_t port, void *buf,
+                        int count)
+    {
+      ++m_rx_cnt;
+      if (++m_burst_rx_cnt == m_burst)
+      {
+        m_stall_timer.reset();
+        sendBurst();
+      }
+    }
+
+    void onStall(Timer *t)
+    {
+        // Datagrams have been lost. Start a new burst.
+      ++m_stall_cnt;
+      sendBurst();
+    }
+
+    void onStop(Timer *t)
+    {
+      Application::app().quit();
+    }
+};
+
+
+static double cpuTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+int main(int argc, char **argv)
+{
+  int burst = (argc > 1) ? atoi(argv[1]) : 200;
+  int runtime_s = (argc > 2) ? atoi(argv[2]) : 3;
+  uint16_t port = (argc > 3) ? atoi(argv[3]) : 47300;
+
+  cout << setw(8) << "method" << setw(8) << "burst"
+       << setw(12) << "sent" << setw(12) << "received" << setw(8) << "stalls"
+       << setw(9) << "dropped"
+       << setw(10) << "cpu [s]" << setw(14) << "datagrams/s" << endl;
+
+  const char *names[] = { "plain", "batched" };
+  for (int i=0; i<2; ++i)
+  {
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+      perror("fork");
+      exit(1);
+    }
+    if (pid == 0)
+    {
+      CppApplication app;
+      Bench bench(port, i == 1, burst, runtime_s);
+      double start = cpuTime();
+      app.exec();
+      bench.printResult(names[i], cpuTime() - start);
+      exit(0);
+    }
+    waitpid(pid, 0, 0);
+  }
+
+  return 0;
+}
@@ -36,8 +36,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <fstream>
 #include <iterator>
 #include <regex>
+#include <set>
 #include <dirent.h>   // for listing directories (list certs)
 #include <sys/stat.h> // for checking if a directory exists (list certs)
+#ifdef HAS_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
 
 
 /****************************************************************************
@@ -67,6 +71,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Reflector.h"
 #include "ReflectorClient.h"
 #include "TGHandler.h"
+#include "ReflectorUdpWorkers.h"
 
 
 /****************************************************************************
@@ -174,6 +179,60 @@ namespace {
     timer.setExpireOffset(10000);
     timer.start();
   } /* startCertRenewTimer */
+
+
+  bool etagMatches(const std::string& if_none_match, const std::string& etag)
+  {
+    std::vector<std::string> tags;
+    SvxLink::splitStr(tags, if_none_match, ",");
+    for (auto tag : tags)
+    {
+      const size_t begin = tag.find_first_not_of(" \t");
+      if (begin == std::string::npos)
+      {
+        continue;
+      }
+      tag.erase(0, begin);
+      tag.erase(tag.find_last_not_of(" \t") + 1);
+      if (tag.compare(0, 2, "W/") == 0)
+      {
+        tag.erase(0, 2);
+      }
+      if ((tag == "*") || (tag == etag))
+      {
+        return true;
+      }
+    }
+    return false;
+  } /* etagMatches */
+
+
+#ifdef HAS_ZLIB_SUPPORT
+  bool gzipCompress(const std::string& in, std::string& out)
+  {
+    z_stream zs = {};
+      // A window size of 15 + 16 select the gzip format
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+      return false;
+    }
+    out.resize(deflateBound(&zs, in.size()));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = in.size();
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = out.size();
+    const int ret = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    if (ret != Z_STREAM_END)
+    {
+      out.clear();
+      return false;
+    }
+    return true;
+  } /* gzipCompress */
+#endif
 };
 
 
@@ -238,6 +297,8 @@ Reflector::Reflector(void)
       mem_fun(*this, &Reflector::onTalkerUpdated));
   TGHandler::instance()->requestAutoQsy.connect(
       mem_fun(*this, &Reflector::onRequestAutoQsy));
+  TGHandler::instance()->subscribersUpdated.connect(
+      sigc::hide(mem_fun(*this, &Reflector::scheduleUdpWorkersUpdate)));
   m_renew_cert_timer.expired.connect(
       [&](Async::AtTimer*)
       {
@@ -257,6 +318,20 @@ Reflector::Reflector(void)
         }
       });
   m_status["nodes"] = Json::Value(Json::objectValue);
+
+    // The serialized status document is cached. The ETag is made unique
+    // across restarts by including the start time.
+  Json::StreamWriterBuilder builder;
+  builder["commentStyle"] = "None";
+  builder["indentation"] = ""; //The JSON document is written on a single line
+  m_status_writer.reset(builder.newStreamWriter());
+  std::ostringstream etag_prefix;
+  etag_prefix << std::hex << time(NULL);
+  m_status_etag_prefix = etag_prefix.str();
+  m_status_event_timer.expired.connect(
+      sigc::hide(mem_fun(*this, &Reflector::sendStatusEvents)));
+  m_status_keepalive_timer.expired.connect(
+      sigc::hide(mem_fun(*this, &Reflector::sendStatusKeepalive)));
 } /* Reflector::Reflector */
 
 
@@ -264,6 +339,8 @@ Reflector::~Reflector(void)
 {
   delete m_http_server;
   m_http_server = 0;
+  delete m_udp_workers;
+  m_udp_workers = nullptr;
   delete m_udp_sock;
   m_udp_sock = 0;
   delete m_srv;
@@ -299,7 +376,10 @@ bool Reflector::initialize(Async::Config &cfg)
 
   uint16_t udp_listen_port = 5300;
   cfg.getValue("GLOBAL", "LISTEN_PORT", udp_listen_port);
-  m_udp_sock = new Async::EncryptedUdpSocket(udp_listen_port);
+  unsigned udp_workers = 0;
+  cfg.getValue("GLOBAL", "UDP_WORKERS", udp_workers);
+  m_udp_sock = new Async::EncryptedUdpSocket(udp_listen_port, IpAddress(),
+                                             udp_workers > 0);
   const char* err = "unknown reason";
   if ((err="bad allocation",          (m_udp_sock == 0)) ||
       (err="initialization failure",  !m_udp_sock->initOk()) ||
@@ -311,11 +391,40 @@ bool Reflector::initialize(Async::Config &cfg)
   }
   m_udp_sock->setCipherAADLength(UdpCipher::AADLEN);
   m_udp_sock->setTagLength(UdpCipher::TAGLEN);
+
+    // Audio is sent to many clients for each received frame so queue all
+    // outgoing datagrams and send them using as few system calls as possible
+  unsigned udp_batch_size = 16;
+  cfg.getValue("GLOBAL", "UDP_BATCH_SIZE", udp_batch_size);
+  m_udp_sock->setSendBatching(udp_batch_size > 1);
+  m_udp_sock->setRecvBatchSize(udp_batch_size);
   m_udp_sock->cipherDataReceived.connect(
       mem_fun(*this, &Reflector::udpCipherDataReceived));
   m_udp_sock->dataReceived.connect(
       mem_fun(*this, &Reflector::udpDatagramReceived));
 
+    // Optionally receive and forward UDP audio in worker threads. The main
+    // socket must be bound before the worker sockets.
+  if (udp_workers > 0)
+  {
+    m_udp_workers = new ReflectorUdpWorkers;
+    if (!m_udp_workers->start(udp_listen_port, m_udp_sock->cipher(),
+                              udp_workers, m_udp_sock))
+    {
+      std::cerr << "*** ERROR: Could not start the UDP worker threads"
+                << std::endl;
+      return false;
+    }
+    m_udp_workers->datagramReceived.connect(
+        mem_fun(*m_udp_sock, &Async::UdpSocket::injectDatagram));
+    m_udp_workers->decryptedDatagramReceived.connect(
+        mem_fun(*this, &Reflector::udpWorkerDatagramReceived));
+    m_udp_workers->audioForwarded.connect(
+        mem_fun(*this, &Reflector::udpWorkerAudioForwarded));
+    std::cout << "Using " << udp_workers << " UDP worker threads"
+              << std::endl;
+  }
+
   unsigned sql_timeout = 0;
   cfg.getValue("GLOBAL", "SQL_TIMEOUT", sql_timeout);
   TGHandler::instance()->setSqlTimeout(sql_timeout);
@@ -405,54 +514,133 @@ void Reflector::broadcastMsg(const ReflectorMsg& msg,
 } /* Reflector::broadcastMsg */
 
 
+void Reflector::broadcastTgMsg(const ReflectorMsg& msg, uint32_t tg,
+                               const ReflectorClient::Filter& filter)
+{
+  TGHandler* tg_handler = TGHandler::instance();
+
+    // Copy the lists since a failed send will disconnect and delete the
+    // client, which change the talk group membership.
+  TGHandler::ClientList clients(tg_handler->subscribersForTG(tg));
+  for (ReflectorClient* client : tg_handler->monitorsForTG(tg))
+  {
+    if (tg_handler->TGForClient(client) != tg)
+    {
+      clients.push_back(client);
+    }
+  }
+
+  for (ReflectorClient* client : clients)
+  {
+    if (filter(client) &&
+        (client->conState() == ReflectorClient::STATE_CONNECTED))
+    {
+      client->sendMsg(msg);
+    }
+  }
+} /* Reflector::broadcastTgMsg */
+
+
 bool Reflector::sendUdpDatagram(ReflectorClient *client,
     const ReflectorUdpMsg& msg)
 {
-  auto udp_addr = client->remoteUdpHost();
-  auto udp_port = client->remoteUdpPort();
   if (client->protoVer() >= ProtoVer(3, 0))
   {
-    ReflectorUdpMsg header(msg.type());
-    ostringstream ss;
-    assert(header.pack(ss) && msg.pack(ss));
-
-    m_udp_sock->setCipherIV(client->udpCipherIV());
-    m_udp_sock->setCipherKey(client->udpCipherKey());
-    UdpCipher::AAD aad{client->udpCipherIVCntrNext()};
-    std::stringstream aadss;
-    if (!aad.pack(aadss))
+    if (!packUdpMsg(msg))
     {
-      std::cout << "*** WARNING: Packing associated data failed for UDP "
-                   "datagram to " << udp_addr << ":" << udp_port << std::endl;
       return false;
     }
-    return m_udp_sock->write(udp_addr, udp_port,
-                             aadss.str().data(), aadss.str().size(),
-                             ss.str().data(), ss.str().size());
+    return sendUdpDatagram(client, m_udp_tx_buf.data(), m_udp_tx_buf.size());
   }
   else
   {
+    auto udp_addr = client->remoteUdpHost();
+    auto udp_port = client->remoteUdpPort();
     ReflectorUdpMsgV2 header(msg.type(), client->clientId(),
         client->udpCipherIVCntrNext() & 0xffff);
-    ostringstream ss;
-    assert(header.pack(ss) && msg.pack(ss));
+      // Do not use m_udp_tx_buf here since it may hold a packed message
+      // that is being broadcast to protocol V3 clients
+    std::vector<uint8_t> buf(header.packedSize() + msg.packedSize());
+    Async::MsgBufWriter w(buf.data(), buf.size());
+    if (!header.pack(w) || !msg.pack(w))
+    {
+      std::cout << "*** WARNING: Packing V2 UDP message of type "
+                << msg.type() << " failed" << std::endl;
+      return false;
+    }
     return m_udp_sock->UdpSocket::write(
-        udp_addr, udp_port,
-        ss.str().data(), ss.str().size());
+        udp_addr, udp_port, buf.data(), w.size());
+  }
+} /* Reflector::sendUdpDatagram */
+
+
+bool Reflector::sendUdpDatagram(ReflectorClient *client, const void *buf,
+                                size_t count)
+{
+  assert(client->protoVer() >= ProtoVer(3, 0));
+
+    // When the UDP worker threads are used they also send to the client
+    // so the datagram must be sent in the same way as the workers do it
+  if (m_udp_workers != nullptr)
+  {
+    return m_udp_workers->send(client, buf, count);
+  }
+
+  auto udp_addr = client->remoteUdpHost();
+  auto udp_port = client->remoteUdpPort();
+
+  if (!bindUdpCipherPeer(client))
+  {
+    std::cout << "*** WARNING: Could not set up cipher context for UDP "
+                 "datagram to " << udp_addr << ":" << udp_port << std::endl;
+    return false;
+  }
+
+    // The IV must be built from the same counter value as the AAD
+  UdpCipher::AAD aad{client->udpCipherIVCntrNext()};
+  const std::vector<uint8_t> iv =
+    UdpCipher::IV{client->udpCipherIVRand(), 0, aad.iv_cntr};
+  uint8_t aad_buf[UdpCipher::AADLEN];
+  Async::MsgBufWriter aadw(aad_buf, sizeof(aad_buf));
+  if (!aad.pack(aadw))
+  {
+    std::cout << "*** WARNING: Packing associated data failed for UDP "
+                 "datagram to " << udp_addr << ":" << udp_port << std::endl;
+    return false;
   }
+  return m_udp_sock->write(udp_addr, udp_port, client->clientId(), iv,
+                           aad_buf, aadw.size(), buf, count);
 } /* Reflector::sendUdpDatagram */
 
 
 void Reflector::broadcastUdpMsg(const ReflectorUdpMsg& msg,
                                 const ReflectorClient::Filter& filter)
 {
+  bool is_packed = false;
   for (const auto& item : m_client_con_map)
   {
     ReflectorClient *client = item.second;
     if (filter(client) &&
-        (client->conState() == ReflectorClient::STATE_CONNECTED))
+        (client->conState() == ReflectorClient::STATE_CONNECTED) &&
+        !sendBroadcastUdpMsg(client, msg, is_packed))
+    {
+      return;
+    }
+  }
+} /* Reflector::broadcastUdpMsg */
+
+
+void Reflector::broadcastUdpMsg(const ReflectorUdpMsg& msg, uint32_t tg,
+                                const ReflectorClient* except)
+{
+  bool is_packed = false;
+  for (ReflectorClient* client : TGHandler::instance()->subscribersForTG(tg))
+  {
+    if ((client != except) &&
+        (client->conState() == ReflectorClient::STATE_CONNECTED) &&
+        !sendBroadcastUdpMsg(client, msg, is_packed))
     {
-      client->sendUdpMsg(msg);
+      return;
     }
   }
 } /* Reflector::broadcastUdpMsg */
@@ -842,6 +1030,16 @@ Json::Value& Reflector::clientStatus(const std::string& callsign)
 } /* Reflector::clientStatus */
 
 
+void Reflector::statusUpdated(void)
+{
+  m_status_dirty = true;
+  if (!m_status_event_clients.empty() && !m_status_event_timer.isEnabled())
+  {
+    m_status_event_timer.setEnable(true);
+  }
+} /* Reflector::statusUpdated */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -856,6 +1054,67 @@ Json::Value& Reflector::clientStatus(const std::string& callsign)
  *
  ****************************************************************************/
 
+bool Reflector::packUdpMsg(const ReflectorUdpMsg& msg)
+{
+  ReflectorUdpMsg header(msg.type());
+  m_udp_tx_buf.resize(header.packedSize() + msg.packedSize());
+  Async::MsgBufWriter w(m_udp_tx_buf.data(), m_udp_tx_buf.size());
+  if (!header.pack(w) || !msg.pack(w))
+  {
+    std::cout << "*** WARNING: Packing UDP message of type " << msg.type()
+              << " failed" << std::endl;
+    return false;
+  }
+  return true;
+} /* Reflector::packUdpMsg */
+
+
+bool Reflector::sendBroadcastUdpMsg(ReflectorClient* client,
+                                    const ReflectorUdpMsg& msg,
+                                    bool& is_packed)
+{
+    // Protocol V3 clients all get the same packed data so the message is
+    // packed once, when the first such client is found.
+  if (client->protoVer() >= ProtoVer(3, 0))
+  {
+    if (!is_packed)
+    {
+      if (!packUdpMsg(msg))
+      {
+        return false;
+      }
+      is_packed = true;
+    }
+    client->sendPackedUdpMsg(m_udp_tx_buf.data(), m_udp_tx_buf.size());
+  }
+  else
+  {
+    client->sendUdpMsg(msg);
+  }
+  return true;
+} /* Reflector::sendBroadcastUdpMsg */
+
+
+bool Reflector::bindUdpCipherPeer(ReflectorClient* client)
+{
+    // The key schedule is set up once per client. After that only the IV
+    // have to be set for each datagram.
+  return m_udp_sock->peerIsBound(client->clientId()) ||
+         m_udp_sock->bindPeer(client->clientId(), client->udpCipherKey());
+} /* Reflector::bindUdpCipherPeer */
+
+
+void Reflector::udpCipherKeyChanged(ReflectorClient *client)
+{
+    // The bound contexts use the key schedule of the old key. The peer is
+    // bound again, using the new key, on next use. The worker threads
+    // compare the key in the published state with the key of their
+    // contexts so they just need a new state.
+  m_udp_sock->unbindPeer(client->clientId());
+  scheduleUdpWorkersUpdate();
+} /* Reflector::udpCipherKeyChanged */
+
+
 void Reflector::clientConnected(Async::FramedTcpConnection *con)
 {
   std::cout << con->remoteHost() << ":" << con->remotePort()
@@ -891,9 +1150,12 @@ void Reflector::clientDisconnected(Async::FramedTcpConnection *con,
   if (!client->callsign().empty())
   {
     m_status["nodes"].removeMember(client->callsign());
+    statusUpdated();
     broadcastMsg(MsgNodeLeft(client->callsign()),
         ReflectorClient::ExceptFilter(client));
   }
+  m_udp_sock->unbindPeer(client->clientId());
+  scheduleUdpWorkersUpdate();
   //Application::app().runTask([=]{ delete client; });
   delete client;
 } /* Reflector::clientDisconnected */
@@ -909,9 +1171,10 @@ bool Reflector::udpCipherDataReceived(const IpAddress& addr, uint16_t port,
     return true;
   }
 
-  stringstream ss;
-  ss.write(reinterpret_cast<const char *>(buf), UdpCipher::AADLEN);
-  assert(m_aad.unpack(ss));
+  Async::MsgBufReader aadr(buf, UdpCipher::AADLEN);
+  bool aad_unpack_ok = m_aad.unpack(aadr);
+  assert(aad_unpack_ok);
+  (void)aad_unpack_ok;
 
   ReflectorClient* client = nullptr;
   if (m_aad.iv_cntr == 0)
@@ -925,11 +1188,10 @@ bool Reflector::udpCipherDataReceived(const IpAddress& addr, uint16_t port,
                    "Ignoring malformed UDP registration datagram" << std::endl;
       return true;
     }
-    ss.clear();
-    ss.write(reinterpret_cast<const char *>(buf)+UdpCipher::AADLEN,
-        sizeof(UdpCipher::ClientId));
-
-    Async::MsgPacker<UdpCipher::ClientId>::unpack(ss, iaad.client_id);
+    Async::MsgBufReader idr(reinterpret_cast<const uint8_t*>(buf) +
+                              UdpCipher::AADLEN,
+                            sizeof(UdpCipher::ClientId));
+    Async::MsgPacker<UdpCipher::ClientId>::unpack(idr, iaad.client_id);
     //std::cout << "### Reflector::udpCipherDataReceived: client_id="
     //          << iaad.client_id << std::endl;
     auto client = ReflectorClient::lookup(iaad.client_id);
@@ -941,7 +1203,11 @@ bool Reflector::udpCipherDataReceived(const IpAddress& addr, uint16_t port,
     }
     m_udp_sock->setCipherIV(UdpCipher::IV{client->udpCipherIVRand(),
                                           client->clientId(), 0});
-    m_udp_sock->setCipherKey(client->udpCipherKey());
+    if (!bindUdpCipherPeer(client) ||
+        !m_udp_sock->setRxPeer(client->clientId()))
+    {
+      m_udp_sock->setCipherKey(client->udpCipherKey());
+    }
     m_udp_sock->setCipherAADLength(iaad.packedSize());
   }
   else if ((client=ReflectorClient::lookup(std::make_pair(addr, port))))
@@ -963,7 +1229,11 @@ bool Reflector::udpCipherDataReceived(const IpAddress& addr, uint16_t port,
     //          << m_aad.iv_cntr << std::endl;
     m_udp_sock->setCipherIV(UdpCipher::IV{client->udpCipherIVRand(),
                                           client->clientId(), m_aad.iv_cntr});
-    m_udp_sock->setCipherKey(client->udpCipherKey());
+    if (!bindUdpCipherPeer(client) ||
+        !m_udp_sock->setRxPeer(client->clientId()))
+    {
+      m_udp_sock->setCipherKey(client->udpCipherKey());
+    }
     m_udp_sock->setCipherAADLength(UdpCipher::AADLEN);
   }
   else
@@ -979,19 +1249,27 @@ bool Reflector::udpCipherDataReceived(const IpAddress& addr, uint16_t port,
 void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
                                     void* aadptr, void *buf, int count)
 {
-  //std::cout << "### Reflector::udpDatagramReceived:"
+  handleUdpDatagram(addr, port, aadptr, m_udp_sock->cipherAADLength(),
+                    buf, count, true);
+} /* Reflector::udpDatagramReceived */
+
+
+void Reflector::handleUdpDatagram(const IpAddress& addr, uint16_t port,
+                                  void* aadptr, size_t aadlen,
+                                  void *buf, int count, bool check_seq)
+{
+  //std::cout << "### Reflector::handleUdpDatagram:"
   //          << " addr=" << addr
   //          << " port=" << port
   //          << " count=" << count
   //          << std::endl;
 
-  assert(m_udp_sock->cipherAADLength() >= UdpCipher::AADLEN);
+  assert((aadptr == nullptr) || (aadlen >= UdpCipher::AADLEN));
 
-  stringstream ss;
-  ss.write(reinterpret_cast<const char *>(buf), static_cast<size_t>(count));
+  Async::MsgBufReader rd(buf, static_cast<size_t>(count));
 
   ReflectorUdpMsg header;
-  if (!header.unpack(ss))
+  if (!header.unpack(rd))
   {
     cout << "*** WARNING: Unpacking message header failed for UDP datagram "
             "from " << addr << ":" << port << endl;
@@ -1003,34 +1281,31 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
   UdpCipher::AAD aad;
   if (aadptr != nullptr)
   {
-    //std::cout << "### Reflector::udpDatagramReceived: m_aad.iv_cntr="
+    //std::cout << "### Reflector::handleUdpDatagram: m_aad.iv_cntr="
     //          << m_aad.iv_cntr << std::endl;
 
-    stringstream aadss;
-    aadss.write(reinterpret_cast<const char *>(aadptr),
-        m_udp_sock->cipherAADLength());
-
-    if (!aad.unpack(aadss))
+    Async::MsgBufReader aadrd(aadptr, aadlen);
+    if (!aad.unpack(aadrd))
     {
       return;
     }
     if (aad.iv_cntr == 0) // Client UDP registration
     {
       UdpCipher::InitialAAD iaad;
-      assert(aadss.seekg(0));
-      if (!iaad.unpack(aadss))
+      aadrd = Async::MsgBufReader(aadptr, aadlen);
+      if (!iaad.unpack(aadrd))
       {
-        std::cout << "### Reflector::udpDatagramReceived: "
+        std::cout << "### Reflector::handleUdpDatagram: "
                      "Could not unpack iaad" << std::endl;
         return;
       }
       assert(iaad.iv_cntr == 0);
-      //std::cout << "### Reflector::udpDatagramReceived: iaad.client_id="
+      //std::cout << "### Reflector::handleUdpDatagram: iaad.client_id="
       //          << iaad.client_id << std::endl;
       client = ReflectorClient::lookup(iaad.client_id);
       if (client == nullptr)
       {
-        std::cout << "### Reflector::udpDatagramReceived: Could not find "
+        std::cout << "### Reflector::handleUdpDatagram: Could not find "
                      "client id " << iaad.client_id << std::endl;
         return;
       }
@@ -1040,7 +1315,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
       }
       else
       {
-        std::cout << "### Reflector::udpDatagramReceived: Client "
+        std::cout << "### Reflector::handleUdpDatagram: Client "
                   << iaad.client_id << " already registered." << std::endl;
       }
       client->setUdpRxSeq(0);
@@ -1058,8 +1333,8 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
   }
   else
   {
-    ss.seekg(0);
-    if (!header_v2.unpack(ss))
+    rd = Async::MsgBufReader(buf, static_cast<size_t>(count));
+    if (!header_v2.unpack(rd))
     {
       std::cout << "*** WARNING: Unpacking V2 message header failed for UDP "
               "datagram from " << addr << ":" << port << std::endl;
@@ -1099,6 +1374,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
   {
     client->setRemoteUdpSource(std::make_pair(addr, port));
     client->sendUdpMsg(MsgUdpHeartbeat());
+    scheduleUdpWorkersUpdate();
   }
   if (port != client->remoteUdpPort())
   {
@@ -1109,8 +1385,9 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
     return;
   }
 
-    // Check sequence number
-  if (client->protoVer() >= ProtoVer(3, 0))
+    // Check sequence number. Datagrams handed over from a UDP worker
+    // thread have already been checked.
+  if (check_seq && (client->protoVer() >= ProtoVer(3, 0)))
   {
     if (aad.iv_cntr < client->nextUdpRxSeq()) // Frame out of sequence (ignore)
     {
@@ -1129,7 +1406,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
     }
     client->setUdpRxSeq(aad.iv_cntr + 1);
   }
-  else
+  else if (check_seq)
   {
     uint16_t next_udp_rx_seq = client->nextUdpRxSeq() & 0xffff;
     uint16_t udp_rx_seq_diff = header_v2.sequenceNum() - next_udp_rx_seq;
@@ -1152,7 +1429,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
 
   client->udpMsgReceived(header);
 
-  //std::cout << "### Reflector::udpDatagramReceived: type="
+  //std::cout << "### Reflector::handleUdpDatagram: type="
   //          << header.type() << std::endl;
   switch (header.type())
   {
@@ -1164,7 +1441,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
       if (!client->isBlocked())
       {
         MsgUdpAudio msg;
-        if (!msg.unpack(ss))
+        if (!msg.unpack(rd))
         {
           cerr << "*** WARNING[" << client->callsign()
                << "]: Could not unpack incoming MsgUdpAudioV1 message" << endl;
@@ -1182,10 +1459,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
           if (talker == client)
           {
             TGHandler::instance()->setTalkerForTG(tg, client);
-            broadcastUdpMsg(msg,
-                ReflectorClient::mkAndFilter(
-                  ReflectorClient::ExceptFilter(client),
-                  ReflectorClient::TgFilter(tg)));
+            broadcastUdpMsg(msg, tg, client);
             //broadcastUdpMsgExcept(tg, client, msg,
             //    ProtoVerRange(ProtoVer(0, 6),
             //                  ProtoVer(1, ProtoVer::max().minor())));
@@ -1258,7 +1532,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
       if (!client->isBlocked())
       {
         MsgUdpSignalStrengthValues msg;
-        if (!msg.unpack(ss))
+        if (!msg.unpack(rd))
         {
           cerr << "*** WARNING[" << client->callsign()
                << "]: Could not unpack incoming "
@@ -1294,41 +1568,167 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
       //     << header.type() << endl;
       break;
   }
-} /* Reflector::udpDatagramReceived */
+} /* Reflector::handleUdpDatagram */
+
+
+void Reflector::udpWorkerDatagramReceived(const IpAddress& addr,
+                                          uint16_t port, void* aadptr,
+                                          size_t aadlen, void *buf, int count)
+{
+  handleUdpDatagram(addr, port, aadptr, aadlen, buf, count, false);
+} /* Reflector::udpWorkerDatagramReceived */
+
+
+void Reflector::udpWorkerAudioForwarded(ReflectorClient::ClientId client_id,
+                                        uint32_t tg)
+{
+    // Audio from the client has been forwarded by a UDP worker thread so
+    // update the timers that would otherwise have been updated for each
+    // received audio frame
+  ReflectorClient* client = ReflectorClient::lookup(client_id);
+  if (client == nullptr)
+  {
+    return;
+  }
+  client->udpMsgReceived(ReflectorUdpMsg(MsgUdpAudio::TYPE));
+  if (TGHandler::instance()->talkerForTG(tg) == client)
+  {
+    TGHandler::instance()->setTalkerForTG(tg, client);
+  }
+
+    // The audio has been sent to the other clients on the talk group so
+    // they do not need a heartbeat
+  for (ReflectorClient* listener :
+       TGHandler::instance()->subscribersForTG(tg))
+  {
+    if ((listener != client) &&
+        (listener->conState() == ReflectorClient::STATE_CONNECTED))
+    {
+      listener->udpDatagramSent();
+    }
+  }
+} /* Reflector::udpWorkerAudioForwarded */
+
+
+void Reflector::scheduleUdpWorkersUpdate(void)
+{
+  if ((m_udp_workers == nullptr) || m_udp_workers_update_pending)
+  {
+    return;
+  }
+  m_udp_workers_update_pending = true;
+  Application::app().runTask(mem_fun(*this, &Reflector::updateUdpWorkers));
+} /* Reflector::scheduleUdpWorkersUpdate */
+
+
+void Reflector::updateUdpWorkers(void)
+{
+  m_udp_workers_update_pending = false;
+  if (m_udp_workers == nullptr)
+  {
+    return;
+  }
+
+  auto state = new ReflectorUdpWorkers::State;
+  std::set<uint32_t> tgs;
+  std::set<uint32_t> v2_tgs;
+  for (const auto& item : m_client_con_map)
+  {
+    ReflectorClient* client = item.second;
+    if (client->conState() != ReflectorClient::STATE_CONNECTED)
+    {
+      continue;
+    }
+    const uint32_t tg = TGHandler::instance()->TGForClient(client);
+    if (client->protoVer() < ProtoVer(3, 0))
+    {
+      v2_tgs.insert(tg);
+      continue;
+    }
+    if (client->udpCipherKey().empty())
+    {
+      continue;
+    }
+    ReflectorUdpWorkers::Peer peer;
+    peer.id = client->clientId();
+    peer.callsign = client->callsign();
+    peer.registered = (client->remoteUdpPort() != 0);
+    if (peer.registered)
+    {
+      peer.addr.sin_family = AF_INET;
+      peer.addr.sin_addr = client->remoteUdpHost().ip4Addr();
+      peer.addr.sin_port = htons(client->remoteUdpPort());
+    }
+    peer.tg = tg;
+    peer.key = client->udpCipherKey();
+    peer.iv_rand = client->udpCipherIVRand();
+    peer.cntrs = client->udpCounters();
+    state->addPeer(peer);
+    tgs.insert(tg);
+  }
+
+    // Audio is only forwarded by the workers for talk groups with an
+    // unblocked talker where all clients use protocol V3. The main thread
+    // handle the audio for all other talk groups.
+  for (uint32_t tg : tgs)
+  {
+    ReflectorClient* talker = TGHandler::instance()->talkerForTG(tg);
+    if ((tg == 0) || (v2_tgs.count(tg) > 0) || (talker == nullptr) ||
+        talker->isBlocked())
+    {
+      continue;
+    }
+    std::vector<size_t> listeners;
+    bool forward_ok = true;
+    for (ReflectorClient* client :
+         TGHandler::instance()->subscribersForTG(tg))
+    {
+      if ((client->conState() != ReflectorClient::STATE_CONNECTED) ||
+          (client->remoteUdpPort() == 0))
+      {
+        continue;
+      }
+      auto it = state->id_map.find(client->clientId());
+      if (it == state->id_map.end())
+      {
+        forward_ok = false;
+        break;
+      }
+      listeners.push_back(it->second);
+    }
+    if (forward_ok)
+    {
+      state->talkers[tg] = talker->clientId();
+      state->listeners[tg] = std::move(listeners);
+    }
+  }
+
+  m_udp_workers->publish(state);
+} /* Reflector::updateUdpWorkers */
 
 
 void Reflector::onTalkerUpdated(uint32_t tg, ReflectorClient* old_talker,
                                 ReflectorClient *new_talker)
 {
+  scheduleUdpWorkersUpdate();
   if (old_talker != 0)
   {
     cout << old_talker->callsign() << ": Talker stop on TG #" << tg << endl;
     old_talker->updateIsTalker();
-    broadcastMsg(MsgTalkerStop(tg, old_talker->callsign()),
-        ReflectorClient::mkAndFilter(
-          ge_v2_client_filter,
-          ReflectorClient::mkOrFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::TgMonitorFilter(tg))));
+    broadcastTgMsg(MsgTalkerStop(tg, old_talker->callsign()), tg,
+        ge_v2_client_filter);
     if (tg == tgForV1Clients())
     {
       broadcastMsg(MsgTalkerStopV1(old_talker->callsign()), v1_client_filter);
     }
-    broadcastUdpMsg(MsgUdpFlushSamples(),
-          ReflectorClient::mkAndFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::ExceptFilter(old_talker)));
+    broadcastUdpMsg(MsgUdpFlushSamples(), tg, old_talker);
   }
   if (new_talker != 0)
   {
     cout << new_talker->callsign() << ": Talker start on TG #" << tg << endl;
     new_talker->updateIsTalker();
-    broadcastMsg(MsgTalkerStart(tg, new_talker->callsign()),
-        ReflectorClient::mkAndFilter(
-          ge_v2_client_filter,
-          ReflectorClient::mkOrFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::TgMonitorFilter(tg))));
+    broadcastTgMsg(MsgTalkerStart(tg, new_talker->callsign()), tg,
+        ge_v2_client_filter);
     if (tg == tgForV1Clients())
     {
       broadcastMsg(MsgTalkerStartV1(new_talker->callsign()), v1_client_filter);
@@ -1352,28 +1752,172 @@ void Reflector::httpRequestReceived(Async::HttpServerConnection *con,
     return;
   }
 
-  if (req.target != "/status")
+  const std::string path(req.target.substr(0, req.target.find('?')));
+  if (path == "/status")
   {
-    res.setCode(404);
-    res.setContent("application/json",
-        "{\"msg\":\"Not found!\"}");
-    con->write(res);
+    sendStatus(con, req);
+    return;
+  }
+  else if (path == "/status/events")
+  {
+    startStatusEvents(con, req);
     return;
   }
 
-  std::ostringstream os;
-  Json::StreamWriterBuilder builder;
-  builder["commentStyle"] = "None";
-  builder["indentation"] = ""; //The JSON document is written on a single line
-  Json::StreamWriter* writer = builder.newStreamWriter();
-  writer->write(m_status, &os);
-  delete writer;
+  res.setCode(404);
+  res.setContent("application/json",
+      "{\"msg\":\"Not found!\"}");
+  con->write(res);
+} /* Reflector::requestReceived */
+
+
+void Reflector::sendStatus(Async::HttpServerConnection *con,
+                           Async::HttpServerConnection::Request& req)
+{
+  Async::HttpServerConnection::Response res;
+  const std::string& json = statusJson();
+  std::string etag = m_status_etag;
+  bool use_gzip = false;
+  std::string accept_encoding;
+  if (req.getHeader("Accept-Encoding", accept_encoding) &&
+      (accept_encoding.find("gzip") != std::string::npos) &&
+      !statusJsonGzip().empty())
+  {
+      // Each content encoding need its own entity tag
+    use_gzip = true;
+    etag.insert(etag.size()-1, "-gz");
+  }
+  res.setHeader("ETag", etag);
+  res.setHeader("Cache-Control", "no-cache");
+  res.setHeader("Vary", "Accept-Encoding");
+
+  std::string if_none_match;
+  if (req.getHeader("If-None-Match", if_none_match) &&
+      etagMatches(if_none_match, etag))
+  {
+    res.setCode(304);
+    con->write(res);
+    return;
+  }
 
-  res.setContent("application/json", os.str());
+  if (use_gzip)
+  {
+    res.setHeader("Content-Encoding", "gzip");
+    res.setContent("application/json", m_status_json_gz);
+  }
+  else
+  {
+    res.setContent("application/json", json);
+  }
   res.setSendContent(req.method == "GET");
   res.setCode(200);
   con->write(res);
-} /* Reflector::requestReceived */
+} /* Reflector::sendStatus */
+
+
+void Reflector::startStatusEvents(Async::HttpServerConnection *con,
+                                  Async::HttpServerConnection::Request& req)
+{
+    // A server-sent event stream. No content length is given so the
+    // connection is kept open and events are written as they happen.
+  Async::HttpServerConnection::Response res;
+  res.setCode(200);
+  res.setHeader("Content-type", "text/event-stream");
+  res.setHeader("Cache-Control", "no-cache");
+  res.setSendContent(false);
+  con->write(res);
+  if (req.method != "GET")
+  {
+    return;
+  }
+
+  m_status_event_clients.insert(con);
+  m_status_keepalive_timer.setEnable(true);
+  const std::string& json = statusJson();
+  std::ostringstream os;
+  os << "id: " << m_status_version << "\n"
+     << "data: " << json << "\n\n";
+  con->write(os.str().data(), os.str().size());
+} /* Reflector::startStatusEvents */
+
+
+const std::string& Reflector::statusJson(void)
+{
+  if (m_status_dirty)
+  {
+    std::ostringstream os;
+    m_status_writer->write(m_status, &os);
+    m_status_json = os.str();
+    m_status_json_gz.clear();
+    m_status_etag = "\"" + m_status_etag_prefix + "-" +
+                    std::to_string(++m_status_version) + "\"";
+    m_status_dirty = false;
+  }
+  return m_status_json;
+} /* Reflector::statusJson */
+
+
+const std::string& Reflector::statusJsonGzip(void)
+{
+  const std::string& json = statusJson();
+#ifdef HAS_ZLIB_SUPPORT
+  if (m_status_json_gz.empty())
+  {
+    gzipCompress(json, m_status_json_gz);
+  }
+#else
+  (void)json;
+#endif
+  return m_status_json_gz;
+} /* Reflector::statusJsonGzip */
+
+
+void Reflector::sendStatusEvents(void)
+{
+  m_status_event_timer.setEnable(false);
+  if (!m_status_dirty)
+  {
+    return;
+  }
+  const std::string& json = statusJson();
+  std::ostringstream os;
+  os << "id: " << m_status_version << "\n"
+     << "data: " << json << "\n\n";
+  writeStatusEvents(os.str());
+} /* Reflector::sendStatusEvents */
+
+
+void Reflector::sendStatusKeepalive(void)
+{
+    // A comment line keep proxies from closing an idle event stream
+  writeStatusEvents(":\n\n");
+} /* Reflector::sendStatusKeepalive */
+
+
+void Reflector::writeStatusEvents(const std::string& data)
+{
+    // Clients that do not read their event stream are disconnected instead
+    // of letting the write buffer grow without limit
+  std::vector<Async::HttpServerConnection*> stalled;
+  for (auto con : m_status_event_clients)
+  {
+    if (con->writeBufferSize() > STATUS_EVENT_MAX_BACKLOG)
+    {
+      stalled.push_back(con);
+      continue;
+    }
+    con->write(data.data(), data.size());
+  }
+  for (auto con : stalled)
+  {
+    std::cerr << "*** WARNING: Disconnecting stalled HTTP status event "
+                 "client " << con->remoteHost() << ":" << con->remotePort()
+              << std::endl;
+    con->disconnect();
+    con->disconnected(con,
+        Async::HttpServerConnection::DR_ORDERED_DISCONNECT);
+  }
+} /* Reflector::writeStatusEvents */
 
 
 void Reflector::httpClientConnected(Async::HttpServerConnection *con)
@@ -1387,6 +1931,12 @@ void Reflector::httpClientConnected(Async::HttpServerConnection *con)
 void Reflector::httpClientDisconnected(Async::HttpServerConnection *con,
     Async::HttpServerConnection::DisconnectReason reason)
 {
+  m_status_event_clients.erase(con);
+  if (m_status_event_clients.empty())
+  {
+    m_status_keepalive_timer.setEnable(false);
+    m_status_event_timer.setEnable(false);
+  }
   //std::cout << "### HTTP Client disconnected: "
   //          << con->remoteHost() << ":" << con->remotePort()
   //          << ": " << Async::HttpServerConnection::disconnectReasonStr(reason)
@@ -1510,6 +2060,7 @@ void Reflector::ctrlPtyDataReceived(const void *buf, size_t count)
         goto write_status;
       }
       node->setBlock(blocktime);
+      scheduleUdpWorkersUpdate();
     }
     else
     {
@@ -1602,13 +2153,27 @@ void Reflector::ctrlPtyDataReceived(const void *buf, size_t count)
       goto write_status;
     }
   }
+  else if (cmd == "STATS")
+  {
+    const auto& stats = m_udp_sock->cipherStats();
+    std::ostringstream os;
+    os << "UDP encrypt: " << stats.encrypt_cnt << " datagrams, "
+       << stats.encrypt_bytes << " bytes, "
+       << (stats.encrypt_time_ns / 1000) << " us\n"
+       << "UDP decrypt: " << stats.decrypt_cnt << " datagrams, "
+       << stats.decrypt_bytes << " bytes, "
+       << (stats.decrypt_time_ns / 1000) << " us, "
+       << stats.decrypt_fail_cnt << " failed\n";
+    m_cmd_pty->write(os.str());
+  }
   else
   {
-    errss << "Valid commands are: CFG, NODE, CA\n"
+    errss << "Valid commands are: CFG, NODE, CA, STATS\n"
           << "Usage:\n"
           << "CFG <section> <tag> <value>\n"
           << "NODE BLOCK <callsign> <blocktime seconds>\n"
           << "CA LS|LSC|LSP|SIGN <callsign>|RM <callsign>\n"
+          << "STATS\n"
           << "\nEmpty CFG lists all configuration";
   }
 
@@ -38,6 +38,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/time.h>
 #include <vector>
 #include <string>
+#include <set>
+#include <memory>
 #include <json/json.h>
 
 
@@ -80,6 +82,7 @@ namespace Async
 
 class ReflectorMsg;
 class ReflectorUdpMsg;
+class ReflectorUdpWorkers;
 
 
 /****************************************************************************
@@ -185,6 +188,20 @@ class Reflector : public sigc::trackable
     void broadcastMsg(const ReflectorMsg& msg,
         const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
 
+    /**
+     * @brief   Broadcast a TCP message to the clients of a talk group
+     * @param   msg The message to broadcast
+     * @param   tg The talk group
+     * @param   filter The client filter to apply
+     *
+     * The message is sent to all connected clients that have selected or
+     * are monitoring the given talk group. Only the clients of the talk
+     * group are visited so the cost does not depend on the total number of
+     * clients.
+     */
+    void broadcastTgMsg(const ReflectorMsg& msg, uint32_t tg,
+        const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
+
     /**
      * @brief   Send a UDP datagram to the specificed ReflectorClient
      * @param   client The client to the send datagram to
@@ -194,9 +211,44 @@ class Reflector : public sigc::trackable
      */
     bool sendUdpDatagram(ReflectorClient *client, const ReflectorUdpMsg& msg);
 
+    /**
+     * @brief   Send an already packed UDP datagram to a ReflectorClient
+     * @param   client The client to the send datagram to
+     * @param   buf The packed header and message
+     * @param   count The number of bytes in the packed data
+     * @return  Returns \em true on success or else \em false
+     *
+     * The client must use protocol version 3 or later, where the header is
+     * the same for all clients. Only the encryption is done per client.
+     */
+    bool sendUdpDatagram(ReflectorClient *client, const void *buf,
+                         size_t count);
+
+    /**
+     * @brief   Send a UDP message to multiple clients
+     * @param   msg The message to send
+     * @param   filter Filter out clients that should get the message
+     *
+     * The message is only packed once for all clients using protocol
+     * version 3 or later. Each client then only have to encrypt the packed
+     * data using its own pre-keyed cipher context.
+     */
     void broadcastUdpMsg(const ReflectorUdpMsg& msg,
         const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
 
+    /**
+     * @brief   Send a UDP message to all clients on a talk group
+     * @param   msg The message to send
+     * @param   tg The talk group
+     * @param   except A client that should not get the message or nullptr
+     *
+     * This function should be used instead of the filter based variant when
+     * distributing audio. The subscriber index in the TGHandler is used so
+     * only the clients that have selected the talk group are visited.
+     */
+    void broadcastUdpMsg(const ReflectorUdpMsg& msg, uint32_t tg,
+                         const ReflectorClient* except=nullptr);
+
     /**
      * @brief   Get the TG for protocol V1 clients
      * @return  Returns the TG used for protocol V1 clients
@@ -209,6 +261,15 @@ class Reflector : public sigc::trackable
      */
     void requestQsy(ReflectorClient *client, uint32_t tg);
 
+    /**
+     * @brief   Tell the reflector that the UDP cipher key of a client changed
+     * @param   client The client that got a new key
+     *
+     * The pre-keyed cipher contexts bound to the client are thrown away so
+     * that the new key is used for the following datagrams.
+     */
+    void udpCipherKeyChanged(ReflectorClient *client);
+
     Async::EncryptedUdpSocket* udpSocket(void) const { return m_udp_sock; }
 
     uint32_t randomQsyLo(void) const { return m_random_qsy_lo; }
@@ -235,6 +296,16 @@ class Reflector : public sigc::trackable
 
     Json::Value& clientStatus(const std::string& callsign);
 
+    /**
+     * @brief   Tell the reflector that the status document has changed
+     *
+     * This function must be called after the status document has been
+     * modified, e.g. through the object returned by clientStatus. The cached
+     * serialized document is then invalidated and status event stream
+     * clients are notified.
+     */
+    void statusUpdated(void);
+
   protected:
 
   private:
@@ -247,6 +318,9 @@ class Reflector : public sigc::trackable
     static constexpr unsigned ISSUING_CA_VALIDITY_DAYS  = 4*90;
     static constexpr unsigned CERT_VALIDITY_DAYS        = 90;
     static constexpr int      CERT_VALIDITY_OFFSET_DAYS = -1;
+    static constexpr int      STATUS_EVENT_DELAY_MS     = 200;
+    static constexpr int      STATUS_KEEPALIVE_MS       = 15000;
+    static constexpr size_t   STATUS_EVENT_MAX_BACKLOG  = 1024*1024;
 
     FramedTcpServer*            m_srv;
     Async::EncryptedUdpSocket*  m_udp_sock;
@@ -264,6 +338,7 @@ class Reflector : public sigc::trackable
     std::string                 m_csrs_dir;
     std::string                 m_certs_dir;
     UdpCipher::AAD              m_aad;
+    std::vector<uint8_t>        m_udp_tx_buf;
     Async::SslKeypair           m_ca_pkey;
     Async::SslX509              m_ca_cert;
     Async::SslKeypair           m_issue_ca_pkey;
@@ -278,20 +353,59 @@ class Reflector : public sigc::trackable
     std::vector<uint8_t>        m_ca_sig;
     std::string                 m_accept_cert_email;
     Json::Value                 m_status;
+    ReflectorUdpWorkers*        m_udp_workers                 = nullptr;
+    bool                        m_udp_workers_update_pending  = false;
+    std::unique_ptr<Json::StreamWriter> m_status_writer;
+    bool                        m_status_dirty                = true;
+    uint64_t                    m_status_version              = 0;
+    std::string                 m_status_etag_prefix;
+    std::string                 m_status_json;
+    std::string                 m_status_etag;
+    std::string                 m_status_json_gz;
+    std::set<Async::HttpServerConnection*> m_status_event_clients;
+    Async::Timer                m_status_event_timer          {
+                                  STATUS_EVENT_DELAY_MS,
+                                  Async::Timer::TYPE_ONESHOT, false};
+    Async::Timer                m_status_keepalive_timer      {
+                                  STATUS_KEEPALIVE_MS,
+                                  Async::Timer::TYPE_PERIODIC, false};
 
     Reflector(const Reflector&);
     Reflector& operator=(const Reflector&);
     void clientConnected(Async::FramedTcpConnection *con);
     void clientDisconnected(Async::FramedTcpConnection *con,
                             Async::FramedTcpConnection::DisconnectReason reason);
+    bool packUdpMsg(const ReflectorUdpMsg& msg);
+    bool sendBroadcastUdpMsg(ReflectorClient* client,
+                             const ReflectorUdpMsg& msg, bool& is_packed);
+    bool bindUdpCipherPeer(ReflectorClient* client);
     bool udpCipherDataReceived(const Async::IpAddress& addr, uint16_t port,
                                void *buf, int count);
     void udpDatagramReceived(const Async::IpAddress& addr, uint16_t port,
                              void* aad, void *buf, int count);
+    void handleUdpDatagram(const Async::IpAddress& addr, uint16_t port,
+                           void* aadptr, size_t aadlen, void *buf, int count,
+                           bool check_seq);
+    void udpWorkerDatagramReceived(const Async::IpAddress& addr,
+                                   uint16_t port, void* aadptr, size_t aadlen,
+                                   void *buf, int count);
+    void udpWorkerAudioForwarded(ReflectorClient::ClientId client_id,
+                                 uint32_t tg);
+    void scheduleUdpWorkersUpdate(void);
+    void updateUdpWorkers(void);
     void onTalkerUpdated(uint32_t tg, ReflectorClient* old_talker,
                          ReflectorClient *new_talker);
     void httpRequestReceived(Async::HttpServerConnection *con,
                              Async::HttpServerConnection::Request& req);
+    void sendStatus(Async::HttpServerConnection *con,
+                    Async::HttpServerConnection::Request& req);
+    void startStatusEvents(Async::HttpServerConnection *con,
+                           Async::HttpServerConnection::Request& req);
+    const std::string& statusJson(void);
+    const std::string& statusJsonGzip(void);
+    void sendStatusEvents(void);
+    void sendStatusKeepalive(void);
+    void writeStatusEvents(const std::string& data);
     void httpClientConnected(Async::HttpServerConnection *con);
     void httpClientDisconnected(Async::HttpServerConnection *con,
         Async::HttpServerConnection::DisconnectReason reason);
@@ -187,14 +187,14 @@ ReflectorClient::ReflectorClient(Reflector *ref, Async::FramedTcpConnection *con
   : m_con(con), m_con_state(STATE_EXPECT_PROTO_VER),
     m_disc_timer(10000, Timer::TYPE_ONESHOT, false),
     m_client_id(newClientId(this)), m_remote_udp_port(0), m_cfg(cfg),
-    /*m_next_udp_tx_seq(0),*/ m_next_udp_rx_seq(0),
+    /*m_next_udp_tx_seq(0),*/
     m_heartbeat_timer(1000, Timer::TYPE_PERIODIC),
     m_heartbeat_tx_cnt(HEARTBEAT_TX_CNT_RESET),
     m_heartbeat_rx_cnt(HEARTBEAT_RX_CNT_RESET),
     m_udp_heartbeat_tx_cnt(UDP_HEARTBEAT_TX_CNT_RESET),
     m_udp_heartbeat_rx_cnt(UDP_HEARTBEAT_RX_CNT_RESET),
     m_reflector(ref), m_blocktime(0), m_remaining_blocktime(0),
-    m_current_tg(0), m_udp_cipher_iv_cntr(0)
+    m_current_tg(0), m_udp_cntrs(std::make_shared<UdpCounters>())
 {
   m_con->setMaxRxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
   m_con->setMaxTxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
@@ -277,13 +277,15 @@ int ReflectorClient::sendMsg(const ReflectorMsg& msg)
     errno = ENOTCONN;
   }
 
-  ostringstream ss;
+  std::vector<uint8_t> buf;
   if (errno == 0)
   {
     m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
 
     ReflectorMsg header(msg.type());
-    if (!header.pack(ss) || !msg.pack(ss))
+    buf.resize(header.packedSize() + msg.packedSize());
+    Async::MsgBufWriter w(buf.data(), buf.size());
+    if (!header.pack(w) || !msg.pack(w))
     {
       cerr << "*** ERROR: Failed to pack TCP message\n";
       errno = EBADMSG;
@@ -292,7 +294,7 @@ int ReflectorClient::sendMsg(const ReflectorMsg& msg)
 
   if (errno == 0)
   {
-    auto ret = m_con->write(ss.str().data(), ss.str().size());
+    auto ret = m_con->write(buf.data(), buf.size());
     if (ret >= 0)
     {
       return ret;
@@ -331,6 +333,19 @@ void ReflectorClient::sendUdpMsg(const ReflectorUdpMsg &msg)
 } /* ReflectorClient::sendUdpMsg */
 
 
+void ReflectorClient::sendPackedUdpMsg(const void *buf, size_t count)
+{
+  if (remoteUdpPort() == 0)
+  {
+    return;
+  }
+
+  m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
+
+  (void)m_reflector->sendUdpDatagram(this, buf, count);
+} /* ReflectorClient::sendPackedUdpMsg */
+
+
 void ReflectorClient::setBlock(unsigned blocktime)
 {
   if (blocktime > 0)
@@ -352,20 +367,29 @@ void ReflectorClient::updateIsTalker(void)
   if (m_status != nullptr)
   {
     auto talker = TGHandler::instance()->talkerForTG(m_current_tg);
-    (*m_status)["isTalker"] = (
+    setStatusParam(*m_status, "isTalker",
         TGHandler::instance()->showActivity(m_current_tg) &&
-        (talker == this)
-        );
+        (talker == this));
   }
 } /* ReflectorClient:;updateIsTalker */
 
 
 std::vector<uint8_t> ReflectorClient::udpCipherIV(void) const
 {
-  return UdpCipher::IV{udpCipherIVRand(), 0, m_udp_cipher_iv_cntr};
+  return UdpCipher::IV{udpCipherIVRand(), 0, m_udp_cntrs->tx_iv_cntr};
 } /* ReflectorClient::udpCipherIV */
 
 
+void ReflectorClient::setUdpCipherKey(const std::vector<uint8_t>& key)
+{
+  if (key != m_udp_cipher_key)
+  {
+    m_udp_cipher_key = key;
+    m_reflector->udpCipherKeyChanged(this);
+  }
+} /* ReflectorClient::setUdpCipherKey */
+
+
 void ReflectorClient::certificateUpdated(Async::SslX509& cert)
 {
   if (m_con_state == STATE_CONNECTED)
@@ -485,11 +509,7 @@ void ReflectorClient::onFrameReceived(FramedTcpConnection *con,
     return;
   }
 
-  int len = data.size();
-  assert(len >= 0);
-  auto buf = reinterpret_cast<const char*>(data.data());
-  stringstream ss;
-  ss.write(buf, len);
+  Async::MsgBufReader rd(data.data(), data.size());
 
   std::stringstream idss;
   if (m_callsign.empty())
@@ -502,7 +522,7 @@ void ReflectorClient::onFrameReceived(FramedTcpConnection *con,
   }
 
   ReflectorMsg header;
-  if (!header.unpack(ss))
+  if (!header.unpack(rd))
   {
     std::cout << "*** ERROR[" << idss.str()
               << "]: Unpacking failed for TCP message header"
@@ -531,48 +551,48 @@ void ReflectorClient::onFrameReceived(FramedTcpConnection *con,
     case MsgHeartbeat::TYPE:
       break;
     case MsgProtoVer::TYPE:
-      handleMsgProtoVer(ss);
+      handleMsgProtoVer(rd);
       break;
     case MsgCABundleRequest::TYPE:
-      handleMsgCABundleRequest(ss);
+      handleMsgCABundleRequest(rd);
       break;
     case MsgStartEncryptionRequest::TYPE:
-      handleMsgStartEncryptionRequest(ss);
+      handleMsgStartEncryptionRequest(rd);
       break;
     case MsgAuthResponse::TYPE:
-      handleMsgAuthResponse(ss);
+      handleMsgAuthResponse(rd);
       break;
     case MsgClientCsr::TYPE:
-      handleMsgClientCsr(ss);
+      handleMsgClientCsr(rd);
       break;
     case MsgSelectTG::TYPE:
-      handleSelectTG(ss);
+      handleSelectTG(rd);
       break;
     case MsgTgMonitor::TYPE:
-      handleTgMonitor(ss);
+      handleTgMonitor(rd);
       break;
     case MsgNodeInfo::TYPE:
-      handleNodeInfo(ss);
+      handleNodeInfo(rd);
       break;
     case MsgSignalStrengthValues::TYPE:
-      handleMsgSignalStrengthValues(ss);
+      handleMsgSignalStrengthValues(rd);
       break;
     case MsgTxStatus::TYPE:
-      handleMsgTxStatus(ss);
+      handleMsgTxStatus(rd);
       break;
 #if 0
     case MsgNodeInfo::TYPE:
-      handleNodeInfo(ss);
+      handleNodeInfo(rd);
       break;
 #endif
     case MsgRequestQsy::TYPE:
-      handleRequestQsy(ss);
+      handleRequestQsy(rd);
       break;
     case MsgStateEvent::TYPE:
-      handleStateEvent(ss);
+      handleStateEvent(rd);
       break;
     case MsgError::TYPE:
-      handleMsgError(ss);
+      handleMsgError(rd);
       break;
     default:
       // Better just ignoring unknown protocol messages for making it easier to
@@ -585,7 +605,7 @@ void ReflectorClient::onFrameReceived(FramedTcpConnection *con,
 } /* ReflectorClient::onFrameReceived */
 
 
-void ReflectorClient::handleMsgProtoVer(std::istream& is)
+void ReflectorClient::handleMsgProtoVer(Async::MsgBufReader& rd)
 {
   if (m_con_state != STATE_EXPECT_PROTO_VER)
   {
@@ -594,7 +614,7 @@ void ReflectorClient::handleMsgProtoVer(std::istream& is)
   }
 
   MsgProtoVer msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     std::cout << "*** ERROR[" << m_con->remoteHost() << ":"
               << m_con->remotePort() << "]: Could not unpack MsgProtoVer"
@@ -659,7 +679,7 @@ void ReflectorClient::handleMsgProtoVer(std::istream& is)
 } /* ReflectorClient::handleMsgProtoVer */
 
 
-void ReflectorClient::handleMsgCABundleRequest(std::istream& is)
+void ReflectorClient::handleMsgCABundleRequest(Async::MsgBufReader& rd)
 {
   //std::cout << "### ReflectorClient::handleMsgCABundleRequest" << std::endl;
 
@@ -679,7 +699,7 @@ void ReflectorClient::handleMsgCABundleRequest(std::istream& is)
 } /* ReflectorClient::handleMsgCABundleRequest */
 
 
-void ReflectorClient::handleMsgStartEncryptionRequest(std::istream& is)
+void ReflectorClient::handleMsgStartEncryptionRequest(Async::MsgBufReader& rd)
 {
   //std::cout << "### ReflectorClient::handleMsgStartEncryptionRequest"
   //          << std::endl;
@@ -694,7 +714,7 @@ void ReflectorClient::handleMsgStartEncryptionRequest(std::istream& is)
   }
 
   MsgStartEncryptionRequest msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     std::cerr << "*** ERROR[" << m_con->remoteHost() << ":"
               << m_con->remotePort()
@@ -713,7 +733,7 @@ void ReflectorClient::handleMsgStartEncryptionRequest(std::istream& is)
 } /* ReflectorClient::handleMsgStartEncryptionRequest */
 
 
-void ReflectorClient::handleMsgAuthResponse(std::istream& is)
+void ReflectorClient::handleMsgAuthResponse(Async::MsgBufReader& rd)
 {
   if (m_con_state != STATE_EXPECT_AUTH_RESPONSE)
   {
@@ -725,7 +745,7 @@ void ReflectorClient::handleMsgAuthResponse(std::istream& is)
   }
 
   MsgAuthResponse msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     std::cerr << "*** ERROR[" << m_con->remoteHost() << ":"
               << m_con->remotePort()
@@ -780,7 +800,7 @@ void ReflectorClient::handleMsgAuthResponse(std::istream& is)
 } /* ReflectorClient::handleMsgAuthResponse */
 
 
-void ReflectorClient::handleMsgClientCsr(std::istream& is)
+void ReflectorClient::handleMsgClientCsr(Async::MsgBufReader& rd)
 {
   std::ostringstream idss;
   if (m_con_state == STATE_CONNECTED)
@@ -801,7 +821,7 @@ void ReflectorClient::handleMsgClientCsr(std::istream& is)
   }
 
   MsgClientCsr msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     std::cout << "*** ERROR[" << idss.str()
               << "]: Could not unpack MsgClientCsr" << std::endl;
@@ -850,10 +870,10 @@ void ReflectorClient::handleMsgClientCsr(std::istream& is)
 } /* ReflectorClient::handleMsgClientCsr */
 
 
-void ReflectorClient::handleSelectTG(std::istream& is)
+void ReflectorClient::handleSelectTG(Async::MsgBufReader& rd)
 {
   MsgSelectTG msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
          << " ERROR: Could not unpack MsgSelectTG" << endl;
@@ -865,10 +885,7 @@ void ReflectorClient::handleSelectTG(std::istream& is)
     auto talker = TGHandler::instance()->talkerForTG(m_current_tg);
     if (talker == this)
     {
-      m_reflector->broadcastUdpMsg(MsgUdpFlushSamples(),
-          mkAndFilter(
-            TgFilter(m_current_tg),
-            ExceptFilter(this)));
+      m_reflector->broadcastUdpMsg(MsgUdpFlushSamples(), m_current_tg, this);
     }
     else if (talker != 0)
     {
@@ -880,10 +897,10 @@ void ReflectorClient::handleSelectTG(std::istream& is)
 } /* ReflectorClient::handleSelectTG */
 
 
-void ReflectorClient::handleTgMonitor(std::istream& is)
+void ReflectorClient::handleTgMonitor(Async::MsgBufReader& rd)
 {
   MsgTgMonitor msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
          << " ERROR: Could not unpack MsgTgMonitor" << endl;
@@ -912,13 +929,13 @@ void ReflectorClient::handleTgMonitor(std::istream& is)
 } /* ReflectorClient::handleTgMonitor */
 
 
-void ReflectorClient::handleNodeInfo(std::istream& is)
+void ReflectorClient::handleNodeInfo(Async::MsgBufReader& rd)
 {
   std::string jsonstr;
   if (m_client_proto_ver >= ProtoVer(3, 0))
   {
     MsgNodeInfo msg;
-    if (!msg.unpack(is))
+    if (!msg.unpack(rd))
     {
       cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
            << " ERROR: Could not unpack MsgNodeInfo" << endl;
@@ -937,7 +954,7 @@ void ReflectorClient::handleNodeInfo(std::istream& is)
   else
   {
     MsgNodeInfoV2 msg;
-    if (!msg.unpack(is))
+    if (!msg.unpack(rd))
     {
       std::cout << "Client " << m_con->remoteHost() << ":"
                 << m_con->remotePort()
@@ -957,6 +974,7 @@ void ReflectorClient::handleNodeInfo(std::istream& is)
 
     status["protoVer"]["majorVer"] = protoVer().majorVer();
     status["protoVer"]["minorVer"] = protoVer().minorVer();
+    statusUpdated();
     setMonitoredTGs(m_monitored_tgs);
     setTg(m_current_tg);
     if (status.isMember("qth") && status["qth"].isArray())
@@ -1017,10 +1035,10 @@ void ReflectorClient::handleNodeInfo(std::istream& is)
 } /* ReflectorClient::handleNodeInfo */
 
 
-void ReflectorClient::handleMsgSignalStrengthValues(std::istream& is)
+void ReflectorClient::handleMsgSignalStrengthValues(Async::MsgBufReader& rd)
 {
   MsgSignalStrengthValues msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     cerr << "*** WARNING[" << callsign()
          << "]: Could not unpack incoming "
@@ -1046,10 +1064,10 @@ void ReflectorClient::handleMsgSignalStrengthValues(std::istream& is)
 } /* ReflectorClient::handleMsgSignalStrengthValues */
 
 
-void ReflectorClient::handleMsgTxStatus(std::istream& is)
+void ReflectorClient::handleMsgTxStatus(Async::MsgBufReader& rd)
 {
   MsgTxStatus msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     cerr << "*** WARNING[" << callsign()
          << "]: Could not unpack incoming MsgTxStatus message" << endl;
@@ -1068,10 +1086,10 @@ void ReflectorClient::handleMsgTxStatus(std::istream& is)
 } /* ReflectorClient::handleMsgTxStatus */
 
 
-void ReflectorClient::handleRequestQsy(std::istream& is)
+void ReflectorClient::handleRequestQsy(Async::MsgBufReader& rd)
 {
   MsgRequestQsy msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
          << " ERROR: Could not unpack MsgRequestQsy" << endl;
@@ -1082,10 +1100,10 @@ void ReflectorClient::handleRequestQsy(std::istream& is)
 } /* ReflectorClient::handleRequestQsy */
 
 
-void ReflectorClient::handleStateEvent(std::istream& is)
+void ReflectorClient::handleStateEvent(Async::MsgBufReader& rd)
 {
   MsgStateEvent msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
          << " ERROR: Could not unpack MsgStateEvent" << endl;
@@ -1101,10 +1119,10 @@ void ReflectorClient::handleStateEvent(std::istream& is)
 
 
 #if 0
-void ReflectorClient::handleNodeInfo(std::istream& is)
+void ReflectorClient::handleNodeInfo(Async::MsgBufReader& rd)
 {
   MsgNodeInfo msg;
-  if (!msg.unpack(is))
+  if (!msg.unpack(rd))
   {
     cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
          << " ERROR: Could not unpack MsgNodeInfo" << endl;
@@ -1182,11 +1200,11 @@ void ReflectorClient::handleNodeInfo(std::istream& is)
 #endif
 
 
-void ReflectorClient::handleMsgError(std::istream& is)
+void ReflectorClient::handleMsgError(Async::MsgBufReader& rd)
 {
   MsgError msg;
   string message;
-  if (msg.unpack(is))
+  if (msg.unpack(rd))
   {
     message = msg.message();
   }
@@ -1404,6 +1422,7 @@ void ReflectorClient::renewClientCertificate(void)
 
 void ReflectorClient::setMonitoredTGs(const std::set<uint32_t>& tgs)
 {
+  TGHandler::instance()->setMonitoredTGs(this, tgs);
   m_monitored_tgs = tgs;
 
   if (m_status != nullptr)
@@ -1419,6 +1438,7 @@ void ReflectorClient::setMonitoredTGs(const std::set<uint32_t>& tgs)
     {
       monitored_tgs.append(tg);
     }
+    statusUpdated();
   }
 } /* ReflectorClient::setMonitoredTGs */
 
@@ -1448,14 +1468,21 @@ void ReflectorClient::setTg(uint32_t tg)
     {
       tg = 0;
     }
-    (*m_status)["tg"] = tg;
-    (*m_status)["restrictedTG"] = TGHandler::instance()->isRestricted(tg);
+    setStatusParam(*m_status, "tg", tg);
+    setStatusParam(*m_status, "restrictedTG",
+                   TGHandler::instance()->isRestricted(tg));
   }
 
   updateIsTalker();
 } /* ReflectorClient::setTg */
 
 
+void ReflectorClient::statusUpdated(void)
+{
+  m_reflector->statusUpdated();
+} /* ReflectorClient::statusUpdated */
+
+
 
 /*
  * This file has not been truncated
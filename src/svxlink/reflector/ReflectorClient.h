@@ -38,6 +38,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <json/json.h>
 #include <sigc++/sigc++.h>
 #include <random>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 
 /****************************************************************************
@@ -118,6 +121,25 @@ class ReflectorClient : public sigc::trackable
     using ClientId = ReflectorUdpMsg::ClientId;
     using ClientSrc = std::pair<Async::IpAddress, uint16_t>;
 
+    /**
+     * @brief   UDP sequence counters for a client
+     *
+     * The counters are atomic so that they can be shared with the UDP worker
+     * threads (see ReflectorUdpWorkers), which send and receive datagrams
+     * for the client without involving the main thread. When the workers
+     * are used, tx_mutex must be held from the time that the transmit
+     * counter is incremented until the datagram has been sent. Otherwise a
+     * datagram with a higher counter may reach the client first, which make
+     * the client drop the other one as out of sequence.
+     */
+    struct UdpCounters
+    {
+      std::atomic<UdpCipher::IVCntr> tx_iv_cntr  {0};
+      std::atomic<UdpCipher::IVCntr> next_rx_seq {0};
+      std::mutex                     tx_mutex;
+    };
+    using UdpCountersPtr = std::shared_ptr<UdpCounters>;
+
     typedef enum
     {
       STATE_EXPECT_DISCONNECT,
@@ -377,7 +399,10 @@ class ReflectorClient : public sigc::trackable
     /**
      * @brief   Set the UDP RX sequence number
      */
-    void setUdpRxSeq(UdpCipher::IVCntr seq) { m_next_udp_rx_seq = seq; }
+    void setUdpRxSeq(UdpCipher::IVCntr seq)
+    {
+      m_udp_cntrs->next_rx_seq = seq;
+    }
 
     /**
      * @brief   Get the next expected UDP packet sequence number
@@ -386,7 +411,28 @@ class ReflectorClient : public sigc::trackable
      * This function will return the next expected UDP sequence number, which
      * is simply the previously received sequence number plus one.
      */
-    UdpCipher::IVCntr nextUdpRxSeq(void) { return m_next_udp_rx_seq; }
+    UdpCipher::IVCntr nextUdpRxSeq(void) { return m_udp_cntrs->next_rx_seq; }
+
+    /**
+     * @brief   Get the UDP sequence counters
+     * @return  Returns a pointer to the counters
+     *
+     * The counters may be shared with other threads and may outlive this
+     * object.
+     */
+    const UdpCountersPtr& udpCounters(void) const { return m_udp_cntrs; }
+
+    /**
+     * @brief   Tell the client that a UDP datagram was sent to it
+     *
+     * This function should be called when a datagram has been sent to the
+     * client by other means than the sendUdpMsg functions, e.g. by a UDP
+     * worker thread, so that no heartbeat is sent while there is traffic.
+     */
+    void udpDatagramSent(void)
+    {
+      m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
+    }
 
     /**
      * @brief   Send a TCP message to the remote end
@@ -478,7 +524,7 @@ class ReflectorClient : public sigc::trackable
 
     void updateIsTalker(void);
 
-    uint32_t udpCipherIVCntrNext() { return m_udp_cipher_iv_cntr++; }
+    uint32_t udpCipherIVCntrNext() { return m_udp_cntrs->tx_iv_cntr++; }
     std::vector<uint8_t> udpCipherIV(void) const;
 
     void setUdpCipherIVRand(const std::vector<uint8_t>& iv_rand)
@@ -490,12 +536,19 @@ class ReflectorClient : public sigc::trackable
       return m_udp_cipher_iv_rand;
     }
 
-    void setUdpCipherKey(const std::vector<uint8_t>& key)
-    {
-      m_udp_cipher_key = key;
-    }
+    void setUdpCipherKey(const std::vector<uint8_t>& key);
     std::vector<uint8_t> udpCipherKey(void) const { return m_udp_cipher_key; }
 
+    /**
+     * @brief   Send an already packed UDP message to the client
+     * @param   buf   The packed header and message
+     * @param   count The size of the packed data
+     *
+     * This function is used when the same message is sent to many clients
+     * so that it only have to be packed once.
+     */
+    void sendPackedUdpMsg(const void *buf, size_t count);
+
     void certificateUpdated(Async::SslX509& cert);
 
   private:
@@ -532,7 +585,6 @@ class ReflectorClient : public sigc::trackable
     ClientSrc                   m_client_src;
     uint16_t                    m_remote_udp_port;
     Async::Config*              m_cfg;
-    UdpCipher::IVCntr           m_next_udp_rx_seq;
     Async::Timer                m_heartbeat_timer;
     unsigned                    m_heartbeat_tx_cnt;
     unsigned                    m_heartbeat_rx_cnt;
@@ -549,7 +601,7 @@ class ReflectorClient : public sigc::trackable
     JsonTxMap                   m_json_tx_map;
     std::vector<uint8_t>        m_udp_cipher_iv_rand;
     std::vector<uint8_t>        m_udp_cipher_key;
-    UdpCipher::IVCntr           m_udp_cipher_iv_cntr;
+    UdpCountersPtr              m_udp_cntrs;
     Async::AtTimer              m_renew_cert_timer;
     Json::Value*                m_status                {nullptr};
 
@@ -560,19 +612,19 @@ class ReflectorClient : public sigc::trackable
     void onSslConnectionReady(Async::TcpConnection *con);
     void onFrameReceived(Async::FramedTcpConnection *con,
                          std::vector<uint8_t>& data);
-    void handleMsgProtoVer(std::istream& is);
-    void handleMsgCABundleRequest(std::istream& is);
-    void handleMsgStartEncryptionRequest(std::istream& is);
-    void handleMsgAuthResponse(std::istream& is);
-    void handleMsgClientCsr(std::istream& is);
-    void handleSelectTG(std::istream& is);
-    void handleTgMonitor(std::istream& is);
-    void handleNodeInfo(std::istream& is);
-    void handleMsgSignalStrengthValues(std::istream& is);
-    void handleMsgTxStatus(std::istream& is);
-    void handleRequestQsy(std::istream& is);
-    void handleStateEvent(std::istream& is);
-    void handleMsgError(std::istream& is);
+    void handleMsgProtoVer(Async::MsgBufReader& rd);
+    void handleMsgCABundleRequest(Async::MsgBufReader& rd);
+    void handleMsgStartEncryptionRequest(Async::MsgBufReader& rd);
+    void handleMsgAuthResponse(Async::MsgBufReader& rd);
+    void handleMsgClientCsr(Async::MsgBufReader& rd);
+    void handleSelectTG(Async::MsgBufReader& rd);
+    void handleTgMonitor(Async::MsgBufReader& rd);
+    void handleNodeInfo(Async::MsgBufReader& rd);
+    void handleMsgSignalStrengthValues(Async::MsgBufReader& rd);
+    void handleMsgTxStatus(Async::MsgBufReader& rd);
+    void handleRequestQsy(Async::MsgBufReader& rd);
+    void handleStateEvent(Async::MsgBufReader& rd);
+    void handleMsgError(Async::MsgBufReader& rd);
     void sendError(const std::string& msg);
     void onDiscTimeout(Async::Timer *t);
     void disconnect(void);
@@ -584,6 +636,7 @@ class ReflectorClient : public sigc::trackable
     void renewClientCertificate(void);
     void setMonitoredTGs(const std::set<uint32_t>& tgs);
     void setTg(uint32_t tg);
+    void statusUpdated(void);
 
     template <typename T>
     void setRxParam(char id, const std::string& name, const T& value)
@@ -591,7 +644,7 @@ class ReflectorClient : public sigc::trackable
       auto it = m_json_rx_map.find(id);
       if (it != m_json_rx_map.end())
       {
-        (it->second)[name] = value;
+        setStatusParam(it->second, name, value);
       }
     }
 
@@ -601,7 +654,19 @@ class ReflectorClient : public sigc::trackable
       auto it = m_json_tx_map.find(id);
       if (it != m_json_tx_map.end())
       {
-        (it->second)[name] = value;
+        setStatusParam(it->second, name, value);
+      }
+    }
+
+    template <typename T>
+    void setStatusParam(Json::Value& obj, const std::string& name,
+                        const T& value)
+    {
+      const Json::Value new_value(value);
+      if (!obj.isMember(name) || (obj[name] != new_value))
+      {
+        obj[name] = new_value;
+        statusUpdated();
       }
     }
 
@@ -1525,6 +1525,38 @@ namespace UdpCipher
     ASYNC_MSG_MEMBERS(client_id)
   };
 
+  /**
+   * @brief A stream buffer that append all written data to a container
+   *
+   * Use this stream buffer to pack messages directly into a byte container,
+   * e.g. a std::vector<uint8_t>. Clearing the container, but not shrinking
+   * it, make it possible to reuse the allocated memory for the next message.
+   */
+  template <typename Container>
+  struct push_ostreambuf : public std::streambuf
+  {
+      push_ostreambuf(Container& ctr) : m_ctr(ctr) {}
+
+    protected:
+      std::streamsize xsputn(const char_type* s, std::streamsize n) override
+      {
+        m_ctr.insert(m_ctr.end(), s, s+n);
+        return n;
+      }
+
+      int_type overflow(int_type ch) override
+      {
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+          m_ctr.push_back(ch);
+        }
+        return traits_type::not_eof(ch);
+      }
+
+    private:
+      Container& m_ctr;
+  };
+
   class IV : public Async::Msg
   {
     public:
@@ -1540,42 +1572,16 @@ namespace UdpCipher
 
       operator std::vector<uint8_t>(void) const
       {
-        std::vector<uint8_t> iv;
-        iv.reserve(IVLEN);
-        push_ostreambuf<decltype(iv)> posbuf(iv);
-        std::ostream pos(&posbuf);
-        pack(pos);
+        std::vector<uint8_t> iv(IVLEN);
+        Async::MsgBufWriter w(iv.data(), iv.size());
+        pack(w);
+        iv.resize(w.size());
         return iv;
       }
 
       ASYNC_MSG_MEMBERS(m_rand, m_client_id, m_cntr)
 
     private:
-      template <typename Container>
-      struct push_ostreambuf : public std::streambuf
-      {
-          push_ostreambuf(Container& ctr) : m_ctr(ctr) {}
-
-        protected:
-          std::streamsize xsputn(const char_type* s, std::streamsize n) override
-          {
-            for (std::streamsize i=0; i<n; ++i)
-            {
-              m_ctr.push_back(s[i]);
-            }
-            return n;
-          }
-
-          int_type overflow(int_type ch) override
-          {
-            m_ctr.push_back(ch);
-            return 1;
-          }
-
-        private:
-          Container& m_ctr;
-      };
-
       uint8_t   m_rand[IVRANDLEN] = {0};
       ClientId  m_client_id       = 0;
       IVCntr    m_cntr            = 0;
@@ -0,0 +1,147 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+#include <AsyncMsg.h>
+
+#include "ReflectorMsg.h"
+
+using namespace std;
+
+
+/*
+ * Reflector message packing micro benchmark
+ *
+ * Usage: ReflectorMsg_bench [iterations]
+ *
+ * The benchmark pack and unpack a MsgUdpAudio message, as sent for each audio
+ * frame, and a MsgNodeList message with many nodes, as sent when a client log
+ * in to a large reflector. The "stream" method use the std::iostream based
+ * pack/unpack functions. The "buffer" method pack into and unpack from a
+ * reused byte buffer using Async::MsgBufWriter and Async::MsgBufReader.
+ */
+
+static double cpuTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+template <typename H, typename M>
+static void runBench(const string& name, const M& msg, int iterations)
+{
+  const H header(msg.type());
+  size_t size = 0;
+
+  double start = cpuTime();
+  for (int i=0; i<iterations; ++i)
+  {
+    ostringstream ss;
+    if (!header.pack(ss) || !msg.pack(ss))
+    {
+      cerr << "*** ERROR: Stream packing failed" << endl;
+      exit(1);
+    }
+    size = ss.str().size();
+  }
+  double stream_pack = cpuTime() - start;
+
+  ostringstream packed_ss;
+  header.pack(packed_ss);
+  msg.pack(packed_ss);
+  const string packed = packed_ss.str();
+
+  start = cpuTime();
+  for (int i=0; i<iterations; ++i)
+  {
+    stringstream ss;
+    ss.write(packed.data(), packed.size());
+    H h;
+    M m;
+    if (!h.unpack(ss) || !m.unpack(ss))
+    {
+      cerr << "*** ERROR: Stream unpacking failed" << endl;
+      exit(1);
+    }
+  }
+  double stream_unpack = cpuTime() - start;
+
+  vector<uint8_t> buf;
+  start = cpuTime();
+  for (int i=0; i<iterations; ++i)
+  {
+    buf.resize(header.packedSize() + msg.packedSize());
+    Async::MsgBufWriter w(buf.data(), buf.size());
+    if (!header.pack(w) || !msg.pack(w))
+    {
+      cerr << "*** ERROR: Buffer packing failed" << endl;
+      exit(1);
+    }
+  }
+  double buffer_pack = cpuTime() - start;
+
+  if ((buf.size() != size) ||
+      (memcmp(buf.data(), packed.data(), packed.size()) != 0))
+  {
+    cerr << "*** ERROR: Stream and buffer packing differ" << endl;
+    exit(1);
+  }
+
+  start = cpuTime();
+  for (int i=0; i<iterations; ++i)
+  {
+    Async::MsgBufReader r(buf.data(), buf.size());
+    H h;
+    M m;
+    if (!h.unpack(r) || !m.unpack(r))
+    {
+      cerr << "*** ERROR: Buffer unpacking failed" << endl;
+      exit(1);
+    }
+  }
+  double buffer_unpack = cpuTime() - start;
+
+  const double ns = 1e9 / iterations;
+  cout << setw(12) << name << setw(8) << size
+       << setw(8) << "stream"
+       << setw(14) << fixed << setprecision(1) << (ns * stream_pack)
+       << setw(14) << (ns * stream_unpack) << endl;
+  cout << setw(12) << name << setw(8) << size
+       << setw(8) << "buffer"
+       << setw(14) << fixed << setprecision(1) << (ns * buffer_pack)
+       << setw(14) << (ns * buffer_unpack) << endl;
+}
+
+
+int main(int argc, char **argv)
+{
+  int iterations = (argc > 1) ? atoi(argv[1]) : 200000;
+
+  cout << setw(12) << "message" << setw(8) << "bytes" << setw(8) << "method"
+       << setw(14) << "pack [ns]" << setw(14) << "unpack [ns]" << endl;
+
+    // One 20ms Opus frame
+  vector<uint8_t> frame(80, 0x55);
+  runBench<ReflectorUdpMsg>("UdpAudio",
+                            MsgUdpAudio(frame.data(), frame.size()),
+                            iterations);
+
+  vector<string> nodes;
+  for (int i=0; i<500; ++i)
+  {
+    ostringstream ss;
+    ss << "SM" << i << "XYZ";
+    nodes.push_back(ss.str());
+  }
+  runBench<ReflectorMsg>("NodeList", MsgNodeList(nodes), iterations / 100);
+
+  return 0;
+}
@@ -0,0 +1,863 @@
+/**
+@file   ReflectorUdpWorkers.cpp
+@brief  Threads that receive and forward reflector UDP audio
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <linux/filter.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncApplication.h>
+#include <AsyncFdWatch.h>
+#include <AsyncMsg.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorUdpWorkers.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+namespace {
+  const size_t MAX_DATAGRAM_SIZE  = 65536;
+  const int    RECV_BATCH_SIZE    = 64;
+
+  int64_t nowMs(void)
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  } /* nowMs */
+
+
+  bool packIV(const std::vector<uint8_t>& iv_rand,
+              UdpCipher::ClientId client_id, UdpCipher::IVCntr cntr,
+              uint8_t (&iv)[UdpCipher::IVLEN])
+  {
+    Async::MsgBufWriter w(iv, sizeof(iv));
+    return UdpCipher::IV{iv_rand, client_id, cntr}.pack(w) &&
+           (w.size() == sizeof(iv));
+  } /* packIV */
+};
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+size_t ReflectorUdpWorkers::State::addPeer(const Peer& peer)
+{
+  const size_t idx = peers.size();
+  peers.push_back(peer);
+  id_map[peer.id] = idx;
+  if (peer.registered)
+  {
+    src_map[srcKey(peer.addr)] = idx;
+  }
+  return idx;
+} /* ReflectorUdpWorkers::State::addPeer */
+
+
+uint64_t ReflectorUdpWorkers::State::srcKey(const struct sockaddr_in& addr)
+{
+  return (static_cast<uint64_t>(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+} /* ReflectorUdpWorkers::State::srcKey */
+
+
+ReflectorUdpWorkers::ReflectorUdpWorkers(void)
+{
+
+} /* ReflectorUdpWorkers::ReflectorUdpWorkers */
+
+
+ReflectorUdpWorkers::~ReflectorUdpWorkers(void)
+{
+  stop();
+} /* ReflectorUdpWorkers::~ReflectorUdpWorkers */
+
+
+bool ReflectorUdpWorkers::start(uint16_t port,
+                                const EncryptedUdpSocket::Cipher* cipher,
+                                unsigned worker_cnt, UdpSocket* main_sock)
+{
+  assert(m_workers.empty());
+  if ((cipher == nullptr) || (worker_cnt == 0) || (main_sock == nullptr))
+  {
+    return false;
+  }
+  m_cipher = cipher;
+  m_main_sock = main_sock;
+
+  if ((pipe(m_stop_pipe) == -1) || (pipe(m_event_pipe) == -1))
+  {
+    perror("pipe");
+    stop();
+    return false;
+  }
+  fcntl(m_event_pipe[0], F_SETFL, O_NONBLOCK);
+  m_event_watch = new FdWatch(m_event_pipe[0], FdWatch::FD_WATCH_RD);
+  m_event_watch->activity.connect(
+      mem_fun(*this, &ReflectorUdpWorkers::onEventPipeActivity));
+
+  for (unsigned i=0; i<worker_cnt; ++i)
+  {
+    Worker* w = new Worker;
+    m_workers.push_back(w);
+    w->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (w->sock == -1)
+    {
+      perror("socket");
+      stop();
+      return false;
+    }
+    int on = 1;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if ((fcntl(w->sock, F_SETFL, O_NONBLOCK) == -1) ||
+        (setsockopt(w->sock, SOL_SOCKET, SO_REUSEPORT, &on,
+                    sizeof(on)) == -1) ||
+        (::bind(w->sock, reinterpret_cast<struct sockaddr*>(&addr),
+                sizeof(addr)) == -1))
+    {
+      perror("UDP worker socket");
+      stop();
+      return false;
+    }
+    w->rx_buf.resize(MAX_DATAGRAM_SIZE);
+    w->plain_buf.resize(MAX_DATAGRAM_SIZE + EVP_MAX_BLOCK_LENGTH);
+    w->tx_buf.resize(EncryptedUdpSocket::encryptedSize(
+          UdpCipher::AADLEN, UdpCipher::TAGLEN, MAX_DATAGRAM_SIZE));
+  }
+
+  if (!attachSteeringProgram())
+  {
+    std::cerr << "*** WARNING: Could not attach the UDP steering program. "
+                 "The main thread will handle part of the UDP traffic."
+              << std::endl;
+  }
+
+  for (Worker* w : m_workers)
+  {
+    w->thread = std::thread(&ReflectorUdpWorkers::workerThread, this, w);
+  }
+
+  return true;
+} /* ReflectorUdpWorkers::start */
+
+
+void ReflectorUdpWorkers::stop(void)
+{
+    // Closing the write end of the stop pipe wake up all workers
+  if (m_stop_pipe[1] != -1)
+  {
+    close(m_stop_pipe[1]);
+    m_stop_pipe[1] = -1;
+  }
+  for (Worker* w : m_workers)
+  {
+    if (w->thread.joinable())
+    {
+      w->thread.join();
+    }
+    freeCipherContexts(w->ctxs);
+    if (w->sock != -1)
+    {
+      close(w->sock);
+    }
+    delete w;
+  }
+  m_workers.clear();
+  m_pending.clear();
+  m_pending_data.clear();
+  m_main_sock = nullptr;
+  freeCipherContexts(m_main_ctxs);
+  m_main_tx_buf.clear();
+
+  delete m_event_watch;
+  m_event_watch = nullptr;
+  for (int* fds : { m_stop_pipe, m_event_pipe })
+  {
+    for (int i=0; i<2; ++i)
+    {
+      if (fds[i] != -1)
+      {
+        close(fds[i]);
+        fds[i] = -1;
+      }
+    }
+  }
+  m_events.clear();
+  m_event_signaled = false;
+
+  delete m_state.exchange(nullptr);
+  for (auto& item : m_retired)
+  {
+    delete item.second;
+  }
+  m_retired.clear();
+} /* ReflectorUdpWorkers::stop */
+
+
+void ReflectorUdpWorkers::publish(State* state)
+{
+  assert(state != nullptr);
+  state->gen = m_gen + 1;
+  State* old_state = m_state.exchange(state);
+  const uint64_t gen = ++m_gen;
+  pruneCipherContexts(m_main_ctxs, state);
+  if (old_state != nullptr)
+  {
+    m_retired.emplace_back(gen, old_state);
+  }
+  reclaimStates();
+} /* ReflectorUdpWorkers::publish */
+
+
+bool ReflectorUdpWorkers::send(const ReflectorClient* client,
+                               const void* buf, size_t count)
+{
+  if (m_workers.empty() || (client->remoteUdpPort() == 0))
+  {
+    return false;
+  }
+  return queueDatagram(client->clientId(), client->udpCipherKey(),
+                       client->udpCipherIVRand(), client->udpCounters(),
+                       client->remoteUdpHost(), client->remoteUdpPort(),
+                       buf, count);
+} /* ReflectorUdpWorkers::send */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ReflectorUdpWorkers::workerThread(Worker* w)
+{
+  struct pollfd pfds[2];
+  pfds[0].fd = w->sock;
+  pfds[0].events = POLLIN;
+  pfds[1].fd = m_stop_pipe[0];
+  pfds[1].events = POLLIN;
+  for (;;)
+  {
+    w->active_gen = GEN_IDLE;
+    if (poll(pfds, 2, -1) == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      perror("poll");
+      break;
+    }
+    if (pfds[1].revents != 0)
+    {
+      break;
+    }
+
+      // Announce which state generation that is used before loading the
+      // state pointer. The main thread will not free the state until all
+      // workers have announced a later generation or are idle.
+    w->active_gen = m_gen.load();
+    const State* state = m_state.load();
+    if ((state != nullptr) && (state->gen != w->state_gen))
+    {
+      pruneCipherContexts(w->ctxs, state);
+      auto act_it = w->last_activity.begin();
+      while (act_it != w->last_activity.end())
+      {
+        if (state->id_map.find(act_it->first) == state->id_map.end())
+        {
+          act_it = w->last_activity.erase(act_it);
+        }
+        else
+        {
+          ++act_it;
+        }
+      }
+      w->state_gen = state->gen;
+    }
+
+      // Read a limited number of datagrams before the state is reloaded
+    for (int i=0; i<RECV_BATCH_SIZE; ++i)
+    {
+      struct sockaddr_in addr;
+      socklen_t addrlen = sizeof(addr);
+      ssize_t len = recvfrom(w->sock, w->rx_buf.data(), w->rx_buf.size(), 0,
+                             reinterpret_cast<struct sockaddr*>(&addr),
+                             &addrlen);
+      if (len < 0)
+      {
+        break;
+      }
+      handleDatagram(w, state, addr, w->rx_buf.data(), len);
+    }
+  }
+} /* ReflectorUdpWorkers::workerThread */
+
+
+void ReflectorUdpWorkers::handleDatagram(Worker* w, const State* state,
+                                         const struct sockaddr_in& addr,
+                                         uint8_t* buf, int count)
+{
+  Event raw_event;
+  raw_event.type = Event::RAW;
+  raw_event.addr = addr;
+
+    // Datagrams from unknown sources, client registrations and datagrams
+    // from protocol V2 clients are handled by the main thread
+  UdpCipher::AAD aad;
+  Async::MsgBufReader aadrd(buf, UdpCipher::AADLEN);
+  if ((state == nullptr) ||
+      (static_cast<size_t>(count) < UdpCipher::AADLEN + UdpCipher::TAGLEN) ||
+      !aad.unpack(aadrd) || (aad.iv_cntr == 0))
+  {
+    raw_event.data.assign(buf, buf + count);
+    postEvent(std::move(raw_event));
+    return;
+  }
+  auto src_it = state->src_map.find(State::srcKey(addr));
+  if (src_it == state->src_map.end())
+  {
+    raw_event.data.assign(buf, buf + count);
+    postEvent(std::move(raw_event));
+    return;
+  }
+  const Peer& peer = state->peers[src_it->second];
+
+  CipherContexts* ctxs = cipherContexts(w->ctxs, peer.id, peer.key);
+  uint8_t iv[UdpCipher::IVLEN];
+  if ((ctxs == nullptr) || !packIV(peer.iv_rand, peer.id, aad.iv_cntr, iv))
+  {
+    return;
+  }
+  uint8_t* plain = w->plain_buf.data();
+  int plain_len = EncryptedUdpSocket::decryptDatagram(
+      ctxs->dec, iv, UdpCipher::AADLEN, UdpCipher::TAGLEN, buf, count, plain);
+  if (plain_len < 0)
+  {
+    return;
+  }
+
+    // Check sequence number
+  const UdpCipher::IVCntr next_rx_seq = peer.cntrs->next_rx_seq;
+  if (aad.iv_cntr < next_rx_seq) // Frame out of sequence (ignore)
+  {
+    std::ostringstream ss;
+    ss << peer.callsign << ": Dropping out of sequence UDP frame with seq="
+       << aad.iv_cntr << "\n";
+    std::cout << ss.str() << std::flush;
+    return;
+  }
+  else if (aad.iv_cntr > next_rx_seq) // Frame lost
+  {
+    std::ostringstream ss;
+    ss << peer.callsign << ": UDP frame(s) lost. Expected seq="
+       << next_rx_seq << " but received " << aad.iv_cntr
+       << ". Resetting next expected sequence number to "
+       << (aad.iv_cntr + 1) << "\n";
+    std::cout << ss.str() << std::flush;
+  }
+  peer.cntrs->next_rx_seq = aad.iv_cntr + 1;
+
+    // Forward audio from the talker of the talk group
+  Async::MsgBufReader rd(plain, plain_len);
+  ReflectorUdpMsg header;
+  if (header.unpack(rd) && (header.type() == MsgUdpAudio::TYPE) &&
+      (peer.tg > 0))
+  {
+    auto talker_it = state->talkers.find(peer.tg);
+    MsgUdpAudio msg;
+    if ((talker_it != state->talkers.end()) &&
+        (talker_it->second == peer.id) &&
+        msg.unpack(rd) && !msg.audioData().empty() &&
+        forwardAudio(w, state, peer, plain, rd.pos() - plain))
+    {
+      const int64_t now = nowMs();
+      int64_t& last_activity = w->last_activity[peer.id];
+      if (now - last_activity >= ACTIVITY_INTERVAL_MS)
+      {
+        last_activity = now;
+        Event event;
+        event.type = Event::ACTIVITY;
+        event.addr = addr;
+        event.client_id = peer.id;
+        event.tg = peer.tg;
+        postEvent(std::move(event));
+      }
+      return;
+    }
+  }
+
+  Event event;
+  event.type = Event::DECRYPTED;
+  event.addr = addr;
+  event.aadlen = UdpCipher::AADLEN;
+  event.data.reserve(UdpCipher::AADLEN + plain_len);
+  event.data.assign(buf, buf + UdpCipher::AADLEN);
+  event.data.insert(event.data.end(), plain, plain + plain_len);
+  postEvent(std::move(event));
+} /* ReflectorUdpWorkers::handleDatagram */
+
+
+bool ReflectorUdpWorkers::forwardAudio(Worker* w, const State* state,
+                                       const Peer& talker,
+                                       const uint8_t* buf, size_t count)
+{
+  auto listeners_it = state->listeners.find(talker.tg);
+  if (listeners_it == state->listeners.end())
+  {
+    return false;
+  }
+
+  for (size_t idx : listeners_it->second)
+  {
+    const Peer& peer = state->peers[idx];
+    if (peer.id == talker.id)
+    {
+      continue;
+    }
+    CipherContexts* ctxs = cipherContexts(w->ctxs, peer.id, peer.key);
+    if (ctxs != nullptr)
+    {
+      encryptAndSend(w->sock, ctxs, peer.iv_rand, *peer.cntrs, peer.addr,
+                     buf, count, w->tx_buf);
+    }
+  }
+
+  return true;
+} /* ReflectorUdpWorkers::forwardAudio */
+
+
+bool ReflectorUdpWorkers::queueDatagram(
+    ClientId id, const std::vector<uint8_t>& key,
+    const std::vector<uint8_t>& iv_rand,
+    const ReflectorClient::UdpCountersPtr& cntrs,
+    const Async::IpAddress& ip, uint16_t port,
+    const void* buf, size_t count)
+{
+  if ((m_pending_data.size() + count > m_main_sock->sendQueueLimit()) &&
+      !m_pending.empty())
+  {
+    flushPending();
+  }
+  const uint8_t* data = static_cast<const uint8_t*>(buf);
+  m_pending.push_back(PendingDatagram{id, key, iv_rand, cntrs, ip, port,
+                                      m_pending_data.size(), count});
+  m_pending_data.insert(m_pending_data.end(), data, data + count);
+  if (!m_flush_pending)
+  {
+    m_flush_pending = true;
+    Application::app().runTask(
+        mem_fun(*this, &ReflectorUdpWorkers::flushPending));
+  }
+  return true;
+} /* ReflectorUdpWorkers::queueDatagram */
+
+
+void ReflectorUdpWorkers::flushPending(void)
+{
+  m_flush_pending = false;
+  if (m_pending.empty() || (m_main_sock == nullptr))
+  {
+    return;
+  }
+
+    // The transmit locks of all clients in the batch are held until the
+    // batch has been sent so that a worker cannot send a datagram with a
+    // higher counter value to any of the clients before the batch. The locks
+    // are taken in address order. The workers only hold one lock at a time.
+  std::vector<std::mutex*> locks;
+  for (const auto& dgram : m_pending)
+  {
+    locks.push_back(&dgram.cntrs->tx_mutex);
+  }
+  std::sort(locks.begin(), locks.end());
+  locks.erase(std::unique(locks.begin(), locks.end()), locks.end());
+  for (std::mutex* lock : locks)
+  {
+    lock->lock();
+  }
+
+  for (const auto& dgram : m_pending)
+  {
+    CipherContexts* ctxs = cipherContexts(m_main_ctxs, dgram.id, dgram.key);
+    if (ctxs == nullptr)
+    {
+      continue;
+    }
+    const size_t size = EncryptedUdpSocket::encryptedSize(
+        UdpCipher::AADLEN, UdpCipher::TAGLEN, dgram.len);
+    if (m_main_tx_buf.size() < size)
+    {
+      m_main_tx_buf.resize(size);
+    }
+    int len = encryptDatagram(ctxs, dgram.iv_rand, *dgram.cntrs,
+                              m_pending_data.data() + dgram.offset, dgram.len,
+                              m_main_tx_buf);
+    if (len >= 0)
+    {
+        // The datagram is already encrypted so the encryption done by
+        // EncryptedUdpSocket::write must be bypassed
+      m_main_sock->UdpSocket::write(dgram.ip, dgram.port,
+                                    m_main_tx_buf.data(), len);
+    }
+  }
+  m_main_sock->flushSendQueue();
+
+  for (std::mutex* lock : locks)
+  {
+    lock->unlock();
+  }
+  m_pending.clear();
+  m_pending_data.clear();
+} /* ReflectorUdpWorkers::flushPending */
+
+
+int ReflectorUdpWorkers::encryptDatagram(CipherContexts* ctxs,
+                                         const std::vector<uint8_t>& iv_rand,
+                                         ReflectorClient::UdpCounters& cntrs,
+                                         const uint8_t* buf, size_t count,
+                                         std::vector<uint8_t>& tx_buf)
+{
+    // The caller must hold the transmit lock
+  const UdpCipher::IVCntr cntr = cntrs.tx_iv_cntr++;
+  uint8_t iv[UdpCipher::IVLEN];
+  uint8_t aad_buf[UdpCipher::AADLEN];
+  Async::MsgBufWriter aadw(aad_buf, sizeof(aad_buf));
+  if (!packIV(iv_rand, 0, cntr, iv) || !UdpCipher::AAD{cntr}.pack(aadw))
+  {
+    return -1;
+  }
+  return EncryptedUdpSocket::encryptDatagram(
+      ctxs->enc, iv, UdpCipher::TAGLEN, aad_buf, aadw.size(),
+      buf, count, tx_buf.data());
+} /* ReflectorUdpWorkers::encryptDatagram */
+
+
+bool ReflectorUdpWorkers::encryptAndSend(int sock, CipherContexts* ctxs,
+                                         const std::vector<uint8_t>& iv_rand,
+                                         ReflectorClient::UdpCounters& cntrs,
+                                         const struct sockaddr_in& addr,
+                                         const uint8_t* buf, size_t count,
+                                         std::vector<uint8_t>& tx_buf)
+{
+    // The counter is taken and the datagram is sent under the lock so that
+    // datagrams sent to the same client by different threads reach the
+    // network in counter order
+  std::lock_guard<std::mutex> lock(cntrs.tx_mutex);
+  int len = encryptDatagram(ctxs, iv_rand, cntrs, buf, count, tx_buf);
+  if (len < 0)
+  {
+    return false;
+  }
+  if (sendto(sock, tx_buf.data(), len, 0,
+             reinterpret_cast<const struct sockaddr*>(&addr),
+             sizeof(addr)) == -1)
+  {
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+    {
+      perror("sendto in UDP worker");
+    }
+    return false;
+  }
+  return true;
+} /* ReflectorUdpWorkers::encryptAndSend */
+
+
+ReflectorUdpWorkers::CipherContexts* ReflectorUdpWorkers::cipherContexts(
+    CipherContextMap& ctxs, ClientId id, const std::vector<uint8_t>& key)
+{
+  auto it = ctxs.find(id);
+  if (it != ctxs.end())
+  {
+    if (it->second.key == key)
+    {
+      return &it->second;
+    }
+    EncryptedUdpSocket::freeCipherContext(it->second.enc);
+    EncryptedUdpSocket::freeCipherContext(it->second.dec);
+    ctxs.erase(it);
+  }
+
+    // The key schedule is set up once per client and thread
+  CipherContexts new_ctxs;
+  new_ctxs.key = key;
+  new_ctxs.enc = EncryptedUdpSocket::newCipherContext(m_cipher, key, true);
+  new_ctxs.dec = EncryptedUdpSocket::newCipherContext(m_cipher, key, false);
+  if ((new_ctxs.enc == nullptr) || (new_ctxs.dec == nullptr))
+  {
+    EncryptedUdpSocket::freeCipherContext(new_ctxs.enc);
+    EncryptedUdpSocket::freeCipherContext(new_ctxs.dec);
+    return nullptr;
+  }
+  return &ctxs.emplace(id, std::move(new_ctxs)).first->second;
+} /* ReflectorUdpWorkers::cipherContexts */
+
+
+void ReflectorUdpWorkers::pruneCipherContexts(CipherContextMap& ctxs,
+                                              const State* state)
+{
+    // Free contexts for clients that have left or got a new key. The
+    // client id may have been reused by a new client.
+  auto it = ctxs.begin();
+  while (it != ctxs.end())
+  {
+    auto id_it = state->id_map.find(it->first);
+    if ((id_it == state->id_map.end()) ||
+        (state->peers[id_it->second].key != it->second.key))
+    {
+      EncryptedUdpSocket::freeCipherContext(it->second.enc);
+      EncryptedUdpSocket::freeCipherContext(it->second.dec);
+      it = ctxs.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+} /* ReflectorUdpWorkers::pruneCipherContexts */
+
+
+void ReflectorUdpWorkers::freeCipherContexts(CipherContextMap& ctxs)
+{
+  for (auto& item : ctxs)
+  {
+    EncryptedUdpSocket::freeCipherContext(item.second.enc);
+    EncryptedUdpSocket::freeCipherContext(item.second.dec);
+  }
+  ctxs.clear();
+} /* ReflectorUdpWorkers::freeCipherContexts */
+
+
+void ReflectorUdpWorkers::postEvent(Event&& event)
+{
+  bool signal = false;
+  {
+    const std::lock_guard<std::mutex> lock(m_event_mutex);
+    m_events.push_back(std::move(event));
+    signal = !m_event_signaled;
+    m_event_signaled = true;
+  }
+  if (signal)
+  {
+    const char ch = 0;
+    if (write(m_event_pipe[1], &ch, 1) == -1)
+    {
+      perror("write to UDP worker event pipe");
+    }
+  }
+} /* ReflectorUdpWorkers::postEvent */
+
+
+void ReflectorUdpWorkers::onEventPipeActivity(FdWatch* watch)
+{
+  char buf[64];
+  while (read(m_event_pipe[0], buf, sizeof(buf)) > 0)
+  {
+  }
+
+  std::deque<Event> events;
+  {
+    const std::lock_guard<std::mutex> lock(m_event_mutex);
+    events.swap(m_events);
+    m_event_signaled = false;
+  }
+
+  for (Event& event : events)
+  {
+    const IpAddress ip(event.addr.sin_addr);
+    const uint16_t port = ntohs(event.addr.sin_port);
+    switch (event.type)
+    {
+      case Event::RAW:
+        datagramReceived(ip, port, event.data.data(), event.data.size());
+        break;
+      case Event::DECRYPTED:
+        decryptedDatagramReceived(ip, port, event.data.data(), event.aadlen,
+            event.data.data() + event.aadlen,
+            event.data.size() - event.aadlen);
+        break;
+      case Event::ACTIVITY:
+        audioForwarded(event.client_id, event.tg);
+        break;
+    }
+  }
+
+  reclaimStates();
+} /* ReflectorUdpWorkers::onEventPipeActivity */
+
+
+void ReflectorUdpWorkers::reclaimStates(void)
+{
+  uint64_t min_gen = GEN_IDLE;
+  for (const Worker* w : m_workers)
+  {
+    min_gen = std::min(min_gen, w->active_gen.load());
+  }
+  auto it = m_retired.begin();
+  while (it != m_retired.end())
+  {
+    if (it->first <= min_gen)
+    {
+      delete it->second;
+      it = m_retired.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+} /* ReflectorUdpWorkers::reclaimStates */
+
+
+bool ReflectorUdpWorkers::attachSteeringProgram(void)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    // The main socket is first in the reuseport group so the workers have
+    // index 1 to N. Select a worker using the source IP address and port so
+    // that all datagrams from a client end up in the same worker.
+  const uint32_t worker_cnt = m_workers.size();
+  struct sock_filter code[] = {
+      // X = IP header length
+    { BPF_LDX | BPF_B | BPF_MSH, 0, 0, static_cast<uint32_t>(SKF_NET_OFF) },
+      // A = UDP source port
+    { BPF_LD | BPF_H | BPF_IND, 0, 0, static_cast<uint32_t>(SKF_NET_OFF) },
+    { BPF_ST, 0, 0, 0 },
+      // A = IP source address
+    { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_NET_OFF + 12) },
+    { BPF_LDX | BPF_MEM, 0, 0, 0 },
+    { BPF_ALU | BPF_XOR | BPF_X, 0, 0, 0 },
+    { BPF_ALU | BPF_MOD | BPF_K, 0, 0, worker_cnt },
+    { BPF_ALU | BPF_ADD | BPF_K, 0, 0, 1 },
+    { BPF_RET | BPF_A, 0, 0, 0 }
+  };
+  struct sock_fprog prog;
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+  if (setsockopt(m_workers.front()->sock, SOL_SOCKET,
+                 SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == -1)
+  {
+    perror("setsockopt(SO_ATTACH_REUSEPORT_CBPF)");
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+} /* ReflectorUdpWorkers::attachSteeringProgram */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,415 @@
+/**
+@file   ReflectorUdpWorkers.h
+@brief  Threads that receive and forward reflector UDP audio
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_UDP_WORKERS_INCLUDED
+#define REFLECTOR_UDP_WORKERS_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <netinet/in.h>
+#include <sigc++/sigc++.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncEncryptedUdpSocket.h>
+#include <AsyncIpAddress.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorClient.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class FdWatch;
+  class UdpSocket;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Threads that receive and forward reflector UDP audio
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class run a number of worker threads that each own a UDP socket bound to
+the reflector UDP port using SO_REUSEPORT. The main reflector socket must also
+be bound using SO_REUSEPORT, before the workers are started. A small BPF
+program is attached to the socket group so that the kernel steer each client
+to one of the worker sockets, based on the client source address and port.
+
+The workers decrypt incoming datagrams. Audio from the current talker of a
+talk group is forwarded directly to all other clients on the talk group,
+encrypted for each client, without involving the main thread. All other
+datagrams are handed over to the main thread through the datagramReceived and
+decryptedDatagramReceived signals. The main thread is also told, at a limited
+rate, about forwarded audio through the audioForwarded signal so that timers
+and talker state can be updated.
+
+The workers never touch the ReflectorClient and TGHandler objects. Instead the
+main thread publish an immutable State object holding the information needed
+for forwarding each time something relevant change. The state is published
+using an atomic pointer so the workers never have to take a lock. Old states
+are freed by the main thread when no worker can be using them anymore.
+
+Datagrams that the main thread sends to protocol V3 clients are queued and
+sent in one batch, using the main socket, when the call chain has returned to
+the main loop.
+*/
+class ReflectorUdpWorkers : public sigc::trackable
+{
+  public:
+    using ClientId = ReflectorClient::ClientId;
+
+    /**
+     * @brief   Information about one client needed by the workers
+     */
+    struct Peer
+    {
+      ClientId                        id          = 0;
+      std::string                     callsign;
+      bool                            registered  = false;
+      struct sockaddr_in              addr        {};
+      uint32_t                        tg          = 0;
+      std::vector<uint8_t>            key;
+      std::vector<uint8_t>            iv_rand;
+      ReflectorClient::UdpCountersPtr cntrs;
+    };
+
+    /**
+     * @brief   The state published to the workers
+     *
+     * Only protocol V3 clients that have received a UDP cipher key are
+     * added. A talk group is only added to the listeners map if the audio
+     * for the talk group can be forwarded by the workers, that is if all
+     * clients on the talk group use protocol V3.
+     */
+    struct State
+    {
+      std::vector<Peer>                                 peers;
+      std::unordered_map<ClientId, size_t>              id_map;
+      std::unordered_map<uint64_t, size_t>              src_map;
+      std::unordered_map<uint32_t, ClientId>            talkers;
+      std::unordered_map<uint32_t, std::vector<size_t>> listeners;
+      uint64_t                                          gen = 0;
+
+      /**
+       * @brief   Add a peer
+       * @param   peer The peer to add
+       * @return  Returns the index of the peer
+       */
+      size_t addPeer(const Peer& peer);
+
+      /**
+       * @brief   Create a key for the src_map
+       * @param   addr The source address and port
+       * @return  Returns the key
+       */
+      static uint64_t srcKey(const struct sockaddr_in& addr);
+    };
+
+    /**
+     * @brief   Default constructor
+     */
+    ReflectorUdpWorkers(void);
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    ReflectorUdpWorkers(const ReflectorUdpWorkers&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    ReflectorUdpWorkers& operator=(const ReflectorUdpWorkers&) = delete;
+
+    /**
+     * @brief   Destructor
+     */
+    ~ReflectorUdpWorkers(void);
+
+    /**
+     * @brief   Start the worker threads
+     * @param   port        The reflector UDP port
+     * @param   cipher      The cipher used for the UDP traffic
+     * @param   worker_cnt  The number of worker threads to start
+     * @param   main_sock   The main reflector UDP socket, used to send
+     *                      datagrams from the main thread
+     * @return  Returns \em true on success
+     */
+    bool start(uint16_t port, const Async::EncryptedUdpSocket::Cipher* cipher,
+               unsigned worker_cnt, Async::UdpSocket* main_sock);
+
+    /**
+     * @brief   Stop all worker threads
+     */
+    void stop(void);
+
+    /**
+     * @brief   Get the number of running workers
+     * @return  Returns the number of worker threads
+     */
+    unsigned workerCount(void) const { return m_workers.size(); }
+
+    /**
+     * @brief   Publish a new state to the workers
+     * @param   state The new state, ownership is taken over
+     */
+    void publish(State* state);
+
+    /**
+     * @brief   Send a datagram to a client from the main thread
+     * @param   client  The client to send to
+     * @param   buf     The packed header and message
+     * @param   count   The size of the packed data
+     * @return  Returns \em true if the datagram was queued
+     *
+     * When the workers are running, all protocol V3 datagrams must be sent
+     * using this function. The datagram is queued and then encrypted and
+     * sent, together with all other queued datagrams, when the call chain
+     * has returned to the main loop. The datagrams are sent in a batch using
+     * the main socket, so the send batching of that socket is used.
+     *
+     * The transmit locks of all clients in the batch are held from the time
+     * that the transmit counters are incremented until the batch has been
+     * sent, just like when the workers forward audio. That way the datagrams
+     * reach each client in the same order as the transmit counter is
+     * incremented. A worker that forwards audio to one of the clients at the
+     * same time will have to wait for the batch to be sent.
+     */
+    bool send(const ReflectorClient* client, const void* buf, size_t count);
+
+    /**
+     * @brief   A datagram that the workers could not handle was received
+     * @param   ip    The source IP-address
+     * @param   port  The source port
+     * @param   buf   The datagram, as received from the network
+     * @param   count The size of the datagram
+     */
+    sigc::signal<void(const Async::IpAddress&, uint16_t,
+                      void*, int)> datagramReceived;
+
+    /**
+     * @brief   A datagram that was not forwarded was received
+     * @param   ip      The source IP-address
+     * @param   port    The source port
+     * @param   aad     The associated data
+     * @param   aadlen  The length of the associated data
+     * @param   buf     The decrypted data
+     * @param   count   The length of the decrypted data
+     *
+     * The datagram come from a known client and the sequence number in the
+     * associated data has already been checked by the worker.
+     */
+    sigc::signal<void(const Async::IpAddress&, uint16_t, void*, size_t,
+                      void*, int)> decryptedDatagramReceived;
+
+    /**
+     * @brief   Audio from a client has been forwarded
+     * @param   client_id The id of the talking client
+     * @param   tg        The talk group
+     *
+     * This signal is emitted at most every ACTIVITY_INTERVAL_MS milliseconds
+     * for each talking client.
+     */
+    sigc::signal<void(ClientId, uint32_t)> audioForwarded;
+
+  private:
+    static constexpr int64_t  ACTIVITY_INTERVAL_MS  = 250;
+    static constexpr uint64_t GEN_IDLE              = UINT64_MAX;
+
+    struct CipherContexts
+    {
+      std::vector<uint8_t>                      key;
+      Async::EncryptedUdpSocket::CipherContext* enc = nullptr;
+      Async::EncryptedUdpSocket::CipherContext* dec = nullptr;
+    };
+    using CipherContextMap = std::unordered_map<ClientId, CipherContexts>;
+
+    struct Worker
+    {
+      std::thread                               thread;
+      int                                       sock          = -1;
+      std::atomic<uint64_t>                     active_gen    {GEN_IDLE};
+      uint64_t                                  state_gen     = 0;
+      CipherContextMap                          ctxs;
+      std::unordered_map<ClientId, int64_t>     last_activity;
+      std::vector<uint8_t>                      rx_buf;
+      std::vector<uint8_t>                      plain_buf;
+      std::vector<uint8_t>                      tx_buf;
+    };
+
+    struct PendingDatagram
+    {
+      ClientId                        id;
+      std::vector<uint8_t>            key;
+      std::vector<uint8_t>            iv_rand;
+      ReflectorClient::UdpCountersPtr cntrs;
+      Async::IpAddress                ip;
+      uint16_t                        port;
+      size_t                          offset;
+      size_t                          len;
+    };
+
+    struct Event
+    {
+      enum Type { RAW, DECRYPTED, ACTIVITY };
+      Type                  type;
+      struct sockaddr_in    addr;
+      std::vector<uint8_t>  data;
+      size_t                aadlen    = 0;
+      ClientId              client_id = 0;
+      uint32_t              tg        = 0;
+    };
+
+    const Async::EncryptedUdpSocket::Cipher*  m_cipher        = nullptr;
+    std::vector<Worker*>                      m_workers;
+    std::atomic<State*>                       m_state         {nullptr};
+    CipherContextMap                          m_main_ctxs;
+    std::vector<uint8_t>                      m_main_tx_buf;
+    Async::UdpSocket*                         m_main_sock     = nullptr;
+    std::vector<PendingDatagram>              m_pending;
+    std::vector<uint8_t>                      m_pending_data;
+    bool                                      m_flush_pending = false;
+    std::atomic<uint64_t>                     m_gen           {0};
+    std::vector<std::pair<uint64_t, State*>>  m_retired;
+    int                                       m_stop_pipe[2]  {-1, -1};
+    int                                       m_event_pipe[2] {-1, -1};
+    Async::FdWatch*                           m_event_watch   = nullptr;
+    std::mutex                                m_event_mutex;
+    std::deque<Event>                         m_events;
+    bool                                      m_event_signaled = false;
+
+    void workerThread(Worker* w);
+    void handleDatagram(Worker* w, const State* state,
+                        const struct sockaddr_in& addr,
+                        uint8_t* buf, int count);
+    bool forwardAudio(Worker* w, const State* state, const Peer& talker,
+                      const uint8_t* buf, size_t count);
+    bool queueDatagram(ClientId id, const std::vector<uint8_t>& key,
+                       const std::vector<uint8_t>& iv_rand,
+                       const ReflectorClient::UdpCountersPtr& cntrs,
+                       const Async::IpAddress& ip, uint16_t port,
+                       const void* buf, size_t count);
+    void flushPending(void);
+    int encryptDatagram(CipherContexts* ctxs,
+                        const std::vector<uint8_t>& iv_rand,
+                        ReflectorClient::UdpCounters& cntrs,
+                        const uint8_t* buf, size_t count,
+                        std::vector<uint8_t>& tx_buf);
+    bool encryptAndSend(int sock, CipherContexts* ctxs,
+                        const std::vector<uint8_t>& iv_rand,
+                        ReflectorClient::UdpCounters& cntrs,
+                        const struct sockaddr_in& addr,
+                        const uint8_t* buf, size_t count,
+                        std::vector<uint8_t>& tx_buf);
+    CipherContexts* cipherContexts(CipherContextMap& ctxs, ClientId id,
+                                   const std::vector<uint8_t>& key);
+    void pruneCipherContexts(CipherContextMap& ctxs, const State* state);
+    void freeCipherContexts(CipherContextMap& ctxs);
+    void postEvent(Event&& event);
+    void onEventPipeActivity(Async::FdWatch* watch);
+    void reclaimStates(void);
+    bool attachSteeringProgram(void);
+};  /* class ReflectorUdpWorkers */
+
+
+//} /* namespace */
+
+#endif /* REFLECTOR_UDP_WORKERS_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
@@ -169,7 +169,9 @@ bool TGHandler::switchTo(ReflectorClient *client, uint32_t tg)
       m_id_map[tg] = tg_info;
     }
     tg_info->clients.insert(client);
+    tg_info->subscribers.push_back(client);
     m_client_map[client] = tg_info;
+    subscribersUpdated(tg);
   }
 
   //printTGStatus();
@@ -191,6 +193,7 @@ void TGHandler::removeClient(ReflectorClient* client)
     removeClientP(tg_info, client);
     //printTGStatus();
   }
+  setMonitoredTGs(client, std::set<uint32_t>());
 } /* TGHandler::removeClient */
 
 
@@ -206,6 +209,75 @@ const TGHandler::ClientSet& TGHandler::clientsForTG(uint32_t tg) const
 } /* TGHandler::clientsForTG */
 
 
+const TGHandler::ClientList& TGHandler::subscribersForTG(uint32_t tg) const
+{
+  static const TGHandler::ClientList empty_list;
+  IdMap::const_iterator id_map_it = m_id_map.find(tg);
+  if (id_map_it == m_id_map.end())
+  {
+    return empty_list;
+  }
+  return id_map_it->second->subscribers;
+} /* TGHandler::subscribersForTG */
+
+
+const TGHandler::ClientList& TGHandler::monitorsForTG(uint32_t tg) const
+{
+  static const TGHandler::ClientList empty_list;
+  MonitorMap::const_iterator it = m_monitor_map.find(tg);
+  if (it == m_monitor_map.end())
+  {
+    return empty_list;
+  }
+  return it->second;
+} /* TGHandler::monitorsForTG */
+
+
+void TGHandler::setMonitoredTGs(ReflectorClient* client,
+                                const std::set<uint32_t>& tgs)
+{
+  std::set<uint32_t> old_tgs;
+  MonitorClientMap::iterator client_it = m_monitor_client_map.find(client);
+  if (client_it != m_monitor_client_map.end())
+  {
+    old_tgs.swap(client_it->second);
+  }
+
+  for (const auto& tg : old_tgs)
+  {
+    if (tgs.count(tg) == 0)
+    {
+      MonitorMap::iterator it = m_monitor_map.find(tg);
+      assert(it != m_monitor_map.end());
+      listRemove(it->second, client);
+      if (it->second.empty())
+      {
+        m_monitor_map.erase(it);
+      }
+    }
+  }
+  for (const auto& tg : tgs)
+  {
+    if (old_tgs.count(tg) == 0)
+    {
+      m_monitor_map[tg].push_back(client);
+    }
+  }
+
+  if (tgs.empty())
+  {
+    if (client_it != m_monitor_client_map.end())
+    {
+      m_monitor_client_map.erase(client_it);
+    }
+  }
+  else
+  {
+    m_monitor_client_map[client] = tgs;
+  }
+} /* TGHandler::setMonitoredTGs */
+
+
 void TGHandler::setTalkerForTG(uint32_t tg, ReflectorClient* new_talker)
 {
   IdMap::const_iterator id_map_it = m_id_map.find(tg);
@@ -392,15 +464,29 @@ void TGHandler::removeClientP(TGInfo *tg_info, ReflectorClient* client)
     tg_info->talker = 0;
   }
   tg_info->clients.erase(client);
+  listRemove(tg_info->subscribers, client);
   m_client_map.erase(client);
+  const uint32_t tg = tg_info->id;
   if (tg_info->clients.empty())
   {
     m_id_map.erase(tg_info->id);
     delete tg_info;
   }
+  subscribersUpdated(tg);
 } /* TGHandler::removeClientP */
 
 
+void TGHandler::listRemove(ClientList& list, ReflectorClient* client)
+{
+  ClientList::iterator it = std::find(list.begin(), list.end(), client);
+  if (it != list.end())
+  {
+    *it = list.back();
+    list.pop_back();
+  }
+} /* TGHandler::listRemove */
+
+
 void TGHandler::printTGStatus(void)
 {
   std::cout << "### ----------- BEGIN ----------------" << std::endl;
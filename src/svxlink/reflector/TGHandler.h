@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <map>
 #include <set>
+#include <vector>
 #include <sigc++/sigc++.h>
 #include <sys/time.h>
 
@@ -118,6 +119,7 @@ class TGHandler : public sigc::trackable
 {
   public:
     typedef std::set<ReflectorClient*> ClientSet;
+    typedef std::vector<ReflectorClient*> ClientList;
 
     static TGHandler* instance(void)
     {
@@ -157,6 +159,38 @@ class TGHandler : public sigc::trackable
 
     const ClientSet& clientsForTG(uint32_t tg) const;
 
+    /**
+     * @brief   Get the clients that have selected the given talk group
+     * @param   tg The talk group
+     * @return  Returns a list of clients
+     *
+     * This is the same set of clients as returned by clientsForTG but stored
+     * in a contiguous array, suitable for fast iteration when distributing
+     * audio. The order of the clients is unspecified. The list is only valid
+     * until the next call that change talk group membership.
+     */
+    const ClientList& subscribersForTG(uint32_t tg) const;
+
+    /**
+     * @brief   Get the clients that monitor the given talk group
+     * @param   tg The talk group
+     * @return  Returns a list of clients
+     *
+     * A client that monitor a talk group may also have selected it so the
+     * list may overlap the one returned by subscribersForTG. The order of the
+     * clients is unspecified. The list is only valid until the next call that
+     * change talk group monitoring.
+     */
+    const ClientList& monitorsForTG(uint32_t tg) const;
+
+    /**
+     * @brief   Set which talk groups that a client monitor
+     * @param   client The client
+     * @param   tgs The set of monitored talk groups
+     */
+    void setMonitoredTGs(ReflectorClient* client,
+                         const std::set<uint32_t>& tgs);
+
     void setTalkerForTG(uint32_t tg, ReflectorClient* client);
 
     ReflectorClient* talkerForTG(uint32_t tg) const;
@@ -176,6 +210,12 @@ class TGHandler : public sigc::trackable
 
     sigc::signal<void(uint32_t)> requestAutoQsy;
 
+    /**
+     * @brief   A signal that is emitted when the subscribers of a TG change
+     * @param   tg The talk group
+     */
+    sigc::signal<void(uint32_t)> subscribersUpdated;
+
   private:
     static const time_t TALKER_AUDIO_TIMEOUT = 3; // Max three seconds gap
 
@@ -183,6 +223,7 @@ class TGHandler : public sigc::trackable
     {
       uint32_t          id;
       ClientSet         clients;
+      ClientList        subscribers;
       ReflectorClient*  talker;
       struct timeval    last_talker_timestamp;
       unsigned          sql_timeout_cnt;
@@ -198,10 +239,15 @@ class TGHandler : public sigc::trackable
     };
     typedef std::map<uint32_t, TGInfo*>               IdMap;
     typedef std::map<const ReflectorClient*, TGInfo*> ClientMap;
+    typedef std::map<uint32_t, ClientList>            MonitorMap;
+    typedef std::map<const ReflectorClient*, std::set<uint32_t>>
+                                                      MonitorClientMap;
 
     const Async::Config*  m_cfg;
     IdMap                 m_id_map;
     ClientMap             m_client_map;
+    MonitorMap            m_monitor_map;
+    MonitorClientMap      m_monitor_client_map;
     Async::Timer          m_timeout_timer;
     unsigned              m_sql_timeout;
     unsigned              m_sql_timeout_blocktime;
@@ -210,6 +256,7 @@ class TGHandler : public sigc::trackable
     TGHandler& operator=(const TGHandler&);
     void checkTimers(Async::Timer *t);
     void removeClientP(TGInfo *tg_info, ReflectorClient* client);
+    static void listRemove(ClientList& list, ReflectorClient* client);
     void printTGStatus(void);
 };  /* class TGHandler */
 
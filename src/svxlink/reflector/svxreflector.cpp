@@ -364,6 +364,23 @@ int main(int argc, const char *argv[])
   cfg.getValue("GLOBAL", "TIMESTAMP_FORMAT", tstamp_format);
   logwriter.setTimestampFormat(tstamp_format);
 
+  std::string io_backend;
+  if (cfg.getValue("GLOBAL", "IO_BACKEND", io_backend))
+  {
+      // Edge triggered epoll require that all file descriptor watches read
+      // until EAGAIN, which the TCP and UDP sockets do not do. It can still
+      // be selected using ASYNC_CPP_APP_BACKEND for testing.
+    CppApplication::Backend backend;
+    if (!CppApplication::backendFromName(io_backend, backend) ||
+        (backend == CppApplication::BACKEND_EPOLL_ET) ||
+        !app.setBackend(backend))
+    {
+      cerr << "*** ERROR: Unknown or unsupported value for configuration "
+              "variable GLOBAL/IO_BACKEND=" << io_backend << endl;
+      exit(1);
+    }
+  }
+
   cout << PROGRAM_NAME " v" SVXREFLECTOR_VERSION
           " Copyright (C) 2003-2025 Tobias Blomberg / SM0SVX\n\n";
   cout << PROGRAM_NAME " comes with ABSOLUTELY NO WARRANTY. "
@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <cstring>
 #include <cerrno>
+#include <cstdlib>
 
 
 /****************************************************************************
@@ -129,12 +130,17 @@ NetUplink::NetUplink(Config &cfg, const string &name, Rx *rx, Tx *tx,
     cfg(cfg), name(name), last_msg_timestamp(), heartbeat_timer(0),
     audio_enc(0), audio_dec(0), loopback_con(0), rx_splitter(0),
     tx_selector(0), state(STATE_DISC), mute_tx_timer(0), tx_muted(false),
-    fallback_enabled(false), tx_ctrl_mode(Tx::TX_OFF)
+    fallback_enabled(false), tx_ctrl_mode(Tx::TX_OFF),
+    udp_audio_enabled(false), udp_port(0)
 {
   heartbeat_timer = new Timer(10000);
   heartbeat_timer->setEnable(false);
   heartbeat_timer->expired.connect(mem_fun(*this, &NetUplink::heartbeat));
 
+  udp_audio.msgReceived.connect(mem_fun(*this, &NetUplink::handleMsg));
+  udp_audio.activeChanged.connect(
+      mem_fun(*this, &NetUplink::udpAudioActiveChanged));
+
     // FIXME: Shouldn't we use the updates directly from the receiver instead?
     // Why is this even here?!
   //siglev_check_timer = new Timer(1000, Timer::TYPE_PERIODIC);
@@ -194,6 +200,23 @@ bool NetUplink::initialize(void)
   cfg.getValue(name, "FALLBACK_REPEATER", fallback_enabled, true);
   cfg.getValue(name, "AUTH_KEY", auth_key);
 
+  cfg.getValue(name, "UDP_AUDIO", udp_audio_enabled);
+  if (udp_audio_enabled)
+  {
+      // The UDP audio channel use the same port number as the TCP server
+    udp_port = atoi(listen_port.c_str());
+    if (udp_port == 0)
+    {
+      std::cerr << "*** WARNING: " << name << "/LISTEN_PORT must be given "
+                   "as a number for UDP audio to work. Sending audio over TCP."
+                << std::endl;
+      udp_audio_enabled = false;
+    }
+  }
+  unsigned udp_jitter_buffer_delay = udp_audio.jitterBufferDelay();
+  cfg.getValue(name, "UDP_JITTER_BUFFER_DELAY", udp_jitter_buffer_delay);
+  udp_audio.setJitterBufferDelay(udp_jitter_buffer_delay);
+
   int mute_tx_on_rx = -1;
   cfg.getValue(name, "MUTE_TX_ON_RX", mute_tx_on_rx, true);
   if (mute_tx_on_rx >= 0)
@@ -295,6 +318,7 @@ void NetUplink::handleIncomingConnection(TcpConnection *incoming_con)
   heartbeat_timer->setEnable(true);
   gettimeofday(&last_msg_timestamp, NULL);
   
+  udp_audio.reset();
   setState(STATE_CON_SETUP);
 
   MsgProtoVer *ver_msg = new MsgProtoVer;
@@ -384,6 +408,7 @@ void NetUplink::clientDisconnected(TcpConnection *the_con,
             << std::endl;
 
   con = 0;
+  udp_audio.reset();
   setState(STATE_DISC_CLEANUP);
   Application::app().runTask(mem_fun(*this, &NetUplink::disconnectCleanup));
 } /* NetUplink::clientDisconnected */
@@ -435,7 +460,7 @@ int NetUplink::tcpDataReceived(TcpConnection *con, void *data, int size)
       	Msg *msg = reinterpret_cast<Msg*>(recv_buf);
 	if (msg->size() == sizeof(Msg))
 	{
-	  handleMsg(msg);
+	  udp_audio.tcpMsgReceived(msg);
 	  recv_cnt = 0;
 	  recv_exp = sizeof(Msg);
 	}
@@ -455,7 +480,7 @@ int NetUplink::tcpDataReceived(TcpConnection *con, void *data, int size)
       else
       {
       	Msg *msg = reinterpret_cast<Msg*>(recv_buf);
-      	handleMsg(msg);
+      	udp_audio.tcpMsgReceived(msg);
 	recv_cnt = 0;
 	recv_exp = sizeof(Msg);
       }
@@ -668,6 +693,12 @@ void NetUplink::handleMsg(Msg *msg)
       break;
     }
     
+    case MsgUdpAudioRequest::TYPE:
+    {
+      handleUdpAudioRequest();
+      break;
+    }
+
     case MsgFlush::TYPE:
     {
       if (audio_dec != 0)
@@ -717,8 +748,28 @@ void NetUplink::handleMsg(Msg *msg)
 
 void NetUplink::sendMsg(Msg *msg)
 {
+  if (state == STATE_READY)
+  {
+    if (msg->type() == MsgAudio::TYPE)
+    {
+      MsgAudio *audio_msg = reinterpret_cast<MsgAudio*>(msg);
+      if (udp_audio.sendAudio(audio_msg->buf(), audio_msg->size()))
+      {
+        delete msg;
+        return;
+      }
+    }
+      // Audio sent over UDP must be played before this message is handled
+    MsgUdpAudioMark *mark_msg = udp_audio.createMark();
+    if (mark_msg != 0)
+    {
+      sendMsg(mark_msg);
+    }
+  }
+
   if ((state == STATE_CON_SETUP) || (state == STATE_READY))
   {
+    udp_audio.tcpMsgSent();
     int written = con->write(msg, msg->size());
     if (written == -1)
     {
@@ -896,6 +947,45 @@ void NetUplink::forceDisconnect(void)
 } /* NetUplink::forceDisconnect */
 
 
+void NetUplink::handleUdpAudioRequest(void)
+{
+  if (!udp_audio_enabled || udp_audio.isStarted())
+  {
+    return;
+  }
+
+  uint32_t session_id = 0;
+  gcry_create_nonce(&session_id, sizeof(session_id));
+
+  std::vector<uint8_t> key;
+  if (!auth_key.empty() &&
+      !NetTrxUdpAudio::deriveKey(key, auth_key, auth_challenge, session_id))
+  {
+    return;
+  }
+
+  if (!udp_audio.startServer(udp_port, con->remoteHost(), session_id, key))
+  {
+    std::cerr << "*** WARNING: Could not set up the UDP audio channel in "
+                 "NetUplink " << name << ". Sending audio over TCP."
+              << std::endl;
+    return;
+  }
+
+  MsgUdpAudioSetup *msg =
+      new MsgUdpAudioSetup(udp_port, session_id, !key.empty());
+  sendMsg(msg);
+} /* NetUplink::handleUdpAudioRequest */
+
+
+void NetUplink::udpAudioActiveChanged(bool is_active)
+{
+  std::cout << name << ": "
+            << (is_active ? "Sending audio over UDP" : "Sending audio over TCP")
+            << (udp_audio.isEncrypted() ? " (encrypted)" : "") << std::endl;
+} /* NetUplink::udpAudioActiveChanged */
+
+
 /*
  * This file has not been truncated
  */
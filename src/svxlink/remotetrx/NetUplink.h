@@ -48,6 +48,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncTcpConnection.h>
 #include <NetTrxMsg.h>
+#include <NetTrxUdpAudio.h>
 
 
 /****************************************************************************
@@ -190,6 +191,9 @@ class NetUplink : public Uplink
     bool		    tx_muted;
     bool                    fallback_enabled;
     Tx::TxCtrlMode	    tx_ctrl_mode;
+    NetTrxUdpAudio          udp_audio;
+    bool                    udp_audio_enabled;
+    uint16_t                udp_port;
     
     NetUplink(const NetUplink&);
     NetUplink& operator=(const NetUplink&);
@@ -237,6 +241,8 @@ class NetUplink : public Uplink
     void setFallbackActive(bool activate);
     void signalLevelUpdated(float siglev);
     void forceDisconnect(void);
+    void handleUdpAudioRequest(void);
+    void udpAudioActiveChanged(bool is_active);
     void setState(State new_state) { state = new_state; }
 
 };  /* class NetUplink */
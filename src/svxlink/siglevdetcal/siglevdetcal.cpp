@@ -46,6 +46,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncFdWatch.h>
 #include <AsyncTimer.h>
 #include <AsyncAudioIO.h>
+#include <AsyncAudioPolyphaseResampler.h>
 
 #include <LocalRxBase.h>
 
@@ -356,6 +357,20 @@ int main(int argc, char **argv)
       AudioIO::setBlockCount(2);
     }
     #endif
+    else if ((rate > 8000) &&
+             AudioPolyphaseResampler::isSupported(rate, 16000))
+    {
+      if (rate > 16000)
+      {
+        AudioIO::setBlocksize(1024);
+        AudioIO::setBlockCount(4);
+      }
+      else
+      {
+        AudioIO::setBlocksize(512);
+        AudioIO::setBlockCount(2);
+      }
+    }
     else
     {
       cerr << "*** ERROR: Illegal sound card sample rate specified for "
@@ -363,7 +378,8 @@ int main(int argc, char **argv)
 	      #if INTERNAL_SAMPLE_RATE <= 8000
 	      "8000, "
 	      #endif
-	      "16000 and 48000\n";
+	      "16000, 48000 and other rates above 8000 that can be "
+	      "converted to 16000 (e.g. 22050, 32000, 44100 or 96000)\n";
       exit(1);
     }
     AudioIO::setSampleRate(rate);
@@ -0,0 +1,254 @@
+/**
+@file	 MsgCache.cpp
+@brief   A cache of decoded audio clips used by the message handler
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/stat.h>
+
+#include <cassert>
+#include <cstring>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "MsgCache.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+namespace {
+  bool operator==(const MsgCache::FileStamp &a, const MsgCache::FileStamp &b)
+  {
+    return (a.dev == b.dev) && (a.ino == b.ino) && (a.size == b.size) &&
+           (a.mtime_ns == b.mtime_ns);
+  }
+};
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+MsgCache::MsgCache(size_t max_size)
+  : m_max_size(max_size), m_size(0), m_hits(0), m_misses(0)
+{
+} /* MsgCache::MsgCache */
+
+
+MsgCache::~MsgCache(void)
+{
+} /* MsgCache::~MsgCache */
+
+
+void MsgCache::setMaxSize(size_t max_size)
+{
+  m_max_size = max_size;
+  shrink(m_max_size);
+} /* MsgCache::setMaxSize */
+
+
+MsgCache::Clip MsgCache::find(const string &path, FileStamp &stamp)
+{
+  memset(&stamp, 0, sizeof(stamp));
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0)
+  {
+    stamp.dev = st.st_dev;
+    stamp.ino = st.st_ino;
+    stamp.size = st.st_size;
+    stamp.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                     st.st_mtim.tv_nsec;
+  }
+
+  ClipMap::iterator it = m_clips.find(path);
+  if (it != m_clips.end())
+  {
+    if (it->second.stamp == stamp)
+    {
+      m_lru.splice(m_lru.begin(), m_lru, it->second.lru_pos);
+      m_hits += 1;
+      return it->second.clip;
+    }
+
+      // The file has been changed or removed since it was cached
+    erase(it);
+  }
+
+  m_misses += 1;
+  return Clip();
+} /* MsgCache::find */
+
+
+MsgCache::Clip MsgCache::add(const string &path, const FileStamp &stamp,
+                             vector<float> &samples)
+{
+  Clip clip(new vector<float>());
+  const_cast<vector<float>&>(*clip).swap(samples);
+
+  const size_t size = clipSize(clip);
+  if ((stamp.ino == 0) || (size > m_max_size))
+  {
+    return clip;
+  }
+
+  ClipMap::iterator it = m_clips.find(path);
+  if (it != m_clips.end())
+  {
+    erase(it);
+  }
+  shrink(m_max_size - size);
+
+  m_lru.push_front(path);
+  Entry &entry = m_clips[path];
+  entry.clip = clip;
+  entry.stamp = stamp;
+  entry.lru_pos = m_lru.begin();
+  m_size += size;
+
+  return clip;
+} /* MsgCache::add */
+
+
+void MsgCache::clear(void)
+{
+  m_clips.clear();
+  m_lru.clear();
+  m_size = 0;
+} /* MsgCache::clear */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+size_t MsgCache::clipSize(const Clip &clip)
+{
+  return clip->size() * sizeof(float);
+} /* MsgCache::clipSize */
+
+
+void MsgCache::erase(ClipMap::iterator it)
+{
+  assert(m_size >= clipSize(it->second.clip));
+  m_size -= clipSize(it->second.clip);
+  m_lru.erase(it->second.lru_pos);
+  m_clips.erase(it);
+} /* MsgCache::erase */
+
+
+void MsgCache::shrink(size_t max_size)
+{
+  while ((m_size > max_size) && !m_lru.empty())
+  {
+    ClipMap::iterator it = m_clips.find(m_lru.back());
+    assert(it != m_clips.end());
+    erase(it);
+  }
+} /* MsgCache::shrink */
+
+
+
+/*
+ * This file has not been truncated
+ */
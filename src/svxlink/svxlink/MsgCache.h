@@ -0,0 +1,269 @@
+/**
+@file	 MsgCache.h
+@brief   A cache of decoded audio clips used by the message handler
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef MSG_CACHE_INCLUDED
+#define MSG_CACHE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A cache of decoded audio clips used by the message handler
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+The same sound clips are played over and over again, for example in
+identifications. This cache keep the decoded samples of the most recently
+played clips in memory so that a clip only has to be read from disk and
+decoded the first time it is played.
+
+A clip is identified by the path to its file. Each time a clip is looked up,
+the file is checked using stat. If the file has been changed since the clip
+was cached, the clip is thrown away and has to be loaded again. When the
+total size of the cached clips exceed the maximum size, the least recently
+used clips are thrown away.
+
+A clip is shared between the cache and its users. A clip that is thrown
+away while it is being played stay in memory until it has been played.
+*/
+class MsgCache
+{
+  public:
+    /**
+     * @brief   The samples of a cached clip
+     */
+    typedef std::shared_ptr<const std::vector<float> > Clip;
+
+    /**
+     * @brief   The state of a file, used to find out if it has changed
+     */
+    struct FileStamp
+    {
+      dev_t   dev;
+      ino_t   ino;
+      off_t   size;
+      int64_t mtime_ns;
+    };
+
+    /**
+     * @brief 	Constuctor
+     * @param	max_size The maximum total size of the cached clips in bytes
+     */
+    explicit MsgCache(size_t max_size);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~MsgCache(void);
+
+    /**
+     * @brief   Set the maximum size of the cache
+     * @param   max_size The maximum total size of the cached clips in bytes
+     *
+     * Setting the size to 0 disables the cache.
+     */
+    void setMaxSize(size_t max_size);
+
+    /**
+     * @brief   Get the maximum size of the cache
+     * @return  Returns the maximum total size of the cached clips in bytes
+     */
+    size_t maxSize(void) const { return m_max_size; }
+
+    /**
+     * @brief   Check if the cache is enabled
+     * @return  Returns \em true if clips can be cached
+     */
+    bool isEnabled(void) const { return m_max_size > 0; }
+
+    /**
+     * @brief   Look up a clip
+     * @param   path  The path to the file of the clip
+     * @param   stamp The current state of the file is stored here
+     * @return  Returns the clip or an empty pointer if it is not cached
+     *
+     * If the clip is not cached, load it and then add it to the cache using
+     * the add function, passing in the stamp returned by this function. If
+     * the file could not be found, the stamp is cleared and nothing should be
+     * added.
+     */
+    Clip find(const std::string &path, FileStamp &stamp);
+
+    /**
+     * @brief   Add a clip to the cache
+     * @param   path    The path to the file of the clip
+     * @param   stamp   The state of the file returned by the find function
+     * @param   samples The decoded samples of the clip. They are moved into
+     *                  the cache.
+     * @return  Returns the new clip
+     *
+     * A clip that is larger than the maximum size of the cache is returned
+     * but not cached.
+     */
+    Clip add(const std::string &path, const FileStamp &stamp,
+             std::vector<float> &samples);
+
+    /**
+     * @brief   Throw away all cached clips
+     */
+    void clear(void);
+
+    /**
+     * @brief   Get the number of lookups that found a cached clip
+     * @return  Returns the number of cache hits
+     */
+    uint64_t hits(void) const { return m_hits; }
+
+    /**
+     * @brief   Get the number of lookups that did not find a cached clip
+     * @return  Returns the number of cache misses
+     */
+    uint64_t misses(void) const { return m_misses; }
+
+    /**
+     * @brief   Get the number of cached clips
+     * @return  Returns the number of clips in the cache
+     */
+    size_t clipCount(void) const { return m_clips.size(); }
+
+    /**
+     * @brief   Get the total size of the cached clips
+     * @return  Returns the number of bytes used by the cached samples
+     */
+    size_t size(void) const { return m_size; }
+
+  private:
+    struct Entry
+    {
+      Clip                              clip;
+      FileStamp                         stamp;
+      std::list<std::string>::iterator  lru_pos;
+    };
+    typedef std::map<std::string, Entry> ClipMap;
+
+    size_t                  m_max_size;
+    size_t                  m_size;
+    ClipMap                 m_clips;
+    std::list<std::string>  m_lru;
+    uint64_t                m_hits;
+    uint64_t                m_misses;
+
+    MsgCache(const MsgCache&);
+    MsgCache& operator=(const MsgCache&);
+    static size_t clipSize(const Clip &clip);
+    void erase(ClipMap::iterator it);
+    void shrink(size_t max_size);
+
+};  /* class MsgCache */
+
+
+//} /* namespace */
+
+#endif /* MSG_CACHE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -52,6 +52,7 @@ extern "C" {
 #include <cstring>
 #include <fstream>
 #include <cerrno>
+#include <vector>
 
 
 
@@ -70,6 +71,7 @@ extern "C" {
  ****************************************************************************/
 
 #include "MsgHandler.h"
+#include "MsgCache.h"
 
 
 
@@ -92,6 +94,8 @@ using namespace std;
 //#define WRITE_BLOCK_SIZE    4*160
 #define WRITE_BLOCK_SIZE    256
 
+#define DEFAULT_CACHE_SIZE  (16 * 1024 * 1024)
+
 
 
 /****************************************************************************
@@ -106,6 +110,7 @@ class QueueItem
     QueueItem(bool idle_marked) : idle_marked(idle_marked) {}
     virtual ~QueueItem(void) {}
     virtual bool initialize(void) { return true; }
+      // Return the number of samples read, 0 at the end or -1 on error
     virtual int readSamples(float *samples, int len) = 0;
     virtual void unreadSamples(int len) = 0;
     
@@ -242,6 +247,29 @@ class WavFileQueueItem : public QueueItem
     int read16bitValue(uint8_t *ptr, uint16_t *val);
 };
 
+class CachedFileQueueItem : public QueueItem
+{
+  public:
+    CachedFileQueueItem(QueueItem *file_item, const std::string& filename,
+                        double samples_per_byte, MsgCache &cache,
+                        bool idle_marked)
+      : QueueItem(idle_marked), file_item(file_item), filename(filename),
+        samples_per_byte(samples_per_byte), cache(cache), pos(0) {}
+    ~CachedFileQueueItem(void) { delete file_item; }
+    bool initialize(void);
+    int readSamples(float *samples, int len);
+    void unreadSamples(int len);
+
+  private:
+    QueueItem       *file_item;
+    string          filename;
+    double          samples_per_byte;
+    MsgCache        &cache;
+    MsgCache::Clip  clip;
+    size_t          pos;
+
+};
+
 
 
 /****************************************************************************
@@ -267,6 +295,8 @@ class WavFileQueueItem : public QueueItem
  *
  ****************************************************************************/
 
+static MsgCache msg_cache(DEFAULT_CACHE_SIZE);
+
 
 
 /****************************************************************************
@@ -275,6 +305,18 @@ class WavFileQueueItem : public QueueItem
  *
  ****************************************************************************/
 
+void MsgHandler::setCacheSize(size_t max_size)
+{
+  msg_cache.setMaxSize(max_size);
+} /* MsgHandler::setCacheSize */
+
+
+const MsgCache& MsgHandler::cache(void)
+{
+  return msg_cache;
+} /* MsgHandler::cache */
+
+
 MsgHandler::MsgHandler(int sample_rate)
   : sample_rate(sample_rate), nesting_level(0), pending_play_next(false),
     current(0), is_writing_message(false), non_idle_cnt(0)
@@ -292,10 +334,12 @@ MsgHandler::~MsgHandler(void)
 void MsgHandler::playFile(const string& path, bool idle_marked)
 {
   QueueItem *item = 0;
+  double samples_per_byte = 1.0 / sizeof(short);
   const char *ext = strrchr(path.c_str(), '.');
   if (strcmp(ext, ".gsm") == 0)
   {
     item = new GsmFileQueueItem(path, idle_marked);
+    samples_per_byte = 160.0 / sizeof(gsm_frame);
   }
   else if (strcmp(ext, ".wav") == 0)
   {
@@ -305,6 +349,11 @@ void MsgHandler::playFile(const string& path, bool idle_marked)
   {
     item = new RawFileQueueItem(path, idle_marked);
   }
+  if (msg_cache.isEnabled())
+  {
+    item = new CachedFileQueueItem(item, path, samples_per_byte, msg_cache,
+                                   idle_marked);
+  }
   addItemToQueue(item);
 } /* MsgHandler::playFile */
 
@@ -489,7 +538,7 @@ void MsgHandler::writeSamples(void)
   do
   {
     read_cnt = current->readSamples(buf, sizeof(buf) / sizeof(*buf));
-    if (read_cnt == 0)
+    if (read_cnt <= 0)
     {
       goto done;
     }
@@ -590,7 +639,6 @@ int RawFileQueueItem::readSamples(float *samples, int len)
   if (read_cnt == -1)
   {
     perror("read in FileQueueItem::readSamples");
-    read_cnt = 0;
   }
   else
   {
@@ -672,13 +720,14 @@ int GsmFileQueueItem::readSamples(float *samples, int len)
     if (cnt == -1)
     {
       perror("read in GsmFileQueueItem::readSamples");
-      return 0;
+      return -1;
     }
     else if (cnt != sizeof(gsm_data))
     {
       if (cnt != 0)
       {
       	cerr << "*** WARNING: Corrupt GSM file: " << filename << endl;
+        return -1;
       }
       
       return 0;
@@ -953,7 +1002,7 @@ int WavFileQueueItem::readSamples(float *samples, int len)
   {
     cerr << "*** WARNING: Failed to read samples from WAV file \""
          << filename << "\": " << strerror(errno) << endl;
-    return 0;
+    return -1;
   }
 
   int read_cnt = file.gcount();
@@ -1085,6 +1134,85 @@ void DtmfQueueItem::unreadSamples(int len)
 
 
 
+/****************************************************************************
+ *
+ * Private member functions for class CachedFileQueueItem
+ *
+ ****************************************************************************/
+
+bool CachedFileQueueItem::initialize(void)
+{
+  MsgCache::FileStamp stamp;
+  clip = cache.find(filename, stamp);
+  if (clip)
+  {
+    delete file_item;
+    file_item = 0;
+    return true;
+  }
+
+  if (!file_item->initialize())
+  {
+    return false;
+  }
+
+    // Stream the file if it could not be found or if the decoded clip would
+    // be too large to be cached anyway
+  const double max_size = stamp.size * samples_per_byte * sizeof(float);
+  if ((stamp.ino == 0) || (max_size > cache.maxSize()))
+  {
+    return true;
+  }
+
+    // Not cached yet so decode the whole file using the file queue item
+  vector<float> samples;
+  float buf[WRITE_BLOCK_SIZE];
+  int read_cnt;
+  while ((read_cnt = file_item->readSamples(buf, WRITE_BLOCK_SIZE)) > 0)
+  {
+    samples.insert(samples.end(), buf, buf + read_cnt);
+  }
+  if (read_cnt < 0)
+  {
+      // Play what could be decoded but do not cache a broken clip
+    clip.reset(new vector<float>(std::move(samples)));
+  }
+  else
+  {
+    clip = cache.add(filename, stamp, samples);
+  }
+  delete file_item;
+  file_item = 0;
+
+  return true;
+} /* CachedFileQueueItem::initialize */
+
+
+int CachedFileQueueItem::readSamples(float *samples, int len)
+{
+  if (file_item != 0)
+  {
+    return file_item->readSamples(samples, len);
+  }
+  int read_cnt = min(static_cast<size_t>(len), clip->size() - pos);
+  memcpy(samples, clip->data() + pos, read_cnt * sizeof(*samples));
+  pos += read_cnt;
+  return read_cnt;
+} /* CachedFileQueueItem::readSamples */
+
+
+void CachedFileQueueItem::unreadSamples(int len)
+{
+  if (file_item != 0)
+  {
+    file_item->unreadSamples(len);
+    return;
+  }
+  pos -= len;
+} /* CachedFileQueueItem::unreadSamples */
+
+
+
 /*
  * This file has not been truncated
  */
@@ -70,6 +70,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 class QueueItem;
+class MsgCache;
 
 
 
@@ -123,6 +124,24 @@ This class handles the playback of audio clips.
 class MsgHandler : public sigc::trackable, public Async::AudioSource
 {
   public:
+    /**
+     * @brief   Set the size of the audio clip cache
+     * @param   max_size The maximum size of the cache in bytes
+     *
+     * The decoded samples of played files are kept in a cache that is
+     * shared by all message handlers. Setting the size to 0 disable the
+     * cache so that the files are read from disk each time they are played.
+     */
+    static void setCacheSize(size_t max_size);
+
+    /**
+     * @brief   Get the audio clip cache
+     * @return  Returns the cache shared by all message handlers
+     *
+     * Use this function to read the cache statistics.
+     */
+    static const MsgCache& cache(void);
+
     /**
      * @brief 	Default constuctor
      * @param	sample_rate The sample rate of the playback system
@@ -42,6 +42,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <sstream>
 
 
 /****************************************************************************
@@ -50,6 +51,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncApplication.h>
 #include <AsyncAudioSelector.h>
 #include <AsyncAudioRecorder.h>
 #include <AsyncConfig.h>
@@ -97,9 +99,9 @@ using namespace Async;
 class QsoRecorder::FileEncoder : public Exec
 {
   public:
-    string basename;
-    FileEncoder(const char *shell, string basename)
-      : Exec(shell), basename(basename)
+    string filename;
+    FileEncoder(const char *shell, string filename)
+      : Exec(shell), filename(filename)
     {}
 };
 
@@ -142,7 +144,7 @@ namespace {
 QsoRecorder::QsoRecorder(Logic *logic)
   : recorder(0), hard_chunk_limit(0), soft_chunk_limit(0), max_dirsize(0),
     default_active(false), tmo_timer(0), logic(logic), qso_tmo_timer(0),
-    min_samples(0)
+    min_samples(0), file_ext("wav"), write_buffer_time(0), file_seq(0)
 {
   selector = new AudioSelector;
 } /* QsoRecorder::QsoRecorder */
@@ -151,6 +153,16 @@ QsoRecorder::QsoRecorder(Logic *logic)
 QsoRecorder::~QsoRecorder(void)
 {
   setEnabled(false);
+
+    // Wait for the files that are still being written in the background
+  while (!closing_recorders.empty())
+  {
+    AudioRecorder *rec = *closing_recorders.begin();
+    closing_recorders.erase(closing_recorders.begin());
+    rec->waitClosed();
+    delete rec;
+  }
+
   delete selector;
   delete tmo_timer;
   delete qso_tmo_timer;
@@ -165,6 +177,22 @@ bool QsoRecorder::initialize(const Config &cfg, const string &name)
     return false;
   }
 
+  string file_format("WAV");
+  cfg.getValue(name, "FILE_FORMAT", file_format);
+  if (file_format == "OPUS")
+  {
+    file_ext = "opus";
+  }
+  else if (file_format != "WAV")
+  {
+    cerr << "*** ERROR: Illegal value for config variable " << name
+         << "/FILE_FORMAT: " << file_format << ". Valid values are WAV and "
+         << "OPUS.\n";
+    return false;
+  }
+
+  cfg.getValue(name, "WRITE_BUFFER_TIME", write_buffer_time);
+
   unsigned max_time = 0;
   cfg.getValue(name, "MAX_TIME", max_time);
   unsigned soft_time = 0;
@@ -277,15 +305,22 @@ void QsoRecorder::openFile(void)
 {
   if (recorder == 0)
   {
-    string filename(rec_dir);
-    filename += "/.qsorec_";
-    filename += logic->name();
-    filename += ".wav";
+      // Each file get its own temporary name since the previous file may
+      // still be written in the background when the next one is opened
+    ostringstream ss;
+    ss << rec_dir << "/.qsorec_" << logic->name() << "_" << file_seq++
+       << "." << file_ext;
+    string filename(ss.str());
     recorder = new AudioRecorder(filename);
+    recorder->setWriteBufferTime(write_buffer_time);
     recorder->setMaxRecordingTime(hard_chunk_limit, soft_chunk_limit);
     recorder->maxRecordingTimeReached.connect(
         mem_fun(*this, &QsoRecorder::openNewFile));
-    recorder->errorOccurred.connect(mem_fun(*this, &QsoRecorder::onError));
+    recorder->errorOccurred.connect(
+        sigc::bind(mem_fun(*this, &QsoRecorder::onError), recorder));
+    recorder->fileClosed.connect(
+        sigc::bind(mem_fun(*this, &QsoRecorder::onFileClosed),
+                   recorder, filename));
     selector->registerSink(recorder, true);
     if (!recorder->initialize())
     {
@@ -301,82 +336,20 @@ void QsoRecorder::closeFile(void)
 {
   if (recorder != 0)
   {
-    string oldpath(rec_dir + "/.qsorec_" + logic->name() + ".wav");
-
-    if (!recorder->closeFile())
-    {
-      cerr << "*** ERROR: Failed to close QsoRecorder file \"" << oldpath
-           << "\" in logic " << logic->name() << ": " << recorder->errorMsg()
-           << endl;
-    }
-
-    if (recorder->samplesWritten() > min_samples)
+    AudioRecorder *rec = recorder;
+    recorder = 0;
+    rec->unregisterSource();
+    rec->closeFile();
+    if (rec->isClosing())
     {
-      string basename("qsorec_" + logic->name() + "_");
-
-      const struct timeval &begin_time = recorder->beginTimestamp();
-      struct tm tm;
-      localtime_r(&begin_time.tv_sec, &tm);
-      char timestamp[256];
-      strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H%M%S", &tm);
-      basename += timestamp;
-
-      basename += "_";
-
-      const struct timeval &end_time = recorder->endTimestamp();
-      localtime_r(&end_time.tv_sec, &tm);
-      strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H%M%S", &tm);
-      basename += timestamp;
-      string newpath = rec_dir + "/" + basename + ".wav";
-      if (rename(oldpath.c_str(), newpath.c_str()) != 0)
-      {
-        perror("QsoRecorder rename");
-      }
-
-      cout << logic->name() << ": Wrote QSO recorder file "
-           << basename << ".wav\n";
-
-        // Execute external audio file handler (e.g. encoder) if configured
-      if (!encoder_cmd.empty())
-      {
-        cout << logic->name() << ": Starting encoding for file "
-             << basename << ".wav\n";
-        const char *shell = getenv("SHELL");
-        if (shell == NULL)
-        {
-          shell = "/bin/sh";
-        }
-        FileEncoder *enc = new FileEncoder(shell, basename);
-        enc->appendArgument("-c");
-        string cmdline(encoder_cmd);
-        replace_all(cmdline, "%f", newpath);
-        replace_all(cmdline, "%d", rec_dir);
-        replace_all(cmdline, "%b", basename);
-        replace_all(cmdline, "%n", basename + ".wav");
-        enc->appendArgument(cmdline);
-        enc->stdoutData.connect(
-            mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
-        enc->stderrData.connect(
-            mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
-        enc->exited.connect(
-            sigc::bind(mem_fun(*this, &QsoRecorder::encoderExited), enc));
-        enc->nice();
-        enc->setTimeout(60*60); // One hour timeout
-        enc->run();
-      }
+        // The file is finished in the background. The recorder is deleted
+        // when it report that the file is complete.
+      closing_recorders.insert(rec);
     }
     else
     {
-      if (unlink(oldpath.c_str()) != 0)
-      {
-        perror("QsoRecorder unlink");
-      }
+      delete rec;
     }
-
-    delete recorder;
-    recorder = 0;
-
-    cleanupDirectory();
   }
 } /* QsoRecorder::closeFile */
 
@@ -465,7 +438,7 @@ void QsoRecorder::handleEncoderPrintouts(const char *buf, int cnt)
 void QsoRecorder::encoderExited(QsoRecorder::FileEncoder *enc)
 {
   cout << logic->name() << ": Encoding done for file "
-             << enc->basename << ".wav\n";
+             << enc->filename << "\n";
   if (enc->ifExited() && (enc->exitStatus() != 0))
   {
     cerr << "*** ERROR: QSO recorder external audio file handler in logic "
@@ -482,13 +455,105 @@ void QsoRecorder::encoderExited(QsoRecorder::FileEncoder *enc)
 } /* QsoRecorder::encoderExited */
 
 
-void QsoRecorder::onError(void)
+void QsoRecorder::onError(AudioRecorder *rec)
 {
   cerr << "*** ERROR: The QsoRecorder in logic " << logic->name() 
-       << " failed: " << recorder->errorMsg() << endl;
+       << " failed: " << rec->errorMsg() << endl;
 } /* QsoRecorder::onError */
 
 
+void QsoRecorder::onFileClosed(bool success, AudioRecorder *rec,
+                               string tmp_path)
+{
+  if (!success)
+  {
+    cerr << "*** ERROR: Failed to close QsoRecorder file \"" << tmp_path
+         << "\" in logic " << logic->name() << ": " << rec->errorMsg()
+         << endl;
+  }
+  if (rec->droppedBlocks() > 0)
+  {
+    cerr << "*** WARNING: The QsoRecorder in logic " << logic->name()
+         << " could not write to disk fast enough. "
+         << rec->droppedBlocks() << " audio blocks were dropped "
+         << "(max write queue depth " << rec->maxWriteQueueDepth()
+         << " blocks). Consider increasing WRITE_BUFFER_TIME.\n";
+  }
+
+  if (rec->samplesWritten() > min_samples)
+  {
+    string basename("qsorec_" + logic->name() + "_");
+
+    const struct timeval &begin_time = rec->beginTimestamp();
+    struct tm tm;
+    localtime_r(&begin_time.tv_sec, &tm);
+    char timestamp[256];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H%M%S", &tm);
+    basename += timestamp;
+
+    basename += "_";
+
+    const struct timeval &end_time = rec->endTimestamp();
+    localtime_r(&end_time.tv_sec, &tm);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H%M%S", &tm);
+    basename += timestamp;
+    string filename = basename + "." + file_ext;
+    string newpath = rec_dir + "/" + filename;
+    if (rename(tmp_path.c_str(), newpath.c_str()) != 0)
+    {
+      perror("QsoRecorder rename");
+    }
+
+    cout << logic->name() << ": Wrote QSO recorder file "
+         << filename << "\n";
+
+      // Execute external audio file handler (e.g. encoder) if configured
+    if (!encoder_cmd.empty())
+    {
+      cout << logic->name() << ": Starting encoding for file "
+           << filename << "\n";
+      const char *shell = getenv("SHELL");
+      if (shell == NULL)
+      {
+        shell = "/bin/sh";
+      }
+      FileEncoder *enc = new FileEncoder(shell, filename);
+      enc->appendArgument("-c");
+      string cmdline(encoder_cmd);
+      replace_all(cmdline, "%f", newpath);
+      replace_all(cmdline, "%d", rec_dir);
+      replace_all(cmdline, "%b", basename);
+      replace_all(cmdline, "%n", filename);
+      enc->appendArgument(cmdline);
+      enc->stdoutData.connect(
+          mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
+      enc->stderrData.connect(
+          mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
+      enc->exited.connect(
+          sigc::bind(mem_fun(*this, &QsoRecorder::encoderExited), enc));
+      enc->nice();
+      enc->setTimeout(60*60); // One hour timeout
+      enc->run();
+    }
+  }
+  else
+  {
+    if (unlink(tmp_path.c_str()) != 0)
+    {
+      perror("QsoRecorder unlink");
+    }
+  }
+
+  cleanupDirectory();
+
+    // The recorder is emitting the signal so it is deleted later
+  if (closing_recorders.erase(rec) > 0)
+  {
+    Application::app().runTask([rec]() { delete rec; });
+  }
+} /* QsoRecorder::onFileClosed */
+
+
 
 /****************************************************************************
  *
@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <string>
+#include <set>
 
 
 /****************************************************************************
@@ -191,6 +192,10 @@ class QsoRecorder
     Async::Timer          *qso_tmo_timer;
     unsigned              min_samples;
     std::string           encoder_cmd;
+    std::string           file_ext;
+    unsigned              write_buffer_time;
+    unsigned              file_seq;
+    std::set<Async::AudioRecorder*> closing_recorders;
 
     QsoRecorder(const QsoRecorder&);
     QsoRecorder& operator=(const QsoRecorder&);
@@ -202,7 +207,9 @@ class QsoRecorder
     void checkTimeoutTimers(void);
     void handleEncoderPrintouts(const char *buf, int cnt);
     void encoderExited(FileEncoder *enc);
-    void onError(void);
+    void onError(Async::AudioRecorder *rec);
+    void onFileClosed(bool success, Async::AudioRecorder *rec,
+                      std::string tmp_path);
 
 };  /* class QsoRecorder */
 
@@ -2020,16 +2020,17 @@ void ReflectorLogic::sendMsg(const ReflectorMsg& msg)
 
   m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
 
-  ostringstream ss;
   ReflectorMsg header(msg.type());
-  if (!header.pack(ss) || !msg.pack(ss))
+  std::vector<uint8_t> buf(header.packedSize() + msg.packedSize());
+  Async::MsgBufWriter w(buf.data(), buf.size());
+  if (!header.pack(w) || !msg.pack(w))
   {
     std::cerr << "*** ERROR[" << name()
               << "]: Failed to pack reflector TCP message" << std::endl;
     disconnect();
     return;
   }
-  if (m_con.write(ss.str().data(), ss.str().size()) == -1)
+  if (m_con.write(buf.data(), buf.size()) == -1)
   {
     std::cerr << "*** ERROR[" << name()
               << "]: Failed to write message to network connection"
@@ -2075,9 +2076,8 @@ bool ReflectorLogic::udpCipherDataReceived(const IpAddress& addr, uint16_t port,
     //             "short to hold associated data" << std::endl;
     return true;
   }
-  stringstream ss;
-  ss.write(reinterpret_cast<const char *>(buf), UdpCipher::AADLEN);
-  if (!m_aad.unpack(ss))
+  Async::MsgBufReader aadrd(buf, UdpCipher::AADLEN);
+  if (!m_aad.unpack(aadrd))
   {
     std::cerr << "*** WARNING: Unpacking associated data failed for UDP "
                  "datagram from " << addr << ":" << port << std::endl;
@@ -2120,11 +2120,10 @@ void ReflectorLogic::udpDatagramReceived(const IpAddress& addr, uint16_t port,
     return;
   }
 
-  stringstream ss;
-  ss.write(reinterpret_cast<const char *>(buf), count);
+  Async::MsgBufReader rd(buf, count);
 
   ReflectorUdpMsg header;
-  if (!header.unpack(ss))
+  if (!header.unpack(rd))
   {
     cerr << "*** WARNING[" << name()
          << "]: Unpacking failed for UDP message header" << endl;
@@ -2194,7 +2193,7 @@ void ReflectorLogic::udpDatagramReceived(const IpAddress& addr, uint16_t port,
     case MsgUdpAudio::TYPE:
     {
       MsgUdpAudio msg;
-      if (!msg.unpack(ss))
+      if (!msg.unpack(rd))
       {
         std::cerr << "*** WARNING[" << name()
                   << "]: Could not unpack MsgUdpAudio" << std::endl;
@@ -2240,8 +2239,9 @@ void ReflectorLogic::sendUdpMsg(const UdpCipher::AAD& aad,
   }
 
   ReflectorUdpMsg header(msg.type());
-  ostringstream ss;
-  if (!header.pack(ss) || !msg.pack(ss))
+  m_udp_tx_buf.resize(header.packedSize() + msg.packedSize());
+  Async::MsgBufWriter w(m_udp_tx_buf.data(), m_udp_tx_buf.size());
+  if (!header.pack(w) || !msg.pack(w))
   {
     std::cerr << "*** ERROR[" << name()
               << "]: Failed to pack reflector UDP message" << std::endl;
@@ -2249,8 +2249,9 @@ void ReflectorLogic::sendUdpMsg(const UdpCipher::AAD& aad,
   }
   m_udp_sock->setCipherIV(UdpCipher::IV{m_udp_cipher_iv_rand, m_client_id,
                                         aad.iv_cntr});
-  std::ostringstream adss;
-  if (!aad.pack(adss))
+  uint8_t aad_buf[UdpCipher::AADLEN + sizeof(UdpCipher::ClientId)];
+  Async::MsgBufWriter aadw(aad_buf, sizeof(aad_buf));
+  if (!aad.pack(aadw))
   {
     std::cerr << "*** WARNING: Packing associated data failed for UDP "
                  "datagram to " << m_con.remoteHost() << ":"
@@ -2258,8 +2259,7 @@ void ReflectorLogic::sendUdpMsg(const UdpCipher::AAD& aad,
     return;
   }
   m_udp_sock->write(m_con.remoteHost(), m_con.remotePort(),
-                    adss.str().data(), adss.str().size(),
-                    ss.str().data(), ss.str().size());
+                    aad_buf, aadw.size(), m_udp_tx_buf.data(), w.size());
 } /* ReflectorLogic::sendUdpMsg */
 
 
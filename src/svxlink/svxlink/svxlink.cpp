@@ -58,6 +58,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncTimer.h>
 #include <AsyncFdWatch.h>
 #include <AsyncAudioIO.h>
+#include <AsyncAudioPolyphaseResampler.h>
 #include <LocationInfo.h>
 #include <common.h>
 #include <config.h>
@@ -73,6 +74,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "version/SVXLINK.h"
 #include "Logic.h"
 #include "LinkManager.h"
+#include "MsgHandler.h"
+#include "MsgCache.h"
 
 
 /****************************************************************************
@@ -402,6 +405,20 @@ int main(int argc, char **argv)
       AudioIO::setBlockCount(2);
     }
     #endif
+    else if ((rate > 8000) &&
+             AudioPolyphaseResampler::isSupported(rate, 16000))
+    {
+      if (rate > 16000)
+      {
+        AudioIO::setBlocksize(1024);
+        AudioIO::setBlockCount(4);
+      }
+      else
+      {
+        AudioIO::setBlocksize(512);
+        AudioIO::setBlockCount(2);
+      }
+    }
     else
     {
       cerr << "*** ERROR: Illegal sound card sample rate specified for "
@@ -409,7 +426,8 @@ int main(int argc, char **argv)
 	      #if INTERNAL_SAMPLE_RATE <= 8000
 	      "8000, "
 	      #endif
-	      "16000 and 48000\n";
+	      "16000, 48000 and other rates above 8000 that can be "
+	      "converted to 16000 (e.g. 22050, 32000, 44100 or 96000)\n";
       exit(1);
     }
     AudioIO::setSampleRate(rate);
@@ -443,6 +461,12 @@ int main(int argc, char **argv)
     }
   }
 
+  unsigned msg_cache_size = 0;
+  if (cfg.getValue("GLOBAL", "MSG_CACHE_SIZE", msg_cache_size))
+  {
+    MsgHandler::setCacheSize(static_cast<size_t>(msg_cache_size) * 1024 * 1024);
+  }
+
   initialize_logics(cfg);
 
   if (LinkManager::hasInstance())
@@ -475,6 +499,17 @@ int main(int argc, char **argv)
             << std::endl;
   app.exec();
 
+  const MsgCache &msg_cache = MsgHandler::cache();
+  const uint64_t msg_lookups = msg_cache.hits() + msg_cache.misses();
+  if (msg_lookups > 0)
+  {
+    cout << "Message cache: hits=" << msg_cache.hits()
+         << " misses=" << msg_cache.misses()
+         << " hit_rate=" << (100 * msg_cache.hits() / msg_lookups) << "%"
+         << " clips=" << msg_cache.clipCount()
+         << " bytes=" << msg_cache.size() << endl;
+  }
+
   LinkManager::deleteInstance();
   LocationInfo::deleteInstance();
 
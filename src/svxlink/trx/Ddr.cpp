@@ -50,6 +50,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <algorithm>
 #include <iterator>
 #include <deque>
+#include <mutex>
+#include <atomic>
 
 
 /****************************************************************************
@@ -72,6 +74,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Ddr.h"
 #include "WbRxRtlSdr.h"
 #include "DdrFilterCoeffs.h"
+#include "FirDecimator.h"
+#include "SpscRing.h"
 
 
 /****************************************************************************
@@ -101,90 +105,6 @@ using namespace Async;
  ****************************************************************************/
 
 namespace {
-  template <class T>
-  class Decimator
-  {
-    public:
-      Decimator(void) : dec_fact(0), p_Z(0), taps(0) {}
-
-      Decimator(int dec_fact, const float *coeff, int taps)
-        : dec_fact(dec_fact), p_Z(0), taps(taps)
-      {
-        setDecimatorParams(dec_fact, coeff, taps);
-      }
-
-      ~Decimator(void)
-      {
-        delete [] p_Z;
-      }
-
-      int decFact(void) const { return dec_fact; }
-
-      void setDecimatorParams(int dec_fact, const float *coeff, int taps)
-      {
-        assert(taps >= dec_fact);
-
-        set_coeff.assign(coeff, coeff + taps);
-        this->dec_fact = dec_fact;
-        this->coeff = set_coeff;
-        this->taps = taps;
-
-        delete [] p_Z;
-        p_Z = new T[taps]();
-      }
-
-      void setGain(double gain_adjust)
-      {
-        coeff = set_coeff;
-        for (vector<float>::iterator it=coeff.begin(); it!=coeff.end(); ++it)
-        {
-          *it *= pow(10.0, gain_adjust / 20.0);
-        }
-      }
-
-      void decimate(vector<T> &out, const vector<T> &in)
-      {
-        int orig_count = in.size();
-
-          // this implementation assumes in.size() is a multiple of factor_M
-        assert(in.size() % dec_fact == 0);
-
-        int num_out = 0;
-        typename vector<T>::const_iterator src = in.begin();
-        out.clear();
-        out.reserve(in.size() / dec_fact);
-        while (src != in.end())
-        {
-            // shift Z delay line up to make room for next samples
-          memmove(p_Z + dec_fact, p_Z, (taps - dec_fact) * sizeof(T));
-
-            // copy next samples from input buffer to bottom of Z delay line
-          for (int tap = dec_fact - 1; tap >= 0; tap--)
-          {
-            assert(src != in.end());
-            p_Z[tap] = *src++;
-          }
-
-            // calculate FIR sum
-          T sum(0);
-          for (int tap = 0; tap < taps; tap++)
-          {
-            sum += coeff[tap] * p_Z[tap];
-          }
-          out.push_back(sum);     /* store sum */
-          num_out++;
-        }
-        assert(num_out == orig_count / dec_fact);
-      }
-
-    private:
-      int             dec_fact;
-      T               *p_Z;
-      int             taps;
-      vector<float>   set_coeff;
-      vector<float>   coeff;
-  };
-
   template <class T>
   class DecimatorMS
   {
@@ -223,7 +143,7 @@ namespace {
   class DecimatorMS1 : public DecimatorMS<T>
   {
     public:
-      DecimatorMS1(Decimator<T> &d1) : d1(d1) {}
+      DecimatorMS1(FirDecimator<T> &d1) : d1(d1) {}
       virtual void setGain(float gain_db) { d1.setGain(gain_db); }
       virtual int decFact(void) const { return d1.decFact(); }
       virtual void decimate(vector<T> &out, const vector<T> &in)
@@ -232,32 +152,34 @@ namespace {
       }
 
     private:
-      Decimator<T> &d1;
+      FirDecimator<T> &d1;
   };
 
   template <class T>
   class DecimatorMS2 : public DecimatorMS<T>
   {
     public:
-      DecimatorMS2(Decimator<T> &d1, Decimator<T> &d2) : d1(d1), d2(d2) {}
+      DecimatorMS2(FirDecimator<T> &d1, FirDecimator<T> &d2)
+        : d1(d1), d2(d2) {}
       virtual void setGain(float gain_db) { d2.setGain(gain_db); }
       virtual int decFact(void) const { return d1.decFact() * d2.decFact(); }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1;
         d1.decimate(dec_samp1, in);
         d2.decimate(out, dec_samp1);
       }
 
     private:
-      Decimator<T> &d1, &d2;
+      FirDecimator<T> &d1, &d2;
+      vector<T> dec_samp1;
   };
 
   template <class T>
   class DecimatorMS3 : public DecimatorMS<T>
   {
     public:
-      DecimatorMS3(Decimator<T> &d1, Decimator<T> &d2, Decimator<T> &d3)
+      DecimatorMS3(FirDecimator<T> &d1, FirDecimator<T> &d2,
+                   FirDecimator<T> &d3)
         : d1(d1), d2(d2), d3(d3) {}
       virtual void setGain(float gain_db) { d3.setGain(gain_db); }
       virtual int decFact(void) const
@@ -266,22 +188,22 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(out, dec_samp2);
       }
 
     private:
-      Decimator<T> &d1, &d2, &d3;
+      FirDecimator<T> &d1, &d2, &d3;
+      vector<T> dec_samp1, dec_samp2;
   };
 
   template <class T>
   class DecimatorMS4 : public DecimatorMS<T>
   {
     public:
-      DecimatorMS4(Decimator<T> &d1, Decimator<T> &d2, Decimator<T> &d3,
-                   Decimator<T> &d4)
+      DecimatorMS4(FirDecimator<T> &d1, FirDecimator<T> &d2,
+                   FirDecimator<T> &d3, FirDecimator<T> &d4)
         : d1(d1), d2(d2), d3(d3), d4(d4) {}
       virtual void setGain(float gain_db) { d4.setGain(gain_db); }
       virtual int decFact(void) const
@@ -290,7 +212,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2, dec_samp3;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(dec_samp3, dec_samp2);
@@ -298,15 +219,17 @@ namespace {
       }
 
     private:
-      Decimator<T> &d1, &d2, &d3, &d4;
+      FirDecimator<T> &d1, &d2, &d3, &d4;
+      vector<T> dec_samp1, dec_samp2, dec_samp3;
   };
 
   template <class T>
   class DecimatorMS5 : public DecimatorMS<T>
   {
     public:
-      DecimatorMS5(Decimator<T> &d1, Decimator<T> &d2, Decimator<T> &d3,
-                   Decimator<T> &d4, Decimator<T> &d5)
+      DecimatorMS5(FirDecimator<T> &d1, FirDecimator<T> &d2,
+                   FirDecimator<T> &d3, FirDecimator<T> &d4,
+                   FirDecimator<T> &d5)
         : d1(d1), d2(d2), d3(d3), d4(d4), d5(d5) {}
       virtual void setGain(float gain_db) { d5.setGain(gain_db); }
       virtual int decFact(void) const
@@ -316,7 +239,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2, dec_samp3, dec_samp4;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(dec_samp3, dec_samp2);
@@ -325,7 +247,8 @@ namespace {
       }
 
     private:
-      Decimator<T> &d1, &d2, &d3, &d4, &d5;
+      FirDecimator<T> &d1, &d2, &d3, &d4, &d5;
+      vector<T> dec_samp1, dec_samp2, dec_samp3, dec_samp4;
   };
 
 
@@ -356,8 +279,16 @@ namespace {
         }
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> &out,
-                       const vector<WbRxRtlSdr::Sample> &in)
+      /**
+       * @brief Translate a block of samples
+       * @param out A buffer to store the translated samples in
+       * @param in The samples to translate
+       * @return Returns the out buffer or, if the offset is zero, the in
+       *         vector to avoid a copy
+       */
+      const vector<WbRxRtlSdr::Sample>& iq_received(
+          vector<WbRxRtlSdr::Sample> &out,
+          const vector<WbRxRtlSdr::Sample> &in)
       {
         if (exp_lut.size() > 0)
         {
@@ -372,11 +303,9 @@ namespace {
               n = 0;
             }
           }
+          return out;
         }
-        else
-        {
-          out = in;
-        }
+        return in;
       }
 
     private:
@@ -471,9 +400,16 @@ namespace {
   class Demodulator : public Async::AudioSource
   {
     public:
+      Demodulator(void) : audio_out(0) {}
       virtual ~Demodulator(void) {}
 
-      virtual void iq_received(vector<WbRxRtlSdr::Sample> samples) = 0;
+      virtual void iq_received(const vector<WbRxRtlSdr::Sample> &samples) = 0;
+
+      /**
+       * @brief Write the audio to a buffer instead of the registered sink
+       * @param out The buffer to append the audio to or 0 to use the sink
+       */
+      void setAudioOutput(vector<float> *out) { audio_out = out; }
 
       /**
        * @brief Resume audio output to the sink
@@ -496,6 +432,21 @@ namespace {
        * This function is normally only called from a connected sink object.
        */
       virtual void allSamplesFlushed(void) { }
+
+      void writeAudio(const float *samples, int count)
+      {
+        if (audio_out != 0)
+        {
+          audio_out->insert(audio_out->end(), samples, samples + count);
+        }
+        else
+        {
+          sinkWriteSamples(samples, count);
+        }
+      }
+
+    private:
+      vector<float> *audio_out;
   };
 
 
@@ -553,7 +504,7 @@ namespace {
         dec->setGain(adj_db);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
           // From article-sdr-is-qs.pdf: Watch your Is and Qs:
           //   FM = (Qn.In-1 - In.Qn-1)/(In.In-1 + Qn.Qn-1)
@@ -561,7 +512,7 @@ namespace {
           // A more indepth report:
           //   Implementation of FM demodulator algorithms on a
           //   high performance digital signal processor
-        vector<float> audio;
+        audio.clear();
         for (size_t idx=0; idx<samples.size(); ++idx)
         {
           complex<float> samp = samples[idx];
@@ -578,17 +529,18 @@ namespace {
 
           audio.push_back(demod);
         }
-        vector<float> dec_audio;
         dec->decimate(dec_audio, audio);
-        sinkWriteSamples(&dec_audio[0], dec_audio.size());
+        writeAudio(&dec_audio[0], dec_audio.size());
       }
 
     private:
       float iold;
       float qold;
-      Decimator<float> audio_dec_wb;
-      Decimator<float> audio_dec;
+      FirDecimator<float> audio_dec_wb;
+      FirDecimator<float> audio_dec;
       DecimatorMS<float> *dec;
+      vector<float> audio;
+      vector<float> dec_audio;
   };
 
 
@@ -602,23 +554,24 @@ namespace {
         agc.setReference(1);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
 
-        vector<float> audio;
+        audio.clear();
         for (size_t idx=0; idx<gain_adjusted.size(); ++idx)
         {
           complex<float> samp = gain_adjusted[idx];
           float demod = abs(samp);
           audio.push_back(demod);
         }
-        sinkWriteSamples(&audio[0], audio.size());
+        writeAudio(&audio[0], audio.size());
       }
 
     private:
       AGC              agc;
+      vector<WbRxRtlSdr::Sample> gain_adjusted;
+      vector<float>    audio;
   };
 
 
@@ -639,9 +592,9 @@ namespace {
         use_lsb = use;
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<float> Q, Qh, audio;
+        Q.clear();
         Q.reserve(samples.size());
         for (vector<WbRxRtlSdr::Sample>::const_iterator it = samples.begin();
              it != samples.end();
@@ -651,6 +604,7 @@ namespace {
           Q.push_back(it->imag());
         }
         hilbert.decimate(Qh, Q);
+        audio.clear();
         audio.reserve(Qh.size());
         for (size_t idx=0; idx<Qh.size(); ++idx)
         {
@@ -666,13 +620,14 @@ namespace {
           audio.push_back(demod);
         }
         I.erase(I.begin(), I.begin() + Qh.size());
-        sinkWriteSamples(&audio[0], audio.size());
+        writeAudio(&audio[0], audio.size());
       }
 
     private:
       deque<float>      I;
-      Decimator<float>  hilbert;
+      FirDecimator<float> hilbert;
       bool              use_lsb;
+      vector<float>     Q, Qh, audio;
   };
 
 #else
@@ -690,16 +645,13 @@ namespace {
         trans.setOffset(lsb ? 2000 : -2000);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
-
-        vector<WbRxRtlSdr::Sample> translated;
         trans.iq_received(translated, gain_adjusted);
 
-        vector<float> audio;
-        audio.reserve(gain_adjusted.size());
+        audio.clear();
+        audio.reserve(translated.size());
         for (vector<WbRxRtlSdr::Sample>::const_iterator it = translated.begin();
              it != translated.end();
              ++it)
@@ -707,12 +659,15 @@ namespace {
           float demod = it->real();
           audio.push_back(demod);
         }
-        sinkWriteSamples(&audio[0], audio.size());
+        writeAudio(&audio[0], audio.size());
       }
 
     private:
       Translate         trans;
       AGC               agc;
+      vector<WbRxRtlSdr::Sample> gain_adjusted;
+      vector<WbRxRtlSdr::Sample> translated;
+      vector<float>     audio;
   };
 #endif
 
@@ -728,14 +683,12 @@ namespace {
         agc.setReference(0.05);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
-
-        vector<WbRxRtlSdr::Sample> translated;
         trans.iq_received(translated, gain_adjusted);
-        vector<float> audio;
+
+        audio.clear();
         audio.reserve(translated.size());
         for (vector<WbRxRtlSdr::Sample>::const_iterator it = translated.begin();
              it != translated.end();
@@ -744,12 +697,15 @@ namespace {
           float demod = it->real();
           audio.push_back(demod);
         }
-        sinkWriteSamples(&audio[0], audio.size());
+        writeAudio(&audio[0], audio.size());
       }
 
     private:
       Translate         trans;
       AGC               agc;
+      vector<WbRxRtlSdr::Sample> gain_adjusted;
+      vector<WbRxRtlSdr::Sample> translated;
+      vector<float>     audio;
   };
 
 
@@ -850,16 +806,16 @@ namespace {
       }
 
     private:
-      Decimator<complex<float> >    dec_960k_192k;
-      Decimator<complex<float> >    dec_192k_64k;
-      Decimator<complex<float> >    dec_64k_32k;
-      Decimator<complex<float> >    dec_192k_48k;
-      Decimator<complex<float> >    dec_48k_16k;
-      Decimator<complex<float> >    ch_filt;
-      Decimator<complex<float> >    ch_filt_narr;
-      Decimator<complex<float> >    ch_filt_6k;
-      Decimator<complex<float> >    ch_filt_3k;
-      Decimator<complex<float> >    ch_filt_500;
+      FirDecimator<complex<float> >    dec_960k_192k;
+      FirDecimator<complex<float> >    dec_192k_64k;
+      FirDecimator<complex<float> >    dec_64k_32k;
+      FirDecimator<complex<float> >    dec_192k_48k;
+      FirDecimator<complex<float> >    dec_48k_16k;
+      FirDecimator<complex<float> >    ch_filt;
+      FirDecimator<complex<float> >    ch_filt_narr;
+      FirDecimator<complex<float> >    ch_filt_6k;
+      FirDecimator<complex<float> >    ch_filt_3k;
+      FirDecimator<complex<float> >    ch_filt_500;
       DecimatorMS<complex<float> >  *dec;
   };
 
@@ -948,15 +904,192 @@ namespace {
       }
 
     private:
-      Decimator<complex<float> >    dec_2400k_800k;
-      Decimator<complex<float> >    dec_800k_160k;
-      Decimator<complex<float> >    dec_160k_32k;
-      Decimator<complex<float> >    dec_32k_16k;
-      Decimator<complex<float> >    ch_filt;
-      Decimator<complex<float> >    ch_filt_narr;
-      Decimator<complex<float> >    ch_filt_6k;
-      Decimator<complex<float> >    ch_filt_3k;
-      Decimator<complex<float> >    ch_filt_500;
+      FirDecimator<complex<float> >    dec_2400k_800k;
+      FirDecimator<complex<float> >    dec_800k_160k;
+      FirDecimator<complex<float> >    dec_160k_32k;
+      FirDecimator<complex<float> >    dec_32k_16k;
+      FirDecimator<complex<float> >    ch_filt;
+      FirDecimator<complex<float> >    ch_filt_narr;
+      FirDecimator<complex<float> >    ch_filt_6k;
+      FirDecimator<complex<float> >    ch_filt_3k;
+      FirDecimator<complex<float> >    ch_filt_500;
+      DecimatorMS<complex<float> >  *dec;
+  };
+
+    /*
+     * Channelizer for the 192kHz filter bank channels from a 960kHz tuner.
+     * The chains are the same as in Channelizer960 without the first stage.
+     * Wideband mode is not supported since it need the whole 192kHz.
+     */
+  class Channelizer192 : public Channelizer
+  {
+    public:
+      Channelizer192(void)
+        : dec_192k_64k( 3, coeff_dec_192k_64k,  coeff_dec_192k_64k_cnt ),
+          dec_64k_32k(  2, coeff_dec_64k_32k,   coeff_dec_64k_32k_cnt  ),
+          dec_192k_48k( 4, coeff_dec_192k_48k,  coeff_dec_192k_48k_cnt ),
+          dec_48k_16k(  3, coeff_dec_48k_16k,   coeff_dec_48k_16k_cnt  ),
+          ch_filt(      1, coeff_25k_channel,   coeff_25k_channel_cnt  ),
+          ch_filt_narr( 1, coeff_12k5_channel,  coeff_12k5_channel_cnt ),
+          ch_filt_6k(   1, coeff_nbam_channel,  coeff_nbam_channel_cnt ),
+          ch_filt_3k(   1, coeff_ssb_channel,   coeff_ssb_channel_cnt  ),
+          ch_filt_500(  1, coeff_cw_channel,    coeff_cw_channel_cnt   ),
+          dec(0)
+      {
+        setBw(BW_20K);
+      }
+      virtual ~Channelizer192(void)
+      {
+        delete dec;
+        dec = 0;
+      }
+
+      virtual void setBw(Bandwidth bw)
+      {
+        delete dec;
+        dec = 0;
+        switch (bw)
+        {
+          case BW_WIDE:
+            dec = new DecimatorMS0<complex<float> >;
+            return;
+          case BW_20K:
+            dec = new DecimatorMS3<complex<float> >(dec_192k_64k,
+                                                    dec_64k_32k,
+                                                    ch_filt);
+            return;
+          case BW_10K:
+            dec = new DecimatorMS3<complex<float> >(dec_192k_48k,
+                                                    dec_48k_16k,
+                                                    ch_filt_narr);
+            return;
+          case BW_6K:
+            dec = new DecimatorMS3<complex<float> >(dec_192k_48k,
+                                                    dec_48k_16k,
+                                                    ch_filt_6k);
+            return;
+          case BW_3K:
+            dec = new DecimatorMS3<complex<float> >(dec_192k_48k,
+                                                    dec_48k_16k,
+                                                    ch_filt_3k);
+            return;
+          case BW_500:
+            dec = new DecimatorMS3<complex<float> >(dec_192k_48k,
+                                                    dec_48k_16k,
+                                                    ch_filt_500);
+            return;
+        }
+        assert(!"Channelizer::setBw: Unknown bandwidth");
+      }
+
+      virtual unsigned chSampRate(void) const
+      {
+        return 192000 / dec->decFact();
+      }
+
+      virtual void iq_received(vector<WbRxRtlSdr::Sample> &out,
+                               const vector<WbRxRtlSdr::Sample> &in)
+      {
+        dec->decimate(out, in);
+        preDemod(out);
+      }
+
+    private:
+      FirDecimator<complex<float> >    dec_192k_64k;
+      FirDecimator<complex<float> >    dec_64k_32k;
+      FirDecimator<complex<float> >    dec_192k_48k;
+      FirDecimator<complex<float> >    dec_48k_16k;
+      FirDecimator<complex<float> >    ch_filt;
+      FirDecimator<complex<float> >    ch_filt_narr;
+      FirDecimator<complex<float> >    ch_filt_6k;
+      FirDecimator<complex<float> >    ch_filt_3k;
+      FirDecimator<complex<float> >    ch_filt_500;
+      DecimatorMS<complex<float> >  *dec;
+  };
+
+    /*
+     * Channelizer for the 160kHz filter bank channels from a 2400kHz tuner.
+     * The chains are the same as in Channelizer2400 without the first two
+     * stages. Wideband mode is not supported.
+     */
+  class Channelizer160 : public Channelizer
+  {
+    public:
+      Channelizer160(void)
+        : dec_160k_32k  (5, coeff_dec_160k_32k,   coeff_dec_160k_32k_cnt  ),
+          dec_32k_16k   (2, coeff_dec_32k_16k,    coeff_dec_32k_16k_cnt   ),
+          ch_filt       (1, coeff_25k_channel,    coeff_25k_channel_cnt   ),
+          ch_filt_narr  (1, coeff_12k5_channel,   coeff_12k5_channel_cnt  ),
+          ch_filt_6k    (1, coeff_nbam_channel,   coeff_nbam_channel_cnt  ),
+          ch_filt_3k    (1, coeff_ssb_channel,    coeff_ssb_channel_cnt   ),
+          ch_filt_500   (1, coeff_cw_channel,     coeff_cw_channel_cnt    ),
+          dec(0)
+      {
+        setBw(BW_20K);
+      }
+      virtual ~Channelizer160(void)
+      {
+        delete dec;
+        dec = 0;
+      }
+
+      virtual void setBw(Bandwidth bw)
+      {
+        delete dec;
+        dec = 0;
+
+        switch (bw)
+        {
+          case BW_WIDE:
+            dec = new DecimatorMS0<complex<float> >;
+            return;
+          case BW_20K:
+            dec = new DecimatorMS2<complex<float> >(dec_160k_32k, ch_filt);
+            return;
+          case BW_10K:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_narr);
+            return;
+          case BW_6K:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_6k);
+            return;
+          case BW_3K:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_3k);
+            return;
+          case BW_500:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_500);
+            return;
+        }
+        assert(!"Channelizer::setBw: Unknown bandwidth");
+      }
+
+      virtual unsigned chSampRate(void) const
+      {
+        return 160000 / dec->decFact();
+      }
+
+      virtual void iq_received(vector<WbRxRtlSdr::Sample> &out,
+                               const vector<WbRxRtlSdr::Sample> &in)
+      {
+        dec->decimate(out, in);
+        preDemod(out);
+      }
+
+    private:
+      FirDecimator<complex<float> >    dec_160k_32k;
+      FirDecimator<complex<float> >    dec_32k_16k;
+      FirDecimator<complex<float> >    ch_filt;
+      FirDecimator<complex<float> >    ch_filt_narr;
+      FirDecimator<complex<float> >    ch_filt_6k;
+      FirDecimator<complex<float> >    ch_filt_3k;
+      FirDecimator<complex<float> >    ch_filt_500;
       DecimatorMS<complex<float> >  *dec;
   };
 
@@ -966,17 +1099,25 @@ namespace {
 class Ddr::Channel : public sigc::trackable, public Async::AudioSource
 {
   public:
-    Channel(int fq_offset, unsigned sample_rate)
-      : sample_rate(sample_rate), channelizer(0),
-        fm_demod(32000, 5000.0), ssb_demod(16000), cw_demod(16000), demod(0),
-        trans(sample_rate, fq_offset), enabled(true), ch_offset(0),
-        fq_offset(fq_offset)
+    Channel(WbRxRtlSdr *rtl, int fq_offset)
+      : rtl(rtl), sample_rate(rtl->sampleRate()), channelizer(0),
+        fb_channelizer(0), fm_demod(32000, 5000.0), ssb_demod(16000),
+        cw_demod(16000), demod(0), trans(sample_rate, fq_offset),
+        fb_trans(rtl->fbSampleRate(), 0), enabled(true),
+        ch_offset(0), fq_offset(fq_offset), bw(Channelizer::BW_20K),
+        dsp_out(16), cur_out(0), dsp_dropped(0)
     {
     }
 
     ~Channel(void)
     {
+      {
+        std::unique_lock<std::mutex> lock(rtl->dspLock());
+        iq_con.disconnect();
+        fb_con.disconnect();
+      }
       delete channelizer;
+      delete fb_channelizer;
     }
 
     bool initialize(void)
@@ -995,51 +1136,77 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
              << ". Legal values are: 960000 and 2400000\n";
         return false;
       }
+
+      if (rtl->fbSampleRate() == 192000)
+      {
+        fb_channelizer = new Channelizer192;
+      }
+      else if (rtl->fbSampleRate() == 160000)
+      {
+        fb_channelizer = new Channelizer160;
+      }
+
+        // With a DSP thread, the output is collected and passed to the main
+        // thread through a ring buffer
+      sigc::slot<void(const vector<WbRxRtlSdr::Sample>&)> pre_demod_slot =
+        preDemod.make_slot();
+      if (rtl->dspThreaded())
+      {
+        pre_demod_slot = mem_fun(*this, &Channel::collectPreDemod);
+        rtl->dspOutputReady.connect(mem_fun(*this, &Channel::dspOutputReady));
+      }
+      channelizer->preDemod.connect(pre_demod_slot);
+      if (fb_channelizer != 0)
+      {
+        fb_channelizer->preDemod.connect(pre_demod_slot);
+      }
+
       setModulation(Modulation::MOD_FM);
-      channelizer->preDemod.connect(preDemod.make_slot());
       return true;
     }
 
     void setFqOffset(int fq_offset)
     {
+      std::unique_lock<std::mutex> lock(rtl->dspLock());
       this->fq_offset = fq_offset;
-      trans.setOffset(fq_offset - ch_offset);
+      updateRouting();
     }
 
     void setModulation(Modulation::Type mod)
     {
+      std::unique_lock<std::mutex> lock(rtl->dspLock());
       demod = 0;
       ch_offset = 0;
       switch (mod)
       {
         case Modulation::MOD_FM:
-          channelizer->setBw(Channelizer::BW_20K);
+          setBw(Channelizer::BW_20K);
           fm_demod.setDemodParams(channelizer->chSampRate(), 5000);
           demod = &fm_demod;
           break;
         case Modulation::MOD_NBFM:
-          channelizer->setBw(Channelizer::BW_10K);
+          setBw(Channelizer::BW_10K);
           fm_demod.setDemodParams(channelizer->chSampRate(), 2500);
           demod = &fm_demod;
           break;
         case Modulation::MOD_WBFM:
-          channelizer->setBw(Channelizer::BW_WIDE);
+          setBw(Channelizer::BW_WIDE);
           fm_demod.setDemodParams(channelizer->chSampRate(), 75000);
           demod = &fm_demod;
           break;
         case Modulation::MOD_AM:
-          channelizer->setBw(Channelizer::BW_10K);
+          setBw(Channelizer::BW_10K);
           demod = &am_demod;
           break;
         case Modulation::MOD_NBAM:
-          channelizer->setBw(Channelizer::BW_6K);
+          setBw(Channelizer::BW_6K);
           demod = &am_demod;
           break;
         case Modulation::MOD_USB:
 #ifdef USE_SSB_PHASE_DEMOD
-          channelizer->setBw(Channelizer::BW_6K);
+          setBw(Channelizer::BW_6K);
 #else
-          channelizer->setBw(Channelizer::BW_3K);
+          setBw(Channelizer::BW_3K);
           ch_offset = -2000;
 #endif
           ssb_demod.useLsb(false);
@@ -1047,28 +1214,31 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
           break;
         case Modulation::MOD_LSB:
 #ifdef USE_SSB_PHASE_DEMOD
-          channelizer->setBw(Channelizer::BW_6K);
+          setBw(Channelizer::BW_6K);
 #else
-          channelizer->setBw(Channelizer::BW_3K);
+          setBw(Channelizer::BW_3K);
           ch_offset = 2000;
 #endif
           ssb_demod.useLsb(true);
           demod = &ssb_demod;
           break;
         case Modulation::MOD_CW:
-          channelizer->setBw(Channelizer::BW_500);
+          setBw(Channelizer::BW_500);
           demod = &cw_demod;
           break;
         case Modulation::MOD_WBCW:
-          channelizer->setBw(Channelizer::BW_3K);
+          setBw(Channelizer::BW_3K);
           demod = &cw_demod;
           break;
         case Modulation::MOD_UNKNOWN:
           break;
       }
-      setFqOffset(fq_offset);
+      updateRouting();
       assert((demod != 0) && "Channel::setModulation: Unknown modulation");
-      setHandler(demod);
+      if (!rtl->dspThreaded())
+      {
+        setHandler(demod);
+      }
     }
 
     unsigned chSampRate(void) const
@@ -1076,24 +1246,39 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
       return channelizer->chSampRate();
     }
 
-    void iq_received(vector<WbRxRtlSdr::Sample> samples)
+    void iq_received(const IqBlock &samples)
     {
       if (enabled)
       {
-        vector<WbRxRtlSdr::Sample> translated, channelized;
-        trans.iq_received(translated, samples);
-        channelizer->iq_received(channelized, translated);
+        beginOutput();
+        channelizer->iq_received(channelized,
+            trans.iq_received(translated, samples.samples()));
         demod->iq_received(channelized);
+        endOutput();
+      }
+    };
+
+    void fbIqReceived(const vector<WbRxRtlSdr::Sample> &samples)
+    {
+      if (enabled)
+      {
+        beginOutput();
+        fb_channelizer->iq_received(channelized,
+            fb_trans.iq_received(translated, samples));
+        demod->iq_received(channelized);
+        endOutput();
       }
     };
 
     void enable(void)
     {
+      std::unique_lock<std::mutex> lock(rtl->dspLock());
       enabled = true;
     }
 
     void disable(void)
     {
+      std::unique_lock<std::mutex> lock(rtl->dspLock());
       enabled = false;
     }
 
@@ -1102,17 +1287,146 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
     sigc::signal<void(const std::vector<RtlTcp::Sample>&)> preDemod;
 
   private:
+    WbRxRtlSdr *rtl;
     unsigned sample_rate;
     Channelizer *channelizer;
+    Channelizer *fb_channelizer;
     DemodulatorFm fm_demod;
     DemodulatorAm am_demod;
     DemodulatorSsb ssb_demod;
     DemodulatorCw cw_demod;
     Demodulator *demod;
     Translate trans;
+    Translate fb_trans;
     bool enabled;
     int ch_offset;
     int fq_offset;
+    Channelizer::Bandwidth bw;
+    sigc::connection iq_con;
+    sigc::connection fb_con;
+    vector<WbRxRtlSdr::Sample> translated;
+    vector<WbRxRtlSdr::Sample> channelized;
+
+      // The output of one block of samples when using a DSP thread
+    struct DspOutput
+    {
+      vector<WbRxRtlSdr::Sample>  pre_demod;
+      vector<float>               audio;
+    };
+    SpscRing<DspOutput> dsp_out;
+    DspOutput dsp_scratch;
+    DspOutput *cur_out;
+    std::atomic<unsigned> dsp_dropped;
+
+      /*
+       * With a DSP thread, the output for the block is collected in the next
+       * free slot of the ring buffer. If the main thread is not keeping up,
+       * the processing is still done to keep the filter states continuous
+       * but the output is thrown away.
+       */
+    void beginOutput(void)
+    {
+      if (!rtl->dspThreaded())
+      {
+        return;
+      }
+      cur_out = dsp_out.writeSlot();
+      if (cur_out == 0)
+      {
+        cur_out = &dsp_scratch;
+      }
+      cur_out->pre_demod.clear();
+      cur_out->audio.clear();
+      demod->setAudioOutput(&cur_out->audio);
+    }
+
+    void endOutput(void)
+    {
+      if (cur_out == 0)
+      {
+        return;
+      }
+      if (cur_out == &dsp_scratch)
+      {
+        dsp_dropped += 1;
+      }
+      else
+      {
+        dsp_out.commitWrite();
+        rtl->dspOutputWritten();
+      }
+      cur_out = 0;
+    }
+
+    void collectPreDemod(const vector<WbRxRtlSdr::Sample> &samples)
+    {
+      cur_out->pre_demod.insert(cur_out->pre_demod.end(),
+                                samples.begin(), samples.end());
+    }
+
+    void dspOutputReady(void)
+    {
+      DspOutput *out;
+      while ((out = dsp_out.readSlot()) != 0)
+      {
+        if (!out->pre_demod.empty())
+        {
+          preDemod(out->pre_demod);
+        }
+        if (!out->audio.empty())
+        {
+          sinkWriteSamples(&out->audio[0], out->audio.size());
+        }
+        dsp_out.commitRead();
+      }
+
+      const unsigned dropped = dsp_dropped.exchange(0);
+      if (dropped > 0)
+      {
+        cerr << "*** WARNING: Dropped " << dropped << " blocks of DDR "
+             << "output since the main thread is not keeping up" << endl;
+      }
+    }
+
+    void setBw(Channelizer::Bandwidth new_bw)
+    {
+      bw = new_bw;
+      channelizer->setBw(bw);
+      if (fb_channelizer != 0)
+      {
+        fb_channelizer->setBw(bw);
+      }
+    }
+
+      /*
+       * Use the shared filter bank of the tuner if possible. If not, fall
+       * back to translating and decimating the full tuner bandwidth in this
+       * channel. The wideband mode need more bandwidth than a filter bank
+       * channel can provide.
+       */
+    void updateRouting(void)
+    {
+      const int offset = fq_offset - ch_offset;
+      fb_con.disconnect();
+      if ((fb_channelizer != 0) && (bw != Channelizer::BW_WIDE))
+      {
+        int residual = 0;
+        fb_con = rtl->fbConnect(offset, residual,
+                                mem_fun(*this, &Channel::fbIqReceived));
+        if (fb_con.connected())
+        {
+          iq_con.disconnect();
+          fb_trans.setOffset(residual);
+          return;
+        }
+      }
+      if (!iq_con.connected())
+      {
+        iq_con = rtl->iqReceived.connect(
+            mem_fun(*this, &Channel::iq_received));
+      }
+      trans.setOffset(offset);
+    }
 }; /* Channel */
 
 
@@ -1167,6 +1481,11 @@ Ddr::Ddr(Config &cfg, const std::string& name)
 
 Ddr::~Ddr(void)
 {
+    // The channel must be deleted before the tuner, which is deleted when
+    // the last DDR is unregistered
+  delete channel;
+  channel = 0;
+
   if (rtl != 0)
   {
     rtl->unregisterDdr(this);
@@ -1178,8 +1497,6 @@ Ddr::~Ddr(void)
   {
     ddr_map.erase(it);
   }
-
-  delete channel;
 } /* Ddr::~Ddr */
 
 
@@ -1218,7 +1535,7 @@ bool Ddr::initialize(void)
   }
   rtl->registerDdr(this);
 
-  channel = new Channel(fq-rtl->centerFq(), rtl->sampleRate());
+  channel = new Channel(rtl, fq-rtl->centerFq());
   if (!channel->initialize())
   {
     cout << "*** ERROR: Could not initialize channel object for receiver "
@@ -1228,7 +1545,6 @@ bool Ddr::initialize(void)
     return false;
   }
   channel->preDemod.connect(preDemod.make_slot());
-  rtl->iqReceived.connect(mem_fun(*channel, &Channel::iq_received));
   rtl->readyStateChanged.connect(readyStateChanged.make_slot());
 
   string modstr("FM");
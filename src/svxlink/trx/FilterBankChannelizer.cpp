@@ -0,0 +1,365 @@
+/**
+@file   FilterBankChannelizer.cpp
+@brief  A polyphase filter bank splitting a wideband signal into channels
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "FilterBankChannelizer.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+    // Zeroth order modified Bessel function of the first kind
+  double besselI0(double x)
+  {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k=1; k<50; ++k)
+    {
+      term *= (x / (2.0 * k)) * (x / (2.0 * k));
+      sum += term;
+      if (term < sum * 1.0e-12)
+      {
+        break;
+      }
+    }
+    return sum;
+  } /* besselI0 */
+
+
+    // Complex multiplication without the checks for infinity and NaN that
+    // std::complex do, which make it a lot slower
+  inline FilterBankChannelizer::Sample cmul(
+      const FilterBankChannelizer::Sample &a,
+      const FilterBankChannelizer::Sample &b)
+  {
+    return FilterBankChannelizer::Sample(
+        a.real() * b.real() - a.imag() * b.imag(),
+        a.real() * b.imag() + a.imag() * b.real());
+  } /* cmul */
+
+
+}; /* End of anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+FilterBankChannelizer::FilterBankChannelizer(unsigned samp_rate,
+                                             unsigned channels, unsigned bw,
+                                             double atten)
+  : m_samp_rate(samp_rate), m_channels(channels), m_phase(0)
+{
+  assert((channels >= 2) && (channels % 2 == 0));
+  assert(samp_rate % channels == 0);
+  assert(bw < samp_rate / channels);
+
+  designFilter(bw, atten);
+
+  m_acc_re.resize(m_channels);
+  m_acc_im.resize(m_channels);
+  m_out_sigs.resize(m_channels);
+  m_out.resize(m_channels);
+
+  m_twiddle.resize(m_channels);
+  for (unsigned i=0; i<m_channels; ++i)
+  {
+    m_twiddle[i] = polar(1.0f,
+                         static_cast<float>(2.0 * M_PI * i / m_channels));
+  }
+
+    // The DFT row for each channel, in polyphase branch order
+  m_dft_re.resize(m_channels * m_channels);
+  m_dft_im.resize(m_channels * m_channels);
+  for (unsigned ch=0; ch<m_channels; ++ch)
+  {
+    for (unsigned i=0; i<m_channels; ++i)
+    {
+      const Sample &w = m_twiddle[(ch * (m_channels - 1 - i)) % m_channels];
+      m_dft_re[ch * m_channels + i] = w.real();
+      m_dft_im[ch * m_channels + i] = w.imag();
+    }
+  }
+
+    // The newest sample used to calculate the first output sample
+  m_phase = decFact() - 1;
+
+  m_re.assign(taps() - 1, 0.0f);
+  m_im.assign(taps() - 1, 0.0f);
+} /* FilterBankChannelizer::FilterBankChannelizer */
+
+
+unsigned FilterBankChannelizer::channelFor(int fq_offset, int &residual) const
+{
+  const int spacing = channelSpacing();
+  const int k = static_cast<int>(lround(static_cast<double>(fq_offset) /
+                                        spacing));
+  residual = fq_offset - k * spacing;
+  const int n = m_channels;
+  return ((k % n) + n) % n;
+} /* FilterBankChannelizer::channelFor */
+
+
+sigc::connection FilterBankChannelizer::connect(unsigned ch, const Slot &slot)
+{
+  assert(ch < m_channels);
+  return m_out_sigs[ch].connect(slot);
+} /* FilterBankChannelizer::connect */
+
+
+void FilterBankChannelizer::process(const vector<Sample> &in)
+{
+  const unsigned dec_fact = decFact();
+  assert(in.size() % dec_fact == 0);
+
+  const size_t hist = taps() - 1;
+  if (m_re.size() < hist + in.size())
+  {
+    m_re.resize(hist + in.size());
+    m_im.resize(hist + in.size());
+  }
+  for (size_t i=0; i<in.size(); ++i)
+  {
+    m_re[hist + i] = in[i].real();
+    m_im[hist + i] = in[i].imag();
+  }
+
+  size_t out_cnt = in.size() / dec_fact;
+  m_active.clear();
+  for (unsigned ch=0; ch<m_channels; ++ch)
+  {
+    if (!m_out_sigs[ch].empty())
+    {
+      m_out[ch].resize(out_cnt);
+      m_active.push_back(ch);
+    }
+  }
+
+  const unsigned n = m_channels;
+  const size_t taps = m_coeff.size();
+  if (m_active.empty())
+  {
+    m_phase = (m_phase + out_cnt * dec_fact) % n;
+    out_cnt = 0;
+  }
+  for (size_t m=0; m<out_cnt; ++m)
+  {
+      // Multiply the filter with a window of the delay line and sum the
+      // products for each polyphase branch. The last tap is multiplied with
+      // the newest sample, which belong to branch zero.
+    const size_t pos = m * dec_fact + dec_fact - 1;
+    const float *re = m_re.data() + pos;
+    const float *im = m_im.data() + pos;
+    float *acc_re = m_acc_re.data();
+    float *acc_im = m_acc_im.data();
+    fill(acc_re, acc_re + n, 0.0f);
+    fill(acc_im, acc_im + n, 0.0f);
+    for (size_t row=0; row<taps; row+=n)
+    {
+      const float *coeff = m_coeff.data() + row;
+      for (unsigned i=0; i<n; ++i)
+      {
+        acc_re[i] += coeff[i] * re[row + i];
+        acc_im[i] += coeff[i] * im[row + i];
+      }
+    }
+
+      // The DFT of the branch sums give the channel outputs. Only the
+      // channels in use are calculated. Each channel is then shifted down to
+      // zero frequency, which only depend on the time of the newest sample
+      // modulo the number of channels.
+    for (unsigned ch : m_active)
+    {
+      const float *w_re = m_dft_re.data() + ch * n;
+      const float *w_im = m_dft_im.data() + ch * n;
+      float sum_re = 0.0f;
+      float sum_im = 0.0f;
+      for (unsigned i=0; i<n; ++i)
+      {
+        sum_re += acc_re[i] * w_re[i] - acc_im[i] * w_im[i];
+        sum_im += acc_re[i] * w_im[i] + acc_im[i] * w_re[i];
+      }
+      m_out[ch][m] = cmul(Sample(sum_re, sum_im),
+                          m_twiddle[(n - (ch * m_phase) % n) % n]);
+    }
+    m_phase = (m_phase + dec_fact) % n;
+  }
+
+  memmove(m_re.data(), m_re.data() + in.size(), hist * sizeof(float));
+  memmove(m_im.data(), m_im.data() + in.size(), hist * sizeof(float));
+
+  for (unsigned ch : m_active)
+  {
+    m_out_sigs[ch](m_out[ch]);
+  }
+} /* FilterBankChannelizer::process */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void FilterBankChannelizer::designFilter(unsigned bw, double atten)
+{
+    // A signal placed at most half a channel spacing away from the channel
+    // center must pass. Frequencies that alias into that signal after the
+    // decimation must be stopped.
+  const double spacing = static_cast<double>(m_samp_rate) / m_channels;
+  const double pass = spacing / 2.0 + bw / 2.0;
+  const double stop = 2.0 * spacing - pass;
+  const double fc = (pass + stop) / 2.0 / m_samp_rate;
+  const double trans_bw = (stop - pass) / m_samp_rate;
+
+  double beta = 0.0;
+  if (atten > 50.0)
+  {
+    beta = 0.1102 * (atten - 8.7);
+  }
+  else if (atten > 21.0)
+  {
+    beta = 0.5842 * pow(atten - 21.0, 0.4) + 0.07886 * (atten - 21.0);
+  }
+  unsigned taps = static_cast<unsigned>(
+      ceil((atten - 7.95) / (14.36 * trans_bw))) + 1;
+  taps = (taps + m_channels - 1) / m_channels * m_channels;
+
+  vector<double> h(taps);
+  double sum = 0.0;
+  const double mid = (taps - 1) / 2.0;
+  for (unsigned n=0; n<taps; ++n)
+  {
+    const double t = n - mid;
+    const double x = 2.0 * fc * t;
+    const double sinc = (t == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+    const double r = t / mid;
+    const double w = besselI0(beta * sqrt(max(0.0, 1.0 - r * r))) /
+                     besselI0(beta);
+    h[n] = 2.0 * fc * sinc * w;
+    sum += h[n];
+  }
+
+    // Unity gain at zero frequency. The coefficients are stored in reverse
+    // order to match a window of the delay line in time order.
+  m_coeff.resize(taps);
+  for (unsigned n=0; n<taps; ++n)
+  {
+    m_coeff[taps - 1 - n] = h[n] / sum;
+  }
+} /* FilterBankChannelizer::designFilter */
+
+
+
+/*
+ * This file has not been truncated
+ */
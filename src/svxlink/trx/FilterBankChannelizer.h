@@ -0,0 +1,233 @@
+/**
+@file   FilterBankChannelizer.h
+@brief  A polyphase filter bank splitting a wideband signal into channels
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef FILTER_BANK_CHANNELIZER_INCLUDED
+#define FILTER_BANK_CHANNELIZER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <vector>
+#include <complex>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A polyphase filter bank channelizer
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class split a wideband I/Q signal into a number of equally spaced
+channels using a polyphase filter bank. The channels are centered at multiples
+of the channel spacing, samp_rate / channels, and each channel is decimated by
+channels / 2. The output sample rate is thus twice the channel spacing so the
+channels overlap, which make it possible to extract any narrowband signal
+within the wideband signal from the nearest channel after a frequency
+translation of at most half the channel spacing.
+
+The wideband signal is filtered once by the polyphase branches of a prototype
+lowpass filter, a Kaiser windowed sinc designed at construction. The channel
+outputs are then calculated as a DFT of the branch outputs. Only channels that
+have something connected to them are calculated. For the small number of
+channels used here, a DFT row per channel in use is cheaper than a full FFT.
+*/
+class FilterBankChannelizer
+{
+  public:
+    typedef std::complex<float> Sample;
+    typedef sigc::slot<void(const std::vector<Sample>&)> Slot;
+
+    /**
+     * @brief   Constructor
+     * @param   samp_rate The sample rate of the wideband signal
+     * @param   channels  The number of channels, must be even
+     * @param   bw        The narrowband signal bandwidth that must fit
+     * @param   atten     The stopband attenuation of the filter in dB
+     *
+     * The passband of each channel is made wide enough to contain a signal
+     * of bandwidth bw anywhere within half the channel spacing from the
+     * channel center.
+     */
+    FilterBankChannelizer(unsigned samp_rate, unsigned channels,
+                          unsigned bw, double atten=60.0);
+
+    /**
+     * @brief   Get the number of channels
+     * @return  Returns the number of channels
+     */
+    unsigned channelCount(void) const { return m_channels; }
+
+    /**
+     * @brief   Get the channel spacing
+     * @return  Returns the distance between channel centers in Hz
+     */
+    unsigned channelSpacing(void) const { return m_samp_rate / m_channels; }
+
+    /**
+     * @brief   Get the decimation factor
+     * @return  Returns the ratio between the input and output sample rates
+     */
+    unsigned decFact(void) const { return m_channels / 2; }
+
+    /**
+     * @brief   Get the output sample rate
+     * @return  Returns the sample rate of the channel outputs
+     */
+    unsigned outputSampleRate(void) const { return m_samp_rate / decFact(); }
+
+    /**
+     * @brief   Get the number of filter taps
+     * @return  Returns the length of the prototype filter
+     */
+    unsigned taps(void) const { return m_coeff.size(); }
+
+    /**
+     * @brief   Find the channel closest to a frequency
+     * @param   fq_offset The frequency offset from the wideband center in Hz
+     * @param   residual  Set to the frequency offset from the channel center
+     * @return  Returns the channel number
+     */
+    unsigned channelFor(int fq_offset, int &residual) const;
+
+    /**
+     * @brief   Connect a slot to the output of a channel
+     * @param   ch    The channel number
+     * @param   slot  The slot to call with each block of channel samples
+     * @return  Returns the connection object
+     */
+    sigc::connection connect(unsigned ch, const Slot &slot);
+
+    /**
+     * @brief   Process a block of wideband samples
+     * @param   in  The wideband samples
+     *
+     * The number of samples must be a multiple of the decimation factor.
+     */
+    void process(const std::vector<Sample> &in);
+
+  private:
+    typedef sigc::signal<void(const std::vector<Sample>&)> OutSignal;
+
+    unsigned                        m_samp_rate;
+    unsigned                        m_channels;
+    std::vector<float>              m_coeff;
+    std::vector<float>              m_re;
+    std::vector<float>              m_im;
+    std::vector<float>              m_acc_re;
+    std::vector<float>              m_acc_im;
+    std::vector<Sample>             m_twiddle;
+    std::vector<float>              m_dft_re;
+    std::vector<float>              m_dft_im;
+    std::vector<OutSignal>          m_out_sigs;
+    std::vector<std::vector<Sample> > m_out;
+    std::vector<unsigned>           m_active;
+    unsigned                        m_phase;
+
+    FilterBankChannelizer(const FilterBankChannelizer&);
+    FilterBankChannelizer& operator=(const FilterBankChannelizer&);
+    void designFilter(unsigned bw, double atten);
+
+};  /* class FilterBankChannelizer */
+
+
+//} /* namespace */
+
+#endif /* FILTER_BANK_CHANNELIZER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
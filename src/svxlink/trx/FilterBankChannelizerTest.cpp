@@ -0,0 +1,141 @@
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+
+#include "FilterBankChannelizer.h"
+
+using namespace std;
+
+
+/*
+ * Verify the FilterBankChannelizer class
+ *
+ * Usage: FilterBankChannelizerTest
+ *
+ * A tone is placed at random frequencies within the wideband signal. The
+ * nearest filter bank channel is frequency translated by the residual offset
+ * and the tone must then be found at the expected frequency and amplitude.
+ * A tone that will alias into the narrowband signal after decimation must be
+ * suppressed. The exit status is zero if all tests pass.
+ */
+
+namespace {
+  typedef complex<double> DSample;
+
+  struct Config
+  {
+    unsigned samp_rate;
+    unsigned channels;
+  };
+
+  const Config configs[] = {
+    { 960000, 10 },
+    { 2400000, 30 },
+  };
+
+  const int BW = 25000;
+  const double MAX_GAIN_ERR_DB = 0.1;
+  const double MIN_SNR_DB = 60.0;
+  const double MIN_ALIAS_ATTEN_DB = 55.0;
+
+  mt19937 rng(4711);
+
+    /*
+     * Run a tone at frequency fq through the filter bank channel closest to
+     * fq_offset and return the amplitude of the component at frequency
+     * expect_fq in the translated channel output together with the power of
+     * everything else.
+     */
+  void runTone(const Config &cfg, int fq_offset, double fq, double expect_fq,
+               double &ampl, double &noise)
+  {
+    FilterBankChannelizer fb(cfg.samp_rate, cfg.channels, BW);
+    int residual = 0;
+    unsigned ch = fb.channelFor(fq_offset, residual);
+    vector<FilterBankChannelizer::Sample> out;
+    fb.connect(ch, [&](const vector<FilterBankChannelizer::Sample> &samples)
+        {
+          out.insert(out.end(), samples.begin(), samples.end());
+        });
+
+    const size_t block_size = cfg.samp_rate / 100;
+    vector<FilterBankChannelizer::Sample> in(block_size);
+    size_t t = 0;
+    for (int block=0; block<10; ++block)
+    {
+      for (auto& s : in)
+      {
+        s = polar(1.0, 2.0 * M_PI * fmod(fq * t++ / cfg.samp_rate, 1.0));
+      }
+      fb.process(in);
+    }
+
+      // Skip the filter transient
+    const size_t skip = fb.taps() / fb.decFact() + 1;
+    const double out_rate = fb.outputSampleRate();
+    DSample corr(0.0);
+    vector<DSample> trans(out.size());
+    for (size_t n=skip; n<out.size(); ++n)
+    {
+      const double phi = -2.0 * M_PI * fmod((residual + expect_fq) * n /
+                                            out_rate, 1.0);
+      trans[n] = DSample(out[n]) * polar(1.0, phi);
+      corr += trans[n];
+    }
+    const size_t cnt = out.size() - skip;
+    corr /= static_cast<double>(cnt);
+    ampl = abs(corr);
+    noise = 0.0;
+    for (size_t n=skip; n<out.size(); ++n)
+    {
+      noise += norm(trans[n] - corr);
+    }
+    noise /= cnt;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  int failed = 0;
+  for (const auto& cfg : configs)
+  {
+    const int max_offset = cfg.samp_rate / 2 - BW / 2;
+    uniform_int_distribution<int> offset_dist(-max_offset, max_offset);
+    uniform_int_distribution<int> tone_dist(-BW * 2 / 5, BW * 2 / 5);
+    double max_gain_err = 0.0;
+    double min_snr = 1000.0;
+    double min_alias_atten = 1000.0;
+    for (int i=0; i<50; ++i)
+    {
+      const int fq_offset = offset_dist(rng);
+      const int tone = tone_dist(rng);
+      double ampl, noise;
+      runTone(cfg, fq_offset, fq_offset + tone, tone, ampl, noise);
+      max_gain_err = max(max_gain_err, abs(20.0 * log10(ampl)));
+      min_snr = min(min_snr, 10.0 * log10(ampl * ampl / noise));
+
+        // A tone one output sample rate away will alias onto the tone
+      FilterBankChannelizer fb(cfg.samp_rate, cfg.channels, BW);
+      const double alias = fq_offset + tone +
+                           ((i % 2 == 0) ? 1.0 : -1.0) * fb.outputSampleRate();
+      runTone(cfg, fq_offset, alias, tone, ampl, noise);
+      min_alias_atten = min(min_alias_atten, -20.0 * log10(ampl));
+    }
+
+    const bool ok = (max_gain_err <= MAX_GAIN_ERR_DB) &&
+                    (min_snr >= MIN_SNR_DB) &&
+                    (min_alias_atten >= MIN_ALIAS_ATTEN_DB);
+    cout << cfg.samp_rate << "/" << cfg.channels << ": "
+         << (ok ? "OK" : "FAILED")
+         << " max_gain_err=" << max_gain_err << "dB"
+         << " min_snr=" << min_snr << "dB"
+         << " min_alias_atten=" << min_alias_atten << "dB" << endl;
+    failed += ok ? 0 : 1;
+  }
+
+  return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <complex>
+#include <random>
+#include <cstdlib>
+#include <memory>
+
+#include "FilterBankChannelizer.h"
+#include "FirDecimator.h"
+#include "DdrFilterCoeffs.h"
+
+using namespace std;
+
+
+/*
+ * DDR multi channel benchmark
+ *
+ * Usage: FilterBankChannelizer_bench [seconds of IQ data]
+ *
+ * A number of 20kHz FM channels are extracted from random IQ data. This is
+ * done both the old way, where each channel translate the full rate signal
+ * and run a complete decimator chain, and using the filter bank, where the
+ * translation and the remaining decimator chain run at the lower filter bank
+ * output sample rate. The result is given as CPU time and how many times
+ * faster than real time the processing run.
+ */
+
+namespace {
+  typedef complex<float> Sample;
+
+  struct Stage
+  {
+    int           dec_fact;
+    const float*  coeff;
+    int           taps;
+  };
+
+#define STAGE(dec_fact, name) { dec_fact, name, name ## _cnt }
+  struct Config
+  {
+    unsigned        samp_rate;
+    unsigned        fb_channels;
+    vector<Stage>   first_stages;
+    vector<Stage>   stages;
+  };
+
+  const Config configs[] = {
+    { 960000, 10,
+      { STAGE(5, coeff_dec_960k_192k) },
+      { STAGE(3, coeff_dec_192k_64k), STAGE(2, coeff_dec_64k_32k),
+        STAGE(1, coeff_25k_channel) } },
+    { 2400000, 30,
+      { STAGE(3, coeff_dec_2400k_800k), STAGE(5, coeff_dec_800k_160k) },
+      { STAGE(5, coeff_dec_160k_32k), STAGE(1, coeff_25k_channel) } },
+  };
+#undef STAGE
+
+  const unsigned channel_counts[] = { 1, 2, 4, 8, 16 };
+
+  inline Sample cmul(const Sample &a, const Sample &b)
+  {
+    return Sample(a.real() * b.real() - a.imag() * b.imag(),
+                  a.real() * b.imag() + a.imag() * b.real());
+  }
+
+  class Channel
+  {
+    public:
+      Channel(unsigned samp_rate, int offset, const vector<Stage> &stages)
+        : phase(1.0f, 0.0f),
+          step(polar(1.0f, static_cast<float>(-2.0 * M_PI * offset /
+                                              samp_rate)))
+      {
+        for (const auto& stage : stages)
+        {
+          decs.emplace_back(new FirDecimator<Sample>(
+                stage.dec_fact, stage.coeff, stage.taps));
+        }
+        bufs.resize(decs.size() + 1);
+      }
+
+      void process(const vector<Sample> &in)
+      {
+        bufs[0].resize(in.size());
+        for (size_t i=0; i<in.size(); ++i)
+        {
+          bufs[0][i] = cmul(in[i], phase);
+          phase = cmul(phase, step);
+        }
+        for (size_t j=0; j<decs.size(); ++j)
+        {
+          decs[j]->decimate(bufs[j+1], bufs[j]);
+        }
+      }
+
+    private:
+      Sample                                      phase;
+      Sample                                      step;
+      vector<unique_ptr<FirDecimator<Sample> > >  decs;
+      vector<vector<Sample> >                     bufs;
+  };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  int channelOffset(const Config &cfg, unsigned ch)
+  {
+      // Spread the channels over the band, 12.5kHz raster
+    return (static_cast<int>(ch * 37) % 64 - 32) * 12500 *
+           static_cast<int>(cfg.samp_rate / 960000);
+  }
+
+  double runLegacy(const Config &cfg, unsigned ch_cnt,
+                   const vector<Sample> &in, int blocks)
+  {
+    vector<Stage> stages(cfg.first_stages);
+    stages.insert(stages.end(), cfg.stages.begin(), cfg.stages.end());
+    vector<unique_ptr<Channel> > channels;
+    for (unsigned ch=0; ch<ch_cnt; ++ch)
+    {
+      channels.emplace_back(
+          new Channel(cfg.samp_rate, channelOffset(cfg, ch), stages));
+    }
+
+    const double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      for (auto& channel : channels)
+      {
+        channel->process(in);
+      }
+    }
+    return cpuTime() - start;
+  }
+
+  double runFilterBank(const Config &cfg, unsigned ch_cnt,
+                       const vector<Sample> &in, int blocks)
+  {
+    FilterBankChannelizer fb(cfg.samp_rate, cfg.fb_channels, 25000);
+    vector<unique_ptr<Channel> > channels;
+    for (unsigned ch=0; ch<ch_cnt; ++ch)
+    {
+      int residual = 0;
+      unsigned fb_ch = fb.channelFor(channelOffset(cfg, ch), residual);
+      channels.emplace_back(
+          new Channel(fb.outputSampleRate(), residual, cfg.stages));
+      fb.connect(fb_ch, sigc::mem_fun(*channels.back(), &Channel::process));
+    }
+
+    const double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      fb.process(in);
+    }
+    return cpuTime() - start;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 2.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  cout << setw(8) << "rate" << setw(10) << "channels"
+       << setw(14) << "per channel" << setw(14) << "filter bank"
+       << "  (CPU seconds / times real time)" << endl;
+  cout << fixed;
+  for (const auto& cfg : configs)
+  {
+    const size_t block_size = cfg.samp_rate / 100;
+    mt19937 rng(4711);
+    uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    vector<Sample> in(block_size);
+    for (auto& s : in)
+    {
+      s = Sample(dist(rng), dist(rng));
+    }
+
+    const int blocks = seconds * 100;
+    const double real_time = blocks / 100.0;
+    for (unsigned ch_cnt : channel_counts)
+    {
+      double t_legacy = runLegacy(cfg, ch_cnt, in, blocks);
+      double t_fb = runFilterBank(cfg, ch_cnt, in, blocks);
+      cout << setw(8) << cfg.samp_rate << setw(10) << ch_cnt
+           << setw(8) << setprecision(3) << t_legacy
+           << setw(5) << setprecision(0) << (real_time / t_legacy) << "x"
+           << setw(8) << setprecision(3) << t_fb
+           << setw(5) << setprecision(0) << (real_time / t_fb) << "x"
+           << endl;
+    }
+  }
+
+  return 0;
+}
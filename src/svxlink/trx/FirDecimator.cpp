@@ -0,0 +1,616 @@
+/**
+@file   FirDecimator.cpp
+@brief  A decimating FIR filter using SIMD instructions when available
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FIR_DECIMATOR_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FIR_DECIMATOR_NEON
+#include <arm_neon.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "FirDecimator.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The number of filter taps is rounded up to a multiple of this value
+#define TAP_ALIGN 8
+
+
+/****************************************************************************
+ *
+ * Static class variables
+ *
+ ****************************************************************************/
+
+FirDecimatorBase::DotFunc   FirDecimatorBase::dot   = nullptr;
+FirDecimatorBase::Dot2Func  FirDecimatorBase::dot2  = nullptr;
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+  FirDecimatorBase::Isa current_isa = FirDecimatorBase::ISA_GENERIC;
+
+    // Multiple accumulators are used to break the dependency chain between
+    // the additions
+  float dotGeneric(const float *a, const float *b, size_t n)
+  {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i+4 <= n; i += 4)
+    {
+      s0 += a[i] * b[i];
+      s1 += a[i+1] * b[i+1];
+      s2 += a[i+2] * b[i+2];
+      s3 += a[i+3] * b[i+3];
+    }
+    for (; i < n; ++i)
+    {
+      s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+  } /* dotGeneric */
+
+
+  void dot2Generic(const float *coeff, const float *re, const float *im,
+                   size_t n, float *out_re, float *out_im)
+  {
+    float r0 = 0.0f, r1 = 0.0f, i0 = 0.0f, i1 = 0.0f;
+    size_t i = 0;
+    for (; i+2 <= n; i += 2)
+    {
+      r0 += coeff[i] * re[i];
+      i0 += coeff[i] * im[i];
+      r1 += coeff[i+1] * re[i+1];
+      i1 += coeff[i+1] * im[i+1];
+    }
+    for (; i < n; ++i)
+    {
+      r0 += coeff[i] * re[i];
+      i0 += coeff[i] * im[i];
+    }
+    *out_re = r0 + r1;
+    *out_im = i0 + i1;
+  } /* dot2Generic */
+
+
+#ifdef FIR_DECIMATOR_X86
+  __attribute__((target("sse")))
+  inline float hsumSse(__m128 v)
+  {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+  } /* hsumSse */
+
+
+  __attribute__((target("sse")))
+  float dotSse(const float *a, const float *b, size_t n)
+  {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i+8 <= n; i += 8)
+    {
+      acc0 = _mm_add_ps(acc0,
+          _mm_mul_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+      acc1 = _mm_add_ps(acc1,
+          _mm_mul_ps(_mm_loadu_ps(a+i+4), _mm_loadu_ps(b+i+4)));
+    }
+    if (i+4 <= n)
+    {
+      acc0 = _mm_add_ps(acc0,
+          _mm_mul_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+      i += 4;
+    }
+    float sum = hsumSse(_mm_add_ps(acc0, acc1));
+    for (; i < n; ++i)
+    {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  } /* dotSse */
+
+
+  __attribute__((target("sse")))
+  void dot2Sse(const float *coeff, const float *re, const float *im,
+               size_t n, float *out_re, float *out_im)
+  {
+    __m128 acc_re = _mm_setzero_ps();
+    __m128 acc_im = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i+4 <= n; i += 4)
+    {
+      const __m128 c = _mm_loadu_ps(coeff+i);
+      acc_re = _mm_add_ps(acc_re, _mm_mul_ps(c, _mm_loadu_ps(re+i)));
+      acc_im = _mm_add_ps(acc_im, _mm_mul_ps(c, _mm_loadu_ps(im+i)));
+    }
+    float sum_re = hsumSse(acc_re);
+    float sum_im = hsumSse(acc_im);
+    for (; i < n; ++i)
+    {
+      sum_re += coeff[i] * re[i];
+      sum_im += coeff[i] * im[i];
+    }
+    *out_re = sum_re;
+    *out_im = sum_im;
+  } /* dot2Sse */
+
+
+  __attribute__((target("avx2,fma")))
+  inline float hsumAvx(__m256 v)
+  {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_movehdup_ps(lo);
+    __m128 sums = _mm_add_ps(lo, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+  } /* hsumAvx */
+
+
+  __attribute__((target("avx2,fma")))
+  float dotAvx2(const float *a, const float *b, size_t n)
+  {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i+16 <= n; i += 16)
+    {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i),
+                             acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i+8), _mm256_loadu_ps(b+i+8),
+                             acc1);
+    }
+    if (i+8 <= n)
+    {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i),
+                             acc0);
+      i += 8;
+    }
+    float sum = hsumAvx(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i)
+    {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  } /* dotAvx2 */
+
+
+  __attribute__((target("avx2,fma")))
+  void dot2Avx2(const float *coeff, const float *re, const float *im,
+                size_t n, float *out_re, float *out_im)
+  {
+    __m256 acc_re0 = _mm256_setzero_ps();
+    __m256 acc_im0 = _mm256_setzero_ps();
+    __m256 acc_re1 = _mm256_setzero_ps();
+    __m256 acc_im1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i+16 <= n; i += 16)
+    {
+      const __m256 c0 = _mm256_loadu_ps(coeff+i);
+      const __m256 c1 = _mm256_loadu_ps(coeff+i+8);
+      acc_re0 = _mm256_fmadd_ps(c0, _mm256_loadu_ps(re+i), acc_re0);
+      acc_im0 = _mm256_fmadd_ps(c0, _mm256_loadu_ps(im+i), acc_im0);
+      acc_re1 = _mm256_fmadd_ps(c1, _mm256_loadu_ps(re+i+8), acc_re1);
+      acc_im1 = _mm256_fmadd_ps(c1, _mm256_loadu_ps(im+i+8), acc_im1);
+    }
+    if (i+8 <= n)
+    {
+      const __m256 c = _mm256_loadu_ps(coeff+i);
+      acc_re0 = _mm256_fmadd_ps(c, _mm256_loadu_ps(re+i), acc_re0);
+      acc_im0 = _mm256_fmadd_ps(c, _mm256_loadu_ps(im+i), acc_im0);
+      i += 8;
+    }
+    float sum_re = hsumAvx(_mm256_add_ps(acc_re0, acc_re1));
+    float sum_im = hsumAvx(_mm256_add_ps(acc_im0, acc_im1));
+    for (; i < n; ++i)
+    {
+      sum_re += coeff[i] * re[i];
+      sum_im += coeff[i] * im[i];
+    }
+    *out_re = sum_re;
+    *out_im = sum_im;
+  } /* dot2Avx2 */
+#endif /* FIR_DECIMATOR_X86 */
+
+
+#ifdef FIR_DECIMATOR_NEON
+  inline float32x4_t macNeon(float32x4_t acc, float32x4_t a, float32x4_t b)
+  {
+#ifdef __aarch64__
+    return vfmaq_f32(acc, a, b);
+#else
+    return vmlaq_f32(acc, a, b);
+#endif
+  } /* macNeon */
+
+
+  inline float hsumNeon(float32x4_t v)
+  {
+#ifdef __aarch64__
+    return vaddvq_f32(v);
+#else
+    float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#endif
+  } /* hsumNeon */
+
+
+  float dotNeon(const float *a, const float *b, size_t n)
+  {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i+8 <= n; i += 8)
+    {
+      acc0 = macNeon(acc0, vld1q_f32(a+i), vld1q_f32(b+i));
+      acc1 = macNeon(acc1, vld1q_f32(a+i+4), vld1q_f32(b+i+4));
+    }
+    if (i+4 <= n)
+    {
+      acc0 = macNeon(acc0, vld1q_f32(a+i), vld1q_f32(b+i));
+      i += 4;
+    }
+    float sum = hsumNeon(vaddq_f32(acc0, acc1));
+    for (; i < n; ++i)
+    {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  } /* dotNeon */
+
+
+  void dot2Neon(const float *coeff, const float *re, const float *im,
+                size_t n, float *out_re, float *out_im)
+  {
+    float32x4_t acc_re = vdupq_n_f32(0.0f);
+    float32x4_t acc_im = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i+4 <= n; i += 4)
+    {
+      const float32x4_t c = vld1q_f32(coeff+i);
+      acc_re = macNeon(acc_re, c, vld1q_f32(re+i));
+      acc_im = macNeon(acc_im, c, vld1q_f32(im+i));
+    }
+    float sum_re = hsumNeon(acc_re);
+    float sum_im = hsumNeon(acc_im);
+    for (; i < n; ++i)
+    {
+      sum_re += coeff[i] * re[i];
+      sum_im += coeff[i] * im[i];
+    }
+    *out_re = sum_re;
+    *out_im = sum_im;
+  } /* dot2Neon */
+#endif /* FIR_DECIMATOR_NEON */
+
+
+}; /* End of anonymous namespace */
+
+/****************************************************************************
+ *
+ * Public static functions
+ *
+ ****************************************************************************/
+
+bool FirDecimatorBase::isaSupported(Isa isa)
+{
+  switch (isa)
+  {
+    case ISA_AUTO:
+    case ISA_GENERIC:
+      return true;
+#ifdef FIR_DECIMATOR_X86
+    case ISA_SSE:
+      return __builtin_cpu_supports("sse");
+    case ISA_AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#ifdef FIR_DECIMATOR_NEON
+    case ISA_NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+} /* FirDecimatorBase::isaSupported */
+
+
+bool FirDecimatorBase::setIsa(Isa isa)
+{
+  if (isa == ISA_AUTO)
+  {
+    for (Isa best : { ISA_AVX2, ISA_SSE, ISA_NEON, ISA_GENERIC })
+    {
+      if (isaSupported(best))
+      {
+        return setIsa(best);
+      }
+    }
+  }
+  if (!isaSupported(isa))
+  {
+    return false;
+  }
+
+  switch (isa)
+  {
+#ifdef FIR_DECIMATOR_X86
+    case ISA_SSE:
+      dot = dotSse;
+      dot2 = dot2Sse;
+      break;
+    case ISA_AVX2:
+      dot = dotAvx2;
+      dot2 = dot2Avx2;
+      break;
+#endif
+#ifdef FIR_DECIMATOR_NEON
+    case ISA_NEON:
+      dot = dotNeon;
+      dot2 = dot2Neon;
+      break;
+#endif
+    default:
+      dot = dotGeneric;
+      dot2 = dot2Generic;
+      isa = ISA_GENERIC;
+      break;
+  }
+  current_isa = isa;
+  return true;
+} /* FirDecimatorBase::setIsa */
+
+
+FirDecimatorBase::Isa FirDecimatorBase::isa(void)
+{
+  if (dot == nullptr)
+  {
+    setIsa(ISA_AUTO);
+  }
+  return current_isa;
+} /* FirDecimatorBase::isa */
+
+
+const char* FirDecimatorBase::isaName(Isa isa)
+{
+  switch (isa)
+  {
+    case ISA_AUTO:
+      return "auto";
+    case ISA_GENERIC:
+      return "generic";
+    case ISA_SSE:
+      return "sse";
+    case ISA_AVX2:
+      return "avx2";
+    case ISA_NEON:
+      return "neon";
+  }
+  return "?";
+} /* FirDecimatorBase::isaName */
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+FirDecimatorBase::FirDecimatorBase(int dec_fact, const float *coeff, int taps)
+{
+  setDecimatorParams(dec_fact, coeff, taps);
+} /* FirDecimatorBase::FirDecimatorBase */
+
+
+void FirDecimatorBase::setDecimatorParams(int dec_fact, const float *coeff,
+                                          int taps)
+{
+  assert((dec_fact > 0) && (taps >= dec_fact));
+
+  if (dot == nullptr)
+  {
+    setIsa(ISA_AUTO);
+  }
+
+  m_set_coeff.assign(coeff, coeff + taps);
+  m_dec_fact = dec_fact;
+  m_taps = taps;
+  m_padded_taps = (taps + TAP_ALIGN - 1) / TAP_ALIGN * TAP_ALIGN;
+  setGain(0.0);
+
+  m_re.assign(bufLen(0), 0.0f);
+  m_im.assign(bufLen(0), 0.0f);
+} /* FirDecimatorBase::setDecimatorParams */
+
+
+void FirDecimatorBase::setGain(double gain_adjust)
+{
+    // The coefficients are stored in reverse order so that the inner product
+    // can be calculated over a window of the delay line in time order. The
+    // zero padding is multiplied with samples following the window.
+  const double gain = pow(10.0, gain_adjust / 20.0);
+  m_coeff.assign(m_padded_taps, 0.0f);
+  for (size_t i=0; i<m_set_coeff.size(); ++i)
+  {
+    m_coeff[i] = m_set_coeff[m_set_coeff.size() - 1 - i] * gain;
+  }
+} /* FirDecimatorBase::setGain */
+
+
+template <>
+void FirDecimator<float>::decimate(std::vector<float> &out,
+                                   const std::vector<float> &in)
+{
+  assert(m_taps > 0);
+  assert(in.size() % m_dec_fact == 0);
+
+  const size_t hist = histLen();
+  if (m_re.size() < bufLen(in.size()))
+  {
+    m_re.resize(bufLen(in.size()));
+  }
+  memcpy(m_re.data() + hist, in.data(), in.size() * sizeof(float));
+
+  const size_t out_cnt = in.size() / m_dec_fact;
+  out.resize(out_cnt);
+  const float *win = m_re.data() + m_dec_fact - 1;
+  for (size_t i=0; i<out_cnt; ++i)
+  {
+    out[i] = dot(m_coeff.data(), win, m_padded_taps);
+    win += m_dec_fact;
+  }
+
+  shiftHistory(m_re, in.size());
+} /* FirDecimator<float>::decimate */
+
+
+template <>
+void FirDecimator<std::complex<float> >::decimate(
+    std::vector<std::complex<float> > &out,
+    const std::vector<std::complex<float> > &in)
+{
+  assert(m_taps > 0);
+  assert(in.size() % m_dec_fact == 0);
+
+  const size_t hist = histLen();
+  if (m_re.size() < bufLen(in.size()))
+  {
+    m_re.resize(bufLen(in.size()));
+    m_im.resize(bufLen(in.size()));
+  }
+  float *re = m_re.data() + hist;
+  float *im = m_im.data() + hist;
+  for (size_t i=0; i<in.size(); ++i)
+  {
+    re[i] = in[i].real();
+    im[i] = in[i].imag();
+  }
+
+  const size_t out_cnt = in.size() / m_dec_fact;
+  out.resize(out_cnt);
+  const size_t first = m_dec_fact - 1;
+  for (size_t i=0; i<out_cnt; ++i)
+  {
+    const size_t pos = first + i * m_dec_fact;
+    float out_re, out_im;
+    dot2(m_coeff.data(), m_re.data() + pos, m_im.data() + pos, m_padded_taps,
+         &out_re, &out_im);
+    out[i] = std::complex<float>(out_re, out_im);
+  }
+
+  shiftHistory(m_re, in.size());
+  shiftHistory(m_im, in.size());
+} /* FirDecimator<std::complex<float> >::decimate */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void FirDecimatorBase::shiftHistory(std::vector<float>& buf, size_t count)
+{
+  if (count > 0)
+  {
+    memmove(buf.data(), buf.data() + count, histLen() * sizeof(float));
+  }
+} /* FirDecimatorBase::shiftHistory */
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
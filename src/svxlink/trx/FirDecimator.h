@@ -0,0 +1,287 @@
+/**
+@file   FirDecimator.h
+@brief  A decimating FIR filter using SIMD instructions when available
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a decimating FIR filter used by the DDR channelizers and
+demodulators. Only the output samples that are kept after decimation are
+calculated. The inner product is calculated using SSE, AVX2/FMA or NEON
+instructions when the CPU support it.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef FIR_DECIMATOR_INCLUDED
+#define FIR_DECIMATOR_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <complex>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Common parts of the decimating FIR filters
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+The delay line is a linear buffer holding the last taps-1 input samples
+followed by the current block of input samples. Each output sample is then the
+inner product of the (reversed) filter coefficients and a contiguous window
+of the buffer, which is well suited for SIMD instructions. The coefficients
+are padded with zeros to a multiple of the SIMD vector length so that no
+scalar loop is needed for the last few taps. After each block
+the history is moved to the start of the buffer so the copying is done once
+per block instead of once per output sample. Complex samples are stored as
+separate arrays of real and imaginary parts.
+
+The SIMD implementation is selected at runtime, depending on what the CPU
+support. The selection is global and can be overridden using setIsa, which is
+mostly useful for testing and benchmarking.
+*/
+class FirDecimatorBase
+{
+  public:
+    /**
+     * @brief   The instruction set used to calculate inner products
+     */
+    typedef enum
+    {
+      ISA_AUTO,     ///< Select the best supported instruction set
+      ISA_GENERIC,  ///< Plain C++
+      ISA_SSE,      ///< x86 SSE
+      ISA_AVX2,     ///< x86 AVX2 with FMA
+      ISA_NEON      ///< ARM NEON
+    } Isa;
+
+    /**
+     * @brief   Check if an instruction set is supported by this CPU
+     * @param   isa The instruction set to check
+     * @return  Returns \em true if the instruction set can be used
+     */
+    static bool isaSupported(Isa isa);
+
+    /**
+     * @brief   Select which instruction set to use
+     * @param   isa The instruction set to use
+     * @return  Returns \em true on success or \em false if not supported
+     */
+    static bool setIsa(Isa isa);
+
+    /**
+     * @brief   Find out which instruction set is currently used
+     * @return  Returns the instruction set in use, never ISA_AUTO
+     */
+    static Isa isa(void);
+
+    /**
+     * @brief   Get the name of an instruction set
+     * @param   isa The instruction set
+     * @return  Returns the name of the instruction set
+     */
+    static const char* isaName(Isa isa);
+
+    /**
+     * @brief   Default constructor
+     */
+    FirDecimatorBase(void) {}
+
+    /**
+     * @brief   Constructor
+     * @param   dec_fact  The decimation factor
+     * @param   coeff     The filter coefficients
+     * @param   taps      The number of filter coefficients
+     */
+    FirDecimatorBase(int dec_fact, const float *coeff, int taps);
+
+    /**
+     * @brief   Get the decimation factor
+     * @return  Returns the decimation factor
+     */
+    int decFact(void) const { return m_dec_fact; }
+
+    /**
+     * @brief   Get the number of filter taps
+     * @return  Returns the number of filter coefficients
+     */
+    int taps(void) const { return m_taps; }
+
+    /**
+     * @brief   Set the filter parameters
+     * @param   dec_fact  The decimation factor
+     * @param   coeff     The filter coefficients
+     * @param   taps      The number of filter coefficients
+     *
+     * The number of taps must be at least as large as the decimation factor.
+     * The delay line is cleared.
+     */
+    void setDecimatorParams(int dec_fact, const float *coeff, int taps);
+
+    /**
+     * @brief   Adjust the gain of the filter
+     * @param   gain_adjust The gain adjustment in dB
+     *
+     * The gain adjustment is relative to the coefficients given to
+     * setDecimatorParams.
+     */
+    void setGain(double gain_adjust);
+
+  protected:
+    typedef float (*DotFunc)(const float *a, const float *b, size_t n);
+    typedef void (*Dot2Func)(const float *coeff, const float *re,
+                             const float *im, size_t n,
+                             float *out_re, float *out_im);
+
+    static DotFunc  dot;
+    static Dot2Func dot2;
+
+    int                 m_dec_fact    = 0;
+    int                 m_taps        = 0;
+    int                 m_padded_taps = 0;
+    std::vector<float>  m_set_coeff;
+    std::vector<float>  m_coeff;
+    std::vector<float>  m_re;
+    std::vector<float>  m_im;
+
+    size_t histLen(void) const { return m_taps - 1; }
+    size_t bufLen(size_t count) const
+    {
+      return histLen() + count + (m_padded_taps - m_taps);
+    }
+    void shiftHistory(std::vector<float>& buf, size_t count);
+};  /* class FirDecimatorBase */
+
+
+/**
+@brief  A decimating FIR filter
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class implement a decimating FIR filter with real coefficients for float
+or std::complex<float> samples. The output is the same as from a plain FIR
+filter, evaluated for every decFact():th input sample, except for rounding
+differences caused by a different order of summation.
+*/
+template <class T>
+class FirDecimator : public FirDecimatorBase
+{
+  public:
+    using FirDecimatorBase::FirDecimatorBase;
+
+    /**
+     * @brief   Filter and decimate a block of samples
+     * @param   out The output samples
+     * @param   in  The input samples
+     *
+     * The number of input samples must be a multiple of the decimation
+     * factor.
+     */
+    void decimate(std::vector<T> &out, const std::vector<T> &in);
+};  /* class FirDecimator */
+
+
+template <>
+void FirDecimator<float>::decimate(std::vector<float> &out,
+                                   const std::vector<float> &in);
+
+template <>
+void FirDecimator<std::complex<float> >::decimate(
+    std::vector<std::complex<float> > &out,
+    const std::vector<std::complex<float> > &in);
+
+
+//} /* namespace */
+
+#endif /* FIR_DECIMATOR_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,130 @@
+/**
+@file   FirDecimatorRef.h
+@brief  A straightforward decimating FIR filter used as a reference
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains the decimating FIR filter that was previously used by the
+DDR. It is kept to verify and benchmark the FirDecimator class.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef FIR_DECIMATOR_REF_INCLUDED
+#define FIR_DECIMATOR_REF_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A straightforward decimating FIR filter used as a reference
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+The whole delay line is shifted for each output sample and the inner product
+is calculated in tap order. Do not use this class in production code.
+*/
+template <class T>
+class FirDecimatorRef
+{
+  public:
+    FirDecimatorRef(int dec_fact, const float *coeff, int taps)
+      : dec_fact(dec_fact), p_Z(new T[taps]()), taps(taps),
+        set_coeff(coeff, coeff + taps), coeff(set_coeff)
+    {
+      assert(taps >= dec_fact);
+    }
+
+    ~FirDecimatorRef(void)
+    {
+      delete [] p_Z;
+    }
+
+    FirDecimatorRef(const FirDecimatorRef&) = delete;
+    FirDecimatorRef& operator=(const FirDecimatorRef&) = delete;
+
+    int decFact(void) const { return dec_fact; }
+
+    void setGain(double gain_adjust)
+    {
+      coeff = set_coeff;
+      for (auto& c : coeff)
+      {
+        c *= pow(10.0, gain_adjust / 20.0);
+      }
+    }
+
+    void decimate(std::vector<T> &out, const std::vector<T> &in)
+    {
+      assert(in.size() % dec_fact == 0);
+      auto src = in.begin();
+      out.clear();
+      out.reserve(in.size() / dec_fact);
+      while (src != in.end())
+      {
+          // shift Z delay line up to make room for next samples
+        memmove(p_Z + dec_fact, p_Z, (taps - dec_fact) * sizeof(T));
+
+          // copy next samples from input buffer to bottom of Z delay line
+        for (int tap = dec_fact - 1; tap >= 0; tap--)
+        {
+          p_Z[tap] = *src++;
+        }
+
+          // calculate FIR sum
+        T sum(0);
+        for (int tap = 0; tap < taps; tap++)
+        {
+          sum += coeff[tap] * p_Z[tap];
+        }
+        out.push_back(sum);
+      }
+    }
+
+  private:
+    int                 dec_fact;
+    T                   *p_Z;
+    int                 taps;
+    std::vector<float>  set_coeff;
+    std::vector<float>  coeff;
+};  /* class FirDecimatorRef */
+
+
+#endif /* FIR_DECIMATOR_REF_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
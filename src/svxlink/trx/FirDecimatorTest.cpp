@@ -0,0 +1,152 @@
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "FirDecimator.h"
+#include "FirDecimatorRef.h"
+#include "DdrFilterCoeffs.h"
+
+using namespace std;
+
+
+/*
+ * Verify the FirDecimator class against the reference implementation
+ *
+ * Usage: FirDecimatorTest
+ *
+ * All DDR filters are run, with random input split into blocks of random
+ * size, using each instruction set supported by the CPU. The output must
+ * match the output of the reference implementation to within rounding errors.
+ * The exit status is zero if all tests pass.
+ */
+
+namespace {
+  struct Filter
+  {
+    const char*   name;
+    int           dec_fact;
+    const float*  coeff;
+    int           taps;
+  };
+
+#define FILTER(dec_fact, name) { #name, dec_fact, name, name ## _cnt }
+  const Filter filters[] = {
+    FILTER(3, coeff_dec_2400k_800k),
+    FILTER(5, coeff_dec_800k_160k),
+    FILTER(5, coeff_dec_160k_32k),
+    FILTER(5, coeff_dec_960k_192k),
+    FILTER(6, coeff_dec_192k_32k),
+    FILTER(3, coeff_dec_192k_64k),
+    FILTER(2, coeff_dec_64k_32k),
+    FILTER(2, coeff_dec_32k_16k),
+    FILTER(4, coeff_dec_192k_48k),
+    FILTER(3, coeff_dec_48k_16k),
+    FILTER(1, coeff_25k_channel),
+    FILTER(1, coeff_12k5_channel),
+    FILTER(1, coeff_nbam_channel),
+    FILTER(1, coeff_ssb_channel),
+    FILTER(1, coeff_cw_channel),
+    FILTER(2, coeff_dec_audio_32k_16k),
+    FILTER(1, coeff_hilbert),
+  };
+#undef FILTER
+
+  const float MAX_REL_ERROR = 1.0e-5f;
+
+  mt19937 rng(4711);
+
+  float randSample(void)
+  {
+    uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    return dist(rng);
+  }
+
+  void fill(vector<float>& v, size_t n)
+  {
+    v.resize(n);
+    generate(v.begin(), v.end(), randSample);
+  }
+
+  void fill(vector<complex<float> >& v, size_t n)
+  {
+    v.resize(n);
+    for (auto& s : v)
+    {
+      s = complex<float>(randSample(), randSample());
+    }
+  }
+
+  template <class T>
+  bool runTest(const Filter& f, double gain)
+  {
+    FirDecimator<T> dec(f.dec_fact, f.coeff, f.taps);
+    FirDecimatorRef<T> ref(f.dec_fact, f.coeff, f.taps);
+    dec.setGain(gain);
+    ref.setGain(gain);
+
+    float max_err = 0.0f;
+    float max_out = 0.0f;
+    size_t out_cnt = 0;
+    uniform_int_distribution<int> blocks(0, 200);
+    vector<T> in, out, ref_out;
+    for (int i=0; i<100; ++i)
+    {
+        // Empty blocks and blocks shorter than the filter are also tested
+      fill(in, blocks(rng) * f.dec_fact);
+      dec.decimate(out, in);
+      ref.decimate(ref_out, in);
+      if (out.size() != ref_out.size())
+      {
+        cout << "*** ERROR: Output size mismatch for " << f.name << endl;
+        return false;
+      }
+      for (size_t j=0; j<out.size(); ++j)
+      {
+        max_err = max(max_err, abs(out[j] - ref_out[j]));
+        max_out = max(max_out, abs(ref_out[j]));
+      }
+      out_cnt += out.size();
+    }
+
+    const bool ok = (out_cnt > 0) && (max_err <= MAX_REL_ERROR * max_out);
+    if (!ok)
+    {
+      cout << "*** ERROR: " << f.name << " max_err=" << max_err
+           << " max_out=" << max_out << endl;
+    }
+    return ok;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  int failed = 0;
+  for (auto isa : { FirDecimatorBase::ISA_GENERIC, FirDecimatorBase::ISA_SSE,
+                    FirDecimatorBase::ISA_AVX2, FirDecimatorBase::ISA_NEON })
+  {
+    if (!FirDecimatorBase::setIsa(isa))
+    {
+      cout << FirDecimatorBase::isaName(isa) << ": Not supported" << endl;
+      continue;
+    }
+    int isa_failed = 0;
+    for (const auto& f : filters)
+    {
+      for (double gain : { 0.0, 12.5 })
+      {
+        isa_failed += runTest<float>(f, gain) ? 0 : 1;
+        isa_failed += runTest<complex<float> >(f, gain) ? 0 : 1;
+      }
+    }
+    cout << FirDecimatorBase::isaName(isa) << ": "
+         << (isa_failed == 0 ? "OK" : "FAILED") << endl;
+    failed += isa_failed;
+  }
+
+  return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <complex>
+#include <string>
+#include <random>
+#include <cstdlib>
+#include <memory>
+
+#include "FirDecimator.h"
+#include "FirDecimatorRef.h"
+#include "DdrFilterCoeffs.h"
+
+using namespace std;
+
+
+/*
+ * DDR channelizer filter chain benchmark
+ *
+ * Usage: FirDecimator_bench [seconds of IQ data]
+ *
+ * Each channelizer filter chain used by the DDR, for both tuner sampling
+ * rates and all channel bandwidths, is run on random IQ data. The reference
+ * implementation is compared to the FirDecimator class using each instruction
+ * set supported by the CPU. The result is given as CPU time and how many
+ * times faster than real time the chain run.
+ */
+
+namespace {
+  typedef complex<float> Sample;
+
+  struct Stage
+  {
+    int           dec_fact;
+    const float*  coeff;
+    int           taps;
+  };
+
+#define STAGE(dec_fact, name) { dec_fact, name, name ## _cnt }
+  struct Chain
+  {
+    const char*     name;
+    unsigned        samp_rate;
+    vector<Stage>   stages;
+  };
+
+  const Stage dec_960k_192k = STAGE(5, coeff_dec_960k_192k);
+  const Stage dec_192k_64k  = STAGE(3, coeff_dec_192k_64k);
+  const Stage dec_64k_32k   = STAGE(2, coeff_dec_64k_32k);
+  const Stage dec_192k_48k  = STAGE(4, coeff_dec_192k_48k);
+  const Stage dec_48k_16k   = STAGE(3, coeff_dec_48k_16k);
+  const Stage dec_2400k_800k= STAGE(3, coeff_dec_2400k_800k);
+  const Stage dec_800k_160k = STAGE(5, coeff_dec_800k_160k);
+  const Stage dec_160k_32k  = STAGE(5, coeff_dec_160k_32k);
+  const Stage dec_32k_16k   = STAGE(2, coeff_dec_32k_16k);
+  const Stage ch_filt       = STAGE(1, coeff_25k_channel);
+  const Stage ch_filt_narr  = STAGE(1, coeff_12k5_channel);
+  const Stage ch_filt_6k    = STAGE(1, coeff_nbam_channel);
+  const Stage ch_filt_3k    = STAGE(1, coeff_ssb_channel);
+  const Stage ch_filt_500   = STAGE(1, coeff_cw_channel);
+#undef STAGE
+
+    // The same chains as set up by Channelizer960 and Channelizer2400
+  const Chain chains[] = {
+    { "960k WIDE", 960000, { dec_960k_192k } },
+    { "960k 20K",  960000, { dec_960k_192k, dec_192k_64k, dec_64k_32k,
+                             ch_filt } },
+    { "960k 10K",  960000, { dec_960k_192k, dec_192k_48k, dec_48k_16k,
+                             ch_filt_narr } },
+    { "960k 6K",   960000, { dec_960k_192k, dec_192k_48k, dec_48k_16k,
+                             ch_filt_6k } },
+    { "960k 3K",   960000, { dec_960k_192k, dec_192k_48k, dec_48k_16k,
+                             ch_filt_3k } },
+    { "960k 500",  960000, { dec_960k_192k, dec_192k_48k, dec_48k_16k,
+                             ch_filt_500 } },
+    { "2400k WIDE", 2400000, { dec_2400k_800k, dec_800k_160k } },
+    { "2400k 20K",  2400000, { dec_2400k_800k, dec_800k_160k, dec_160k_32k,
+                               ch_filt } },
+    { "2400k 10K",  2400000, { dec_2400k_800k, dec_800k_160k, dec_160k_32k,
+                               dec_32k_16k, ch_filt_narr } },
+    { "2400k 6K",   2400000, { dec_2400k_800k, dec_800k_160k, dec_160k_32k,
+                               dec_32k_16k, ch_filt_6k } },
+    { "2400k 3K",   2400000, { dec_2400k_800k, dec_800k_160k, dec_160k_32k,
+                               dec_32k_16k, ch_filt_3k } },
+    { "2400k 500",  2400000, { dec_2400k_800k, dec_800k_160k, dec_160k_32k,
+                               dec_32k_16k, ch_filt_500 } },
+  };
+
+    // A multiple of all chain decimation factors
+  const size_t BLOCK_SIZE = 24000;
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  template <class D>
+  double runChain(const Chain& chain, const vector<Sample>& in, int blocks)
+  {
+    vector<unique_ptr<D> > decs;
+    for (const auto& stage : chain.stages)
+    {
+      decs.emplace_back(new D(stage.dec_fact, stage.coeff, stage.taps));
+    }
+    vector<vector<Sample> > bufs(decs.size() + 1);
+    bufs[0] = in;
+
+    const double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      for (size_t j=0; j<decs.size(); ++j)
+      {
+        decs[j]->decimate(bufs[j+1], bufs[j]);
+      }
+    }
+    return cpuTime() - start;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 2.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  mt19937 rng(4711);
+  uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  vector<Sample> in(BLOCK_SIZE);
+  for (auto& s : in)
+  {
+    s = Sample(dist(rng), dist(rng));
+  }
+
+  vector<FirDecimatorBase::Isa> isas;
+  for (auto isa : { FirDecimatorBase::ISA_GENERIC, FirDecimatorBase::ISA_SSE,
+                    FirDecimatorBase::ISA_AVX2, FirDecimatorBase::ISA_NEON })
+  {
+    if (FirDecimatorBase::isaSupported(isa))
+    {
+      isas.push_back(isa);
+    }
+  }
+
+  cout << setw(12) << left << "chain" << right
+       << setw(12) << "reference";
+  for (auto isa : isas)
+  {
+    cout << setw(12) << FirDecimatorBase::isaName(isa);
+  }
+  cout << "  (CPU seconds / times real time)" << endl;
+
+  cout << fixed;
+  for (const auto& chain : chains)
+  {
+    const int blocks = seconds * chain.samp_rate / BLOCK_SIZE;
+    const double real_time = static_cast<double>(blocks) * BLOCK_SIZE /
+                             chain.samp_rate;
+    cout << setw(12) << left << chain.name << right;
+    double t = runChain<FirDecimatorRef<Sample> >(chain, in, blocks);
+    cout << setw(6) << setprecision(3) << t
+         << setw(5) << setprecision(0) << (real_time / t) << "x";
+    for (auto isa : isas)
+    {
+      FirDecimatorBase::setIsa(isa);
+      t = runChain<FirDecimator<Sample> >(chain, in, blocks);
+      cout << setw(6) << setprecision(3) << t
+           << setw(5) << setprecision(0) << (real_time / t) << "x";
+    }
+    cout << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,508 @@
+/**
+@file   GoertzelBank.cpp
+@brief  A bank of Goertzel detectors evaluated in one pass over the samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GOERTZEL_BANK_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GOERTZEL_BANK_NEON
+#include <arm_neon.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "GoertzelBank.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The number of bins is rounded up to a multiple of this value
+#define LANE_ALIGN 8
+
+
+/****************************************************************************
+ *
+ * Static class variables
+ *
+ ****************************************************************************/
+
+GoertzelBank::CalcFunc GoertzelBank::calc_func = nullptr;
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+  GoertzelBank::Isa current_isa = GoertzelBank::ISA_GENERIC;
+
+    /*
+     * All kernels calculate q0 = two_cosw * q1 - q2 + x in the same order as
+     * the Goertzel class does so that the results are the same. Two groups of
+     * lanes are run at the same time, when possible, to break the dependency
+     * chain from one sample to the next.
+     */
+  void calcGeneric(const float *two_cosw, float *q0, float *q1, size_t lanes,
+                   const float *x, size_t n)
+  {
+    for (size_t lane=0; lane<lanes; lane+=4)
+    {
+      float c[4], a[4], b[4];
+      for (int j=0; j<4; ++j)
+      {
+        c[j] = two_cosw[lane+j];
+        a[j] = q0[lane+j];
+        b[j] = q1[lane+j];
+      }
+      for (size_t i=0; i<n; ++i)
+      {
+        for (int j=0; j<4; ++j)
+        {
+          const float t = c[j] * a[j] - b[j] + x[i];
+          b[j] = a[j];
+          a[j] = t;
+        }
+      }
+      for (int j=0; j<4; ++j)
+      {
+        q0[lane+j] = a[j];
+        q1[lane+j] = b[j];
+      }
+    }
+  } /* calcGeneric */
+
+
+#ifdef GOERTZEL_BANK_X86
+  __attribute__((target("sse")))
+  void calcSse(const float *two_cosw, float *q0, float *q1, size_t lanes,
+               const float *x, size_t n)
+  {
+    for (size_t lane=0; lane<lanes; lane+=8)
+    {
+      const __m128 c0 = _mm_loadu_ps(two_cosw+lane);
+      const __m128 c1 = _mm_loadu_ps(two_cosw+lane+4);
+      __m128 a0 = _mm_loadu_ps(q0+lane);
+      __m128 a1 = _mm_loadu_ps(q0+lane+4);
+      __m128 b0 = _mm_loadu_ps(q1+lane);
+      __m128 b1 = _mm_loadu_ps(q1+lane+4);
+      for (size_t i=0; i<n; ++i)
+      {
+        const __m128 xv = _mm_set1_ps(x[i]);
+        const __m128 t0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c0, a0), b0), xv);
+        const __m128 t1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c1, a1), b1), xv);
+        b0 = a0;
+        b1 = a1;
+        a0 = t0;
+        a1 = t1;
+      }
+      _mm_storeu_ps(q0+lane, a0);
+      _mm_storeu_ps(q0+lane+4, a1);
+      _mm_storeu_ps(q1+lane, b0);
+      _mm_storeu_ps(q1+lane+4, b1);
+    }
+  } /* calcSse */
+
+
+  __attribute__((target("avx")))
+  void calcAvx(const float *two_cosw, float *q0, float *q1, size_t lanes,
+               const float *x, size_t n)
+  {
+    size_t lane = 0;
+    for (; lane+16<=lanes; lane+=16)
+    {
+      const __m256 c0 = _mm256_loadu_ps(two_cosw+lane);
+      const __m256 c1 = _mm256_loadu_ps(two_cosw+lane+8);
+      __m256 a0 = _mm256_loadu_ps(q0+lane);
+      __m256 a1 = _mm256_loadu_ps(q0+lane+8);
+      __m256 b0 = _mm256_loadu_ps(q1+lane);
+      __m256 b1 = _mm256_loadu_ps(q1+lane+8);
+      for (size_t i=0; i<n; ++i)
+      {
+        const __m256 xv = _mm256_set1_ps(x[i]);
+        const __m256 t0 =
+          _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(c0, a0), b0), xv);
+        const __m256 t1 =
+          _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(c1, a1), b1), xv);
+        b0 = a0;
+        b1 = a1;
+        a0 = t0;
+        a1 = t1;
+      }
+      _mm256_storeu_ps(q0+lane, a0);
+      _mm256_storeu_ps(q0+lane+8, a1);
+      _mm256_storeu_ps(q1+lane, b0);
+      _mm256_storeu_ps(q1+lane+8, b1);
+    }
+    if (lane < lanes)
+    {
+      const __m256 c = _mm256_loadu_ps(two_cosw+lane);
+      __m256 a = _mm256_loadu_ps(q0+lane);
+      __m256 b = _mm256_loadu_ps(q1+lane);
+      for (size_t i=0; i<n; ++i)
+      {
+        const __m256 t = _mm256_add_ps(
+            _mm256_sub_ps(_mm256_mul_ps(c, a), b), _mm256_set1_ps(x[i]));
+        b = a;
+        a = t;
+      }
+      _mm256_storeu_ps(q0+lane, a);
+      _mm256_storeu_ps(q1+lane, b);
+    }
+  } /* calcAvx */
+#endif /* GOERTZEL_BANK_X86 */
+
+
+#ifdef GOERTZEL_BANK_NEON
+  void calcNeon(const float *two_cosw, float *q0, float *q1, size_t lanes,
+                const float *x, size_t n)
+  {
+    for (size_t lane=0; lane<lanes; lane+=8)
+    {
+      const float32x4_t c0 = vld1q_f32(two_cosw+lane);
+      const float32x4_t c1 = vld1q_f32(two_cosw+lane+4);
+      float32x4_t a0 = vld1q_f32(q0+lane);
+      float32x4_t a1 = vld1q_f32(q0+lane+4);
+      float32x4_t b0 = vld1q_f32(q1+lane);
+      float32x4_t b1 = vld1q_f32(q1+lane+4);
+      for (size_t i=0; i<n; ++i)
+      {
+        const float32x4_t xv = vdupq_n_f32(x[i]);
+        const float32x4_t t0 = vaddq_f32(vsubq_f32(vmulq_f32(c0, a0), b0), xv);
+        const float32x4_t t1 = vaddq_f32(vsubq_f32(vmulq_f32(c1, a1), b1), xv);
+        b0 = a0;
+        b1 = a1;
+        a0 = t0;
+        a1 = t1;
+      }
+      vst1q_f32(q0+lane, a0);
+      vst1q_f32(q0+lane+4, a1);
+      vst1q_f32(q1+lane, b0);
+      vst1q_f32(q1+lane+4, b1);
+    }
+  } /* calcNeon */
+#endif /* GOERTZEL_BANK_NEON */
+
+
+}; /* End of anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public static functions
+ *
+ ****************************************************************************/
+
+bool GoertzelBank::isaSupported(Isa isa)
+{
+  switch (isa)
+  {
+    case ISA_AUTO:
+    case ISA_GENERIC:
+      return true;
+#ifdef GOERTZEL_BANK_X86
+    case ISA_SSE:
+      return __builtin_cpu_supports("sse");
+    case ISA_AVX:
+      return __builtin_cpu_supports("avx");
+#endif
+#ifdef GOERTZEL_BANK_NEON
+    case ISA_NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+} /* GoertzelBank::isaSupported */
+
+
+bool GoertzelBank::setIsa(Isa isa)
+{
+  if (isa == ISA_AUTO)
+  {
+    for (Isa best : { ISA_AVX, ISA_SSE, ISA_NEON, ISA_GENERIC })
+    {
+      if (isaSupported(best))
+      {
+        return setIsa(best);
+      }
+    }
+  }
+  if (!isaSupported(isa))
+  {
+    return false;
+  }
+
+  switch (isa)
+  {
+#ifdef GOERTZEL_BANK_X86
+    case ISA_SSE:
+      calc_func = calcSse;
+      break;
+    case ISA_AVX:
+      calc_func = calcAvx;
+      break;
+#endif
+#ifdef GOERTZEL_BANK_NEON
+    case ISA_NEON:
+      calc_func = calcNeon;
+      break;
+#endif
+    default:
+      calc_func = calcGeneric;
+      isa = ISA_GENERIC;
+      break;
+  }
+  current_isa = isa;
+  return true;
+} /* GoertzelBank::setIsa */
+
+
+GoertzelBank::Isa GoertzelBank::isa(void)
+{
+  if (calc_func == nullptr)
+  {
+    setIsa(ISA_AUTO);
+  }
+  return current_isa;
+} /* GoertzelBank::isa */
+
+
+const char* GoertzelBank::isaName(Isa isa)
+{
+  switch (isa)
+  {
+    case ISA_AUTO:
+      return "auto";
+    case ISA_GENERIC:
+      return "generic";
+    case ISA_SSE:
+      return "sse";
+    case ISA_AVX:
+      return "avx";
+    case ISA_NEON:
+      return "neon";
+  }
+  return "?";
+} /* GoertzelBank::isaName */
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+GoertzelBank::GoertzelBank(unsigned sample_rate)
+  : m_sample_rate(sample_rate)
+{
+  if (calc_func == nullptr)
+  {
+    setIsa(ISA_AUTO);
+  }
+} /* GoertzelBank::GoertzelBank */
+
+
+size_t GoertzelBank::addBin(float freq)
+{
+  const size_t bin = m_freq.size();
+  resize(bin + 1);
+  setFrequency(bin, freq);
+  m_q0[bin] = m_q1[bin] = 0.0f;
+  return bin;
+} /* GoertzelBank::addBin */
+
+
+void GoertzelBank::setFrequency(size_t bin, float freq)
+{
+  assert(bin < m_freq.size());
+  const float w = 2.0f * M_PI * (freq / (float)m_sample_rate);
+  m_freq[bin] = freq;
+  m_cosw[bin] = cosf(w);
+  m_sinw[bin] = sinf(w);
+  m_two_cosw[bin] = 2.0f * m_cosw[bin];
+} /* GoertzelBank::setFrequency */
+
+
+void GoertzelBank::setWindow(const std::vector<float>& window,
+                             bool window_energy)
+{
+  m_window = window;
+  m_window_energy = window_energy;
+} /* GoertzelBank::setWindow */
+
+
+void GoertzelBank::reset(void)
+{
+  fill(m_q0.begin(), m_q0.end(), 0.0f);
+  fill(m_q1.begin(), m_q1.end(), 0.0f);
+  m_block_pos = 0;
+  m_energy = 0.0;
+} /* GoertzelBank::reset */
+
+
+void GoertzelBank::calc(const float *samples, size_t count)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  const float *x = samples;
+  double energy = 0.0;
+  if (!m_window.empty())
+  {
+    assert(m_block_pos + count <= m_window.size());
+    if (m_scratch.size() < count)
+    {
+      m_scratch.resize(count);
+    }
+    const float *win = &m_window[m_block_pos];
+    for (size_t i=0; i<count; ++i)
+    {
+      const float sample = samples[i];
+      const float windowed = sample * win[i];
+      const float e = m_window_energy ? windowed : sample;
+      energy += static_cast<double>(e) * e;
+      m_scratch[i] = windowed;
+    }
+    x = m_scratch.data();
+  }
+  else
+  {
+    for (size_t i=0; i<count; ++i)
+    {
+      energy += static_cast<double>(samples[i]) * samples[i];
+    }
+  }
+  m_energy += energy;
+
+  if (!m_q0.empty())
+  {
+    calc_func(m_two_cosw.data(), m_q0.data(), m_q1.data(), m_q0.size(),
+              x, count);
+  }
+  m_block_pos += count;
+} /* GoertzelBank::calc */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void GoertzelBank::resize(size_t bins)
+{
+    // The state arrays are padded to a whole number of SIMD vectors. The
+    // padding lanes run with a zero coefficient and are never read.
+  const size_t lanes = (bins + LANE_ALIGN - 1) / LANE_ALIGN * LANE_ALIGN;
+  m_freq.resize(bins, 0.0f);
+  m_cosw.resize(lanes, 0.0f);
+  m_sinw.resize(lanes, 0.0f);
+  m_two_cosw.resize(lanes, 0.0f);
+  m_q0.resize(lanes, 0.0f);
+  m_q1.resize(lanes, 0.0f);
+} /* GoertzelBank::resize */
+
+
+
+/*
+ * This file has not been truncated
+ */
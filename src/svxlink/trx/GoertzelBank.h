@@ -0,0 +1,319 @@
+/**
+@file   GoertzelBank.h
+@brief  A bank of Goertzel detectors evaluated in one pass over the samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a bank of Goertzel single bin DFT detectors that all work on
+the same block of samples. The window and passband energy is calculated once
+for the whole bank and the Goertzel recurrences for all bins are run side by
+side using SSE, AVX or NEON instructions when the CPU support it.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef GOERTZEL_BANK_INCLUDED
+#define GOERTZEL_BANK_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <complex>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A bank of Goertzel detectors working on the same samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class calculates the same thing as a number of Goertzel objects that are
+fed with the same samples, but in one pass over the samples. The window
+function is applied and the passband energy is summed once for all bins
+instead of once for each detector. The states of the Goertzel recurrences are
+stored as arrays, one element per bin, so that the recurrences for a number of
+bins are calculated in parallel using SIMD instructions. The results are the
+same as for the Goertzel class.
+
+See the documentation for the Goertzel class for how to choose the block
+length and how to use the results.
+
+\code
+  GoertzelBank bank(INTERNAL_SAMPLE_RATE);
+  for (float fq : { 697.0f, 770.0f, 852.0f, 941.0f })
+  {
+    bank.addBin(fq);
+  }
+  bank.setWindow(hamming_window);
+  bank.reset();
+  bank.calc(samples, block_len);
+  float mag_sqr = bank.magnitudeSquared(0);
+  double energy = bank.passbandEnergy();
+\endcode
+
+The SIMD implementation is selected at runtime, depending on what the CPU
+support. The selection is global and can be overridden using setIsa, which is
+mostly useful for testing and benchmarking.
+*/
+class GoertzelBank
+{
+  public:
+    /**
+     * @brief   The instruction set used to run the recurrences
+     */
+    typedef enum
+    {
+      ISA_AUTO,     ///< Select the best supported instruction set
+      ISA_GENERIC,  ///< Plain C++
+      ISA_SSE,      ///< x86 SSE
+      ISA_AVX,      ///< x86 AVX
+      ISA_NEON      ///< ARM NEON
+    } Isa;
+
+    /**
+     * @brief   Check if an instruction set is supported by this CPU
+     * @param   isa The instruction set to check
+     * @return  Returns \em true if the instruction set can be used
+     */
+    static bool isaSupported(Isa isa);
+
+    /**
+     * @brief   Select which instruction set to use
+     * @param   isa The instruction set to use
+     * @return  Returns \em true on success or \em false if not supported
+     */
+    static bool setIsa(Isa isa);
+
+    /**
+     * @brief   Find out which instruction set is currently used
+     * @return  Returns the instruction set in use, never ISA_AUTO
+     */
+    static Isa isa(void);
+
+    /**
+     * @brief   Get the name of an instruction set
+     * @param   isa The instruction set
+     * @return  Returns the name of the instruction set
+     */
+    static const char* isaName(Isa isa);
+
+    /**
+     * @brief   Constructor
+     * @param   sample_rate The sample rate used
+     */
+    explicit GoertzelBank(unsigned sample_rate);
+
+    /**
+     * @brief   Add a bin to the bank
+     * @param   freq The frequency of interest, in Hz
+     * @return  Returns the index of the new bin
+     */
+    size_t addBin(float freq);
+
+    /**
+     * @brief   Change the frequency of a bin
+     * @param   bin   The index of the bin
+     * @param   freq  The new frequency, in Hz
+     *
+     * The state of the bin is not reset so this function should normally be
+     * called between blocks.
+     */
+    void setFrequency(size_t bin, float freq);
+
+    /**
+     * @brief   Get the frequency of a bin
+     * @param   bin The index of the bin
+     * @return  Returns the frequency of the bin, in Hz
+     */
+    float frequency(size_t bin) const { return m_freq[bin]; }
+
+    /**
+     * @brief   Get the number of bins in the bank
+     * @return  Returns the number of bins
+     */
+    size_t size(void) const { return m_freq.size(); }
+
+    /**
+     * @brief   Set the window function to apply to each block
+     * @param   window          The window, one coefficient per block sample
+     * @param   window_energy   Set to \em true to sum the passband energy
+     *                          after the window has been applied
+     *
+     * The window will be applied to the samples before they are fed into
+     * the recurrences. An empty window disable windowing. The number of
+     * samples in a block must not exceed the length of the window.
+     */
+    void setWindow(const std::vector<float>& window, bool window_energy=true);
+
+    /**
+     * @brief   Reset all bins and the passband energy to start a new block
+     */
+    void reset(void);
+
+    /**
+     * @brief   Process a number of samples
+     * @param   samples The samples to process
+     * @param   count   The number of samples
+     *
+     * The samples are processed as the continuation of the current block.
+     * A block may be processed using any number of calls to this function.
+     */
+    void calc(const float *samples, size_t count);
+
+    /**
+     * @brief   Get the number of samples processed since the last reset
+     * @return  Returns the position in the current block
+     */
+    size_t blockPos(void) const { return m_block_pos; }
+
+    /**
+     * @brief   Get the passband energy
+     * @return  Returns the sum of the squared samples since the last reset
+     */
+    double passbandEnergy(void) const { return m_energy; }
+
+    /**
+     * @brief   Calculate the result for a bin in complex form
+     * @param   bin The index of the bin
+     * @return  Returns the result in complex form
+     *
+     * See Goertzel::result.
+     */
+    std::complex<float> result(size_t bin) const
+    {
+      return std::complex<float>(m_cosw[bin] * m_q0[bin] - m_q1[bin],
+                                 m_sinw[bin] * m_q0[bin]);
+    }
+
+    /**
+     * @brief   Calculate the magnitude squared for a bin
+     * @param   bin The index of the bin
+     * @return  Returns the magnitude squared
+     *
+     * See Goertzel::magnitudeSquared.
+     */
+    float magnitudeSquared(size_t bin) const
+    {
+      return m_q0[bin] * m_q0[bin] + m_q1[bin] * m_q1[bin] -
+             m_q0[bin] * m_q1[bin] * m_two_cosw[bin];
+    }
+
+  private:
+    typedef void (*CalcFunc)(const float *two_cosw, float *q0, float *q1,
+                             size_t lanes, const float *x, size_t n);
+
+    static CalcFunc calc_func;
+
+    unsigned            m_sample_rate;
+    std::vector<float>  m_freq;
+    std::vector<float>  m_cosw;
+    std::vector<float>  m_sinw;
+    std::vector<float>  m_two_cosw;
+    std::vector<float>  m_q0;
+    std::vector<float>  m_q1;
+    std::vector<float>  m_window;
+    bool                m_window_energy = true;
+    std::vector<float>  m_scratch;
+    size_t              m_block_pos     = 0;
+    double              m_energy        = 0.0;
+
+    void resize(size_t bins);
+
+};  /* class GoertzelBank */
+
+
+//} /* namespace */
+
+#endif /* GOERTZEL_BANK_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
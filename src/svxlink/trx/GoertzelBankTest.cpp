@@ -0,0 +1,157 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Goertzel.h"
+#include "GoertzelBank.h"
+
+using namespace std;
+
+
+/*
+ * Verify the GoertzelBank class against the Goertzel class
+ *
+ * Usage: GoertzelBankTest
+ *
+ * Banks of different sizes are run, with random input split into pieces of
+ * random size, using each instruction set supported by the CPU. The result
+ * for each bin must match the result of a Goertzel object fed with the same
+ * windowed samples, to within rounding errors. The passband energy must
+ * match the energy summed up sample by sample.
+ * The exit status is zero if all tests pass.
+ */
+
+namespace {
+  const unsigned SAMPLE_RATE = 16000;
+  const size_t BLOCK_LEN = 320;
+  const float MAX_REL_ERROR = 1.0e-5f;
+
+  mt19937 rng(4711);
+
+  bool runTest(size_t bins, bool use_window, bool window_energy)
+  {
+    uniform_real_distribution<float> fq_dist(50.0f, 7500.0f);
+    uniform_real_distribution<float> sample_dist(-1.0f, 1.0f);
+    uniform_int_distribution<size_t> piece_dist(0, 50);
+
+    vector<float> window;
+    if (use_window)
+    {
+      for (size_t i=0; i<BLOCK_LEN; ++i)
+      {
+        window.push_back(
+            0.54f - 0.46f * cosf(2.0f * M_PI * i / (BLOCK_LEN - 1)));
+      }
+    }
+
+    GoertzelBank bank(SAMPLE_RATE);
+    vector<Goertzel> ref(bins);
+    for (size_t i=0; i<bins; ++i)
+    {
+      const float fq = fq_dist(rng);
+      if (bank.addBin(fq) != i)
+      {
+        cout << "*** ERROR: Wrong bin index returned" << endl;
+        return false;
+      }
+      ref[i].initialize(fq, SAMPLE_RATE);
+    }
+    bank.setWindow(window, window_energy);
+
+    bool ok = true;
+    for (int block=0; block<10; ++block)
+    {
+      bank.reset();
+      for (auto& g : ref)
+      {
+        g.reset();
+      }
+
+      vector<float> samples(BLOCK_LEN);
+      generate(samples.begin(), samples.end(),
+               [&]() { return sample_dist(rng); });
+      double energy = 0.0;
+      for (size_t i=0; i<BLOCK_LEN; ++i)
+      {
+        float sample = samples[i];
+        if (use_window)
+        {
+          sample *= window[i];
+        }
+        const float e = window_energy ? sample : samples[i];
+        energy += static_cast<double>(e) * e;
+        for (auto& g : ref)
+        {
+          g.calc(sample);
+        }
+      }
+
+        // Empty pieces are also tested
+      size_t pos = 0;
+      while (pos < BLOCK_LEN)
+      {
+        const size_t len = min(piece_dist(rng), BLOCK_LEN - pos);
+        bank.calc(&samples[pos], len);
+        pos += len;
+      }
+
+      if (bank.blockPos() != BLOCK_LEN)
+      {
+        cout << "*** ERROR: Wrong block position" << endl;
+        ok = false;
+      }
+      if (fabs(bank.passbandEnergy() - energy) > 1.0e-9 * energy)
+      {
+        cout << "*** ERROR: Passband energy " << bank.passbandEnergy()
+             << " != " << energy << endl;
+        ok = false;
+      }
+      for (size_t i=0; i<bins; ++i)
+      {
+        const float ref_ms = ref[i].magnitudeSquared();
+        const float ms = bank.magnitudeSquared(i);
+        const float err = abs(bank.result(i) - ref[i].result());
+        const float mag = abs(ref[i].result());
+        if ((fabs(ms - ref_ms) > MAX_REL_ERROR * max(ref_ms, 1.0f)) ||
+            (err > MAX_REL_ERROR * max(mag, 1.0f)))
+        {
+          cout << "*** ERROR: bins=" << bins << " bin=" << i
+               << " fq=" << bank.frequency(i) << " mag_sqr=" << ms
+               << " ref=" << ref_ms << endl;
+          ok = false;
+        }
+      }
+    }
+    return ok;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  int failed = 0;
+  for (auto isa : { GoertzelBank::ISA_GENERIC, GoertzelBank::ISA_SSE,
+                    GoertzelBank::ISA_AVX, GoertzelBank::ISA_NEON })
+  {
+    if (!GoertzelBank::setIsa(isa))
+    {
+      cout << GoertzelBank::isaName(isa) << ": Not supported" << endl;
+      continue;
+    }
+    int isa_failed = 0;
+    for (size_t bins : { 1, 3, 8, 10, 17, 51 })
+    {
+      isa_failed += runTest(bins, false, true) ? 0 : 1;
+      isa_failed += runTest(bins, true, true) ? 0 : 1;
+      isa_failed += runTest(bins, true, false) ? 0 : 1;
+    }
+    cout << GoertzelBank::isaName(isa) << ": "
+         << (isa_failed == 0 ? "OK" : "FAILED") << endl;
+    failed += isa_failed;
+  }
+
+  return (failed == 0) ? 0 : 1;
+}
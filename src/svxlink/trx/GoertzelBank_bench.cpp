@@ -0,0 +1,216 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <memory>
+
+#include <AsyncAudioFilter.h>
+#include <AsyncAudioSplitter.h>
+
+#include "Goertzel.h"
+#include "GoertzelBank.h"
+#include "ToneDetector.h"
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Goertzel bank benchmark
+ *
+ * Usage: GoertzelBank_bench [seconds of audio]
+ *
+ * A number of Goertzel detectors, the same number as used by the DTMF
+ * decoder, the tone signal level detector and a CTCSS squelch listening for
+ * all standard tones, are run on the same random audio both as separate
+ * Goertzel objects and as one GoertzelBank, using each instruction set
+ * supported by the CPU. The result is given as CPU time per second of audio.
+ * Last, a full CTCSS squelch setup with one tone detector per tone is run
+ * both with one band pass filter per detector, as it was done before, and
+ * with one filter shared by all detectors.
+ */
+
+namespace {
+  const unsigned SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
+  const size_t BLOCK_LEN = 320;
+  const size_t bin_counts[] = { 3, 8, 10, 50 };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  float fq(size_t bin)
+  {
+    return 67.0f + 4.0f * bin;
+  }
+
+  double runScalar(size_t bins, const vector<float>& in, int blocks)
+  {
+    vector<Goertzel> dets(bins);
+    for (size_t i=0; i<bins; ++i)
+    {
+      dets[i].initialize(fq(i), SAMPLE_RATE);
+    }
+    float sum = 0.0f;
+    const double start = cpuTime();
+    for (int b=0; b<blocks; ++b)
+    {
+      for (auto& det : dets)
+      {
+        det.reset();
+      }
+      for (float sample : in)
+      {
+        for (auto& det : dets)
+        {
+          det.calc(sample);
+        }
+      }
+      for (auto& det : dets)
+      {
+        sum += det.magnitudeSquared();
+      }
+    }
+    const double t = cpuTime() - start;
+    if (sum < 0.0f)
+    {
+      cout << sum << endl;
+    }
+    return t;
+  }
+
+  double runBank(size_t bins, const vector<float>& in, int blocks)
+  {
+    GoertzelBank bank(SAMPLE_RATE);
+    for (size_t i=0; i<bins; ++i)
+    {
+      bank.addBin(fq(i));
+    }
+    float sum = 0.0f;
+    const double start = cpuTime();
+    for (int b=0; b<blocks; ++b)
+    {
+      bank.reset();
+      bank.calc(in.data(), in.size());
+      for (size_t i=0; i<bins; ++i)
+      {
+        sum += bank.magnitudeSquared(i);
+      }
+    }
+    const double t = cpuTime() - start;
+    if (sum < 0.0f)
+    {
+      cout << sum << endl;
+    }
+    return t;
+  }
+
+  double runCtcss(bool shared_filter, const vector<float>& in, int blocks)
+  {
+    static const float ctcss_fqs[] = {
+      67.0, 71.9, 74.4, 77.0, 79.7, 82.5, 85.4, 88.5, 91.5, 94.8, 97.4,
+      100.0, 103.5, 107.2, 110.9, 114.8, 118.8, 123.0, 127.3, 131.8, 136.5,
+      141.3, 146.2, 151.4, 156.7, 162.2, 167.9, 173.8, 179.9, 186.2, 192.8,
+      203.5, 210.7, 218.1, 225.7, 233.6, 241.8, 250.3
+    };
+    AudioSplitter splitter;
+    for (float ctcss_fq : ctcss_fqs)
+    {
+      ToneDetector *det = new ToneDetector(ctcss_fq, 8.0f);
+      det->setDetectBw(16.0f);
+      det->setDetectOverlapPercent(75.0f);
+      det->setDetectDelay(100);
+      det->setDetectToneFrequencyTolerancePercent(0.75f);
+      det->setDetectUseWindowing(false);
+      det->setDetectPeakThresh(0.0f);
+      det->setDetectSnrThresh(15.0f, 200.0f);
+      det->setUndetectBw(8.0f);
+      det->setUndetectOverlapPercent(75.0f);
+      det->setUndetectDelay(100);
+      det->setUndetectUseWindowing(false);
+      det->setUndetectPeakThresh(0.0f);
+      det->setUndetectSnrThresh(10.0f, 200.0f);
+      AudioSink *sink = det;
+      if (!shared_filter)
+      {
+        AudioFilter *filter = new AudioFilter("BpBu8/60-270", SAMPLE_RATE);
+        filter->registerSink(det, true);
+        sink = filter;
+      }
+      splitter.addSink(sink, true);
+    }
+    AudioFilter filter("BpBu8/60-270", SAMPLE_RATE);
+    filter.registerSink(&splitter);
+    AudioSink *input = shared_filter ? static_cast<AudioSink*>(&filter)
+                                     : static_cast<AudioSink*>(&splitter);
+
+    const double start = cpuTime();
+    for (int b=0; b<blocks; ++b)
+    {
+      input->writeSamples(in.data(), in.size());
+    }
+    const double t = cpuTime() - start;
+    filter.unregisterSink();
+    return t;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 20.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  mt19937 rng(4711);
+  normal_distribution<float> dist(0.0f, 0.3f);
+  vector<float> in(BLOCK_LEN);
+  for (auto& s : in)
+  {
+    s = dist(rng);
+  }
+  const int blocks = seconds * SAMPLE_RATE / BLOCK_LEN;
+  const double scale = 1.0 / seconds;
+
+  cout << setw(6) << "bins" << setw(12) << "Goertzel";
+  vector<GoertzelBank::Isa> isas;
+  for (auto isa : { GoertzelBank::ISA_GENERIC, GoertzelBank::ISA_SSE,
+                    GoertzelBank::ISA_AVX, GoertzelBank::ISA_NEON })
+  {
+    if (GoertzelBank::isaSupported(isa))
+    {
+      isas.push_back(isa);
+      cout << setw(12) << GoertzelBank::isaName(isa);
+    }
+  }
+  cout << "  (CPU milliseconds per second of audio)" << endl;
+  cout << fixed << setprecision(3);
+  for (size_t bins : bin_counts)
+  {
+    cout << setw(6) << bins
+         << setw(12) << 1e3 * scale * runScalar(bins, in, blocks);
+    for (auto isa : isas)
+    {
+      GoertzelBank::setIsa(isa);
+      cout << setw(12) << 1e3 * scale * runBank(bins, in, blocks);
+    }
+    cout << endl;
+  }
+  GoertzelBank::setIsa(GoertzelBank::ISA_AUTO);
+
+  cout << endl << "CTCSS squelch, all standard tones, mode 4:" << endl;
+  cout << setw(24) << "filter per detector"
+       << setw(12) << 1e3 * scale * runCtcss(false, in, blocks) << endl;
+  cout << setw(24) << "shared filter"
+       << setw(12) << 1e3 * scale * runCtcss(true, in, blocks) << endl;
+
+  return 0;
+}
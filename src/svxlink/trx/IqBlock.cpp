@@ -0,0 +1,313 @@
+/**
+@file   IqBlock.cpp
+@brief  Pooled and reference counted blocks of I/Q samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <atomic>
+#include <mutex>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "IqBlock.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+struct IqBlockPool::Impl
+{
+  mutex                     mtx;
+  vector<IqBlock::Buffer*>  free_list;
+  atomic<size_t>            allocations;
+  bool                      closed;
+
+  Impl(void) : allocations(0), closed(false) {}
+};
+
+
+struct IqBlock::Buffer
+{
+  atomic<unsigned>                  ref_cnt;
+  vector<Sample>                    samples;
+  shared_ptr<IqBlockPool::Impl>     pool;
+
+  explicit Buffer(const shared_ptr<IqBlockPool::Impl> &pool)
+    : ref_cnt(0), pool(pool) {}
+};
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+namespace {
+  atomic<size_t> total_allocations(0);
+};
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+IqBlock::IqBlock(const IqBlock &other)
+  : m_buf(other.m_buf)
+{
+  if (m_buf != 0)
+  {
+    m_buf->ref_cnt.fetch_add(1, memory_order_relaxed);
+  }
+} /* IqBlock::IqBlock */
+
+
+IqBlock::~IqBlock(void)
+{
+  release();
+} /* IqBlock::~IqBlock */
+
+
+IqBlock& IqBlock::operator=(const IqBlock &other)
+{
+  if (other.m_buf != 0)
+  {
+    other.m_buf->ref_cnt.fetch_add(1, memory_order_relaxed);
+  }
+  release();
+  m_buf = other.m_buf;
+  return *this;
+} /* IqBlock::operator= */
+
+
+size_t IqBlock::size(void) const
+{
+  return (m_buf != 0) ? m_buf->samples.size() : 0;
+} /* IqBlock::size */
+
+
+const vector<IqBlock::Sample>& IqBlock::samples(void) const
+{
+  assert(m_buf != 0);
+  return m_buf->samples;
+} /* IqBlock::samples */
+
+
+IqBlock::Sample *IqBlock::data(void)
+{
+  assert(m_buf != 0);
+  return m_buf->samples.data();
+} /* IqBlock::data */
+
+
+unsigned IqBlock::refCount(void) const
+{
+  return (m_buf != 0) ? m_buf->ref_cnt.load(memory_order_relaxed) : 0;
+} /* IqBlock::refCount */
+
+
+void IqBlock::release(void)
+{
+  Buffer *buf = m_buf;
+  m_buf = 0;
+  if ((buf == 0) || (buf->ref_cnt.fetch_sub(1, memory_order_acq_rel) != 1))
+  {
+    return;
+  }
+
+    // The last reference is gone so give the buffer back to the pool. If the
+    // pool have been destroyed, the buffer is freed instead. That may also
+    // free the pool implementation so keep a reference to it while the lock
+    // is held.
+  shared_ptr<IqBlockPool::Impl> pool(buf->pool);
+  {
+    lock_guard<mutex> lock(pool->mtx);
+    if (!pool->closed)
+    {
+      pool->free_list.push_back(buf);
+      return;
+    }
+  }
+  delete buf;
+} /* IqBlock::release */
+
+
+IqBlockPool::IqBlockPool(void)
+  : m_impl(make_shared<Impl>())
+{
+  m_impl->free_list.reserve(16);
+} /* IqBlockPool::IqBlockPool */
+
+
+IqBlockPool::~IqBlockPool(void)
+{
+  vector<IqBlock::Buffer*> free_list;
+  {
+    lock_guard<mutex> lock(m_impl->mtx);
+    m_impl->closed = true;
+    free_list.swap(m_impl->free_list);
+  }
+  for (IqBlock::Buffer *buf : free_list)
+  {
+    delete buf;
+  }
+} /* IqBlockPool::~IqBlockPool */
+
+
+IqBlock IqBlockPool::alloc(size_t size)
+{
+  IqBlock::Buffer *buf = 0;
+  {
+    lock_guard<mutex> lock(m_impl->mtx);
+    if (!m_impl->free_list.empty())
+    {
+      buf = m_impl->free_list.back();
+      m_impl->free_list.pop_back();
+    }
+  }
+
+  bool alloced = false;
+  if (buf == 0)
+  {
+    buf = new IqBlock::Buffer(m_impl);
+    alloced = true;
+  }
+  if (buf->samples.capacity() < size)
+  {
+    buf->samples.reserve(size);
+    alloced = true;
+  }
+  if (alloced)
+  {
+    m_impl->allocations += 1;
+    total_allocations += 1;
+  }
+  buf->samples.resize(size);
+  buf->ref_cnt.store(1, memory_order_relaxed);
+  return IqBlock(buf);
+} /* IqBlockPool::alloc */
+
+
+size_t IqBlockPool::freeCount(void) const
+{
+  lock_guard<mutex> lock(m_impl->mtx);
+  return m_impl->free_list.size();
+} /* IqBlockPool::freeCount */
+
+
+size_t IqBlockPool::allocations(void) const
+{
+  return m_impl->allocations;
+} /* IqBlockPool::allocations */
+
+
+size_t IqBlockPool::totalAllocations(void)
+{
+  return total_allocations;
+} /* IqBlockPool::totalAllocations */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,280 @@
+/**
+@file   IqBlock.h
+@brief  Pooled and reference counted blocks of I/Q samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef IQ_BLOCK_INCLUDED
+#define IQ_BLOCK_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <complex>
+#include <vector>
+#include <memory>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class IqBlockPool;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A reference counted block of I/Q samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+An IqBlock object is a handle to a sample buffer that has been allocated from
+an IqBlockPool. Copying the handle only increase the reference count of the
+buffer so a block can be passed on to any number of receivers without copying
+the samples. When the last handle is destroyed, the buffer is given back to
+the pool to be used for a later block. The reference count is atomic so a
+block may be released in another thread than the one that allocated it.
+
+The samples should not be modified after the block has been passed on.
+*/
+class IqBlock
+{
+  public:
+    typedef std::complex<float> Sample;
+
+    /**
+     * @brief   Default constructor
+     *
+     * Create a null block, which contain no samples.
+     */
+    IqBlock(void) : m_buf(0) {}
+
+    /**
+     * @brief   Copy constructor
+     * @param   other The block to share the buffer with
+     */
+    IqBlock(const IqBlock &other);
+
+    /**
+     * @brief   Destructor
+     */
+    ~IqBlock(void);
+
+    /**
+     * @brief   Assignment operator
+     * @param   other The block to share the buffer with
+     * @return  Returns this object
+     */
+    IqBlock& operator=(const IqBlock &other);
+
+    /**
+     * @brief   Check if this is a null block
+     * @return  Returns \em true if the block have no buffer
+     */
+    bool isNull(void) const { return m_buf == 0; }
+
+    /**
+     * @brief   Get the number of samples in the block
+     * @return  Returns the number of samples
+     */
+    size_t size(void) const;
+
+    /**
+     * @brief   Access the samples
+     * @return  Returns the samples as a vector owned by the block
+     *
+     * The returned vector is valid as long as a handle to the block exist.
+     */
+    const std::vector<Sample>& samples(void) const;
+
+    /**
+     * @brief   Access the samples for writing
+     * @return  Returns a pointer to the first sample
+     *
+     * This function is meant to be used by the producer of the block to fill
+     * in the samples before the block is passed on.
+     */
+    Sample *data(void);
+
+    /**
+     * @brief   Get the reference count
+     * @return  Returns the number of handles to the buffer of this block
+     */
+    unsigned refCount(void) const;
+
+    /**
+     * @brief   Release the buffer
+     *
+     * Drop the reference to the buffer, making this a null block.
+     */
+    void release(void);
+
+  private:
+    struct Buffer;
+
+    Buffer *m_buf;
+
+    explicit IqBlock(Buffer *buf) : m_buf(buf) {}
+
+    friend class IqBlockPool;
+
+};  /* class IqBlock */
+
+
+/**
+@brief  A pool of I/Q sample buffers
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class hand out IqBlock objects. Buffers that are released are kept in a
+free list and reused for later blocks, so in steady state, when the block
+size does not grow, no memory is allocated. The number of allocations made is
+counted to make that possible to verify.
+
+The pool may be destroyed while blocks from it are still in use. Those
+buffers are then freed when released.
+*/
+class IqBlockPool
+{
+  public:
+    /**
+     * @brief   Default constructor
+     */
+    IqBlockPool(void);
+
+    /**
+     * @brief   Destructor
+     */
+    ~IqBlockPool(void);
+
+    /**
+     * @brief   Allocate a block
+     * @param   size The number of samples in the block
+     * @return  Returns a block with a reference count of one
+     *
+     * The content of the samples is undefined.
+     */
+    IqBlock alloc(size_t size);
+
+    /**
+     * @brief   Get the number of buffers in the free list
+     * @return  Returns the number of buffers ready for reuse
+     */
+    size_t freeCount(void) const;
+
+    /**
+     * @brief   Get the number of memory allocations made by this pool
+     * @return  Returns the number of sample buffers allocated or grown
+     */
+    size_t allocations(void) const;
+
+    /**
+     * @brief   Get the number of memory allocations made by all pools
+     * @return  Returns the number of sample buffers allocated or grown
+     */
+    static size_t totalAllocations(void);
+
+  private:
+    struct Impl;
+
+    std::shared_ptr<Impl> m_impl;
+
+    IqBlockPool(const IqBlockPool&);
+    IqBlockPool& operator=(const IqBlockPool&);
+
+    friend class IqBlock;
+
+};  /* class IqBlockPool */
+
+
+//} /* namespace */
+
+#endif /* IQ_BLOCK_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
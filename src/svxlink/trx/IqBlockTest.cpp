@@ -0,0 +1,157 @@
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <cstdlib>
+#include <new>
+
+#include "IqBlock.h"
+#include "FilterBankChannelizer.h"
+#include "FirDecimator.h"
+#include "DdrFilterCoeffs.h"
+
+using namespace std;
+
+
+/*
+ * Verify the IqBlock and IqBlockPool classes
+ *
+ * Usage: IqBlockTest
+ *
+ * Check that block buffers are shared between copies, given back to the pool
+ * when the last copy is gone and that they survive the pool. Then blocks are
+ * run through the filter bank and a channel decimator chain, like the
+ * RtlSdr -> WbRxRtlSdr -> Ddr path do, and after a warm up period no heap
+ * allocations at all may be made. The exit status is zero if all tests pass.
+ */
+
+namespace {
+  size_t heap_allocations = 0;
+
+  int failed = 0;
+
+  void check(bool ok, const char *what)
+  {
+    cout << (ok ? "OK     " : "FAILED ") << what << endl;
+    failed += ok ? 0 : 1;
+  }
+
+  void testRefCount(void)
+  {
+    IqBlockPool pool;
+    IqBlock blk = pool.alloc(100);
+    check((blk.size() == 100) && (blk.refCount() == 1), "alloc");
+    {
+      IqBlock copy(blk);
+      IqBlock assigned;
+      assigned = copy;
+      check((blk.refCount() == 3) && (&copy.samples() == &blk.samples()),
+            "copies share the buffer");
+    }
+    check((blk.refCount() == 1) && (pool.freeCount() == 0),
+          "copies released");
+    const IqBlock::Sample *data = blk.data();
+    blk.release();
+    check(blk.isNull() && (pool.freeCount() == 1), "buffer returned to pool");
+    blk = pool.alloc(50);
+    check((blk.data() == data) && (pool.allocations() == 1),
+          "buffer reused");
+    blk.release();
+    blk = pool.alloc(200);
+    check((pool.freeCount() == 0) && (pool.allocations() == 2),
+          "buffer grown");
+  }
+
+  void testPoolLifetime(void)
+  {
+    IqBlock blk;
+    {
+      IqBlockPool pool;
+      blk = pool.alloc(10);
+      IqBlock other = pool.alloc(10);
+    }
+    blk.data()[9] = IqBlock::Sample(1.0f, 0.0f);
+    check(blk.samples()[9] == IqBlock::Sample(1.0f, 0.0f),
+          "block outlive the pool");
+  }
+
+  void testSteadyState(void)
+  {
+    const unsigned samp_rate = 2400000;
+    const size_t block_size = samp_rate / 100;
+    IqBlockPool pool;
+    FilterBankChannelizer fb(samp_rate, 30, 25000);
+    FirDecimator<IqBlock::Sample> dec1(5, coeff_dec_160k_32k,
+                                       coeff_dec_160k_32k_cnt);
+    FirDecimator<IqBlock::Sample> dec2(1, coeff_25k_channel,
+                                       coeff_25k_channel_cnt);
+    vector<IqBlock::Sample> dec_samp1, dec_samp2;
+    IqBlock held;
+    fb.connect(3, [&](const vector<IqBlock::Sample> &samples)
+        {
+          dec1.decimate(dec_samp1, samples);
+          dec2.decimate(dec_samp2, dec_samp1);
+        });
+
+    const size_t warmup_allocs = heap_allocations;
+    size_t steady_allocs = 0;
+    for (int i=0; i<200; ++i)
+    {
+      if (i == 10)
+      {
+        steady_allocs = heap_allocations;
+      }
+      IqBlock blk = pool.alloc(block_size);
+      IqBlock::Sample *samples = blk.data();
+      for (size_t n=0; n<block_size; ++n)
+      {
+        samples[n] = IqBlock::Sample(n % 7 - 3.0f, n % 5 - 2.0f);
+      }
+      fb.process(blk.samples());
+
+        // Keep every other block for a while, like a slow consumer would
+      if (i % 2 == 0)
+      {
+        held = blk;
+      }
+    }
+    steady_allocs = heap_allocations - steady_allocs;
+    cout << "Warm up allocations: " << (heap_allocations - warmup_allocs -
+                                        steady_allocs)
+         << ", pool allocations: " << pool.allocations() << endl;
+    check(steady_allocs == 0, "no allocations in steady state");
+    check(pool.allocations() <= 2, "at most two buffers in use");
+  }
+};
+
+
+void *operator new(size_t size)
+{
+  ++heap_allocations;
+  void *ptr = malloc(size);
+  if (ptr == 0)
+  {
+    throw bad_alloc();
+  }
+  return ptr;
+}
+
+
+void operator delete(void *ptr) noexcept
+{
+  free(ptr);
+}
+
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  free(ptr);
+}
+
+
+int main(int argc, const char **argv)
+{
+  testRefCount();
+  testPoolLifetime();
+  testSteadyState();
+  return (failed == 0) ? 0 : 1;
+}
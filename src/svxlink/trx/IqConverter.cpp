@@ -0,0 +1,365 @@
+/**
+@file   IqConverter.cpp
+@brief  Convert 8 bit I/Q samples to float and gather block statistics
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#define IQ_CONVERTER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IQ_CONVERTER_NEON
+#include <arm_neon.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "IqConverter.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+    // Integer sums over the I/Q bytes of a block
+  struct Sums
+  {
+    uint64_t  sum_i;
+    uint64_t  sum_q;
+    uint64_t  sum_sq;
+    uint64_t  clipped;
+
+    Sums(void) : sum_i(0), sum_q(0), sum_sq(0), clipped(0) {}
+  };
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+    /*
+     * The number of 16 byte iterations that can be run before the 8 bit
+     * clip counters may overflow
+     */
+  const size_t CHUNK_ITERATIONS = 255;
+  const float SCALE = 1.0f / 127.5f;
+
+
+  void convertGeneric(float *out, const uint8_t *in, size_t bytes,
+                      Sums &sums)
+  {
+    for (size_t i=0; i<bytes; i+=2)
+    {
+      const unsigned si = in[i];
+      const unsigned sq = in[i+1];
+      out[i] = si * SCALE - 1.0f;
+      out[i+1] = sq * SCALE - 1.0f;
+      sums.sum_i += si;
+      sums.sum_q += sq;
+      sums.sum_sq += si * si + sq * sq;
+      sums.clipped += (si == 0) + (si == 255) + (sq == 0) + (sq == 255);
+    }
+  } /* convertGeneric */
+
+
+#ifdef IQ_CONVERTER_SSE2
+    /*
+     * Each 16 byte vector hold eight I/Q pairs. The I values are the low
+     * bytes of the 16 bit lanes and the Q values the high bytes, so masking
+     * or shifting the lanes and summing the absolute differences against zero
+     * give the I and Q sums. The squares are summed by a multiply-add of the
+     * widened lanes.
+     */
+  size_t convertSse2(float *out, const uint8_t *in, size_t bytes, Sums &sums)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(-1);
+    const __m128i lo_mask = _mm_set1_epi16(0x00ff);
+    const __m128 scale = _mm_set1_ps(SCALE);
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i sum_i = zero;
+    __m128i sum_q = zero;
+    __m128i sum_sq = zero;
+    __m128i clipped = zero;
+    const size_t end = bytes & ~static_cast<size_t>(15);
+    size_t i = 0;
+    while (i < end)
+    {
+      const size_t chunk_end = min(end, i + 16 * CHUNK_ITERATIONS);
+      __m128i sq = zero;
+      __m128i clip_cnt = zero;
+      for (; i < chunk_end; i += 16)
+      {
+        const __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i clip = _mm_or_si128(_mm_cmpeq_epi8(v, ones),
+                                          _mm_cmpeq_epi8(v, zero));
+        clip_cnt = _mm_sub_epi8(clip_cnt, clip);
+        sum_i = _mm_add_epi64(sum_i,
+                              _mm_sad_epu8(_mm_and_si128(v, lo_mask), zero));
+        sum_q = _mm_add_epi64(sum_q, _mm_sad_epu8(_mm_srli_epi16(v, 8), zero));
+
+        const __m128i w0 = _mm_unpacklo_epi8(v, zero);
+        const __m128i w1 = _mm_unpackhi_epi8(v, zero);
+        sq = _mm_add_epi32(sq, _mm_add_epi32(_mm_madd_epi16(w0, w0),
+                                             _mm_madd_epi16(w1, w1)));
+
+        const __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(w0, zero));
+        const __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(w0, zero));
+        const __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(w1, zero));
+        const __m128 f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(w1, zero));
+        _mm_storeu_ps(out + i, _mm_sub_ps(_mm_mul_ps(f0, scale), one));
+        _mm_storeu_ps(out + i + 4, _mm_sub_ps(_mm_mul_ps(f1, scale), one));
+        _mm_storeu_ps(out + i + 8, _mm_sub_ps(_mm_mul_ps(f2, scale), one));
+        _mm_storeu_ps(out + i + 12, _mm_sub_ps(_mm_mul_ps(f3, scale), one));
+      }
+      sum_sq = _mm_add_epi64(sum_sq,
+                             _mm_add_epi64(_mm_unpacklo_epi32(sq, zero),
+                                           _mm_unpackhi_epi32(sq, zero)));
+      clipped = _mm_add_epi64(clipped, _mm_sad_epu8(clip_cnt, zero));
+    }
+
+    uint64_t buf[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buf), sum_i);
+    sums.sum_i += buf[0] + buf[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buf), sum_q);
+    sums.sum_q += buf[0] + buf[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buf), sum_sq);
+    sums.sum_sq += buf[0] + buf[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buf), clipped);
+    sums.clipped += buf[0] + buf[1];
+    return end;
+  } /* convertSse2 */
+#endif
+
+
+#ifdef IQ_CONVERTER_NEON
+    /*
+     * The de-interleaving load split eight I/Q pairs into one vector of I
+     * values and one of Q values. The interleaving store put them back
+     * together after the conversion to float.
+     */
+  size_t convertNeon(float *out, const uint8_t *in, size_t bytes, Sums &sums)
+  {
+    const uint8x8_t zero = vdup_n_u8(0);
+    const uint8x8_t ones = vdup_n_u8(255);
+    const float32x4_t scale = vdupq_n_f32(SCALE);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const size_t end = bytes & ~static_cast<size_t>(15);
+    size_t i = 0;
+    while (i < end)
+    {
+      const size_t chunk_end = min(end, i + 16 * CHUNK_ITERATIONS);
+      uint32x4_t sum_i = vdupq_n_u32(0);
+      uint32x4_t sum_q = vdupq_n_u32(0);
+      uint32x4_t sq = vdupq_n_u32(0);
+      uint16x4_t clipped = vdup_n_u16(0);
+      for (; i < chunk_end; i += 16)
+      {
+        const uint8x8x2_t v = vld2_u8(in + i);
+        const uint8x8_t ci = vorr_u8(vceq_u8(v.val[0], ones),
+                                     vceq_u8(v.val[0], zero));
+        const uint8x8_t cq = vorr_u8(vceq_u8(v.val[1], ones),
+                                     vceq_u8(v.val[1], zero));
+        clipped = vpadal_u8(clipped, vadd_u8(vshr_n_u8(ci, 7),
+                                             vshr_n_u8(cq, 7)));
+
+        const uint16x8_t wi = vmovl_u8(v.val[0]);
+        const uint16x8_t wq = vmovl_u8(v.val[1]);
+        sum_i = vpadalq_u16(sum_i, wi);
+        sum_q = vpadalq_u16(sum_q, wq);
+        sq = vmlal_u16(sq, vget_low_u16(wi), vget_low_u16(wi));
+        sq = vmlal_u16(sq, vget_high_u16(wi), vget_high_u16(wi));
+        sq = vmlal_u16(sq, vget_low_u16(wq), vget_low_u16(wq));
+        sq = vmlal_u16(sq, vget_high_u16(wq), vget_high_u16(wq));
+
+        float32x4x2_t f;
+        f.val[0] = vsubq_f32(vmulq_f32(
+              vcvtq_f32_u32(vmovl_u16(vget_low_u16(wi))), scale), one);
+        f.val[1] = vsubq_f32(vmulq_f32(
+              vcvtq_f32_u32(vmovl_u16(vget_low_u16(wq))), scale), one);
+        vst2q_f32(out + i, f);
+        f.val[0] = vsubq_f32(vmulq_f32(
+              vcvtq_f32_u32(vmovl_u16(vget_high_u16(wi))), scale), one);
+        f.val[1] = vsubq_f32(vmulq_f32(
+              vcvtq_f32_u32(vmovl_u16(vget_high_u16(wq))), scale), one);
+        vst2q_f32(out + i + 8, f);
+      }
+      const uint64x2_t si = vpaddlq_u32(sum_i);
+      const uint64x2_t sqi = vpaddlq_u32(sum_q);
+      const uint64x2_t ssq = vpaddlq_u32(sq);
+      const uint64x1_t cl = vpaddl_u32(vpaddl_u16(clipped));
+      sums.sum_i += vgetq_lane_u64(si, 0) + vgetq_lane_u64(si, 1);
+      sums.sum_q += vgetq_lane_u64(sqi, 0) + vgetq_lane_u64(sqi, 1);
+      sums.sum_sq += vgetq_lane_u64(ssq, 0) + vgetq_lane_u64(ssq, 1);
+      sums.clipped += vget_lane_u64(cl, 0);
+    }
+    return end;
+  } /* convertNeon */
+#endif
+
+
+}; /* End of anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+void IqConverter::convert(Sample *out, const complex<uint8_t> *in,
+                          size_t count, Stats &stats)
+{
+  float *fout = reinterpret_cast<float*>(out);
+  const uint8_t *bin = reinterpret_cast<const uint8_t*>(in);
+  const size_t bytes = 2 * count;
+  Sums sums;
+  size_t done = 0;
+#if defined(IQ_CONVERTER_SSE2)
+  done = convertSse2(fout, bin, bytes, sums);
+#elif defined(IQ_CONVERTER_NEON)
+  done = convertNeon(fout, bin, bytes, sums);
+#endif
+  convertGeneric(fout + done, bin + done, bytes - done, sums);
+
+  stats.samples = count;
+  stats.clipped = sums.clipped;
+  if (count == 0)
+  {
+    stats.dc = 0.0f;
+    stats.rms = 0.0f;
+    return;
+  }
+
+    // With x the raw value, the sample value is (x - c) / c where c is
+    // 127.5, so the sum of the squared sample values can be calculated
+    // from the sums of x and x^2.
+  const double c = 127.5;
+  const double n = count;
+  stats.dc = Sample(sums.sum_i / (n * c) - 1.0, sums.sum_q / (n * c) - 1.0);
+  const double sum_sq = sums.sum_sq - 2.0 * c * (sums.sum_i + sums.sum_q) +
+                        2.0 * n * c * c;
+  stats.rms = sqrt(max(0.0, sum_sq / (n * c * c)));
+} /* IqConverter::convert */
+
+
+const char *IqConverter::implName(void)
+{
+#if defined(IQ_CONVERTER_SSE2)
+  return "SSE2";
+#elif defined(IQ_CONVERTER_NEON)
+  return "NEON";
+#else
+  return "generic";
+#endif
+} /* IqConverter::implName */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
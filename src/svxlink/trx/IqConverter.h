@@ -0,0 +1,164 @@
+/**
+@file   IqConverter.h
+@brief  Convert 8 bit I/Q samples to float and gather block statistics
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef IQ_CONVERTER_INCLUDED
+#define IQ_CONVERTER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <complex>
+#include <stdint.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Convert 8 bit I/Q samples from a RTL2832U to float
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+The RTL2832U deliver unsigned 8 bit I/Q samples with an offset of 127.5. This
+class convert them to complex floats in the range -1 to 1. While doing that,
+statistics about the block are gathered in the same pass: the number of
+clipped components, the DC offset and the RMS level. The conversion use SSE2
+on x86 and NEON on ARM, which handle 16 bytes per iteration without any
+branches. The statistics are summed as integers so they are exact and the
+same for all implementations.
+*/
+class IqConverter
+{
+  public:
+    typedef std::complex<float> Sample;
+
+    /**
+     * @brief   Statistics for a block of samples
+     */
+    struct Stats
+    {
+      size_t  samples;  ///< The number of complex samples in the block
+      size_t  clipped;  ///< The number of I or Q values at 0 or 255
+      Sample  dc;       ///< The mean of the samples
+      float   rms;      ///< The RMS magnitude of the samples, DC included
+
+      Stats(void) : samples(0), clipped(0), dc(0.0f), rms(0.0f) {}
+    };
+
+    /**
+     * @brief   Convert a block of samples
+     * @param   out     Where to store the converted samples
+     * @param   in      The 8 bit samples to convert
+     * @param   count   The number of complex samples to convert
+     * @param   stats   Set to the statistics for the block
+     */
+    static void convert(Sample *out, const std::complex<uint8_t> *in,
+                        size_t count, Stats &stats);
+
+    /**
+     * @brief   Get the name of the implementation in use
+     * @return  Returns "SSE2", "NEON" or "generic"
+     */
+    static const char *implName(void);
+
+};  /* class IqConverter */
+
+
+//} /* namespace */
+
+#endif /* IQ_CONVERTER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
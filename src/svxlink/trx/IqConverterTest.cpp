@@ -0,0 +1,167 @@
+#include <time.h>
+
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "IqConverter.h"
+
+using namespace std;
+
+
+/*
+ * Verify the IqConverter class against a plain per sample implementation
+ *
+ * Usage: IqConverterTest
+ *
+ * Blocks of random size, some of them larger than the accumulation chunk of
+ * the SIMD implementation, are filled with random 8 bit samples with a DC
+ * offset and some clipping. The converted samples and the block statistics
+ * must match the plain implementation. The time used by both
+ * implementations for a 2.4MHz block is printed. The exit status is zero if
+ * all tests pass.
+ */
+
+namespace {
+  typedef IqConverter::Sample Sample;
+
+  const double MAX_ERROR = 1.0e-6;
+
+  mt19937 rng(4711);
+
+  void convertRef(vector<Sample> &out, const vector<complex<uint8_t> > &in,
+                  IqConverter::Stats &stats)
+  {
+    complex<double> sum(0.0);
+    double sum_sq = 0.0;
+    stats = IqConverter::Stats();
+    stats.samples = in.size();
+    out.resize(in.size());
+    for (size_t idx=0; idx<in.size(); ++idx)
+    {
+      for (uint8_t x : { in[idx].real(), in[idx].imag() })
+      {
+        if ((x == 0) || (x == 255))
+        {
+          stats.clipped += 1;
+        }
+      }
+      float i = in[idx].real();
+      i = i / 127.5f - 1.0f;
+      float q = in[idx].imag();
+      q = q / 127.5f - 1.0f;
+      out[idx] = Sample(i, q);
+      sum += complex<double>(i, q);
+      sum_sq += norm(complex<double>(i, q));
+    }
+    if (!in.empty())
+    {
+      stats.dc = Sample(sum / static_cast<double>(in.size()));
+      stats.rms = sqrt(sum_sq / in.size());
+    }
+  }
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  void fill(vector<complex<uint8_t> > &in, size_t count)
+  {
+    normal_distribution<double> dist(0.0, 40.0);
+    uniform_int_distribution<int> dc_dist(-20, 20);
+    const double dc_i = 127.5 + dc_dist(rng);
+    const double dc_q = 127.5 + dc_dist(rng);
+    auto clamp = [](double x) {
+      return static_cast<uint8_t>(min(255.0, max(0.0, round(x))));
+    };
+    in.resize(count);
+    for (auto& s : in)
+    {
+      s = complex<uint8_t>(clamp(dc_i + dist(rng)), clamp(dc_q + dist(rng)));
+    }
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  cout << "Implementation: " << IqConverter::implName() << endl;
+
+  int failed = 0;
+  uniform_int_distribution<size_t> size_dist(0, 100000);
+  vector<complex<uint8_t> > in;
+  vector<Sample> out, ref;
+  for (int i=0; i<100; ++i)
+  {
+    const size_t count = (i < 20) ? i : size_dist(rng);
+    fill(in, count);
+    IqConverter::Stats stats, ref_stats;
+    out.assign(count, Sample(99.0f));
+    IqConverter::convert(out.data(), in.data(), count, stats);
+    convertRef(ref, in, ref_stats);
+
+    double max_err = 0.0;
+    for (size_t n=0; n<count; ++n)
+    {
+      max_err = max(max_err, static_cast<double>(abs(out[n] - ref[n])));
+    }
+    const bool ok = (max_err <= MAX_ERROR) &&
+                    (stats.samples == ref_stats.samples) &&
+                    (stats.clipped == ref_stats.clipped) &&
+                    (abs(stats.dc - ref_stats.dc) <= MAX_ERROR) &&
+                    (abs(stats.rms - ref_stats.rms) <= MAX_ERROR);
+    if (!ok)
+    {
+      cout << "FAILED count=" << count << " max_err=" << max_err
+           << " clipped=" << stats.clipped << "/" << ref_stats.clipped
+           << " dc=" << stats.dc << "/" << ref_stats.dc
+           << " rms=" << stats.rms << "/" << ref_stats.rms << endl;
+      failed += 1;
+    }
+  }
+  cout << (failed == 0 ? "OK" : "FAILED") << endl;
+
+    // The plain conversion only check for clipping, like RtlSdr used to do
+  const size_t count = 24000;
+  const int blocks = 1000;
+  fill(in, count);
+  out.resize(count);
+  size_t clipped = 0;
+  double start = cpuTime();
+  for (int i=0; i<blocks; ++i)
+  {
+    for (size_t idx=0; idx<count; ++idx)
+    {
+      if ((in[idx].real() == 255) || (in[idx].imag() == 255))
+      {
+        clipped += 1;
+      }
+      float i = in[idx].real();
+      i = i / 127.5f - 1.0f;
+      float q = in[idx].imag();
+      q = q / 127.5f - 1.0f;
+      out[idx] = Sample(i, q);
+    }
+  }
+  const double t_ref = cpuTime() - start;
+  IqConverter::Stats stats;
+  start = cpuTime();
+  for (int i=0; i<blocks; ++i)
+  {
+    IqConverter::convert(out.data(), in.data(), count, stats);
+  }
+  const double t_conv = cpuTime() - start;
+  cout << "Clipped samples per block: " << (clipped / blocks) << endl;
+  cout << "Plain: " << (t_ref / blocks * 1e6) << "us/block, "
+       << IqConverter::implName() << ": " << (t_conv / blocks * 1e6)
+       << "us/block" << endl;
+
+  return (failed == 0) ? 0 : 1;
+}
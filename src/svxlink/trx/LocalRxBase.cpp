@@ -57,6 +57,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioAmp.h>
 #include <AsyncAudioPassthrough.h>
 #include <AsyncAudioDecimator.h>
+#include <AsyncAudioResampler.h>
 #include <AsyncAudioClipper.h>
 #include <AsyncAudioCompressor.h>
 #include <AsyncAudioFifo.h>
@@ -75,6 +76,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "SigLevDet.h"
 #include "DtmfDecoder.h"
 #include "ToneDetector.h"
+#include "ToneAnalyzer.h"
 #include "SquelchCtcss.h"
 #include "LocalRxBase.h"
 #include "multirate_filter_coeff.h"
@@ -238,7 +240,8 @@ LocalRxBase::LocalRxBase(Config &cfg, const std::string& name)
     tone_dets(0), sql_valve(0), delay(0), sql_tail_elim(0),
     preamp_gain(0), mute_valve(0), sql_hangtime(0), sql_extended_hangtime(0),
     sql_extended_hangtime_thresh(0), input_fifo(0), dtmf_muting_pre(0),
-    ob_afsk_deframer(0), ib_afsk_deframer(0), audio_dev_keep_open(false)
+    ob_afsk_deframer(0), ib_afsk_deframer(0), audio_dev_keep_open(false),
+    fullband_splitter(0), tone_analyzer(0)
 {
 } /* LocalRxBase::LocalRxBase */
 
@@ -336,15 +339,22 @@ bool LocalRxBase::initialize(void)
     prev_src = peak_meter;
   }
   
-    // If the sound card sample rate is higher than 16kHz (48kHz assumed),
-    // decimate it down to 16kHz
-  if (audioSampleRate() > 16000)
+    // If the sound card sample rate is 48kHz, decimate it down to 16kHz.
+    // Other sound card sample rates are converted to 16kHz using a
+    // rational resampler.
+  if (audioSampleRate() == 48000)
   {
     AudioDecimator *d1 = new AudioDecimator(3, coeff_48_16_wide,
 					    coeff_48_16_wide_taps);
     prev_src->registerSink(d1, true);
     prev_src = d1;
   }
+  else if ((audioSampleRate() > 8000) && (audioSampleRate() != 16000))
+  {
+    AudioResampler *r1 = new AudioResampler(audioSampleRate(), 16000);
+    prev_src->registerSink(r1, true);
+    prev_src = r1;
+  }
 
   AudioSplitter *siglevdet_splitter = 0;
   siglevdet_splitter = new AudioSplitter;
@@ -370,8 +380,8 @@ bool LocalRxBase::initialize(void)
   prev_src = siglevdet_splitter_pass;
 
 #if (INTERNAL_SAMPLE_RATE != 16000)
-    // If the sound card sample rate is higher than 8kHz (16 or 48kHz assumed)
-    // decimate it down to 8kHz.
+    // If the sound card sample rate is higher than 8kHz, the audio is now
+    // at 16kHz so decimate it down to 8kHz.
     // 16kHz audio to other consumers.
   if (audioSampleRate() > 8000)
   {
@@ -517,6 +527,16 @@ bool LocalRxBase::initialize(void)
         mem_fun(*ib_afsk_deframer, &HdlcDeframer::bitsReceived));
   }
 
+    // If configured, create a tone analyzer that calculate the bins for all
+    // tone detectors that use the same block parameters in one go
+  bool shared_tone_analysis = false;
+  cfg().getValue(name(), "SHARED_TONE_ANALYSIS", shared_tone_analysis);
+  if (shared_tone_analysis)
+  {
+    tone_analyzer = new ToneAnalyzer(INTERNAL_SAMPLE_RATE);
+    fullband_splitter->addSink(tone_analyzer, true);
+  }
+
     // Create a new audio splitter to handle tone detectors
   tone_dets = new AudioSplitter;
   prev_src->registerSink(tone_dets, true);
@@ -762,7 +782,8 @@ bool LocalRxBase::addToneDetector(float fq, int bw, float thresh,
   det->setDetectOverlapPercent(75);
   det->setDetectToneFrequencyTolerancePercent(50.0f * bw / fq);
   det->detected.connect(sigc::mem_fun(*this, &LocalRxBase::onToneDetected));
-  
+  det->setToneAnalyzer(tone_analyzer);
+
   tone_dets->addSink(det, true);
   
   return true;
@@ -79,6 +79,7 @@ namespace Async
 
 class Squelch;
 class HdlcDeframer;
+class ToneAnalyzer;
 
 
 /****************************************************************************
@@ -281,6 +282,7 @@ class LocalRxBase : public Rx
     HdlcDeframer *              ib_afsk_deframer;
     bool                        audio_dev_keep_open;
     Async::AudioSplitter *      fullband_splitter;
+    ToneAnalyzer *              tone_analyzer;
 
     int audioRead(float *samples, int count);
     void dtmfDigitActivated(char digit);
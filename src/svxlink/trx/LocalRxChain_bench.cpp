@@ -0,0 +1,285 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <random>
+#include <cstdlib>
+#include <memory>
+
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
+#include <AsyncAudioAmp.h>
+#include <AsyncAudioFilter.h>
+#include <AsyncAudioClipper.h>
+#include <AsyncAudioCompressor.h>
+#include <AsyncAudioSplitter.h>
+#include <AsyncAudioValve.h>
+#include <AsyncAudioPassthrough.h>
+#include <AsyncAudioStreamStateDetector.h>
+
+#include "Emphasis.h"
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * LocalRx audio chain benchmark
+ *
+ * Usage: LocalRxChain_bench [seconds of audio]
+ *
+ * The receive audio chain of a number of local receivers is built the same
+ * way as in LocalRxBase, from the preamp up to the splatter filter. Decimators
+ * and detectors are left out. The result is given as CPU time per receiver
+ * and how many times faster than real time the processing run.
+ *
+ * Then each stage is run on its own to get a per-stage CPU profile. An
+ * AudioPassthrough is run the same way. It does no processing so its cost is
+ * what passing a block between two audio pipe objects cost, which is the most
+ * that could be saved for each stage by fusing stages into one loop.
+ */
+
+namespace {
+  const int SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
+  const int BLOCK_SIZE = SAMPLE_RATE / 100;
+  const unsigned rx_counts[] = { 1, 4, 16 };
+
+  class NullSink : public AudioSink
+  {
+    public:
+      int writeSamples(const float *samples, int len) { return len; }
+      void flushSamples(void) { sourceAllSamplesFlushed(); }
+  };
+
+  class Source : public AudioSource
+  {
+    public:
+      void write(const vector<float> &block)
+      {
+        int written = sinkWriteSamples(block.data(), block.size());
+        if (written != static_cast<int>(block.size()))
+        {
+          cerr << "*** ERROR: Short write in audio chain" << endl;
+          exit(1);
+        }
+      }
+      void resumeOutput(void) {}
+      void allSamplesFlushed(void) {}
+  };
+
+  struct Stage
+  {
+    AudioSink*    sink;
+    AudioSource*  source;
+  };
+
+  enum
+  {
+    STAGE_PREAMP, STAGE_DEEMPH, STAGE_SPLITTER, STAGE_VOICEBAND,
+    STAGE_SQL_VALVE, STAGE_STATE_DET, STAGE_LIMITER, STAGE_CLIPPER,
+    STAGE_SPLATTER, STAGE_COUNT, STAGE_PASSTHROUGH = STAGE_COUNT
+  };
+
+  const char *stage_names[] =
+  {
+    "preamp", "deemphasis", "splitter", "voiceband filter", "squelch valve",
+    "state detector", "limiter", "clipper", "splatter filter", "empty stage"
+  };
+
+  Stage createStage(int stage)
+  {
+    switch (stage)
+    {
+      case STAGE_PREAMP:
+      {
+        AudioAmp *preamp = new AudioAmp;
+        preamp->setGain(3);
+        return Stage{preamp, preamp};
+      }
+
+      case STAGE_DEEMPH:
+      {
+        DeemphasisFilter *deemph_filt = new DeemphasisFilter;
+        return Stage{deemph_filt, deemph_filt};
+      }
+
+      case STAGE_SPLITTER:
+      {
+          // The fullband splitter, with a tone detector branch that just
+          // throw the samples away
+        AudioSplitter *splitter = new AudioSplitter;
+        splitter->addSink(new NullSink, true);
+        AudioPassthrough *pass = new AudioPassthrough;
+        splitter->addSink(pass, true);
+        return Stage{splitter, pass};
+      }
+
+      case STAGE_VOICEBAND:
+      {
+#if (INTERNAL_SAMPLE_RATE == 16000)
+        AudioFilter *voiceband_filter = new AudioFilter("BpCh12/-0.1/300-5000");
+#else
+        AudioFilter *voiceband_filter = new AudioFilter("BpCh12/-0.1/300-3500");
+#endif
+        return Stage{voiceband_filter, voiceband_filter};
+      }
+
+      case STAGE_SQL_VALVE:
+      {
+        AudioValve *sql_valve = new AudioValve;
+        sql_valve->setOpen(true);
+        return Stage{sql_valve, sql_valve};
+      }
+
+      case STAGE_STATE_DET:
+      {
+        AudioStreamStateDetector *state_det = new AudioStreamStateDetector;
+        return Stage{state_det, state_det};
+      }
+
+      case STAGE_LIMITER:
+      {
+        AudioCompressor *limit = new AudioCompressor;
+        limit->setThreshold(-1.0);
+        limit->setRatio(0.1);
+        limit->setAttack(2);
+        limit->setDecay(20);
+        limit->setOutputGain(1);
+        return Stage{limit, limit};
+      }
+
+      case STAGE_CLIPPER:
+      {
+        AudioClipper *clipper = new AudioClipper;
+        clipper->setClipLevel(0.98);
+        return Stage{clipper, clipper};
+      }
+
+      case STAGE_SPLATTER:
+      {
+#if (INTERNAL_SAMPLE_RATE == 16000)
+        AudioFilter *splatter_filter = new AudioFilter("LpCh9/-0.05/5000");
+#else
+        AudioFilter *splatter_filter = new AudioFilter("LpCh9/-0.05/3500");
+#endif
+        return Stage{splatter_filter, splatter_filter};
+      }
+
+      default:
+      {
+        AudioPassthrough *pass = new AudioPassthrough;
+        return Stage{pass, pass};
+      }
+    }
+  }
+
+    // A source, the given stages connected in order and a sink
+  class Pipeline
+  {
+    public:
+      explicit Pipeline(const vector<int> &stages)
+      {
+        AudioSource *prev_src = &src;
+        for (int stage : stages)
+        {
+          Stage s = createStage(stage);
+          prev_src->registerSink(s.sink, true);
+          prev_src = s.source;
+        }
+        prev_src->registerSink(&sink);
+      }
+
+      void write(const vector<float> &block) { src.write(block); }
+
+    private:
+      Source    src;
+      NullSink  sink;
+  };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  double run(const vector<int> &stages, unsigned pipe_cnt,
+             const vector<float> &in, int blocks)
+  {
+    vector<unique_ptr<Pipeline> > pipes;
+    for (unsigned i=0; i<pipe_cnt; ++i)
+    {
+      pipes.emplace_back(new Pipeline(stages));
+    }
+
+    const double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      for (auto& pipe : pipes)
+      {
+        pipe->write(in);
+      }
+    }
+    return cpuTime() - start;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 20.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  mt19937 rng(4711);
+  normal_distribution<float> dist(0.0f, 0.3f);
+  vector<float> in(BLOCK_SIZE);
+  for (auto& s : in)
+  {
+    s = dist(rng);
+  }
+
+  const int blocks = seconds * 100;
+  const double real_time = blocks / 100.0;
+  const double samples = static_cast<double>(blocks) * BLOCK_SIZE;
+
+  vector<int> chain;
+  for (int stage=0; stage<STAGE_COUNT; ++stage)
+  {
+    chain.push_back(stage);
+  }
+
+  cout << setw(10) << "receivers" << setw(16) << "chain"
+       << "  (CPU seconds per receiver / times real time)" << endl;
+  cout << fixed;
+  double t_chain = 0.0;
+  for (unsigned rx_cnt : rx_counts)
+  {
+    double t = run(chain, rx_cnt, in, blocks) / rx_cnt;
+    if (rx_cnt == 1)
+    {
+      t_chain = t;
+    }
+    cout << setw(10) << rx_cnt
+         << setw(9) << setprecision(4) << t
+         << setw(6) << setprecision(0) << (real_time / t) << "x"
+         << endl;
+  }
+
+  cout << endl << "Stage profile:" << endl;
+  for (int stage=0; stage<=STAGE_PASSTHROUGH; ++stage)
+  {
+    const double t = run(vector<int>(1, stage), 1, in, blocks);
+    cout << setw(18) << stage_names[stage]
+         << setw(10) << setprecision(2) << (1e9 * t / samples)
+         << " ns/sample"
+         << setw(6) << setprecision(0) << (100.0 * t / t_chain) << "%"
+         << endl;
+  }
+
+  return 0;
+}
@@ -67,6 +67,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioPassthrough.h>
 #include <AsyncAudioFifo.h>
 #include <AsyncAudioInterpolator.h>
+#include <AsyncAudioResampler.h>
 #include <AsyncAudioAmp.h>
 #include <AsyncAudioMixer.h>
 #include <AsyncAudioDebugger.h>
@@ -709,7 +710,7 @@ bool LocalTx::initialize(void)
   }
 #endif
 
-  if (audio_io->sampleRate() > 16000)
+  if (audio_io->sampleRate() == 48000)
   {
       // Interpolate sample rate to 48kHz
 #if (INTERNAL_SAMPLE_RATE == 8000)
@@ -722,6 +723,14 @@ bool LocalTx::initialize(void)
     prev_src->registerSink(i2, true);
     prev_src = i2;
   }
+  else if ((audio_io->sampleRate() > 8000) &&
+           (audio_io->sampleRate() != 16000))
+  {
+      // Convert the sample rate to the sound card sample rate
+    AudioResampler *r2 = new AudioResampler(16000, audio_io->sampleRate());
+    prev_src->registerSink(r2, true);
+    prev_src = r2;
+  }
   
     // Finally connect the whole audio pipe to the audio device
   prev_src->registerSink(audio_io, true);
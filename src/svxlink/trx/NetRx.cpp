@@ -189,6 +189,11 @@ bool NetRx::initialize(void)
   
   string auth_key;
   cfg.getValue(name(), "AUTH_KEY", auth_key);
+
+  bool udp_audio = false;
+  cfg.getValue(name(), "UDP_AUDIO", udp_audio);
+  unsigned udp_jitter_buffer_delay = 60;
+  cfg.getValue(name(), "UDP_JITTER_BUFFER_DELAY", udp_jitter_buffer_delay);
   
   audio_dec = AudioDecoder::create(audio_dec_name);
   if (audio_dec == 0)
@@ -222,6 +227,11 @@ bool NetRx::initialize(void)
     return false;
   }
   tcp_con->setAuthKey(auth_key);
+  if (udp_audio)
+  {
+    tcp_con->enableUdpAudio();
+  }
+  tcp_con->setUdpJitterBufferDelay(udp_jitter_buffer_delay);
   tcp_con->isReady.connect(mem_fun(*this, &NetRx::connectionReady));
   tcp_con->msgReceived.connect(mem_fun(*this, &NetRx::handleMsg));
   tcp_con->connect();
@@ -0,0 +1,298 @@
+/**
+@file   NetTrxJitterBuffer.cpp
+@brief  A jitter buffer for remote transceiver audio received over UDP
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "NetTrxJitterBuffer.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+NetTrxJitterBuffer::NetTrxJitterBuffer(unsigned delay_ms)
+  : m_delay(delay_ms), m_synced(false), m_next_seq(0), m_base_valid(false),
+    m_base(0), m_last_timestamp(0), m_mark_pending(false), m_mark_seq(0),
+    m_mark_timestamp(0)
+{
+} /* NetTrxJitterBuffer::NetTrxJitterBuffer */
+
+
+NetTrxJitterBuffer::~NetTrxJitterBuffer(void)
+{
+} /* NetTrxJitterBuffer::~NetTrxJitterBuffer */
+
+
+void NetTrxJitterBuffer::reset(void)
+{
+  m_packets.clear();
+  m_synced = false;
+  m_base_valid = false;
+  m_mark_pending = false;
+} /* NetTrxJitterBuffer::reset */
+
+
+bool NetTrxJitterBuffer::push(uint32_t seq, uint32_t timestamp,
+                              uint32_t tcp_cnt, const void *buf, int len,
+                              uint32_t now)
+{
+  assert(len >= 0);
+  ++m_stats.received;
+
+  if ((m_synced && seqBefore(seq, m_next_seq)) ||
+      (m_packets.find(seq) != m_packets.end()))
+  {
+    ++m_stats.late;
+    return false;
+  }
+
+    // The first packet of a transmission decide how the send time relate to
+    // the local time. After that the relation is only moved if a packet
+    // arrive faster than any packet before it.
+  const uint32_t transit = now - timestamp;
+  const bool new_transmission = m_synced && m_packets.empty() &&
+      !m_mark_pending &&
+      (static_cast<int32_t>(timestamp - m_last_timestamp) > REBASE_GAP);
+  if (!m_base_valid || new_transmission ||
+      (static_cast<int32_t>(transit - m_base) < 0))
+  {
+    m_base = transit;
+    m_base_valid = true;
+  }
+
+  Packet &pkt = m_packets[seq];
+  pkt.timestamp = timestamp;
+  pkt.tcp_cnt = tcp_cnt;
+  const uint8_t *ptr = static_cast<const uint8_t *>(buf);
+  pkt.payload.assign(ptr, ptr + len);
+
+    // Throw the oldest packet away if the buffer is full. This can only
+    // happen if the packets are held for a long time waiting for a TCP
+    // message.
+  if (m_packets.size() > MAX_PACKETS)
+  {
+    Packets::iterator it = m_packets.begin();
+    release(it->first);
+    m_packets.erase(it);
+    ++m_stats.lost;
+  }
+  m_stats.max_depth = max(m_stats.max_depth,
+                          static_cast<unsigned>(m_packets.size()));
+
+  return true;
+} /* NetTrxJitterBuffer::push */
+
+
+void NetTrxJitterBuffer::setMark(uint32_t seq, uint32_t timestamp,
+                                 uint32_t now)
+{
+  assert(!m_mark_pending);
+  m_mark_pending = true;
+  m_mark_seq = seq;
+  m_mark_timestamp = timestamp;
+
+    // If no packet has been received yet, the packets before the mark are
+    // given the delay of the buffer counted from when the mark arrived
+  if (!m_base_valid)
+  {
+    m_base = now - timestamp;
+    m_base_valid = true;
+  }
+} /* NetTrxJitterBuffer::setMark */
+
+
+NetTrxJitterBuffer::Result NetTrxJitterBuffer::next(uint32_t now,
+    uint32_t tcp_handled, vector<uint8_t> &payload)
+{
+  if (!m_packets.empty() && isBeforeMark(m_packets.begin()->first))
+  {
+    Packets::iterator it = m_packets.begin();
+    Packet &pkt = it->second;
+    if ((static_cast<int32_t>(tcp_handled - pkt.tcp_cnt) < 0) ||
+        (static_cast<int32_t>(now - playoutTime(pkt.timestamp)) < 0))
+    {
+      return NONE;
+    }
+    payload.swap(pkt.payload);
+    m_last_timestamp = pkt.timestamp;
+    release(it->first);
+    m_packets.erase(it);
+    ++m_stats.released;
+    return AUDIO;
+  }
+
+  if (m_mark_pending)
+  {
+    const bool all_released = m_synced && !seqBefore(m_next_seq, m_mark_seq);
+    if (!all_released &&
+        (static_cast<int32_t>(now - playoutTime(m_mark_timestamp)) < 0))
+    {
+      return NONE;
+    }
+    if (m_synced && seqBefore(m_next_seq, m_mark_seq))
+    {
+      m_stats.lost += m_mark_seq - m_next_seq;
+    }
+    m_next_seq = m_mark_seq;
+    m_synced = true;
+    m_mark_pending = false;
+    return MARK;
+  }
+
+  return NONE;
+} /* NetTrxJitterBuffer::next */
+
+
+int NetTrxJitterBuffer::timeToNext(uint32_t now, uint32_t tcp_handled) const
+{
+  if (!m_packets.empty() && isBeforeMark(m_packets.begin()->first))
+  {
+    const Packet &pkt = m_packets.begin()->second;
+    if (static_cast<int32_t>(tcp_handled - pkt.tcp_cnt) < 0)
+    {
+      return -1;
+    }
+    return max(0, static_cast<int32_t>(playoutTime(pkt.timestamp) - now));
+  }
+
+  if (m_mark_pending)
+  {
+    if (m_synced && !seqBefore(m_next_seq, m_mark_seq))
+    {
+      return 0;
+    }
+    return max(0, static_cast<int32_t>(playoutTime(m_mark_timestamp) - now));
+  }
+
+  return -1;
+} /* NetTrxJitterBuffer::timeToNext */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void NetTrxJitterBuffer::release(uint32_t seq)
+{
+  if (m_synced && seqBefore(m_next_seq, seq))
+  {
+    m_stats.lost += seq - m_next_seq;
+  }
+  m_next_seq = seq + 1;
+  m_synced = true;
+} /* NetTrxJitterBuffer::release */
+
+
+
+/*
+ * This file has not been truncated
+ */
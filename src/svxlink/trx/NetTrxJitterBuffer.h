@@ -0,0 +1,346 @@
+/**
+@file   NetTrxJitterBuffer.h
+@brief  A jitter buffer for remote transceiver audio received over UDP
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a jitter buffer that put audio packets received over UDP
+back in order and release them at an even pace. Packets that have not arrived
+when it is time to play them are skipped.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef NET_TRX_JITTER_BUFFER_INCLUDED
+#define NET_TRX_JITTER_BUFFER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A jitter buffer for remote transceiver audio received over UDP
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+Each packet carry a sequence number and the time, in milliseconds on the
+clock of the sender, when it was sent. The first packet of a transmission
+set up the relation between the clock of the sender and the local clock.
+Each packet is then held until its send time, plus the configured delay, has
+been reached on the local clock. If the network delay drop later on, the
+relation is moved so that the delay is always counted from the fastest packet
+seen. The packets are released in sequence number order. A packet that has
+not arrived when a packet with a higher sequence number is released is
+counted as lost. If it arrive later it is thrown away.
+
+The buffer also keep the audio in order with the messages sent over the TCP
+connection. Each packet carry the number of TCP messages that the sender had
+sent before the packet. A packet is not released until the same number of TCP
+messages have been handled on the receiving side. In the other direction, the
+sender put a mark in the TCP stream before a message that must not be handled
+until the audio sent before it has been played. The mark hold the sequence
+number of the next packet and the time it was sent. When the mark is set in
+the buffer, it is reached when all packets before it have been released or
+when the send time of the mark, plus the delay, has been reached. Packets
+before the mark that are still missing at that point are counted as lost.
+
+The buffer does not use any timers itself. The owner call the next function
+to get packets and use the timeToNext function to know when to call it again.
+*/
+class NetTrxJitterBuffer
+{
+  public:
+    /**
+     * @brief The result of a call to the next function
+     */
+    typedef enum
+    {
+      NONE,   ///< Nothing to release right now
+      AUDIO,  ///< An audio packet was released
+      MARK    ///< The mark was reached
+    } Result;
+
+    /**
+     * @brief Jitter buffer statistics
+     */
+    struct Stats
+    {
+      uint64_t  received;   ///< Number of packets received
+      uint64_t  released;   ///< Number of packets released
+      uint64_t  lost;       ///< Number of packets that never arrived in time
+      uint64_t  late;       ///< Number of late or duplicated packets
+      unsigned  max_depth;  ///< Maximum number of packets in the buffer
+
+      Stats(void) : received(0), released(0), lost(0), late(0), max_depth(0)
+      {}
+    };
+
+    /**
+     * @brief   The maximum number of packets to buffer
+     */
+    static const unsigned MAX_PACKETS = 256;
+
+    /**
+     * @brief   A gap in send time that start a new transmission
+     */
+    static const int REBASE_GAP = 1000;
+
+    /**
+     * @brief   Check if one sequence number come before another one
+     * @param   a The first sequence number
+     * @param   b The second sequence number
+     * @return  Returns \em true if a come before b
+     *
+     * Sequence numbers are compared so that they can wrap around.
+     */
+    static bool seqBefore(uint32_t a, uint32_t b)
+    {
+      return static_cast<int32_t>(a - b) < 0;
+    }
+
+    /**
+     * @brief   Constructor
+     * @param   delay_ms The number of milliseconds to delay the audio
+     */
+    explicit NetTrxJitterBuffer(unsigned delay_ms=60);
+
+    /**
+     * @brief   Destructor
+     */
+    ~NetTrxJitterBuffer(void);
+
+    /**
+     * @brief   Set the delay of the buffer
+     * @param   delay_ms The number of milliseconds to delay the audio
+     */
+    void setDelay(unsigned delay_ms) { m_delay = delay_ms; }
+
+    /**
+     * @brief   Get the delay of the buffer
+     * @return  Returns the number of milliseconds the audio is delayed
+     */
+    unsigned delay(void) const { return m_delay; }
+
+    /**
+     * @brief   Throw away all packets and the mark and start over
+     *
+     * The statistics are kept. Use resetStats to clear them.
+     */
+    void reset(void);
+
+    /**
+     * @brief   Add a received packet to the buffer
+     * @param   seq       The sequence number of the packet
+     * @param   timestamp The send time of the packet in milliseconds
+     * @param   tcp_cnt   The number of TCP messages sent before the packet
+     * @param   buf       The payload of the packet
+     * @param   len       The number of bytes in the payload
+     * @param   now       The local time in milliseconds
+     * @return  Returns \em false if the packet was late or a duplicate
+     *
+     * There is no time limit on how long a packet wait for the TCP messages
+     * sent before it. The buffer is only capped by throwing the oldest
+     * packet away, counted as lost, when more than MAX_PACKETS are held.
+     * A peer that never send the TCP messages or the mark that the packets
+     * wait for can therefore hold back the audio until the buffer overflow
+     * or until the owner fall back to TCP audio when no datagram has been
+     * received for NetTrxUdpAudio::HEARTBEAT_TIMEOUT (15 seconds).
+     */
+    bool push(uint32_t seq, uint32_t timestamp, uint32_t tcp_cnt,
+              const void *buf, int len, uint32_t now);
+
+    /**
+     * @brief   Set the mark
+     * @param   seq       The sequence number of the first packet after the mark
+     * @param   timestamp The time the mark was sent in milliseconds
+     * @param   now       The local time in milliseconds
+     *
+     * Only one mark can be set at a time.
+     */
+    void setMark(uint32_t seq, uint32_t timestamp, uint32_t now);
+
+    /**
+     * @brief   Check if a mark is set that has not been reached yet
+     * @return  Returns \em true if the mark has not been reached
+     */
+    bool markPending(void) const { return m_mark_pending; }
+
+    /**
+     * @brief   Release the next packet or the mark if it is time to do so
+     * @param   now           The local time in milliseconds
+     * @param   tcp_handled   The number of TCP messages handled so far
+     * @param   payload       The payload of a released packet is put here
+     * @return  Returns what was released, if anything
+     */
+    Result next(uint32_t now, uint32_t tcp_handled,
+                std::vector<uint8_t> &payload);
+
+    /**
+     * @brief   Find out when the next function should be called again
+     * @param   now           The local time in milliseconds
+     * @param   tcp_handled   The number of TCP messages handled so far
+     * @return  Returns the time in milliseconds or -1 if there is no need to
+     *          call the next function until more packets or TCP messages
+     *          have been received
+     */
+    int timeToNext(uint32_t now, uint32_t tcp_handled) const;
+
+    /**
+     * @brief   Get the number of packets in the buffer
+     * @return  Returns the number of packets waiting to be released
+     */
+    unsigned size(void) const { return m_packets.size(); }
+
+    /**
+     * @brief   Get the statistics
+     * @return  Returns the statistics collected since the last reset
+     */
+    const Stats& stats(void) const { return m_stats; }
+
+    /**
+     * @brief   Reset the statistics
+     */
+    void resetStats(void) { m_stats = Stats(); }
+
+  private:
+    struct Packet
+    {
+      uint32_t              timestamp;
+      uint32_t              tcp_cnt;
+      std::vector<uint8_t>  payload;
+    };
+    struct SeqLess
+    {
+      bool operator()(uint32_t a, uint32_t b) const
+      {
+        return seqBefore(a, b);
+      }
+    };
+    typedef std::map<uint32_t, Packet, SeqLess> Packets;
+
+    unsigned  m_delay;
+    Packets   m_packets;
+    bool      m_synced;
+    uint32_t  m_next_seq;
+    bool      m_base_valid;
+    uint32_t  m_base;
+    uint32_t  m_last_timestamp;
+    bool      m_mark_pending;
+    uint32_t  m_mark_seq;
+    uint32_t  m_mark_timestamp;
+    Stats     m_stats;
+
+    NetTrxJitterBuffer(const NetTrxJitterBuffer&);
+    NetTrxJitterBuffer& operator=(const NetTrxJitterBuffer&);
+    uint32_t playoutTime(uint32_t timestamp) const
+    {
+      return m_base + timestamp + m_delay;
+    }
+    bool isBeforeMark(uint32_t seq) const
+    {
+      return !m_mark_pending || seqBefore(seq, m_mark_seq);
+    }
+    void release(uint32_t seq);
+
+};  /* class NetTrxJitterBuffer */
+
+
+//} /* namespace */
+
+#endif /* NET_TRX_JITTER_BUFFER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -278,6 +278,105 @@ class MsgAuthOk : public Msg
 
 
 
+/****************************** UDP Audio Messages ***************************/
+
+/*
+ * Audio can be sent over UDP instead of over the TCP connection. The client
+ * ask for it by sending a MsgUdpAudioRequest when the connection is ready.
+ * A server that support UDP audio, and has it enabled, answer with a
+ * MsgUdpAudioSetup. A server that does not support it will just complain
+ * about an unknown message and audio will continue to go over TCP. Each UDP
+ * datagram start with an UdpAudioHeader. If an authentication key is used,
+ * the rest of the datagram is encrypted using AES-128-GCM with the header as
+ * associated data.
+ */
+
+class MsgUdpAudioRequest : public Msg
+{
+  public:
+    static const unsigned TYPE = 20;
+    MsgUdpAudioRequest(void) : Msg(TYPE, sizeof(MsgUdpAudioRequest)) {}
+
+};  /* MsgUdpAudioRequest */
+
+
+class MsgUdpAudioSetup : public Msg
+{
+  public:
+    static const unsigned TYPE = 21;
+    MsgUdpAudioSetup(uint16_t udp_port, uint32_t session_id, bool encrypted)
+      : Msg(TYPE, sizeof(MsgUdpAudioSetup)), m_udp_port(udp_port),
+        m_session_id(session_id), m_encrypted(encrypted ? 1 : 0) {}
+    uint16_t udpPort(void) const { return m_udp_port; }
+    uint32_t sessionId(void) const { return m_session_id; }
+    bool encrypted(void) const { return m_encrypted != 0; }
+
+  private:
+    uint16_t  m_udp_port;
+    uint32_t  m_session_id;
+    uint8_t   m_encrypted;
+
+};  /* MsgUdpAudioSetup */
+
+
+/*
+ * Sent before a TCP message that must not be handled by the receiver until
+ * all audio sent over UDP before it has been played. The sequence number is
+ * the one that the next UDP audio datagram will get.
+ */
+class MsgUdpAudioMark : public Msg
+{
+  public:
+    static const unsigned TYPE = 22;
+    MsgUdpAudioMark(uint32_t seq, uint32_t timestamp)
+      : Msg(TYPE, sizeof(MsgUdpAudioMark)), m_seq(seq),
+        m_timestamp(timestamp) {}
+    uint32_t seq(void) const { return m_seq; }
+    uint32_t timestamp(void) const { return m_timestamp; }
+
+  private:
+    uint32_t  m_seq;
+    uint32_t  m_timestamp;
+
+};  /* MsgUdpAudioMark */
+
+
+class UdpAudioHeader
+{
+  public:
+    static const uint8_t  TYPE_HEARTBEAT  = 1;
+    static const uint8_t  TYPE_AUDIO      = 2;
+    static const size_t   KEY_LEN         = 16;
+    static const size_t   IV_LEN          = 12;
+    static const size_t   TAG_LEN         = 8;
+    static const char *cipherName(void) { return "AES-128-GCM"; }
+
+    UdpAudioHeader(void)
+      : m_session_id(0), m_cntr(0), m_seq(0), m_tcp_cnt(0), m_timestamp(0),
+        m_type(0) {}
+    UdpAudioHeader(uint8_t type, uint32_t session_id, uint32_t cntr,
+                   uint32_t seq, uint32_t tcp_cnt, uint32_t timestamp)
+      : m_session_id(session_id), m_cntr(cntr), m_seq(seq),
+        m_tcp_cnt(tcp_cnt), m_timestamp(timestamp), m_type(type) {}
+    uint8_t type(void) const { return m_type; }
+    uint32_t sessionId(void) const { return m_session_id; }
+    uint32_t cntr(void) const { return m_cntr; }
+    uint32_t seq(void) const { return m_seq; }
+    uint32_t tcpCnt(void) const { return m_tcp_cnt; }
+    uint32_t timestamp(void) const { return m_timestamp; }
+
+  private:
+    uint32_t  m_session_id;
+    uint32_t  m_cntr;
+    uint32_t  m_seq;
+    uint32_t  m_tcp_cnt;
+    uint32_t  m_timestamp;
+    uint8_t   m_type;
+
+};  /* UdpAudioHeader */
+
+
+
 
 
 /****************************** Common Messages *****************************/
@@ -185,6 +185,25 @@ void NetTrxTcpClient::deleteInstance(void)
 
 void NetTrxTcpClient::sendMsg(Msg *msg)
 {
+  if (state == STATE_READY)
+  {
+    if (msg->type() == MsgAudio::TYPE)
+    {
+      MsgAudio *audio_msg = reinterpret_cast<MsgAudio*>(msg);
+      if (udp_audio.sendAudio(audio_msg->buf(), audio_msg->size()))
+      {
+        delete msg;
+        return;
+      }
+    }
+      // Audio sent over UDP must be played before this message is handled
+    MsgUdpAudioMark *mark_msg = udp_audio.createMark();
+    if (mark_msg != 0)
+    {
+      sendMsgP(mark_msg);
+    }
+  }
+
   if (state == STATE_READY)
   {
     sendMsgP(msg);
@@ -215,7 +234,8 @@ NetTrxTcpClient::NetTrxTcpClient(const std::string& remote_host,
       	      	      	      	 uint16_t remote_port, size_t recv_buf_len)
   : TcpClient<>(remote_host, remote_port, recv_buf_len), recv_cnt(0),
     recv_exp(0), reconnect_timer(0), last_msg_timestamp(), heartbeat_timer(0),
-    user_cnt(0), state(STATE_DISC), disc_reason(DR_SYSTEM_ERROR)
+    user_cnt(0), state(STATE_DISC), disc_reason(DR_SYSTEM_ERROR),
+    udp_audio_enabled(false), auth_challenge(), auth_challenge_valid(false)
 {
   connected.connect(mem_fun(*this, &NetTrxTcpClient::tcpConnected));
   disconnected.connect(mem_fun(*this, &NetTrxTcpClient::tcpDisconnected));
@@ -228,6 +248,10 @@ NetTrxTcpClient::NetTrxTcpClient(const std::string& remote_host,
   heartbeat_timer = new Timer(10000);
   heartbeat_timer->setEnable(false);
   heartbeat_timer->expired.connect(mem_fun(*this, &NetTrxTcpClient::heartbeat));
+
+  udp_audio.msgReceived.connect(mem_fun(*this, &NetTrxTcpClient::handleMsg));
+  udp_audio.activeChanged.connect(
+      mem_fun(*this, &NetTrxTcpClient::udpAudioActiveChanged));
   
 } /* NetTrxTcpClient::NetTrxTcpClient */
 
@@ -254,6 +278,8 @@ void NetTrxTcpClient::tcpConnected(void)
   recv_exp = sizeof(Msg);
   gettimeofday(&last_msg_timestamp, NULL);
   heartbeat_timer->setEnable(true);
+  udp_audio.reset();
+  auth_challenge_valid = false;
   state = STATE_VER_WAIT;
 } /* NetTx::tcpConnected */
 
@@ -264,6 +290,7 @@ void NetTrxTcpClient::tcpDisconnected(TcpConnection *con,
   disc_reason = reason;
   recv_exp = 0;
   state = STATE_DISC;
+  udp_audio.reset();
   reconnect_timer->setEnable(true);
   heartbeat_timer->setEnable(false);
   isReady(false);
@@ -304,7 +331,7 @@ int NetTrxTcpClient::tcpDataReceived(TcpConnection *con, void *data, int size)
       	Msg *msg = reinterpret_cast<Msg*>(recv_buf);
 	if (msg->size() == sizeof(Msg))
 	{
-	  handleMsg(msg);
+	  udp_audio.tcpMsgReceived(msg);
 	  recv_cnt = 0;
 	  recv_exp = sizeof(Msg);
 	}
@@ -325,7 +352,7 @@ int NetTrxTcpClient::tcpDataReceived(TcpConnection *con, void *data, int size)
       else
       {
       	Msg *msg = reinterpret_cast<Msg*>(recv_buf);
-	handleMsg(msg);
+	udp_audio.tcpMsgReceived(msg);
 	recv_cnt = 0;
 	recv_exp = sizeof(Msg);
       }
@@ -391,6 +418,9 @@ void NetTrxTcpClient::handleMsg(Msg *msg)
           return;
         }
         MsgAuthChallenge *chal_msg = reinterpret_cast<MsgAuthChallenge*>(msg);
+        memcpy(auth_challenge, chal_msg->challenge(),
+               MsgAuthChallenge::CHALLENGE_LEN);
+        auth_challenge_valid = true;
         MsgAuthResponse *resp_msg =
             new MsgAuthResponse(auth_key, chal_msg->challenge());
         sendMsgP(resp_msg);
@@ -406,6 +436,14 @@ void NetTrxTcpClient::handleMsg(Msg *msg)
           return;
         }
         state = STATE_READY;
+        if (udp_audio_enabled)
+        {
+          sendMsgP(new MsgUdpAudioRequest);
+          if (state != STATE_READY)
+          {
+            return;
+          }
+        }
         isReady(true);
       }
       return;
@@ -423,6 +461,10 @@ void NetTrxTcpClient::handleMsg(Msg *msg)
       break;
     }
     
+    case MsgUdpAudioSetup::TYPE:
+      handleUdpAudioSetup(reinterpret_cast<MsgUdpAudioSetup*>(msg));
+      break;
+
     case MsgProtoVer::TYPE:
     case MsgAuthChallenge::TYPE:
     case MsgAuthOk::TYPE:
@@ -475,6 +517,7 @@ void NetTrxTcpClient::sendMsgP(Msg *msg)
 {
   assert(isConnected());
 
+  udp_audio.tcpMsgSent();
   int written = write(msg, msg->size());
   if (written != static_cast<int>(msg->size()))
   {
@@ -496,6 +539,57 @@ void NetTrxTcpClient::sendMsgP(Msg *msg)
 } /* NetTrxTcpClient::sendMsgP */
 
 
+void NetTrxTcpClient::handleUdpAudioSetup(MsgUdpAudioSetup *msg)
+{
+  if (msg->size() != sizeof(MsgUdpAudioSetup))
+  {
+    cerr << "*** ERROR: Protocol error. Wrong length of "
+            "MsgUdpAudioSetup message. Disconnecting from "
+         << remoteHost().toString() << ":" << remotePort() << "...\n";
+    localDisconnect();
+    return;
+  }
+
+  if (!udp_audio_enabled || udp_audio.isStarted())
+  {
+    return;
+  }
+
+  vector<uint8_t> key;
+  if (msg->encrypted())
+  {
+    if (auth_key.empty() || !auth_challenge_valid)
+    {
+      cerr << "*** WARNING: " << remoteHost().toString() << ":"
+           << remotePort() << ": Encrypted UDP audio requested but no "
+              "authentication key is set. Sending audio over TCP.\n";
+      return;
+    }
+    if (!NetTrxUdpAudio::deriveKey(key, auth_key, auth_challenge,
+                                   msg->sessionId()))
+    {
+      return;
+    }
+  }
+
+  if (!udp_audio.startClient(remoteHost(), msg->udpPort(), msg->sessionId(),
+                             key))
+  {
+    cerr << "*** WARNING: " << remoteHost().toString() << ":"
+         << remotePort() << ": Could not set up the UDP audio channel. "
+            "Sending audio over TCP.\n";
+  }
+} /* NetTrxTcpClient::handleUdpAudioSetup */
+
+
+void NetTrxTcpClient::udpAudioActiveChanged(bool is_active)
+{
+  cout << remoteHost().toString() << ":" << remotePort() << ": "
+       << (is_active ? "Sending audio over UDP" : "Sending audio over TCP")
+       << (udp_audio.isEncrypted() ? " (encrypted)" : "") << endl;
+} /* NetTrxTcpClient::udpAudioActiveChanged */
+
+
 
 /*
  * This file has not been truncated
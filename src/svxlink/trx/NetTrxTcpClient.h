@@ -58,6 +58,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "NetTrxMsg.h"
+#include "NetTrxUdpAudio.h"
 
 
 /****************************************************************************
@@ -146,6 +147,25 @@ class NetTrxTcpClient : public Async::TcpClient<>
      * @param key The autentication key to use
      */
     void setAuthKey(const std::string &key) { auth_key = key; }
+
+    /**
+     * @brief Request that audio is sent over UDP
+     *
+     * The UDP audio channel is requested from the remote side after the
+     * next successful authentication. If the remote side does not support
+     * it, or if the UDP datagrams do not get through, the audio is sent over
+     * the TCP connection as usual.
+     */
+    void enableUdpAudio(void) { udp_audio_enabled = true; }
+
+    /**
+     * @brief Set the delay of the jitter buffer for audio received over UDP
+     * @param delay_ms The delay in milliseconds
+     */
+    void setUdpJitterBufferDelay(unsigned delay_ms)
+    {
+      udp_audio.setJitterBufferDelay(delay_ms);
+    }
     
     /**
      * @brief Send a message over the connection
@@ -222,6 +242,10 @@ class NetTrxTcpClient : public Async::TcpClient<>
     std::string     auth_key;
     State           state;
     DiscReason      disc_reason;
+    NetTrxUdpAudio  udp_audio;
+    bool            udp_audio_enabled;
+    unsigned char   auth_challenge[NetTrxMsg::MsgAuthChallenge::CHALLENGE_LEN];
+    bool            auth_challenge_valid;
     
     NetTrxTcpClient(const NetTrxTcpClient&);
     using TcpClientBase::operator=;
@@ -236,6 +260,8 @@ class NetTrxTcpClient : public Async::TcpClient<>
     void heartbeat(Async::Timer *t);
     void localDisconnect(void);
     void sendMsgP(NetTrxMsg::Msg *msg);
+    void handleUdpAudioSetup(NetTrxMsg::MsgUdpAudioSetup *msg);
+    void udpAudioActiveChanged(bool is_active);
 
 };  /* class NetTrxTcpClient */
 
@@ -0,0 +1,548 @@
+/**
+@file   NetTrxUdpAudio.cpp
+@brief  An UDP audio channel for remote transceiver connections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <gcrypt.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncEncryptedUdpSocket.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "NetTrxUdpAudio.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace NetTrxMsg;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool NetTrxUdpAudio::deriveKey(vector<uint8_t> &key, const string &auth_key,
+                               const unsigned char *challenge,
+                               uint32_t session_id)
+{
+  static const char label[] = "UDP audio";
+
+  gcry_md_hd_t hd = { 0 };
+  gcry_error_t err = gcry_md_open(&hd, GCRY_MD_SHA1, GCRY_MD_FLAG_HMAC);
+  if (!err)
+  {
+    err = gcry_md_setkey(hd, auth_key.data(), auth_key.size());
+  }
+  if (err)
+  {
+    gcry_md_close(hd);
+    cerr << "*** ERROR: gcrypt error: " << gcry_strsource(err) << "/"
+         << gcry_strerror(err) << endl;
+    return false;
+  }
+  gcry_md_write(hd, challenge, MsgAuthChallenge::CHALLENGE_LEN);
+  gcry_md_write(hd, label, sizeof(label) - 1);
+  gcry_md_write(hd, &session_id, sizeof(session_id));
+  const unsigned char *digest = gcry_md_read(hd, 0);
+  key.assign(digest, digest + UdpAudioHeader::KEY_LEN);
+  gcry_md_close(hd);
+  return true;
+} /* NetTrxUdpAudio::deriveKey */
+
+
+NetTrxUdpAudio::NetTrxUdpAudio(void)
+  : m_sock(0),
+    m_heartbeat_timer(HEARTBEAT_INTERVAL, Timer::TYPE_PERIODIC, false),
+    m_jb_timer(0, Timer::TYPE_ONESHOT, false), m_epoch(Clock::now()),
+    m_peer_port(0), m_is_server(false), m_session_id(0), m_encrypted(false),
+    m_active(false), m_last_rx(0), m_tx_cntr(0), m_tx_seq(0),
+    m_audio_since_mark(false), m_tcp_tx_cnt(0), m_tcp_rx_cnt(0),
+    m_reset_cnt(0)
+{
+  m_heartbeat_timer.expired.connect(
+      mem_fun(*this, &NetTrxUdpAudio::heartbeat));
+  m_jb_timer.expired.connect(
+      mem_fun(*this, &NetTrxUdpAudio::jitterBufferTimeout));
+} /* NetTrxUdpAudio::NetTrxUdpAudio */
+
+
+NetTrxUdpAudio::~NetTrxUdpAudio(void)
+{
+  delete m_sock;
+} /* NetTrxUdpAudio::~NetTrxUdpAudio */
+
+
+bool NetTrxUdpAudio::startServer(uint16_t local_port, const IpAddress &peer_ip,
+                                 uint32_t session_id,
+                                 const vector<uint8_t> &key)
+{
+  m_is_server = true;
+  m_peer_ip = peer_ip;
+  m_peer_port = 0;
+  m_session_id = session_id;
+  return start(local_port, key);
+} /* NetTrxUdpAudio::startServer */
+
+
+bool NetTrxUdpAudio::startClient(const IpAddress &peer_ip, uint16_t peer_port,
+                                 uint32_t session_id,
+                                 const vector<uint8_t> &key)
+{
+  m_is_server = false;
+  m_peer_ip = peer_ip;
+  m_peer_port = peer_port;
+  m_session_id = session_id;
+  if (!start(0, key))
+  {
+    return false;
+  }
+  sendDatagram(UdpAudioHeader::TYPE_HEARTBEAT, 0, 0, 0);
+  return true;
+} /* NetTrxUdpAudio::startClient */
+
+
+void NetTrxUdpAudio::reset(void)
+{
+  stop();
+  m_tcp_tx_cnt = 0;
+  m_tcp_rx_cnt = 0;
+  m_tcp_queue.clear();
+  m_reset_cnt += 1;
+} /* NetTrxUdpAudio::reset */
+
+
+uint16_t NetTrxUdpAudio::localPort(void) const
+{
+  return (m_sock != 0) ? m_sock->localPort() : 0;
+} /* NetTrxUdpAudio::localPort */
+
+
+bool NetTrxUdpAudio::sendAudio(const void *buf, int size)
+{
+  if (!m_active || (m_peer_port == 0))
+  {
+    return false;
+  }
+  sendDatagram(UdpAudioHeader::TYPE_AUDIO, m_tx_seq++, buf, size);
+  m_audio_since_mark = true;
+  return true;
+} /* NetTrxUdpAudio::sendAudio */
+
+
+MsgUdpAudioMark *NetTrxUdpAudio::createMark(void)
+{
+  if (!m_audio_since_mark)
+  {
+    return 0;
+  }
+  m_audio_since_mark = false;
+  return new MsgUdpAudioMark(m_tx_seq, now());
+} /* NetTrxUdpAudio::createMark */
+
+
+void NetTrxUdpAudio::tcpMsgReceived(Msg *msg)
+{
+    // Messages are only queued while waiting for audio sent before a mark
+  if (!m_tcp_queue.empty() || m_jb.markPending())
+  {
+    const char *ptr = reinterpret_cast<const char *>(msg);
+    m_tcp_queue.push_back(vector<char>(ptr, ptr + msg->size()));
+    return;
+  }
+
+  const unsigned reset_cnt = m_reset_cnt;
+  handleTcpMsg(msg);
+  if ((m_reset_cnt == reset_cnt) && (m_jb.markPending() || (m_jb.size() > 0)))
+  {
+    processQueues();
+  }
+} /* NetTrxUdpAudio::tcpMsgReceived */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+uint32_t NetTrxUdpAudio::now(void) const
+{
+  return chrono::duration_cast<chrono::milliseconds>(
+      Clock::now() - m_epoch).count();
+} /* NetTrxUdpAudio::now */
+
+
+bool NetTrxUdpAudio::start(uint16_t local_port, const vector<uint8_t> &key)
+{
+  stop();
+
+  m_sock = new EncryptedUdpSocket(local_port);
+  if (!m_sock->UdpSocket::initOk())
+  {
+    cerr << "*** ERROR: Could not create UDP audio socket" << endl;
+    stop();
+    return false;
+  }
+
+  m_encrypted = !key.empty();
+  if (m_encrypted)
+  {
+    if (!m_sock->setCipher(UdpAudioHeader::cipherName()) ||
+        !m_sock->setCipherKey(key))
+    {
+      cerr << "*** ERROR: Could not set up the UDP audio cipher "
+           << UdpAudioHeader::cipherName() << endl;
+      stop();
+      return false;
+    }
+    m_sock->setCipherAADLength(sizeof(UdpAudioHeader));
+    m_sock->setTagLength(UdpAudioHeader::TAG_LEN);
+  }
+  m_sock->cipherDataReceived.connect(
+      mem_fun(*this, &NetTrxUdpAudio::cipherDataReceived));
+  m_sock->dataReceived.connect(
+      mem_fun(*this, &NetTrxUdpAudio::datagramReceived));
+
+  m_heartbeat_timer.setEnable(true);
+
+  return true;
+} /* NetTrxUdpAudio::start */
+
+
+void NetTrxUdpAudio::stop(void)
+{
+  delete m_sock;
+  m_sock = 0;
+  m_heartbeat_timer.setEnable(false);
+  m_jb_timer.setEnable(false);
+  m_jb.reset();
+  m_active = false;
+  m_encrypted = false;
+  m_tx_cntr = 0;
+  m_tx_seq = 0;
+  m_audio_since_mark = false;
+} /* NetTrxUdpAudio::stop */
+
+
+vector<uint8_t> NetTrxUdpAudio::cipherIV(bool from_server,
+                                         uint32_t cntr) const
+{
+    // The session id is unique for each key and the counter is unique for
+    // each datagram sent in one direction so the IV is never reused
+  const uint32_t dir = from_server ? 1 : 0;
+  vector<uint8_t> iv(UdpAudioHeader::IV_LEN);
+  memcpy(&iv[0], &m_session_id, sizeof(m_session_id));
+  memcpy(&iv[4], &dir, sizeof(dir));
+  memcpy(&iv[8], &cntr, sizeof(cntr));
+  return iv;
+} /* NetTrxUdpAudio::cipherIV */
+
+
+void NetTrxUdpAudio::sendDatagram(uint8_t type, uint32_t seq,
+                                  const void *buf, int len)
+{
+  if ((m_sock == 0) || (m_peer_port == 0))
+  {
+    return;
+  }
+
+  UdpAudioHeader hdr(type, m_session_id, m_tx_cntr++, seq, m_tcp_tx_cnt,
+                     now());
+  if (m_encrypted)
+  {
+    m_sock->setCipherIV(cipherIV(m_is_server, hdr.cntr()));
+    m_sock->write(m_peer_ip, m_peer_port, &hdr, sizeof(hdr), buf, len);
+  }
+  else
+  {
+    const uint8_t *hdr_ptr = reinterpret_cast<const uint8_t *>(&hdr);
+    const uint8_t *buf_ptr = static_cast<const uint8_t *>(buf);
+    m_tx_buf.assign(hdr_ptr, hdr_ptr + sizeof(hdr));
+    m_tx_buf.insert(m_tx_buf.end(), buf_ptr, buf_ptr + len);
+    m_sock->UdpSocket::write(m_peer_ip, m_peer_port, m_tx_buf.data(),
+                             m_tx_buf.size());
+  }
+} /* NetTrxUdpAudio::sendDatagram */
+
+
+bool NetTrxUdpAudio::cipherDataReceived(const IpAddress &ip, uint16_t port,
+                                        void *buf, int count)
+{
+  if ((count < static_cast<int>(sizeof(UdpAudioHeader))) ||
+      (ip != m_peer_ip) || (!m_is_server && (port != m_peer_port)))
+  {
+    return true;
+  }
+  UdpAudioHeader hdr;
+  memcpy(&hdr, buf, sizeof(hdr));
+  if (hdr.sessionId() != m_session_id)
+  {
+    return true;
+  }
+
+  if (!m_encrypted)
+  {
+    handleDatagram(port, hdr, static_cast<uint8_t *>(buf) + sizeof(hdr),
+                   count - sizeof(hdr));
+    return true;
+  }
+
+  m_sock->setCipherIV(cipherIV(!m_is_server, hdr.cntr()));
+  return false;
+} /* NetTrxUdpAudio::cipherDataReceived */
+
+
+void NetTrxUdpAudio::datagramReceived(const IpAddress &ip, uint16_t port,
+                                      void *aad, void *buf, int count)
+{
+  UdpAudioHeader hdr;
+  memcpy(&hdr, aad, sizeof(hdr));
+  handleDatagram(port, hdr, buf, count);
+} /* NetTrxUdpAudio::datagramReceived */
+
+
+void NetTrxUdpAudio::handleDatagram(uint16_t port, const UdpAudioHeader &hdr,
+                                    const void *buf, int len)
+{
+  m_last_rx = now();
+  if (m_is_server)
+  {
+    m_peer_port = port;
+  }
+  setActive(true);
+
+  switch (hdr.type())
+  {
+    case UdpAudioHeader::TYPE_HEARTBEAT:
+      if (m_is_server)
+      {
+        sendDatagram(UdpAudioHeader::TYPE_HEARTBEAT, 0, 0, 0);
+      }
+      break;
+
+    case UdpAudioHeader::TYPE_AUDIO:
+      if (len <= MsgAudio::BUFSIZE)
+      {
+        m_jb.push(hdr.seq(), hdr.timestamp(), hdr.tcpCnt(), buf, len, now());
+        processQueues();
+      }
+      break;
+
+    default:
+      break;
+  }
+} /* NetTrxUdpAudio::handleDatagram */
+
+
+void NetTrxUdpAudio::handleTcpMsg(Msg *msg)
+{
+  ++m_tcp_rx_cnt;
+  if (msg->type() == MsgUdpAudioMark::TYPE)
+  {
+    if (msg->size() == sizeof(MsgUdpAudioMark))
+    {
+      MsgUdpAudioMark *mark_msg = reinterpret_cast<MsgUdpAudioMark *>(msg);
+      m_jb.setMark(mark_msg->seq(), mark_msg->timestamp(), now());
+    }
+    return;
+  }
+  msgReceived(msg);
+} /* NetTrxUdpAudio::handleTcpMsg */
+
+
+void NetTrxUdpAudio::processQueues(void)
+{
+    // Any message handler may reset this object, e.g. on a disconnect, so
+    // stop right away if that happens
+  const unsigned reset_cnt = m_reset_cnt;
+  bool progress = true;
+  while (progress)
+  {
+    progress = false;
+    while (!m_tcp_queue.empty() && !m_jb.markPending())
+    {
+      vector<char> buf;
+      buf.swap(m_tcp_queue.front());
+      m_tcp_queue.pop_front();
+      handleTcpMsg(reinterpret_cast<Msg *>(buf.data()));
+      if (m_reset_cnt != reset_cnt)
+      {
+        return;
+      }
+      progress = true;
+    }
+
+    switch (m_jb.next(now(), m_tcp_rx_cnt, m_payload))
+    {
+      case NetTrxJitterBuffer::AUDIO:
+      {
+        MsgAudio audio_msg(m_payload.data(), m_payload.size());
+        msgReceived(&audio_msg);
+        if (m_reset_cnt != reset_cnt)
+        {
+          return;
+        }
+        progress = true;
+        break;
+      }
+
+      case NetTrxJitterBuffer::MARK:
+        progress = true;
+        break;
+
+      case NetTrxJitterBuffer::NONE:
+        break;
+    }
+  }
+
+  const int timeout = m_jb.timeToNext(now(), m_tcp_rx_cnt);
+  if (timeout >= 0)
+  {
+    m_jb_timer.setTimeout(max(timeout, 1));
+    m_jb_timer.setEnable(true);
+  }
+  else
+  {
+    m_jb_timer.setEnable(false);
+  }
+} /* NetTrxUdpAudio::processQueues */
+
+
+void NetTrxUdpAudio::heartbeat(Timer *t)
+{
+  if (!m_is_server)
+  {
+    sendDatagram(UdpAudioHeader::TYPE_HEARTBEAT, 0, 0, 0);
+  }
+  if (m_active &&
+      (static_cast<int32_t>(now() - m_last_rx) > HEARTBEAT_TIMEOUT))
+  {
+    setActive(false);
+  }
+} /* NetTrxUdpAudio::heartbeat */
+
+
+void NetTrxUdpAudio::jitterBufferTimeout(Timer *t)
+{
+  m_jb_timer.setEnable(false);
+  processQueues();
+} /* NetTrxUdpAudio::jitterBufferTimeout */
+
+
+void NetTrxUdpAudio::setActive(bool is_active)
+{
+  if (is_active != m_active)
+  {
+    m_active = is_active;
+    activeChanged(is_active);
+  }
+} /* NetTrxUdpAudio::setActive */
+
+
+
+/*
+ * This file has not been truncated
+ */
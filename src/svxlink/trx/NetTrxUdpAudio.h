@@ -0,0 +1,367 @@
+/**
+@file   NetTrxUdpAudio.h
+@brief  An UDP audio channel for remote transceiver connections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a class that send and receive the audio of a remote
+transceiver connection over UDP while the control messages still go over the
+TCP connection.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef NET_TRX_UDP_AUDIO_INCLUDED
+#define NET_TRX_UDP_AUDIO_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncIpAddress.h>
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "NetTrxMsg.h"
+#include "NetTrxJitterBuffer.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class EncryptedUdpSocket;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  An UDP audio channel for remote transceiver connections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+Audio sent over a TCP connection stall every time a packet is lost since TCP
+will not deliver any data until the lost packet has been retransmitted. This
+class instead send the audio as UDP datagrams. Lost datagrams are just skipped
+and the receiving side use a jitter buffer (see NetTrxJitterBuffer) to put the
+datagrams back in order and even out variations in network delay.
+
+One object is used on each side of a connection, by NetTrxTcpClient on the
+client side and by NetUplink on the server side. All TCP messages sent and
+received on the connection must be passed through the object so that it can
+keep the audio and the control messages in the same order as they were sent.
+The negotiation of the channel is done by the owner using the
+MsgUdpAudioRequest and MsgUdpAudioSetup messages.
+
+The client send a heartbeat datagram to the server at regular intervals and
+the server answer each one of them. That way the server learn the address to
+send datagrams to, even if the client is behind a NAT router. Audio is only
+sent over UDP when datagrams have been received from the other side lately.
+Until then, and if the UDP channel stop working, the audio is sent over TCP
+as before.
+
+If an authentication key is used on the connection, the datagrams are
+encrypted using AES-128-GCM. The key is derived from the authentication key
+and the authentication challenge of the connection so it never has to be sent
+over the network.
+*/
+class NetTrxUdpAudio : public sigc::trackable
+{
+  public:
+    /**
+     * @brief   The number of milliseconds between heartbeat datagrams
+     */
+    static const int HEARTBEAT_INTERVAL = 5000;
+
+    /**
+     * @brief   The number of milliseconds without datagrams before falling
+     *          back to sending audio over TCP
+     */
+    static const int HEARTBEAT_TIMEOUT = 15000;
+
+    /**
+     * @brief   Derive the encryption key for an UDP audio session
+     * @param   key         The derived key is put here
+     * @param   auth_key    The authentication key of the connection
+     * @param   challenge   The authentication challenge of the connection
+     * @param   session_id  The session id
+     * @return  Returns \em true on success or \em false on failure
+     */
+    static bool deriveKey(std::vector<uint8_t> &key,
+                          const std::string &auth_key,
+                          const unsigned char *challenge,
+                          uint32_t session_id);
+
+    /**
+     * @brief   Default constructor
+     */
+    NetTrxUdpAudio(void);
+
+    /**
+     * @brief   Destructor
+     */
+    ~NetTrxUdpAudio(void);
+
+    /**
+     * @brief   Set the delay of the jitter buffer
+     * @param   delay_ms The delay in milliseconds
+     */
+    void setJitterBufferDelay(unsigned delay_ms) { m_jb.setDelay(delay_ms); }
+
+    /**
+     * @brief   Get the delay of the jitter buffer
+     * @return  Returns the delay in milliseconds
+     */
+    unsigned jitterBufferDelay(void) const { return m_jb.delay(); }
+
+    /**
+     * @brief   Start a session on the server side
+     * @param   local_port  The local UDP port to use
+     * @param   peer_ip     The IP address of the client
+     * @param   session_id  The session id
+     * @param   key         The encryption key. Empty for no encryption.
+     * @return  Returns \em true on success or \em false on failure
+     */
+    bool startServer(uint16_t local_port, const Async::IpAddress &peer_ip,
+                     uint32_t session_id, const std::vector<uint8_t> &key);
+
+    /**
+     * @brief   Start a session on the client side
+     * @param   peer_ip     The IP address of the server
+     * @param   peer_port   The UDP port of the server
+     * @param   session_id  The session id
+     * @param   key         The encryption key. Empty for no encryption.
+     * @return  Returns \em true on success or \em false on failure
+     */
+    bool startClient(const Async::IpAddress &peer_ip, uint16_t peer_port,
+                     uint32_t session_id, const std::vector<uint8_t> &key);
+
+    /**
+     * @brief   Stop the session and start over
+     *
+     * This function must be called when a new TCP connection has been set up
+     * and when the TCP connection has been closed.
+     */
+    void reset(void);
+
+    /**
+     * @brief   Check if a session has been started
+     * @return  Returns \em true if a session has been started
+     */
+    bool isStarted(void) const { return m_sock != 0; }
+
+    /**
+     * @brief   Check if audio is sent over UDP
+     * @return  Returns \em true if datagrams have been received lately
+     */
+    bool isActive(void) const { return m_active; }
+
+    /**
+     * @brief   Check if the datagrams are encrypted
+     * @return  Returns \em true if the datagrams are encrypted
+     */
+    bool isEncrypted(void) const { return m_encrypted; }
+
+    /**
+     * @brief   Get the local UDP port
+     * @return  Returns the local port or 0 if no session has been started
+     */
+    uint16_t localPort(void) const;
+
+    /**
+     * @brief   Send encoded audio over UDP
+     * @param   buf   The buffer containing the encoded audio
+     * @param   size  The number of bytes in the buffer
+     * @return  Returns \em false if the audio must be sent over TCP instead
+     */
+    bool sendAudio(const void *buf, int size);
+
+    /**
+     * @brief   Create a mark to send before a TCP message
+     * @return  Returns a new mark message or 0 if no mark is needed
+     *
+     * A mark is needed if audio has been sent over UDP since the last mark.
+     * The mark make the receiver wait for that audio before handling the TCP
+     * messages that follow it.
+     */
+    NetTrxMsg::MsgUdpAudioMark *createMark(void);
+
+    /**
+     * @brief   Tell this object that a TCP message has been sent
+     */
+    void tcpMsgSent(void) { ++m_tcp_tx_cnt; }
+
+    /**
+     * @brief   Pass on a TCP message that has been received
+     * @param   msg The received message
+     *
+     * The message is emitted through the msgReceived signal, now or later
+     * when the audio sent before it has been played.
+     */
+    void tcpMsgReceived(NetTrxMsg::Msg *msg);
+
+    /**
+     * @brief   Get the jitter buffer statistics
+     * @return  Returns the statistics of the jitter buffer
+     */
+    const NetTrxJitterBuffer::Stats& jitterBufferStats(void) const
+    {
+      return m_jb.stats();
+    }
+
+    /**
+     * @brief   A signal that is emitted when a message should be handled
+     * @param   msg The message
+     *
+     * All TCP messages, except the marks, and all audio received over UDP,
+     * in the form of MsgAudio messages, are emitted through this signal in
+     * the order they were sent.
+     */
+    sigc::signal<void(NetTrxMsg::Msg*)> msgReceived;
+
+    /**
+     * @brief   A signal that is emitted when UDP audio start or stop
+     * @param   is_active \em true if the audio is now sent over UDP
+     */
+    sigc::signal<void(bool)> activeChanged;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    Async::EncryptedUdpSocket*        m_sock;
+    Async::Timer                      m_heartbeat_timer;
+    Async::Timer                      m_jb_timer;
+    Clock::time_point                 m_epoch;
+    Async::IpAddress                  m_peer_ip;
+    uint16_t                          m_peer_port;
+    bool                              m_is_server;
+    uint32_t                          m_session_id;
+    bool                              m_encrypted;
+    bool                              m_active;
+    uint32_t                          m_last_rx;
+    uint32_t                          m_tx_cntr;
+    uint32_t                          m_tx_seq;
+    bool                              m_audio_since_mark;
+    uint32_t                          m_tcp_tx_cnt;
+    uint32_t                          m_tcp_rx_cnt;
+    unsigned                          m_reset_cnt;
+    NetTrxJitterBuffer                m_jb;
+    std::deque<std::vector<char> >    m_tcp_queue;
+    std::vector<uint8_t>              m_tx_buf;
+    std::vector<uint8_t>              m_payload;
+
+    NetTrxUdpAudio(const NetTrxUdpAudio&);
+    NetTrxUdpAudio& operator=(const NetTrxUdpAudio&);
+    uint32_t now(void) const;
+    bool start(uint16_t local_port, const std::vector<uint8_t> &key);
+    void stop(void);
+    std::vector<uint8_t> cipherIV(bool from_server, uint32_t cntr) const;
+    void sendDatagram(uint8_t type, uint32_t seq, const void *buf, int len);
+    bool cipherDataReceived(const Async::IpAddress &ip, uint16_t port,
+                            void *buf, int count);
+    void datagramReceived(const Async::IpAddress &ip, uint16_t port,
+                          void *aad, void *buf, int count);
+    void handleDatagram(uint16_t port, const NetTrxMsg::UdpAudioHeader &hdr,
+                        const void *buf, int len);
+    void handleTcpMsg(NetTrxMsg::Msg *msg);
+    void processQueues(void);
+    void heartbeat(Async::Timer *t);
+    void jitterBufferTimeout(Async::Timer *t);
+    void setActive(bool is_active);
+
+};  /* class NetTrxUdpAudio */
+
+
+//} /* namespace */
+
+#endif /* NET_TRX_UDP_AUDIO_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
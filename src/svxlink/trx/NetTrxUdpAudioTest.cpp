@@ -0,0 +1,519 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#include <AsyncCppApplication.h>
+#include <AsyncUdpSocket.h>
+#include <AsyncIpAddress.h>
+#include <AsyncTimer.h>
+
+#include "NetTrxUdpAudio.h"
+
+using namespace std;
+using namespace Async;
+using namespace NetTrxMsg;
+
+
+/*
+ * UDP audio loss and latency simulation test
+ *
+ * Usage: NetTrxUdpAudioTest
+ *
+ * A client and a server NetTrxUdpAudio object are connected through a local
+ * UDP impairment shim that drop, duplicate, corrupt, delay and reorder the
+ * datagrams. The TCP connection is simulated by a link that deliver the
+ * messages in order after a fixed delay. Audio is sent in both directions at
+ * the same time, framed by a TCP message before the first packet and a flush
+ * message after the last one, the same way as for a real transmission.
+ *
+ * For each direction the test check that the audio is delivered in order,
+ * that nothing is delivered before the start message or after the flush
+ * message, that no corrupted audio get through and that every packet that
+ * was not dropped by the shim is delivered. The latency from sending a packet
+ * until it is delivered is printed and it must not be longer than the delay
+ * through the shim plus the jitter buffer delay. The exit status is zero if
+ * all checks pass.
+ */
+
+namespace {
+  typedef chrono::steady_clock Clock;
+
+  const int       PACKET_INTERVAL = 20;
+  const unsigned  PACKET_CNT = 250;
+  const int       PAYLOAD_SIZE = 160;
+  const unsigned  JB_DELAY = 60;
+  const int       TCP_DELAY = 30;
+  const int       LATENCY_SLACK = 15;
+  const uint32_t  SESSION_ID = 0x4711;
+  const IpAddress LOCALHOST("127.0.0.1");
+
+  struct Scenario
+  {
+    const char  *name;
+    bool        encrypted;
+    double      loss;
+    double      duplicate;
+    double      corrupt;
+    int         delay;
+    int         jitter;
+  };
+
+  const Scenario scenarios[] = {
+    { "clean",           false, 0.00, 0.00, 0.00,  5,  0 },
+    { "lossy",           false, 0.05, 0.02, 0.00, 10, 40 },
+    { "lossy encrypted", true,  0.05, 0.02, 0.02, 10, 40 },
+  };
+
+  unsigned msNow(void)
+  {
+    static const Clock::time_point epoch = Clock::now();
+    return chrono::duration_cast<chrono::milliseconds>(
+        Clock::now() - epoch).count();
+  }
+
+
+    // Forward datagrams between the client and the server after dropping,
+    // duplicating, corrupting, delaying and reordering them
+  class ImpairmentShim : public sigc::trackable
+  {
+    public:
+      unsigned dropped_audio[2];
+      unsigned corrupted_audio[2];
+
+      ImpairmentShim(const Scenario &sc)
+        : sc(sc), rng(4711), sock(0, LOCALHOST), server_port(0),
+          client_port(0), timer(0, Timer::TYPE_ONESHOT, false)
+      {
+        dropped_audio[0] = dropped_audio[1] = 0;
+        corrupted_audio[0] = corrupted_audio[1] = 0;
+        sock.dataReceived.connect(
+            mem_fun(*this, &ImpairmentShim::datagramReceived));
+        timer.expired.connect(mem_fun(*this, &ImpairmentShim::deliver));
+      }
+
+      uint16_t localPort(void) const { return sock.localPort(); }
+      void setServerPort(uint16_t port) { server_port = port; }
+
+    private:
+      struct Datagram
+      {
+        uint16_t              dest_port;
+        vector<uint8_t>       data;
+      };
+
+      const Scenario                  &sc;
+      mt19937                         rng;
+      UdpSocket                       sock;
+      uint16_t                        server_port;
+      uint16_t                        client_port;
+      multimap<unsigned, Datagram>    queue;
+      Timer                           timer;
+
+      bool chance(double p)
+      {
+        return uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+      }
+
+      void datagramReceived(const IpAddress &ip, uint16_t port, void *buf,
+                            int count)
+      {
+        const bool to_server = (port != server_port);
+        if (to_server)
+        {
+          client_port = port;
+        }
+        UdpAudioHeader hdr;
+        memcpy(&hdr, buf, sizeof(hdr));
+        const bool is_audio = (hdr.type() == UdpAudioHeader::TYPE_AUDIO);
+
+        if (chance(sc.loss))
+        {
+          dropped_audio[to_server] += is_audio ? 1 : 0;
+          return;
+        }
+        Datagram dgram;
+        dgram.dest_port = to_server ? server_port : client_port;
+        const uint8_t *ptr = static_cast<const uint8_t *>(buf);
+        dgram.data.assign(ptr, ptr + count);
+        if (is_audio && chance(sc.corrupt))
+        {
+          dgram.data.back() ^= 0x55;
+          corrupted_audio[to_server] += 1;
+        }
+        const int copies = chance(sc.duplicate) ? 2 : 1;
+        for (int i=0; i<copies; ++i)
+        {
+          const int delay = sc.delay +
+              uniform_int_distribution<int>(0, sc.jitter)(rng);
+          queue.insert(make_pair(msNow() + delay, dgram));
+        }
+        schedule();
+      }
+
+      void deliver(Timer *t)
+      {
+        while (!queue.empty() && (queue.begin()->first <= msNow()))
+        {
+          const Datagram &dgram = queue.begin()->second;
+          sock.write(LOCALHOST, dgram.dest_port, dgram.data.data(),
+                     dgram.data.size());
+          queue.erase(queue.begin());
+        }
+        schedule();
+      }
+
+      void schedule(void)
+      {
+        timer.setEnable(false);
+        if (!queue.empty())
+        {
+          const int timeout = queue.begin()->first - msNow();
+          timer.setTimeout(max(timeout, 1));
+          timer.setEnable(true);
+        }
+      }
+  };
+
+
+    // Simulate a TCP connection by delivering messages in order after a
+    // fixed delay
+  class TcpLink : public sigc::trackable
+  {
+    public:
+      TcpLink(NetTrxUdpAudio &from, NetTrxUdpAudio &to)
+        : from(from), to(to), timer(0, Timer::TYPE_ONESHOT, false)
+      {
+        timer.expired.connect(mem_fun(*this, &TcpLink::deliver));
+      }
+
+      void sendMsg(Msg *msg)
+      {
+        MsgUdpAudioMark *mark = from.createMark();
+        if (mark != 0)
+        {
+          send(mark);
+        }
+        send(msg);
+      }
+
+    private:
+      NetTrxUdpAudio                          &from;
+      NetTrxUdpAudio                          &to;
+      deque<pair<unsigned, vector<char> > >   queue;
+      Timer                                   timer;
+
+      void send(Msg *msg)
+      {
+        const char *ptr = reinterpret_cast<const char *>(msg);
+        queue.push_back(make_pair(msNow() + TCP_DELAY,
+                                  vector<char>(ptr, ptr + msg->size())));
+        from.tcpMsgSent();
+        delete msg;
+        schedule();
+      }
+
+      void deliver(Timer *t)
+      {
+        while (!queue.empty() && (queue.front().first <= msNow()))
+        {
+          vector<char> buf;
+          buf.swap(queue.front().second);
+          queue.pop_front();
+          to.tcpMsgReceived(reinterpret_cast<Msg *>(buf.data()));
+        }
+        schedule();
+      }
+
+      void schedule(void)
+      {
+        timer.setEnable(false);
+        if (!queue.empty())
+        {
+          const int timeout = queue.front().first - msNow();
+          timer.setTimeout(max(timeout, 1));
+          timer.setEnable(true);
+        }
+      }
+  };
+
+
+    // Send audio in one direction and check what come out on the other side
+  class Direction : public sigc::trackable
+  {
+    public:
+      Direction(const char *name, NetTrxUdpAudio &from, NetTrxUdpAudio &to)
+        : name(name), from(from), link(from, to), sent(0), tcp_fallback(0),
+          started(false), flushed(false), delivered(0), next_idx(0),
+          out_of_order(0), corrupted(0), outside(0), latency_sum(0),
+          latency_max(0)
+      {
+        to.msgReceived.connect(mem_fun(*this, &Direction::msgReceived));
+      }
+
+      bool isDone(void) const { return flushed; }
+
+      void tick(void)
+      {
+        if (sent == 0)
+        {
+          link.sendMsg(new MsgSetRxFq(1));
+        }
+        if (sent < PACKET_CNT)
+        {
+          uint8_t buf[PAYLOAD_SIZE];
+          for (int i=0; i<PAYLOAD_SIZE; ++i)
+          {
+            buf[i] = (sent + i) & 0xff;
+          }
+          memcpy(buf, &sent, sizeof(sent));
+          send_time.push_back(msNow());
+          if (!from.sendAudio(buf, sizeof(buf)))
+          {
+            tcp_fallback += 1;
+            link.sendMsg(new MsgAudio(buf, sizeof(buf)));
+          }
+          if (++sent == PACKET_CNT)
+          {
+            link.sendMsg(new MsgFlush);
+          }
+        }
+      }
+
+      bool report(const Scenario &sc, const NetTrxJitterBuffer::Stats &stats,
+                  unsigned dropped, unsigned corrupted_by_shim)
+      {
+        const unsigned latency_limit = sc.delay + sc.jitter + JB_DELAY +
+                                       LATENCY_SLACK;
+        const bool ok = flushed && (tcp_fallback == 0) &&
+                        (out_of_order == 0) && (corrupted == 0) &&
+                        (outside == 0) &&
+                        (delivered + dropped + corrupted_by_shim ==
+                         PACKET_CNT) &&
+                        (stats.lost == dropped + corrupted_by_shim) &&
+                        (latency_max <= latency_limit);
+        cout << "  " << setw(16) << left << name << right
+             << setw(6) << delivered << "/" << PACKET_CNT
+             << "  dropped=" << setw(3) << dropped
+             << " corrupted=" << setw(3) << corrupted_by_shim
+             << " lost=" << setw(3) << stats.lost
+             << " late=" << setw(3) << stats.late
+             << " depth=" << setw(2) << stats.max_depth
+             << "  latency avg=" << setw(3)
+             << (delivered > 0 ? latency_sum / delivered : 0)
+             << " max=" << setw(3) << latency_max
+             << " (limit " << latency_limit << ") ms"
+             << (ok ? "  OK" : "  FAILED") << endl;
+        return ok;
+      }
+
+    private:
+      const char        *name;
+      NetTrxUdpAudio    &from;
+      TcpLink           link;
+      unsigned          sent;
+      unsigned          tcp_fallback;
+      vector<unsigned>  send_time;
+      bool              started;
+      bool              flushed;
+      unsigned          delivered;
+      unsigned          next_idx;
+      unsigned          out_of_order;
+      unsigned          corrupted;
+      unsigned          outside;
+      unsigned          latency_sum;
+      unsigned          latency_max;
+
+      void msgReceived(Msg *msg)
+      {
+        switch (msg->type())
+        {
+          case MsgSetRxFq::TYPE:
+            started = true;
+            break;
+
+          case MsgAudio::TYPE:
+          {
+            MsgAudio *audio_msg = reinterpret_cast<MsgAudio *>(msg);
+            const uint8_t *buf = static_cast<uint8_t *>(audio_msg->buf());
+            unsigned idx;
+            memcpy(&idx, buf, sizeof(idx));
+            bool valid = (audio_msg->size() == PAYLOAD_SIZE) &&
+                         (idx < PACKET_CNT);
+            for (int i=sizeof(idx); valid && (i<PAYLOAD_SIZE); ++i)
+            {
+              valid = (buf[i] == ((idx + i) & 0xff));
+            }
+            if (!valid)
+            {
+              corrupted += 1;
+              break;
+            }
+            if (!started || flushed)
+            {
+              outside += 1;
+            }
+            if (idx < next_idx)
+            {
+              out_of_order += 1;
+            }
+            next_idx = idx + 1;
+            delivered += 1;
+            const unsigned latency = msNow() - send_time[idx];
+            latency_sum += latency;
+            latency_max = max(latency_max, latency);
+            break;
+          }
+
+          case MsgFlush::TYPE:
+            flushed = true;
+            break;
+        }
+      }
+  };
+
+
+  class Runner : public sigc::trackable
+  {
+    public:
+      Runner(const Scenario &sc)
+        : sc(sc), shim(sc), up("client->server", client, server),
+          down("server->client", server, client),
+          timer(PACKET_INTERVAL, Timer::TYPE_PERIODIC), wait_cnt(0),
+          ok(false)
+      {
+        vector<uint8_t> key;
+        if (sc.encrypted)
+        {
+          unsigned char challenge[MsgAuthChallenge::CHALLENGE_LEN];
+          memset(challenge, 0xa5, sizeof(challenge));
+          if (!NetTrxUdpAudio::deriveKey(key, "secret", challenge,
+                                         SESSION_ID))
+          {
+            exit(1);
+          }
+        }
+        server.setJitterBufferDelay(JB_DELAY);
+        client.setJitterBufferDelay(JB_DELAY);
+        if (!server.startServer(0, LOCALHOST, SESSION_ID, key) ||
+            (server.localPort() == 0) || (shim.localPort() == 0))
+        {
+          exit(1);
+        }
+        shim.setServerPort(server.localPort());
+        if (!client.startClient(LOCALHOST, shim.localPort(), SESSION_ID, key))
+        {
+          exit(1);
+        }
+        timer.expired.connect(mem_fun(*this, &Runner::tick));
+      }
+
+      bool isOk(void) const { return ok; }
+
+      sigc::signal<void()> done;
+
+    private:
+      const Scenario  &sc;
+      NetTrxUdpAudio  client;
+      NetTrxUdpAudio  server;
+      ImpairmentShim  shim;
+      Direction       up;
+      Direction       down;
+      Timer           timer;
+      unsigned        wait_cnt;
+      bool            ok;
+
+      void tick(Timer *t)
+      {
+        ++wait_cnt;
+        if (!client.isActive() || !server.isActive())
+        {
+          if (wait_cnt * PACKET_INTERVAL > 2000)
+          {
+            cout << "*** ERROR: The UDP audio channel was not set up" << endl;
+            finish();
+          }
+          return;
+        }
+        up.tick();
+        down.tick();
+        if (up.isDone() && down.isDone())
+        {
+          finish();
+        }
+        else if (wait_cnt * PACKET_INTERVAL > 2 * PACKET_CNT * PACKET_INTERVAL)
+        {
+          cout << "*** ERROR: Timeout waiting for the flush message" << endl;
+          finish();
+        }
+      }
+
+      void finish(void)
+      {
+        timer.setEnable(false);
+        cout << sc.name << ":" << endl;
+        const bool up_ok = up.report(sc, server.jitterBufferStats(),
+                                     shim.dropped_audio[1],
+                                     shim.corrupted_audio[1]);
+        const bool down_ok = down.report(sc, client.jitterBufferStats(),
+                                         shim.dropped_audio[0],
+                                         shim.corrupted_audio[0]);
+        ok = up_ok && down_ok;
+        done();
+      }
+  };
+
+
+    // Run the scenarios one after the other
+  class Test : public sigc::trackable
+  {
+    public:
+      Test(void) : runner(0), idx(0), failed(0) { runNext(); }
+      ~Test(void) { delete runner; }
+
+      int failedCount(void) const { return failed; }
+
+    private:
+      Runner    *runner;
+      unsigned  idx;
+      int       failed;
+
+      void runNext(void)
+      {
+        if (runner != 0)
+        {
+          failed += runner->isOk() ? 0 : 1;
+          delete runner;
+          runner = 0;
+        }
+        if (idx == sizeof(scenarios) / sizeof(*scenarios))
+        {
+          Application::app().quit();
+          return;
+        }
+        runner = new Runner(scenarios[idx++]);
+        runner->done.connect(mem_fun(*this, &Test::runnerDone));
+      }
+
+      void runnerDone(void)
+      {
+          // The runner cannot be deleted from within its own signal
+        Application::app().runTask(mem_fun(*this, &Test::runNext));
+      }
+  };
+};
+
+
+int main(int argc, const char **argv)
+{
+  CppApplication app;
+  Test test;
+  app.exec();
+
+  return (test.failedCount() == 0) ? 0 : 1;
+}
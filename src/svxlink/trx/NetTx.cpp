@@ -169,6 +169,9 @@ bool NetTx::initialize(void)
   
   string auth_key;
   cfg.getValue(name(), "AUTH_KEY", auth_key);
+
+  bool udp_audio = false;
+  cfg.getValue(name(), "UDP_AUDIO", udp_audio);
   
   pacer = new AudioPacer(INTERNAL_SAMPLE_RATE, 512, 50);
   setHandler(pacer);
@@ -207,6 +210,10 @@ bool NetTx::initialize(void)
     return false;
   }
   tcp_con->setAuthKey(auth_key);
+  if (udp_audio)
+  {
+    tcp_con->enableUdpAudio();
+  }
   tcp_con->isReady.connect(mem_fun(*this, &NetTx::connectionReady));
   tcp_con->msgReceived.connect(mem_fun(*this, &NetTx::handleMsg));
   tcp_con->connect();
@@ -280,20 +280,12 @@ void RtlSdr::handleIq(const complex<uint8_t> *samples, int samp_count)
 {
   //cout << "RtlSdr::handleIq: samp_count=" << samp_count << endl;
 
-  vector<Sample> iq;
-  iq.reserve(samp_count);
-  for (int idx=0; idx<samp_count; ++idx)
+  IqBlock iq = iq_pool.alloc(samp_count);
+  IqConverter::Stats stats;
+  IqConverter::convert(iq.data(), samples, samp_count, stats);
+  if ((dist_print_cnt == 0) && (stats.clipped > 0))
   {
-    if ((dist_print_cnt == 0) &&
-        ((samples[idx].real() == 255) || (samples[idx].imag() == 255)))
-    {
-      dist_print_cnt = samp_rate;
-    }
-    float i = samples[idx].real();
-    i = i / 127.5f - 1.0f;
-    float q = samples[idx].imag();
-    q = q / 127.5f - 1.0f;
-    iq.push_back(complex<float>(i, q));
+    dist_print_cnt = samp_rate;
   }
 
   if (dist_print_cnt > 0)
@@ -311,6 +303,7 @@ void RtlSdr::handleIq(const complex<uint8_t> *samples, int samp_count)
   }
 
   iqReceived(iq);
+  iqStatsReceived(stats);
 } /* RtlSdr::handleIq */
 
 
@@ -55,6 +55,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include "IqBlock.h"
+#include "IqConverter.h"
 
 
 /****************************************************************************
@@ -290,13 +292,26 @@ class RtlSdr : public sigc::trackable
 
     /**
      * @brief   A signal that is emitted when new samples have been received
-     * @param   samples A vector of received samples
+     * @param   samples A block of received samples
      *
      * Connecting to this signal is the way to get samples from the DVB-T
-     * dongle. The format is a vector of complex floats (I/Q) with a range from
-     * -1 to 1.
+     * dongle. The format is a block of complex floats (I/Q) with a range from
+     * -1 to 1. The block buffer is taken from a pool and is reused when the
+     * last copy of the block is destroyed, so keep a copy of the block rather
+     * than copying the samples if they are needed after the call.
      */
-    sigc::signal<void(std::vector<Sample>)> iqReceived;
+    sigc::signal<void(const IqBlock&)> iqReceived;
+
+    /**
+     * @brief   A signal that is emitted with statistics for each sample block
+     * @param   stats The number of clipped values, DC offset and RMS level
+     *
+     * The statistics are gathered while the samples are converted so they
+     * come without any extra cost. They can be used to monitor the health of
+     * the dongle, like clipping caused by too high gain or a large DC offset.
+     * The signal is emitted right after the iqReceived signal.
+     */
+    sigc::signal<void(const IqConverter::Stats&)> iqStatsReceived;
 
     /**
      * @brief   A signal that is emitted when the ready state changes
@@ -416,6 +431,7 @@ class RtlSdr : public sigc::trackable
     bool              use_digital_agc_set;
     bool              use_digital_agc;
     int               dist_print_cnt;
+    IqBlockPool       iq_pool;
 
     RtlSdr(const RtlSdr&);
     RtlSdr& operator=(const RtlSdr&);
@@ -33,6 +33,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <iostream>
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 
@@ -56,7 +57,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "SigLevDetTone.h"
-#include "Goertzel.h"
+#include "GoertzelBank.h"
 
 
 
@@ -161,25 +162,17 @@ class SigLevDetTone::HammingWindow
  ****************************************************************************/
 
 SigLevDetTone::SigLevDetTone(void)
-  : sample_rate(0), tone_siglev_map(10), block_idx(0), last_siglev(0),
-    passband_energy(0.0f), filter(0), prev_peak_to_tot_pwr(0.0f),
-    integration_time(1), update_interval(0), update_counter(0)
+  : sample_rate(0), tone_siglev_map(10), bank(0), last_siglev(0),
+    filter(0), prev_peak_to_tot_pwr(0.0f), integration_time(1),
+    update_interval(0), update_counter(0)
 {
-  for (int i=0; i<10; ++i)
-  {
-    det[i] = 0;
-  }
 } /* SigLevDetTone::SigLevDetTone */
 
 
 SigLevDetTone::~SigLevDetTone(void)
 {
   delete filter;
-
-  for (int i=0; i<10; ++i)
-  {
-    delete det[i];
-  }
+  delete bank;
 } /* SigLevDetTone::~SigLevDetTone */
 
 
@@ -209,9 +202,11 @@ bool SigLevDetTone::initialize(Config &cfg, const string& name, int sample_rate)
       mem_fun(*sigc_sink, &SigCAudioSink::allSamplesFlushed));
   filter->registerSink(sigc_sink, true);
 
+  delete bank;
+  bank = new GoertzelBank(sample_rate);
   for (int i=0; i<10; ++i)
   {
-    det[i] = new Goertzel(5500 + i * 100, sample_rate);
+    bank->addBin(5500 + i * 100);
     tone_siglev_map[i] = 100 - i * 10;
   }
   reset();
@@ -235,13 +230,11 @@ bool SigLevDetTone::initialize(Config &cfg, const string& name, int sample_rate)
 
 void SigLevDetTone::reset(void)
 {
-  for (int i=0; i<10; ++i)
+  if (bank != 0)
   {
-    det[i]->reset();
+    bank->reset();
   }
-  block_idx = 0;
   last_siglev = 0;
-  passband_energy = 0.0f;
   prev_peak_to_tot_pwr = 0.0f;
   update_counter = 0;
   siglev_values.clear();
@@ -300,25 +293,22 @@ float SigLevDetTone::siglevIntegrated(void) const
 
 int SigLevDetTone::processSamples(const float *samples, int count)
 {
-  for (int i=0; i<count; ++i)
+  int pos = 0;
+  while (pos < count)
   {
-    const float &sample = samples[i];
-
-    passband_energy += sample * sample;
+      // Run all ten detectors on the samples up to the end of the block
+    const int len = min(count - pos,
+                        static_cast<int>(BLOCK_SIZE - bank->blockPos()));
+    bank->calc(samples + pos, len);
+    pos += len;
 
-    for (int detno=0; detno < 10; ++detno)
-    {
-      det[detno]->calc(sample);
-    }
-    
-    if (++block_idx == BLOCK_SIZE)
+    if (bank->blockPos() == BLOCK_SIZE)
     {
       float max = 0.0f;
       int max_idx = -1;
       for (int detno=0; detno < 10; ++detno)
       {
-        float res = det[detno]->magnitudeSquared();
-        det[detno]->reset();
+        float res = bank->magnitudeSquared(detno);
         if (res > max)
         {
           max = res;
@@ -334,7 +324,7 @@ int SigLevDetTone::processSamples(const float *samples, int count)
       {
           // Calculate the coefficient used to get from relative magnitude
           // squared to the "peak to total power" relation.
-        float coeff = 2.0f / (BLOCK_SIZE * passband_energy);
+        float coeff = 2.0f / (BLOCK_SIZE * bank->passbandEnergy());
 
           // Calculate the peak to total bandpass power relation
         float peak_to_tot_pwr = coeff * max;
@@ -356,11 +346,11 @@ int SigLevDetTone::processSamples(const float *samples, int count)
           float lo_peak_to_tot_pwr = 0.0f, hi_peak_to_tot_pwr = 0.0f;
           if (max_idx > 0)
           {
-            lo_peak_to_tot_pwr = coeff * det[max_idx-1];
+            lo_peak_to_tot_pwr = coeff * bank->magnitudeSquared(max_idx-1);
           }
           if (max_idx < 9)
           {
-            hi_peak_to_tot_pwr = coeff * det[max_idx+1];
+            hi_peak_to_tot_pwr = coeff * bank->magnitudeSquared(max_idx+1);
           }
           peak_to_tot_pwr += max(lo_peak_to_tot_pwr - hi_peak_to_tot_pwr,
                                  hi_peak_to_tot_pwr - lo_peak_to_tot_pwr);
@@ -391,8 +381,7 @@ int SigLevDetTone::processSamples(const float *samples, int count)
 	}
       }
 
-      passband_energy = 0.0f;
-      block_idx = 0;
+      bank->reset();
     }
   }
   
@@ -68,7 +68,7 @@ namespace Async
   class AudioFilter;
 };
 
-class Goertzel;
+class GoertzelBank;
 
 
 /****************************************************************************
@@ -198,10 +198,8 @@ class SigLevDetTone : public SigLevDet
 
     int	                sample_rate;
     std::vector<int>    tone_siglev_map;
-    Goertzel            *det[10];
-    unsigned            block_idx;
+    GoertzelBank        *bank;
     int                 last_siglev;
-    float               passband_energy;
     Async::AudioFilter  *filter;
     float               prev_peak_to_tot_pwr;
     unsigned            integration_time;
@@ -0,0 +1,298 @@
+/**
+@file   SlidingDft.cpp
+@brief  A recursively updated DFT over the most recent block of samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "SlidingDft.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The number of blocks between recalculations of the bins from the stored
+  // samples
+#define RESYNC_BLOCKS 64
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+SlidingDft::SlidingDft(unsigned sample_rate)
+  : m_sample_rate(sample_rate)
+{
+  setup();
+} /* SlidingDft::SlidingDft */
+
+
+void SlidingDft::setBlockLen(size_t block_len)
+{
+  assert(block_len > 0);
+  m_block_len = block_len;
+  setup();
+} /* SlidingDft::setBlockLen */
+
+
+void SlidingDft::setWindow(float a0)
+{
+  m_a0 = a0;
+  setup();
+} /* SlidingDft::setWindow */
+
+
+size_t SlidingDft::addBin(float freq)
+{
+  m_freq.push_back(freq);
+  setup();
+  return m_freq.size() - 1;
+} /* SlidingDft::addBin */
+
+
+void SlidingDft::clearBins(void)
+{
+  m_freq.clear();
+  setup();
+} /* SlidingDft::clearBins */
+
+
+void SlidingDft::reset(void)
+{
+  fill(m_hist.begin(), m_hist.end(), 0.0f);
+  m_hist_pos = 0;
+  m_fill = 0;
+  m_resync_left = RESYNC_BLOCKS * m_block_len;
+  m_energy = 0.0;
+  for (Component& comp : m_comp)
+  {
+    comp.state = 0.0;
+  }
+} /* SlidingDft::reset */
+
+
+void SlidingDft::calc(const float *samples, size_t count)
+{
+  for (size_t i=0; i<count; ++i)
+  {
+    const double x = samples[i];
+    const double old = m_hist[m_hist_pos];
+    m_hist[m_hist_pos] = samples[i];
+    if (++m_hist_pos >= m_block_len)
+    {
+      m_hist_pos = 0;
+    }
+    m_energy += x * x - old * old;
+
+      // X[n] = (X[n-1] - x[n-N]) * e^(jw) + x[n] * e^(-jw(N-1)).
+      // The complex multiplications are written out to not get the slow
+      // NaN checking code generated for std::complex.
+    for (Component& comp : m_comp)
+    {
+      const double re = comp.state.real() - old;
+      const double im = comp.state.imag();
+      comp.state = complex<double>(
+          re * comp.rot.real() - im * comp.rot.imag() + x * comp.in_rot.real(),
+          re * comp.rot.imag() + im * comp.rot.real() + x * comp.in_rot.imag());
+    }
+
+    if (m_fill < m_block_len)
+    {
+      ++m_fill;
+    }
+    else if (--m_resync_left == 0)
+    {
+      resync();
+    }
+  }
+} /* SlidingDft::calc */
+
+
+complex<float> SlidingDft::result(size_t bin) const
+{
+  assert(bin < m_freq.size());
+  if (m_a0 == 1.0f)
+  {
+    return complex<float>(m_comp[bin].state * m_out_rot[bin]);
+  }
+
+    // A raised cosine window in the time domain is the same thing as a
+    // weighted sum of the bin and the two bins one cycle per block away
+  const Component *comp = &m_comp[3 * bin];
+  const complex<double> res = static_cast<double>(m_a0) * comp[0].state -
+    0.5 * (1.0 - m_a0) * (comp[1].state + comp[2].state);
+  return complex<float>(res * m_out_rot[bin]);
+} /* SlidingDft::result */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void SlidingDft::setup(void)
+{
+  const size_t N = m_block_len;
+  const bool windowed = (m_a0 != 1.0f) && (N > 1);
+  const double theta = windowed ? 2.0 * M_PI / (N - 1) : 0.0;
+  m_comp.clear();
+  m_out_rot.clear();
+  for (float freq : m_freq)
+  {
+    const double w = 2.0 * M_PI * freq / m_sample_rate;
+    m_out_rot.push_back(polar(1.0, w * N));
+    for (double offset : { 0.0, -theta, theta })
+    {
+      Component comp;
+      comp.freq = w + offset;
+      comp.rot = polar(1.0, comp.freq);
+      comp.in_rot = polar(1.0, -comp.freq * (N - 1));
+      m_comp.push_back(comp);
+      if (!windowed)
+      {
+        break;
+      }
+    }
+  }
+  if (!windowed)
+  {
+    m_a0 = 1.0f;
+  }
+  m_hist.assign(N, 0.0f);
+  reset();
+} /* SlidingDft::setup */
+
+
+void SlidingDft::resync(void)
+{
+  m_resync_left = RESYNC_BLOCKS * m_block_len;
+
+  double energy = 0.0;
+  for (size_t m=0; m<m_block_len; ++m)
+  {
+    const double x = m_hist[(m_hist_pos + m) % m_block_len];
+    energy += x * x;
+  }
+  m_energy = energy;
+
+  for (Component& comp : m_comp)
+  {
+    const complex<double> step = polar(1.0, -comp.freq);
+    complex<double> rot = 1.0;
+    complex<double> sum = 0.0;
+    for (size_t m=0; m<m_block_len; ++m)
+    {
+      sum += static_cast<double>(m_hist[(m_hist_pos + m) % m_block_len]) * rot;
+      rot *= step;
+    }
+    comp.state = sum;
+  }
+} /* SlidingDft::resync */
+
+
+
+/*
+ * This file has not been truncated
+ */
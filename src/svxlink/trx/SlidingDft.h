@@ -0,0 +1,278 @@
+/**
+@file   SlidingDft.h
+@brief  A recursively updated DFT over the most recent block of samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a sliding DFT that evaluates a number of frequency bins over
+the most recent block of samples. Each new sample updates the bins in constant
+time so the result can be read as often as needed without recalculating the
+whole block.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef SLIDING_DFT_INCLUDED
+#define SLIDING_DFT_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <complex>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A recursively updated DFT over the most recent block of samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class calculates the same thing as running a Goertzel detector over the
+last block_len samples, but the result is available after every sample. When
+a new sample arrives, the oldest sample in the block is subtracted, the bin
+is rotated one sample and the new sample is added. That costs a few
+multiplications per sample and bin, no matter how often the result is read.
+A Goertzel detector with overlapping blocks instead has to process each
+sample once for every block it is part of.
+
+The bin frequencies do not have to be a whole number of cycles per block. A
+raised cosine window, like the Hamming window, can be applied by combining
+each bin with two neighbouring bins. That makes each bin three times as
+expensive to update.
+
+The state is kept in double precision and is recalculated from the stored
+samples at regular intervals so that rounding errors cannot build up over
+time.
+
+\code
+  SlidingDft sdft(INTERNAL_SAMPLE_RATE);
+  sdft.setBlockLen(400);
+  size_t bin = sdft.addBin(1750.0f);
+  sdft.calc(samples, count);
+  if (sdft.isFull())
+  {
+    float mag_sqr = sdft.magnitudeSquared(bin);
+  }
+\endcode
+*/
+class SlidingDft
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   sample_rate The sample rate used
+     */
+    explicit SlidingDft(unsigned sample_rate);
+
+    /**
+     * @brief   Set the block length
+     * @param   block_len The number of samples in the block
+     *
+     * All bins are reset when the block length is changed.
+     */
+    void setBlockLen(size_t block_len);
+
+    /**
+     * @brief   Get the block length
+     * @return  Returns the number of samples in the block
+     */
+    size_t blockLen(void) const { return m_block_len; }
+
+    /**
+     * @brief   Set a raised cosine window
+     * @param   a0 The window constant
+     *
+     * The window is w[n] = a0 - (1-a0) * cos(2*pi*n / (block_len-1)), which
+     * is the same window as used by the ToneDetector class. A value of 1.0
+     * disables windowing. All bins are reset.
+     */
+    void setWindow(float a0);
+
+    /**
+     * @brief   Add a bin
+     * @param   freq The frequency of interest, in Hz
+     * @return  Returns the index of the new bin
+     *
+     * All bins are reset.
+     */
+    size_t addBin(float freq);
+
+    /**
+     * @brief   Remove all bins
+     */
+    void clearBins(void);
+
+    /**
+     * @brief   Get the number of bins
+     * @return  Returns the number of bins
+     */
+    size_t size(void) const { return m_freq.size(); }
+
+    /**
+     * @brief   Reset all bins and forget all samples
+     */
+    void reset(void);
+
+    /**
+     * @brief   Process a number of samples
+     * @param   samples The samples to process
+     * @param   count   The number of samples
+     */
+    void calc(const float *samples, size_t count);
+
+    /**
+     * @brief   Check if a whole block of samples has been processed
+     * @return  Returns \em true if block_len samples have been processed
+     *          since the last reset
+     *
+     * Before the block is full, the missing samples are treated as zeros.
+     */
+    bool isFull(void) const { return m_fill >= m_block_len; }
+
+    /**
+     * @brief   Get the result for a bin in complex form
+     * @param   bin The index of the bin
+     * @return  Returns the result in complex form
+     *
+     * The result is the same, including the phase, as from Goertzel::result
+     * for a Goertzel detector that has processed the last block_len samples.
+     */
+    std::complex<float> result(size_t bin) const;
+
+    /**
+     * @brief   Get the magnitude squared for a bin
+     * @param   bin The index of the bin
+     * @return  Returns the magnitude squared
+     */
+    float magnitudeSquared(size_t bin) const { return std::norm(result(bin)); }
+
+    /**
+     * @brief   Get the passband energy
+     * @return  Returns the sum of the squared samples in the block
+     *
+     * The energy is summed before the window is applied.
+     */
+    double passbandEnergy(void) const { return m_energy; }
+
+  private:
+    struct Component
+    {
+      double                freq;
+      std::complex<double>  rot;
+      std::complex<double>  in_rot;
+      std::complex<double>  state;
+    };
+
+    unsigned                          m_sample_rate;
+    size_t                            m_block_len     = 1;
+    float                             m_a0            = 1.0f;
+    std::vector<float>                m_freq;
+    std::vector<std::complex<double>> m_out_rot;
+    std::vector<Component>            m_comp;
+    std::vector<float>                m_hist;
+    size_t                            m_hist_pos      = 0;
+    size_t                            m_fill          = 0;
+    size_t                            m_resync_left   = 0;
+    double                            m_energy        = 0.0;
+
+    void setup(void);
+    void resync(void);
+
+};  /* class SlidingDft */
+
+
+//} /* namespace */
+
+#endif /* SLIDING_DFT_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Goertzel.h"
+#include "SlidingDft.h"
+
+using namespace std;
+
+
+/*
+ * Verify the SlidingDft class against the Goertzel class
+ *
+ * Usage: SlidingDftTest
+ *
+ * Random input is fed to sliding DFTs with different block lengths, with and
+ * without a Hamming window, in pieces of random size. At random points the
+ * result for each bin is compared to a DFT and a Goertzel detector run over
+ * the last block of samples. The comparison is also done after a long run to
+ * make sure that rounding errors do not build up.
+ * The exit status is zero if all tests pass.
+ */
+
+namespace {
+  const unsigned SAMPLE_RATE = 16000;
+  const double MAX_REL_ERROR = 1.0e-6;
+  const float HAMMING_A0 = 25.0f / 46.0f;
+
+  mt19937 rng(4711);
+
+  bool compare(const SlidingDft& sdft, const vector<float>& hist, float a0)
+  {
+    const size_t N = sdft.blockLen();
+    bool ok = true;
+    double energy = 0.0;
+    for (size_t i=hist.size()-N; i<hist.size(); ++i)
+    {
+      energy += static_cast<double>(hist[i]) * hist[i];
+    }
+    if (fabs(sdft.passbandEnergy() - energy) > 1.0e-6 * energy)
+    {
+      cout << "*** ERROR: N=" << N << " passband energy "
+           << sdft.passbandEnergy() << " != " << energy << endl;
+      ok = false;
+    }
+
+    static const float fqs[] = { 67.0f, 136.5f, 1750.0f, 1807.3f };
+    for (size_t bin=0; bin<sdft.size(); ++bin)
+    {
+        // The DFT is calculated directly in double precision and then
+        // rotated to the same phase reference as the Goertzel result. A
+        // float Goertzel detector is also run but it is itself not very
+        // accurate at low frequencies so a larger error is accepted.
+      const double w = 2.0 * M_PI * fqs[bin] / SAMPLE_RATE;
+      Goertzel g(fqs[bin], SAMPLE_RATE);
+      complex<double> sum = 0.0;
+      for (size_t n=0; n<N; ++n)
+      {
+        const double win = a0 - (1.0 - a0) * cos(2.0 * M_PI * n / (N - 1));
+        const double x = win * hist[hist.size() - N + n];
+        sum += x * polar(1.0, -w * n);
+        g.calc(x);
+      }
+      const complex<double> ref = sum * polar(1.0, w * N);
+      const complex<double> res = sdft.result(bin);
+      const double scale = max(abs(ref), sqrt(energy));
+      if ((abs(res - ref) > MAX_REL_ERROR * scale) ||
+          (abs(res - complex<double>(g.result())) > 1.0e-2 * scale))
+      {
+        cout << "*** ERROR: N=" << N << " a0=" << a0 << " fq=" << fqs[bin]
+             << " res=" << res << " ref=" << ref << endl;
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
+  bool runTest(size_t N, float a0, size_t samples)
+  {
+    uniform_real_distribution<float> sample_dist(-1.0f, 1.0f);
+    uniform_int_distribution<size_t> piece_dist(0, 3 * N);
+
+    SlidingDft sdft(SAMPLE_RATE);
+    sdft.setBlockLen(N);
+    sdft.setWindow(a0);
+    for (float fq : { 67.0f, 136.5f, 1750.0f, 1807.3f })
+    {
+      sdft.addBin(fq);
+    }
+
+    bool ok = true;
+    vector<float> hist;
+    vector<float> piece;
+    size_t total = 0;
+    while (total < samples)
+    {
+      piece.resize(piece_dist(rng));
+      generate(piece.begin(), piece.end(), [&]() { return sample_dist(rng); });
+      sdft.calc(piece.data(), piece.size());
+      hist.insert(hist.end(), piece.begin(), piece.end());
+      total += piece.size();
+      if (hist.size() >= N)
+      {
+        if (!sdft.isFull())
+        {
+          cout << "*** ERROR: Not full after " << total << " samples" << endl;
+          ok = false;
+        }
+        ok = compare(sdft, hist, a0) && ok;
+        hist.erase(hist.begin(), hist.end() - N);
+      }
+    }
+    return ok;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  int failed = 0;
+  for (size_t N : { 2, 100, 239, 960, 1707 })
+  {
+    for (float a0 : { 1.0f, HAMMING_A0 })
+    {
+      failed += runTest(N, a0, 200 * N) ? 0 : 1;
+    }
+  }
+
+    // Long run, many times longer than the resynchronization interval
+  failed += runTest(400, 1.0f, 16000 * 600) ? 0 : 1;
+
+  cout << (failed == 0 ? "OK" : "FAILED") << endl;
+  return (failed == 0) ? 0 : 1;
+}
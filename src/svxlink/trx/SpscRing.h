@@ -0,0 +1,242 @@
+/**
+@file   SpscRing.h
+@brief  A lock-free single producer, single consumer ring buffer
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef SPSC_RING_INCLUDED
+#define SPSC_RING_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <vector>
+#include <atomic>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A lock-free ring buffer for one producer and one consumer thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This is a ring buffer of preallocated slots that is used to pass data from
+one thread to another without locking. The producer fill in the slot returned
+by writeSlot and then publish it using commitWrite. The consumer get the
+oldest published slot using readSlot and give it back using commitRead. The
+slot objects are reused so, if they are containers, their memory is only
+allocated until they have grown to the largest size used.
+
+Only one thread may write and only one thread may read. The consumer need to
+be woken up some other way, like through a pipe.
+*/
+template <typename T>
+class SpscRing
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   size The minimum number of slots, rounded up to a power of two
+     */
+    explicit SpscRing(size_t size) : m_head(0), m_tail(0)
+    {
+      size_t slots = 1;
+      while (slots < size)
+      {
+        slots <<= 1;
+      }
+      m_slots.resize(slots);
+      m_mask = slots - 1;
+    }
+
+    /**
+     * @brief   Get the number of slots
+     * @return  Returns the capacity of the ring
+     */
+    size_t capacity(void) const { return m_slots.size(); }
+
+    /**
+     * @brief   Get the number of published slots
+     * @return  Returns the number of slots waiting to be read
+     *
+     * The value is only a snapshot if called by another thread than the
+     * producer or the consumer.
+     */
+    size_t count(void) const
+    {
+      return m_head.load(std::memory_order_acquire) -
+             m_tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief   Get the next slot to write to (producer only)
+     * @return  Returns a pointer to the slot or 0 if the ring is full
+     */
+    T *writeSlot(void)
+    {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      if (head - m_tail.load(std::memory_order_acquire) == m_slots.size())
+      {
+        return 0;
+      }
+      return &m_slots[head & m_mask];
+    }
+
+    /**
+     * @brief   Publish the slot returned by writeSlot (producer only)
+     */
+    void commitWrite(void)
+    {
+      m_head.store(m_head.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    }
+
+    /**
+     * @brief   Copy an object into the ring (producer only)
+     * @param   obj The object to copy
+     * @return  Returns \em true on success or \em false if the ring is full
+     */
+    bool push(const T &obj)
+    {
+      T *slot = writeSlot();
+      if (slot == 0)
+      {
+        return false;
+      }
+      *slot = obj;
+      commitWrite();
+      return true;
+    }
+
+    /**
+     * @brief   Get the oldest published slot (consumer only)
+     * @return  Returns a pointer to the slot or 0 if the ring is empty
+     */
+    T *readSlot(void)
+    {
+      const size_t tail = m_tail.load(std::memory_order_relaxed);
+      if (tail == m_head.load(std::memory_order_acquire))
+      {
+        return 0;
+      }
+      return &m_slots[tail & m_mask];
+    }
+
+    /**
+     * @brief   Give back the slot returned by readSlot (consumer only)
+     */
+    void commitRead(void)
+    {
+      m_tail.store(m_tail.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    }
+
+  private:
+    std::vector<T>                  m_slots;
+    size_t                          m_mask;
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+
+    SpscRing(const SpscRing&);
+    SpscRing& operator=(const SpscRing&);
+
+};  /* class SpscRing */
+
+
+//} /* namespace */
+
+#endif /* SPSC_RING_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+#include "SpscRing.h"
+
+using namespace std;
+
+
+/*
+ * Verify the SpscRing class
+ *
+ * Usage: SpscRingTest
+ *
+ * A producer thread write blocks of increasing sequence numbers, of varying
+ * length, into a small ring while the consumer thread read them back. All
+ * blocks must arrive complete and in order. The exit status is zero if the
+ * test pass.
+ */
+
+namespace {
+  const unsigned BLOCKS = 200000;
+};
+
+
+int main(int argc, const char **argv)
+{
+  SpscRing<vector<unsigned> > ring(5);
+  if (ring.capacity() != 8)
+  {
+    cout << "FAILED capacity=" << ring.capacity() << endl;
+    return 1;
+  }
+
+  thread producer([&]
+      {
+        unsigned seq = 0;
+        for (unsigned block=0; block<BLOCKS; ++block)
+        {
+          vector<unsigned> *slot;
+          while ((slot = ring.writeSlot()) == 0)
+          {
+            this_thread::yield();
+          }
+          slot->resize(1 + block % 37);
+          for (auto& val : *slot)
+          {
+            val = seq++;
+          }
+          ring.commitWrite();
+        }
+      });
+
+  unsigned expected = 0;
+  unsigned errors = 0;
+  for (unsigned block=0; block<BLOCKS; ++block)
+  {
+    vector<unsigned> *slot;
+    while ((slot = ring.readSlot()) == 0)
+    {
+      this_thread::yield();
+    }
+    if (slot->size() != 1 + block % 37)
+    {
+      errors += 1;
+    }
+    for (auto val : *slot)
+    {
+      if (val != expected++)
+      {
+        errors += 1;
+      }
+    }
+    ring.commitRead();
+  }
+  producer.join();
+
+  const bool ok = (errors == 0) && (ring.count() == 0);
+  cout << (ok ? "OK" : "FAILED") << " errors=" << errors << endl;
+  return ok ? 0 : 1;
+}
@@ -136,6 +136,7 @@ class SquelchCtcss : public Squelch
      */
     virtual ~SquelchCtcss(void)
     {
+      delete m_bpf;
       delete m_splitter;
     }
 
@@ -229,6 +230,17 @@ class SquelchCtcss : public Squelch
 
       m_splitter = new Async::AudioSplitter;
 
+        // All tone detectors except the neighbour bins mode get their input
+        // through the same CTCSS band pass filter. The filter is run once,
+        // before the audio is split up between the tone detectors.
+      if (ctcss_mode != 1)
+      {
+        std::stringstream filter_spec;
+        filter_spec << "BpBu8/" << bpf_low << "-" << bpf_high;
+        m_bpf = new Async::AudioFilter(filter_spec.str());
+        m_bpf->registerSink(m_splitter);
+      }
+
       for (FqList::const_iterator it = ctcss_fqs.begin();
            it != ctcss_fqs.end(); ++it)
       {
@@ -238,13 +250,9 @@ class SquelchCtcss : public Squelch
         det->activated.connect(sigc::bind(
             sigc::mem_fun(*this, &SquelchCtcss::checkSignalDetected), det));
         det->snrUpdated.connect(sigc::bind(snrUpdated.make_slot(), ctcss_fq));
-        Async::AudioSink *sink = det;
 
         m_dets.push_back(det);
 
-        std::stringstream filter_spec;
-        filter_spec << "BpBu8/" << bpf_low << "-" << bpf_high;
-
         switch (ctcss_mode)
         {
           case 1:
@@ -273,12 +281,6 @@ class SquelchCtcss : public Squelch
             det->setUndetectSnrThresh(close_threshs[ctcss_fq], bpf_high - bpf_low);
             det->setUndetectStableCountThresh(2);
             //det->setUndetectPhaseBwThresh(4.0f, 16.0f);
-
-              // Set up CTCSS band pass filter
-            Async::AudioFilter *filter =
-              new Async::AudioFilter(filter_spec.str());
-            filter->registerSink(det, true);
-            sink = filter;
             break;
           }
 
@@ -298,12 +300,6 @@ class SquelchCtcss : public Squelch
             //det->setUndetectPeakToTotPwrThresh(0.3f);
             det->setUndetectSnrThresh(close_threshs[ctcss_fq], bpf_high - bpf_low);
             det->setUndetectStableCountThresh(2);
-
-              // Set up CTCSS band pass filter
-            Async::AudioFilter *filter =
-              new Async::AudioFilter(filter_spec.str());
-            filter->registerSink(det, true);
-            sink = filter;
             break;
           }
 
@@ -328,24 +324,20 @@ class SquelchCtcss : public Squelch
             det->setDetectUseWindowing(USE_WINDOWING);
             det->setDetectPeakThresh(0.0f);
             det->setDetectSnrThresh(open_threshs[ctcss_fq], bpf_high - bpf_low);
+            det->setDetectSlidingDft(true);
 
             det->setUndetectBw(8.0f);
             det->setUndetectOverlapPercent(OVERLAP_PERCENT);
             det->setUndetectDelay(100);
             det->setUndetectUseWindowing(USE_WINDOWING);
             det->setUndetectPeakThresh(0.0f);
+            det->setUndetectSlidingDft(true);
             det->setUndetectSnrThresh(close_threshs[ctcss_fq], bpf_high - bpf_low);
-
-              // Set up CTCSS band pass filter
-            Async::AudioFilter *filter =
-              new Async::AudioFilter(filter_spec.str());
-            filter->registerSink(det, true);
-            sink = filter;
             break;
           }
         }
 
-        m_splitter->addSink(sink, true);
+        m_splitter->addSink(det, true);
       }
 
       cfg.getValue(rx_name, "CTCSS_DEBUG", m_debug);
@@ -408,6 +400,10 @@ class SquelchCtcss : public Squelch
      */
     int processSamples(const float *samples, int count)
     {
+      if (m_bpf != nullptr)
+      {
+        return m_bpf->writeSamples(samples, count);
+      }
       return m_splitter->writeSamples(samples, count);
     }
 
@@ -428,6 +424,7 @@ class SquelchCtcss : public Squelch
 
     DetList                       m_dets;
     Async::AudioSplitter*         m_splitter            = nullptr;
+    Async::AudioFilter*           m_bpf                 = nullptr;
     ToneDetector*                 m_active_det          = nullptr;
     std::map<float, float>        m_ctcss_snr_offsets;
     bool                          m_debug               = false;
@@ -125,8 +125,9 @@ namespace {
 
 SvxSwDtmfDecoder::SvxSwDtmfDecoder(Config &cfg, const string &name)
   : DtmfDecoder(cfg, name), twist_nrm_thresh(0), twist_rev_thresh(0),
-    row(8), col(8), block_size(0), block_pos(0), det_cnt(0), undet_cnt(0),
-    last_digit_active(0), min_det_cnt(DEFAULT_MIN_DET_CNT),
+    row(8), col(8), fund_bank(INTERNAL_SAMPLE_RATE),
+    ot_bank(INTERNAL_SAMPLE_RATE), block_size(0), block_pos(0), det_cnt(0),
+    undet_cnt(0), last_digit_active(0), min_det_cnt(DEFAULT_MIN_DET_CNT),
     min_undet_cnt(DEFAULT_MIN_UNDET_CNT), det_state(STATE_IDLE),
     det_cnt_weight(0), duration(0), undet_thresh(0), debug(false),
     win_pwr_comp(0.0f)
@@ -161,6 +162,25 @@ SvxSwDtmfDecoder::SvxSwDtmfDecoder(Config &cfg, const string &name)
   }
   win_pwr_comp /= BLOCK_SIZE;
   win_pwr_comp = 1.0f / win_pwr_comp;
+
+    // The fundamentals of all eight tones are calculated in one bank, rows
+    // first. The overtone bank holds the two overtones and the
+    // intermodulation product for the strongest row and column tones.
+  const vector<float> window(win, win + BLOCK_SIZE);
+  for (size_t i=0; i<4; ++i)
+  {
+    fund_bank.addBin(row[i].m_freq);
+  }
+  for (size_t i=0; i<4; ++i)
+  {
+    fund_bank.addBin(col[i].m_freq);
+  }
+  fund_bank.setWindow(window);
+  for (size_t i=0; i<3; ++i)
+  {
+    ot_bank.addBin(0.0f);
+  }
+  ot_bank.setWindow(window);
 } /* SvxSwDtmfDecoder::SvxSwDtmfDecoder */
 
 
@@ -243,32 +263,11 @@ int SvxSwDtmfDecoder::writeSamples(const float *buf, int len)
 
 void SvxSwDtmfDecoder::processBlock(void)
 {
-    // Reset all Goertzel objects
-  row[0].reset();
-  row[1].reset();
-  row[2].reset();
-  row[3].reset();
-  col[0].reset();
-  col[1].reset();
-  col[2].reset();
-  col[3].reset();
-
     // Calculate the total block energy and energy for all individual
-    // Goertzel detectors over the block
-  double block_energy = 0.0;
-  for (size_t i=0; i<BLOCK_SIZE; ++i)
-  {
-    float sample = block[i] * win[i];
-    block_energy += static_cast<double>(sample) * sample;
-    row[0].calc(sample);
-    row[1].calc(sample);
-    row[2].calc(sample);
-    row[3].calc(sample);
-    col[0].calc(sample);
-    col[1].calc(sample);
-    col[2].calc(sample);
-    col[3].calc(sample);
-  }
+    // Goertzel detectors over the windowed block
+  fund_bank.reset();
+  fund_bank.calc(block, BLOCK_SIZE);
+  const double block_energy = fund_bank.passbandEnergy();
   ios_base::fmtflags orig_cout_flags(cout.flags());
   if (debug)
   {
@@ -301,7 +300,7 @@ void SvxSwDtmfDecoder::processBlock(void)
     float col_sum = 0.0f;
     for (size_t i = 0; i < 4; ++i)
     {
-      const float row_ms = WIN_ENB * row[i].magnitudeSquared();
+      const float row_ms = WIN_ENB * fund_bank.magnitudeSquared(i);
       if (row_ms > max_row_ms)
       {
         max_row_ms = row_ms;
@@ -309,7 +308,7 @@ void SvxSwDtmfDecoder::processBlock(void)
       }
       row_sum += row_ms;
 
-      const float col_ms = WIN_ENB * col[i].magnitudeSquared();
+      const float col_ms = WIN_ENB * fund_bank.magnitudeSquared(i+4);
       if (col_ms > max_col_ms)
       {
         max_col_ms = col_ms;
@@ -383,21 +382,15 @@ void SvxSwDtmfDecoder::processBlock(void)
     // that this is not a DTMF digit.
   if (digit_active)
   {
-    Goertzel im(max_col.m_freq + max_col.m_freq - max_row.m_freq,
-                INTERNAL_SAMPLE_RATE);
-    row[max_row_idx+4].reset();
-    col[max_col_idx+4].reset();
-    for (size_t i=0; i<BLOCK_SIZE; ++i)
-    {
-      float sample = block[i] * win[i];
-      im.calc(sample);
-      row[max_row_idx+4].calc(sample);
-      col[max_col_idx+4].calc(sample);
-    }
-
-    float row_ot_rel = row[max_row_idx+4].magnitudeSquared() / max_row_ms;
-    float col_ot_rel = col[max_col_idx+4].magnitudeSquared() / max_col_ms;
-    float im_rel = im.magnitudeSquared() / (max_row_ms + max_col_ms);
+    ot_bank.setFrequency(0, row[max_row_idx+4].m_freq);
+    ot_bank.setFrequency(1, col[max_col_idx+4].m_freq);
+    ot_bank.setFrequency(2, max_col.m_freq + max_col.m_freq - max_row.m_freq);
+    ot_bank.reset();
+    ot_bank.calc(block, BLOCK_SIZE);
+
+    float row_ot_rel = ot_bank.magnitudeSquared(0) / max_row_ms;
+    float col_ot_rel = ot_bank.magnitudeSquared(1) / max_col_ms;
+    float im_rel = ot_bank.magnitudeSquared(2) / (max_row_ms + max_col_ms);
     if (debug)
     {
       cout << " row3rd=" << row_ot_rel;
@@ -57,6 +57,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "DtmfDecoder.h"
 #include "Goertzel.h"
+#include "GoertzelBank.h"
 
 
 /****************************************************************************
@@ -200,6 +201,8 @@ class SvxSwDtmfDecoder : public DtmfDecoder
     float twist_rev_thresh;
     std::vector<DtmfGoertzel> row;
     std::vector<DtmfGoertzel> col;
+    GoertzelBank fund_bank;
+    GoertzelBank ot_bank;
     float block[BLOCK_SIZE];
     size_t block_size;
     size_t block_pos;
@@ -0,0 +1,619 @@
+/**
+@file   ToneAnalyzer.cpp
+@brief  A spectral analysis shared by all tone detectors of a receiver
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ToneAnalyzer.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The Hamming window constant. Must be the same as in ToneDetector.
+#define WINDOW_A0 (25.0 / 46.0)
+
+  // The largest distance, in DFT bins, from the frequency grid for a bin to
+  // be taken from the FFT
+#define MAX_GRID_OFFSET 1.0e-4
+
+  // The relative cost of one Goertzel iteration, for all SIMD lanes, and
+  // one complex multiply and add in the FFT. Measured using
+  // ToneAnalyzer_bench.
+#define GOERTZEL_COST 1.0
+#define FFT_COST 0.7
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+/**
+ * A mixed radix, decimation in time, complex FFT. Any size can be used but
+ * sizes with only small prime factors are the most efficient.
+ */
+class ToneAnalyzer::Fft
+{
+  public:
+    explicit Fft(size_t n)
+      : m_n(n), m_twiddle(n)
+    {
+      for (size_t i=0; i<n; ++i)
+      {
+        const double w = -2.0 * M_PI * i / n;
+        m_twiddle[i] = complex<float>(cos(w), sin(w));
+      }
+      size_t rest = n;
+      while ((rest % 4) == 0)
+      {
+        m_factors.push_back(4);
+        rest /= 4;
+      }
+      for (size_t p=2; rest>1; ++p)
+      {
+        while ((rest % p) == 0)
+        {
+          m_factors.push_back(p);
+          rest /= p;
+        }
+      }
+      m_scratch.resize(m_factors.empty() ? 1 :
+                       *max_element(m_factors.begin(), m_factors.end()));
+    }
+
+      // The complex multiplication is written out to not get the slow NaN
+      // checking code generated for std::complex
+    static complex<float> cmul(const complex<float>& a,
+                               const complex<float>& b)
+    {
+      return complex<float>(a.real() * b.real() - a.imag() * b.imag(),
+                            a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    size_t size(void) const { return m_n; }
+
+      // The estimated number of complex multiply and add operations
+    double cost(void) const
+    {
+      double cost = 0.0;
+      for (size_t p : m_factors)
+      {
+        cost += static_cast<double>(m_n) * p;
+      }
+      return cost;
+    }
+
+    void transform(const complex<float> *in, complex<float> *out)
+    {
+      transform(in, out, m_n, 1, 0);
+    }
+
+  private:
+    size_t                    m_n;
+    vector<size_t>            m_factors;
+    vector<complex<float> >   m_twiddle;
+    vector<complex<float> >   m_scratch;
+
+    void transform(const complex<float> *in, complex<float> *out, size_t n,
+                   size_t stride, size_t factor_idx)
+    {
+      if (n == 1)
+      {
+        out[0] = in[0];
+        return;
+      }
+
+        // Transform each of the p interleaved sub-sequences of length m and
+        // then combine them using p point DFTs
+      const size_t p = m_factors[factor_idx];
+      const size_t m = n / p;
+      for (size_t q=0; q<p; ++q)
+      {
+        transform(in + q * stride, out + q * m, m, stride * p,
+                  factor_idx + 1);
+      }
+
+      const size_t tw_step = m_n / n;
+      if (p == 2)
+      {
+        for (size_t k=0; k<m; ++k)
+        {
+          const complex<float> t = cmul(out[m + k], m_twiddle[k * tw_step]);
+          out[m + k] = out[k] - t;
+          out[k] += t;
+        }
+        return;
+      }
+
+      if (p == 4)
+      {
+        for (size_t k=0; k<m; ++k)
+        {
+          const complex<float> t0 = out[k];
+          const complex<float> t1 = cmul(out[m + k], m_twiddle[k * tw_step]);
+          const complex<float> t2 = cmul(out[2 * m + k],
+                                        m_twiddle[2 * k * tw_step]);
+          const complex<float> t3 = cmul(out[3 * m + k],
+                                        m_twiddle[3 * k * tw_step]);
+          const complex<float> a0 = t0 + t2;
+          const complex<float> a1 = t0 - t2;
+          const complex<float> a2 = t1 + t3;
+          const complex<float> d = t1 - t3;
+          const complex<float> a3(d.imag(), -d.real());
+          out[k] = a0 + a2;
+          out[m + k] = a1 + a3;
+          out[2 * m + k] = a0 - a2;
+          out[3 * m + k] = a1 - a3;
+        }
+        return;
+      }
+
+        // Generic p point DFT. The twiddle factor for u*v in the p point
+        // DFT is the twiddle factor for u*v*m in the n point DFT.
+      complex<float> *t = m_scratch.data();
+      for (size_t k=0; k<m; ++k)
+      {
+        for (size_t u=0; u<p; ++u)
+        {
+          t[u] = cmul(out[u * m + k], m_twiddle[u * k * tw_step]);
+        }
+        for (size_t v=0; v<p; ++v)
+        {
+          complex<float> sum = t[0];
+          size_t idx = 0;
+          const size_t step = (v * m * tw_step) % m_n;
+          for (size_t u=1; u<p; ++u)
+          {
+            idx += step;
+            if (idx >= m_n)
+            {
+              idx -= m_n;
+            }
+            sum += cmul(t[u], m_twiddle[idx]);
+          }
+          out[v * m + k] = sum;
+        }
+      }
+    }
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ToneAnalyzer::ToneAnalyzer(unsigned sample_rate)
+  : m_sample_rate(sample_rate)
+{
+} /* ToneAnalyzer::ToneAnalyzer */
+
+
+ToneAnalyzer::~ToneAnalyzer(void)
+{
+} /* ToneAnalyzer::~ToneAnalyzer */
+
+
+shared_ptr<ToneAnalyzer::Analysis> ToneAnalyzer::analysis(size_t block_len,
+    size_t hop, bool use_windowing)
+{
+  assert(block_len > 0);
+  hop = min(max(hop, static_cast<size_t>(1)), block_len);
+  for (const auto& a : m_analyses)
+  {
+    if ((a->blockLen() == block_len) && (a->hopLength() == hop) &&
+        (a->useWindowing() == use_windowing))
+    {
+      return a;
+    }
+  }
+  shared_ptr<Analysis> a(
+      new Analysis(m_sample_rate, block_len, hop, use_windowing));
+  m_analyses.push_back(a);
+  return a;
+} /* ToneAnalyzer::analysis */
+
+
+int ToneAnalyzer::writeSamples(const float *samples, int count)
+{
+    // Drop the analyses that no one is using anymore
+  auto unused = [](const shared_ptr<Analysis>& a)
+  {
+    return a.use_count() == 1;
+  };
+  m_analyses.erase(remove_if(m_analyses.begin(), m_analyses.end(), unused),
+                   m_analyses.end());
+
+    // A copy of the list is used since a detector may ask for a new
+    // analysis when it is notified about a result
+  const vector<shared_ptr<Analysis> > analyses(m_analyses);
+  for (const auto& a : analyses)
+  {
+    a->process(samples, count);
+  }
+  return count;
+} /* ToneAnalyzer::writeSamples */
+
+
+void ToneAnalyzer::flushSamples(void)
+{
+  sourceAllSamplesFlushed();
+} /* ToneAnalyzer::flushSamples */
+
+
+ToneAnalyzer::Analysis::~Analysis(void)
+{
+  delete m_fft;
+} /* ToneAnalyzer::Analysis::~Analysis */
+
+
+size_t ToneAnalyzer::Analysis::addBin(float freq)
+{
+  size_t free_bin = m_bins.size();
+  for (size_t i=0; i<m_bins.size(); ++i)
+  {
+    if (m_bins[i].users > 0)
+    {
+      if (m_bins[i].freq == freq)
+      {
+        m_bins[i].users += 1;
+        return i;
+      }
+    }
+    else if (free_bin == m_bins.size())
+    {
+      free_bin = i;
+    }
+  }
+
+  if (free_bin == m_bins.size())
+  {
+    m_bins.push_back(Bin());
+    m_res.push_back(0.0f);
+    m_mag_sqr.push_back(0.0f);
+  }
+  Bin& bin = m_bins[free_bin];
+  bin.freq = freq;
+  bin.users = 1;
+  m_res[free_bin] = 0.0f;
+  m_mag_sqr[free_bin] = 0.0f;
+  m_dirty = true;
+  return free_bin;
+} /* ToneAnalyzer::Analysis::addBin */
+
+
+void ToneAnalyzer::Analysis::removeBin(size_t bin)
+{
+  assert((bin < m_bins.size()) && (m_bins[bin].users > 0));
+  if (--m_bins[bin].users == 0)
+  {
+    m_dirty = true;
+  }
+} /* ToneAnalyzer::Analysis::removeBin */
+
+
+bool ToneAnalyzer::Analysis::usesFft(void) const
+{
+  const_cast<Analysis*>(this)->setup();
+  return m_use_fft;
+} /* ToneAnalyzer::Analysis::usesFft */
+
+
+void ToneAnalyzer::Analysis::process(const float *samples, size_t count)
+{
+  while (count > 0)
+  {
+    const size_t cnt = min(count, m_hop_left);
+    for (size_t i=0; i<cnt; ++i)
+    {
+      m_hist[m_hist_pos] = samples[i];
+      if (++m_hist_pos == m_block_len)
+      {
+        m_hist_pos = 0;
+      }
+    }
+    m_fill = min(m_fill + cnt, m_block_len);
+    m_hop_left -= cnt;
+    samples += cnt;
+    count -= cnt;
+
+      // The first result is ready when a whole block has been received and
+      // then every hop samples
+    if (m_hop_left == 0)
+    {
+      assert(m_fill == m_block_len);
+      m_hop_left = m_hop;
+      analyze();
+      analysisDone();
+    }
+  }
+} /* ToneAnalyzer::Analysis::process */
+
+
+void ToneAnalyzer::Analysis::reset(void)
+{
+  fill(m_hist.begin(), m_hist.end(), 0.0f);
+  m_hist_pos = 0;
+  m_fill = 0;
+  m_hop_left = m_block_len;
+} /* ToneAnalyzer::Analysis::reset */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+ToneAnalyzer::Analysis::Analysis(unsigned sample_rate, size_t block_len,
+                                 size_t hop, bool use_windowing)
+  : m_sample_rate(sample_rate), m_block_len(block_len), m_hop(hop),
+    m_hist(block_len), m_block(block_len), m_bank(sample_rate)
+{
+  if (use_windowing)
+  {
+    for (size_t i=0; i<m_block_len; ++i)
+    {
+      m_window.push_back(
+          WINDOW_A0 - (1.0f - WINDOW_A0) * cosf(2.0f * M_PI * i /
+                                                (m_block_len - 1)));
+    }
+  }
+  reset();
+} /* ToneAnalyzer::Analysis::Analysis */
+
+
+void ToneAnalyzer::Analysis::setup(void)
+{
+  if (!m_dirty)
+  {
+    return;
+  }
+  m_dirty = false;
+
+    // Find the bins that are centered on the DFT frequency grid. The FFT is
+    // calculated using a complex FFT of half the block length so the block
+    // length must be even.
+  size_t grid_bins = 0;
+  for (Bin& bin : m_bins)
+  {
+    const double k = static_cast<double>(bin.freq) * m_block_len /
+                     m_sample_rate;
+    const double k_int = round(k);
+    bin.from_fft = (bin.users > 0) && ((m_block_len % 2) == 0) &&
+                  (fabs(k - k_int) < MAX_GRID_OFFSET) && (k_int >= 0.0) &&
+                  (k_int <= m_block_len / 2);
+    bin.fft_bin = bin.from_fft ? static_cast<size_t>(k_int) : 0;
+    const double w = -2.0 * M_PI * bin.fft_bin / m_block_len;
+    bin.fft_twiddle = complex<float>(cos(w), sin(w));
+    grid_bins += bin.from_fft ? 1 : 0;
+  }
+
+    // Use the FFT if it is estimated to be cheaper than running the grid
+    // bins through the Goertzel bank, which run a number of bins in
+    // parallel depending on the SIMD instruction set used.
+  m_use_fft = false;
+  if (grid_bins > 0)
+  {
+    if ((m_fft == nullptr) || (m_fft->size() != m_block_len / 2))
+    {
+      delete m_fft;
+      m_fft = new Fft(m_block_len / 2);
+    }
+    unsigned lanes = 1;
+    switch (GoertzelBank::isa())
+    {
+      case GoertzelBank::ISA_AVX:
+        lanes = 8;
+        break;
+      case GoertzelBank::ISA_SSE:
+      case GoertzelBank::ISA_NEON:
+        lanes = 4;
+        break;
+      default:
+        break;
+    }
+    const double goertzel_cost =
+      GOERTZEL_COST * m_block_len * ((grid_bins + lanes - 1) / lanes);
+    const double fft_cost = FFT_COST * (m_fft->cost() + m_block_len / 2);
+    m_use_fft = (fft_cost < goertzel_cost);
+  }
+
+    // All bins that are not taken from the FFT are run in the Goertzel bank
+  m_bank = GoertzelBank(m_sample_rate);
+  m_bank.setWindow(m_window, false);
+  for (Bin& bin : m_bins)
+  {
+    bin.from_fft = bin.from_fft && m_use_fft;
+    if ((bin.users > 0) && !bin.from_fft)
+    {
+      bin.bank_bin = m_bank.addBin(bin.freq);
+    }
+  }
+  if (m_use_fft)
+  {
+    m_fft_in.resize(m_block_len / 2);
+    m_fft_out.resize(m_block_len / 2);
+  }
+  else
+  {
+    delete m_fft;
+    m_fft = nullptr;
+  }
+} /* ToneAnalyzer::Analysis::setup */
+
+
+void ToneAnalyzer::Analysis::analyze(void)
+{
+  setup();
+
+    // Put the samples of the last block in order, oldest first
+  copy(m_hist.begin() + m_hist_pos, m_hist.end(), m_block.begin());
+  copy(m_hist.begin(), m_hist.begin() + m_hist_pos,
+       m_block.begin() + (m_block_len - m_hist_pos));
+
+    // The Goertzel bank sum up the passband energy while running the bins.
+    // If all bins are taken from the FFT, it is summed up here instead.
+  if (m_bank.size() > 0)
+  {
+    m_bank.reset();
+    m_bank.calc(m_block.data(), m_block_len);
+    m_energy = m_bank.passbandEnergy();
+  }
+  else
+  {
+    m_energy = 0.0;
+    for (size_t i=0; i<m_block_len; ++i)
+    {
+      m_energy += static_cast<double>(m_block[i]) * m_block[i];
+    }
+  }
+
+  if (m_use_fft)
+  {
+      // The real block is packed into a complex sequence of half the length,
+      // even samples in the real part and odd samples in the imaginary part.
+    const size_t m = m_block_len / 2;
+    for (size_t i=0; i<m; ++i)
+    {
+      float re = m_block[2 * i];
+      float im = m_block[2 * i + 1];
+      if (!m_window.empty())
+      {
+        re *= m_window[2 * i];
+        im *= m_window[2 * i + 1];
+      }
+      m_fft_in[i] = complex<float>(re, im);
+    }
+    m_fft->transform(m_fft_in.data(), m_fft_out.data());
+
+      // Split the packed transform into the transform of the real block,
+      // for the bins needed only:
+      // X[k] = (Z[k] + Z*[m-k]) / 2 - j * exp(-j*pi*k/m) * (Z[k] - Z*[m-k]) / 2
+    for (size_t i=0; i<m_bins.size(); ++i)
+    {
+      if ((m_bins[i].users == 0) || !m_bins[i].from_fft)
+      {
+        continue;
+      }
+      const size_t k = m_bins[i].fft_bin;
+      const complex<float> zk = m_fft_out[k % m];
+      const complex<float> zmk = conj(m_fft_out[(m - k) % m]);
+      const complex<float> even = 0.5f * (zk + zmk);
+      const complex<float> d = zk - zmk;
+      const complex<float> odd(0.5f * d.imag(), -0.5f * d.real());
+      m_res[i] = even + Fft::cmul(m_bins[i].fft_twiddle, odd);
+      m_mag_sqr[i] = norm(m_res[i]);
+    }
+  }
+
+  for (size_t i=0; i<m_bins.size(); ++i)
+  {
+    if ((m_bins[i].users > 0) && !m_bins[i].from_fft)
+    {
+      m_res[i] = m_bank.result(m_bins[i].bank_bin);
+      m_mag_sqr[i] = m_bank.magnitudeSquared(m_bins[i].bank_bin);
+    }
+  }
+} /* ToneAnalyzer::Analysis::analyze */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,353 @@
+/**
+@file   ToneAnalyzer.h
+@brief  A spectral analysis shared by all tone detectors of a receiver
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a class that analyzes the audio of a receiver once per hop
+and let a number of tone detectors read their bins from the same analysis
+instead of each running its own.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef TONE_ANALYZER_INCLUDED
+#define TONE_ANALYZER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <cstddef>
+#include <complex>
+#include <memory>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "GoertzelBank.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A spectral analysis shared by all tone detectors of a receiver
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+A receiver may have a number of tone detectors that all look at the same
+audio. Each of them normally buffer the samples, apply a window and run its
+own Goertzel detectors. This class instead do that work once for all
+detectors that use the same block length, hop length and window. Such a set
+of detectors share an Analysis object. Each detector add the bins it need to
+the analysis and is notified through the analysisDone signal each time a new
+result is available.
+
+The bins of an analysis are normally calculated using one Goertzel bank, so
+that the bins of all detectors are run in parallel using SIMD instructions.
+When there are many bins that are centered on the frequency grid of a DFT
+with the block length of the analysis, those bins are instead calculated
+using one FFT. Bins that are off the grid are always calculated using the
+Goertzel bank. The choice is made from an estimate of the number of
+operations needed by the two methods, taking the SIMD width of the Goertzel
+bank into account. The results are the same, apart from rounding, no matter
+which method is used.
+
+\code
+  ToneAnalyzer analyzer(INTERNAL_SAMPLE_RATE);
+  std::shared_ptr<ToneAnalyzer::Analysis> a = analyzer.analysis(320, 80, true);
+  size_t bin = a->addBin(1750.0f);
+  a->analysisDone.connect(...);
+  splitter->addSink(&analyzer);
+  ...
+  float mag_sqr = a->magnitudeSquared(bin);
+\endcode
+
+The first result of an analysis is available when a whole block of samples
+has been received. After that, a new result is available every hop length
+samples.
+*/
+class ToneAnalyzer : public Async::AudioSink
+{
+  public:
+    class Fft;
+
+    /**
+     * @brief The analysis shared by detectors with the same block parameters
+     */
+    class Analysis
+    {
+      public:
+        /**
+         * @brief   Destructor
+         */
+        ~Analysis(void);
+
+        /**
+         * @brief   Get the block length
+         * @return  Returns the number of samples in each analysis block
+         */
+        size_t blockLen(void) const { return m_block_len; }
+
+        /**
+         * @brief   Get the hop length
+         * @return  Returns the number of samples between two results
+         */
+        size_t hopLength(void) const { return m_hop; }
+
+        /**
+         * @brief   Find out if a Hamming window is applied
+         * @return  Returns \em true if the blocks are windowed
+         */
+        bool useWindowing(void) const { return !m_window.empty(); }
+
+        /**
+         * @brief   Add a bin to the analysis
+         * @param   freq The frequency of interest, in Hz
+         * @return  Returns the index of the bin
+         *
+         * If a bin with the same frequency already exist, that bin is shared
+         * and its index is returned. Each call must be matched by a call to
+         * removeBin when the bin is no longer needed.
+         */
+        size_t addBin(float freq);
+
+        /**
+         * @brief   Remove a bin from the analysis
+         * @param   bin The index of the bin, as returned by addBin
+         */
+        void removeBin(size_t bin);
+
+        /**
+         * @brief   Find out if an FFT is used to calculate the bins
+         * @return  Returns \em true if at least one bin is taken from an FFT
+         */
+        bool usesFft(void) const;
+
+        /**
+         * @brief   Get the result for a bin in complex form
+         * @param   bin The index of the bin
+         * @return  Returns the result in the same form as Goertzel::result
+         */
+        std::complex<float> result(size_t bin) const { return m_res[bin]; }
+
+        /**
+         * @brief   Get the magnitude squared for a bin
+         * @param   bin The index of the bin
+         * @return  Returns the magnitude squared
+         */
+        float magnitudeSquared(size_t bin) const { return m_mag_sqr[bin]; }
+
+        /**
+         * @brief   Get the passband energy
+         * @return  Returns the sum of the squared, unwindowed, samples in the
+         *          last block
+         */
+        double passbandEnergy(void) const { return m_energy; }
+
+        /**
+         * @brief   Process a number of samples
+         * @param   samples The samples to process
+         * @param   count   The number of samples
+         *
+         * The analysisDone signal is emitted each time a new result is
+         * available.
+         */
+        void process(const float *samples, size_t count);
+
+        /**
+         * @brief   Forget all samples
+         */
+        void reset(void);
+
+        /**
+         * @brief   A signal that is emitted when a new result is available
+         */
+        sigc::signal<void> analysisDone;
+
+      private:
+        struct Bin
+        {
+          float   freq;
+          int     users;
+          bool    from_fft;
+          size_t  fft_bin;
+          std::complex<float> fft_twiddle;
+          size_t  bank_bin;
+        };
+
+        const unsigned        m_sample_rate;
+        const size_t          m_block_len;
+        const size_t          m_hop;
+        std::vector<float>    m_window;
+        std::vector<Bin>      m_bins;
+        std::vector<std::complex<float> > m_res;
+        std::vector<float>    m_mag_sqr;
+        double                m_energy      = 0.0;
+        std::vector<float>    m_hist;
+        size_t                m_hist_pos    = 0;
+        size_t                m_fill        = 0;
+        size_t                m_hop_left    = 0;
+        std::vector<float>    m_block;
+        GoertzelBank          m_bank;
+        Fft*                  m_fft         = nullptr;
+        std::vector<std::complex<float> > m_fft_in;
+        std::vector<std::complex<float> > m_fft_out;
+        bool                  m_use_fft     = false;
+        bool                  m_dirty       = true;
+
+        Analysis(unsigned sample_rate, size_t block_len, size_t hop,
+                 bool use_windowing);
+        Analysis(const Analysis&);
+        Analysis& operator=(const Analysis&);
+        void setup(void);
+        void analyze(void);
+
+        friend class ToneAnalyzer;
+    };
+
+    /**
+     * @brief   Constructor
+     * @param   sample_rate The sample rate of the incoming audio
+     */
+    explicit ToneAnalyzer(unsigned sample_rate);
+
+    /**
+     * @brief   Destructor
+     */
+    ~ToneAnalyzer(void);
+
+    /**
+     * @brief   Get the analysis for a set of block parameters
+     * @param   block_len     The number of samples in each block
+     * @param   hop           The number of samples between results
+     * @param   use_windowing Set to \em true to apply a Hamming window
+     * @return  Returns the shared analysis object
+     *
+     * An existing analysis is returned if one with the same parameters
+     * exist. An analysis is kept alive for as long as someone hold a
+     * reference to it.
+     */
+    std::shared_ptr<Analysis> analysis(size_t block_len, size_t hop,
+                                       bool use_windowing);
+
+    /**
+     * @brief   Get the number of analyses in use
+     * @return  Returns the number of analysis objects
+     */
+    size_t analysisCount(void) const { return m_analyses.size(); }
+
+    /**
+     * @brief   Write samples into this audio sink
+     * @param   samples The buffer containing the samples
+     * @param   count   The number of samples in the buffer
+     * @return  Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief   Tell the sink to flush the previously written samples
+     */
+    virtual void flushSamples(void);
+
+  private:
+    unsigned                                m_sample_rate;
+    std::vector<std::shared_ptr<Analysis> > m_analyses;
+
+    ToneAnalyzer(const ToneAnalyzer&);
+    ToneAnalyzer& operator=(const ToneAnalyzer&);
+
+};  /* class ToneAnalyzer */
+
+
+//} /* namespace */
+
+#endif /* TONE_ANALYZER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,218 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "GoertzelBank.h"
+#include "ToneAnalyzer.h"
+
+using namespace std;
+
+
+/*
+ * Verify the ToneAnalyzer class against the GoertzelBank class
+ *
+ * Usage: ToneAnalyzerTest
+ *
+ * Random input is fed to analyses with different block and hop lengths, with
+ * and without a Hamming window, in pieces of random size. Each time a result
+ * is available, all bins are compared to a Goertzel bank run over the last
+ * block of samples. Bin sets are chosen so that the bins are calculated both
+ * by the Goertzel bank and by the FFT. The number of results and the sharing
+ * of bins and analyses are also checked.
+ * The exit status is zero if all tests pass.
+ */
+
+namespace {
+  const unsigned SAMPLE_RATE = 16000;
+  const double MAX_REL_ERROR = 1.0e-4;
+  const float HAMMING_A0 = 25.0f / 46.0f;
+
+  mt19937 rng(4711);
+
+  struct Checker
+  {
+    ToneAnalyzer::Analysis *a;
+    vector<float>           fqs;
+    vector<size_t>          bins;
+    vector<float>           hist;
+    size_t                  results = 0;
+    bool                    ok = true;
+
+    void check(void)
+    {
+      const size_t N = a->blockLen();
+      results += 1;
+
+      vector<float> window;
+      if (a->useWindowing())
+      {
+        for (size_t n=0; n<N; ++n)
+        {
+          window.push_back(HAMMING_A0 - (1.0f - HAMMING_A0) *
+                           cosf(2.0f * M_PI * n / (N - 1)));
+        }
+      }
+      GoertzelBank bank(SAMPLE_RATE);
+      for (float fq : fqs)
+      {
+        bank.addBin(fq);
+      }
+      bank.setWindow(window, false);
+      bank.calc(&hist[hist.size() - N], N);
+
+      const double energy = bank.passbandEnergy();
+      if (fabs(a->passbandEnergy() - energy) > 1.0e-9 * energy)
+      {
+        cout << "*** ERROR: N=" << N << " passband energy "
+             << a->passbandEnergy() << " != " << energy << endl;
+        ok = false;
+      }
+
+      const double scale = N * sqrt(energy / N);
+      for (size_t i=0; i<fqs.size(); ++i)
+      {
+        const complex<float> ref = bank.result(i);
+        const complex<float> res = a->result(bins[i]);
+        const float ref_mag = bank.magnitudeSquared(i);
+        const float mag = a->magnitudeSquared(bins[i]);
+        if ((abs(res - ref) > MAX_REL_ERROR * scale) ||
+            (fabs(mag - ref_mag) > MAX_REL_ERROR * scale * scale))
+        {
+          cout << "*** ERROR: N=" << N << " hop=" << a->hopLength()
+               << " win=" << a->useWindowing() << " fq=" << fqs[i]
+               << " res=" << res << " ref=" << ref << " mag=" << mag
+               << " ref_mag=" << ref_mag << endl;
+          ok = false;
+        }
+      }
+    }
+  };
+
+  bool runTest(size_t N, size_t hop, bool use_windowing,
+               const vector<float>& fqs, bool expect_fft)
+  {
+    uniform_real_distribution<float> sample_dist(-1.0f, 1.0f);
+    uniform_int_distribution<size_t> piece_dist(0, 3 * N);
+
+    ToneAnalyzer analyzer(SAMPLE_RATE);
+    auto a = analyzer.analysis(N, hop, use_windowing);
+    Checker checker;
+    checker.a = a.get();
+    checker.fqs = fqs;
+    for (float fq : fqs)
+    {
+      checker.bins.push_back(a->addBin(fq));
+    }
+    a->analysisDone.connect(sigc::mem_fun(checker, &Checker::check));
+
+    bool ok = true;
+    if (a->usesFft() != expect_fft)
+    {
+      cout << "*** ERROR: N=" << N << " bins=" << fqs.size()
+           << " expected " << (expect_fft ? "FFT" : "Goertzel") << endl;
+      ok = false;
+    }
+
+    vector<float> piece;
+    size_t total = 0;
+    while (total < 100 * N)
+    {
+      piece.resize(piece_dist(rng));
+      generate(piece.begin(), piece.end(), [&]() { return sample_dist(rng); });
+      for (float s : piece)
+      {
+          // Feed one sample at a time to the checker history so that it is
+          // up to date when the result is reported
+        checker.hist.push_back(s);
+        analyzer.writeSamples(&s, 1);
+      }
+      total += piece.size();
+    }
+
+    const size_t expected = (total >= N) ? (total - N) / hop + 1 : 0;
+    if (checker.results != expected)
+    {
+      cout << "*** ERROR: N=" << N << " hop=" << hop << " got "
+           << checker.results << " results, expected " << expected << endl;
+      ok = false;
+    }
+    return ok && checker.ok;
+  }
+
+  vector<float> gridBins(size_t N, size_t first, size_t count, float offset)
+  {
+    vector<float> fqs;
+    for (size_t k=first; k<first+count; ++k)
+    {
+      fqs.push_back((k + offset) * static_cast<float>(SAMPLE_RATE) / N);
+    }
+    return fqs;
+  }
+
+  bool testSharing(void)
+  {
+    bool ok = true;
+    ToneAnalyzer analyzer(SAMPLE_RATE);
+    auto a1 = analyzer.analysis(320, 80, true);
+    auto a2 = analyzer.analysis(320, 80, true);
+    auto a3 = analyzer.analysis(320, 320, true);
+    ok = ok && (a1 == a2) && (a1 != a3) && (analyzer.analysisCount() == 2);
+
+    const size_t b1 = a1->addBin(1750.0f);
+    const size_t b2 = a2->addBin(1750.0f);
+    const size_t b3 = a1->addBin(1650.0f);
+    ok = ok && (b1 == b2) && (b1 != b3);
+    a1->removeBin(b1);
+    a1->removeBin(b2);
+    const size_t b4 = a1->addBin(1850.0f);
+    ok = ok && (b4 == b1);
+
+      // Analyses that no one use are dropped
+    a2.reset();
+    a3.reset();
+    float sample = 0.0f;
+    analyzer.writeSamples(&sample, 1);
+    ok = ok && (analyzer.analysisCount() == 1);
+    if (!ok)
+    {
+      cout << "*** ERROR: Sharing of bins or analyses failed" << endl;
+    }
+    return ok;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  int failed = 0;
+  for (bool win : { false, true })
+  {
+      // A few bins, run by the Goertzel bank
+    failed += runTest(320, 80, win, { 1650.0f, 1750.0f, 1850.0f }, false)
+                ? 0 : 1;
+    failed += runTest(333, 333, win, { 67.0f, 136.5f, 1750.0f }, false)
+                ? 0 : 1;
+
+      // Many bins on the grid, taken from the FFT, mixed with bins that are
+      // off the grid. The plain C++ Goertzel bank is used so that the FFT is
+      // chosen for a moderate number of bins.
+    GoertzelBank::setIsa(GoertzelBank::ISA_GENERIC);
+    vector<float> fqs = gridBins(320, 1, 150, 0.0f);
+    fqs.push_back(1807.3f);
+    failed += runTest(320, 80, win, fqs, true) ? 0 : 1;
+    failed += runTest(240, 17, win, gridBins(240, 0, 120, 0.0f), true)
+                ? 0 : 1;
+    GoertzelBank::setIsa(GoertzelBank::ISA_AUTO);
+
+      // Many bins off the grid are always run by the Goertzel bank
+    failed += runTest(320, 160, win, gridBins(320, 1, 150, 0.5f), false)
+                ? 0 : 1;
+  }
+  failed += testSharing() ? 0 : 1;
+
+  cout << (failed == 0 ? "OK" : "FAILED") << endl;
+  return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+#include "GoertzelBank.h"
+#include "ToneDetector.h"
+#include "ToneAnalyzer.h"
+
+using namespace std;
+
+
+/*
+ * Shared tone analyzer benchmark
+ *
+ * Usage: ToneAnalyzer_bench [seconds of audio]
+ *
+ * A number of tone detectors, set up like the tone detectors added by
+ * LocalRxBase::addToneDetector, are run on the same audio. They are first run
+ * on their own and then using a shared tone analyzer. The number of
+ * detections must be the same. The result is given as CPU time per second of
+ * audio. Then the cost of the Goertzel bank and the FFT is measured for a
+ * single analysis with an increasing number of bins, to show where the
+ * analyzer switch to the FFT.
+ */
+
+namespace {
+  const int SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
+  const int BLOCK_SIZE = SAMPLE_RATE / 100;
+  const unsigned det_counts[] = { 1, 4, 8, 16 };
+  const size_t bin_counts[] = { 8, 16, 24, 32, 40, 48, 64, 96, 128, 160 };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  vector<float> makeSignal(int len)
+  {
+    mt19937 rng(4711);
+    normal_distribution<float> noise(0.0f, 0.01f);
+    vector<float> sig(len);
+    for (int n=0; n<len; ++n)
+    {
+        // A 1750Hz tone is on for two seconds and then off for one second
+      const bool on = (n / SAMPLE_RATE) % 3 != 0;
+      sig[n] = noise(rng) + (on ? 0.1f * sinf(2.0f * M_PI * 1750.0f * n /
+                                              SAMPLE_RATE) : 0.0f);
+    }
+    return sig;
+  }
+
+  double runDetectors(unsigned det_cnt, bool shared, const vector<float>& sig,
+                      int blocks, int *detections)
+  {
+    ToneAnalyzer analyzer(SAMPLE_RATE);
+    vector<unique_ptr<ToneDetector> > dets;
+    *detections = 0;
+    for (unsigned i=0; i<det_cnt; ++i)
+    {
+        // Like a tone burst detector with a bandwidth of 25Hz. The first
+        // detector listen for 1750Hz.
+      const float fq = 1750.0f + 100.0f * i;
+      const int bw = 25;
+      ToneDetector *det = new ToneDetector(fq, 2 * bw, 100);
+      det->setPeakThresh(10.0f);
+      det->setDetectOverlapPercent(75);
+      det->setDetectToneFrequencyTolerancePercent(50.0f * bw / fq);
+      det->detected.connect([=](float) { *detections += 1; });
+      if (shared)
+      {
+        det->setToneAnalyzer(&analyzer);
+      }
+      dets.emplace_back(det);
+    }
+
+    const int sig_blocks = sig.size() / BLOCK_SIZE;
+    const double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      const float *samples = &sig[(i % sig_blocks) * BLOCK_SIZE];
+      analyzer.writeSamples(samples, BLOCK_SIZE);
+      for (auto& det : dets)
+      {
+        det->writeSamples(samples, BLOCK_SIZE);
+      }
+    }
+    return cpuTime() - start;
+  }
+
+  double runAnalysis(size_t bins, float offset, const vector<float>& sig,
+                     int blocks, bool *uses_fft)
+  {
+    const size_t N = 320;
+    ToneAnalyzer analyzer(SAMPLE_RATE);
+    auto a = analyzer.analysis(N, N / 4, true);
+    for (size_t k=1; k<=bins; ++k)
+    {
+      a->addBin((k + offset) * static_cast<float>(SAMPLE_RATE) / N);
+    }
+    *uses_fft = a->usesFft();
+
+    const int sig_blocks = sig.size() / BLOCK_SIZE;
+    const double start = cpuTime();
+    for (int i=0; i<blocks; ++i)
+    {
+      analyzer.writeSamples(&sig[(i % sig_blocks) * BLOCK_SIZE], BLOCK_SIZE);
+    }
+    return cpuTime() - start;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 60.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  const vector<float> sig = makeSignal(SAMPLE_RATE * 30);
+  const int blocks = seconds * SAMPLE_RATE / BLOCK_SIZE;
+
+  cout << "SIMD implementation: "
+       << GoertzelBank::isaName(GoertzelBank::isa()) << endl;
+  cout << setw(10) << "detectors" << setw(10) << "private"
+       << setw(10) << "shared" << setw(16) << "detections"
+       << "  (CPU ms per second of audio)" << endl;
+  cout << fixed;
+  for (unsigned det_cnt : det_counts)
+  {
+    int det_private = 0;
+    int det_shared = 0;
+    const double t_private =
+      runDetectors(det_cnt, false, sig, blocks, &det_private);
+    const double t_shared =
+      runDetectors(det_cnt, true, sig, blocks, &det_shared);
+    cout << setw(10) << det_cnt << setprecision(3)
+         << setw(10) << (1e3 * t_private / seconds)
+         << setw(10) << (1e3 * t_shared / seconds)
+         << setw(10) << det_private << setw(6) << det_shared
+         << (det_private == det_shared ? "" : "  MISMATCH") << endl;
+  }
+
+  cout << endl << setw(10) << "bins" << setw(10) << "goertzel"
+       << setw(10) << "grid" << "  (CPU ms per second of audio, N=320, "
+       << "75% overlap)" << endl;
+  for (size_t bins : bin_counts)
+  {
+    bool bank_fft = false;
+    bool grid_fft = false;
+    const double t_bank = runAnalysis(bins, 0.5f, sig, blocks, &bank_fft);
+    const double t_grid = runAnalysis(bins, 0.0f, sig, blocks, &grid_fft);
+    cout << setw(10) << bins << setprecision(3)
+         << setw(10) << (1e3 * t_bank / seconds)
+         << setw(10) << (1e3 * t_grid / seconds)
+         << (grid_fft ? "  FFT" : "  Goertzel") << endl;
+  }
+
+  return 0;
+}
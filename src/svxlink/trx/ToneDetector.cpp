@@ -58,6 +58,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "ToneDetector.h"
 #include "Goertzel.h"
+#include "GoertzelBank.h"
+#include "SlidingDft.h"
+#include "ToneAnalyzer.h"
 
 
 
@@ -88,6 +91,8 @@ using namespace Async;
 
 struct ToneDetector::DetectorParams
 {
+  enum { BIN_CENTER, BIN_LOWER, BIN_UPPER };
+
   float               bw                      = 0.0f;
   int                 detect_delay_ms         = -1;
   int                 stable_count_thresh     = DEFAULT_STABLE_COUNT_THRESH;
@@ -105,14 +110,59 @@ struct ToneDetector::DetectorParams
   float               phase_mean_thresh       = DEFAULT_PHASE_MEAN_THRESH;
   float               phase_var_thresh        = DEFAULT_PHASE_VAR_THRESH;
   float               phase_actual_fq         = 0.0f;
-  Goertzel            center;
-  Goertzel            lower;
-  Goertzel            upper;
+  GoertzelBank        bank {INTERNAL_SAMPLE_RATE};
+  bool                sliding_dft             = false;
+  SlidingDft          sdft {INTERNAL_SAMPLE_RATE};
+  std::shared_ptr<ToneAnalyzer::Analysis> analysis;
+  std::vector<size_t> analysis_bins;
+  sigc::connection    analysis_con;
   std::vector<float>  window_table;
   bool                use_windowing           = DEFAULT_USE_WINDOWING;
   float               peak_to_tot_pwr_thresh  = DEFAULT_PEAK_TO_TOT_PWR_THRESH;
   float               snr_thresh              = DEFAULT_SNR_THRESH;
   float               passband_bw             = 0.0f;
+
+  std::complex<float> result(size_t bin) const
+  {
+    if (analysis)
+    {
+      return analysis->result(analysis_bins[bin]);
+    }
+    return sliding_dft ? sdft.result(bin) : bank.result(bin);
+  }
+
+  float magnitudeSquared(size_t bin) const
+  {
+    if (analysis)
+    {
+      return analysis->magnitudeSquared(analysis_bins[bin]);
+    }
+    return sliding_dft ? sdft.magnitudeSquared(bin)
+                       : bank.magnitudeSquared(bin);
+  }
+
+  double passbandEnergy(void) const
+  {
+    if (analysis)
+    {
+      return analysis->passbandEnergy();
+    }
+    return sliding_dft ? sdft.passbandEnergy() : bank.passbandEnergy();
+  }
+
+  void releaseAnalysis(void)
+  {
+    analysis_con.disconnect();
+    if (analysis)
+    {
+      for (size_t bin : analysis_bins)
+      {
+        analysis->removeBin(bin);
+      }
+      analysis_bins.clear();
+      analysis.reset();
+    }
+  }
 }; /* struct ToneDetector::DetectorParams */
 
 
@@ -166,7 +216,7 @@ namespace
 ToneDetector::ToneDetector(float tone_hz, float width_hz, int det_delay_ms)
   : tone_fq(tone_hz), buf_pos(0), is_activated(false),
     last_active(false), stable_count(0), phase_check_left(-1),
-    par(nullptr), last_snr(0.0f), tone_fq_est(0.0f)
+    par(nullptr), last_snr(0.0f), tone_fq_est(0.0f), analyzer(nullptr)
 {
   det_par = new DetectorParams;
   setDetectBw(width_hz);
@@ -207,6 +257,8 @@ ToneDetector::ToneDetector(float tone_hz, float width_hz, int det_delay_ms)
 
 ToneDetector::~ToneDetector(void)
 {
+  det_par->releaseAnalysis();
+  undet_par->releaseAnalysis();
   delete det_par;
   det_par = 0;
   delete undet_par;
@@ -256,6 +308,42 @@ void ToneDetector::setUndetectOverlapLength(size_t overlap)
 } /* ToneDetector::setUndetectOverlapLength */
 
 
+void ToneDetector::setDetectHopLength(size_t hop)
+{
+  setHopLength(det_par, hop);
+} /* ToneDetector::setDetectHopLength */
+
+
+void ToneDetector::setUndetectHopLength(size_t hop)
+{
+  setHopLength(undet_par, hop);
+} /* ToneDetector::setUndetectHopLength */
+
+
+void ToneDetector::setDetectSlidingDft(bool enable)
+{
+  det_par->sliding_dft = enable;
+  setupSlidingDft(det_par);
+  setupAnalysis(det_par);
+} /* ToneDetector::setDetectSlidingDft */
+
+
+void ToneDetector::setUndetectSlidingDft(bool enable)
+{
+  undet_par->sliding_dft = enable;
+  setupSlidingDft(undet_par);
+  setupAnalysis(undet_par);
+} /* ToneDetector::setUndetectSlidingDft */
+
+
+void ToneDetector::setToneAnalyzer(ToneAnalyzer *analyzer)
+{
+  this->analyzer = analyzer;
+  setupAnalysis(det_par);
+  setupAnalysis(undet_par);
+} /* ToneDetector::setToneAnalyzer */
+
+
 void ToneDetector::reset(void)
 {
   setActivated(false);
@@ -263,11 +351,8 @@ void ToneDetector::reset(void)
   stable_count = 0;
   buf_pos = 0;
   tone_fq_est = 0.0f;
-  passband_energy = 0.0f;
-  win = par->window_table.begin();
-  par->center.reset();
-  par->lower.reset();
-  par->upper.reset();
+  par->bank.reset();
+  par->sdft.reset();
   par->overlap_buf.clear();
   par->prev_res_cmplx = 0;
   phaseCheckReset();
@@ -339,6 +424,8 @@ void ToneDetector::setDetectPeakThresh(float thresh)
   {
     det_par->peak_thresh = 0.0f;
   }
+  setupSlidingDft(det_par);
+  setupAnalysis(det_par);
 } /* ToneDetector::setDetectPeakThresh */
 
 
@@ -352,6 +439,8 @@ void ToneDetector::setUndetectPeakThresh(float thresh)
   {
     undet_par->peak_thresh = 0.0f;
   }
+  setupSlidingDft(undet_par);
+  setupAnalysis(undet_par);
 } /* ToneDetector::setUndetectPeakThresh */
 
 
@@ -397,6 +486,7 @@ void ToneDetector::setDetectPhaseBwThresh(float bw_hz, float stddev_hz)
     det_par->phase_mean_thresh = 0.0f;
     det_par->phase_var_thresh = 0.0f;
   }
+  setupAnalysis(det_par);
 } /* ToneDetector::setDetectPhaseBwThresh */
 
 
@@ -417,6 +507,7 @@ void ToneDetector::setUndetectPhaseBwThresh(float bw_hz, float stddev_hz)
     undet_par->phase_mean_thresh = 0.0f;
     undet_par->phase_var_thresh = 0.0f;
   }
+  setupAnalysis(undet_par);
 } /* ToneDetector::setUndetectPhaseBwThresh */
 
 
@@ -444,57 +535,93 @@ void ToneDetector::setUndetectUseWindowing(bool enable)
 
 int ToneDetector::writeSamples(const float *buf, int len)
 {
+    // The bins are calculated by the shared analyzer
+  if (par->analysis)
+  {
+    return len;
+  }
+
+  if (par->sliding_dft)
+  {
+    slidingDftWriteSamples(buf, len);
+    return len;
+  }
+
   const float *end = buf + len;
   while (buf != end)
   {
-    float famp;
-    if (buf_pos < par->overlap_buf.size())
+      // Find out how many samples that can be processed in one go. We must
+      // stop at the end of the overlap replay, where samples start to be
+      // saved for the next block, at the next phase check and at the end of
+      // the block.
+    const bool replay = (buf_pos < par->overlap_buf.size());
+    size_t cnt = par->block_len - buf_pos;
+    if (replay)
     {
-      famp = par->overlap_buf.at(buf_pos);
+      cnt = min(cnt, par->overlap_buf.size() - buf_pos);
     }
     else
     {
-      famp = *buf++;
+      cnt = min(cnt, static_cast<size_t>(end - buf));
     }
     const size_t non_overlap_len = par->block_len - par->overlap_buf_size;
-    if (buf_pos >= non_overlap_len)
+    if (buf_pos < non_overlap_len)
     {
-      const size_t insert_pos = buf_pos - non_overlap_len;
-      if (insert_pos < par->overlap_buf.size())
-      {
-        par->overlap_buf[insert_pos] = famp;
-      }
-      else
-      {
-        par->overlap_buf.push_back(famp);
-      }
+      cnt = min(cnt, non_overlap_len - buf_pos);
     }
-
-    passband_energy += static_cast<double>(famp) * famp;
-
-      // First apply the Hamming window, if enabled
-    if (par->use_windowing)
+    if (phase_check_left > 0)
     {
-      famp *= *(win++);
+      cnt = min(cnt, static_cast<size_t>(phase_check_left));
     }
 
-      // Run the recursive Goertzel stage for the center frequency
-    par->center.calc(famp);
+      // Replayed samples are copied out of the overlap buffer since the
+      // buffer may be written to below
+    const float *samples;
+    if (replay)
+    {
+      replay_buf.assign(par->overlap_buf.begin() + buf_pos,
+                        par->overlap_buf.begin() + buf_pos + cnt);
+      samples = replay_buf.data();
+    }
+    else
+    {
+      samples = buf;
+      buf += cnt;
+    }
 
-    if (par->peak_thresh > 0.0f)
+    if (buf_pos >= non_overlap_len)
     {
-        // Run the recursive Goertzel stage for the lower and upper frequency
-      par->lower.calc(famp);
-      par->upper.calc(famp);
+      const size_t insert_pos = buf_pos - non_overlap_len;
+      for (size_t i=0; i<cnt; ++i)
+      {
+        if (insert_pos + i < par->overlap_buf.size())
+        {
+          par->overlap_buf[insert_pos + i] = samples[i];
+        }
+        else
+        {
+          par->overlap_buf.push_back(samples[i]);
+        }
+      }
     }
 
-    if ((phase_check_left > 0) && (--phase_check_left == 0))
+      // Run the recursive Goertzel stages for the center, lower and upper
+      // frequency. The bank also applies the Hamming window, if enabled, and
+      // sum up the passband energy.
+    par->bank.calc(samples, cnt);
+    buf_pos += cnt;
+
+    if (phase_check_left > 0)
     {
-      phaseCheck();
-      phase_check_left = par->period_block_len;
+      phase_check_left -= cnt;
+      if (phase_check_left == 0)
+      {
+        phaseCheck();
+        phase_check_left = par->period_block_len;
+      }
     }
 
-    if (++buf_pos >= par->block_len)
+    if (buf_pos >= par->block_len)
     {
       postProcess();
     }
@@ -529,7 +656,7 @@ void ToneDetector::phaseCheckReset(void)
 
 void ToneDetector::phaseCheck(void)
 {
-  float phase = par->center.phase();
+  float phase = Goertzel::phase(par->result(DetectorParams::BIN_CENTER));
   if (prev_phase < 2.0f * M_PI)
   {
     float diff = phase - prev_phase;
@@ -542,6 +669,19 @@ void ToneDetector::phaseCheck(void)
       diff = 2.0f * M_PI + diff;
     }
     diff -= par->phase_offset;
+    if (par->sliding_dft)
+    {
+        // The phase of a sliding DFT moves twice as fast as the phase of a
+        // Goertzel detector that accumulates samples from the block start
+        // when the tone is off frequency. Also, only the phase differences
+        // for the last block are kept since the block is never restarted.
+      diff /= 2.0f;
+      const size_t max_diffs = par->block_len / par->period_block_len;
+      if (phase_diffs.size() >= max_diffs)
+      {
+        phase_diffs.erase(phase_diffs.begin());
+      }
+    }
     phase_diffs.push_back(diff);
   }
   prev_phase = phase;
@@ -551,6 +691,7 @@ void ToneDetector::phaseCheck(void)
 void ToneDetector::postProcess(void)
 {
   bool active = true;
+  const double passband_energy = par->passbandEnergy();
   float bw = static_cast<float>(INTERNAL_SAMPLE_RATE) / par->block_len;
   float det_bw = bw;
   float win_comp_energy = 1.0f;
@@ -563,7 +704,8 @@ void ToneDetector::postProcess(void)
   }
 
     // Calculate the magnitude for the center bin
-  const std::complex<float> res_cmplx = par->center.result();
+  const std::complex<float> res_cmplx =
+    par->result(DetectorParams::BIN_CENTER);
   float res_center = win_comp_energy * Goertzel::magnitudeSquared(res_cmplx);
 
     // Now determine if the tone is active or not. We start by checking
@@ -576,12 +718,14 @@ void ToneDetector::postProcess(void)
   {
       // Check if the center fq is above the lower fq bin by the peak threshold.
       // This is part of the "neighbour bin SNR" check.
-    float res_lower = win_comp_energy * par->lower.magnitudeSquared();
+    float res_lower = win_comp_energy *
+      par->magnitudeSquared(DetectorParams::BIN_LOWER);
     active = active && (res_center > (res_lower * par->peak_thresh));
 
       // Check if the center fq is above the upper fq bin by the peak threshold.
       // This is part of the "neighbour bin SNR" check.
-    float res_upper = win_comp_energy * par->upper.magnitudeSquared();
+    float res_upper = win_comp_energy *
+      par->magnitudeSquared(DetectorParams::BIN_UPPER);
     active = active && (res_center > (res_upper * par->peak_thresh));
   }
 
@@ -711,17 +855,15 @@ void ToneDetector::postProcess(void)
     tone_fq_est = 0.0f;
   }
 
-    // Point to the first windowing table entry
-  win = par->window_table.begin();
-
-    // Reset sample counter
+    // Reset sample counter. The sliding DFT and its phase check just keep
+    // on running.
   buf_pos = 0;
 
-  par->center.reset();
-  par->lower.reset();
-  par->upper.reset();
-  phaseCheckReset();
-  passband_energy = 0.0f;
+  if (!par->sliding_dft)
+  {
+    par->bank.reset();
+    phaseCheckReset();
+  }
 
 } /* ToneDetector::postProcess */
 
@@ -729,6 +871,7 @@ void ToneDetector::postProcess(void)
 void ToneDetector::setActivated(bool activated)
 {
   //std::cout << "### activate[" << toneFq() << "]=" << activated << std::endl;
+  DetectorParams *prev_par = par;
   is_activated = activated;
   if (activated)
   {
@@ -743,6 +886,19 @@ void ToneDetector::setActivated(bool activated)
     par = det_par;
   }
   par->overlap_buf.clear();
+  par->sdft.reset();
+  phaseCheckReset();
+
+    // Only the parameter set in use is attached to the shared analyzer so
+    // that no analysis is run for the other one
+  if ((analyzer != nullptr) && (par != prev_par))
+  {
+    if (prev_par != nullptr)
+    {
+      setupAnalysis(prev_par);
+    }
+    setupAnalysis(par);
+  }
 } /* ToneDetector::setActivated */
 
 
@@ -829,6 +985,7 @@ void ToneDetector::setOverlapLength(ToneDetector::DetectorParams* par,
     par->overlap_buf.resize(overlap);
   }
   setDelay(par, par->detect_delay_ms);
+  setupAnalysis(par);
 } /* ToneDetector::setOverlapLength */
 
 
@@ -853,14 +1010,127 @@ void ToneDetector::setBw(ToneDetector::DetectorParams* par, float bw_hz)
     }
   }
 
-  par->center.initialize(tone_fq, INTERNAL_SAMPLE_RATE);
-  par->lower.initialize(tone_fq - 2 * bw_hz, INTERNAL_SAMPLE_RATE);
-  par->upper.initialize(tone_fq + 2 * bw_hz, INTERNAL_SAMPLE_RATE);
+  if (par->bank.size() == 0)
+  {
+    par->bank.addBin(tone_fq);
+    par->bank.addBin(tone_fq - 2 * bw_hz);
+    par->bank.addBin(tone_fq + 2 * bw_hz);
+  }
+  else
+  {
+    par->bank.setFrequency(DetectorParams::BIN_CENTER, tone_fq);
+    par->bank.setFrequency(DetectorParams::BIN_LOWER, tone_fq - 2 * bw_hz);
+    par->bank.setFrequency(DetectorParams::BIN_UPPER, tone_fq + 2 * bw_hz);
+  }
+  par->bank.setWindow(par->window_table, false);
 
   setOverlapPercent(par, par->overlap_percent);
+  setupSlidingDft(par);
 } /* ToneDetector::setBw */
 
 
+void ToneDetector::setHopLength(ToneDetector::DetectorParams* par, size_t hop)
+{
+  hop = min(max(hop, static_cast<size_t>(1)), par->block_len);
+  par->overlap_percent = 100.0f * (par->block_len - hop) / par->block_len;
+  setOverlapLength(par, par->block_len - hop);
+} /* ToneDetector::setHopLength */
+
+
+void ToneDetector::setupSlidingDft(ToneDetector::DetectorParams* par)
+{
+  par->sdft.clearBins();
+  if (!par->sliding_dft)
+  {
+    par->sdft.setBlockLen(1);
+    return;
+  }
+
+    // The bins are set up in the same order as for the Goertzel bank. The
+    // lower and upper bins are only needed for the neighbour bin SNR check.
+  par->sdft.setBlockLen(par->block_len);
+  par->sdft.setWindow(par->use_windowing ? 25.0f / 46.0f : 1.0f);
+  par->sdft.addBin(tone_fq);
+  if (par->peak_thresh > 0.0f)
+  {
+    par->sdft.addBin(tone_fq - 2 * par->bw);
+    par->sdft.addBin(tone_fq + 2 * par->bw);
+  }
+} /* ToneDetector::setupSlidingDft */
+
+
+void ToneDetector::slidingDftWriteSamples(const float *buf, int len)
+{
+  const float *end = buf + len;
+  while (buf != end)
+  {
+      // The detector is evaluated for the first time when a whole block
+      // has been received and then every hop samples
+    const size_t hop =
+      max(par->block_len - par->overlap_buf_size, static_cast<size_t>(1));
+    const size_t eval_len = par->sdft.isFull() ? hop : par->block_len;
+    size_t cnt = (eval_len > buf_pos) ? eval_len - buf_pos : 0;
+    cnt = min(cnt, static_cast<size_t>(end - buf));
+    if (phase_check_left > 0)
+    {
+      cnt = min(cnt, static_cast<size_t>(phase_check_left));
+    }
+
+    par->sdft.calc(buf, cnt);
+    buf += cnt;
+    buf_pos += cnt;
+
+    if (phase_check_left > 0)
+    {
+      phase_check_left -= cnt;
+      if (phase_check_left == 0)
+      {
+        phaseCheck();
+        phase_check_left = par->period_block_len;
+      }
+    }
+
+    if (buf_pos >= eval_len)
+    {
+      postProcess();
+    }
+  }
+} /* ToneDetector::slidingDftWriteSamples */
+
+
+void ToneDetector::setupAnalysis(ToneDetector::DetectorParams* par)
+{
+  par->releaseAnalysis();
+  if ((analyzer == nullptr) || (par != this->par) || par->sliding_dft ||
+      (par->phase_mean_thresh > 0.0f))
+  {
+    return;
+  }
+
+    // The bins are added in the same order as for the Goertzel bank. The
+    // lower and upper bins are only needed for the neighbour bin SNR check.
+  par->analysis = analyzer->analysis(par->block_len,
+                                     par->block_len - par->overlap_buf_size,
+                                     par->use_windowing);
+  par->analysis_bins.push_back(par->analysis->addBin(tone_fq));
+  if (par->peak_thresh > 0.0f)
+  {
+    par->analysis_bins.push_back(
+        par->analysis->addBin(tone_fq - 2 * par->bw));
+    par->analysis_bins.push_back(
+        par->analysis->addBin(tone_fq + 2 * par->bw));
+  }
+  par->analysis_con = par->analysis->analysisDone.connect(
+      sigc::mem_fun(*this, &ToneDetector::onAnalysisDone));
+} /* ToneDetector::setupAnalysis */
+
+
+void ToneDetector::onAnalysisDone(void)
+{
+  postProcess();
+} /* ToneDetector::onAnalysisDone */
+
+
 /*
  * This file has not been truncated
  */
@@ -63,6 +63,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+class ToneAnalyzer;
 
 
 /****************************************************************************
@@ -204,6 +205,70 @@ class ToneDetector : public sigc::trackable, public Async::AudioSink
      */
     void setUndetectOverlapLength(size_t overlap);
 
+    /**
+     * @brief   Set the detection hop length
+     * @param   hop The number of samples between detector evaluations
+     *
+     * This is another way of setting the overlap. The overlap will be set to
+     * the block length minus the hop length.
+     */
+    void setDetectHopLength(size_t hop);
+
+    /**
+     * @brief   Set the undetection hop length
+     * @param   hop The number of samples between detector evaluations
+     *
+     * This is another way of setting the overlap. The overlap will be set to
+     * the block length minus the hop length.
+     */
+    void setUndetectHopLength(size_t hop);
+
+    /**
+     * @brief   Choose if a sliding DFT should be used when inactive
+     * @param   enable Set to \em true to enable or \em false to disable
+     *
+     * Normally each block is processed from the start, so with overlapping
+     * blocks each sample is processed once for each block it is part of.
+     * A high overlap then costs a lot of CPU. When the sliding DFT is
+     * enabled, the detector bins are instead updated recursively using each
+     * sample once. The detector is evaluated every hop samples, where the
+     * hop is the block length minus the overlap. The CPU usage is then
+     * about the same no matter how much overlap is used. The detection
+     * criteria are the same as for the block based detector.
+     * This function will choose if the sliding DFT should be used when the
+     * detector is in its inactive state, that is when a tone is not
+     * being detected.
+     */
+    void setDetectSlidingDft(bool enable);
+
+    /**
+     * @brief   Choose if a sliding DFT should be used when active
+     * @param   enable Set to \em true to enable or \em false to disable
+     *
+     * See setDetectSlidingDft.
+     * This function will choose if the sliding DFT should be used when the
+     * detector is in its active state, that is when a tone is being detected.
+     */
+    void setUndetectSlidingDft(bool enable);
+
+    /**
+     * @brief   Use a shared tone analyzer
+     * @param   analyzer The analyzer to use or nullptr to use none
+     *
+     * When a shared tone analyzer is used, the bins of this detector are
+     * calculated by the analyzer together with the bins of all other
+     * detectors that use the same block length, overlap and window. The
+     * samples must then be written to the analyzer instead of to this
+     * detector. Samples written to this detector are ignored for as long as
+     * the analyzer is used. The analyzer is not used in a state where the
+     * phase check or the sliding DFT is enabled. The samples must then be
+     * written to this detector as usual. The easiest way is to write the
+     * samples to both the analyzer and the detector.
+     * The analyzer must outlive the detector if the detector is
+     * reconfigured after this function has been called.
+     */
+    void setToneAnalyzer(ToneAnalyzer *analyzer);
+
     /**
      * @brief  Set the detection delay
      * @param  delay_ms The number of milliseconds to delay a detection
@@ -564,11 +629,10 @@ class ToneDetector : public sigc::trackable, public Async::AudioSink
     DetectorParams	*det_par;
     DetectorParams	*undet_par;
     DetectorParams	*par;
-    double		passband_energy;
     float               last_snr;
     float               tone_fq_est;
-
-    std::vector<float>::const_iterator win;
+    std::vector<float>  replay_buf;
+    ToneAnalyzer*       analyzer;
 
     void phaseCheckReset(void);
     void phaseCheck(void);
@@ -581,6 +645,11 @@ class ToneDetector : public sigc::trackable, public Async::AudioSink
     void setOverlapPercent(DetectorParams* par, float overlap_percent);
     void setOverlapLength(ToneDetector::DetectorParams* par, size_t overlap);
     void setBw(DetectorParams* par, float bw_hz);
+    void setHopLength(DetectorParams* par, size_t hop);
+    void setupSlidingDft(DetectorParams* par);
+    void slidingDftWriteSamples(const float *buf, int len);
+    void setupAnalysis(DetectorParams* par);
+    void onAnalysisDone(void);
 
 };  /* class ToneDetector */
 
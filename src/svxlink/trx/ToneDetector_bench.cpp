@@ -0,0 +1,139 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+#include "ToneDetector.h"
+
+using namespace std;
+
+
+/*
+ * Tone detector benchmark
+ *
+ * Usage: ToneDetector_bench [seconds of audio]
+ *
+ * A CTCSS tone detector, set up like in CTCSS_MODE 4, and a 1750Hz tone burst
+ * detector, set up like the tone detectors added by LocalRxBase, are run with
+ * different amount of block overlap. Each detector is run both with
+ * overlapping blocks and with the sliding DFT. The number of detections must
+ * be the same for both. The result is given as CPU time per second of audio
+ * together with the resulting detection delay.
+ */
+
+namespace {
+  const int SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
+  const int BLOCK_SIZE = SAMPLE_RATE / 100;
+  const float overlaps[] = { 0.0f, 75.0f, 87.5f, 93.75f };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  ToneDetector *createCtcss(float overlap)
+  {
+    ToneDetector *det = new ToneDetector(136.5f, 8.0f);
+    det->setDetectBw(16.0f);
+    det->setDetectOverlapPercent(overlap);
+    det->setDetectDelay(100);
+    det->setDetectToneFrequencyTolerancePercent(0.75f);
+    det->setDetectUseWindowing(false);
+    det->setDetectPeakThresh(0.0f);
+    det->setDetectSnrThresh(15.0f, 200.0f);
+    det->setUndetectBw(8.0f);
+    det->setUndetectOverlapPercent(overlap);
+    det->setUndetectDelay(100);
+    det->setUndetectUseWindowing(false);
+    det->setUndetectPeakThresh(0.0f);
+    det->setUndetectSnrThresh(10.0f, 200.0f);
+    return det;
+  }
+
+  ToneDetector *createToneBurst(float overlap)
+  {
+    ToneDetector *det = new ToneDetector(1750.0f, 50.0f, 100);
+    det->setPeakThresh(10.0f);
+    det->setDetectOverlapPercent(overlap);
+    det->setDetectToneFrequencyTolerancePercent(50.0f * 25.0f / 1750.0f);
+    return det;
+  }
+
+  vector<float> makeSignal(float fq, int len)
+  {
+    mt19937 rng(4711);
+    normal_distribution<float> noise(0.0f, 0.01f);
+    vector<float> sig(len);
+    for (int n=0; n<len; ++n)
+    {
+        // The tone is on for two seconds and then off for one second
+      const bool on = (n / SAMPLE_RATE) % 3 != 0;
+      sig[n] = noise(rng) + (on ? 0.1f * sinf(2.0f * M_PI * fq * n /
+                                              SAMPLE_RATE) : 0.0f);
+    }
+    return sig;
+  }
+
+  void run(const char *name, ToneDetector *(*create)(float), float fq,
+           double seconds)
+  {
+    const vector<float> sig = makeSignal(fq, SAMPLE_RATE * 30);
+    const int blocks = seconds * SAMPLE_RATE / BLOCK_SIZE;
+    const int sig_blocks = sig.size() / BLOCK_SIZE;
+    for (float overlap : overlaps)
+    {
+      double t[2];
+      int detections[2];
+      int hop = 0;
+      for (int sliding=0; sliding<2; ++sliding)
+      {
+        unique_ptr<ToneDetector> det(create(overlap));
+        det->setDetectSlidingDft(sliding);
+        det->setUndetectSlidingDft(sliding);
+        int cnt = 0;
+        det->activated.connect([&](bool active) { cnt += active ? 1 : 0; });
+        const double start = cpuTime();
+        for (int i=0; i<blocks; ++i)
+        {
+          det->writeSamples(&sig[(i % sig_blocks) * BLOCK_SIZE], BLOCK_SIZE);
+        }
+        t[sliding] = cpuTime() - start;
+        detections[sliding] = cnt;
+        hop = det->detectDelay();
+      }
+      cout << setw(12) << name << setw(8) << setprecision(2) << overlap << "%"
+           << setw(10) << setprecision(3) << (1e3 * t[0] / seconds)
+           << setw(10) << (1e3 * t[1] / seconds)
+           << setw(10) << detections[0] << setw(6) << detections[1]
+           << setw(8) << hop
+           << (detections[0] == detections[1] ? "" : "  MISMATCH") << endl;
+    }
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  double seconds = 60.0;
+  if (argc > 1)
+  {
+    seconds = atof(argv[1]);
+  }
+
+  cout << setw(12) << "detector" << setw(9) << "overlap"
+       << setw(10) << "block" << setw(10) << "sliding"
+       << setw(16) << "detections" << setw(8) << "delay"
+       << "  (CPU ms per second of audio, detect delay in ms)" << endl;
+  cout << fixed;
+  run("CTCSS", createCtcss, 136.5f, seconds);
+  run("1750Hz", createToneBurst, 1750.0f, seconds);
+
+  return 0;
+}
@@ -67,6 +67,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "Voter.h"
+#include "VoterAlignBuffer.h"
+#include "VoterCombiner.h"
 
 
 
@@ -106,13 +108,18 @@ using namespace Async;
  * its "subscribers".
  * When the receiver close its squelch, the squelch signal is delayed until
  * all audio has been flushed.
+ * When time alignment is enabled, a VoterAlignBuffer is used instead of the
+ * FIFO. It also delay the audio so that it line up with the audio from the
+ * other satellite receivers.
  */
 class Voter::SatRx : public AudioSource, public sigc::trackable
 {
   public:
-    SatRx(Config &cfg, const string &rx_name, int id, int fifo_length_ms)
-      : rx_id(id), rx(0), fifo(0), sql_open(false), enabled(true),
-        mute_state(Rx::MUTE_ALL), sql_open_delay(0)
+    SatRx(Config &cfg, const string &rx_name, int id, int fifo_length_ms,
+          bool time_align, unsigned max_align_delay_ms)
+      : rx_id(id), rx(0), fifo(0), align_buf(0), sql_open(false),
+        enabled(true), mute_state(Rx::MUTE_ALL), sql_open_delay(0),
+        rx_latency(0.0f), rx_latency_valid(false), latency_misses(0)
     {
       rx = RxFactory::createNamedRx(cfg, rx_name);
       if (rx != 0)
@@ -133,7 +140,17 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
 
 	AudioSource *prev_src = rx;
 
-	if (fifo_length_ms > 0)
+	if (time_align)
+	{
+	  const unsigned len = fifo_length_ms + max_align_delay_ms;
+	  align_buf = new VoterAlignBuffer(len * INTERNAL_SAMPLE_RATE / 1000);
+	  align_buf->setHistoryLength(
+	      fifo_length_ms * INTERNAL_SAMPLE_RATE / 1000);
+	  prev_src->registerSink(align_buf);
+	  prev_src = align_buf;
+	  valve.setBlockWhenClosed(true);
+	}
+	else if (fifo_length_ms > 0)
 	{
 	  fifo = new AudioFifo(fifo_length_ms * INTERNAL_SAMPLE_RATE / 1000);
 	  fifo->setOverwrite(true);
@@ -156,6 +173,7 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     ~SatRx(void)
     {
       delete fifo;
+      delete align_buf;
       rx->reset();
       delete rx;
     }
@@ -222,7 +240,15 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     
     void stopOutput(bool do_stop)
     {
+      if ((align_buf != 0) && !do_stop)
+      {
+        align_buf->setOpen(true);
+      }
       valve.setOpen(!do_stop);
+      if ((align_buf != 0) && do_stop)
+      {
+        align_buf->setOpen(false);
+      }
       if (!do_stop)
       {
         if (tone_detected >= 0.0f)
@@ -255,6 +281,30 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     }
     unsigned sqlOpenDelay(void) const { return sql_open_delay; }
 
+    unsigned index(void) const { return rx_id - 1; }
+
+    VoterAlignBuffer *alignBuffer(void) { return align_buf; }
+
+    void openAlignedTo(SatRx *srx, unsigned crossfade_len)
+    {
+      if ((align_buf != 0) && (srx->align_buf != 0))
+      {
+        align_buf->openAlignedTo(*srx->align_buf, crossfade_len);
+      }
+    }
+
+      // The latency, in samples, relative to the other satellite receivers
+    bool latencyIsValid(void) const { return rx_latency_valid; }
+    float latency(void) const { return rx_latency; }
+    unsigned latencyMisses(void) const { return latency_misses; }
+    void setLatency(float new_latency)
+    {
+      rx_latency = new_latency;
+      rx_latency_valid = true;
+      latency_misses = 0;
+    }
+    void latencyMissed(void) { latency_misses += 1; }
+
     sigc::signal<void(char, int)>     dtmfDigitDetected;
     sigc::signal<void(string)>        selcallSequenceDetected;
     sigc::signal<void(bool, SatRx*)>  squelchOpen;
@@ -276,6 +326,7 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     int		  rx_id;
     Rx		  *rx;
     AudioFifo 	  *fifo;
+    VoterAlignBuffer *align_buf;
     AudioValve	  valve;
     DtmfBuf   	  dtmf_buf;
     SelcallBuf	  selcall_buf;
@@ -284,6 +335,9 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     Rx::MuteState mute_state;
     unsigned      sql_open_delay;
     float         tone_detected   {-1.0};
+    float         rx_latency;
+    bool          rx_latency_valid;
+    unsigned      latency_misses;
     
     void onDtmfDigitDetected(char digit, int duration)
     {
@@ -329,7 +383,14 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
       }
       else
       {
-      	if ((fifo == 0) || fifo->empty())
+	if ((align_buf != 0) && !align_buf->isOpen())
+	{
+	    // Audio that is not going to be played is of no use
+	  align_buf->clear();
+	  setSquelchOpen(false);
+	}
+	else if (((fifo == 0) || fifo->empty()) &&
+	         ((align_buf == 0) || align_buf->empty()))
 	{
 	  setSquelchOpen(false);
 	}
@@ -362,6 +423,10 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
         {
           fifo->clear();
         }
+        if (align_buf != 0)
+        {
+          align_buf->clear();
+        }
         dtmf_buf.clear();
         selcall_buf.clear();
         tone_detected = -1.0f;
@@ -403,17 +468,24 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
  ****************************************************************************/
 
 Voter::Voter(Config &cfg, const std::string& name)
-  : Rx(cfg, name), cfg(cfg), m_verbose(true), selector(0),
+  : Rx(cfg, name), cfg(cfg), m_verbose(true), selector(0), m_combiner(0),
     sm(Macho::State<Top>(this)), is_processing_event(false), command_pty(0),
-    m_print_sat_squelch(false)
+    m_print_sat_squelch(false), m_time_align(false),
+    m_max_align_delay(DEFAULT_MAX_ALIGN_DELAY),
+    m_crossfade_len(DEFAULT_CROSSFADE_TIME * INTERNAL_SAMPLE_RATE / 1000),
+    m_align_timer(0)
 {
 } /* Voter::Voter */
 
 
 Voter::~Voter(void)
 {
+  delete m_align_timer;
+  m_align_timer = 0;
   delete command_pty;
   command_pty = 0;
+  delete m_combiner;
+  m_combiner = 0;
   delete selector;
   selector = 0;
   
@@ -536,8 +608,51 @@ bool Voter::initialize(void)
 
   cfg.getValue(name(), "VERBOSE", m_print_sat_squelch);
 
+  cfg.getValue(name(), "TIME_ALIGN", m_time_align);
+  bool combine = false;
+  cfg.getValue(name(), "COMBINE", combine);
+  if (combine)
+  {
+      // The audio must be time aligned to be combined
+    m_time_align = true;
+  }
+  cfg.getValue(name(), "MAX_ALIGN_DELAY", m_max_align_delay);
+  if (m_max_align_delay > MAX_ALIGN_DELAY)
+  {
+    cerr << "*** ERROR: Config variable " << name()
+         << "/MAX_ALIGN_DELAY out of range ("
+	 << m_max_align_delay << "). Valid range is 0 to "
+	 << MAX_ALIGN_DELAY << ".\n";
+    return false;
+  }
+  unsigned crossfade_time = DEFAULT_CROSSFADE_TIME;
+  cfg.getValue(name(), "CROSSFADE_TIME", crossfade_time);
+  if (crossfade_time > MAX_CROSSFADE_TIME)
+  {
+    cerr << "*** ERROR: Config variable " << name()
+         << "/CROSSFADE_TIME out of range ("
+	 << crossfade_time << "). Valid range is 0 to "
+	 << MAX_CROSSFADE_TIME << ".\n";
+    return false;
+  }
+  m_crossfade_len = crossfade_time * INTERNAL_SAMPLE_RATE / 1000;
+  if (m_time_align)
+  {
+    m_align_timer = new Timer(ALIGN_INTERVAL, Timer::TYPE_PERIODIC);
+    m_align_timer->expired.connect(mem_fun(*this, &Voter::updateAlignment));
+  }
+
   selector = new AudioSelector;
-  setHandler(selector);
+  if (combine)
+  {
+    m_combiner = new VoterCombiner;
+    selector->registerSink(m_combiner);
+    setHandler(m_combiner);
+  }
+  else
+  {
+    setHandler(selector);
+  }
   
   string::iterator start(receivers.begin());
   for (;;)
@@ -560,7 +675,8 @@ bool Voter::initialize(void)
     if (!rx_name.empty())
     {
       cout << "\tAdding receiver: " << rx_name << endl;
-      SatRx *srx = new SatRx(cfg, rx_name, rxs.size() + 1, buffer_length);
+      SatRx *srx = new SatRx(cfg, rx_name, rxs.size() + 1, buffer_length,
+                             m_time_align, m_max_align_delay);
       srx->setSqlOpenDelay(sql_open_delay);
       srx->squelchOpen.connect(mem_fun(*this, &Voter::satSquelchOpen));
       srx->signalLevelUpdated.connect(
@@ -576,6 +692,10 @@ bool Voter::initialize(void)
       srx->toneDetected.connect(toneDetected.make_slot());
       selector->addSource(srx);
       selector->enableAutoSelect(srx, 0);
+      if (m_combiner != 0)
+      {
+        m_combiner->addInput(srx->alignBuffer());
+      }
       
       rxs.push_back(srx);
     }
@@ -666,6 +786,7 @@ void Voter::dispatchEvent(Macho::IEvent<Top> *event)
     }
     event_queue.clear();
     is_processing_event = false;
+    updateCombiner();
   }
   else
   {
@@ -788,6 +909,115 @@ Voter::SatRx *Voter::findBestRx(void) const
 } /* Voter::findBestRx */
 
 
+void Voter::updateAlignment(Timer *t)
+{
+    // Estimate the latency of each satellite receiver relative to the
+    // active receiver, or to the best one if none is active yet
+  SatRx *ref_srx = sm->activeSrx();
+  if ((ref_srx == 0) || !ref_srx->squelchIsOpen())
+  {
+    ref_srx = findBestRx();
+  }
+  if (ref_srx == 0)
+  {
+    return;
+  }
+  if (!ref_srx->latencyIsValid())
+  {
+    ref_srx->setLatency(0.0f);
+  }
+
+  const int max_align = m_max_align_delay * INTERNAL_SAMPLE_RATE / 1000;
+  for (const auto& srx : rxs)
+  {
+    if ((srx == ref_srx) || !srx->isEnabled() || !srx->squelchIsOpen())
+    {
+      continue;
+    }
+
+      // Search close to the last estimate if there is one. Search the full
+      // range if there is none or if it has not been seen for a while.
+    int expected = 0;
+    int max_dev = max_align;
+    if (srx->latencyIsValid() &&
+        (srx->latencyMisses() < MAX_LATENCY_MISSES))
+    {
+      expected = static_cast<int>(roundf(srx->latency() -
+                                         ref_srx->latency()));
+      max_dev = LATENCY_SEARCH_RANGE * INTERNAL_SAMPLE_RATE / 1000;
+    }
+    int lag = 0;
+    float quality = 0.0f;
+    if (VoterAlignBuffer::estimateLag(*ref_srx->alignBuffer(),
+                                      *srx->alignBuffer(),
+                                      expected, max_dev, lag, quality))
+    {
+      float latency = ref_srx->latency() + lag;
+      if (srx->latencyIsValid() &&
+          (srx->latencyMisses() < MAX_LATENCY_MISSES))
+      {
+        latency = srx->latency() +
+                  LATENCY_AVG_FACTOR * (latency - srx->latency());
+      }
+      srx->setLatency(latency);
+    }
+    else
+    {
+      srx->latencyMissed();
+    }
+  }
+
+    // Delay each receiver so that it line up with the receiver with the
+    // highest latency among the receivers that are receiving a signal right
+    // now. The crossfade need some extra audio to work with.
+  bool found = false;
+  float max_latency = 0.0f;
+  for (const auto& srx : rxs)
+  {
+    if (srx->isEnabled() && srx->squelchIsOpen() && srx->latencyIsValid() &&
+        (!found || (srx->latency() > max_latency)))
+    {
+      max_latency = srx->latency();
+      found = true;
+    }
+  }
+  for (const auto& srx : rxs)
+  {
+    if (srx->isEnabled() && srx->squelchIsOpen() && srx->latencyIsValid())
+    {
+      const int delay = static_cast<int>(
+          roundf(max_latency - srx->latency())) + m_crossfade_len;
+      srx->alignBuffer()->setTargetDelay(min(delay, max_align));
+    }
+  }
+
+  updateCombiner();
+} /* Voter::updateAlignment */
+
+
+void Voter::updateCombiner(void)
+{
+  if (m_combiner == 0)
+  {
+    return;
+  }
+
+    // The audio from the active receiver pass through the selector so it
+    // is the one that the audio from the other receivers is mixed into
+  SatRx *active_srx = sm->activeSrx();
+  m_combiner->setMaster((active_srx != 0) ? active_srx->index() : -1);
+  for (const auto& srx : rxs)
+  {
+    const unsigned input = srx->index();
+    m_combiner->setInputActive(input, srx->isEnabled() &&
+                                      srx->squelchIsOpen() &&
+                                      srx->latencyIsValid());
+    m_combiner->setLatency(input, srx->latency());
+    m_combiner->setSignalLevel(input, srx->signalStrength());
+  }
+} /* Voter::updateCombiner */
+
+
 
 /****************************************************************************
  *
@@ -886,6 +1116,18 @@ void Voter::Top::satSignalLevelUpdated(SatRx *srx, float siglev)
 } /* Voter::Top::satSignalLevelUpdated */
 
 
+Rx::MuteState Voter::Top::inactiveMuteState(void)
+{
+    // When time aligning, the audio from the inactive receivers is needed to
+    // estimate the latency and to be able to switch receiver seamlessly
+  if (voter().m_time_align && (muteState() == Rx::MUTE_NONE))
+  {
+    return Rx::MUTE_NONE;
+  }
+  return Rx::MUTE_CONTENT;
+} /* Voter::Top::inactiveMuteState */
+
+
 void Voter::Top::runTask(sigc::slot<void()> task)
 {
   Async::Application::app().runTask(task);
@@ -1057,7 +1299,7 @@ void Voter::ActiveRxSelected::init(SatRx *srx)
   }
   else
   {
-    voter().muteAllBut(srx, MUTE_CONTENT);
+    voter().muteAllBut(srx, inactiveMuteState());
   }
   setState<SquelchOpen>();
 } /* Voter::ActiveRxSelected::init */
@@ -1078,6 +1320,10 @@ void Voter::ActiveRxSelected::setMuteState(Rx::MuteState new_mute_state)
   }
   activeSrx()->setMuteState(MUTE_NONE);
   TOP::box().mute_state = Rx::MUTE_NONE;
+  if (inactiveMuteState() == Rx::MUTE_NONE)
+  {
+    voter().unmuteAll();
+  }
 } /* Voter::ActiveRxSelected::setMuteState */
 
 
@@ -1089,8 +1335,11 @@ char Voter::ActiveRxSelected::sqlRxId(void)
 
 void Voter::ActiveRxSelected::changeActiveSrx(SatRx *srx)
 {
+    // The new receiver must continue where the old one is before the old
+    // one is muted
+  srx->openAlignedTo(activeSrx(), voter().m_crossfade_len);
   voter().selector->selectSource(srx);
-  activeSrx()->setMuteState(MUTE_CONTENT);
+  activeSrx()->setMuteState(inactiveMuteState());
   box().active_srx = srx;
   if (muteState() == Rx::MUTE_NONE)
   {
@@ -1288,7 +1537,7 @@ void Voter::SwitchActiveRx::exit(void)
   //cout << "### SwitchActiveRx::exit\n";
   if (box().switch_to_srx != 0)
   {
-    box().switch_to_srx->setMuteState(MUTE_CONTENT);
+    box().switch_to_srx->setMuteState(inactiveMuteState());
   }
 
   stopTimer();
@@ -1305,6 +1554,10 @@ void Voter::SwitchActiveRx::setMuteState(Rx::MuteState new_mute_state)
   activeSrx()->setMuteState(MUTE_NONE);
   box().switch_to_srx->setMuteState(MUTE_NONE);
   TOP::box().mute_state = Rx::MUTE_NONE;
+  if (inactiveMuteState() == Rx::MUTE_NONE)
+  {
+    voter().unmuteAll();
+  }
 } /* Voter::SwitchActiveRx::setMuteState */
 
 
@@ -71,6 +71,8 @@ namespace Async
   class Pty;
 };
 
+class VoterCombiner;
+
 
 /****************************************************************************
  *
@@ -197,6 +199,8 @@ class Voter : public Rx
     static CONSTEXPR unsigned DEFAULT_SQL_CLOSE_REVOTE_DELAY = 500;
     static CONSTEXPR unsigned DEFAULT_REVOTE_INTERVAL        = 1000;
     static CONSTEXPR unsigned DEFAULT_RX_SWITCH_DELAY        = 500;
+    static CONSTEXPR unsigned DEFAULT_MAX_ALIGN_DELAY        = 500;
+    static CONSTEXPR unsigned DEFAULT_CROSSFADE_TIME         = 0;
     
     static CONSTEXPR unsigned MAX_VOTING_DELAY               = 5000;
     static CONSTEXPR unsigned MAX_BUFFER_LENGTH              = MAX_VOTING_DELAY;
@@ -205,6 +209,12 @@ class Voter : public Rx
     static CONSTEXPR unsigned MIN_REVOTE_INTERVAL            = 100;
     static CONSTEXPR unsigned MAX_REVOTE_INTERVAL            = 60000;
     static CONSTEXPR unsigned MAX_RX_SWITCH_DELAY            = 3000;
+    static CONSTEXPR unsigned MAX_ALIGN_DELAY                = 1000;
+    static CONSTEXPR unsigned MAX_CROSSFADE_TIME             = 100;
+    static CONSTEXPR unsigned ALIGN_INTERVAL                 = 250;
+    static CONSTEXPR unsigned LATENCY_SEARCH_RANGE           = 50;
+    static CONSTEXPR unsigned MAX_LATENCY_MISSES             = 8;
+    static CONSTEXPR float    LATENCY_AVG_FACTOR             = 0.3f;
 
     class SatRx;
 
@@ -261,6 +271,7 @@ class Voter : public Rx
       }
       unsigned revoteInterval(void) { return box().revote_interval; }
       Rx::MuteState muteState(void) const { return box().mute_state; }
+      Rx::MuteState inactiveMuteState(void);
 
 	// Machine's event protocol
       virtual void timerExpired(void) { }
@@ -413,12 +424,17 @@ class Voter : public Rx
     std::list<SatRx *>	  rxs;
     bool	      	  m_verbose;
     Async::AudioSelector  *selector;
+    VoterCombiner         *m_combiner;
     Macho::Machine<Top>   sm;
     bool		  is_processing_event;
     EventQueue		  event_queue;
     Async::Pty            *command_pty;
     std::string           command_buf;
     bool                  m_print_sat_squelch;
+    bool                  m_time_align;
+    unsigned              m_max_align_delay;
+    unsigned              m_crossfade_len;
+    Async::Timer          *m_align_timer;
 
     void dispatchEvent(Macho::IEvent<Top> *event);
     void satSquelchOpen(bool is_open, SatRx *rx);
@@ -429,6 +445,8 @@ class Voter : public Rx
     void resetAll(void);
     void publishSquelchState(void);
     SatRx *findBestRx(void) const;
+    void updateAlignment(Async::Timer *t);
+    void updateCombiner(void);
     void onCommandPtyInput(const void *buf, size_t count);
     void handlePtyCommand(const std::string &full_command);
     void setRxEnabled(const std::string &rx_name,
@@ -0,0 +1,607 @@
+/**
+@file   VoterAlignBuffer.cpp
+@brief  A delay buffer used to time align the audio from voter satellites
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "VoterAlignBuffer.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+namespace {
+  const int64_t NO_TIME = numeric_limits<int64_t>::min();
+
+    // The audio is silent if its energy is this much below the average
+  const float SILENCE_RATIO = 0.1f;
+
+    // The lowest energy per sample that is not considered silence
+  const float MIN_ENERGY = 1.0e-8f;
+
+    // The averaging time of the audio energy, in samples
+  const float ENERGY_AVG_LEN = INTERNAL_SAMPLE_RATE;
+
+    // The lowest normalized correlation that give a trusted lag estimate
+  const float MIN_QUALITY = 0.5f;
+
+  int64_t floorDiv(int64_t a, int64_t b)
+  {
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+  }
+};
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool VoterAlignBuffer::estimateLag(const VoterAlignBuffer &ref,
+                                   const VoterAlignBuffer &other,
+                                   int expected, int max_dev, int &lag,
+                                   float &quality)
+{
+  if ((ref.m_hist_end == NO_TIME) || (other.m_hist_end == NO_TIME))
+  {
+    return false;
+  }
+
+  const int dec = HISTORY_DECIMATION;
+  const int max_lag = MAX_LAG / dec;
+  const int center = (expected >= 0) ? (expected + dec / 2) / dec
+                                     : -((-expected + dec / 2) / dec);
+  const int dev = (max_dev + dec - 1) / dec;
+  const int lo = max(center - dev, -max_lag);
+  const int hi = min(center + dev, max_lag);
+  if (hi - lo < 2)
+  {
+    return false;
+  }
+
+    // The window must be inside the history of the reference buffer and the
+    // lagged window must be inside the history of the other buffer for all
+    // lags searched
+  const int win = LAG_WINDOW / dec;
+  const int64_t t_end = min(ref.m_hist_end, other.m_hist_end - hi);
+  const int64_t t_start = t_end - win;
+  if ((t_start < ref.m_hist_end - HISTORY_TICKS) ||
+      (t_start + lo < other.m_hist_end - HISTORY_TICKS))
+  {
+    return false;
+  }
+
+  vector<float> r(win);
+  float r_energy = 0.0f;
+  for (int i=0; i<win; ++i)
+  {
+    r[i] = ref.history(t_start + i);
+    r_energy += r[i] * r[i];
+  }
+  if (r_energy < win * MIN_ENERGY)
+  {
+    return false;
+  }
+
+  const int lags = hi - lo + 1;
+  vector<float> o(win + lags - 1);
+  for (size_t i=0; i<o.size(); ++i)
+  {
+    o[i] = other.history(t_start + lo + i);
+  }
+
+  vector<float> corr(lags);
+  float o_energy = 0.0f;
+  for (int i=0; i<win; ++i)
+  {
+    o_energy += o[i] * o[i];
+  }
+  int best = -1;
+  for (int j=0; j<lags; ++j)
+  {
+    if (j > 0)
+    {
+      o_energy += o[j + win - 1] * o[j + win - 1] - o[j - 1] * o[j - 1];
+      o_energy = max(o_energy, 0.0f);
+    }
+    const float *op = &o[j];
+    float c = 0.0f;
+    for (int i=0; i<win; ++i)
+    {
+      c += r[i] * op[i];
+    }
+    corr[j] = c / sqrtf(r_energy * o_energy + 1.0e-20f);
+    if ((best < 0) || (corr[j] > corr[best]))
+    {
+      best = j;
+    }
+  }
+
+    // A peak at the edge of the search range probably mean that the real lag
+    // is outside of the range
+  quality = corr[best];
+  if ((best == 0) || (best == lags - 1) || (quality < MIN_QUALITY))
+  {
+    return false;
+  }
+
+    // Interpolate between the decimated lags using a parabola through the
+    // peak and its neighbours
+  const float a = corr[best - 1];
+  const float b = corr[best];
+  const float c = corr[best + 1];
+  float frac = 0.0f;
+  if (a - 2.0f * b + c < 0.0f)
+  {
+    frac = 0.5f * (a - c) / (a - 2.0f * b + c);
+  }
+  lag = lroundf((lo + best + frac) * dec);
+  return true;
+} /* VoterAlignBuffer::estimateLag */
+
+
+VoterAlignBuffer::VoterAlignBuffer(unsigned capacity)
+  : m_buf(max(capacity, 1U)), m_head(0), m_level(0), m_due(0), m_target(0),
+    m_history_len(capacity), m_is_open(false), m_is_flushing(false),
+    m_output_stopped(false), m_avg_energy(0.0f), m_next_time(NO_TIME),
+    m_hist(HISTORY_TICKS), m_hist_end(NO_TIME), m_acc_tick(NO_TIME),
+    m_acc(0.0f)
+{
+} /* VoterAlignBuffer::VoterAlignBuffer */
+
+
+VoterAlignBuffer::~VoterAlignBuffer(void)
+{
+} /* VoterAlignBuffer::~VoterAlignBuffer */
+
+
+void VoterAlignBuffer::setTargetDelay(unsigned delay)
+{
+  m_target = min(delay, static_cast<unsigned>(m_buf.size()));
+} /* VoterAlignBuffer::setTargetDelay */
+
+
+void VoterAlignBuffer::setOpen(bool is_open)
+{
+  if (is_open == m_is_open)
+  {
+    return;
+  }
+
+  if (is_open)
+  {
+      // Keep the configured history plus the alignment delay
+    if (m_level > m_history_len + m_target)
+    {
+      drop(m_level - m_history_len - m_target);
+    }
+    open();
+  }
+  else
+  {
+    m_is_open = false;
+    m_due = 0;
+    if (m_is_flushing)
+    {
+      m_head = m_level = 0;
+      sinkFlushSamples();
+    }
+  }
+} /* VoterAlignBuffer::setOpen */
+
+
+void VoterAlignBuffer::openAlignedTo(const VoterAlignBuffer &other,
+                                     unsigned crossfade_len)
+{
+  if (m_is_open)
+  {
+    return;
+  }
+
+    // The next sample played by the other buffer arrived other.m_level
+    // samples ago. Our sample from the same point in time arrived the
+    // difference in target delay later.
+  const int keep = static_cast<int>(other.m_level) -
+                   static_cast<int>(other.m_target) +
+                   static_cast<int>(m_target);
+  if (keep < static_cast<int>(m_level))
+  {
+    drop(m_level - max(keep, 0));
+  }
+
+  const unsigned len = min(crossfade_len, min(m_level, other.m_level));
+  for (unsigned i=0; i<len; ++i)
+  {
+    const float gain = (i + 0.5f) / len;
+    at(i) = gain * at(i) + (1.0f - gain) * other.at(i);
+  }
+
+  open();
+} /* VoterAlignBuffer::openAlignedTo */
+
+
+bool VoterAlignBuffer::copySamples(int64_t t, float *dest,
+                                   unsigned count) const
+{
+  if ((m_next_time == NO_TIME) || (t < headTime()) ||
+      (t + count > m_next_time))
+  {
+    return false;
+  }
+  const unsigned pos = t - headTime();
+  for (unsigned i=0; i<count; ++i)
+  {
+    dest[i] = at(pos + i);
+  }
+  return true;
+} /* VoterAlignBuffer::copySamples */
+
+
+void VoterAlignBuffer::clear(void)
+{
+  const bool was_empty = empty();
+  m_head = m_level = m_due = 0;
+  if (m_is_flushing && !was_empty)
+  {
+    sinkFlushSamples();
+  }
+} /* VoterAlignBuffer::clear */
+
+
+int VoterAlignBuffer::writeSamples(const float *samples, int count)
+{
+  writeToHistory(samples, count);
+  m_is_flushing = false;
+
+  float energy = 0.0f;
+  const unsigned size = m_buf.size();
+  for (int i=0; i<count; ++i)
+  {
+    energy += samples[i] * samples[i];
+    if (m_level == size)
+    {
+      m_head = (m_head + 1) % size;
+      m_level -= 1;
+      m_due -= (m_due > 0) ? 1 : 0;
+    }
+    m_buf[(m_head + m_level) % size] = samples[i];
+    m_level += 1;
+  }
+  const float alpha = count / (count + ENERGY_AVG_LEN);
+  m_avg_energy += alpha * (energy / count - m_avg_energy);
+
+  if (m_is_open)
+  {
+    m_due = min(m_due + count, m_level);
+    adjustDelay(count);
+    writeDueSamples();
+  }
+
+  return count;
+} /* VoterAlignBuffer::writeSamples */
+
+
+void VoterAlignBuffer::flushSamples(void)
+{
+  m_is_flushing = true;
+  if (!m_is_open)
+  {
+      // Nobody is listening so the buffered audio is of no use
+    m_head = m_level = m_due = 0;
+    sinkFlushSamples();
+    return;
+  }
+
+  m_due = m_level;
+  if (empty())
+  {
+    sinkFlushSamples();
+  }
+  else
+  {
+    writeDueSamples();
+  }
+} /* VoterAlignBuffer::flushSamples */
+
+
+void VoterAlignBuffer::resumeOutput(void)
+{
+  m_output_stopped = false;
+  writeDueSamples();
+} /* VoterAlignBuffer::resumeOutput */
+
+
+void VoterAlignBuffer::allSamplesFlushed(void)
+{
+  if (m_is_flushing && empty())
+  {
+    m_is_flushing = false;
+    sourceAllSamplesFlushed();
+  }
+} /* VoterAlignBuffer::allSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+int64_t VoterAlignBuffer::now(void) const
+{
+  if (!m_time_source.empty())
+  {
+    return m_time_source();
+  }
+  const auto t = chrono::steady_clock::now().time_since_epoch();
+  return chrono::duration_cast<chrono::microseconds>(t).count() *
+         INTERNAL_SAMPLE_RATE / 1000000;
+} /* VoterAlignBuffer::now */
+
+
+void VoterAlignBuffer::drop(unsigned count)
+{
+  count = min(count, m_level);
+  m_head = (m_head + count) % m_buf.size();
+  m_level -= count;
+  m_due = min(m_due, m_level);
+} /* VoterAlignBuffer::drop */
+
+
+bool VoterAlignBuffer::isSilent(unsigned count) const
+{
+  count = min(count, m_level);
+  if (count == 0)
+  {
+    return true;
+  }
+  float energy = 0.0f;
+  for (unsigned i=0; i<count; ++i)
+  {
+    energy += at(i) * at(i);
+  }
+  energy /= count;
+  return (energy < MIN_ENERGY) || (energy < SILENCE_RATIO * m_avg_energy);
+} /* VoterAlignBuffer::isSilent */
+
+
+void VoterAlignBuffer::adjustDelay(unsigned count)
+{
+  const int diff = static_cast<int>(m_level - m_due) -
+                   static_cast<int>(m_target);
+  if ((abs(diff) <= static_cast<int>(TOLERANCE)) || !isSilent(m_due))
+  {
+    return;
+  }
+
+  if (diff > 0)
+  {
+      // Skip silent samples to catch up, at most doubling the speed
+    const unsigned skip = min(static_cast<unsigned>(diff), count);
+    const unsigned due = m_due;
+    drop(skip);
+    m_due = min(due, m_level);
+  }
+  else
+  {
+      // Hold back silent samples to build up the delay
+    m_due -= min(static_cast<unsigned>(-diff), m_due);
+  }
+} /* VoterAlignBuffer::adjustDelay */
+
+
+void VoterAlignBuffer::open(void)
+{
+  m_is_open = true;
+  m_due = m_is_flushing ? m_level : 0;
+  m_output_stopped = false;
+  if (m_is_flushing && empty())
+  {
+    sinkFlushSamples();
+  }
+  else
+  {
+    writeDueSamples();
+  }
+} /* VoterAlignBuffer::open */
+
+
+void VoterAlignBuffer::writeToHistory(const float *samples, int count)
+{
+    // The samples are assumed to have arrived at an even pace, the last one
+    // just now, but never before the samples written before them
+  const int64_t t_now = now();
+  int64_t t = t_now - count;
+  if ((m_next_time != NO_TIME) && (t < m_next_time))
+  {
+    t = m_next_time;
+  }
+  m_next_time = t + count;
+
+  for (int i=0; i<count; ++i, ++t)
+  {
+    const int64_t tick = floorDiv(t, HISTORY_DECIMATION);
+    if (tick != m_acc_tick)
+    {
+      commitHistoryTick();
+      m_acc_tick = tick;
+      m_acc = 0.0f;
+    }
+    m_acc += samples[i];
+  }
+} /* VoterAlignBuffer::writeToHistory */
+
+
+void VoterAlignBuffer::commitHistoryTick(void)
+{
+  if (m_acc_tick == NO_TIME)
+  {
+    return;
+  }
+  if ((m_hist_end == NO_TIME) || (m_acc_tick - m_hist_end >= HISTORY_TICKS))
+  {
+    fill(m_hist.begin(), m_hist.end(), 0.0f);
+  }
+  else
+  {
+    for (int64_t tick=m_hist_end; tick<m_acc_tick; ++tick)
+    {
+      m_hist[histIndex(tick)] = 0.0f;
+    }
+  }
+  if ((m_hist_end == NO_TIME) || (m_acc_tick >= m_hist_end))
+  {
+    m_hist[histIndex(m_acc_tick)] = m_acc / HISTORY_DECIMATION;
+    m_hist_end = m_acc_tick + 1;
+  }
+} /* VoterAlignBuffer::commitHistoryTick */
+
+
+float VoterAlignBuffer::history(int64_t tick) const
+{
+  if ((m_hist_end == NO_TIME) || (tick >= m_hist_end) ||
+      (tick < m_hist_end - HISTORY_TICKS))
+  {
+    return 0.0f;
+  }
+  return m_hist[histIndex(tick)];
+} /* VoterAlignBuffer::history */
+
+
+void VoterAlignBuffer::writeDueSamples(void)
+{
+  if (!m_is_open || m_output_stopped || (m_due == 0))
+  {
+    return;
+  }
+
+  const unsigned size = m_buf.size();
+  while (m_due > 0)
+  {
+    const unsigned len = min(m_due, size - m_head);
+    const int written = sinkWriteSamples(&m_buf[m_head], len);
+    m_head = (m_head + written) % size;
+    m_level -= written;
+    m_due -= written;
+    if (written == 0)
+    {
+      m_output_stopped = true;
+      break;
+    }
+  }
+
+  if (m_is_flushing && empty())
+  {
+    sinkFlushSamples();
+  }
+} /* VoterAlignBuffer::writeDueSamples */
+
+
+
+/*
+ * This file has not been truncated
+ */
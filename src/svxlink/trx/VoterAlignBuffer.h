@@ -0,0 +1,378 @@
+/**
+@file   VoterAlignBuffer.h
+@brief  A delay buffer used to time align the audio from voter satellites
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a buffer that delay the audio from one voter satellite
+receiver so that it line up in time with the audio from the other satellite
+receivers. It also contain the functions used to estimate the difference in
+latency between two satellite receivers.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef VOTER_ALIGN_BUFFER_INCLUDED
+#define VOTER_ALIGN_BUFFER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+#include <stdint.h>
+
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A delay buffer used to time align the audio from voter satellites
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+The audio from the satellite receivers of a voter reach the voter with
+different latency, depending on how each receiver is connected. This buffer
+delay the audio from one satellite so that it line up with the audio from
+the satellite that has the highest latency. When the voter switch between two
+aligned satellites, the audio continue from the same point in time.
+
+When the output is closed, the buffer keep the latest audio up to its
+capacity, just like an overwriting AudioFifo. When the output is open, the
+buffer work as a delay line. For each block of samples written to the buffer,
+the same number of samples are written to the sink. The number of samples
+kept in the buffer is the delay. The delay is moved towards the target delay
+by dropping or holding back samples, but only when the audio is silent so
+that it is not heard.
+
+Each sample written to the buffer is given a timestamp, the time it arrived
+at the buffer. A decimated copy of the latest audio is kept on that time
+scale. The estimateLag function cross correlate the history of two buffers to
+find out how much later the audio arrive at one buffer compared to the other.
+*/
+class VoterAlignBuffer : public Async::AudioSink, public Async::AudioSource
+{
+  public:
+    /**
+     * @brief   A time source returning the current time in samples
+     */
+    typedef sigc::slot<int64_t()> TimeSource;
+
+    /**
+     * @brief   The decimation factor of the history used to estimate lag
+     */
+    static const unsigned HISTORY_DECIMATION = 8;
+
+    /**
+     * @brief   The length of the history, in samples before decimation
+     */
+    static const unsigned HISTORY_LENGTH = 4 * INTERNAL_SAMPLE_RATE;
+
+    /**
+     * @brief   The length of the window used when estimating lag
+     */
+    static const unsigned LAG_WINDOW = INTERNAL_SAMPLE_RATE / 4;
+
+    /**
+     * @brief   The maximum lag that can be estimated, in samples
+     */
+    static const int MAX_LAG = INTERNAL_SAMPLE_RATE;
+
+    /**
+     * @brief   Estimate the lag of one buffer compared to another one
+     * @param   ref       The reference buffer
+     * @param   other     The buffer to estimate the lag for
+     * @param   expected  The expected lag in samples
+     * @param   max_dev   The maximum deviation from the expected lag
+     * @param   lag       The estimated lag, in samples, is put here
+     * @param   quality   The normalized correlation at the lag is put here
+     * @return  Returns \em true if a lag could be estimated
+     *
+     * The lag is positive if the audio arrive later at the other buffer than
+     * at the reference buffer. Lags between expected-max_dev and
+     * expected+max_dev are searched. No estimate is made if the reference
+     * audio is silent in the latest window or if the correlation is too weak
+     * to be trusted.
+     */
+    static bool estimateLag(const VoterAlignBuffer &ref,
+                            const VoterAlignBuffer &other,
+                            int expected, int max_dev, int &lag,
+                            float &quality);
+
+    /**
+     * @brief   Constructor
+     * @param   capacity  The maximum number of samples to buffer
+     */
+    explicit VoterAlignBuffer(unsigned capacity);
+
+    /**
+     * @brief   Destructor
+     */
+    ~VoterAlignBuffer(void);
+
+    /**
+     * @brief   Set the time source to use for timestamps
+     * @param   time_source The time source
+     *
+     * The default is to use the system monotonic clock.
+     */
+    void setTimeSource(const TimeSource &time_source)
+    {
+      m_time_source = time_source;
+    }
+
+    /**
+     * @brief   Set the target delay
+     * @param   delay The target delay in samples
+     */
+    void setTargetDelay(unsigned delay);
+
+    /**
+     * @brief   Get the target delay
+     * @return  Returns the target delay in samples
+     */
+    unsigned targetDelay(void) const { return m_target; }
+
+    /**
+     * @brief   Set the number of history samples to keep when opening
+     * @param   len The number of samples
+     *
+     * When the output is opened using the setOpen function, the buffer is
+     * first cut down to this many samples plus the target delay. That way the
+     * start of a transmission is kept when the voter make its first choice.
+     */
+    void setHistoryLength(unsigned len) { m_history_len = len; }
+
+    /**
+     * @brief   Open or close the output
+     * @param   is_open Set to \em true to open the output
+     */
+    void setOpen(bool is_open);
+
+    /**
+     * @brief   Check if the output is open
+     * @return  Returns \em true if the output is open
+     */
+    bool isOpen(void) const { return m_is_open; }
+
+    /**
+     * @brief   Open the output in line with the output of another buffer
+     * @param   other         The buffer that has been playing until now
+     * @param   crossfade_len The number of samples to crossfade
+     *
+     * The buffer is cut down so that the output continue from the same point
+     * in time as the other buffer would have. The first samples of the output
+     * are crossfaded from the samples that the other buffer would have played.
+     * The other buffer is not changed.
+     */
+    void openAlignedTo(const VoterAlignBuffer &other, unsigned crossfade_len);
+
+    /**
+     * @brief   Get the number of samples in the buffer
+     * @return  Returns the number of samples buffered
+     */
+    unsigned samplesInBuffer(void) const { return m_level; }
+
+    /**
+     * @brief   Get the current delay
+     * @return  Returns the number of buffered samples that are not due yet
+     */
+    unsigned delay(void) const { return m_level - m_due; }
+
+    /**
+     * @brief   Get the arrival time of the oldest sample in the buffer
+     * @return  Returns the time in samples
+     *
+     * When the output is open, this is the arrival time of the next sample
+     * that will be written to the sink.
+     */
+    int64_t headTime(void) const { return m_next_time - m_level; }
+
+    /**
+     * @brief   Copy buffered samples given their arrival time
+     * @param   t     The arrival time of the first sample to copy
+     * @param   dest  The buffer to copy the samples to
+     * @param   count The number of samples to copy
+     * @return  Returns \em true if all the samples were in the buffer
+     *
+     * Nothing is copied if some of the samples have not arrived yet or have
+     * already left the buffer.
+     */
+    bool copySamples(int64_t t, float *dest, unsigned count) const;
+
+    /**
+     * @brief   Check if the buffer is empty
+     * @return  Returns \em true if the buffer is empty
+     */
+    bool empty(void) const { return m_level == 0; }
+
+    /**
+     * @brief   Throw away all buffered samples
+     *
+     * The history used to estimate lag is kept.
+     */
+    void clear(void);
+
+    /**
+     * @brief   Write samples into this audio sink
+     * @param   samples The buffer containing the samples
+     * @param   count   The number of samples in the buffer
+     * @return  Returns the number of samples that has been taken care of
+     */
+    int writeSamples(const float *samples, int count) override;
+
+    /**
+     * @brief   Tell the sink to flush the previously written samples
+     */
+    void flushSamples(void) override;
+
+    /**
+     * @brief   Resume audio output to the sink
+     */
+    void resumeOutput(void) override;
+
+    /**
+     * @brief   The registered sink has flushed all samples
+     */
+    void allSamplesFlushed(void) override;
+
+  private:
+    static const unsigned TOLERANCE     = INTERNAL_SAMPLE_RATE / 200;
+    static const unsigned HISTORY_TICKS =
+        HISTORY_LENGTH / HISTORY_DECIMATION;
+
+    std::vector<float>  m_buf;
+    unsigned            m_head;
+    unsigned            m_level;
+    unsigned            m_due;
+    unsigned            m_target;
+    unsigned            m_history_len;
+    bool                m_is_open;
+    bool                m_is_flushing;
+    bool                m_output_stopped;
+    float               m_avg_energy;
+    TimeSource          m_time_source;
+    int64_t             m_next_time;
+    std::vector<float>  m_hist;
+    int64_t             m_hist_end;
+    int64_t             m_acc_tick;
+    float               m_acc;
+
+    VoterAlignBuffer(const VoterAlignBuffer&);
+    VoterAlignBuffer& operator=(const VoterAlignBuffer&);
+    int64_t now(void) const;
+    float& at(unsigned pos) { return m_buf[(m_head + pos) % m_buf.size()]; }
+    float at(unsigned pos) const
+    {
+      return m_buf[(m_head + pos) % m_buf.size()];
+    }
+    void drop(unsigned count);
+    bool isSilent(unsigned count) const;
+    void adjustDelay(unsigned count);
+    void open(void);
+    void writeToHistory(const float *samples, int count);
+    void commitHistoryTick(void);
+    float history(int64_t tick) const;
+    static unsigned histIndex(int64_t tick)
+    {
+      return (tick % HISTORY_TICKS + HISTORY_TICKS) % HISTORY_TICKS;
+    }
+    void writeDueSamples(void);
+
+};  /* class VoterAlignBuffer */
+
+
+//} /* namespace */
+
+#endif /* VOTER_ALIGN_BUFFER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,289 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include <AsyncAudioSink.h>
+
+#include "VoterAlignBuffer.h"
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Verify the VoterAlignBuffer class
+ *
+ * Usage: VoterAlignBufferTest
+ *
+ * Speech like audio is received by simulated satellite receivers with
+ * different latencies, noise and packet jitter. The estimated lag between
+ * two receivers must be within a millisecond of the simulated one. The
+ * delay line must move its delay to the target delay by only dropping or
+ * holding back silent audio, and a buffer opened in line with another one
+ * must continue from the same sample, with and without crossfade.
+ * The exit status is zero if all tests pass.
+ */
+
+namespace {
+  const int SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
+  const int BLOCK_SIZE = 160;
+  const int MAX_LAG_ERROR = SAMPLE_RATE / 1000;
+
+  class Clock
+  {
+    public:
+      Clock(void) : t(1000000) {}
+      int64_t now(void) { return t; }
+      int64_t t;
+  };
+
+  class Capture : public AudioSink
+  {
+    public:
+      Capture(void) : flushed(false) {}
+      int writeSamples(const float *samples, int count) override
+      {
+        out.insert(out.end(), samples, samples + count);
+        flushed = false;
+        return count;
+      }
+      void flushSamples(void) override
+      {
+        flushed = true;
+        sourceAllSamplesFlushed();
+      }
+      vector<float> out;
+      bool          flushed;
+  };
+
+    // Noise shaped like speech, with syllables and pauses
+  vector<float> makeSpeech(int len, unsigned seed)
+  {
+    mt19937 rng(seed);
+    normal_distribution<float> noise(0.0f, 0.3f);
+    vector<float> sig(len);
+    float lp = 0.0f;
+    for (int n=0; n<len; ++n)
+    {
+      lp = 0.7f * lp + noise(rng);
+      const float syllable = sinf(2.0f * M_PI * 3.0f * n / SAMPLE_RATE);
+      const float gate = ((n / (SAMPLE_RATE / 8)) % 6 == 5) ? 0.0f : 1.0f;
+      sig[n] = gate * max(syllable, 0.0f) * lp;
+    }
+    return sig;
+  }
+
+  bool testLagEstimate(int lag, int jitter_blocks, float noise_level)
+  {
+    const int len = 3 * SAMPLE_RATE;
+    const vector<float> speech = makeSpeech(len, 4711);
+    mt19937 rng(lag + 1000);
+    normal_distribution<float> noise(0.0f, noise_level);
+
+    Clock ref_clock;
+    Clock other_clock;
+    VoterAlignBuffer ref(SAMPLE_RATE);
+    VoterAlignBuffer other(SAMPLE_RATE);
+    ref.setTimeSource(sigc::mem_fun(ref_clock, &Clock::now));
+    other.setTimeSource(sigc::mem_fun(other_clock, &Clock::now));
+
+      // The other receiver get each block lag samples later than the
+      // reference receiver. Blocks are sometimes held back by jitter and
+      // delivered together with the next blocks.
+    uniform_int_distribution<int> jitter_dist(0, jitter_blocks);
+    vector<float> pending;
+    int held = 0;
+    for (int n=0; n+BLOCK_SIZE<=len; n+=BLOCK_SIZE)
+    {
+      vector<float> block(&speech[n], &speech[n] + BLOCK_SIZE);
+      ref_clock.t += BLOCK_SIZE;
+      ref.writeSamples(block.data(), BLOCK_SIZE);
+
+      for (auto& s : block)
+      {
+        s += noise(rng);
+      }
+      pending.insert(pending.end(), block.begin(), block.end());
+      if (held == 0)
+      {
+        held = jitter_dist(rng);
+      }
+      if (--held <= 0)
+      {
+        other_clock.t = ref_clock.t + lag;
+        other.writeSamples(pending.data(), pending.size());
+        pending.clear();
+        held = 0;
+      }
+    }
+
+      // The other receiver must have delivered all audio up to the current
+      // time for the estimate to be fair
+    ref_clock.t += lag;
+
+    int est = 0;
+    float quality = 0.0f;
+    const bool ok = VoterAlignBuffer::estimateLag(ref, other, 0,
+        VoterAlignBuffer::MAX_LAG - 10, est, quality);
+    int local_est = 0;
+    const bool local_ok = VoterAlignBuffer::estimateLag(ref, other,
+        lag + 160, SAMPLE_RATE / 20, local_est, quality);
+    const bool pass = ok && local_ok && (abs(est - lag) <= MAX_LAG_ERROR) &&
+                      (abs(local_est - lag) <= MAX_LAG_ERROR);
+    cout << "lag=" << lag << " jitter=" << jitter_blocks
+         << " noise=" << noise_level << ": estimate=" << est
+         << " local=" << local_est << " quality=" << quality
+         << (pass ? "  OK" : "  FAILED") << endl;
+    return pass;
+  }
+
+  bool testSilentNoEstimate(void)
+  {
+    Clock clock;
+    VoterAlignBuffer ref(SAMPLE_RATE);
+    VoterAlignBuffer other(SAMPLE_RATE);
+    ref.setTimeSource(sigc::mem_fun(clock, &Clock::now));
+    other.setTimeSource(sigc::mem_fun(clock, &Clock::now));
+    vector<float> silence(BLOCK_SIZE, 0.0f);
+    for (int i=0; i<200; ++i)
+    {
+      clock.t += BLOCK_SIZE;
+      ref.writeSamples(silence.data(), BLOCK_SIZE);
+      other.writeSamples(silence.data(), BLOCK_SIZE);
+    }
+    int lag = 0;
+    float quality = 0.0f;
+    const bool pass = !VoterAlignBuffer::estimateLag(ref, other, 0, 8000,
+                                                     lag, quality);
+    cout << "Silence: " << (pass ? "no estimate  OK" : "estimate  FAILED")
+         << endl;
+    return pass;
+  }
+
+  bool testCatchUp(unsigned target)
+  {
+    const int len = 4 * SAMPLE_RATE;
+    const vector<float> speech = makeSpeech(len, 17);
+    const unsigned history = 3 * SAMPLE_RATE / 10;
+
+    VoterAlignBuffer buf(SAMPLE_RATE);
+    buf.setHistoryLength(history);
+    buf.setTargetDelay(target);
+    Capture cap;
+    buf.registerSink(&cap);
+
+    int n = 0;
+    for (; n<static_cast<int>(history); n+=BLOCK_SIZE)
+    {
+      buf.writeSamples(&speech[n], BLOCK_SIZE);
+    }
+    buf.setOpen(true);
+    const unsigned start_delay = buf.delay();
+    for (; n+BLOCK_SIZE<=len; n+=BLOCK_SIZE)
+    {
+      buf.writeSamples(&speech[n], BLOCK_SIZE);
+    }
+    const unsigned end_delay = buf.delay();
+    buf.flushSamples();
+
+      // Only silent samples may have been dropped
+    unsigned loud_in = 0;
+    unsigned loud_out = 0;
+    for (int i=0; i<n; ++i)
+    {
+      loud_in += (fabsf(speech[i]) > 0.05f) ? 1 : 0;
+    }
+    for (float s : cap.out)
+    {
+      loud_out += (fabsf(s) > 0.05f) ? 1 : 0;
+    }
+
+    const bool pass = (abs(static_cast<int>(end_delay - target)) <=
+                       SAMPLE_RATE / 100) &&
+                      (loud_in - loud_out < loud_in / 100) &&
+                      cap.flushed && buf.empty();
+    cout << "Catch up from " << start_delay << " to target " << target
+         << ": delay=" << end_delay << " in=" << n
+         << " out=" << cap.out.size() << " loud in/out="
+         << loud_in << "/" << loud_out << (pass ? "  OK" : "  FAILED")
+         << endl;
+    return pass;
+  }
+
+  bool testSwitch(unsigned crossfade_len)
+  {
+    const int lag = 8 * BLOCK_SIZE;
+    const int len = 2 * SAMPLE_RATE;
+    vector<float> sig(len + lag);
+    for (size_t i=0; i<sig.size(); ++i)
+    {
+      sig[i] = 0.5f + 0.4f * sinf(2.0f * M_PI * 440.0f * i / SAMPLE_RATE);
+    }
+
+      // The slow receiver get the same audio lag samples later so the fast
+      // one need a delay of lag samples to line up
+    VoterAlignBuffer fast(SAMPLE_RATE);
+    VoterAlignBuffer slow(SAMPLE_RATE);
+    fast.setTargetDelay(lag + crossfade_len);
+    slow.setTargetDelay(crossfade_len);
+    fast.setHistoryLength(0);
+    Capture cap;
+    fast.registerSink(&cap);
+
+    int n = 0;
+    for (; n<lag; n+=BLOCK_SIZE)
+    {
+      fast.writeSamples(&sig[n], BLOCK_SIZE);
+    }
+    fast.setOpen(true);
+    for (; n<len/2; n+=BLOCK_SIZE)
+    {
+      fast.writeSamples(&sig[n], BLOCK_SIZE);
+      slow.writeSamples(&sig[n - lag], BLOCK_SIZE);
+    }
+    const size_t played = cap.out.size();
+
+    fast.unregisterSink();
+    slow.registerSink(&cap);
+    slow.openAlignedTo(fast, crossfade_len);
+    fast.setOpen(false);
+    for (; n<len; n+=BLOCK_SIZE)
+    {
+      slow.writeSamples(&sig[n - lag], BLOCK_SIZE);
+    }
+
+    float max_diff = 0.0f;
+    for (size_t i=0; i<cap.out.size(); ++i)
+    {
+      max_diff = max(max_diff, fabsf(cap.out[i] - sig[i]));
+    }
+    const bool pass = (played > 0) && (cap.out.size() > played) &&
+                      (max_diff < 1.0e-5f);
+    cout << "Switch with crossfade " << crossfade_len << ": played "
+         << played << "+" << (cap.out.size() - played)
+         << " samples, max diff=" << max_diff
+         << (pass ? "  OK" : "  FAILED") << endl;
+    return pass;
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  int failed = 0;
+  failed += testLagEstimate(0, 0, 0.01f) ? 0 : 1;
+  failed += testLagEstimate(592, 0, 0.01f) ? 0 : 1;
+  failed += testLagEstimate(2900, 3, 0.05f) ? 0 : 1;
+  failed += testLagEstimate(-1450, 2, 0.1f) ? 0 : 1;
+  failed += testLagEstimate(7000, 5, 0.05f) ? 0 : 1;
+  failed += testSilentNoEstimate() ? 0 : 1;
+  failed += testCatchUp(0) ? 0 : 1;
+  failed += testCatchUp(SAMPLE_RATE / 10) ? 0 : 1;
+  failed += testCatchUp(SAMPLE_RATE / 2) ? 0 : 1;
+  failed += testSwitch(0) ? 0 : 1;
+  failed += testSwitch(SAMPLE_RATE / 100) ? 0 : 1;
+  return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,315 @@
+/**
+@file   VoterCombiner.cpp
+@brief  Combine the audio from a number of voter satellite receivers
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "VoterCombiner.h"
+#include "VoterAlignBuffer.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+VoterCombiner::VoterCombiner(void)
+  : m_out(BLOCK_SIZE), m_master(-1)
+{
+} /* VoterCombiner::VoterCombiner */
+
+
+VoterCombiner::~VoterCombiner(void)
+{
+} /* VoterCombiner::~VoterCombiner */
+
+
+unsigned VoterCombiner::addInput(const VoterAlignBuffer *buf)
+{
+  Input input;
+  input.buf = buf;
+  input.is_active = false;
+  input.has_audio = false;
+  input.latency = 0.0f;
+  input.siglev = 0.0f;
+  input.gain = 0.0f;
+  input.target = 0.0f;
+  m_inputs.push_back(input);
+  m_block.resize(m_inputs.size() * BLOCK_SIZE);
+  return m_inputs.size() - 1;
+} /* VoterCombiner::addInput */
+
+
+void VoterCombiner::setMaster(int input)
+{
+  assert(input < static_cast<int>(m_inputs.size()));
+  m_master = input;
+} /* VoterCombiner::setMaster */
+
+
+void VoterCombiner::setInputActive(unsigned input, bool is_active)
+{
+  assert(input < m_inputs.size());
+  m_inputs[input].is_active = is_active;
+} /* VoterCombiner::setInputActive */
+
+
+void VoterCombiner::setLatency(unsigned input, float latency)
+{
+  assert(input < m_inputs.size());
+  m_inputs[input].latency = latency;
+} /* VoterCombiner::setLatency */
+
+
+void VoterCombiner::setSignalLevel(unsigned input, float siglev)
+{
+  assert(input < m_inputs.size());
+  m_inputs[input].siglev = siglev;
+} /* VoterCombiner::setSignalLevel */
+
+
+float VoterCombiner::weight(unsigned input) const
+{
+  assert(input < m_inputs.size());
+  return m_inputs[input].gain;
+} /* VoterCombiner::weight */
+
+
+int VoterCombiner::writeSamples(const float *samples, int count)
+{
+  if ((m_master < 0) || !m_inputs[m_master].is_active)
+  {
+    return sinkWriteSamples(samples, count);
+  }
+
+    // Pick the audio that arrived at the same time as the master audio
+    // from the other receivers, compensating for the difference in latency
+  count = min(count, static_cast<int>(BLOCK_SIZE));
+  Input &master = m_inputs[m_master];
+  const int64_t t = master.buf->headTime();
+  bool is_combining = false;
+  for (size_t i=0; i<m_inputs.size(); ++i)
+  {
+    Input &input = m_inputs[i];
+    if (static_cast<int>(i) == m_master)
+    {
+      copy(samples, samples + count, &m_block[i * BLOCK_SIZE]);
+      input.has_audio = true;
+      continue;
+    }
+    const int64_t dt = llroundf(input.latency - master.latency);
+    input.has_audio = input.is_active &&
+        input.buf->copySamples(t + dt, &m_block[i * BLOCK_SIZE], count);
+    is_combining |= input.has_audio;
+  }
+  if (!is_combining)
+  {
+    for (auto& input : m_inputs)
+    {
+      input.gain = 0.0f;
+    }
+    master.gain = 1.0f;
+    return sinkWriteSamples(samples, count);
+  }
+
+  calcWeights();
+  mix(count);
+  return sinkWriteSamples(&m_out[0], count);
+} /* VoterCombiner::writeSamples */
+
+
+void VoterCombiner::flushSamples(void)
+{
+  sinkFlushSamples();
+} /* VoterCombiner::flushSamples */
+
+
+void VoterCombiner::resumeOutput(void)
+{
+  sourceResumeOutput();
+} /* VoterCombiner::resumeOutput */
+
+
+void VoterCombiner::allSamplesFlushed(void)
+{
+  sourceAllSamplesFlushed();
+} /* VoterCombiner::allSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void VoterCombiner::calcWeights(void)
+{
+    // The weights are calculated relative to the strongest receiver to
+    // keep the exponent within range
+  float max_siglev = m_inputs[m_master].siglev;
+  for (const auto& input : m_inputs)
+  {
+    if (input.has_audio)
+    {
+      max_siglev = max(max_siglev, input.siglev);
+    }
+  }
+
+  float sum = 0.0f;
+  for (auto& input : m_inputs)
+  {
+    if (input.has_audio)
+    {
+      input.target = powf(10.0f, (input.siglev - max_siglev) / SIGLEV_SCALE);
+      sum += input.target;
+    }
+    else
+    {
+        // There is no audio to ramp the gain down with
+      input.target = 0.0f;
+      input.gain = 0.0f;
+    }
+  }
+  for (auto& input : m_inputs)
+  {
+    input.target /= sum;
+  }
+} /* VoterCombiner::calcWeights */
+
+
+void VoterCombiner::mix(unsigned count)
+{
+    // The blocks are stored one after the other so that the inner loop run
+    // over contiguous samples, which the compiler turn into SIMD code
+  float *out = &m_out[0];
+  fill(out, out + count, 0.0f);
+  for (size_t i=0; i<m_inputs.size(); ++i)
+  {
+    Input &input = m_inputs[i];
+    const float g0 = input.gain;
+    const float g1 = input.target;
+    input.gain = g1;
+    if (!input.has_audio)
+    {
+      continue;
+    }
+    const float *in = &m_block[i * BLOCK_SIZE];
+    const float dg = (g1 - g0) / count;
+    for (unsigned n=0; n<count; ++n)
+    {
+      out[n] += (g0 + dg * n) * in[n];
+    }
+  }
+} /* VoterCombiner::mix */
+
+
+
+/*
+ * This file has not been truncated
+ */
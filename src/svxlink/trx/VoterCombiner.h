@@ -0,0 +1,286 @@
+/**
+@file   VoterCombiner.h
+@brief  Combine the audio from a number of voter satellite receivers
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This file contains a class that mix the time aligned audio from a number of
+voter satellite receivers, weighting each receiver by its signal level.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef VOTER_COMBINER_INCLUDED
+#define VOTER_COMBINER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
+#include <CppStdCompat.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+class VoterAlignBuffer;
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Combine the audio from a number of voter satellite receivers
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-18
+
+This class mix the audio from a number of satellite receivers that receive the
+same signal. It is an approximation of maximal ratio combining. The noise in
+the audio from an FM receiver is inversely proportional to the signal level
+so each receiver is weighted by its linear signal level. The signal level
+values are assumed to be in dB, like the values from a noise based signal
+level detector using the default slope. The weights are normalized so that
+they sum up to one, which keep the audio level constant.
+
+The audio of each receiver is kept in a VoterAlignBuffer. The audio stream
+of one of the receivers, the master, is written to the combiner. The master
+stream set the pace and decide what is being output. For each block written,
+the audio that arrived at the same time, compensated for the difference in
+latency, is picked from the buffers of the other active receivers and mixed
+in. A receiver that does not have all the audio for a block is left out of
+that block. The weights are calculated once for each block and the gain for
+each receiver is ramped from the old to the new weight over the block to
+avoid clicks.
+
+\code
+  VoterCombiner combiner;
+  unsigned rx1 = combiner.addInput(&rx1_buf);
+  unsigned rx2 = combiner.addInput(&rx2_buf);
+  rx1_buf.registerSink(&combiner);
+  combiner.registerSink(&sink);
+  combiner.setMaster(rx1);
+  combiner.setInputActive(rx1, true);
+  combiner.setInputActive(rx2, true);
+  combiner.setLatency(rx2, 800.0f);
+  combiner.setSignalLevel(rx1, 35.0f);
+  combiner.setSignalLevel(rx2, 12.0f);
+\endcode
+*/
+class VoterCombiner : public Async::AudioSink, public Async::AudioSource
+{
+  public:
+    /**
+     * @brief   The maximum number of samples combined in one block
+     */
+    static const unsigned BLOCK_SIZE = 256;
+
+    /**
+     * @brief   The change in signal level that scale the weight ten times
+     */
+    static CONSTEXPR float SIGLEV_SCALE = 10.0f;
+
+    /**
+     * @brief   Default constructor
+     */
+    VoterCombiner(void);
+
+    /**
+     * @brief   Destructor
+     */
+    ~VoterCombiner(void);
+
+    /**
+     * @brief   Add a receiver buffer to combine audio from
+     * @param   buf The buffer holding the audio of the receiver
+     * @return  Returns the index of the new input
+     *
+     * The input is not active until setInputActive is called.
+     */
+    unsigned addInput(const VoterAlignBuffer *buf);
+
+    /**
+     * @brief   Set which input the written audio come from
+     * @param   input The index of the input or -1 for none
+     *
+     * When there is no master, or the master input is not active, the audio
+     * written to the combiner is passed on unchanged.
+     */
+    void setMaster(int input);
+
+    /**
+     * @brief   Get the index of the master input
+     * @return  Returns the index of the master input or -1 for none
+     */
+    int master(void) const { return m_master; }
+
+    /**
+     * @brief   Set if an input should take part in the combination
+     * @param   input     The index of the input
+     * @param   is_active Set to \em true to combine audio from the input
+     *
+     * An input should only be activated when its latency is known.
+     */
+    void setInputActive(unsigned input, bool is_active);
+
+    /**
+     * @brief   Set the latency for an input
+     * @param   input   The index of the input
+     * @param   latency The latency in samples
+     *
+     * The latency is relative to the other inputs so it does not matter
+     * which input it is measured from, as long as it is the same for all.
+     */
+    void setLatency(unsigned input, float latency);
+
+    /**
+     * @brief   Set the signal level for an input
+     * @param   input   The index of the input
+     * @param   siglev  The signal level
+     *
+     * The new signal level is used from the next block of audio.
+     */
+    void setSignalLevel(unsigned input, float siglev);
+
+    /**
+     * @brief   Get the weight used for an input in the last block
+     * @param   input The index of the input
+     * @return  Returns the weight, between zero and one
+     */
+    float weight(unsigned input) const;
+
+    /**
+     * @brief   Write samples into this audio sink
+     * @param   samples The buffer containing the samples
+     * @param   count   The number of samples in the buffer
+     * @return  Returns the number of samples that has been taken care of
+     */
+    int writeSamples(const float *samples, int count) override;
+
+    /**
+     * @brief   Tell the sink to flush the previously written samples
+     */
+    void flushSamples(void) override;
+
+    /**
+     * @brief   Resume audio output to the sink
+     */
+    void resumeOutput(void) override;
+
+    /**
+     * @brief   The registered sink has flushed all samples
+     */
+    void allSamplesFlushed(void) override;
+
+  private:
+    struct Input
+    {
+      const VoterAlignBuffer *buf;
+      bool                    is_active;
+      bool                    has_audio;
+      float                   latency;
+      float                   siglev;
+      float                   gain;
+      float                   target;
+    };
+
+    std::vector<Input>  m_inputs;
+    std::vector<float>  m_block;
+    std::vector<float>  m_out;
+    int                 m_master;
+
+    VoterCombiner(const VoterCombiner&);
+    VoterCombiner& operator=(const VoterCombiner&);
+    void calcWeights(void);
+    void mix(unsigned count);
+
+};  /* class VoterCombiner */
+
+
+//} /* namespace */
+
+#endif /* VOTER_COMBINER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,339 @@
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <memory>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include <AsyncConfig.h>
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
+
+#include "SigLevDetNoise.h"
+#include "VoterAlignBuffer.h"
+#include "VoterCombiner.h"
+
+using namespace std;
+using namespace Async;
+
+
+/*
+ * Voter combiner test harness and benchmark
+ *
+ * Usage: VoterCombiner_bench [reference.wav rx1.wav rx2.wav ...]
+ *
+ * The audio from a number of receivers that received the same transmission
+ * is combined by the VoterCombiner, using the signal level reported by a
+ * noise based signal level detector for each receiver. The audio is written
+ * to a VoterAlignBuffer for each receiver, the first receiver being the
+ * master. The result is compared
+ * to the audio of each receiver alone and to selecting the receiver with the
+ * highest signal level for each block, which is what the voter does when not
+ * combining. The quality is given as the SNR compared to the reference audio.
+ * The CPU time used to buffer and combine each block is also printed.
+ *
+ * The WAV files must be mono, 16 bit PCM at the internal sample rate. The
+ * receiver recordings must be time aligned with each other and with the
+ * reference, which is the audio that was transmitted. They should be recorded
+ * before any filtering that remove the noise above the voice band, since that
+ * is where the signal level detector measure the noise.
+ *
+ * Without arguments, a speech like reference is generated and received by
+ * four simulated receivers with different noise levels. One of the receivers
+ * has a fading signal.
+ */
+
+namespace {
+  const int SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
+  const int BLOCK_SIZE = SAMPLE_RATE / 50;
+
+  class Clock
+  {
+    public:
+      Clock(void) : t(0) {}
+      int64_t now(void) { return t; }
+      int64_t t;
+  };
+
+  class Capture : public AudioSink
+  {
+    public:
+      int writeSamples(const float *samples, int len)
+      {
+        out.insert(out.end(), samples, samples + len);
+        return len;
+      }
+      void flushSamples(void) { sourceAllSamplesFlushed(); }
+      vector<float> out;
+  };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  bool readWav(const string &filename, vector<float> &samples)
+  {
+    ifstream file(filename.c_str(), ios::binary);
+    char riff[12];
+    if (!file.read(riff, sizeof(riff)) || (memcmp(riff, "RIFF", 4) != 0) ||
+        (memcmp(riff + 8, "WAVE", 4) != 0))
+    {
+      cerr << "*** ERROR: " << filename << " is not a WAV file" << endl;
+      return false;
+    }
+
+    bool format_ok = false;
+    char hdr[8];
+    while (file.read(hdr, sizeof(hdr)))
+    {
+      const uint32_t len = static_cast<uint8_t>(hdr[4]) |
+                           (static_cast<uint8_t>(hdr[5]) << 8) |
+                           (static_cast<uint8_t>(hdr[6]) << 16) |
+                           (static_cast<uint32_t>(
+                              static_cast<uint8_t>(hdr[7])) << 24);
+      vector<char> data(len + (len & 1));
+      if (!file.read(data.data(), data.size()) && (memcmp(hdr, "data", 4)))
+      {
+        break;
+      }
+      auto u16 = [&](int pos) {
+        return static_cast<uint16_t>(static_cast<uint8_t>(data[pos]) |
+                                     (static_cast<uint8_t>(data[pos+1]) << 8));
+      };
+      if (memcmp(hdr, "fmt ", 4) == 0)
+      {
+        const uint32_t rate = u16(4) | (static_cast<uint32_t>(u16(6)) << 16);
+        format_ok = (len >= 16) && (u16(0) == 1) && (u16(2) == 1) &&
+                    (rate == SAMPLE_RATE) && (u16(14) == 16);
+      }
+      else if (memcmp(hdr, "data", 4) == 0)
+      {
+        if (!format_ok)
+        {
+          break;
+        }
+        const size_t count = min<size_t>(len, file.gcount()) / 2;
+        samples.resize(count);
+        for (size_t i=0; i<count; ++i)
+        {
+          samples[i] = static_cast<int16_t>(u16(2 * i)) / 32768.0f;
+        }
+        return true;
+      }
+    }
+    cerr << "*** ERROR: " << filename << " is not a mono 16 bit PCM WAV "
+            "file with a sample rate of " << SAMPLE_RATE << " Hz" << endl;
+    return false;
+  }
+
+  void generate(vector<float> &ref, vector<vector<float> > &rxs)
+  {
+    const int len = 20 * SAMPLE_RATE;
+    mt19937 rng(4711);
+    ref.resize(len);
+    float phase = 0.0f;
+    for (int n=0; n<len; ++n)
+    {
+        // Voiced sound with a moving pitch and a syllabic envelope
+      const float t = static_cast<float>(n) / SAMPLE_RATE;
+      const float f0 = 140.0f + 40.0f * sinf(2.0f * M_PI * 0.7f * t);
+      phase += 2.0f * M_PI * f0 / SAMPLE_RATE;
+      float s = 0.0f;
+      for (int h=1; h*f0<3000.0f; ++h)
+      {
+        s += sinf(h * phase) / h;
+      }
+      const float env = max(sinf(2.0f * M_PI * 4.0f * t), 0.0f);
+      const float gate = (fmodf(t, 3.0f) < 2.5f) ? 1.0f : 0.0f;
+      ref[n] = 0.3f * gate * env * s;
+    }
+
+    const float noise_level[] = { 0.1f, 0.2f, 0.3f, 0.5f };
+    for (unsigned i=0; i<sizeof(noise_level)/sizeof(*noise_level); ++i)
+    {
+      normal_distribution<float> noise(0.0f, 1.0f);
+      vector<float> rx(len);
+      for (int n=0; n<len; ++n)
+      {
+        float level = noise_level[i];
+        if (i == 2)
+        {
+            // A receiver that fade in and out
+          level *= 0.2f + 2.0f *
+                   fabsf(sinf(2.0f * M_PI * 0.15f * n / SAMPLE_RATE));
+        }
+        rx[n] = ref[n] + level * noise(rng);
+      }
+      rxs.push_back(rx);
+    }
+  }
+
+    // The SNR of a signal compared to the reference, using the gain that
+    // minimize the noise
+  float snr(const vector<float> &ref, const vector<float> &sig)
+  {
+    const size_t len = min(ref.size(), sig.size());
+    double rr = 0.0;
+    double rs = 0.0;
+    for (size_t i=0; i<len; ++i)
+    {
+      rr += ref[i] * ref[i];
+      rs += ref[i] * sig[i];
+    }
+    const double gain = (rr > 0.0) ? (rs / rr) : 0.0;
+    double signal = 0.0;
+    double noise = 0.0;
+    for (size_t i=0; i<len; ++i)
+    {
+      const double err = sig[i] - gain * ref[i];
+      signal += gain * ref[i] * gain * ref[i];
+      noise += err * err;
+    }
+    return 10.0 * log10((signal + 1.0e-20) / (noise + 1.0e-20));
+  }
+};
+
+
+int main(int argc, const char **argv)
+{
+  vector<float> ref;
+  vector<vector<float> > rx_audio;
+  vector<string> rx_names;
+  if (argc > 1)
+  {
+    if (argc < 3)
+    {
+      cerr << "Usage: VoterCombiner_bench [reference.wav rx1.wav ...]\n";
+      return 1;
+    }
+    if (!readWav(argv[1], ref))
+    {
+      return 1;
+    }
+    for (int i=2; i<argc; ++i)
+    {
+      rx_audio.push_back(vector<float>());
+      if (!readWav(argv[i], rx_audio.back()))
+      {
+        return 1;
+      }
+      rx_names.push_back(argv[i]);
+    }
+  }
+  else
+  {
+    generate(ref, rx_audio);
+    for (size_t i=0; i<rx_audio.size(); ++i)
+    {
+      rx_names.push_back("Rx" + to_string(i + 1));
+    }
+  }
+
+  size_t len = ref.size();
+  for (const auto& rx : rx_audio)
+  {
+    len = min(len, rx.size());
+  }
+  const size_t blocks = len / BLOCK_SIZE;
+  len = blocks * BLOCK_SIZE;
+  ref.resize(len);
+  const unsigned rx_cnt = rx_audio.size();
+
+  Config cfg;
+  Clock clock;
+  VoterCombiner combiner;
+  Capture combined;
+  combiner.registerSink(&combined);
+  vector<unique_ptr<VoterAlignBuffer> > bufs;
+  vector<unique_ptr<SigLevDetNoise> > dets;
+  vector<double> siglev_sum(rx_cnt, 0.0);
+  for (unsigned i=0; i<rx_cnt; ++i)
+  {
+    bufs.emplace_back(new VoterAlignBuffer(SAMPLE_RATE / 2));
+    bufs.back()->setTimeSource(sigc::mem_fun(clock, &Clock::now));
+    combiner.addInput(bufs.back().get());
+    combiner.setInputActive(i, true);
+    dets.emplace_back(new SigLevDetNoise);
+    dets.back()->initialize(cfg, rx_names[i], SAMPLE_RATE);
+  }
+  bufs[0]->registerSink(&combiner);
+  bufs[0]->setHistoryLength(0);
+  bufs[0]->setOpen(true);
+  combiner.setMaster(0);
+
+  vector<float> selected;
+  selected.reserve(len);
+  double cpu = 0.0;
+  double max_cpu = 0.0;
+  for (size_t b=0; b<blocks; ++b)
+  {
+    const size_t pos = b * BLOCK_SIZE;
+    unsigned best = 0;
+    float best_siglev = 0.0f;
+    for (unsigned i=0; i<rx_cnt; ++i)
+    {
+      dets[i]->writeSamples(&rx_audio[i][pos], BLOCK_SIZE);
+      const float siglev = dets[i]->lastSiglev();
+      siglev_sum[i] += siglev;
+      combiner.setSignalLevel(i, siglev);
+      if ((i == 0) || (siglev > best_siglev))
+      {
+        best = i;
+        best_siglev = siglev;
+      }
+    }
+    selected.insert(selected.end(), &rx_audio[best][pos],
+                    &rx_audio[best][pos] + BLOCK_SIZE);
+
+      // The master is written last so that the audio from the other
+      // receivers is in place when it is combined
+    clock.t += BLOCK_SIZE;
+    const double start = cpuTime();
+    for (unsigned i=rx_cnt; i-->0; )
+    {
+      bufs[i]->writeSamples(&rx_audio[i][pos], BLOCK_SIZE);
+    }
+    const double t = cpuTime() - start;
+    cpu += t;
+    max_cpu = max(max_cpu, t);
+  }
+  bufs[0]->flushSamples();
+
+  cout << fixed << setprecision(1);
+  for (unsigned i=0; i<rx_cnt; ++i)
+  {
+    rx_audio[i].resize(len);
+    cout << setw(24) << rx_names[i] << ": SNR=" << setw(5)
+         << snr(ref, rx_audio[i]) << " dB  mean siglev="
+         << (siglev_sum[i] / blocks) << endl;
+  }
+  cout << setw(24) << "Selection" << ": SNR=" << setw(5)
+       << snr(ref, selected) << " dB" << endl;
+  cout << setw(24) << "Combination" << ": SNR=" << setw(5)
+       << snr(ref, combined.out) << " dB" << endl;
+  cout << endl << "Combined " << rx_cnt << " receivers in blocks of "
+       << BLOCK_SIZE << " samples: " << setprecision(2)
+       << (1e6 * cpu / blocks) << " us/block (max "
+       << (1e6 * max_cpu) << " us), "
+       << setprecision(0) << (len / (double)SAMPLE_RATE / cpu)
+       << " times faster than real time" << endl;
+
+  if (combined.out.size() != len)
+  {
+    cerr << "*** ERROR: The combined audio is " << combined.out.size()
+         << " samples long but should be " << len << endl;
+    return 1;
+  }
+
+  return 0;
+}
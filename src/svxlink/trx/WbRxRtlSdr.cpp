@@ -33,6 +33,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdio>
 #include <cassert>
 #include <limits>
 #include <algorithm>
@@ -47,6 +51,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncConfig.h>
+#include <AsyncFdWatch.h>
 
 
 /****************************************************************************
@@ -61,6 +66,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "RtlUsb.h"
 #endif
 #include "Ddr.h"
+#include "FilterBankChannelizer.h"
 
 
 
@@ -137,8 +143,13 @@ WbRxRtlSdr *WbRxRtlSdr::instance(Async::Config &cfg, const string &name)
 
 
 WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
-  : auto_tune_enabled(true), m_name(name), xvrtr_offset(0)
+  : fb(0), auto_tune_enabled(true), m_name(name), xvrtr_offset(0),
+    dsp_in(32), dsp_event_watch(0), dsp_output_pending(false),
+    dsp_overruns(0)
 {
+  dsp_wake_pipe[0] = dsp_wake_pipe[1] = -1;
+  dsp_event_pipe[0] = dsp_event_pipe[1] = -1;
+
   //cout << "### Initializing WBRX " << name << endl;
 
   string rtl_type = "RtlTcp";
@@ -173,7 +184,8 @@ WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
   cfg.getValue(name, "SAMPLE_RATE", sample_rate);
   //cout << "###   SAMPLE_RATE = " << sample_rate << endl;
   rtl->setSampleRate(sample_rate);
-  rtl->iqReceived.connect(iqReceived.make_slot());
+  rtl->iqReceived.connect(mem_fun(*this, &WbRxRtlSdr::rtlIqReceived));
+  rtl->iqStatsReceived.connect(iqStatsReceived.make_slot());
   rtl->readyStateChanged.connect(
       mem_fun(*this, &WbRxRtlSdr::rtlReadyStateChanged));
 
@@ -206,13 +218,40 @@ WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
   bool peak_meter = false;
   cfg.getValue(name, "PEAK_METER", peak_meter);
   rtl->enableDistPrint(peak_meter);
+
+    // The number of filter bank channels is chosen so that the channel
+    // sample rate match a stage in the ordinary DDR decimator chain
+  bool use_fb = true;
+  cfg.getValue(name, "FILTER_BANK", use_fb);
+  if (use_fb)
+  {
+    if (sample_rate == 960000)
+    {
+      fb = new FilterBankChannelizer(sample_rate, 10, 25000);
+    }
+    else if (sample_rate == 2400000)
+    {
+      fb = new FilterBankChannelizer(sample_rate, 30, 25000);
+    }
+  }
+
+  bool use_dsp_thread = false;
+  cfg.getValue(name, "DSP_THREAD", use_dsp_thread);
+  if (use_dsp_thread && !startDspThread())
+  {
+    cerr << "*** WARNING: " << name << ": Could not start the DSP thread. "
+         << "The DSP will run in the main thread." << endl;
+  }
 } /* WbRxRtlSdr::WbRxRtlSdr */
 
 
 WbRxRtlSdr::~WbRxRtlSdr(void)
 {
+  stopDspThread();
   delete rtl;
   rtl = 0;
+  delete fb;
+  fb = 0;
 } /* WbRxRtlSdr::~WbRxRtlSdr */
 
 
@@ -286,6 +325,37 @@ bool WbRxRtlSdr::isReady(void) const
 } /* WbRxRtlSdr::isReady */
 
 
+unsigned WbRxRtlSdr::fbSampleRate(void) const
+{
+  return (fb != 0) ? fb->outputSampleRate() : 0;
+} /* WbRxRtlSdr::fbSampleRate */
+
+
+sigc::connection WbRxRtlSdr::fbConnect(int fq_offset, int &residual,
+    const sigc::slot<void(const std::vector<Sample>&)> &slot)
+{
+  if (fb == 0)
+  {
+    return sigc::connection();
+  }
+  unsigned ch = fb->channelFor(fq_offset, residual);
+  return fb->connect(ch, slot);
+} /* WbRxRtlSdr::fbConnect */
+
+
+void WbRxRtlSdr::dspOutputWritten(void)
+{
+  if (!dsp_output_pending.exchange(true))
+  {
+    const char ch = 'O';
+    if (write(dsp_event_pipe[1], &ch, 1) == -1)
+    {
+      perror("write to WbRx DSP event pipe");
+    }
+  }
+} /* WbRxRtlSdr::dspOutputWritten */
+
+
 
 /****************************************************************************
  *
@@ -406,6 +476,152 @@ void WbRxRtlSdr::rtlReadyStateChanged(void)
 } /* WbRxRtlSdr::rtlReadyStateChanged */
 
 
+void WbRxRtlSdr::rtlIqReceived(const IqBlock &samples)
+{
+  if (!dspThreaded())
+  {
+    processIq(samples);
+    return;
+  }
+
+    // Hand the block over to the DSP thread. The block is reference counted
+    // so the samples are not copied.
+  if (!dsp_in.push(samples))
+  {
+    if (dsp_overruns++ % 100 == 0)
+    {
+      cerr << "*** WARNING: " << name() << ": The DSP thread is not keeping "
+           << "up. Dropped " << dsp_overruns << " sample blocks so far."
+           << endl;
+    }
+    return;
+  }
+  const char ch = 'B';
+  if (write(dsp_wake_pipe[1], &ch, 1) == -1)
+  {
+    perror("write to WbRx DSP wake pipe");
+  }
+} /* WbRxRtlSdr::rtlIqReceived */
+
+
+void WbRxRtlSdr::processIq(const IqBlock &samples)
+{
+  iqReceived(samples);
+  if (fb != 0)
+  {
+    fb->process(samples.samples());
+  }
+} /* WbRxRtlSdr::processIq */
+
+
+bool WbRxRtlSdr::startDspThread(void)
+{
+  if ((pipe(dsp_wake_pipe) == -1) || (pipe(dsp_event_pipe) == -1))
+  {
+    perror("pipe");
+    stopDspThread();
+    return false;
+  }
+
+    // The main thread must never block on the pipes. If the wake pipe is
+    // full, the DSP thread is already awake.
+  fcntl(dsp_wake_pipe[1], F_SETFL, O_NONBLOCK);
+  fcntl(dsp_event_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl(dsp_event_pipe[1], F_SETFL, O_NONBLOCK);
+  dsp_event_watch = new Async::FdWatch(dsp_event_pipe[0],
+                                       Async::FdWatch::FD_WATCH_RD);
+  dsp_event_watch->activity.connect(
+      mem_fun(*this, &WbRxRtlSdr::dspEventReceived));
+
+  dsp_thread = std::thread(&WbRxRtlSdr::dspThreadFunc, this);
+  return true;
+} /* WbRxRtlSdr::startDspThread */
+
+
+void WbRxRtlSdr::stopDspThread(void)
+{
+    // Closing the write end of the wake pipe make the DSP thread exit
+  if (dsp_wake_pipe[1] != -1)
+  {
+    close(dsp_wake_pipe[1]);
+    dsp_wake_pipe[1] = -1;
+  }
+  if (dsp_thread.joinable())
+  {
+    dsp_thread.join();
+  }
+
+  delete dsp_event_watch;
+  dsp_event_watch = 0;
+  for (int *fds : { dsp_wake_pipe, dsp_event_pipe })
+  {
+    for (int i=0; i<2; ++i)
+    {
+      if (fds[i] != -1)
+      {
+        close(fds[i]);
+        fds[i] = -1;
+      }
+    }
+  }
+
+  IqBlock *block;
+  while ((block = dsp_in.readSlot()) != 0)
+  {
+    block->release();
+    dsp_in.commitRead();
+  }
+} /* WbRxRtlSdr::stopDspThread */
+
+
+void WbRxRtlSdr::dspThreadFunc(void)
+{
+  char buf[64];
+  for (;;)
+  {
+    ssize_t len = read(dsp_wake_pipe[0], buf, sizeof(buf));
+    if (len == 0)
+    {
+      break;
+    }
+    else if (len < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      perror("read from WbRx DSP wake pipe");
+      break;
+    }
+
+    IqBlock *block;
+    while ((block = dsp_in.readSlot()) != 0)
+    {
+      {
+        std::lock_guard<std::mutex> lock(dsp_mutex);
+        processIq(*block);
+      }
+      block->release();
+      dsp_in.commitRead();
+    }
+  }
+} /* WbRxRtlSdr::dspThreadFunc */
+
+
+void WbRxRtlSdr::dspEventReceived(Async::FdWatch *watch)
+{
+  char buf[64];
+  while (read(dsp_event_pipe[0], buf, sizeof(buf)) > 0)
+  {
+  }
+
+    // Clear the flag before emitting the signal so that output written
+    // while the signal is handled cause a new event
+  dsp_output_pending = false;
+  dspOutputReady();
+} /* WbRxRtlSdr::dspEventReceived */
+
+
 
 /*
  * This file has not been truncated
@@ -41,6 +41,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <vector>
 #include <complex>
 #include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
 
 
 /****************************************************************************
@@ -57,6 +60,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include "IqBlock.h"
+#include "IqConverter.h"
+#include "SpscRing.h"
 
 
 /****************************************************************************
@@ -65,9 +71,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+class FilterBankChannelizer;
+
 namespace Async
 {
   class Config;
+  class FdWatch;
 };
 class RtlSdr;
 class Ddr;
@@ -195,15 +204,88 @@ class WbRxRtlSdr : public sigc::trackable
      */
     bool isReady(void) const;
 
+    /**
+     * @brief   Get the sample rate of the filter bank channels
+     * @returns Returns the sample rate or 0 if the filter bank is not used
+     */
+    unsigned fbSampleRate(void) const;
+
+    /**
+     * @brief   Connect to the filter bank channel closest to a frequency
+     * @param   fq_offset The frequency offset from the tuner center frequency
+     * @param   residual  Set to the frequency offset from the channel center
+     * @param   slot      The slot to call with the channel samples
+     * @returns Returns the connection or an empty connection on failure
+     *
+     * The filter bank split the wideband signal into overlapping channels
+     * once, so that each DDR only need to process a signal with a lower
+     * sample rate. The DDR must translate the channel samples by the residual
+     * frequency offset. An empty connection is returned if the filter bank is
+     * not used.
+     */
+    sigc::connection fbConnect(int fq_offset, int &residual,
+        const sigc::slot<void(const std::vector<Sample>&)> &slot);
+
+    /**
+     * @brief   Find out if the DSP is run in a separate thread
+     * @returns Returns \em true if a DSP thread is used
+     *
+     * When the DSP thread is used, the iqReceived signal and the filter bank
+     * slots are called from the DSP thread while holding the DSP lock. The
+     * receivers must then pass their output back to the main thread, @see
+     * dspOutputWritten.
+     */
+    bool dspThreaded(void) const { return dsp_thread.joinable(); }
+
+    /**
+     * @brief   Lock the DSP processing
+     * @returns Returns the lock, which is held until it is destroyed
+     *
+     * The main thread must hold this lock while connecting to the signals
+     * above or changing the state of anything that is called by them. It
+     * should only be held for a short time since the DSP thread is blocked
+     * meanwhile. Without a DSP thread the lock is never contended.
+     */
+    std::unique_lock<std::mutex> dspLock(void)
+    {
+      return std::unique_lock<std::mutex>(dsp_mutex);
+    }
+
+    /**
+     * @brief   Tell the main thread that there is DSP output to handle
+     *
+     * This function is called from the DSP thread when output has been
+     * written to a ring buffer. The dspOutputReady signal will then be
+     * emitted in the main thread. Multiple calls before the main thread get
+     * to run only result in one signal.
+     */
+    void dspOutputWritten(void);
+
     /**
      * @brief   A signal that is emitted when new samples have been received
-     * @param   samples A vector of received samples
+     * @param   samples A block of received samples
      *
      * Connecting to this signal is the way to get samples from the DVB-T
-     * dongle. The format is a vector of complex floats (I/Q) with a range from
-     * -1 to 1.
+     * dongle. The format is a block of complex floats (I/Q) with a range from
+     * -1 to 1. The samples are not copied, @see RtlSdr::iqReceived.
+     */
+    sigc::signal<void(const IqBlock&)> iqReceived;
+
+    /**
+     * @brief   A signal that is emitted with statistics for each sample block
+     * @param   stats The statistics for the block
+     *
+     * @see RtlSdr::iqStatsReceived
+     */
+    sigc::signal<void(const IqConverter::Stats&)> iqStatsReceived;
+
+    /**
+     * @brief   A signal that is emitted when the DSP thread have output
+     *
+     * The signal is emitted in the main thread. The receivers should then
+     * read their ring buffers until they are empty.
      */
-    sigc::signal<void(std::vector<Sample>)> iqReceived;
+    sigc::signal<void()> dspOutputReady;
     
     /**
      * @brief   A signal that is emitted when the ready state changes
@@ -219,15 +301,30 @@ class WbRxRtlSdr : public sigc::trackable
     static InstanceMap instances;
 
     RtlSdr *rtl;
+    FilterBankChannelizer *fb;
     Ddrs ddrs;
     bool auto_tune_enabled;
     std::string m_name;
     int xvrtr_offset;
+    std::mutex dsp_mutex;
+    std::thread dsp_thread;
+    SpscRing<IqBlock> dsp_in;
+    int dsp_wake_pipe[2];
+    int dsp_event_pipe[2];
+    Async::FdWatch *dsp_event_watch;
+    std::atomic<bool> dsp_output_pending;
+    unsigned dsp_overruns;
 
     WbRxRtlSdr(const WbRxRtlSdr&);
     WbRxRtlSdr& operator=(const WbRxRtlSdr&);
     void findBestCenterFq(void);
     void rtlReadyStateChanged(void);
+    void rtlIqReceived(const IqBlock &samples);
+    void processIq(const IqBlock &samples);
+    bool startDspThread(void);
+    void stopDspThread(void);
+    void dspThreadFunc(void);
+    void dspEventReceived(Async::FdWatch *watch);
     
 };  /* class WbRxRtlSdr */
 